@@ -0,0 +1,216 @@
+/**
+  @file
+  @brief libdaisyff public API: in-process TrueType font builder.
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  DaisyffBuilder_new() -> set names/metrics -> add glyphs -> finally(to memory or fd) -> free.
+  エラーはDaisyffErrorで返し、プロセスを終了しない(メモリ確保失敗もDaisyffError_NoMemoryで返す)。
+  builderは独立しているので、builder毎に別threadで使ってよい。
+ */
+#ifndef DAISYFF_LIBDAISYFF_H_
+#define DAISYFF_LIBDAISYFF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define DAISYFF_API __attribute__((visibility("default")))
+
+enum DaisyffError_Kind{
+	DaisyffError_None = 0,
+	DaisyffError_InvalidArgument,	//!< 引数がNULL・範囲外など
+	DaisyffError_InvalidState,	//!< 必須の設定が無い、finally後の追加など
+	DaisyffError_DuplicateCodepoint,	//!< 既に割り当て済みのcodepoint
+	DaisyffError_TooManyGlyphs,	//!< numGlyphs(Uint16)に収まらない
+	DaisyffError_TableOverflow,	//!< Tableのoffset/length等がフォーマットの上限を超える
+	DaisyffError_Io,		//!< 書き出し失敗(errnoを参照)
+	DaisyffError_DuplicateName,	//!< 同じ言語・nameIDの名前が既にある
+	DaisyffError_IncompatibleMaster,	//!< masterのcontour数・点数がdefault glyphと異なる
+	DaisyffError_NoMemory,		//!< メモリ確保失敗(以後このbuilderはfreeのみ可)
+};
+typedef int DaisyffError;
+
+enum DaisyffMacStyle_Kind{
+	DaisyffMacStyle_Regular		= (0x1 << 6),
+	DaisyffMacStyle_Bold		= (0x1 << 5),
+	DaisyffMacStyle_Italic		= (0x1 << 0),
+	DaisyffMacStyle_BoldItalic	= (0x1 << 5) | (0x1 << 0),
+};
+typedef uint16_t DaisyffMacStyle;
+
+typedef struct{
+	int16_t			x;
+	int16_t			y;
+}DaisyffPoint;
+
+//! 閉パス(on curve点のみ)
+typedef struct{
+	const DaisyffPoint	*points;
+	size_t			pointNum;
+}DaisyffContour;
+
+//! 'name' Table (文字列はUTF-8。builder内へコピーされる)
+typedef struct{
+	const char		*copyright;
+	const char		*familyName;
+	DaisyffMacStyle		macStyle;
+	const char		*versionString;
+	const char		*vendorName;
+	const char		*designerName;
+	const char		*vendorUrl;
+	const char		*designerUrl;
+}DaisyffNames;
+
+//! 'head', 'hhea' Tableの字面・行送り情報
+typedef struct{
+	int16_t			xMin;		//!< font bounding box
+	int16_t			yMin;
+	int16_t			xMax;
+	int16_t			yMax;
+	uint16_t		ascender;
+	uint16_t		descender;
+	uint16_t		lineGap;
+	uint16_t		lowestRecPPEM;
+	time_t			created;	//!< UNIX time
+	time_t			modified;	//!< UNIX time
+}DaisyffMetrics;
+
+//! 'GPOS' Table kerningの圧縮結果
+typedef struct{
+	size_t			pairNum;	//!< 重複と値0を除いたpair数
+	size_t			leftClassNum;	//!< PairPos format 2のClass1Count(0: format 1のみ)
+	size_t			rightClassNum;	//!< PairPos format 2のClass2Count
+	size_t			exceptionNum;	//!< format 1で出したpair数
+	size_t			naiveSize;	//!< 全pairをformat 1で出した場合の'GPOS' Tableサイズ(byte)
+	size_t			tableSize;	//!< 出力した'GPOS' Tableサイズ(byte)
+}DaisyffKerningReport;
+
+//! 'gvar' Tableの圧縮結果
+typedef struct{
+	size_t			tupleNum;	//!< tuple variation数
+	size_t			sharedTupleNum;	//!< shared tuples数
+	size_t			pointNum;	//!< 差分を出力した点数(phantom point含む)
+	size_t			omittedPointNum;	//!< IUPで再現できるので省略した点数
+	size_t			gvarSize;	//!< 'gvar' Tableサイズ(byte)
+	size_t			gvarUnpackedSize;	//!< 全点の差分をwordで出した場合の'gvar' Tableサイズ(byte)
+}DaisyffVariationReport;
+
+typedef struct DaisyffBuilder DaisyffBuilder;
+
+DAISYFF_API const char *DaisyffError_toString(DaisyffError error);
+
+/** @brief builderを生成する。
+  .notdef(GlyphId 0)と空グリフ(NUL, BS, GS, CR)、TABは生成時に追加済み。
+  @return NULL: メモリ確保失敗
+  */
+DAISYFF_API DaisyffBuilder *DaisyffBuilder_new(void);
+//! @brief builderが確保したメモリを全て開放する。NULLは無視する。
+DAISYFF_API void DaisyffBuilder_free(DaisyffBuilder *builder);
+
+DAISYFF_API DaisyffError DaisyffBuilder_setNames(DaisyffBuilder *builder, const DaisyffNames *names);
+/** @brief 言語別の名前をWindows platform('name' Table platformID 3, encodingID 1)へ追加する。
+  1つ以上追加すると、setNames()の名前はWindows en-US(0x0409)にも置かれる。
+  同じ文字列は全Recordで共有して格納する。
+  @param languageId Windows language ID(例: 0x0411 日本語)
+  @param nameId 'name' Table nameID(例: 1 family, 4 full font name)
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addLocalizedName(
+		DaisyffBuilder *builder,
+		uint16_t languageId,
+		uint16_t nameId,
+		const char *string);
+DAISYFF_API DaisyffError DaisyffBuilder_setMetrics(DaisyffBuilder *builder, const DaisyffMetrics *metrics);
+
+/** @brief glyphを追加し、codepointへ割り当てる。
+  @param codepoint BMP(0x0000-0xfffe)
+  @param contours contourNum == 0 の場合は空グリフ
+  @param glyphId NULL可。追加したGlyphIdを返す。
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addGlyph(
+		DaisyffBuilder *builder,
+		uint32_t codepoint,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth,
+		int16_t lsb,
+		uint16_t *glyphId);
+
+DAISYFF_API size_t DaisyffBuilder_getNumGlyphs(const DaisyffBuilder *builder);
+
+/** @brief kerningのpairを追加する('GPOS' Table 'kern' feature, DFLT script)。
+  同じpairは後に追加した値を使う。pairが1つ以上あれば'GPOS' Tableを出力する。
+  glyphは左右のclassへまとめてPairPos format 2で出力し、classに合わないpairはformat 1で出力する。
+  @param leftGlyphId, rightGlyphId 追加済みのGlyphId
+  @param xAdvance 左glyphの送り幅の調整量(font unit)
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addKerningPair(
+		DaisyffBuilder *builder,
+		uint16_t leftGlyphId,
+		uint16_t rightGlyphId,
+		int16_t xAdvance);
+//! @brief finally後に'GPOS' Tableの圧縮結果を返す(pairが無い場合は全て0)。
+DAISYFF_API DaisyffError DaisyffBuilder_getKerningReport(const DaisyffBuilder *builder, DaisyffKerningReport *report);
+
+/** @brief variation axisを追加する('fvar' Table)。axisが1つ以上あれば'fvar', 'gvar' Tableを出力する。
+  axis, axis mappingはinstance, masterより先に追加する。
+  名前は'name' TableのnameID 256以降に追加順で置く。
+  @param tag 4文字(例: "wght")
+  @param minValue, defaultValue, maxValue user座標(minValue <= defaultValue <= maxValue, minValue < maxValue)
+  @param axisIndex NULL可。追加したaxisのindexを返す。
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addAxis(
+		DaisyffBuilder *builder,
+		const char *tag,
+		double minValue,
+		double defaultValue,
+		double maxValue,
+		const char *name,
+		uint16_t *axisIndex);
+/** @brief axisのuser座標の対応を追加する('avar' Table)。
+  @param fromValue min, default, max以外のuser座標
+  @param toValue 対応先のuser座標(fromValueの順に単調増加であること)
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addAxisMapping(
+		DaisyffBuilder *builder,
+		uint16_t axisIndex,
+		double fromValue,
+		double toValue);
+/** @brief named instanceを追加する('fvar' Table)。
+  @param coordinates user座標[axis数]
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addNamedInstance(
+		DaisyffBuilder *builder,
+		const char *subfamilyName,
+		const double *coordinates);
+/** @brief glyphのmasterを追加する('gvar' Table)。addGlyph()の字形がdefault masterになる。
+  @param coordinates masterの位置のuser座標[axis数](default位置以外)
+  @param contours default glyphとcontour数・各contourの点数が同じであること
+  @param advanceWidth masterの送り幅
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_addGlyphMaster(
+		DaisyffBuilder *builder,
+		uint16_t glyphId,
+		const double *coordinates,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth);
+//! @brief finally後に'gvar' Tableの圧縮結果を返す(axisが無い場合は全て0)。
+DAISYFF_API DaisyffError DaisyffBuilder_getVariationReport(const DaisyffBuilder *builder, DaisyffVariationReport *report);
+
+/** @brief フォントのbyte列を生成する。builderに対して一度だけ呼べる。
+  @param data 成功時にmalloc()したバッファを返す。呼び出し側でfree()する。
+  */
+DAISYFF_API DaisyffError DaisyffBuilder_finallyToMemory(DaisyffBuilder *builder, uint8_t **data, size_t *size);
+//! @brief フォントを生成してfdへ書き出す(fdはcloseしない)。
+DAISYFF_API DaisyffError DaisyffBuilder_finallyToFd(DaisyffBuilder *builder, int fd);
+
+/** @brief 処理時間の記録(Chrome trace-event JSON)を有効にする。
+  プロセス全体で1つの記録を共有する。
+  */
+DAISYFF_API void DaisyffTrace_enable(void);
+DAISYFF_API bool DaisyffTrace_writeJson(const char *filepath);
+
+#endif // #ifndef DAISYFF_LIBDAISYFF_H_
+
@@ -0,0 +1,27 @@
+
+#include "version.h"
+
+const char *GIT_HASH		= "b34cc75";
+const char *GIT_BRANCH		= "master";
+const char *GIT_DATETIME	= "2026-10-19 09:22:01 +0000";
+const char *GIT_STATUS_SHORT	= " 2 files changed, 20 insertions(+), 1 deletion(-)";
+
+const char *SHOW_VERSION	= "0.26.10-b34cc75";
+const char *FULL_VERSION	= "0.26.10-19092201.0-b34cc75";
+
+
+const char *get_vecterion_build()
+{
+	return ""
+			"git_hash		: b34cc75\n"
+			"git_branch		: master\n"
+			"git_datetime		: 2026-10-19 09:22:01 +0000\n"
+			"git_status_short	:  2 files changed, 20 insertions(+), 1 deletion(-)\n"
+			"\n"
+			"show_version		: 0.26.10-b34cc75\n"
+			"full_version		: 0.26.10-19092201.0-b34cc75\n"
+			"\n"
+			;
+}
+
+
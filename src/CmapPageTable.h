@@ -0,0 +1,203 @@
+/**
+  @file
+  @brief cmap subtableから作るcodepoint -> glyphIdの2段の表(定数時間で引く)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  1段目はcodepoint >> 8 (0x1100個)からpage番号、2段目は256要素のpage。
+  割り当ての無いpageは全て空のpage 0を共有するので、大きさは割り当てのあるpage数に比例する。
+  作成はsubtableの割り当てのある文字数に比例する。
+ */
+#ifndef DAISYFF_CMAP_PAGE_TABLE_HPP_
+#define DAISYFF_CMAP_PAGE_TABLE_HPP_
+
+#include "src/FontParser.h"
+
+#define CmapPageTable_CODEPOINT_NUM	(0x110000)
+#define CmapPageTable_PAGE_SIZE		(256)
+
+typedef struct{
+	uint16_t		pageIndexes[CmapPageTable_CODEPOINT_NUM / CmapPageTable_PAGE_SIZE];	//!< 0: 空のpage
+	uint16_t		*pages;		//!< [pageNum][PAGE_SIZE]
+	size_t			pageNum;	//!< 空のpageを含む
+	size_t			mappedNum;	//!< glyphId != 0 の文字の数
+	uint16_t		numGlyphs;	//!< これ以上のglyphIdは割り当て無しとする
+}CmapPageTable;
+
+void CmapPageTable_free(CmapPageTable *table)
+{
+	free(table->pages);
+	*table = (CmapPageTable){0};
+}
+
+//! @brief 空の表(全て0)にする
+void CmapPageTable_init(CmapPageTable *table, uint16_t numGlyphs)
+{
+	*table = (CmapPageTable){.numGlyphs = numGlyphs};
+	table->pages = (uint16_t *)ffmalloc(sizeof(uint16_t) * CmapPageTable_PAGE_SIZE);
+	table->pageNum = 1;
+}
+
+uint16_t CmapPageTable_glyphId(const CmapPageTable *table, uint32_t codepoint)
+{
+	if(CmapPageTable_CODEPOINT_NUM <= codepoint){
+		return 0;
+	}
+	return table->pages[((size_t)table->pageIndexes[codepoint >> 8] * CmapPageTable_PAGE_SIZE) + (codepoint & 0xFF)];
+}
+
+void CmapPageTable_set_inline_(CmapPageTable *table, uint32_t codepoint, uint16_t glyphId)
+{
+	if(CmapPageTable_CODEPOINT_NUM <= codepoint || 0 == glyphId || table->numGlyphs <= glyphId){
+		return;
+	}
+	uint16_t *pageIndex = &table->pageIndexes[codepoint >> 8];
+	if(0 == *pageIndex){
+		table->pages = (uint16_t *)ffrealloc(table->pages, sizeof(uint16_t) * CmapPageTable_PAGE_SIZE * (table->pageNum + 1));
+		memset(&table->pages[table->pageNum * CmapPageTable_PAGE_SIZE], 0, sizeof(uint16_t) * CmapPageTable_PAGE_SIZE);
+		*pageIndex = (uint16_t)table->pageNum++;
+	}
+	uint16_t *entry = &table->pages[((size_t)*pageIndex * CmapPageTable_PAGE_SIZE) + (codepoint & 0xFF)];
+	table->mappedNum += (0 == *entry)? 1 : 0;
+	*entry = glyphId;
+}
+
+FontParseError CmapPageTable_buildFormat0_inline_(CmapPageTable *table, FontSpan subtable)
+{
+	FontSpanReader reader = FontSpanReader_init(subtable, 6);
+	for(uint32_t c = 0; c < 256; c++){
+		const uint8_t glyphId = FontSpanReader_uint8(&reader);
+		if(reader.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+		CmapPageTable_set_inline_(table, c, glyphId);
+	}
+	return FontParseError_None;
+}
+
+FontParseError CmapPageTable_buildFormat4_inline_(CmapPageTable *table, FontSpan subtable)
+{
+	FontSpanReader reader = FontSpanReader_init(subtable, 6);
+	const size_t segCount = FontSpanReader_uint16(&reader) / 2;
+	const size_t endCodeOffset = 14;
+	const size_t startCodeOffset = endCodeOffset + (2 * segCount) + 2;
+	const size_t idDeltaOffset = startCodeOffset + (2 * segCount);
+	const size_t idRangeOffsetOffset = idDeltaOffset + (2 * segCount);
+	if(reader.isOverrun || subtable.size < idRangeOffsetOffset + (2 * segCount)){
+		return FontParseError_OutOfRange;
+	}
+	bool isPrevExist = false;
+	uint32_t prevEndCode = 0;
+	for(size_t i = 0; i < segCount; i++){
+		reader.offset = endCodeOffset + (2 * i);
+		const uint16_t endCode = FontSpanReader_uint16(&reader);
+		reader.offset = startCodeOffset + (2 * i);
+		const uint16_t startCode = FontSpanReader_uint16(&reader);
+		reader.offset = idDeltaOffset + (2 * i);
+		const uint16_t idDelta = FontSpanReader_uint16(&reader);
+		const size_t idRangeOffsetPos = idRangeOffsetOffset + (2 * i);
+		reader.offset = idRangeOffsetPos;
+		const uint16_t idRangeOffset = FontSpanReader_uint16(&reader);
+		// 不正・順序違反のsegmentは捨てる(二分探索で引く実装と結果を揃える)
+		if(endCode < startCode || (isPrevExist && startCode <= prevEndCode)){
+			continue;
+		}
+		isPrevExist = true;
+		prevEndCode = endCode;
+		for(uint32_t c = startCode; c <= endCode; c++){
+			uint16_t glyphId;
+			if(0 == idRangeOffset){
+				glyphId = (uint16_t)(c + idDelta);
+			}else{
+				// 範囲外の参照は割り当て無し
+				reader.offset = idRangeOffsetPos + idRangeOffset + (2 * (c - startCode));
+				glyphId = FontSpanReader_uint16(&reader);
+				glyphId = (reader.isOverrun || 0 == glyphId)? 0 : (uint16_t)(glyphId + idDelta);
+				reader.isOverrun = false;
+			}
+			CmapPageTable_set_inline_(table, c, glyphId);
+		}
+	}
+	return FontParseError_None;
+}
+
+FontParseError CmapPageTable_buildFormat6_inline_(CmapPageTable *table, FontSpan subtable)
+{
+	FontSpanReader reader = FontSpanReader_init(subtable, 6);
+	const uint16_t firstCode = FontSpanReader_uint16(&reader);
+	const uint16_t entryCount = FontSpanReader_uint16(&reader);
+	for(uint32_t i = 0; i < entryCount; i++){
+		const uint16_t glyphId = FontSpanReader_uint16(&reader);
+		if(reader.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+		CmapPageTable_set_inline_(table, firstCode + i, glyphId);
+	}
+	return FontParseError_None;
+}
+
+//! @param isManyToOne true: format 13(group内の全文字が同じglyph)
+FontParseError CmapPageTable_buildFormat12_inline_(CmapPageTable *table, FontSpan subtable, bool isManyToOne)
+{
+	FontSpanReader reader = FontSpanReader_init(subtable, 12);
+	const uint32_t numGroups = FontSpanReader_uint32(&reader);
+	if(reader.isOverrun || (subtable.size - 16) / 12 < numGroups){
+		return FontParseError_OutOfRange;
+	}
+	bool isPrevExist = false;
+	uint32_t prevEndCode = 0;
+	for(size_t i = 0; i < numGroups; i++){
+		const uint32_t startCode = FontSpanReader_uint32(&reader);
+		const uint32_t endCode = FontSpanReader_uint32(&reader);
+		const uint32_t startGlyphId = FontSpanReader_uint32(&reader);
+		if(endCode < startCode || CmapPageTable_CODEPOINT_NUM <= endCode || (isPrevExist && startCode <= prevEndCode)){
+			continue;
+		}
+		isPrevExist = true;
+		prevEndCode = endCode;
+		for(uint32_t c = startCode; c <= endCode; c++){
+			const uint32_t glyphId = isManyToOne ? startGlyphId : startGlyphId + (c - startCode);
+			if(UINT16_MAX < glyphId){
+				break;
+			}
+			CmapPageTable_set_inline_(table, c, (uint16_t)glyphId);
+		}
+	}
+	return FontParseError_None;
+}
+
+/** @brief cmap subtable(format 0, 4, 6, 12, 13)から表を作る。
+  エラーの場合もtableは有効(読めた所までの割り当て)で、CmapPageTable_free()する。
+  @param numGlyphs これ以上のglyphIdは割り当て無しとする
+  */
+FontParseError CmapPageTable_build(CmapPageTable *table, FontSpan subtable, uint16_t numGlyphs)
+{
+	CmapPageTable_init(table, numGlyphs);
+	FontSpanReader reader = FontSpanReader_init(subtable, 0);
+	const uint16_t format = FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	switch(format){
+	case 0:
+		return CmapPageTable_buildFormat0_inline_(table, subtable);
+	case 4:
+		return CmapPageTable_buildFormat4_inline_(table, subtable);
+	case 6:
+		return CmapPageTable_buildFormat6_inline_(table, subtable);
+	case 12:
+		return CmapPageTable_buildFormat12_inline_(table, subtable, false);
+	case 13:
+		return CmapPageTable_buildFormat12_inline_(table, subtable, true);
+	default:
+		return FontParseError_Unsupported;
+	}
+}
+
+//! @return 表の大きさ(byte)
+size_t CmapPageTable_memorySize(const CmapPageTable *table)
+{
+	return sizeof(table->pageIndexes) + (sizeof(uint16_t) * CmapPageTable_PAGE_SIZE * table->pageNum);
+}
+
+#endif // #ifndef DAISYFF_CMAP_PAGE_TABLE_HPP_
@@ -0,0 +1,1064 @@
+/**
+  @file
+  @brief libdaisyff builder(include/daisyff.h)の実装。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  入力はAPI境界で検証し、OpenType.h内部のASSERTに到達させない。
+  内部の確保(ffmalloc/ffrealloc)の失敗はAPI毎にffAllocFailureJumpで受け、DaisyffError_NoMemoryとして返す。
+ */
+#ifndef DAISYFF_DAISYFF_BUILDER_HPP_
+#define DAISYFF_DAISYFF_BUILDER_HPP_
+
+#include "src/OpenType.h"
+#include "src/GposTable.h"
+#include "src/VariationTables.h"
+#include "include/daisyff.h"
+
+//! 'fvar' Tableのaxis名・instance名を置く最初のnameID
+#define DaisyffBuilder_VARIATION_NAME_ID_BEGIN (256)
+
+//! Windows platformの言語別の名前
+typedef struct{
+	uint16_t		languageId;
+	uint16_t		nameId;
+	char			*string;
+}DaisyffBuilderLocalizedName;
+
+struct DaisyffBuilder{
+	bool			isNamesSet;
+	char			*copyright;
+	char			*familyName;
+	MacStyle		macStyle;
+	char			*versionString;
+	char			*vendorName;
+	char			*designerName;
+	char			*vendorUrl;
+	char			*designerUrl;
+
+	DaisyffBuilderLocalizedName	*localizedNames;
+	size_t			localizedNameNum;
+
+	bool			isMetricsSet;
+	DaisyffMetrics		metrics;
+
+	GlyphTablesBuf		glyphTablesBuf;
+	HmtxTableBuf		hmtxTableBuf;
+	// 'maxp', 'hhea' Table用の集計
+	size_t			maxPoints;
+	size_t			maxContours;
+	bool			isOutlineGlyphExist;
+	int			minLeftSideBearing;
+	int			minRightSideBearing;
+	int			xMaxExtent;
+
+	GposTableBuf		gposTableBuf;
+
+	VariationTablesBuf	variationTablesBuf;
+	char			**variationNames;	//!< nameID DaisyffBuilder_VARIATION_NAME_ID_BEGIN + index
+	size_t			variationNameNum;
+
+	bool			isFinally;
+	bool			isNoMemory;	//!< 確保に失敗した(途中までの変更を含むので、以後はfree以外を受け付けない)
+};
+
+/** @brief APIの本体(ARG_expression)を評価して返す。
+  本体の中で確保に失敗した場合はDaisyffError_NoMemoryを返す(その呼び出しの作業領域は解放されない)。
+  */
+#define DaisyffBuilder_RETURN_GUARDED_(ARG_builder, ARG_expression) \
+	do{ \
+		DaisyffBuilder * volatile guardedBuilder_ = (ARG_builder); \
+		if(NULL != guardedBuilder_ && guardedBuilder_->isNoMemory){ \
+			return DaisyffError_NoMemory; \
+		} \
+		jmp_buf * const outerJump_ = ffAllocFailureJump; \
+		jmp_buf jump_; \
+		if(0 != setjmp(jump_)){ \
+			ffAllocFailureJump = outerJump_; \
+			guardedBuilder_->isNoMemory = true; \
+			return DaisyffError_NoMemory; \
+		} \
+		ffAllocFailureJump = &jump_; \
+		const DaisyffError guardedError_ = (ARG_expression); \
+		ffAllocFailureJump = outerJump_; \
+		return guardedError_; \
+	}while(0)
+
+const char *DaisyffError_toString(DaisyffError error)
+{
+	switch(error){
+	case DaisyffError_None:			return "none";
+	case DaisyffError_InvalidArgument:	return "invalid argument";
+	case DaisyffError_InvalidState:		return "invalid state";
+	case DaisyffError_DuplicateCodepoint:	return "duplicate codepoint";
+	case DaisyffError_TooManyGlyphs:	return "too many glyphs";
+	case DaisyffError_TableOverflow:	return "table overflow";
+	case DaisyffError_Io:			return "io error";
+	case DaisyffError_DuplicateName:	return "duplicate name";
+	case DaisyffError_IncompatibleMaster:	return "incompatible master";
+	case DaisyffError_NoMemory:		return "no memory";
+	default:				return "<unknown>";
+	}
+}
+
+//! @brief 検証済みのoutlineをglyphとして追加する
+void DaisyffBuilder_appendGlyph_inline_(
+		DaisyffBuilder *builder,
+		uint16_t codepoint,
+		const GlyphOutline *outline,
+		uint16_t advanceWidth,
+		int16_t lsb)
+{
+	GlyphDescriptionBuf glyphDescriptionBuf = {0};
+	GlyphDescriptionBuf_setOutline(&glyphDescriptionBuf, outline);
+	GlyphTablesBuf_appendSimpleGlyph(&builder->glyphTablesBuf, codepoint, &glyphDescriptionBuf);
+	HmtxTableBuf_appendLongHorMetric(&builder->hmtxTableBuf, advanceWidth, lsb);
+	VariationDefaultGlyphs_append(&builder->variationTablesBuf.defaultGlyphs, outline, advanceWidth);
+
+	// 'maxp', 'hhea' Tableの値を集計
+	if(builder->maxPoints < glyphDescriptionBuf.pointNum){
+		builder->maxPoints = glyphDescriptionBuf.pointNum;
+	}
+	if(builder->maxContours < (size_t)glyphDescriptionBuf.numberOfContours){
+		builder->maxContours = glyphDescriptionBuf.numberOfContours;
+	}
+	if(0 < glyphDescriptionBuf.numberOfContours){
+		const int width = glyphDescriptionBuf.xMax - glyphDescriptionBuf.xMin;
+		const int rsb = advanceWidth - (lsb + width);
+		const int extent = lsb + width;
+		if(! builder->isOutlineGlyphExist){
+			builder->minLeftSideBearing	= lsb;
+			builder->minRightSideBearing	= rsb;
+			builder->xMaxExtent		= extent;
+			builder->isOutlineGlyphExist	= true;
+		}else{
+			builder->minLeftSideBearing	= (lsb < builder->minLeftSideBearing)? lsb : builder->minLeftSideBearing;
+			builder->minRightSideBearing	= (rsb < builder->minRightSideBearing)? rsb : builder->minRightSideBearing;
+			builder->xMaxExtent		= (extent > builder->xMaxExtent)? extent : builder->xMaxExtent;
+		}
+	}
+
+	GlyphDescriptionBuf_free(&glyphDescriptionBuf);
+}
+
+void DaisyffBuilder_init_inline_(DaisyffBuilder *builder)
+{
+	GlyphTablesBuf_init(&builder->glyphTablesBuf);
+
+	// ** .notdefなどデフォルトの文字を追加
+	//    & CmapTableテーブルにGlyphIdの初期値をセット
+	//! @note Format0のBackspaceなどへのGlyphIdの割り当てはFontForgeの出力ファイルに倣った
+	// *** .notdef
+	GlyphOutline outline_notdef = GlyphOutline_Notdef();
+	DaisyffBuilder_appendGlyph_inline_(builder, 0x0, &outline_notdef, 500, 50);
+	GlyphOutline_free(&outline_notdef);
+
+	// 下の2つのGlyphで使用する空の字形
+	GlyphOutline outline_empty = {0};
+	// *** NUL and other
+	DaisyffBuilder_appendGlyph_inline_(builder, 0, &outline_empty, 0, 0);
+	builder->glyphTablesBuf.cmapSubtableBuf_GlyphIdArray8[ 8] = 1; // BackSpace = index 1
+	builder->glyphTablesBuf.cmapSubtableBuf_GlyphIdArray8[29] = 1; // GroupSeparator = index 1
+	// *** TAB(HT) and other
+	DaisyffBuilder_appendGlyph_inline_(builder, '\t', &outline_empty, 1000, 0);
+	builder->glyphTablesBuf.cmapSubtableBuf_GlyphIdArray8[13] = 1; // CR = index 2
+}
+
+void DaisyffBuilder_free(DaisyffBuilder *builder)
+{
+	if(NULL == builder){
+		return;
+	}
+
+	free(builder->copyright);
+	free(builder->familyName);
+	free(builder->versionString);
+	free(builder->vendorName);
+	free(builder->designerName);
+	free(builder->vendorUrl);
+	free(builder->designerUrl);
+	for(size_t i = 0; i < builder->localizedNameNum; i++){
+		free(builder->localizedNames[i].string);
+	}
+	free(builder->localizedNames);
+	GlyphTablesBuf_free(&builder->glyphTablesBuf);
+	HmtxTableBuf_free(&builder->hmtxTableBuf);
+	GposTableBuf_free(&builder->gposTableBuf);
+	VariationTablesBuf_free(&builder->variationTablesBuf);
+	for(size_t i = 0; i < builder->variationNameNum; i++){
+		free(builder->variationNames[i]);
+	}
+	free(builder->variationNames);
+	free(builder);
+}
+
+DaisyffBuilder *DaisyffBuilder_new(void)
+{
+	DaisyffBuilder * volatile const builder = (DaisyffBuilder *)calloc(1, sizeof(DaisyffBuilder));
+	if(NULL == builder){
+		return NULL;
+	}
+	jmp_buf * const outerJump = ffAllocFailureJump;
+	jmp_buf jump;
+	if(0 != setjmp(jump)){
+		ffAllocFailureJump = outerJump;
+		DaisyffBuilder_free(builder);
+		return NULL;
+	}
+	ffAllocFailureJump = &jump;
+	DaisyffBuilder_init_inline_(builder);
+	ffAllocFailureJump = outerJump;
+
+	return builder;
+}
+
+bool DaisyffBuilder_isValidUtf8_inline_(const char *str)
+{
+	size_t utf16sSize;
+	uint8_t *utf16s = convertNewUtf16FromUtf8(str, &utf16sSize);
+	free(utf16s);
+	return (NULL != utf16s);
+}
+
+DaisyffError DaisyffBuilder_setNames_inline_(DaisyffBuilder *builder, const DaisyffNames *names)
+{
+	if(NULL == builder || NULL == names){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	const char *strings[] = {
+		names->copyright, names->familyName, names->versionString,
+		names->vendorName, names->designerName, names->vendorUrl, names->designerUrl,
+	};
+	for(int i = 0; i < sizeof(strings) / sizeof(strings[0]); i++){
+		if(NULL == strings[i] || (! DaisyffBuilder_isValidUtf8_inline_(strings[i]))){
+			return DaisyffError_InvalidArgument;
+		}
+	}
+	const char *macStyleString = MacStyle_toStringForNameTable(names->macStyle);
+	if(NULL == macStyleString){
+		return DaisyffError_InvalidArgument;
+	}
+	// fontnameはPostScriptName(`%s-%s`)にも使う
+	//! @note 'name' Tableのoffset(16bit)超過はfinallyで検出する
+	char *postscriptfontname = ffsprintf_new("%s-%s", names->familyName, macStyleString);
+	bool isValidPostScriptName = PostScriptName_valid(postscriptfontname);
+	free(postscriptfontname);
+	if(! isValidPostScriptName){
+		return DaisyffError_InvalidArgument;
+	}
+
+	char **dsts[] = {
+		&builder->copyright, &builder->familyName, &builder->versionString,
+		&builder->vendorName, &builder->designerName, &builder->vendorUrl, &builder->designerUrl,
+	};
+	for(int i = 0; i < sizeof(dsts) / sizeof(dsts[0]); i++){
+		free(*dsts[i]);
+		*dsts[i] = ffsprintf_new("%s", strings[i]);
+	}
+	builder->macStyle = names->macStyle;
+	builder->isNamesSet = true;
+
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_setNames(DaisyffBuilder *builder, const DaisyffNames *names)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_setNames_inline_(builder, names));
+}
+
+DaisyffError DaisyffBuilder_addLocalizedName_inline_(
+		DaisyffBuilder *builder,
+		uint16_t languageId,
+		uint16_t nameId,
+		const char *string)
+{
+	if(NULL == builder || NULL == string || (! DaisyffBuilder_isValidUtf8_inline_(string))){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	// en-USの基本の名前(NameTableBuf_appendFontNames())とは重複させない
+	const uint16_t fontNameIds[] = {0, 1, 2, 3, 4, 5, 6, 8, 9, 11, 12};
+	if(LanguageID_Windows_EnglishUS == languageId){
+		for(size_t i = 0; i < sizeof(fontNameIds) / sizeof(fontNameIds[0]); i++){
+			if(fontNameIds[i] == nameId){
+				return DaisyffError_DuplicateName;
+			}
+		}
+	}
+	if(LanguageID_Windows_EnglishUS == languageId
+			&& DaisyffBuilder_VARIATION_NAME_ID_BEGIN <= nameId
+			&& nameId < DaisyffBuilder_VARIATION_NAME_ID_BEGIN + builder->variationNameNum){
+		return DaisyffError_DuplicateName;
+	}
+	for(size_t i = 0; i < builder->localizedNameNum; i++){
+		if(languageId == builder->localizedNames[i].languageId && nameId == builder->localizedNames[i].nameId){
+			return DaisyffError_DuplicateName;
+		}
+	}
+	if(UINT16_MAX <= builder->localizedNameNum){
+		return DaisyffError_TableOverflow;
+	}
+
+	builder->localizedNames = (DaisyffBuilderLocalizedName *)ffrealloc(
+			builder->localizedNames,
+			sizeof(DaisyffBuilderLocalizedName) * (builder->localizedNameNum + 1));
+	builder->localizedNames[builder->localizedNameNum] = (DaisyffBuilderLocalizedName){
+		.languageId	= languageId,
+		.nameId		= nameId,
+		.string		= ffsprintf_new("%s", string),
+	};
+	builder->localizedNameNum++;
+
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addLocalizedName(
+		DaisyffBuilder *builder,
+		uint16_t languageId,
+		uint16_t nameId,
+		const char *string)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addLocalizedName_inline_(builder, languageId, nameId, string));
+}
+
+DaisyffError DaisyffBuilder_setMetrics_inline_(DaisyffBuilder *builder, const DaisyffMetrics *metrics)
+{
+	if(NULL == builder || NULL == metrics){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	if(! (metrics->xMin < metrics->xMax && metrics->yMin < metrics->yMax)){
+		return DaisyffError_InvalidArgument;
+	}
+	// LONGDATETIMEは1904-01-01起点
+	if(metrics->created < -(time_t)LONGDATETIME_DELTA || metrics->modified < -(time_t)LONGDATETIME_DELTA){
+		return DaisyffError_InvalidArgument;
+	}
+
+	builder->metrics = *metrics;
+	builder->isMetricsSet = true;
+
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_setMetrics(DaisyffBuilder *builder, const DaisyffMetrics *metrics)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_setMetrics_inline_(builder, metrics));
+}
+
+DaisyffError DaisyffBuilder_addGlyph_inline_(
+		DaisyffBuilder *builder,
+		uint32_t codepoint,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth,
+		int16_t lsb,
+		uint16_t *glyphId)
+{
+	if(NULL == builder || (0 < contourNum && NULL == contours)){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	if(CmapSubtableFormat4_CODEPOINT_MAX < codepoint){
+		return DaisyffError_InvalidArgument;
+	}
+	if(UINT16_MAX <= builder->glyphTablesBuf.numGlyphs){
+		return DaisyffError_TooManyGlyphs;
+	}
+	// endPtsOfContours[]はUint16, numberOfContoursはInt16
+	if(INT16_MAX < contourNum){
+		return DaisyffError_InvalidArgument;
+	}
+	size_t pointNum = 0;
+	for(size_t i = 0; i < contourNum; i++){
+		if(0 == contours[i].pointNum || NULL == contours[i].points){
+			return DaisyffError_InvalidArgument;
+		}
+		pointNum += contours[i].pointNum;
+	}
+	if(UINT16_MAX < pointNum){
+		return DaisyffError_InvalidArgument;
+	}
+	const GlyphTablesBuf *glyphTablesBuf = &builder->glyphTablesBuf;
+	if(0 != glyphTablesBuf->cmapSubtableBuf_GlyphIdArray16[codepoint]
+			|| (codepoint <= CmapSubtableFormat0_CODEPOINT_MAX
+				&& 0 != glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8[codepoint])){
+		return DaisyffError_DuplicateCodepoint;
+	}
+
+	GlyphOutline outline = {0};
+	for(size_t i = 0; i < contourNum; i++){
+		GlyphClosePath cpath = {0};
+		cpath.anchorPoints = (GlyphAnchorPoint *)ffmalloc(sizeof(GlyphAnchorPoint) * contours[i].pointNum);
+		for(size_t p = 0; p < contours[i].pointNum; p++){
+			cpath.anchorPoints[p].point.x = contours[i].points[p].x;
+			cpath.anchorPoints[p].point.y = contours[i].points[p].y;
+		}
+		cpath.anchorPointNum = contours[i].pointNum;
+		GlyphOutline_addClosePath(&outline, &cpath);
+	}
+
+	if(NULL != glyphId){
+		*glyphId = builder->glyphTablesBuf.numGlyphs;
+	}
+	DaisyffBuilder_appendGlyph_inline_(builder, (uint16_t)codepoint, &outline, advanceWidth, lsb);
+	GlyphOutline_free(&outline);
+
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addGlyph(
+		DaisyffBuilder *builder,
+		uint32_t codepoint,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth,
+		int16_t lsb,
+		uint16_t *glyphId)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addGlyph_inline_(builder, codepoint, contours, contourNum, advanceWidth, lsb, glyphId));
+}
+
+size_t DaisyffBuilder_getNumGlyphs(const DaisyffBuilder *builder)
+{
+	if(NULL == builder){
+		return 0;
+	}
+	return builder->glyphTablesBuf.numGlyphs;
+}
+
+DaisyffError DaisyffBuilder_addKerningPair_inline_(
+		DaisyffBuilder *builder,
+		uint16_t leftGlyphId,
+		uint16_t rightGlyphId,
+		int16_t xAdvance)
+{
+	if(NULL == builder){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	if(builder->glyphTablesBuf.numGlyphs <= leftGlyphId || builder->glyphTablesBuf.numGlyphs <= rightGlyphId){
+		return DaisyffError_InvalidArgument;
+	}
+	if(UINT32_MAX <= builder->gposTableBuf.pairNum){
+		return DaisyffError_TableOverflow;
+	}
+
+	GposTableBuf_appendPair(&builder->gposTableBuf, leftGlyphId, rightGlyphId, xAdvance);
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addKerningPair(
+		DaisyffBuilder *builder,
+		uint16_t leftGlyphId,
+		uint16_t rightGlyphId,
+		int16_t xAdvance)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addKerningPair_inline_(builder, leftGlyphId, rightGlyphId, xAdvance));
+}
+
+DaisyffError DaisyffBuilder_getKerningReport(const DaisyffBuilder *builder, DaisyffKerningReport *report)
+{
+	if(NULL == builder || NULL == report){
+		return DaisyffError_InvalidArgument;
+	}
+	if(! builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+
+	const GposKernReport *gposReport = &builder->gposTableBuf.report;
+	*report = (DaisyffKerningReport){
+		.pairNum	= gposReport->pairNum,
+		.leftClassNum	= gposReport->leftClassNum,
+		.rightClassNum	= gposReport->rightClassNum,
+		.exceptionNum	= gposReport->exceptionNum,
+		.naiveSize	= gposReport->naiveSize,
+		.tableSize	= gposReport->tableSize,
+	};
+	return DaisyffError_None;
+}
+
+//! @brief 'fvar' Table用の名前を追加してnameIDを返す
+uint16_t DaisyffBuilder_appendVariationName_inline_(DaisyffBuilder *builder, const char *name)
+{
+	builder->variationNames = (char **)ffrealloc(
+			builder->variationNames, sizeof(char *) * (builder->variationNameNum + 1));
+	builder->variationNames[builder->variationNameNum] = ffsprintf_new("%s", name);
+	return (uint16_t)(DaisyffBuilder_VARIATION_NAME_ID_BEGIN + builder->variationNameNum++);
+}
+
+//! @brief 名前用のnameIDが残っていて、en-USの言語別の名前と重ならない
+bool DaisyffBuilder_isVariationNameIdAvailable_inline_(const DaisyffBuilder *builder)
+{
+	const size_t nameId = DaisyffBuilder_VARIATION_NAME_ID_BEGIN + builder->variationNameNum;
+	if(0x7FFF < nameId){
+		return false;
+	}
+	for(size_t i = 0; i < builder->localizedNameNum; i++){
+		if(LanguageID_Windows_EnglishUS == builder->localizedNames[i].languageId
+				&& nameId == builder->localizedNames[i].nameId){
+			return false;
+		}
+	}
+	return true;
+}
+
+//! @brief user座標がaxisの範囲内か
+bool DaisyffBuilder_isValidCoordinates_inline_(const DaisyffBuilder *builder, const double *coordinates)
+{
+	const VariationTablesBuf *variationTablesBuf = &builder->variationTablesBuf;
+	for(size_t a = 0; a < variationTablesBuf->axisNum; a++){
+		const FvarAxis *axis = &variationTablesBuf->axes[a];
+		if(! (axis->minValue <= coordinates[a] && coordinates[a] <= axis->maxValue)){
+			return false;
+		}
+	}
+	return true;
+}
+
+DaisyffError DaisyffBuilder_addAxis_inline_(
+		DaisyffBuilder *builder,
+		const char *tag,
+		double minValue,
+		double defaultValue,
+		double maxValue,
+		const char *name,
+		uint16_t *axisIndex)
+{
+	if(NULL == builder || NULL == tag || NULL == name || (! DaisyffBuilder_isValidUtf8_inline_(name))){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	VariationTablesBuf *variationTablesBuf = &builder->variationTablesBuf;
+	if(0 < variationTablesBuf->instanceNum || 0 < variationTablesBuf->masterNum){
+		return DaisyffError_InvalidState;
+	}
+	TagType tagValue;
+	if(4 != strlen(tag) || (! TagType_init(&tagValue, tag))){
+		return DaisyffError_InvalidArgument;
+	}
+	for(size_t a = 0; a < variationTablesBuf->axisNum; a++){
+		if(0 == memcmp(variationTablesBuf->axes[a].tag, tag, 4)){
+			return DaisyffError_InvalidArgument;
+		}
+	}
+	// Fixed(16.16)に収まる範囲
+	if(! (-32768.0 <= minValue && minValue <= defaultValue && defaultValue <= maxValue && maxValue < 32768.0)
+			|| minValue == maxValue){
+		return DaisyffError_InvalidArgument;
+	}
+	if(VariationTables_AXIS_MAX <= variationTablesBuf->axisNum
+			|| (! DaisyffBuilder_isVariationNameIdAvailable_inline_(builder))){
+		return DaisyffError_TableOverflow;
+	}
+
+	const uint16_t nameId = DaisyffBuilder_appendVariationName_inline_(builder, name);
+	const size_t index = VariationTablesBuf_appendAxis(
+			variationTablesBuf, tag, minValue, defaultValue, maxValue, nameId);
+	if(NULL != axisIndex){
+		*axisIndex = (uint16_t)index;
+	}
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addAxis(
+		DaisyffBuilder *builder,
+		const char *tag,
+		double minValue,
+		double defaultValue,
+		double maxValue,
+		const char *name,
+		uint16_t *axisIndex)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addAxis_inline_(builder, tag, minValue, defaultValue, maxValue, name, axisIndex));
+}
+
+DaisyffError DaisyffBuilder_addAxisMapping_inline_(
+		DaisyffBuilder *builder,
+		uint16_t axisIndex,
+		double fromValue,
+		double toValue)
+{
+	if(NULL == builder){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+	VariationTablesBuf *variationTablesBuf = &builder->variationTablesBuf;
+	if(0 < variationTablesBuf->instanceNum || 0 < variationTablesBuf->masterNum){
+		return DaisyffError_InvalidState;
+	}
+	if(variationTablesBuf->axisNum <= axisIndex){
+		return DaisyffError_InvalidArgument;
+	}
+	const FvarAxis *axis = &variationTablesBuf->axes[axisIndex];
+	const double from = F2Dot14_toDouble(F2Dot14_fromDouble(FvarAxis_normalize(axis, fromValue)));
+	if(! (axis->minValue < fromValue && fromValue < axis->maxValue)
+			|| (! (-1.0 < from && from < 1.0 && 0.0 != from))
+			|| (! (axis->minValue <= toValue && toValue <= axis->maxValue))){
+		return DaisyffError_InvalidArgument;
+	}
+	if(! VariationTablesBuf_appendAxisMap(variationTablesBuf, axisIndex, fromValue, toValue)){
+		return DaisyffError_InvalidArgument;
+	}
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addAxisMapping(
+		DaisyffBuilder *builder,
+		uint16_t axisIndex,
+		double fromValue,
+		double toValue)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addAxisMapping_inline_(builder, axisIndex, fromValue, toValue));
+}
+
+DaisyffError DaisyffBuilder_addNamedInstance_inline_(
+		DaisyffBuilder *builder,
+		const char *subfamilyName,
+		const double *coordinates)
+{
+	if(NULL == builder || NULL == subfamilyName || NULL == coordinates
+			|| (! DaisyffBuilder_isValidUtf8_inline_(subfamilyName))){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally || 0 == builder->variationTablesBuf.axisNum){
+		return DaisyffError_InvalidState;
+	}
+	if(! DaisyffBuilder_isValidCoordinates_inline_(builder, coordinates)){
+		return DaisyffError_InvalidArgument;
+	}
+	if(UINT16_MAX <= builder->variationTablesBuf.instanceNum
+			|| (! DaisyffBuilder_isVariationNameIdAvailable_inline_(builder))){
+		return DaisyffError_TableOverflow;
+	}
+
+	const uint16_t nameId = DaisyffBuilder_appendVariationName_inline_(builder, subfamilyName);
+	VariationTablesBuf_appendInstance(&builder->variationTablesBuf, nameId, coordinates);
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addNamedInstance(
+		DaisyffBuilder *builder,
+		const char *subfamilyName,
+		const double *coordinates)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addNamedInstance_inline_(builder, subfamilyName, coordinates));
+}
+
+DaisyffError DaisyffBuilder_addGlyphMaster_inline_(
+		DaisyffBuilder *builder,
+		uint16_t glyphId,
+		const double *coordinates,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth)
+{
+	if(NULL == builder || NULL == coordinates || (0 < contourNum && NULL == contours)){
+		return DaisyffError_InvalidArgument;
+	}
+	VariationTablesBuf *variationTablesBuf = &builder->variationTablesBuf;
+	if(builder->isFinally || 0 == variationTablesBuf->axisNum){
+		return DaisyffError_InvalidState;
+	}
+	if(builder->glyphTablesBuf.numGlyphs <= glyphId
+			|| (! DaisyffBuilder_isValidCoordinates_inline_(builder, coordinates))){
+		return DaisyffError_InvalidArgument;
+	}
+
+	// ** masterの位置(default位置・同じglyphで同じ位置は不可)
+	int16_t location[VariationTables_AXIS_MAX];
+	VariationTablesBuf_normalizeLocation(variationTablesBuf, coordinates, location);
+	bool isDefault = true;
+	for(size_t a = 0; a < variationTablesBuf->axisNum; a++){
+		isDefault = isDefault && (0 == location[a]);
+	}
+	if(isDefault){
+		return DaisyffError_InvalidArgument;
+	}
+	for(size_t m = 0; m < variationTablesBuf->masterNum; m++){
+		const GvarMaster *master = &variationTablesBuf->masters[m];
+		if(glyphId == master->glyphId
+				&& 0 == memcmp(master->location, location, sizeof(int16_t) * variationTablesBuf->axisNum)){
+			return DaisyffError_InvalidArgument;
+		}
+	}
+
+	// ** default glyphとの互換
+	const VariationDefaultGlyphs *defaultGlyphs = &variationTablesBuf->defaultGlyphs;
+	if(contourNum != VariationDefaultGlyphs_contourNum(defaultGlyphs, glyphId)){
+		return DaisyffError_IncompatibleMaster;
+	}
+	const uint16_t *endPoints = &defaultGlyphs->endPoints[defaultGlyphs->endPointStarts[glyphId]];
+	size_t pointNum = 0;
+	for(size_t i = 0; i < contourNum; i++){
+		if(NULL == contours[i].points){
+			return DaisyffError_InvalidArgument;
+		}
+		pointNum += contours[i].pointNum;
+		if(endPoints[i] + 1 != pointNum){
+			return DaisyffError_IncompatibleMaster;
+		}
+	}
+	if(UINT32_MAX <= variationTablesBuf->masterNum){
+		return DaisyffError_TableOverflow;
+	}
+
+	GlyphPoint *points = (GlyphPoint *)ffmalloc(sizeof(GlyphPoint) * (pointNum + 1));
+	size_t p = 0;
+	for(size_t i = 0; i < contourNum; i++){
+		for(size_t k = 0; k < contours[i].pointNum; k++){
+			points[p++] = (GlyphPoint){contours[i].points[k].x, contours[i].points[k].y};
+		}
+	}
+	VariationTablesBuf_appendMaster(variationTablesBuf, glyphId, location, points, pointNum, advanceWidth);
+	free(points);
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_addGlyphMaster(
+		DaisyffBuilder *builder,
+		uint16_t glyphId,
+		const double *coordinates,
+		const DaisyffContour *contours,
+		size_t contourNum,
+		uint16_t advanceWidth)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_addGlyphMaster_inline_(builder, glyphId, coordinates, contours, contourNum, advanceWidth));
+}
+
+DaisyffError DaisyffBuilder_getVariationReport(const DaisyffBuilder *builder, DaisyffVariationReport *report)
+{
+	if(NULL == builder || NULL == report){
+		return DaisyffError_InvalidArgument;
+	}
+	if(! builder->isFinally){
+		return DaisyffError_InvalidState;
+	}
+
+	const GvarReport *gvarReport = &builder->variationTablesBuf.report;
+	*report = (DaisyffVariationReport){
+		.tupleNum		= gvarReport->tupleNum,
+		.sharedTupleNum		= gvarReport->sharedTupleNum,
+		.pointNum		= gvarReport->pointNum,
+		.omittedPointNum	= gvarReport->omittedPointNum,
+		.gvarSize		= gvarReport->gvarSize,
+		.gvarUnpackedSize	= gvarReport->gvarUnpackedSize,
+	};
+	return DaisyffError_None;
+}
+
+/** @brief 'name' Tableを生成する。
+  言語別の名前がある場合は、基本の名前をWindows en-USにも置く(文字列はUnicode platformと共有される)。
+  @return false: headerとstring strageがUint16のoffsetに収まらない
+  */
+bool DaisyffBuilder_generateNameTable_inline_(DaisyffBuilder *builder, NameTableBuf *nameTableBuf)
+{
+	FFTRACE_BEGIN("name", "table");
+	NameTableBuf_begin(nameTableBuf);
+	const PlatformID platformIDs[] = {PlatformID_Unicode, PlatformID_Windows};
+	const EncodingID encodingIDs[] = {EncodingID_Unicode_0, EncodingID_Windows_UnicodeBMP};
+	const LanguageID languageIDs[] = {0x0, LanguageID_Windows_EnglishUS};
+	const size_t platformNum = (0 == builder->localizedNameNum)? 1 : 2;
+	bool isSuccess = true;
+	for(size_t i = 0; isSuccess && i < platformNum; i++){
+		isSuccess = NameTableBuf_appendFontNames(
+				nameTableBuf, platformIDs[i], encodingIDs[i], languageIDs[i],
+				builder->copyright,
+				builder->familyName,
+				builder->macStyle,
+				builder->versionString,
+				builder->vendorName,
+				builder->designerName,
+				builder->vendorUrl,
+				builder->designerUrl);
+		for(size_t n = 0; isSuccess && n < builder->variationNameNum; n++){
+			isSuccess = NameTableBuf_append(
+					nameTableBuf, platformIDs[i], encodingIDs[i], languageIDs[i],
+					DaisyffBuilder_VARIATION_NAME_ID_BEGIN + n, builder->variationNames[n]);
+		}
+	}
+	for(size_t i = 0; isSuccess && i < builder->localizedNameNum; i++){
+		const DaisyffBuilderLocalizedName *localizedName = &builder->localizedNames[i];
+		isSuccess = NameTableBuf_append(
+				nameTableBuf, PlatformID_Windows, EncodingID_Windows_UnicodeBMP,
+				localizedName->languageId, localizedName->nameId, localizedName->string);
+	}
+	if(isSuccess){
+		NameTableBuf_generateByteData(nameTableBuf);
+	}else{
+		NameTableBuf_free(nameTableBuf);
+	}
+	FFTRACE_END("name", "table");
+
+	return isSuccess;
+}
+
+DaisyffError DaisyffBuilder_finallyToMemory_inline_(DaisyffBuilder *builder, uint8_t **data, size_t *size)
+{
+	if(NULL == builder || NULL == data || NULL == size){
+		return DaisyffError_InvalidArgument;
+	}
+	if(builder->isFinally || (! builder->isNamesSet) || (! builder->isMetricsSet)){
+		return DaisyffError_InvalidState;
+	}
+	// cmap format4のsegmentはUint16のlengthに収まる必要がある
+	{
+		CmapSubtable_Format4_SegmentBuf *segmentBufs = (CmapSubtable_Format4_SegmentBuf *)ffmalloc(
+				sizeof(CmapSubtable_Format4_SegmentBuf) * CmapSubtableFormat4_ARRAY_SIZE);
+		size_t segCount = CmapTable_CmapSubtable_Format4_collectSegments(
+				builder->glyphTablesBuf.cmapSubtableBuf_GlyphIdArray16, segmentBufs);
+		free(segmentBufs);
+		if(UINT16_MAX < CmapTable_CmapSubtable_Format4_lengthFromSegCount(segCount)){
+			return DaisyffError_TableOverflow;
+		}
+	}
+	/**
+	  'name' Table
+	  */
+	NameTableBuf nameTableBuf;
+	if(! DaisyffBuilder_generateNameTable_inline_(builder, &nameTableBuf)){
+		return DaisyffError_TableOverflow;
+	}
+	/**
+	  'fvar', 'avar', 'gvar' Table(axisがある場合のみ)
+	  */
+	VariationTablesBuf *variationTablesBuf = &builder->variationTablesBuf;
+	if(0 < variationTablesBuf->axisNum){
+		if(! VariationTablesBuf_finally(variationTablesBuf, builder->glyphTablesBuf.numGlyphs)){
+			NameTableBuf_free(&nameTableBuf);
+			return DaisyffError_TableOverflow;
+		}
+	}
+	builder->isFinally = true;
+
+	FFTRACE_BEGIN("DaisyffBuilder_finally", "stage");
+	const DaisyffMetrics *metrics = &builder->metrics;
+
+	/**
+	  'head' Table
+	  */
+	FFTRACE_BEGIN("head", "stage");
+	BBox bBox = BBox_generate(metrics->xMin, metrics->xMax, metrics->yMin, metrics->yMax);
+	HeadTable headTable;
+	HeadTableFlagsElement	flags = (HeadTableFlagsElement)(0x0
+			| HeadTableFlagsElement_Bit1_isLeftSidebearingPointAtXIsZero
+			);
+	ASSERT(HeadTable_init(
+			&headTable,
+			0x00010000,
+			flags,
+			LONGDATETIMEType_generate(metrics->created),
+			LONGDATETIMEType_generate(metrics->modified),
+			builder->macStyle,
+			bBox,
+			metrics->lowestRecPPEM
+			));
+	FFTRACE_END("head", "stage");
+
+	/**
+	  'glyf', 'loca', 'cmap' Table
+	  */
+	FFTRACE_BEGIN("glyf", "stage");
+	GlyphTablesBuf *glyphTablesBuf = &builder->glyphTablesBuf;
+	HmtxTableBuf *hmtxTableBuf = &builder->hmtxTableBuf;
+	GlyphTablesBuf_finally(glyphTablesBuf);
+	headTable.indexToLocFormat = htons(glyphTablesBuf->indexToLocFormat);
+	FFTRACE_END("glyf", "stage");
+
+	/**
+	  'hhea', 'hmtx' Table
+	  */
+	HheaTable hheaTable = {0};
+	HheaTable_init(
+			&hheaTable,
+			metrics->ascender,
+			metrics->descender,
+			metrics->lineGap,
+			hmtxTableBuf->advanceWidthMax,
+			builder->minLeftSideBearing,
+			builder->minRightSideBearing,
+			builder->xMaxExtent,
+			hmtxTableBuf->numberOfHMetrics);
+	HmtxTableBuf_finally(hmtxTableBuf);
+
+	/**
+	'maxp' Table:
+	 使用グリフ数。
+	 TrueType必須Table。
+	*/
+	MaxpTable_Version10 maxpTable_Version10 = {
+		.version		= (FixedType)htonl(0x00010000),
+		.numGlyphs		= htons(glyphTablesBuf->numGlyphs),
+		.maxPoints		= htons(builder->maxPoints),
+		.maxContours		= htons(builder->maxContours),
+		.maxCompositePoints	= htons(0),
+		.maxCompositeContours	= htons(0),
+		.maxZones		= htons(2), // @todo 以下はFF由来の仮の固定値
+		.maxTwilightPoints	= htons(0),
+		.maxStorage		= htons(1),
+		.maxFunctionDefs	= htons(1),
+		.maxInstructionDefs	= htons(0),
+		.maxStackElements	= htons(64),
+		.maxSizeOfInstructions	= htons(0),
+		.maxComponentElements	= htons(0),
+		.maxComponentDepth	= htons(0),
+	};
+
+	/**
+	  'post' Table: PostScriptエンジン(プリンタ等)が使用する参考情報
+	 */
+	PostTable_Header postTable = {
+		.version		= htonl(0x00030000),
+		.italicAngle		= htonl(0x00000000),
+		.underlinePosition	= htons(-125),
+		.underlineThickness	= htons(50),
+		.isFixedPitch		= htonl(0x00000001),
+	};
+
+	/**
+	  'GPOS' Table: kerning(pairがある場合のみ)
+	  */
+	if(0 < builder->gposTableBuf.pairNum){
+		GposTableBuf_finally(&builder->gposTableBuf);
+	}
+
+	/**
+	TableDiectoryを生成しつつ、Tableをバイト配列に変換して繋げていく。
+	  */
+	FFTRACE_BEGIN("tables", "stage");
+	Tablebuf tableBuf;
+	Tablebuf_init(&tableBuf);
+
+	Tablebuf_appendTable(&tableBuf, "head", (void *)(&headTable), sizeof(HeadTable));
+	Tablebuf_appendTable(&tableBuf, "name", (void *)(nameTableBuf.data), nameTableBuf.dataSize);
+	Tablebuf_appendTable(&tableBuf, "maxp", (void *)(&maxpTable_Version10), sizeof(MaxpTable_Version10));
+	Tablebuf_appendTable(&tableBuf, "cmap", (void *)(glyphTablesBuf->cmapByteArray.data), glyphTablesBuf->cmapByteArray.length);
+	Tablebuf_appendTable(&tableBuf, "loca", (void *)(glyphTablesBuf->locaByteArray.data), glyphTablesBuf->locaByteArray.length);
+	Tablebuf_appendTable(&tableBuf, "glyf", (void *)(glyphTablesBuf->glyfData), glyphTablesBuf->glyfDataSize);
+	Tablebuf_appendTable(&tableBuf, "hhea", (void *)(&hheaTable), sizeof(HheaTable));
+	Tablebuf_appendTable(&tableBuf, "hmtx", (void *)(hmtxTableBuf->byteArray.data), hmtxTableBuf->byteArray.length);
+	Tablebuf_appendTable(&tableBuf, "post", (void *)(&postTable), sizeof(PostTable_Header));
+	if(0 < builder->gposTableBuf.pairNum){
+		Tablebuf_appendTable(&tableBuf, "GPOS", (void *)(builder->gposTableBuf.byteArray.data), builder->gposTableBuf.byteArray.length);
+	}
+	if(0 < variationTablesBuf->axisNum){
+		Tablebuf_appendTable(&tableBuf, "fvar", (void *)(variationTablesBuf->fvarByteArray.data), variationTablesBuf->fvarByteArray.length);
+		if(0 < variationTablesBuf->avarByteArray.length){
+			Tablebuf_appendTable(&tableBuf, "avar", (void *)(variationTablesBuf->avarByteArray.data), variationTablesBuf->avarByteArray.length);
+		}
+		Tablebuf_appendTable(&tableBuf, "gvar", (void *)(variationTablesBuf->gvarByteArray.data), variationTablesBuf->gvarByteArray.length);
+	}
+	NameTableBuf_free(&nameTableBuf);
+
+	// offsetは、Tableのフォントファイル先頭からのオフセット。先に計算しておく。
+	const size_t offsetHeadSize = sizeof(OffsetTable) + (sizeof(TableDirectory_Member) * tableBuf.appendTableNum);
+	Tablebuf_finallyTableDirectoryOffset(&tableBuf, offsetHeadSize);
+	FFTRACE_END("tables", "stage");
+
+	/**
+	OffsetTable:
+	 (Offset Subtable, sfnt)
+	*/
+	OffsetTable offsetTable;
+	ASSERT(OffsetTable_init(&offsetTable, 0x00010000, tableBuf.appendTableNum));
+
+	const size_t fontDataSize = offsetHeadSize + tableBuf.dataSize;
+	uint8_t *fontData = (uint8_t *)ffmalloc(sizeof(uint8_t) * fontDataSize);
+	memcpy(&fontData[0], (uint8_t *)&offsetTable, sizeof(OffsetTable));
+	memcpy(&fontData[sizeof(OffsetTable)], (uint8_t *)tableBuf.tableDirectory, (sizeof(TableDirectory_Member) * tableBuf.appendTableNum));
+	memcpy(&fontData[offsetHeadSize], (uint8_t *)tableBuf.data, tableBuf.dataSize);
+	Tablebuf_free(&tableBuf);
+
+	/**
+	  'head'TableにcheckSumAdjustment要素を計算して書き込む。
+	  */
+	FFTRACE_BEGIN("checkSumAdjustment", "stage");
+	Uint32Type checkSumAdjustment = 0xB1B0AFBA - CalcTableChecksum((uint32_t *)fontData, fontDataSize);
+	size_t checkSumAdjustmentOffset =
+		offsetHeadSize
+		+ 0 // 'head' Tableは先頭に置くこととする。
+		+ offsetof(HeadTable, checkSumAdjustment)
+		;
+	uint32_t checkSumAdjustment_Net = htonl(checkSumAdjustment);
+	memcpy(&fontData[checkSumAdjustmentOffset], &checkSumAdjustment_Net, sizeof(uint32_t));
+	FFTRACE_END("checkSumAdjustment", "stage");
+	FFTRACE_END("DaisyffBuilder_finally", "stage");
+
+	*data = fontData;
+	*size = fontDataSize;
+
+	return DaisyffError_None;
+}
+
+DaisyffError DaisyffBuilder_finallyToMemory(DaisyffBuilder *builder, uint8_t **data, size_t *size)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_finallyToMemory_inline_(builder, data, size));
+}
+
+DaisyffError DaisyffBuilder_finallyToFd_inline_(DaisyffBuilder *builder, int fd)
+{
+	if(fd < 0){
+		return DaisyffError_InvalidArgument;
+	}
+
+	uint8_t *fontData;
+	size_t fontDataSize;
+	DaisyffError error = DaisyffBuilder_finallyToMemory(builder, &fontData, &fontDataSize);
+	if(DaisyffError_None != error){
+		return error;
+	}
+
+	FFTRACE_BEGIN("write", "stage");
+	size_t offset = 0;
+	while(offset < fontDataSize){
+		ssize_t s = write(fd, &fontData[offset], fontDataSize - offset);
+		if(-1 == s && EINTR == errno){
+			continue;
+		}
+		if(s <= 0){
+			error = DaisyffError_Io;
+			break;
+		}
+		offset += s;
+	}
+	FFTRACE_END("write", "stage");
+	free(fontData);
+
+	return error;
+}
+
+DaisyffError DaisyffBuilder_finallyToFd(DaisyffBuilder *builder, int fd)
+{
+	DaisyffBuilder_RETURN_GUARDED_(builder, DaisyffBuilder_finallyToFd_inline_(builder, fd));
+}
+
+void DaisyffTrace_enable(void)
+{
+	FFTrace_enable();
+}
+
+bool DaisyffTrace_writeJson(const char *filepath)
+{
+	if(NULL == filepath){
+		return false;
+	}
+	return FFTrace_writeJson(filepath);
+}
+
+#endif // #ifndef DAISYFF_DAISYFF_BUILDER_HPP_
+
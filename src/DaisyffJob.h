@@ -0,0 +1,702 @@
+/**
+  @file
+  @brief daisyffのフォント生成job(1行のjob記述 -> libdaisyffでフォントファイルを生成)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  include/daisyff.hのAPIのみを使う。
+
+  job記述: `key=value`を空白区切りで並べた1行。
+    name=FAMILY		(必須) family name
+    output=PATH		出力先(省略時 `FAMILY.otf`)
+    glyphs=PATH		glyph sourceファイル(省略時 DaisyMiniの'A'のみ)
+    style=regular|bold|italic
+
+  glyph sourceファイル: 1行1glyph。空行と`#`から始まる行は無視する。
+    U+0041 500 50 50,100 250,600 450,100 250,180 / ...
+    (codepoint advanceWidth lsb 座標... `/`で次のcontour)
+    KERN U+0041 U+0056 -80
+    (kerning: 左codepoint 右codepoint xAdvance。glyphはそれより前の行で定義する)
+  variable font(AXIS, AXISMAP行はINSTANCE, MASTER行より前に置く):
+    AXIS wght 100 400 900 Weight	(tag min default max 名前)
+    AXISMAP wght 700 650		(user座標の対応 from to)
+    INSTANCE Bold wght=700		(named instance。省略したaxisはdefault)
+    MASTER U+0041 wght=900 560 40,100 280,600 520,100 280,180 / ...
+    (glyphのmaster: codepoint 位置 advanceWidth 座標...。点の並びはdefault glyphと同じ)
+ */
+#ifndef DAISYFF_DAISYFF_JOB_HPP_
+#define DAISYFF_DAISYFF_JOB_HPP_
+
+#include "include/daisyff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DaisyffJob_MESSAGE_SIZE (256)
+#define DaisyffJob_AXIS_MAX (64)
+
+typedef struct{
+	char			*name;
+	char			*output;
+	char			*glyphs;
+	DaisyffMacStyle		macStyle;
+}DaisyffJobSpec;
+
+//! glyph sourceのcontour(scratch.points[]の範囲)
+typedef struct{
+	size_t			pointStart;
+	size_t			pointNum;
+}DaisyffJobContourRange;
+
+/** job間で使い回す作業領域(server modeではworker毎に1つ持つ)。
+  巨大なglyph sourceでも毎回確保し直さずに済む。
+  */
+typedef struct{
+	char			*line;
+	size_t			lineCapacity;
+	DaisyffPoint		*points;
+	size_t			pointCapacity;
+	DaisyffJobContourRange	*ranges;
+	DaisyffContour		*contours;
+	size_t			contourCapacity;
+	uint16_t		*glyphIdOfCodepoint;	//!< [0x10000] KERN行の解決用(0: 未定義)
+	char			axisTags[DaisyffJob_AXIS_MAX][5];	//!< AXIS行のtag(追加順 = axis index)
+	double			axisDefaults[DaisyffJob_AXIS_MAX];
+	size_t			axisNum;
+	double			coordinates[DaisyffJob_AXIS_MAX];	//!< INSTANCE, MASTER行の位置
+}DaisyffJobScratch;
+
+typedef struct{
+	size_t			fileSize;
+	size_t			numGlyphs;
+	DaisyffKerningReport	kerning;
+	DaisyffVariationReport	variation;
+}DaisyffJobResult;
+
+void DaisyffJob_setMessage_inline_(char *message, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+void DaisyffJob_setMessage_inline_(char *message, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(message, DaisyffJob_MESSAGE_SIZE, fmt, ap);
+	va_end(ap);
+}
+
+// ** 確保失敗ではプロセスを終了せず、jobの失敗として返す(serverは次のjobを続ける)
+
+//! @return NULL: 確保失敗
+char *DaisyffJob_strdup_inline_(const char *str)
+{
+	char *dst = (char *)malloc(strlen(str) + 1);
+	if(NULL != dst){
+		strcpy(dst, str);
+	}
+	return dst;
+}
+
+//! @return false: 確保失敗(*pはそのまま)
+bool DaisyffJob_realloc_inline_(void **p, size_t size)
+{
+	void *dst = realloc(*p, size);
+	if(NULL == dst){
+		return false;
+	}
+	*p = dst;
+	return true;
+}
+
+void DaisyffJobSpec_free(DaisyffJobSpec *spec)
+{
+	free(spec->name);
+	free(spec->output);
+	free(spec->glyphs);
+	*spec = (DaisyffJobSpec){0};
+}
+
+/** @brief job記述の1行をparseする。
+  @return false: 記述が不正(messageに理由)
+  */
+bool DaisyffJobSpec_parse(DaisyffJobSpec *spec, const char *line, char *message)
+{
+	*spec = (DaisyffJobSpec){0};
+	spec->macStyle = DaisyffMacStyle_Regular;
+
+	char *work = DaisyffJob_strdup_inline_(line);
+	if(NULL == work){
+		DaisyffJob_setMessage_inline_(message, "no memory");
+		return false;
+	}
+	char *saveptr = NULL;
+	for(char *token = strtok_r(work, " \t\r\n", &saveptr);
+			NULL != token;
+			token = strtok_r(NULL, " \t\r\n", &saveptr)){
+		char *value = strchr(token, '=');
+		if(NULL == value || '\0' == value[1]){
+			DaisyffJob_setMessage_inline_(message, "invalid token `%s`", token);
+			goto err;
+		}
+		*value = '\0';
+		value++;
+
+		char **stringValue = NULL;
+		if(0 == strcmp("name", token)){
+			stringValue = &spec->name;
+		}else if(0 == strcmp("output", token)){
+			stringValue = &spec->output;
+		}else if(0 == strcmp("glyphs", token)){
+			stringValue = &spec->glyphs;
+		}else if(0 == strcmp("style", token)){
+			if(0 == strcmp("regular", value)){
+				spec->macStyle = DaisyffMacStyle_Regular;
+			}else if(0 == strcmp("bold", value)){
+				spec->macStyle = DaisyffMacStyle_Bold;
+			}else if(0 == strcmp("italic", value)){
+				spec->macStyle = DaisyffMacStyle_Italic;
+			}else{
+				DaisyffJob_setMessage_inline_(message, "invalid style `%s`", value);
+				goto err;
+			}
+		}else{
+			DaisyffJob_setMessage_inline_(message, "unknown key `%s`", token);
+			goto err;
+		}
+		if(NULL != stringValue){
+			free(*stringValue);
+			*stringValue = DaisyffJob_strdup_inline_(value);
+			if(NULL == *stringValue){
+				DaisyffJob_setMessage_inline_(message, "no memory");
+				goto err;
+			}
+		}
+	}
+
+	if(NULL == spec->name){
+		DaisyffJob_setMessage_inline_(message, "`name` is required");
+		goto err;
+	}
+	if(NULL == spec->output){
+		spec->output = (char *)malloc(strlen(spec->name) + 5);
+		if(NULL == spec->output){
+			DaisyffJob_setMessage_inline_(message, "no memory");
+			goto err;
+		}
+		sprintf(spec->output, "%s.otf", spec->name);
+	}
+
+	free(work);
+	return true;
+err:
+	free(work);
+	DaisyffJobSpec_free(spec);
+	return false;
+}
+
+void DaisyffJobScratch_free(DaisyffJobScratch *scratch)
+{
+	free(scratch->line);
+	free(scratch->points);
+	free(scratch->ranges);
+	free(scratch->contours);
+	free(scratch->glyphIdOfCodepoint);
+	*scratch = (DaisyffJobScratch){0};
+}
+
+/** @brief 行の残りの`x,y ... / ...`をscratch.contours[]へ読む。
+  @param saveptr strtok_r()の続き
+  */
+bool DaisyffJob_parseContours_inline_(
+		DaisyffJobScratch *scratch,
+		char **saveptr,
+		size_t lineNumber,
+		char *message,
+		size_t *contourNumResult)
+{
+	size_t pointNum = 0;
+	size_t contourNum = 0;
+	bool isContourOpen = false;
+	for(const char *token = strtok_r(NULL, " \t\r\n", saveptr);
+			NULL != token;
+			token = strtok_r(NULL, " \t\r\n", saveptr)){
+		if(0 == strcmp("/", token)){
+			if(! isContourOpen){
+				DaisyffJob_setMessage_inline_(message, "glyphs:%zu: empty contour", lineNumber);
+				return false;
+			}
+			isContourOpen = false;
+			continue;
+		}
+		long x, y;
+		char tail;
+		if(2 != sscanf(token, "%ld,%ld%c", &x, &y, &tail)
+				|| x < INT16_MIN || INT16_MAX < x || y < INT16_MIN || INT16_MAX < y){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid point `%s`", lineNumber, token);
+			return false;
+		}
+		if(! isContourOpen){
+			if(scratch->contourCapacity <= contourNum){
+				const size_t capacity = (0 == scratch->contourCapacity)? 16 : scratch->contourCapacity * 2;
+				if(! DaisyffJob_realloc_inline_((void **)&scratch->ranges, sizeof(DaisyffJobContourRange) * capacity)
+						|| ! DaisyffJob_realloc_inline_((void **)&scratch->contours, sizeof(DaisyffContour) * capacity)){
+					DaisyffJob_setMessage_inline_(message, "glyphs:%zu: no memory", lineNumber);
+					return false;
+				}
+				scratch->contourCapacity = capacity;
+			}
+			scratch->ranges[contourNum] = (DaisyffJobContourRange){pointNum, 0};
+			contourNum++;
+			isContourOpen = true;
+		}
+		if(scratch->pointCapacity <= pointNum){
+			const size_t capacity = (0 == scratch->pointCapacity)? 64 : scratch->pointCapacity * 2;
+			if(! DaisyffJob_realloc_inline_((void **)&scratch->points, sizeof(DaisyffPoint) * capacity)){
+				DaisyffJob_setMessage_inline_(message, "glyphs:%zu: no memory", lineNumber);
+				return false;
+			}
+			scratch->pointCapacity = capacity;
+		}
+		scratch->points[pointNum] = (DaisyffPoint){(int16_t)x, (int16_t)y};
+		scratch->ranges[contourNum - 1].pointNum++;
+		pointNum++;
+	}
+	if(0 < contourNum && (! isContourOpen)){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: empty contour", lineNumber);
+		return false;
+	}
+	// points[]はreallocで動くので、ポインタは最後に解決する
+	for(size_t i = 0; i < contourNum; i++){
+		scratch->contours[i].points	= &scratch->points[scratch->ranges[i].pointStart];
+		scratch->contours[i].pointNum	= scratch->ranges[i].pointNum;
+	}
+
+	*contourNumResult = contourNum;
+	return true;
+}
+
+//! @brief `U+XXXX`を定義済みglyphのGlyphIdへ解決する
+bool DaisyffJob_resolveGlyphId_inline_(
+		const DaisyffJobScratch *scratch,
+		const char *token,
+		uint16_t *glyphId)
+{
+	if(NULL == token || 0 != strncmp("U+", token, 2) || '\0' == token[2]){
+		return false;
+	}
+	char *end;
+	const unsigned long codepoint = strtoul(&token[2], &end, 16);
+	if('\0' != *end || UINT16_MAX < codepoint || 0 == scratch->glyphIdOfCodepoint[codepoint]){
+		return false;
+	}
+	*glyphId = scratch->glyphIdOfCodepoint[codepoint];
+	return true;
+}
+
+//! @brief `KERN U+XXXX U+XXXX xAdvance`行をbuilderへ追加する。
+bool DaisyffJob_addKerningFromLine_inline_(
+		DaisyffBuilder *builder,
+		DaisyffJobScratch *scratch,
+		char **saveptr,
+		size_t lineNumber,
+		char *message)
+{
+	const char *tokenLeft		= strtok_r(NULL, " \t\r\n", saveptr);
+	const char *tokenRight		= strtok_r(NULL, " \t\r\n", saveptr);
+	const char *tokenXAdvance	= strtok_r(NULL, " \t\r\n", saveptr);
+	if(NULL == tokenXAdvance || NULL != strtok_r(NULL, " \t\r\n", saveptr)){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `KERN U+XXXX U+XXXX xAdvance`", lineNumber);
+		return false;
+	}
+	uint16_t leftGlyphId;
+	uint16_t rightGlyphId;
+	if(! DaisyffJob_resolveGlyphId_inline_(scratch, tokenLeft, &leftGlyphId)){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: undefined glyph `%s`", lineNumber, tokenLeft);
+		return false;
+	}
+	if(! DaisyffJob_resolveGlyphId_inline_(scratch, tokenRight, &rightGlyphId)){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: undefined glyph `%s`", lineNumber, tokenRight);
+		return false;
+	}
+	char *end;
+	const long xAdvance = strtol(tokenXAdvance, &end, 10);
+	if('\0' != *end || xAdvance < INT16_MIN || INT16_MAX < xAdvance){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid xAdvance `%s`", lineNumber, tokenXAdvance);
+		return false;
+	}
+
+	DaisyffError error = DaisyffBuilder_addKerningPair(builder, leftGlyphId, rightGlyphId, (int16_t)xAdvance);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: KERN: %s", lineNumber, DaisyffError_toString(error));
+		return false;
+	}
+	return true;
+}
+
+bool DaisyffJob_parseDouble_inline_(const char *token, double *value)
+{
+	if(NULL == token){
+		return false;
+	}
+	char *end;
+	*value = strtod(token, &end);
+	return ('\0' != token[0] && '\0' == *end);
+}
+
+//! @return axis index。-1: 未定義
+int DaisyffJob_findAxis_inline_(const DaisyffJobScratch *scratch, const char *tag)
+{
+	for(size_t a = 0; a < scratch->axisNum; a++){
+		if(0 == strcmp(scratch->axisTags[a], tag)){
+			return (int)a;
+		}
+	}
+	return -1;
+}
+
+/** @brief `tag=value`の並びをscratch.coordinatesへ読む(省略したaxisはdefault)。
+  @return 次のtoken(`tag=value`ではない最初のtoken)。NULL: 行末
+  */
+const char *DaisyffJob_parseLocation_inline_(
+		DaisyffJobScratch *scratch,
+		char **saveptr,
+		size_t lineNumber,
+		char *message,
+		bool *isSuccess)
+{
+	memcpy(scratch->coordinates, scratch->axisDefaults, sizeof(double) * scratch->axisNum);
+	*isSuccess = true;
+	const char *token;
+	while(NULL != (token = strtok_r(NULL, " \t\r\n", saveptr))){
+		const char *value = strchr(token, '=');
+		if(NULL == value){
+			return token;
+		}
+		char tag[5] = "";
+		const size_t tagLength = value - token;
+		if(tagLength < sizeof(tag)){
+			memcpy(tag, token, tagLength);
+		}
+		const int axisIndex = DaisyffJob_findAxis_inline_(scratch, tag);
+		if(4 != tagLength || axisIndex < 0
+				|| (! DaisyffJob_parseDouble_inline_(&value[1], &scratch->coordinates[axisIndex]))){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid location `%s`", lineNumber, token);
+			*isSuccess = false;
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+/** @brief variable fontの行(AXIS, AXISMAP, INSTANCE, MASTER)をbuilderへ追加する。
+  @param keyword 行の最初のtoken
+  */
+bool DaisyffJob_addVariationFromLine_inline_(
+		DaisyffBuilder *builder,
+		DaisyffJobScratch *scratch,
+		const char *keyword,
+		char **saveptr,
+		size_t lineNumber,
+		char *message)
+{
+	DaisyffError error = DaisyffError_None;
+	if(0 == strcmp("AXIS", keyword)){
+		const char *tag = strtok_r(NULL, " \t\r\n", saveptr);
+		double values[3];
+		bool isValid = (NULL != tag && 4 == strlen(tag));
+		for(int i = 0; i < 3; i++){
+			isValid = isValid && DaisyffJob_parseDouble_inline_(strtok_r(NULL, " \t\r\n", saveptr), &values[i]);
+		}
+		const char *name = strtok_r(NULL, " \t\r\n", saveptr);
+		if((! isValid) || NULL == name || DaisyffJob_AXIS_MAX <= scratch->axisNum){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `AXIS tag min default max name`", lineNumber);
+			return false;
+		}
+		error = DaisyffBuilder_addAxis(builder, tag, values[0], values[1], values[2], name, NULL);
+		if(DaisyffError_None == error){
+			strcpy(scratch->axisTags[scratch->axisNum], tag);
+			scratch->axisDefaults[scratch->axisNum] = values[1];
+			scratch->axisNum++;
+		}
+	}else if(0 == strcmp("AXISMAP", keyword)){
+		const char *tag = strtok_r(NULL, " \t\r\n", saveptr);
+		double from;
+		double to;
+		const int axisIndex = (NULL == tag)? -1 : DaisyffJob_findAxis_inline_(scratch, tag);
+		if(axisIndex < 0
+				|| (! DaisyffJob_parseDouble_inline_(strtok_r(NULL, " \t\r\n", saveptr), &from))
+				|| (! DaisyffJob_parseDouble_inline_(strtok_r(NULL, " \t\r\n", saveptr), &to))){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `AXISMAP tag from to`", lineNumber);
+			return false;
+		}
+		error = DaisyffBuilder_addAxisMapping(builder, (uint16_t)axisIndex, from, to);
+	}else if(0 == strcmp("INSTANCE", keyword)){
+		const char *name = strtok_r(NULL, " \t\r\n", saveptr);
+		bool isSuccess;
+		const char *rest = DaisyffJob_parseLocation_inline_(scratch, saveptr, lineNumber, message, &isSuccess);
+		if(! isSuccess){
+			return false;
+		}
+		if(NULL == name || NULL != rest){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `INSTANCE name tag=value ...`", lineNumber);
+			return false;
+		}
+		error = DaisyffBuilder_addNamedInstance(builder, name, scratch->coordinates);
+	}else{ // MASTER
+		uint16_t glyphId;
+		const char *tokenCodepoint = strtok_r(NULL, " \t\r\n", saveptr);
+		if(! DaisyffJob_resolveGlyphId_inline_(scratch, tokenCodepoint, &glyphId)){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: undefined glyph `%s`",
+					lineNumber, (NULL == tokenCodepoint)? "" : tokenCodepoint);
+			return false;
+		}
+		bool isSuccess;
+		const char *tokenAdvanceWidth = DaisyffJob_parseLocation_inline_(scratch, saveptr, lineNumber, message, &isSuccess);
+		if(! isSuccess){
+			return false;
+		}
+		char *end;
+		const long advanceWidth = (NULL == tokenAdvanceWidth)? -1 : strtol(tokenAdvanceWidth, &end, 10);
+		if(NULL == tokenAdvanceWidth || '\0' != *end || advanceWidth < 0 || UINT16_MAX < advanceWidth){
+			DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `MASTER U+XXXX tag=value ... advanceWidth points`", lineNumber);
+			return false;
+		}
+		size_t contourNum;
+		if(! DaisyffJob_parseContours_inline_(scratch, saveptr, lineNumber, message, &contourNum)){
+			return false;
+		}
+		error = DaisyffBuilder_addGlyphMaster(
+				builder, glyphId, scratch->coordinates, scratch->contours, contourNum, (uint16_t)advanceWidth);
+	}
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: %s: %s", lineNumber, keyword, DaisyffError_toString(error));
+		return false;
+	}
+	return true;
+}
+
+//! @brief glyph sourceの1行をparseしてbuilderへ追加する。
+bool DaisyffJob_addGlyphFromLine_inline_(
+		DaisyffBuilder *builder,
+		DaisyffJobScratch *scratch,
+		char *line,
+		size_t lineNumber,
+		char *message)
+{
+	char *saveptr = NULL;
+	const char *tokenCodepoint	= strtok_r(line, " \t\r\n", &saveptr);
+	if(NULL == tokenCodepoint || '#' == tokenCodepoint[0]){
+		return true; // 空行・コメント
+	}
+	if(0 == strcmp("KERN", tokenCodepoint)){
+		return DaisyffJob_addKerningFromLine_inline_(builder, scratch, &saveptr, lineNumber, message);
+	}
+	if(0 == strcmp("AXIS", tokenCodepoint) || 0 == strcmp("AXISMAP", tokenCodepoint)
+			|| 0 == strcmp("INSTANCE", tokenCodepoint) || 0 == strcmp("MASTER", tokenCodepoint)){
+		return DaisyffJob_addVariationFromLine_inline_(builder, scratch, tokenCodepoint, &saveptr, lineNumber, message);
+	}
+	const char *tokenAdvanceWidth	= strtok_r(NULL, " \t\r\n", &saveptr);
+	const char *tokenLsb		= strtok_r(NULL, " \t\r\n", &saveptr);
+	if(NULL == tokenAdvanceWidth || NULL == tokenLsb
+			|| 0 != strncmp("U+", tokenCodepoint, 2)){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: expected `U+XXXX advanceWidth lsb`", lineNumber);
+		return false;
+	}
+	char *end;
+	const unsigned long codepoint = strtoul(&tokenCodepoint[2], &end, 16);
+	if('\0' != *end || '\0' == tokenCodepoint[2]){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid codepoint `%s`", lineNumber, tokenCodepoint);
+		return false;
+	}
+	const long advanceWidth = strtol(tokenAdvanceWidth, &end, 10);
+	if('\0' != *end || advanceWidth < 0 || UINT16_MAX < advanceWidth){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid advanceWidth `%s`", lineNumber, tokenAdvanceWidth);
+		return false;
+	}
+	const long lsb = strtol(tokenLsb, &end, 10);
+	if('\0' != *end || lsb < INT16_MIN || INT16_MAX < lsb){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: invalid lsb `%s`", lineNumber, tokenLsb);
+		return false;
+	}
+
+	size_t contourNum;
+	if(! DaisyffJob_parseContours_inline_(scratch, &saveptr, lineNumber, message, &contourNum)){
+		return false;
+	}
+
+	uint16_t glyphId;
+	DaisyffError error = DaisyffBuilder_addGlyph(
+			builder, (uint32_t)codepoint, scratch->contours, contourNum,
+			(uint16_t)advanceWidth, (int16_t)lsb, &glyphId);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "glyphs:%zu: U+%04lX: %s",
+				lineNumber, codepoint, DaisyffError_toString(error));
+		return false;
+	}
+	scratch->glyphIdOfCodepoint[codepoint] = glyphId;
+
+	return true;
+}
+
+bool DaisyffJob_addGlyphsFromFile_inline_(
+		DaisyffBuilder *builder,
+		DaisyffJobScratch *scratch,
+		const char *filepath,
+		char *message)
+{
+	FILE *fp = fopen(filepath, "r");
+	if(NULL == fp){
+		DaisyffJob_setMessage_inline_(message, "glyphs `%s`: %s", filepath, strerror(errno));
+		return false;
+	}
+
+	if(NULL == scratch->glyphIdOfCodepoint
+			&& ! DaisyffJob_realloc_inline_((void **)&scratch->glyphIdOfCodepoint, sizeof(uint16_t) * (UINT16_MAX + 1))){
+		DaisyffJob_setMessage_inline_(message, "glyphs `%s`: no memory", filepath);
+		fclose(fp);
+		return false;
+	}
+	memset(scratch->glyphIdOfCodepoint, 0, sizeof(uint16_t) * (UINT16_MAX + 1));
+	scratch->axisNum = 0;
+
+	bool isSuccess = true;
+	size_t lineNumber = 0;
+	while(-1 != getline(&scratch->line, &scratch->lineCapacity, fp)){
+		lineNumber++;
+		if(! DaisyffJob_addGlyphFromLine_inline_(builder, scratch, scratch->line, lineNumber, message)){
+			isSuccess = false;
+			break;
+		}
+	}
+	if(isSuccess && (ferror(fp) || ! feof(fp))){
+		// getline()の確保失敗・読み込みエラーを終端と区別する
+		DaisyffJob_setMessage_inline_(message, "glyphs `%s`:%zu: %s", filepath, lineNumber + 1, strerror(errno));
+		isSuccess = false;
+	}
+	fclose(fp);
+
+	return isSuccess;
+}
+
+//! @brief glyph source未指定時のglyph(DaisyMiniの'A')
+bool DaisyffJob_addDefaultGlyphs_inline_(DaisyffBuilder *builder, char *message)
+{
+	// ** //! @todo flags repeat, Coodinates SHORT_VECTOR
+	const DaisyffPoint points_A[] = {
+		{  50, 100},
+		{ 250, 600},
+		{ 450, 100},
+		{ 250, 180},
+	};
+	const DaisyffContour contours_A[] = {
+		{points_A, sizeof(points_A) / sizeof(points_A[0])},
+	};
+	DaisyffError error = DaisyffBuilder_addGlyph(
+			builder, 'A', contours_A, sizeof(contours_A) / sizeof(contours_A[0]), 500, 50, NULL);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "addGlyph 'A': %s", DaisyffError_toString(error));
+		return false;
+	}
+	return true;
+}
+
+/** @brief jobを実行してフォントファイルを書き出す。
+  @param message [DaisyffJob_MESSAGE_SIZE] 失敗時に理由を返す
+  */
+bool DaisyffJob_run(
+		const DaisyffJobSpec *spec,
+		DaisyffJobScratch *scratch,
+		DaisyffJobResult *result,
+		char *message)
+{
+	*result = (DaisyffJobResult){0};
+
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	if(NULL == builder){
+		DaisyffJob_setMessage_inline_(message, "DaisyffBuilder_new: %s", DaisyffError_toString(DaisyffError_NoMemory));
+		return false;
+	}
+
+	DaisyffError error;
+	const DaisyffNames names = {
+		.copyright	= "©Copyright the project daisy bell 2019",
+		.familyName	= spec->name,
+		.macStyle	= spec->macStyle,
+		.versionString	= "Version 1.0",
+		.vendorName	= "project daisy bell",
+		.designerName	= "MichinariNukazawa",
+		.vendorUrl	= "https://daisy-bell.booth.pm/",
+		.designerUrl	= "https://twitter.com/MNukazawa",
+	};
+	error = DaisyffBuilder_setNames(builder, &names);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "setNames `%s`: %s", spec->name, DaisyffError_toString(error));
+		goto err;
+	}
+
+	const int baseline = 300;
+	const time_t time_20190101 = 1546300800; // 2019-01-01T00:00:00+00:00
+	const DaisyffMetrics metrics = {
+		// 値は一応のデザインルールから仮の値
+		.xMin		= 50,
+		.yMin		= - baseline,
+		.xMax		= 450,
+		.yMax		= 1000 - baseline,
+		.ascender	= 1000 - baseline,
+		.descender	= baseline,
+		.lineGap	= 24,
+		.lowestRecPPEM	= 8,
+		.created	= time_20190101,
+		.modified	= time_20190101,
+	};
+	error = DaisyffBuilder_setMetrics(builder, &metrics);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "setMetrics: %s", DaisyffError_toString(error));
+		goto err;
+	}
+
+	// ** 目的の字形・文字を追加していく
+	if(NULL == spec->glyphs){
+		if(! DaisyffJob_addDefaultGlyphs_inline_(builder, message)){
+			goto err;
+		}
+	}else{
+		if(! DaisyffJob_addGlyphsFromFile_inline_(builder, scratch, spec->glyphs, message)){
+			goto err;
+		}
+	}
+	result->numGlyphs = DaisyffBuilder_getNumGlyphs(builder);
+
+	/**
+	  ファイル書き出し
+	  */
+	int fd = open(spec->output, O_CREAT|O_TRUNC|O_RDWR, 0777);
+	if(-1 == fd){
+		DaisyffJob_setMessage_inline_(message, "open `%s`: %s", spec->output, strerror(errno));
+		goto err;
+	}
+	error = DaisyffBuilder_finallyToFd(builder, fd);
+	if(DaisyffError_None != error){
+		DaisyffJob_setMessage_inline_(message, "write `%s`: %s %s",
+				spec->output, DaisyffError_toString(error), strerror(errno));
+		close(fd);
+		goto err;
+	}
+	result->fileSize = (size_t)lseek(fd, 0, SEEK_CUR);
+	close(fd);
+	DaisyffBuilder_getKerningReport(builder, &result->kerning);
+	DaisyffBuilder_getVariationReport(builder, &result->variation);
+
+	DaisyffBuilder_free(builder);
+	return true;
+err:
+	DaisyffBuilder_free(builder);
+	return false;
+}
+
+#endif // #ifndef DAISYFF_DAISYFF_JOB_HPP_
+
@@ -0,0 +1,634 @@
+/**
+  @file
+  @brief `daisyff --serve`: job記述を1行ずつ受け取り、常駐workerでフォントを生成する。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  入力は標準入力(応答は標準出力)、またはUnix domain socket(接続毎に応答)。
+  jobは上限付きqueueに積み、満杯の間は読み込み側を待たせる(backpressure)。
+  workerはプロセス終了まで常駐し、作業領域(DaisyffJobScratch)をjob間で使い回す。
+
+  応答(1job 1行):
+    ok id=N output=PATH bytes=N glyphs=N queue_us=F build_us=F worker=N
+       (KERN行がある場合は続けて kern_pairs=N gpos_bytes=N gpos_naive_bytes=N)
+       (MASTER行がある場合は続けて gvar_tuples=N gvar_bytes=N gvar_unpacked_bytes=N)
+    error id=N message="..."
+  コマンド:
+    stats	集計を1行で返す
+    quit	(socketのみ)serverを終了する
+ */
+#ifndef DAISYFF_DAISYFF_SERVER_HPP_
+#define DAISYFF_DAISYFF_SERVER_HPP_
+
+#include "src/DaisyffJob.h"
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define DaisyffServer_RESPONSE_SIZE (1024)
+
+typedef struct DaisyffServerConnection DaisyffServerConnection;
+struct DaisyffServerConnection{
+	int			fd;		//!< 応答の書き出し先
+	bool			isOwnedFd;	//!< 参照が無くなった時にcloseする
+	pthread_mutex_t		mutex;		//!< 応答の書き込みとrefCountを保護
+	size_t			refCount;	//!< reader + 処理待ちjob
+	DaisyffServerConnection	*next;
+};
+
+typedef struct{
+	size_t			id;
+	char			*line;
+	DaisyffServerConnection	*connection;
+	double			enqueueUs;
+}DaisyffServerJob;
+
+//! 上限付きのFIFO(ring buffer)
+typedef struct{
+	DaisyffServerJob	*jobs;
+	size_t			capacity;
+	size_t			head;
+	size_t			num;
+	bool			isClosed;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		notEmpty;
+	pthread_cond_t		notFull;
+}DaisyffServerJobQueue;
+
+typedef struct{
+	size_t			jobNum;
+	size_t			errorNum;
+	double			queueUsSum;
+	double			queueUsMax;
+	double			buildUsSum;
+	double			buildUsMax;
+}DaisyffServerStats;
+
+typedef struct DaisyffServer DaisyffServer;
+
+typedef struct{
+	DaisyffServer		*server;
+	size_t			index;
+	pthread_t		thread;
+}DaisyffServerWorker;
+
+struct DaisyffServer{
+	DaisyffServerJobQueue	queue;
+	DaisyffServerWorker	*workers;
+	size_t			workerNum;
+	size_t			nextJobId;	//!< queue.mutexで保護
+
+	pthread_mutex_t		statsMutex;
+	DaisyffServerStats	stats;
+
+	// socket mode
+	int			listenFd;
+	volatile bool		isStopping;
+	pthread_mutex_t		connectionsMutex;
+	pthread_cond_t		connectionsCond;
+	DaisyffServerConnection	*connections;	//!< reader threadが動作中の接続
+	size_t			readerNum;
+};
+
+double DaisyffServer_nowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec * 1e6) + ((double)ts.tv_nsec / 1e3);
+}
+
+// ********
+// connection
+// ********
+
+DaisyffServerConnection *DaisyffServerConnection_new(int fd, bool isOwnedFd)
+{
+	DaisyffServerConnection *connection = (DaisyffServerConnection *)calloc(1, sizeof(DaisyffServerConnection));
+	if(NULL == connection){
+		fprintf(stderr, "critical: %s()[%d]: calloc\n", __func__, __LINE__);
+		exit(1);
+	}
+	connection->fd		= fd;
+	connection->isOwnedFd	= isOwnedFd;
+	connection->refCount	= 1;
+	pthread_mutex_init(&connection->mutex, NULL);
+	return connection;
+}
+
+void DaisyffServerConnection_ref(DaisyffServerConnection *connection)
+{
+	pthread_mutex_lock(&connection->mutex);
+	connection->refCount++;
+	pthread_mutex_unlock(&connection->mutex);
+}
+
+void DaisyffServerConnection_unref(DaisyffServerConnection *connection)
+{
+	pthread_mutex_lock(&connection->mutex);
+	const size_t refCount = --connection->refCount;
+	pthread_mutex_unlock(&connection->mutex);
+	if(0 != refCount){
+		return;
+	}
+
+	if(connection->isOwnedFd){
+		close(connection->fd);
+	}
+	pthread_mutex_destroy(&connection->mutex);
+	free(connection);
+}
+
+//! @brief 応答を1行書き出す(workerから並行に呼ばれる)。相手が切断済みなら捨てる。
+void DaisyffServerConnection_reply(DaisyffServerConnection *connection, const char *response)
+{
+	const size_t size = strlen(response);
+	pthread_mutex_lock(&connection->mutex);
+	size_t offset = 0;
+	while(offset < size){
+		ssize_t s = write(connection->fd, &response[offset], size - offset);
+		if(-1 == s && EINTR == errno){
+			continue;
+		}
+		if(s <= 0){
+			break;
+		}
+		offset += s;
+	}
+	pthread_mutex_unlock(&connection->mutex);
+}
+
+// ********
+// job queue
+// ********
+
+void DaisyffServerJobQueue_init(DaisyffServerJobQueue *queue, size_t capacity)
+{
+	*queue = (DaisyffServerJobQueue){0};
+	queue->jobs = (DaisyffServerJob *)calloc(capacity, sizeof(DaisyffServerJob));
+	if(NULL == queue->jobs){
+		fprintf(stderr, "critical: %s()[%d]: calloc\n", __func__, __LINE__);
+		exit(1);
+	}
+	queue->capacity = capacity;
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->notEmpty, NULL);
+	pthread_cond_init(&queue->notFull, NULL);
+}
+
+void DaisyffServerJobQueue_free(DaisyffServerJobQueue *queue)
+{
+	pthread_mutex_destroy(&queue->mutex);
+	pthread_cond_destroy(&queue->notEmpty);
+	pthread_cond_destroy(&queue->notFull);
+	free(queue->jobs);
+	*queue = (DaisyffServerJobQueue){0};
+}
+
+/** @brief jobを積む。満杯の間は待つ。
+  @return false: queueが閉じられた
+  */
+bool DaisyffServerJobQueue_push(DaisyffServerJobQueue *queue, DaisyffServerJob *job, size_t *nextJobId)
+{
+	pthread_mutex_lock(&queue->mutex);
+	while((! queue->isClosed) && queue->capacity == queue->num){
+		pthread_cond_wait(&queue->notFull, &queue->mutex);
+	}
+	if(queue->isClosed){
+		pthread_mutex_unlock(&queue->mutex);
+		return false;
+	}
+	job->id		= ++(*nextJobId);
+	job->enqueueUs	= DaisyffServer_nowUs();
+	queue->jobs[(queue->head + queue->num) % queue->capacity] = *job;
+	queue->num++;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->mutex);
+
+	return true;
+}
+
+/** @brief jobを取り出す。空の間は待つ。
+  @return false: queueが閉じられ、かつ空
+  */
+bool DaisyffServerJobQueue_pop(DaisyffServerJobQueue *queue, DaisyffServerJob *job)
+{
+	pthread_mutex_lock(&queue->mutex);
+	while((! queue->isClosed) && 0 == queue->num){
+		pthread_cond_wait(&queue->notEmpty, &queue->mutex);
+	}
+	if(0 == queue->num){
+		pthread_mutex_unlock(&queue->mutex);
+		return false;
+	}
+	*job = queue->jobs[queue->head];
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->num--;
+	pthread_cond_signal(&queue->notFull);
+	pthread_mutex_unlock(&queue->mutex);
+
+	return true;
+}
+
+//! @brief 以降のpushを拒否する。積まれたjobはpopできる。
+void DaisyffServerJobQueue_close(DaisyffServerJobQueue *queue)
+{
+	pthread_mutex_lock(&queue->mutex);
+	queue->isClosed = true;
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_cond_broadcast(&queue->notFull);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+size_t DaisyffServerJobQueue_getNum(DaisyffServerJobQueue *queue)
+{
+	pthread_mutex_lock(&queue->mutex);
+	const size_t num = queue->num;
+	pthread_mutex_unlock(&queue->mutex);
+	return num;
+}
+
+// ********
+// worker
+// ********
+
+void DaisyffServer_formatStats_inline_(DaisyffServer *server, char *response)
+{
+	const size_t queueNum = DaisyffServerJobQueue_getNum(&server->queue);
+	pthread_mutex_lock(&server->statsMutex);
+	const DaisyffServerStats stats = server->stats;
+	pthread_mutex_unlock(&server->statsMutex);
+
+	const double jobNum = (0 == stats.jobNum)? 1.0 : (double)stats.jobNum;
+	snprintf(response, DaisyffServer_RESPONSE_SIZE,
+			"stats jobs=%zu errors=%zu queue_depth=%zu workers=%zu"
+			" queue_us_mean=%.1f queue_us_max=%.1f build_us_mean=%.1f build_us_max=%.1f\n",
+			stats.jobNum, stats.errorNum, queueNum, server->workerNum,
+			stats.queueUsSum / jobNum, stats.queueUsMax,
+			stats.buildUsSum / jobNum, stats.buildUsMax);
+}
+
+void DaisyffServerWorker_runJob_inline_(
+		DaisyffServerWorker *worker,
+		DaisyffJobScratch *scratch,
+		const DaisyffServerJob *job)
+{
+	DaisyffServer *server = worker->server;
+	char response[DaisyffServer_RESPONSE_SIZE];
+	char message[DaisyffJob_MESSAGE_SIZE] = "";
+
+	const double startUs = DaisyffServer_nowUs();
+	const double queueUs = startUs - job->enqueueUs;
+
+	DaisyffJobSpec spec;
+	DaisyffJobResult result = {0};
+	bool isSuccess = DaisyffJobSpec_parse(&spec, job->line, message);
+	if(isSuccess){
+		isSuccess = DaisyffJob_run(&spec, scratch, &result, message);
+	}
+	const double buildUs = DaisyffServer_nowUs() - startUs;
+
+	if(isSuccess){
+		char kerning[128] = "";
+		if(0 < result.kerning.pairNum){
+			snprintf(kerning, sizeof(kerning), " kern_pairs=%zu gpos_bytes=%zu gpos_naive_bytes=%zu",
+					result.kerning.pairNum, result.kerning.tableSize, result.kerning.naiveSize);
+		}
+		char variation[128] = "";
+		if(0 < result.variation.tupleNum){
+			snprintf(variation, sizeof(variation), " gvar_tuples=%zu gvar_bytes=%zu gvar_unpacked_bytes=%zu",
+					result.variation.tupleNum, result.variation.gvarSize, result.variation.gvarUnpackedSize);
+		}
+		snprintf(response, sizeof(response),
+				"ok id=%zu output=%s bytes=%zu glyphs=%zu queue_us=%.1f build_us=%.1f worker=%zu%s%s\n",
+				job->id, spec.output, result.fileSize, result.numGlyphs, queueUs, buildUs, worker->index,
+				kerning, variation);
+		DaisyffJobSpec_free(&spec);
+	}else{
+		for(char *c = message; '\0' != *c; c++){
+			if('"' == *c || '\n' == *c){
+				*c = '\'';
+			}
+		}
+		snprintf(response, sizeof(response), "error id=%zu message=\"%s\"\n", job->id, message);
+	}
+
+	pthread_mutex_lock(&server->statsMutex);
+	DaisyffServerStats *stats = &server->stats;
+	stats->jobNum++;
+	stats->errorNum		+= (isSuccess)? 0 : 1;
+	stats->queueUsSum	+= queueUs;
+	stats->queueUsMax	= (stats->queueUsMax < queueUs)? queueUs : stats->queueUsMax;
+	stats->buildUsSum	+= buildUs;
+	stats->buildUsMax	= (stats->buildUsMax < buildUs)? buildUs : stats->buildUsMax;
+	pthread_mutex_unlock(&server->statsMutex);
+
+	DaisyffServerConnection_reply(job->connection, response);
+}
+
+void *DaisyffServerWorker_main(void *arg)
+{
+	DaisyffServerWorker *worker = (DaisyffServerWorker *)arg;
+	DaisyffJobScratch scratch = {0};
+
+	DaisyffServerJob job;
+	while(DaisyffServerJobQueue_pop(&worker->server->queue, &job)){
+		DaisyffServerWorker_runJob_inline_(worker, &scratch, &job);
+		free(job.line);
+		DaisyffServerConnection_unref(job.connection);
+	}
+
+	DaisyffJobScratch_free(&scratch);
+	return NULL;
+}
+
+// ********
+// server
+// ********
+
+void DaisyffServer_init(DaisyffServer *server, size_t workerNum, size_t queueCapacity)
+{
+	*server = (DaisyffServer){0};
+	server->listenFd = -1;
+	DaisyffServerJobQueue_init(&server->queue, queueCapacity);
+	pthread_mutex_init(&server->statsMutex, NULL);
+	pthread_mutex_init(&server->connectionsMutex, NULL);
+	pthread_cond_init(&server->connectionsCond, NULL);
+
+	server->workers = (DaisyffServerWorker *)calloc(workerNum, sizeof(DaisyffServerWorker));
+	if(NULL == server->workers){
+		fprintf(stderr, "critical: %s()[%d]: calloc\n", __func__, __LINE__);
+		exit(1);
+	}
+	for(size_t i = 0; i < workerNum; i++){
+		server->workers[i].server	= server;
+		server->workers[i].index	= i;
+		int ret = pthread_create(&server->workers[i].thread, NULL, DaisyffServerWorker_main, &server->workers[i]);
+		if(0 != ret){
+			fprintf(stderr, "critical: %s()[%d]: pthread_create %s\n", __func__, __LINE__, strerror(ret));
+			exit(1);
+		}
+		server->workerNum++;
+	}
+}
+
+//! @brief 積まれたjobを全て処理してからworkerを終了させる。
+void DaisyffServer_finally(DaisyffServer *server)
+{
+	DaisyffServerJobQueue_close(&server->queue);
+	for(size_t i = 0; i < server->workerNum; i++){
+		pthread_join(server->workers[i].thread, NULL);
+	}
+
+	char response[DaisyffServer_RESPONSE_SIZE];
+	DaisyffServer_formatStats_inline_(server, response);
+	fprintf(stderr, "%s", response);
+
+	free(server->workers);
+	DaisyffServerJobQueue_free(&server->queue);
+	pthread_mutex_destroy(&server->statsMutex);
+	pthread_mutex_destroy(&server->connectionsMutex);
+	pthread_cond_destroy(&server->connectionsCond);
+}
+
+/** @brief 入力から1行ずつjob記述・コマンドを読んでqueueに積む。
+  @return true: `quit`を受け取った
+  */
+bool DaisyffServer_readJobs(DaisyffServer *server, FILE *fp, DaisyffServerConnection *connection)
+{
+	bool isQuit = false;
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	ssize_t lineSize;
+	while(-1 != (lineSize = getline(&line, &lineCapacity, fp))){
+		while(0 < lineSize && ('\n' == line[lineSize - 1] || '\r' == line[lineSize - 1])){
+			line[--lineSize] = '\0';
+		}
+		const char *command = line + strspn(line, " \t");
+		if('\0' == command[0] || '#' == command[0]){
+			continue;
+		}
+		if(0 == strcmp("stats", command)){
+			char response[DaisyffServer_RESPONSE_SIZE];
+			DaisyffServer_formatStats_inline_(server, response);
+			DaisyffServerConnection_reply(connection, response);
+			continue;
+		}
+		if(0 == strcmp("quit", command)){
+			isQuit = true;
+			break;
+		}
+
+		DaisyffServerJob job = {
+			.line		= DaisyffJob_strdup_inline_(command),
+			.connection	= connection,
+		};
+		DaisyffServerConnection_ref(connection);
+		if(! DaisyffServerJobQueue_push(&server->queue, &job, &server->nextJobId)){
+			free(job.line);
+			DaisyffServerConnection_unref(connection);
+			DaisyffServerConnection_reply(connection, "error id=0 message=\"server is stopping\"\n");
+			break;
+		}
+	}
+	free(line);
+
+	return isQuit;
+}
+
+// ********
+// stdin mode
+// ********
+
+bool DaisyffServer_serveStdin(size_t workerNum, size_t queueCapacity)
+{
+	DaisyffServer server;
+	DaisyffServer_init(&server, workerNum, queueCapacity);
+	DaisyffServerConnection *connection = DaisyffServerConnection_new(STDOUT_FILENO, false);
+
+	DaisyffServer_readJobs(&server, stdin, connection);
+
+	DaisyffServer_finally(&server);
+	DaisyffServerConnection_unref(connection);
+	return true;
+}
+
+// ********
+// socket mode
+// ********
+
+typedef struct{
+	DaisyffServer		*server;
+	DaisyffServerConnection	*connection;
+}DaisyffServerReaderArg;
+
+void DaisyffServer_stop_inline_(DaisyffServer *server)
+{
+	server->isStopping = true;
+	// accept()を起こす
+	shutdown(server->listenFd, SHUT_RDWR);
+}
+
+void *DaisyffServer_readerMain_inline_(void *arg_)
+{
+	DaisyffServerReaderArg *arg = (DaisyffServerReaderArg *)arg_;
+	DaisyffServer *server = arg->server;
+	DaisyffServerConnection *connection = arg->connection;
+	free(arg);
+
+	FILE *fp = NULL;
+	const int fd = dup(connection->fd);
+	if(-1 != fd){
+		fp = fdopen(fd, "r");
+		if(NULL == fp){
+			close(fd);
+		}
+	}
+	if(NULL != fp){
+		if(DaisyffServer_readJobs(server, fp, connection)){
+			DaisyffServer_stop_inline_(server);
+		}
+		fclose(fp);
+	}
+
+	// 応答は処理待ちjobが全て終わってから閉じる(unref)
+	pthread_mutex_lock(&server->connectionsMutex);
+	DaisyffServerConnection **p = &server->connections;
+	while(*p != connection){
+		p = &(*p)->next;
+	}
+	*p = connection->next;
+	server->readerNum--;
+	pthread_cond_broadcast(&server->connectionsCond);
+	pthread_mutex_unlock(&server->connectionsMutex);
+	DaisyffServerConnection_unref(connection);
+
+	return NULL;
+}
+
+volatile sig_atomic_t daisyffServerSignal_ = 0;
+
+void DaisyffServer_signalHandler_inline_(int signum)
+{
+	daisyffServerSignal_ = signum;
+}
+
+bool DaisyffServer_serveSocket(const char *socketpath, size_t workerNum, size_t queueCapacity)
+{
+	struct sockaddr_un addr = {0};
+	if(sizeof(addr.sun_path) <= strlen(socketpath)){
+		fprintf(stderr, "error: socket path too long `%s`\n", socketpath);
+		return false;
+	}
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, socketpath);
+
+	const int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(-1 == listenFd){
+		fprintf(stderr, "error: socket: %s\n", strerror(errno));
+		return false;
+	}
+	unlink(socketpath);
+	if(0 != bind(listenFd, (const struct sockaddr *)&addr, sizeof(addr))
+			|| 0 != listen(listenFd, 16)){
+		fprintf(stderr, "error: bind/listen `%s`: %s\n", socketpath, strerror(errno));
+		close(listenFd);
+		return false;
+	}
+
+	// SIGINT/SIGTERMは普段blockし、接続待ちのpselect()の間だけ受け取る。
+	// (フラグの確認から待ちに入るまでに届いたsignalはpendingとなり、pselect()が直ちにEINTRで戻る)
+	// workerとreader threadはblockしたmaskを継承するので、signalはこのthreadにだけ届く。
+	// 切断済みの相手へのwriteでは落ちない。
+	sigset_t blockMask;
+	sigset_t waitMask;
+	sigemptyset(&blockMask);
+	sigaddset(&blockMask, SIGINT);
+	sigaddset(&blockMask, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &blockMask, &waitMask);
+	struct sigaction sa = {0};
+	sa.sa_handler = DaisyffServer_signalHandler_inline_;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	// 待ちはpselect()で行うので、accept()は(相手が先に切断した場合も)blockさせない
+	fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+
+	DaisyffServer server;
+	DaisyffServer_init(&server, workerNum, queueCapacity);
+	server.listenFd = listenFd;
+
+	while((! server.isStopping) && 0 == daisyffServerSignal_){
+		// quitのshutdown()でも読み込み可能として戻る
+		fd_set readFds;
+		FD_ZERO(&readFds);
+		FD_SET(listenFd, &readFds);
+		if(-1 == pselect(listenFd + 1, &readFds, NULL, NULL, NULL, &waitMask)){
+			if(EINTR == errno){
+				continue;
+			}
+			fprintf(stderr, "error: pselect: %s\n", strerror(errno));
+			break;
+		}
+		const int fd = accept(listenFd, NULL, NULL);
+		if(-1 == fd){
+			if(EINTR == errno || ECONNABORTED == errno || EAGAIN == errno){
+				continue;
+			}
+			if(! server.isStopping){
+				fprintf(stderr, "error: accept: %s\n", strerror(errno));
+			}
+			break;
+		}
+
+		DaisyffServerConnection *connection = DaisyffServerConnection_new(fd, true);
+		DaisyffServerReaderArg *arg = (DaisyffServerReaderArg *)calloc(1, sizeof(DaisyffServerReaderArg));
+		if(NULL == arg){
+			fprintf(stderr, "critical: %s()[%d]: calloc\n", __func__, __LINE__);
+			exit(1);
+		}
+		arg->server	= &server;
+		arg->connection	= connection;
+
+		pthread_mutex_lock(&server.connectionsMutex);
+		connection->next = server.connections;
+		server.connections = connection;
+		server.readerNum++;
+		pthread_mutex_unlock(&server.connectionsMutex);
+
+		pthread_t thread;
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		int ret = pthread_create(&thread, &attr, DaisyffServer_readerMain_inline_, arg);
+		pthread_attr_destroy(&attr);
+		if(0 != ret){
+			fprintf(stderr, "critical: %s()[%d]: pthread_create %s\n", __func__, __LINE__, strerror(ret));
+			exit(1);
+		}
+	}
+
+	// 残っている接続の読み込みを止め、reader threadの終了を待つ
+	pthread_mutex_lock(&server.connectionsMutex);
+	for(DaisyffServerConnection *c = server.connections; NULL != c; c = c->next){
+		shutdown(c->fd, SHUT_RD);
+	}
+	while(0 < server.readerNum){
+		pthread_cond_wait(&server.connectionsCond, &server.connectionsMutex);
+	}
+	pthread_mutex_unlock(&server.connectionsMutex);
+
+	DaisyffServer_finally(&server);
+	close(listenFd);
+	unlink(socketpath);
+	pthread_sigmask(SIG_SETMASK, &waitMask, NULL);
+
+	return true;
+}
+
+#endif // #ifndef DAISYFF_DAISYFF_SERVER_HPP_
+
@@ -0,0 +1,195 @@
+/**
+  @file
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+ */
+#ifndef DAISYFF_ENDIAN_HPP_
+#define DAISYFF_ENDIAN_HPP_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <byteswap.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DAISYFF_ENDIAN_X86_SIMD
+#endif
+
+//* ********
+//* data endian
+//* ********
+
+// http://www.math.kobe-u.ac.jp/HOME/kodama/tips-C-endian.html
+bool IS_LITTLE_ENDIAN()
+{
+        int i = 1;
+        return (bool)(*(char*)&i);
+}
+
+uint64_t htonll(uint64_t x)
+{
+	if(IS_LITTLE_ENDIAN()){
+		return bswap_64(x);
+	}else{
+		return x;
+	}
+}
+
+uint64_t ntohll(uint64_t x)
+{
+	return htonll(x);
+}
+
+// ********
+// bulk byte swap kernels
+// ********
+/** dst == srcの場合はin-placeで変換する(一部だけ重なる領域は非対応)。
+  dst,srcともにアライメントを要求しない(glyfデータ等のbyte列中を直接指してよい)。
+  */
+
+void bswapArray16Move_scalar_inline_(uint8_t *dst, const uint8_t *src, size_t num)
+{
+	for(size_t i = 0; i < num; i++){
+		uint16_t v;
+		memcpy(&v, &src[i * 2], sizeof(v));
+		v = bswap_16(v);
+		memcpy(&dst[i * 2], &v, sizeof(v));
+	}
+}
+
+void bswapArray32Move_scalar_inline_(uint8_t *dst, const uint8_t *src, size_t num)
+{
+	for(size_t i = 0; i < num; i++){
+		uint32_t v;
+		memcpy(&v, &src[i * 4], sizeof(v));
+		v = bswap_32(v);
+		memcpy(&dst[i * 4], &v, sizeof(v));
+	}
+}
+
+#ifdef DAISYFF_ENDIAN_X86_SIMD
+__attribute__((target("ssse3")))
+size_t bswapArrayMove_ssse3_inline_(uint8_t *dst, const uint8_t *src, size_t bytes, const __m128i shuffle)
+{
+	size_t i = 0;
+	for(; i + 16 <= bytes; i += 16){
+		__m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+		_mm_storeu_si128((__m128i *)&dst[i], _mm_shuffle_epi8(v, shuffle));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+size_t bswapArrayMove_avx2_inline_(uint8_t *dst, const uint8_t *src, size_t bytes, const __m128i shuffle128)
+{
+	const __m256i shuffle = _mm256_broadcastsi128_si256(shuffle128);
+	size_t i = 0;
+	for(; i + 32 <= bytes; i += 32){
+		__m256i v = _mm256_loadu_si256((const __m256i *)&src[i]);
+		_mm256_storeu_si256((__m256i *)&dst[i], _mm256_shuffle_epi8(v, shuffle));
+	}
+	return i;
+}
+
+//! @return SIMDで処理済みのbyte数(残りはscalarで処理する)
+size_t bswapArrayMove_simd_inline_(uint8_t *dst, const uint8_t *src, size_t bytes, size_t elementSize)
+{
+	const __m128i shuffle = (2 == elementSize)
+		? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+		: _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+	size_t done = 0;
+	if(__builtin_cpu_supports("avx2")){
+		done = bswapArrayMove_avx2_inline_(dst, src, bytes, shuffle);
+	}
+	if(__builtin_cpu_supports("ssse3")){
+		done += bswapArrayMove_ssse3_inline_(&dst[done], &src[done], bytes - done, shuffle);
+	}
+	return done;
+}
+#endif // DAISYFF_ENDIAN_X86_SIMD
+
+void bswapArray16Move(void *dst_, const void *src_, size_t array16Num)
+{
+	uint8_t *dst = (uint8_t *)dst_;
+	const uint8_t *src = (const uint8_t *)src_;
+
+	size_t done = 0;
+#ifdef DAISYFF_ENDIAN_X86_SIMD
+	done = bswapArrayMove_simd_inline_(dst, src, array16Num * 2, 2) / 2;
+#endif
+	bswapArray16Move_scalar_inline_(&dst[done * 2], &src[done * 2], array16Num - done);
+}
+
+void bswapArray32Move(void *dst_, const void *src_, size_t array32Num)
+{
+	uint8_t *dst = (uint8_t *)dst_;
+	const uint8_t *src = (const uint8_t *)src_;
+
+	size_t done = 0;
+#ifdef DAISYFF_ENDIAN_X86_SIMD
+	done = bswapArrayMove_simd_inline_(dst, src, array32Num * 4, 4) / 4;
+#endif
+	bswapArray32Move_scalar_inline_(&dst[done * 4], &src[done * 4], array32Num - done);
+}
+
+// ********
+// host <-> big endian array
+// ********
+
+//! @brief host配列をbig endian byte列へコピーする。
+void htonArray16Move(uint8_t *buf8, const uint16_t *array16, size_t array16Num)
+{
+	if(IS_LITTLE_ENDIAN()){
+		bswapArray16Move(buf8, array16, array16Num);
+	}else if((const void *)buf8 != (const void *)array16){
+		memmove(buf8, array16, sizeof(uint16_t) * array16Num);
+	}
+}
+
+void htonArray32Move(uint8_t *buf8, const uint32_t *array32, size_t array32Num)
+{
+	if(IS_LITTLE_ENDIAN()){
+		bswapArray32Move(buf8, array32, array32Num);
+	}else if((const void *)buf8 != (const void *)array32){
+		memmove(buf8, array32, sizeof(uint32_t) * array32Num);
+	}
+}
+
+//! @brief big endian byte列をhost配列へコピーする。
+void ntohArray16Move(uint16_t *array16, const uint8_t *buf8, size_t array16Num)
+{
+	// uint16_tの場合は逆変換するだけ
+	htonArray16Move((uint8_t *)array16, (const uint16_t *)(const void *)buf8, array16Num);
+}
+
+void ntohArray32Move(uint32_t *array32, const uint8_t *buf8, size_t array32Num)
+{
+	htonArray32Move((uint8_t *)array32, (const uint32_t *)(const void *)buf8, array32Num);
+}
+
+//! @brief in-place変換
+void htonArray16(uint16_t *array16, size_t array16Num)
+{
+	htonArray16Move((uint8_t *)array16, array16, array16Num);
+}
+
+void htonArray32(uint32_t *array32, size_t array32Num)
+{
+	htonArray32Move((uint8_t *)array32, array32, array32Num);
+}
+
+void ntohArray16(uint16_t *array16, size_t array16Num)
+{
+	htonArray16(array16, array16Num);
+}
+
+void ntohArray32(uint32_t *array32, size_t array32Num)
+{
+	htonArray32(array32, array32Num);
+}
+
+#endif // #ifndef DAISYFF_ENDIAN_HPP_
+
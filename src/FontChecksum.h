@@ -0,0 +1,153 @@
+/**
+  @file
+  @brief Table毎のchecksumと'head'.checkSumAdjustmentを計算し直して、TableDirectory, 'head'の値と比べる。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  checksumはbig endianのuint32の合計(末尾の4byteに満たない部分は0で埋める)。
+  'head'のchecksumとファイル全体の合計は、checkSumAdjustment(4byte)を0として計算する。
+  大きなファイルはTable毎・ファイル全体を区切った範囲毎にWorkStealingPoolで並列に計算する。
+ */
+#ifndef DAISYFF_FONT_CHECKSUM_HPP_
+#define DAISYFF_FONT_CHECKSUM_HPP_
+
+#include "src/FontParser.h"
+#include "src/WorkStealingPool.h"
+
+#define FontChecksum_PARALLEL_MIN_SIZE	(4 * 1024 * 1024)	//!< これより小さいファイルはthreadを起こさない
+#define FontChecksum_CHUNK_SIZE		(1024 * 1024)		//!< ファイル全体の合計を分ける単位(4の倍数)
+#define FontChecksum_MAGIC		(0xB1B0AFBA)
+#define FontChecksum_ADJUSTMENT_OFFSET	(8)			//!< 'head'のTable内でのcheckSumAdjustmentの位置
+
+typedef struct{
+	uint32_t		tag;
+	uint32_t		stored;		//!< TableDirectoryの値
+	uint32_t		actual;		//!< 計算した値
+	bool			isOutOfRange;	//!< Tableがファイルの範囲外(actualは0)
+}FontChecksumTable;
+
+typedef struct{
+	FontChecksumTable	*tables;	//!< [tableNum] TableDirectoryの順
+	size_t			tableNum;
+	size_t			mismatchNum;	//!< 一致しないTableの数(範囲外を含む)
+	bool			isHeadFound;	//!< false: adjustmentは比べない
+	uint32_t		storedAdjustment;
+	uint32_t		actualAdjustment;
+}FontChecksumReport;
+
+void FontChecksumReport_free(FontChecksumReport *report)
+{
+	free(report->tables);
+	*report = (FontChecksumReport){0};
+}
+
+//! @return adjustmentまで含め全て一致した
+bool FontChecksumReport_isOk(const FontChecksumReport *report)
+{
+	return (0 == report->mismatchNum) && ((! report->isHeadFound) || report->storedAdjustment == report->actualAdjustment);
+}
+
+/** @brief data[size]をbig endianのuint32の列として合計する。
+  @param base dataのファイル(Table)先頭からの位置(4の倍数でない場合もbyteの桁を合わせる)
+  */
+uint32_t FontChecksum_sum(const uint8_t *data, size_t size, size_t base)
+{
+	uint32_t sum = 0;
+	size_t i = 0;
+	// 4byte境界まで
+	for(; i < size && 0 != ((base + i) % 4); i++){
+		sum += (uint32_t)data[i] << (8 * (3 - ((base + i) % 4)));
+	}
+	for(; i + 4 <= size; i += 4){
+		uint32_t word;
+		memcpy(&word, &data[i], sizeof(word));
+		sum += ntohl(word);
+	}
+	for(; i < size; i++){
+		sum += (uint32_t)data[i] << (8 * (3 - ((base + i) % 4)));
+	}
+	return sum;
+}
+
+typedef struct{
+	const FontParser	*parser;
+	FontChecksumTable	*tables;
+	uint32_t		*chunkSums;	//!< [chunkNum]
+	size_t			chunkNum;
+}FontChecksumContext;
+
+void FontChecksum_task_inline_(void *context_, size_t index, size_t workerIndex)
+{
+	FontChecksumContext *context = (FontChecksumContext *)context_;
+	const FontParser *parser = context->parser;
+	const size_t tableNum = parser->offsetTable.numTables;
+	if(index < tableNum){
+		const TableDirectory_Member *member = &parser->tableDirectory[index];
+		FontChecksumTable *table = &context->tables[index];
+		FontSpan span;
+		if(FontParseError_None != FontSpan_sub(parser->file, member->offset, member->length, &span)){
+			table->isOutOfRange = true;
+			return;
+		}
+		table->actual = FontChecksum_sum(span.data, span.size, 0);
+		if(0x68656164 == member->tag && FontChecksum_ADJUSTMENT_OFFSET + 4 <= span.size){ // 'head'
+			table->actual -= FontChecksum_sum(&span.data[FontChecksum_ADJUSTMENT_OFFSET], 4, FontChecksum_ADJUSTMENT_OFFSET);
+		}
+		return;
+	}
+	const size_t chunk = index - tableNum;
+	const size_t begin = chunk * FontChecksum_CHUNK_SIZE;
+	const size_t end = (parser->file.size < begin + FontChecksum_CHUNK_SIZE)? parser->file.size : begin + FontChecksum_CHUNK_SIZE;
+	context->chunkSums[chunk] = FontChecksum_sum(&parser->file.data[begin], end - begin, begin);
+}
+
+/** @brief 全Tableのchecksumとファイル全体のcheckSumAdjustmentを計算し直して比べる。
+  @param threadNum 0: CPU数(ファイルがFontChecksum_PARALLEL_MIN_SIZEより小さい場合は1)
+  使い終えたらFontChecksumReport_free()する。
+  */
+void FontChecksum_verify(const FontParser *parser, size_t threadNum, FontChecksumReport *report)
+{
+	*report = (FontChecksumReport){0};
+	const size_t tableNum = parser->offsetTable.numTables;
+	report->tableNum = tableNum;
+	report->tables = (FontChecksumTable *)ffmalloc(sizeof(FontChecksumTable) * ((0 == tableNum)? 1 : tableNum));
+	for(size_t i = 0; i < tableNum; i++){
+		report->tables[i].tag = parser->tableDirectory[i].tag;
+		report->tables[i].stored = parser->tableDirectory[i].checkSum;
+	}
+
+	const size_t chunkNum = (parser->file.size + FontChecksum_CHUNK_SIZE - 1) / FontChecksum_CHUNK_SIZE;
+	FontChecksumContext context = {
+		.parser		= parser,
+		.tables		= report->tables,
+		.chunkSums	= (uint32_t *)ffmalloc(sizeof(uint32_t) * ((0 == chunkNum)? 1 : chunkNum)),
+		.chunkNum	= chunkNum,
+	};
+	if(parser->file.size < FontChecksum_PARALLEL_MIN_SIZE){
+		threadNum = 1;
+	}
+	WorkStealingPool_run(tableNum + chunkNum, threadNum, FontChecksum_task_inline_, &context);
+
+	for(size_t i = 0; i < tableNum; i++){
+		if(report->tables[i].isOutOfRange || report->tables[i].stored != report->tables[i].actual){
+			report->mismatchNum++;
+		}
+	}
+
+	// ** checkSumAdjustment
+	uint32_t fileSum = 0;
+	for(size_t c = 0; c < chunkNum; c++){
+		fileSum += context.chunkSums[c];
+	}
+	free(context.chunkSums);
+	FontSpan head;
+	if(FontParseError_None == FontParser_table(parser, "head", &head) && FontChecksum_ADJUSTMENT_OFFSET + 4 <= head.size){
+		const size_t offset = (size_t)(head.data - parser->file.data) + FontChecksum_ADJUSTMENT_OFFSET;
+		report->isHeadFound = true;
+		FontSpanReader reader = FontSpanReader_init(head, FontChecksum_ADJUSTMENT_OFFSET);
+		report->storedAdjustment = FontSpanReader_uint32(&reader);
+		report->actualAdjustment = FontChecksum_MAGIC - (fileSum - FontChecksum_sum(&parser->file.data[offset], 4, offset));
+	}
+}
+
+#endif // #ifndef DAISYFF_FONT_CHECKSUM_HPP_
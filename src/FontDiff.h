@@ -0,0 +1,506 @@
+/**
+  @file
+  @brief 2つのフォントファイルを構造で比べ、違いを出力する(daisydump --diff)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  1. TableDirectoryを比べ、checksum・長さ・内容が一致するTableは読み飛ばす(内容はmapping上のmemcmpで比べる)。
+  2. 変化したTableのうち'head', 'maxp'はfield毎の値、'cmap'は文字毎の割り当て、
+     'glyf'('loca')はglyphId毎に比べる。
+  glyphはbyte列が同じなら解析せず、違うglyphだけをoutline(composite glyphは展開した絶対座標)にして点毎の差分を出す。
+  部品が変わったcomposite glyphは、部品のglyphの変化として出力する(自身のbyte列は変わらないため)。
+ */
+#ifndef DAISYFF_FONT_DIFF_HPP_
+#define DAISYFF_FONT_DIFF_HPP_
+
+#include "src/FontParser.h"
+#include "src/FontChecksum.h"
+#include "src/CmapPageTable.h"
+#include <inttypes.h>
+#include <stdarg.h>
+
+#define FontDiff_POINT_LINE_MAX		(8)	//!< glyph毎に出力する点の行数(超えた分は数だけ出力する)
+
+typedef struct{
+	FILE			*out;			//!< NULL: 出力せず数えるだけ
+	size_t			tableSameNum;		//!< 一致して読み飛ばしたTable
+	size_t			tableChangedNum;
+	size_t			tableAddedNum;
+	size_t			tableRemovedNum;
+	size_t			fieldNum;		//!< 値が変わった'head', 'maxp'のfield
+	size_t			mappingNum;		//!< 追加・削除・変更された'cmap'の割り当て
+	size_t			glyphNum;		//!< 変化・追加・削除されたglyph
+}FontDiff;
+
+//! @return Tableの追加・削除・変化が無い
+bool FontDiff_isSame(const FontDiff *diff)
+{
+	return 0 == (diff->tableChangedNum + diff->tableAddedNum + diff->tableRemovedNum);
+}
+
+void FontDiff_print(FontDiff *diff, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+void FontDiff_print(FontDiff *diff, const char *fmt, ...)
+{
+	if(NULL == diff->out){
+		return;
+	}
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(diff->out, fmt, ap);
+	va_end(ap);
+	fputc('\n', diff->out);
+}
+
+void FontDiff_tagString_inline_(uint32_t tag, char *str)
+{
+	for(int i = 0; i < 4; i++){
+		const char c = (char)(tag >> (8 * (3 - i)));
+		str[i] = (0x20 <= c && c < 0x7F)? c : '?';
+	}
+	str[4] = '\0';
+}
+
+// ** TableDirectory
+
+//! 意味を比べるTable
+enum{
+	FontDiffTable_HEAD	= (1 << 0),
+	FontDiffTable_MAXP	= (1 << 1),
+	FontDiffTable_CMAP	= (1 << 2),
+	FontDiffTable_GLYF	= (1 << 3),	//!< 'glyf'または'loca'
+};
+typedef int FontDiffTable;
+
+FontDiffTable FontDiffTable_fromTag_inline_(uint32_t tag)
+{
+	switch(tag){
+	case 0x68656164: return FontDiffTable_HEAD; // 'head'
+	case 0x6D617870: return FontDiffTable_MAXP; // 'maxp'
+	case 0x636D6170: return FontDiffTable_CMAP; // 'cmap'
+	case 0x676C7966: return FontDiffTable_GLYF; // 'glyf'
+	case 0x6C6F6361: return FontDiffTable_GLYF; // 'loca'
+	default: return 0;
+	}
+}
+
+/** @brief 長さが一致したTableの内容を比べる(checksumは単純な和なので、一致しても内容が同じとは限らない)。
+  'head'のcheckSumAdjustmentはファイル全体から決まるので比べない(他のTableの変化として出る)。
+  */
+bool FontDiff_isSameTable_inline_(uint32_t tag, FontSpan a, FontSpan b)
+{
+	const size_t ADJUSTMENT_END = FontChecksum_ADJUSTMENT_OFFSET + 4;
+	if(0x68656164 == tag && ADJUSTMENT_END <= a.size){ // 'head'
+		return 0 == memcmp(a.data, b.data, FontChecksum_ADJUSTMENT_OFFSET)
+			&& 0 == memcmp(&a.data[ADJUSTMENT_END], &b.data[ADJUSTMENT_END], a.size - ADJUSTMENT_END);
+	}
+	return 0 == memcmp(a.data, b.data, a.size);
+}
+
+const TableDirectory_Member *FontDiff_member_inline_(const FontParser *parser, uint32_t tag)
+{
+	for(size_t i = 0; i < parser->offsetTable.numTables; i++){
+		if(tag == parser->tableDirectory[i].tag){
+			return &parser->tableDirectory[i];
+		}
+	}
+	return NULL;
+}
+
+int FontDiff_compareTag_inline_(const void *a, const void *b)
+{
+	const uint32_t ta = *(const uint32_t *)a;
+	const uint32_t tb = *(const uint32_t *)b;
+	return (ta < tb)? -1 : ((tb < ta)? 1 : 0);
+}
+
+//! @return 両方にあり内容の変わった、意味を比べるTable
+FontDiffTable FontDiff_tables_inline_(FontDiff *diff, const FontParser *a, const FontParser *b)
+{
+	// 両方のTagを合わせ、Tag順に比べる
+	const size_t numA = a->offsetTable.numTables;
+	const size_t numB = b->offsetTable.numTables;
+	uint32_t *tags = (uint32_t *)ffmalloc(sizeof(uint32_t) * (numA + numB + 1));
+	size_t tagNum = 0;
+	for(size_t i = 0; i < numA; i++){
+		tags[tagNum++] = a->tableDirectory[i].tag;
+	}
+	for(size_t i = 0; i < numB; i++){
+		bool isFound = false;
+		for(size_t j = 0; j < numA && ! isFound; j++){
+			isFound = (a->tableDirectory[j].tag == b->tableDirectory[i].tag);
+		}
+		if(! isFound){
+			tags[tagNum++] = b->tableDirectory[i].tag;
+		}
+	}
+	qsort(tags, tagNum, sizeof(uint32_t), FontDiff_compareTag_inline_);
+
+	FontDiffTable changed = 0;
+	for(size_t i = 0; i < tagNum; i++){
+		char tag[5];
+		FontDiff_tagString_inline_(tags[i], tag);
+		const TableDirectory_Member *memberA = FontDiff_member_inline_(a, tags[i]);
+		const TableDirectory_Member *memberB = FontDiff_member_inline_(b, tags[i]);
+		if(NULL == memberA){
+			diff->tableAddedNum++;
+			FontDiff_print(diff, "table '%s': added length %"PRIu32, tag, memberB->length);
+			continue;
+		}
+		if(NULL == memberB){
+			diff->tableRemovedNum++;
+			FontDiff_print(diff, "table '%s': removed length %"PRIu32, tag, memberA->length);
+			continue;
+		}
+		FontSpan spanA;
+		FontSpan spanB;
+		const FontParseError errorA = FontSpan_sub(a->file, memberA->offset, memberA->length, &spanA);
+		const FontParseError errorB = FontSpan_sub(b->file, memberB->offset, memberB->length, &spanB);
+		if(FontParseError_None != errorA || FontParseError_None != errorB){
+			diff->tableChangedNum++;
+			FontDiff_print(diff, "table '%s': %s -> %s", tag, FontParseError_toString(errorA), FontParseError_toString(errorB));
+			continue;
+		}
+		const bool isSameData = (memberA->length == memberB->length) && FontDiff_isSameTable_inline_(tags[i], spanA, spanB);
+		if(isSameData && memberA->checkSum == memberB->checkSum){
+			diff->tableSameNum++;
+			continue;
+		}
+		diff->tableChangedNum++;
+		if(isSameData){
+			// 内容は同じでTableDirectoryの値だけが違う(checksumを誤って計算したbuild等)
+			FontDiff_print(diff, "table '%s': checkSum 0x%08"PRIX32" -> 0x%08"PRIX32", data same",
+					tag, memberA->checkSum, memberB->checkSum);
+			continue;
+		}
+		changed |= FontDiffTable_fromTag_inline_(tags[i]);
+		FontDiff_print(diff, "table '%s': changed length %"PRIu32" -> %"PRIu32" checkSum 0x%08"PRIX32" -> 0x%08"PRIX32,
+				tag, memberA->length, memberB->length, memberA->checkSum, memberB->checkSum);
+	}
+	free(tags);
+	return changed;
+}
+
+// ** 'head', 'maxp'
+
+enum{
+	FontDiffFieldKind_UINT = 0,
+	FontDiffFieldKind_INT,
+	FontDiffFieldKind_HEX,
+};
+typedef int FontDiffFieldKind;
+
+typedef struct{
+	const char		*name;
+	size_t			offset;		//!< Table先頭から
+	size_t			size;		//!< 2, 4, 8 byte
+	FontDiffFieldKind	kind;
+}FontDiffField;
+
+//! checkSumAdjustmentは比べない(FontDiff_isSameTable_inline_())
+const FontDiffField fontDiffHeadFields[] = {
+	{"majorVersion",	0,	2,	FontDiffFieldKind_UINT},
+	{"minorVersion",	2,	2,	FontDiffFieldKind_UINT},
+	{"fontRevision",	4,	4,	FontDiffFieldKind_HEX},
+	{"magicNumber",		12,	4,	FontDiffFieldKind_HEX},
+	{"flags",		16,	2,	FontDiffFieldKind_HEX},
+	{"unitsPerEm",		18,	2,	FontDiffFieldKind_UINT},
+	{"created",		20,	8,	FontDiffFieldKind_UINT},
+	{"modified",		28,	8,	FontDiffFieldKind_UINT},
+	{"xMin",		36,	2,	FontDiffFieldKind_INT},
+	{"yMin",		38,	2,	FontDiffFieldKind_INT},
+	{"xMax",		40,	2,	FontDiffFieldKind_INT},
+	{"yMax",		42,	2,	FontDiffFieldKind_INT},
+	{"macStyle",		44,	2,	FontDiffFieldKind_HEX},
+	{"lowestRecPPEM",	46,	2,	FontDiffFieldKind_UINT},
+	{"fontDirectionHint",	48,	2,	FontDiffFieldKind_INT},
+	{"indexToLocFormat",	50,	2,	FontDiffFieldKind_INT},
+	{"glyphDataFormat",	52,	2,	FontDiffFieldKind_INT},
+};
+
+//! version 0.5はnumGlyphsまで
+const FontDiffField fontDiffMaxpFields[] = {
+	{"version",		0,	4,	FontDiffFieldKind_HEX},
+	{"numGlyphs",		4,	2,	FontDiffFieldKind_UINT},
+	{"maxPoints",		6,	2,	FontDiffFieldKind_UINT},
+	{"maxContours",		8,	2,	FontDiffFieldKind_UINT},
+	{"maxCompositePoints",	10,	2,	FontDiffFieldKind_UINT},
+	{"maxCompositeContours",12,	2,	FontDiffFieldKind_UINT},
+	{"maxZones",		14,	2,	FontDiffFieldKind_UINT},
+	{"maxTwilightPoints",	16,	2,	FontDiffFieldKind_UINT},
+	{"maxStorage",		18,	2,	FontDiffFieldKind_UINT},
+	{"maxFunctionDefs",	20,	2,	FontDiffFieldKind_UINT},
+	{"maxInstructionDefs",	22,	2,	FontDiffFieldKind_UINT},
+	{"maxStackElements",	24,	2,	FontDiffFieldKind_UINT},
+	{"maxSizeOfInstructions",26,	2,	FontDiffFieldKind_UINT},
+	{"maxComponentElements",28,	2,	FontDiffFieldKind_UINT},
+	{"maxComponentDepth",	30,	2,	FontDiffFieldKind_UINT},
+};
+
+//! @brief fieldの値を文字列にする。Tableが短く値が無い場合は"(none)"
+void FontDiffField_toString_inline_(const FontDiffField *field, FontSpan table, char *str, size_t size)
+{
+	if(table.size < field->offset + field->size){
+		snprintf(str, size, "(none)");
+		return;
+	}
+	FontSpanReader reader = FontSpanReader_init(table, field->offset);
+	const uint64_t value = (8 == field->size)? FontSpanReader_uint64(&reader)
+		: ((4 == field->size)? FontSpanReader_uint32(&reader) : FontSpanReader_uint16(&reader));
+	switch(field->kind){
+	case FontDiffFieldKind_INT:
+		snprintf(str, size, "%d", (int)(int16_t)value);
+		break;
+	case FontDiffFieldKind_HEX:
+		snprintf(str, size, "0x%0*"PRIX64, (int)(field->size * 2), value);
+		break;
+	default:
+		snprintf(str, size, "%"PRIu64, value);
+		break;
+	}
+}
+
+void FontDiff_fields_inline_(FontDiff *diff, const char *tag, const FontDiffField *fields, size_t fieldNum, const FontParser *a, const FontParser *b)
+{
+	FontSpan tableA;
+	FontSpan tableB;
+	FontParser_table(a, tag, &tableA);
+	FontParser_table(b, tag, &tableB);
+	for(size_t i = 0; i < fieldNum; i++){
+		char valueA[32];
+		char valueB[32];
+		FontDiffField_toString_inline_(&fields[i], tableA, valueA, sizeof(valueA));
+		FontDiffField_toString_inline_(&fields[i], tableB, valueB, sizeof(valueB));
+		if(0 != strcmp(valueA, valueB)){
+			diff->fieldNum++;
+			FontDiff_print(diff, "%s.%s: %s -> %s", tag, fields[i].name, valueA, valueB);
+		}
+	}
+}
+
+// ** 'cmap'
+
+/** @brief 比べるsubtable(format 12、無ければ4、無ければその他の最初のもの)の表を作る。
+  'cmap'が無い・読めない場合は空の表(読めた所までを比べる)。
+  */
+void FontDiff_cmapPageTable_inline_(const FontParser *parser, CmapPageTable *table)
+{
+	FontParseCmap cmap;
+	if(FontParseError_None != FontParser_cmap(parser, &cmap)){
+		FontParseCmap_free(&cmap);
+		CmapPageTable_init(table, UINT16_MAX);
+		return;
+	}
+	size_t selected = SIZE_MAX;
+	int selectedRank = 0;
+	for(size_t i = 0; i < cmap.header.numTables; i++){
+		uint16_t format;
+		if(FontParseError_None != FontParseCmap_subtableFormat(&cmap, i, &format)){
+			continue;
+		}
+		const int rank = (12 == format)? 3 : ((4 == format)? 2 : ((0 == format || 6 == format || 13 == format)? 1 : 0));
+		if(selectedRank < rank){
+			selected = i;
+			selectedRank = rank;
+		}
+	}
+	if(SIZE_MAX == selected){
+		CmapPageTable_init(table, UINT16_MAX);
+	}else{
+		const size_t offset = cmap.encodingRecords[selected].offset;
+		FontSpan subtable;
+		FontSpan_sub(cmap.table, offset, cmap.table.size - offset, &subtable);
+		CmapPageTable_build(table, subtable, UINT16_MAX);
+	}
+	FontParseCmap_free(&cmap);
+}
+
+void FontDiff_cmap_inline_(FontDiff *diff, const FontParser *a, const FontParser *b)
+{
+	CmapPageTable tableA;
+	CmapPageTable tableB;
+	FontDiff_cmapPageTable_inline_(a, &tableA);
+	FontDiff_cmapPageTable_inline_(b, &tableB);
+	// 両方とも空のpageは読み飛ばす
+	for(uint32_t page = 0; page < CmapPageTable_CODEPOINT_NUM / CmapPageTable_PAGE_SIZE; page++){
+		if(0 == tableA.pageIndexes[page] && 0 == tableB.pageIndexes[page]){
+			continue;
+		}
+		const uint16_t *glyphIdsA = &tableA.pages[(size_t)tableA.pageIndexes[page] * CmapPageTable_PAGE_SIZE];
+		const uint16_t *glyphIdsB = &tableB.pages[(size_t)tableB.pageIndexes[page] * CmapPageTable_PAGE_SIZE];
+		for(uint32_t i = 0; i < CmapPageTable_PAGE_SIZE; i++){
+			if(glyphIdsA[i] == glyphIdsB[i]){
+				continue;
+			}
+			const uint32_t codepoint = (page * CmapPageTable_PAGE_SIZE) + i;
+			diff->mappingNum++;
+			if(0 == glyphIdsA[i]){
+				FontDiff_print(diff, "cmap U+%04"PRIX32": added glyph %u", codepoint, glyphIdsB[i]);
+			}else if(0 == glyphIdsB[i]){
+				FontDiff_print(diff, "cmap U+%04"PRIX32": removed glyph %u", codepoint, glyphIdsA[i]);
+			}else{
+				FontDiff_print(diff, "cmap U+%04"PRIX32": glyph %u -> %u", codepoint, glyphIdsA[i], glyphIdsB[i]);
+			}
+		}
+	}
+	CmapPageTable_free(&tableA);
+	CmapPageTable_free(&tableB);
+}
+
+// ** 'glyf'
+
+typedef struct{
+	FontParseLocaView	loca;
+	FontSpan		glyf;
+	size_t			numGlyphs;
+	FontParseGlyphResolver	resolver;
+}FontDiffGlyphs;
+
+void FontDiffGlyphs_free_inline_(FontDiffGlyphs *glyphs)
+{
+	FontParseGlyphResolver_free(&glyphs->resolver);
+	*glyphs = (FontDiffGlyphs){0};
+}
+
+FontParseError FontDiffGlyphs_init_inline_(FontDiffGlyphs *glyphs, const FontParser *parser)
+{
+	*glyphs = (FontDiffGlyphs){0};
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	FontParseError error = FontParser_head(parser, &head);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxp);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_table(parser, "glyf", &glyphs->glyf);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_locaView(parser, head.indexToLocFormat, maxp.numGlyphs, &glyphs->loca);
+	}
+	if(FontParseError_None == error){
+		error = FontParseGlyphResolver_init(&glyphs->resolver, parser, head.indexToLocFormat, maxp.numGlyphs);
+	}
+	glyphs->numGlyphs = (FontParseError_None == error)? maxp.numGlyphs : 0;
+	return error;
+}
+
+//! @return false: 'loca'の範囲が不正
+bool FontDiffGlyphs_data_inline_(const FontDiffGlyphs *glyphs, size_t glyphId, FontSpan *data)
+{
+	uint32_t offset;
+	uint32_t nextOffset;
+	if(FontParseError_None != FontParseLocaView_entry(&glyphs->loca, glyphId, glyphs->glyf.size, &offset, &nextOffset)){
+		return false;
+	}
+	return FontParseError_None == FontSpan_sub(glyphs->glyf, offset, nextOffset - offset, data);
+}
+
+bool FontParseOutlinePoint_isEqual_inline_(const FontParseOutlinePoint *a, const FontParseOutlinePoint *b)
+{
+	return a->x == b->x && a->y == b->y && a->isOnCurve == b->isOnCurve;
+}
+
+//! @brief byte列の違うglyphをoutlineにして比べる
+void FontDiff_glyph_inline_(FontDiff *diff, size_t glyphId, FontDiffGlyphs *glyphsA, FontDiffGlyphs *glyphsB)
+{
+	diff->glyphNum++;
+	const FontParseOutline *outlineA;
+	const FontParseOutline *outlineB;
+	const FontParseError errorA = FontParseGlyphResolver_outline(&glyphsA->resolver, glyphId, &outlineA);
+	const FontParseError errorB = FontParseGlyphResolver_outline(&glyphsB->resolver, glyphId, &outlineB);
+	if(FontParseError_None != errorA || FontParseError_None != errorB){
+		FontDiff_print(diff, "glyph %zu: %s -> %s", glyphId, FontParseError_toString(errorA), FontParseError_toString(errorB));
+		return;
+	}
+	if(outlineA->pointNum != outlineB->pointNum || outlineA->contourNum != outlineB->contourNum
+			|| 0 != memcmp(outlineA->endPts, outlineB->endPts, sizeof(uint32_t) * outlineA->contourNum)){
+		FontDiff_print(diff, "glyph %zu: points %zu -> %zu contours %zu -> %zu",
+				glyphId, outlineA->pointNum, outlineB->pointNum, outlineA->contourNum, outlineB->contourNum);
+		return;
+	}
+	size_t movedNum = 0;
+	for(size_t i = 0; i < outlineA->pointNum; i++){
+		movedNum += FontParseOutlinePoint_isEqual_inline_(&outlineA->points[i], &outlineB->points[i])? 0 : 1;
+	}
+	if(0 == movedNum){
+		// 命令・bounding box・符号化だけが違う
+		FontDiff_print(diff, "glyph %zu: data changed, outline same", glyphId);
+		return;
+	}
+	FontDiff_print(diff, "glyph %zu: moved %zu / %zu points", glyphId, movedNum, outlineA->pointNum);
+	size_t lineNum = 0;
+	for(size_t i = 0; i < outlineA->pointNum && lineNum < FontDiff_POINT_LINE_MAX; i++){
+		const FontParseOutlinePoint *pointA = &outlineA->points[i];
+		const FontParseOutlinePoint *pointB = &outlineB->points[i];
+		if(FontParseOutlinePoint_isEqual_inline_(pointA, pointB)){
+			continue;
+		}
+		lineNum++;
+		FontDiff_print(diff, "glyph %zu point %zu: (%"PRId32", %"PRId32")%s -> (%"PRId32", %"PRId32")%s delta (%+"PRId32", %+"PRId32")",
+				glyphId, i,
+				pointA->x, pointA->y, pointA->isOnCurve ? "" : " off",
+				pointB->x, pointB->y, pointB->isOnCurve ? "" : " off",
+				pointB->x - pointA->x, pointB->y - pointA->y);
+	}
+	if(lineNum < movedNum){
+		FontDiff_print(diff, "glyph %zu: ... %zu more points", glyphId, movedNum - lineNum);
+	}
+}
+
+void FontDiff_glyphs_inline_(FontDiff *diff, const FontParser *a, const FontParser *b)
+{
+	FontDiffGlyphs glyphsA;
+	FontDiffGlyphs glyphsB;
+	const FontParseError errorA = FontDiffGlyphs_init_inline_(&glyphsA, a);
+	const FontParseError errorB = FontDiffGlyphs_init_inline_(&glyphsB, b);
+	if(FontParseError_None != errorA || FontParseError_None != errorB){
+		FontDiff_print(diff, "glyf: not compared: %s -> %s", FontParseError_toString(errorA), FontParseError_toString(errorB));
+		FontDiffGlyphs_free_inline_(&glyphsA);
+		FontDiffGlyphs_free_inline_(&glyphsB);
+		return;
+	}
+	const size_t num = (glyphsA.numGlyphs < glyphsB.numGlyphs)? glyphsB.numGlyphs : glyphsA.numGlyphs;
+	for(size_t glyphId = 0; glyphId < num; glyphId++){
+		if(glyphsA.numGlyphs <= glyphId){
+			diff->glyphNum++;
+			FontDiff_print(diff, "glyph %zu: added", glyphId);
+			continue;
+		}
+		if(glyphsB.numGlyphs <= glyphId){
+			diff->glyphNum++;
+			FontDiff_print(diff, "glyph %zu: removed", glyphId);
+			continue;
+		}
+		FontSpan dataA;
+		FontSpan dataB;
+		if(FontDiffGlyphs_data_inline_(&glyphsA, glyphId, &dataA) && FontDiffGlyphs_data_inline_(&glyphsB, glyphId, &dataB)
+				&& dataA.size == dataB.size && 0 == memcmp(dataA.data, dataB.data, dataA.size)){
+			continue;
+		}
+		FontDiff_glyph_inline_(diff, glyphId, &glyphsA, &glyphsB);
+	}
+	FontDiffGlyphs_free_inline_(&glyphsA);
+	FontDiffGlyphs_free_inline_(&glyphsB);
+}
+
+/** @brief フォントa, bを比べ、違いをdiff->outへ1行ずつ出力し、数を数える。
+  @param diff outを設定しておく(数は0から数える)
+  */
+void FontDiff_compare(FontDiff *diff, const FontParser *a, const FontParser *b)
+{
+	const FontDiffTable changed = FontDiff_tables_inline_(diff, a, b);
+	if(0 != (changed & FontDiffTable_HEAD)){
+		FontDiff_fields_inline_(diff, "head", fontDiffHeadFields, sizeof(fontDiffHeadFields) / sizeof(fontDiffHeadFields[0]), a, b);
+	}
+	if(0 != (changed & FontDiffTable_MAXP)){
+		FontDiff_fields_inline_(diff, "maxp", fontDiffMaxpFields, sizeof(fontDiffMaxpFields) / sizeof(fontDiffMaxpFields[0]), a, b);
+	}
+	if(0 != (changed & FontDiffTable_CMAP)){
+		FontDiff_cmap_inline_(diff, a, b);
+	}
+	if(0 != (changed & FontDiffTable_GLYF)){
+		FontDiff_glyphs_inline_(diff, a, b);
+	}
+}
+
+#endif // #ifndef DAISYFF_FONT_DIFF_HPP_
@@ -0,0 +1,127 @@
+/**
+  @file
+  @brief フォントファイルを1度だけメモリへ載せ、範囲を確かめたポインタで参照する。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  通常のファイルはmmap(読み取り専用)する。
+  mmapできない入力(pipe, 空ファイル等)は1度に読み切ったbufferを使う。
+  open後は変更しない(threadの扱いはFontSpanを参照)。
+ */
+#ifndef DAISYFF_FONT_FILE_HPP_
+#define DAISYFF_FONT_FILE_HPP_
+
+#include "src/Util.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+typedef struct{
+	const uint8_t		*data;
+	size_t			size;
+	void			*mapped;	//!< munmap()する領域(NULL: mmapしていない)
+	uint8_t			*buffer;	//!< free()する領域(NULL: bufferを使っていない)
+}FontFile;
+
+void FontFile_close(FontFile *file)
+{
+	if(NULL != file->mapped){
+		munmap(file->mapped, file->size);
+	}
+	free(file->buffer);
+	*file = (FontFile){0};
+}
+
+/** @brief メモリ上のデータをFontFileとして扱う。bufferの所有権はfileへ移る(FontFile_close()で解放する)。
+  */
+void FontFile_openBuffer(FontFile *file, uint8_t *buffer, size_t size)
+{
+	*file = (FontFile){.data = buffer, .size = size, .buffer = buffer};
+}
+
+//! @brief 終端まで読む(大きさの分からない入力用)
+bool FontFile_readAll_inline_(FontFile *file, int fd)
+{
+	size_t capacity = 64 * 1024;
+	uint8_t *buffer = (uint8_t *)ffmalloc(capacity);
+	size_t size = 0;
+	while(true){
+		if(capacity == size){
+			capacity *= 2;
+			buffer = (uint8_t *)ffrealloc(buffer, capacity);
+		}
+		const ssize_t ssize = read(fd, &buffer[size], capacity - size);
+		if(0 == ssize){
+			break;
+		}
+		if(ssize < 0){
+			if(EINTR == errno){
+				continue;
+			}
+			free(buffer);
+			return false;
+		}
+		size += ssize;
+	}
+	FontFile_openBuffer(file, buffer, size);
+	return true;
+}
+
+/** @brief ファイルを開いてメモリへ載せる(fdは閉じる)。
+  @return false: 開けない・読めない(errnoを設定する)
+  */
+bool FontFile_open(FontFile *file, const char *filepath)
+{
+	*file = (FontFile){0};
+	const int fd = open(filepath, O_RDONLY);
+	if(-1 == fd){
+		return false;
+	}
+	struct stat st;
+	bool isSuccess = false;
+	if(0 == fstat(fd, &st) && S_ISREG(st.st_mode) && 0 < st.st_size){
+		void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(MAP_FAILED != mapped){
+			*file = (FontFile){.data = (const uint8_t *)mapped, .size = st.st_size, .mapped = mapped};
+			isSuccess = true;
+		}
+	}
+	if(! isSuccess){
+		isSuccess = FontFile_readAll_inline_(file, fd);
+	}
+	const int errnoSave = errno;
+	close(fd);
+	errno = errnoSave;
+	return isSuccess;
+}
+
+/** @brief [offset, offset + size)を指すポインタを返す。
+  @return NULL: ファイルの範囲外
+  */
+const uint8_t *FontFile_view(const FontFile *file, size_t offset, size_t size)
+{
+	if(file->size < offset || file->size - offset < size){
+		return NULL;
+	}
+	return &file->data[offset];
+}
+
+/** @brief [offset, offset + size)をbufへ写す(構造体へ読む場合に使う。境界の揃っていない位置でもよい)。
+  @return false: ファイルの範囲外(errno = ERANGE)
+  */
+bool FontFile_copyRange(const FontFile *file, void *buf, size_t offset, size_t size)
+{
+	const uint8_t *view = FontFile_view(file, offset, size);
+	if(NULL == view){
+		errno = ERANGE;
+		return false;
+	}
+	memcpy(buf, view, size);
+	return true;
+}
+
+#endif // #ifndef DAISYFF_FONT_FILE_HPP_
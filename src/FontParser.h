@@ -0,0 +1,1189 @@
+/**
+  @file
+  @brief フォントファイルの解析(OffsetTable, TableDirectory, 'head', 'maxp', 'hhea', 'hmtx', 'cmap', 'loca', 'glyf'(composite glyphを含む))。表示はしない。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  byte列はFontSpan(範囲付きのポインタ)で受け取り、読み出しは全て範囲を確かめる。
+  不正・範囲外はFontParseErrorで返す(exit・ログ出力はしない)。
+  解析結果はhost byte order。
+ */
+#ifndef DAISYFF_FONT_PARSER_HPP_
+#define DAISYFF_FONT_PARSER_HPP_
+
+#include "src/OpenType.h"
+#include "src/GlyfDecoder.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+enum FontParseError{
+	FontParseError_None = 0,
+	FontParseError_OutOfRange,	//!< 範囲外の参照(途中で切れたファイル等)
+	FontParseError_NotFound,	//!< Tableが無い
+	FontParseError_InvalidValue,	//!< 値が仕様に合わない
+	FontParseError_Unsupported,	//!< 未実装の形式
+	FontParseError_Recursion,	//!< composite glyphの部品の参照が循環している、または深すぎる
+};
+typedef int FontParseError;
+
+const char *FontParseError_toString(FontParseError error)
+{
+	switch(error){
+	case FontParseError_None:		return "none";
+	case FontParseError_OutOfRange:		return "out of range";
+	case FontParseError_NotFound:		return "not found";
+	case FontParseError_InvalidValue:	return "invalid value";
+	case FontParseError_Unsupported:	return "unsupported";
+	case FontParseError_Recursion:		return "component recursion";
+	default:				return "<unknown>";
+	}
+}
+
+// ** FontSpan
+
+/** 読み取り専用のbyte列の範囲。
+  threadの扱い: FontSpan(とその元のFontFile)は作成後に書き換えない。
+  FontSpanから作る型(FontParser, CmapPageTable, TextMeasure等)も初期化後は変更せず大域変数も持たないので、
+  初期化後は1つを複数threadから同時に読んでよい(初期化・解放はそれぞれ1threadで行う)。
+  例外は引いた結果を覚えるFontParseGlyphResolverで、threadごとに持つ。
+  */
+typedef struct{
+	const uint8_t		*data;
+	size_t			size;
+}FontSpan;
+
+//! @brief span内の[offset, offset + size)。範囲外の場合は{NULL, 0}
+FontParseError FontSpan_sub(FontSpan span, size_t offset, size_t size, FontSpan *sub)
+{
+	if(span.size < offset || span.size - offset < size){
+		*sub = (FontSpan){NULL, 0};
+		return FontParseError_OutOfRange;
+	}
+	*sub = (FontSpan){&span.data[offset], size};
+	return FontParseError_None;
+}
+
+//! Spanの範囲を超えずにbig endianを読む(範囲外はisOverrunを立てて0を返す)
+typedef struct{
+	const uint8_t		*data;
+	size_t			size;
+	size_t			offset;
+	bool			isOverrun;
+}FontSpanReader;
+
+FontSpanReader FontSpanReader_init(FontSpan span, size_t offset)
+{
+	return (FontSpanReader){span.data, span.size, offset, false};
+}
+
+uint8_t FontSpanReader_uint8(FontSpanReader *reader)
+{
+	if(reader->size < reader->offset + 1){
+		reader->isOverrun = true;
+		return 0;
+	}
+	return reader->data[reader->offset++];
+}
+
+uint16_t FontSpanReader_uint16(FontSpanReader *reader)
+{
+	uint16_t v = FontSpanReader_uint8(reader);
+	return (uint16_t)((v << 8) | FontSpanReader_uint8(reader));
+}
+
+uint32_t FontSpanReader_uint32(FontSpanReader *reader)
+{
+	uint32_t v = FontSpanReader_uint16(reader);
+	return (v << 16) | FontSpanReader_uint16(reader);
+}
+
+uint64_t FontSpanReader_uint64(FontSpanReader *reader)
+{
+	uint64_t v = FontSpanReader_uint32(reader);
+	return (v << 32) | FontSpanReader_uint32(reader);
+}
+
+// ** OffsetTable, TableDirectory
+
+typedef struct{
+	FontSpan		file;
+	OffsetTable		offsetTable;
+	TableDirectory_Member	*tableDirectory;	//!< [offsetTable.numTables]
+}FontParser;
+
+void FontParser_free(FontParser *parser)
+{
+	free(parser->tableDirectory);
+	*parser = (FontParser){0};
+}
+
+/** @brief OffsetTableとTableDirectoryを読む。data[size]は解析結果を使い終えるまで呼び出し側で保持する。
+  */
+FontParseError FontParser_init(FontParser *parser, const uint8_t *data, size_t size)
+{
+	*parser = (FontParser){.file = {data, size}};
+	FontSpanReader reader = FontSpanReader_init(parser->file, 0);
+	parser->offsetTable.sfntVersion		= FontSpanReader_uint32(&reader);
+	parser->offsetTable.numTables		= FontSpanReader_uint16(&reader);
+	parser->offsetTable.searchRange		= FontSpanReader_uint16(&reader);
+	parser->offsetTable.entrySelector	= FontSpanReader_uint16(&reader);
+	parser->offsetTable.rangeShift		= FontSpanReader_uint16(&reader);
+	const size_t numTables = parser->offsetTable.numTables;
+	if(reader.isOverrun || size - reader.offset < sizeof(TableDirectory_Member) * numTables){
+		return FontParseError_OutOfRange;
+	}
+
+	parser->tableDirectory = (TableDirectory_Member *)ffmalloc(sizeof(TableDirectory_Member) * (numTables + 1));
+	for(size_t i = 0; i < numTables; i++){
+		parser->tableDirectory[i].tag		= FontSpanReader_uint32(&reader);
+		parser->tableDirectory[i].checkSum	= FontSpanReader_uint32(&reader);
+		parser->tableDirectory[i].offset	= FontSpanReader_uint32(&reader);
+		parser->tableDirectory[i].length	= FontSpanReader_uint32(&reader);
+	}
+	return FontParseError_None;
+}
+
+//! @return NULL: Tableが無い
+const TableDirectory_Member *FontParser_queryTag(const FontParser *parser, const char *tag)
+{
+	const uint32_t tagValue = ((uint32_t)(uint8_t)tag[0] << 24) | ((uint32_t)(uint8_t)tag[1] << 16)
+		| ((uint32_t)(uint8_t)tag[2] << 8) | (uint32_t)(uint8_t)tag[3];
+	for(size_t i = 0; i < parser->offsetTable.numTables; i++){
+		if(parser->tableDirectory[i].tag == tagValue){
+			return &parser->tableDirectory[i];
+		}
+	}
+	return NULL;
+}
+
+FontParseError FontParser_table(const FontParser *parser, const char *tag, FontSpan *table)
+{
+	const TableDirectory_Member *member = FontParser_queryTag(parser, tag);
+	if(NULL == member){
+		*table = (FontSpan){NULL, 0};
+		return FontParseError_NotFound;
+	}
+	return FontSpan_sub(parser->file, member->offset, member->length, table);
+}
+
+// ** 'head', 'maxp' Table
+
+FontParseError FontParser_head(const FontParser *parser, HeadTable *head)
+{
+	*head = (HeadTable){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "head", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(table, 0);
+	head->majorVersion		= FontSpanReader_uint16(&reader);
+	head->minorVersion		= FontSpanReader_uint16(&reader);
+	head->fontRevision		= FontSpanReader_uint32(&reader);
+	head->checkSumAdjustment	= FontSpanReader_uint32(&reader);
+	head->magicNumber		= FontSpanReader_uint32(&reader);
+	head->flags			= FontSpanReader_uint16(&reader);
+	head->unitsPerEm		= FontSpanReader_uint16(&reader);
+	head->created			= FontSpanReader_uint64(&reader);
+	head->modified			= FontSpanReader_uint64(&reader);
+	head->xMin			= (int16_t)FontSpanReader_uint16(&reader);
+	head->yMin			= (int16_t)FontSpanReader_uint16(&reader);
+	head->xMax			= (int16_t)FontSpanReader_uint16(&reader);
+	head->yMax			= (int16_t)FontSpanReader_uint16(&reader);
+	head->macStyle			= FontSpanReader_uint16(&reader);
+	head->lowestRecPPEM		= FontSpanReader_uint16(&reader);
+	head->fontDirectionHint		= (int16_t)FontSpanReader_uint16(&reader);
+	head->indexToLocFormat		= (int16_t)FontSpanReader_uint16(&reader);
+	head->glyphDataFormat		= (int16_t)FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+//! @brief version 0.5の範囲(version, numGlyphs)を読む(version 1.0の残りは読まない)
+FontParseError FontParser_maxp(const FontParser *parser, MaxpTable_Version05 *maxp)
+{
+	*maxp = (MaxpTable_Version05){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "maxp", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(table, 0);
+	maxp->version		= FontSpanReader_uint32(&reader);
+	maxp->numGlyphs		= FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+// ** 'hhea', 'hmtx' Table
+
+FontParseError FontParser_hhea(const FontParser *parser, HheaTable *hhea)
+{
+	*hhea = (HheaTable){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "hhea", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(table, 0);
+	hhea->majorVersion		= FontSpanReader_uint16(&reader);
+	hhea->minorVersion		= FontSpanReader_uint16(&reader);
+	hhea->ascender			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->descender			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->lineGap			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->advanceWidthMax		= FontSpanReader_uint16(&reader);
+	hhea->minLeftSideBearing	= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->minRightSideBearing	= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->xMaxExtent		= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->caretSlopeRise		= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->caretSlopeRun		= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->caretOffset		= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->reserved0			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->reserved1			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->reserved2			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->reserved3			= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->metricDataFormat		= (int16_t)FontSpanReader_uint16(&reader);
+	hhea->numberOfHMetrics		= FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+//! @brief 'hmtx'を展開せずにmapping上から直接引く
+typedef struct{
+	FontSpan		table;
+	size_t			numberOfHMetrics;
+	size_t			numGlyphs;
+}FontParseHmtx;
+
+//! @param numberOfHMetrics HheaTable.numberOfHMetrics
+FontParseError FontParser_hmtx(const FontParser *parser, size_t numberOfHMetrics, size_t numGlyphs, FontParseHmtx *hmtx)
+{
+	*hmtx = (FontParseHmtx){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "hmtx", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	if(0 == numberOfHMetrics || numGlyphs < numberOfHMetrics){
+		return FontParseError_InvalidValue;
+	}
+	// longHorMetric[numberOfHMetrics], leftSideBearing[numGlyphs - numberOfHMetrics]
+	if(table.size < (4 * numberOfHMetrics) + (2 * (numGlyphs - numberOfHMetrics))){
+		return FontParseError_OutOfRange;
+	}
+	*hmtx = (FontParseHmtx){table, numberOfHMetrics, numGlyphs};
+	return FontParseError_None;
+}
+
+/** @brief 送り幅とlsbを返す(numberOfHMetrics以降のglyphは最後の送り幅を使う)。
+  @return FontParseError_OutOfRange: glyphIdが範囲外
+  */
+FontParseError FontParseHmtx_metric(const FontParseHmtx *hmtx, size_t glyphId, uint16_t *advanceWidth, int16_t *lsb)
+{
+	if(hmtx->numGlyphs <= glyphId){
+		*advanceWidth = 0;
+		*lsb = 0;
+		return FontParseError_OutOfRange;
+	}
+	const size_t n = hmtx->numberOfHMetrics;
+	FontSpanReader reader = FontSpanReader_init(hmtx->table, 4 * ((glyphId < n)? glyphId : n - 1));
+	*advanceWidth = FontSpanReader_uint16(&reader);
+	if(n <= glyphId){
+		reader.offset = (4 * n) + (2 * (glyphId - n));
+	}
+	*lsb = (int16_t)FontSpanReader_uint16(&reader);
+	return FontParseError_None;
+}
+
+// ** 'cmap' Table
+
+typedef struct{
+	FontSpan				table;
+	CmapTableHeader				header;
+	CmapTable_EncodingRecordElementHeader	*encodingRecords;	//!< [header.numTables]
+}FontParseCmap;
+
+void FontParseCmap_free(FontParseCmap *cmap)
+{
+	free(cmap->encodingRecords);
+	*cmap = (FontParseCmap){0};
+}
+
+FontParseError FontParser_cmap(const FontParser *parser, FontParseCmap *cmap)
+{
+	*cmap = (FontParseCmap){0};
+	FontParseError error = FontParser_table(parser, "cmap", &cmap->table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(cmap->table, 0);
+	cmap->header.version	= FontSpanReader_uint16(&reader);
+	cmap->header.numTables	= FontSpanReader_uint16(&reader);
+	const size_t numTables = cmap->header.numTables;
+	if(reader.isOverrun || cmap->table.size - reader.offset < sizeof(CmapTable_EncodingRecordElementHeader) * numTables){
+		return FontParseError_OutOfRange;
+	}
+	cmap->encodingRecords = (CmapTable_EncodingRecordElementHeader *)ffmalloc(
+			sizeof(CmapTable_EncodingRecordElementHeader) * (numTables + 1));
+	for(size_t i = 0; i < numTables; i++){
+		cmap->encodingRecords[i].platformID	= FontSpanReader_uint16(&reader);
+		cmap->encodingRecords[i].encodingID	= FontSpanReader_uint16(&reader);
+		cmap->encodingRecords[i].offset		= FontSpanReader_uint32(&reader);
+	}
+	return FontParseError_None;
+}
+
+FontParseError FontParseCmap_subtableFormat(const FontParseCmap *cmap, size_t index, uint16_t *format)
+{
+	FontSpanReader reader = FontSpanReader_init(cmap->table, cmap->encodingRecords[index].offset);
+	*format = FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+/** @brief 文字の割り当てに使うsubtable(Unicode full repertoire(3,10 / 0,4 / 0,6)のformat 12、無ければUnicode BMP(3,1 / 0,3)のformat 4)。
+  subtableはcmap->tableの終端までを指す(CmapPageTable_build()へ渡す)。
+  @return FontParseError_NotFound: 該当するsubtableが無い
+  */
+FontParseError FontParseCmap_unicodeSubtable(const FontParseCmap *cmap, FontSpan *subtable)
+{
+	*subtable = (FontSpan){NULL, 0};
+	size_t selected = SIZE_MAX;
+	for(size_t i = 0; i < cmap->header.numTables; i++){
+		const uint16_t platformID = cmap->encodingRecords[i].platformID;
+		const uint16_t encodingID = cmap->encodingRecords[i].encodingID;
+		uint16_t format;
+		if(FontParseError_None != FontParseCmap_subtableFormat(cmap, i, &format)){
+			continue;
+		}
+		const bool isFull = (12 == format) && ((3 == platformID && 10 == encodingID) || (0 == platformID && (4 == encodingID || 6 == encodingID)));
+		const bool isBmp = (4 == format) && ((3 == platformID && 1 == encodingID) || (0 == platformID && 3 == encodingID));
+		if(isFull){
+			selected = i;
+			break;
+		}
+		if(isBmp && SIZE_MAX == selected){
+			selected = i;
+		}
+	}
+	if(SIZE_MAX == selected){
+		return FontParseError_NotFound;
+	}
+	const size_t offset = cmap->encodingRecords[selected].offset;
+	return FontSpan_sub(cmap->table, offset, cmap->table.size - offset, subtable);
+}
+
+typedef struct{
+	uint16_t		format;
+	uint16_t		length;
+	uint16_t		language;
+}FontParseCmapSubtableHeader;
+
+//! @brief 16bit長のsubtable(format 0, 2, 4, 6)の先頭を読む
+FontParseError FontParseCmap_subtableHeader(const FontParseCmap *cmap, size_t index, FontParseCmapSubtableHeader *header)
+{
+	FontSpanReader reader = FontSpanReader_init(cmap->table, cmap->encodingRecords[index].offset);
+	header->format		= FontSpanReader_uint16(&reader);
+	header->length		= FontSpanReader_uint16(&reader);
+	header->language	= FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+typedef struct{
+	FontParseCmapSubtableHeader	header;
+	uint8_t				glyphIdArray[256];
+	size_t				glyphIdNum;	//!< header.length - 6(256未満は途中までのTable)
+}FontParseCmapFormat0;
+
+FontParseError FontParseCmap_format0(const FontParseCmap *cmap, size_t index, FontParseCmapFormat0 *format0)
+{
+	const size_t HEADER_SIZE = 6;
+	*format0 = (FontParseCmapFormat0){0};
+	FontParseError error = FontParseCmap_subtableHeader(cmap, index, &format0->header);
+	if(FontParseError_None != error){
+		return error;
+	}
+	if(! (HEADER_SIZE <= format0->header.length && format0->header.length <= HEADER_SIZE + 256)){
+		return FontParseError_InvalidValue;
+	}
+	FontSpan glyphIdArray;
+	error = FontSpan_sub(cmap->table, cmap->encodingRecords[index].offset + HEADER_SIZE, format0->header.length - HEADER_SIZE, &glyphIdArray);
+	if(FontParseError_None != error){
+		return error;
+	}
+	memcpy(format0->glyphIdArray, glyphIdArray.data, glyphIdArray.size);
+	format0->glyphIdNum = glyphIdArray.size;
+	return FontParseError_None;
+}
+
+//! endCode, startCode, idDelta, idRangeOffsetはffmallocした[segCountX2 / 2]の配列(glyphIdArrayは読まない)
+typedef CmapTable_CmapSubtable_Format4Buf FontParseCmapFormat4;
+
+void FontParseCmapFormat4_free(FontParseCmapFormat4 *format4)
+{
+	free(format4->endCode);
+	free(format4->startCode);
+	free(format4->idDelta);
+	free(format4->idRangeOffset);
+	*format4 = (FontParseCmapFormat4){0};
+}
+
+FontParseError FontParseCmap_format4(const FontParseCmap *cmap, size_t index, FontParseCmapFormat4 *format4)
+{
+	const size_t FIXED_LENGTH_HEAD_SIZE = sizeof(Uint16Type) * 7;
+	*format4 = (FontParseCmapFormat4){0};
+	FontSpanReader reader = FontSpanReader_init(cmap->table, cmap->encodingRecords[index].offset);
+	format4->format		= FontSpanReader_uint16(&reader);
+	format4->length		= FontSpanReader_uint16(&reader);
+	format4->language	= FontSpanReader_uint16(&reader);
+	format4->segCountX2	= FontSpanReader_uint16(&reader);
+	format4->searchRange	= FontSpanReader_uint16(&reader);
+	format4->entrySelector	= FontSpanReader_uint16(&reader);
+	format4->rangeShift	= FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	if(format4->length < FIXED_LENGTH_HEAD_SIZE){
+		return FontParseError_InvalidValue;
+	}
+	// 以降はsubtableの範囲(length)内を読む
+	FontSpan subtable;
+	const FontParseError error = FontSpan_sub(cmap->table, cmap->encodingRecords[index].offset, format4->length, &subtable);
+	if(FontParseError_None != error){
+		return error;
+	}
+	reader = FontSpanReader_init(subtable, FIXED_LENGTH_HEAD_SIZE);
+
+	const size_t segCount = format4->segCountX2 / 2;
+	format4->endCode	= (Uint16Type *)ffmalloc(sizeof(Uint16Type) * (segCount + 1));
+	format4->startCode	= (Uint16Type *)ffmalloc(sizeof(Uint16Type) * (segCount + 1));
+	format4->idDelta	= (Int16Type *)ffmalloc(sizeof(Int16Type) * (segCount + 1));
+	format4->idRangeOffset	= (Uint16Type *)ffmalloc(sizeof(Uint16Type) * (segCount + 1));
+	for(size_t seg = 0; seg < segCount; seg++){
+		format4->endCode[seg] = FontSpanReader_uint16(&reader);
+	}
+	format4->reservedPad = FontSpanReader_uint16(&reader);
+	for(size_t seg = 0; seg < segCount; seg++){
+		format4->startCode[seg] = FontSpanReader_uint16(&reader);
+	}
+	for(size_t seg = 0; seg < segCount; seg++){
+		format4->idDelta[seg] = (int16_t)FontSpanReader_uint16(&reader);
+	}
+	for(size_t seg = 0; seg < segCount; seg++){
+		format4->idRangeOffset[seg] = FontSpanReader_uint16(&reader);
+	}
+	return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+}
+
+// ** 'loca' Table
+
+typedef struct{
+	uint32_t		*offsets;	//!< [num] 'glyf'先頭からのbyte offset
+	uint32_t		*rawOffsets;	//!< [num] Table上の値(short形式はoffset / 2)
+	size_t			num;		//!< numGlyphs + 1
+}FontParseLoca;
+
+void FontParseLoca_free(FontParseLoca *loca)
+{
+	free(loca->offsets);
+	free(loca->rawOffsets);
+	*loca = (FontParseLoca){0};
+}
+
+//! @param indexToLocFormat HeadTable.indexToLocFormat(0: short, 以外: long)
+FontParseError FontParser_loca(const FontParser *parser, int16_t indexToLocFormat, size_t numGlyphs, FontParseLoca *loca)
+{
+	*loca = (FontParseLoca){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "loca", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	const bool isShort = (0 == indexToLocFormat);
+	const size_t num = numGlyphs + 1;
+	if(table.size / (isShort ? sizeof(uint16_t) : sizeof(uint32_t)) < num){
+		return FontParseError_OutOfRange;
+	}
+	loca->offsets = (uint32_t *)ffmalloc(sizeof(uint32_t) * num);
+	loca->rawOffsets = (uint32_t *)ffmalloc(sizeof(uint32_t) * num);
+	loca->num = num;
+	FontSpanReader reader = FontSpanReader_init(table, 0);
+	for(size_t i = 0; i < num; i++){
+		if(isShort){
+			loca->rawOffsets[i] = FontSpanReader_uint16(&reader);
+			loca->offsets[i] = loca->rawOffsets[i] * 2;
+		}else{
+			loca->rawOffsets[i] = FontSpanReader_uint32(&reader);
+			loca->offsets[i] = loca->rawOffsets[i];
+		}
+	}
+	return FontParseError_None;
+}
+
+/** @brief 'loca'を展開せずにmapping上から直接引く。
+  numGlyphsによらずメモリを確保しないので、65535 glyphのフォントも1 glyphずつ読める。
+  */
+typedef struct{
+	FontSpan		table;
+	bool			isShort;
+	size_t			num;		//!< numGlyphs + 1
+}FontParseLocaView;
+
+//! @param indexToLocFormat HeadTable.indexToLocFormat(0: short, 以外: long)
+FontParseError FontParser_locaView(const FontParser *parser, int16_t indexToLocFormat, size_t numGlyphs, FontParseLocaView *view)
+{
+	*view = (FontParseLocaView){0};
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, "loca", &table);
+	if(FontParseError_None != error){
+		return error;
+	}
+	const bool isShort = (0 == indexToLocFormat);
+	if(table.size / (isShort ? sizeof(uint16_t) : sizeof(uint32_t)) < numGlyphs + 1){
+		return FontParseError_OutOfRange;
+	}
+	*view = (FontParseLocaView){table, isShort, numGlyphs + 1};
+	return FontParseError_None;
+}
+
+//! @return Table上の値(short形式はoffset / 2) index < view->numであること
+uint32_t FontParseLocaView_raw(const FontParseLocaView *view, size_t index)
+{
+	const uint8_t *p = &view->table.data[index * (view->isShort ? 2 : 4)];
+	return view->isShort ? (uint32_t)((p[0] << 8) | p[1])
+		: (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+}
+
+//! @return 'glyf'先頭からのbyte offset
+uint32_t FontParseLocaView_offset(const FontParseLocaView *view, size_t index)
+{
+	const uint32_t raw = FontParseLocaView_raw(view, index);
+	return view->isShort ? raw * 2 : raw;
+}
+
+/** @brief glyphIdの'glyf'内の範囲を引き、昇順(offset <= nextOffset <= glyfSize)であることを確かめる。
+  @return FontParseError_InvalidValue: 昇順でない・'glyf'の外(offset, nextOffsetは読んだ値)
+  */
+FontParseError FontParseLocaView_entry(const FontParseLocaView *view, size_t glyphId, size_t glyfSize,
+		uint32_t *offset, uint32_t *nextOffset)
+{
+	if(view->num <= glyphId + 1){
+		*offset = 0;
+		*nextOffset = 0;
+		return FontParseError_OutOfRange;
+	}
+	*offset = FontParseLocaView_offset(view, glyphId);
+	*nextOffset = FontParseLocaView_offset(view, glyphId + 1);
+	return (*offset <= *nextOffset && *nextOffset <= glyfSize)? FontParseError_None : FontParseError_InvalidValue;
+}
+
+/** @brief 1 glyphの'glyf'内の範囲[offset, nextOffset)だけを読む(loca全体を展開しない)。
+  @param indexToLocFormat HeadTable.indexToLocFormat(0: short, 以外: long)
+  */
+FontParseError FontParser_locaEntry(const FontParser *parser, int16_t indexToLocFormat, size_t numGlyphs, size_t glyphId,
+		uint32_t *offset, uint32_t *nextOffset)
+{
+	*offset = 0;
+	*nextOffset = 0;
+	FontParseLocaView view;
+	const FontParseError error = FontParser_locaView(parser, indexToLocFormat, numGlyphs, &view);
+	if(FontParseError_None != error){
+		return error;
+	}
+	if(numGlyphs <= glyphId){
+		return FontParseError_OutOfRange;
+	}
+	*offset = FontParseLocaView_offset(&view, glyphId);
+	*nextOffset = FontParseLocaView_offset(&view, glyphId + 1);
+	return FontParseError_None;
+}
+
+// ** 'glyf' Table
+
+bool GlyphFlag_IsXShortVector(uint8_t flag)
+{
+	return (0 != (flag & (0x1 << 1)));
+}
+
+bool GlyphFlag_IsSameOrPisitiveXShortVector(uint8_t flag)
+{
+	return (0 != (flag & (0x1 << 4)));
+}
+
+bool GlyphFlag_IsYShortVector(uint8_t flag)
+{
+	return (0 != (flag & (0x1 << 2)));
+}
+
+bool GlyphFlag_IsSameOrPisitiveYShortVector(uint8_t flag)
+{
+	return (0 != (flag & (0x1 << 5)));
+}
+
+typedef struct{
+	int		isFlagRepeated;
+	uint8_t		flag;
+	int		isRelXSame;
+	int		isRelYSame;
+	struct{
+		uint16_t	x;
+		uint16_t	y;
+	}raw;			//!< Table上の値(同値の場合は0)
+	struct{
+		int		x;
+		int		y;
+	}rel;
+	struct{
+		int		x;
+		int		y;
+	}abs;
+}FontParseGlyphPoint;
+
+/** @brief simple glyphの解析結果。
+  配列は次のglyphの解析で再利用する(glyph毎に確保しない)。使い終えたらFontParseGlyph_free()する。
+  */
+typedef struct{
+	GlyphDescriptionHeader	header;			//!< 空glyphは0
+	size_t			dataSize;
+	uint16_t		*endPtsOfContours;	//!< [header.numberOfContours]
+	FontSpan		instructions;
+	FontParseGlyphPoint	*points;		//!< [pointNum]
+	size_t			pointNum;
+	size_t			endPtsCapacity;
+	size_t			pointCapacity;
+	uint8_t			*flags;			//!< [pointCapacity] 展開したflag(GlyfDecoderへ渡す)
+	int32_t			*coordinates;		//!< [pointCapacity * 2] GlyfDecoderの出力(x, y)
+}FontParseGlyph;
+
+void FontParseGlyph_free(FontParseGlyph *glyph)
+{
+	free(glyph->endPtsOfContours);
+	free(glyph->points);
+	free(glyph->flags);
+	free(glyph->coordinates);
+	*glyph = (FontParseGlyph){0};
+}
+
+//! @brief decodeした絶対座標からpointsのx(isY: y)を埋める(値の扱いはttfdumpの表示に合わせる)
+void FontParser_glyphCoordinates_inline_(FontParseGlyphPoint *points, const uint8_t *flags, const int32_t *values, size_t pointNum, bool isY)
+{
+	for(size_t i = 0; i < pointNum; i++){
+		const uint8_t flag = flags[i];
+		const bool isShort = isY ? GlyphFlag_IsYShortVector(flag) : GlyphFlag_IsXShortVector(flag);
+		const bool isSameOrPositive = isY ? GlyphFlag_IsSameOrPisitiveYShortVector(flag) : GlyphFlag_IsSameOrPisitiveXShortVector(flag);
+		const int rel = values[i] - ((0 == i)? 0 : values[i - 1]);
+		//! @note 先頭の場合もゼロ(FontForgeの生成したフォントファイルによるとありうるらしい。)
+		const bool isSame = (! isShort) && isSameOrPositive;
+		const uint16_t raw = isSame ? 0 : (isShort ? (uint16_t)abs(rel) : (uint16_t)rel);
+		if(isY){
+			points[i].isRelYSame = isSame;
+			points[i].raw.y = raw;
+			points[i].rel.y = rel;
+			points[i].abs.y = values[i];
+		}else{
+			points[i].isRelXSame = isSame;
+			points[i].raw.x = raw;
+			points[i].rel.x = rel;
+			points[i].abs.x = values[i];
+		}
+	}
+}
+
+/** @brief 'glyf'の[offset, nextOffset)をsimple glyphとして解析する。
+  @return FontParseError_Unsupported: composite glyph(headerのみ読む)
+  */
+FontParseError FontParser_glyph(FontSpan glyf, uint32_t offset, uint32_t nextOffset, FontParseGlyph *glyph)
+{
+	glyph->header = (GlyphDescriptionHeader){0};
+	glyph->dataSize = 0;
+	glyph->instructions = (FontSpan){NULL, 0};
+	glyph->pointNum = 0;
+	if(nextOffset < offset){
+		return FontParseError_InvalidValue;
+	}
+	FontSpan data;
+	FontParseError error = FontSpan_sub(glyf, offset, nextOffset - offset, &data);
+	if(FontParseError_None != error){
+		return error;
+	}
+	glyph->dataSize = data.size;
+	if(0 == data.size){
+		return FontParseError_None;
+	}
+
+	// *** GlyphDescription.Header
+	FontSpanReader reader = FontSpanReader_init(data, 0);
+	glyph->header.numberOfContours	= (int16_t)FontSpanReader_uint16(&reader);
+	glyph->header.xMin		= (int16_t)FontSpanReader_uint16(&reader);
+	glyph->header.yMin		= (int16_t)FontSpanReader_uint16(&reader);
+	glyph->header.xMax		= (int16_t)FontSpanReader_uint16(&reader);
+	glyph->header.yMax		= (int16_t)FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	if(glyph->header.numberOfContours < 0){
+		return FontParseError_Unsupported; //!< @todo CompositeGlyphDescription
+	}
+
+	// *** GlyphDescription.EndPoints
+	const size_t contourNum = (size_t)glyph->header.numberOfContours;
+	if(glyph->endPtsCapacity < contourNum){
+		glyph->endPtsOfContours = (uint16_t *)ffrealloc(glyph->endPtsOfContours, sizeof(uint16_t) * contourNum);
+		glyph->endPtsCapacity = contourNum;
+	}
+	for(size_t co = 0; co < contourNum; co++){
+		glyph->endPtsOfContours[co] = FontSpanReader_uint16(&reader);
+		if(0 < co && glyph->endPtsOfContours[co] < glyph->endPtsOfContours[co - 1]){
+			return FontParseError_InvalidValue;
+		}
+	}
+	const size_t pointNum = (0 == contourNum)? 0 : (size_t)glyph->endPtsOfContours[contourNum - 1] + 1;
+
+	// *** GlyphDescription.Instructions
+	const uint16_t instructionLength = FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	error = FontSpan_sub(data, reader.offset, instructionLength, &glyph->instructions);
+	if(FontParseError_None != error){
+		return error;
+	}
+	reader.offset += instructionLength;
+
+	// *** GlyphDescription.Flags
+	if(glyph->pointCapacity < pointNum){
+		glyph->points = (FontParseGlyphPoint *)ffrealloc(glyph->points, sizeof(FontParseGlyphPoint) * pointNum);
+		glyph->flags = (uint8_t *)ffrealloc(glyph->flags, sizeof(uint8_t) * pointNum);
+		glyph->coordinates = (int32_t *)ffrealloc(glyph->coordinates, sizeof(int32_t) * pointNum * 2);
+		glyph->pointCapacity = pointNum;
+	}
+	if(0 < pointNum){
+		memset(glyph->points, 0, sizeof(FontParseGlyphPoint) * pointNum);
+	}
+	for(size_t i = 0; i < pointNum; ){
+		const uint8_t flag = FontSpanReader_uint8(&reader);
+		glyph->points[i].flag = flag;
+		glyph->flags[i++] = flag;
+		if(0 != (flag & (1 << 3))){
+			const uint8_t repeatNum = FontSpanReader_uint8(&reader);
+			if(pointNum - i < repeatNum){
+				return FontParseError_InvalidValue;
+			}
+			memset(&glyph->flags[i], flag, repeatNum);
+			for(int rep = 0; rep < repeatNum; rep++){
+				glyph->points[i].isFlagRepeated = 1;
+				glyph->points[i++].flag = flag;
+			}
+		}
+		if(reader.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+	}
+
+	// *** GlyphDescription.XYCoordinates
+	int32_t *xs = glyph->coordinates;
+	int32_t *ys = &glyph->coordinates[pointNum];
+	size_t used;
+	if(! GlyfDecoder_coordinates(&reader.data[reader.offset], reader.size - reader.offset, glyph->flags, pointNum, xs, ys, &used)){
+		return FontParseError_OutOfRange;
+	}
+	FontParser_glyphCoordinates_inline_(glyph->points, glyph->flags, xs, pointNum, false);
+	FontParser_glyphCoordinates_inline_(glyph->points, glyph->flags, ys, pointNum, true);
+
+	glyph->pointNum = pointNum;
+	return FontParseError_None;
+}
+
+// ** 'glyf' Table composite glyph
+
+enum{
+	ComponentFlag_ARG_1_AND_2_ARE_WORDS	= 0x0001,
+	ComponentFlag_ARGS_ARE_XY_VALUES	= 0x0002,
+	ComponentFlag_ROUND_XY_TO_GRID		= 0x0004,
+	ComponentFlag_WE_HAVE_A_SCALE		= 0x0008,
+	ComponentFlag_MORE_COMPONENTS		= 0x0020,
+	ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE	= 0x0040,
+	ComponentFlag_WE_HAVE_A_TWO_BY_TWO	= 0x0080,
+	ComponentFlag_WE_HAVE_INSTRUCTIONS	= 0x0100,
+	ComponentFlag_USE_MY_METRICS		= 0x0200,
+	ComponentFlag_OVERLAP_COMPOUND		= 0x0400,
+	ComponentFlag_SCALED_COMPONENT_OFFSET	= 0x0800,
+	ComponentFlag_UNSCALED_COMPONENT_OFFSET	= 0x1000,
+};
+
+typedef struct{
+	uint16_t		flags;
+	uint16_t		glyphIndex;
+	int32_t			arg1;		//!< ARGS_ARE_XY_VALUES: x offset, 以外: 親の点番号
+	int32_t			arg2;		//!< ARGS_ARE_XY_VALUES: y offset, 以外: 部品の点番号
+	double			scale[4];	//!< a, b, c, d (x' = a * x + c * y, y' = b * x + d * y)
+}FontParseComponent;
+
+/** @brief composite glyphの解析結果。配列は次のglyphの解析で再利用する。
+  */
+typedef struct{
+	GlyphDescriptionHeader	header;
+	FontParseComponent	*components;	//!< [componentNum]
+	size_t			componentNum;
+	size_t			componentCapacity;
+	FontSpan		instructions;	//!< WE_HAVE_INSTRUCTIONSの場合
+}FontParseComposite;
+
+void FontParseComposite_free(FontParseComposite *composite)
+{
+	free(composite->components);
+	*composite = (FontParseComposite){0};
+}
+
+double F2Dot14_toDouble_inline_(uint16_t value)
+{
+	return (double)(int16_t)value / 16384.0;
+}
+
+/** @brief 'glyf'の[offset, nextOffset)をcomposite glyphとして解析する(部品は辿らない)。
+  @return FontParseError_InvalidValue: simple glyph・空glyph
+  */
+FontParseError FontParser_compositeGlyph(FontSpan glyf, uint32_t offset, uint32_t nextOffset, FontParseComposite *composite)
+{
+	composite->header = (GlyphDescriptionHeader){0};
+	composite->componentNum = 0;
+	composite->instructions = (FontSpan){NULL, 0};
+	if(nextOffset < offset){
+		return FontParseError_InvalidValue;
+	}
+	FontSpan data;
+	const FontParseError error = FontSpan_sub(glyf, offset, nextOffset - offset, &data);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(data, 0);
+	composite->header.numberOfContours	= (int16_t)FontSpanReader_uint16(&reader);
+	composite->header.xMin			= (int16_t)FontSpanReader_uint16(&reader);
+	composite->header.yMin			= (int16_t)FontSpanReader_uint16(&reader);
+	composite->header.xMax			= (int16_t)FontSpanReader_uint16(&reader);
+	composite->header.yMax			= (int16_t)FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	if(0 <= composite->header.numberOfContours){
+		return FontParseError_InvalidValue;
+	}
+
+	uint16_t flags;
+	bool isInstructionExist = false;
+	do{
+		FontParseComponent component = {.scale = {1.0, 0.0, 0.0, 1.0}};
+		flags = FontSpanReader_uint16(&reader);
+		component.flags		= flags;
+		component.glyphIndex	= FontSpanReader_uint16(&reader);
+		const bool isXY = (0 != (flags & ComponentFlag_ARGS_ARE_XY_VALUES));
+		// 引数はoffset(符号付き)または点番号(符号無し)
+		if(0 != (flags & ComponentFlag_ARG_1_AND_2_ARE_WORDS)){
+			const uint16_t arg1 = FontSpanReader_uint16(&reader);
+			const uint16_t arg2 = FontSpanReader_uint16(&reader);
+			component.arg1 = isXY ? (int16_t)arg1 : arg1;
+			component.arg2 = isXY ? (int16_t)arg2 : arg2;
+		}else{
+			const uint8_t arg1 = FontSpanReader_uint8(&reader);
+			const uint8_t arg2 = FontSpanReader_uint8(&reader);
+			component.arg1 = isXY ? (int8_t)arg1 : arg1;
+			component.arg2 = isXY ? (int8_t)arg2 : arg2;
+		}
+		if(0 != (flags & ComponentFlag_WE_HAVE_A_SCALE)){
+			component.scale[0] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+			component.scale[3] = component.scale[0];
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE)){
+			component.scale[0] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+			component.scale[3] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_A_TWO_BY_TWO)){
+			component.scale[0] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+			component.scale[1] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+			component.scale[2] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+			component.scale[3] = F2Dot14_toDouble_inline_(FontSpanReader_uint16(&reader));
+		}
+		if(reader.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+		isInstructionExist = isInstructionExist || (0 != (flags & ComponentFlag_WE_HAVE_INSTRUCTIONS));
+
+		if(composite->componentCapacity <= composite->componentNum){
+			composite->componentCapacity = (0 == composite->componentCapacity)? 4 : composite->componentCapacity * 2;
+			composite->components = (FontParseComponent *)ffrealloc(composite->components,
+					sizeof(FontParseComponent) * composite->componentCapacity);
+		}
+		composite->components[composite->componentNum++] = component;
+	}while(0 != (flags & ComponentFlag_MORE_COMPONENTS));
+
+	if(isInstructionExist){
+		const uint16_t instructionLength = FontSpanReader_uint16(&reader);
+		if(reader.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+		return FontSpan_sub(data, reader.offset, instructionLength, &composite->instructions);
+	}
+	return FontParseError_None;
+}
+
+// ** 'glyf' Table outline(composite glyphを展開した絶対座標)
+
+typedef struct{
+	int32_t			x;
+	int32_t			y;
+	bool			isOnCurve;
+}FontParseOutlinePoint;
+
+typedef struct{
+	FontParseOutlinePoint	*points;	//!< [pointNum]
+	size_t			pointNum;
+	uint32_t		*endPts;	//!< [contourNum] 展開後は65535点を超えうる
+	size_t			contourNum;
+}FontParseOutline;
+
+void FontParseOutline_free(FontParseOutline *outline)
+{
+	free(outline->points);
+	free(outline->endPts);
+	*outline = (FontParseOutline){0};
+}
+
+#define FontParseGlyphResolver_DEPTH_MAX	(16)	//!< 部品の入れ子の上限(maxComponentDepthより十分大きい)
+
+enum{
+	FontParseGlyphResolverState_None = 0,
+	FontParseGlyphResolverState_Resolving,	//!< 解決中(ここへ戻る参照は循環)
+	FontParseGlyphResolverState_Resolved,
+	FontParseGlyphResolverState_Error,
+};
+typedef int FontParseGlyphResolverState;
+
+/** @brief glyphIdからcomposite glyphを展開したoutlineを引く。
+  解決したglyph(部品を含む)はglyphId毎に覚え、共有される部品・深い参照を再び解析しない。
+  エラーも覚え、同じglyphは2度目以降も同じエラーを返す。
+  引くたびに書き換わるので、複数threadでは共有しない。
+  */
+typedef struct{
+	const FontParser	*parser;
+	FontSpan		glyf;
+	int16_t			indexToLocFormat;
+	size_t			numGlyphs;
+	FontParseOutline	*outlines;	//!< [numGlyphs]
+	uint8_t			*states;	//!< [numGlyphs] FontParseGlyphResolverState
+	uint8_t			*errors;	//!< [numGlyphs] State_Errorの場合のFontParseError
+	FontParseGlyph		glyph;		//!< simple glyphの解析に使い回す
+	size_t			decodeNum;	//!< 'glyf'からglyphを解析した回数
+}FontParseGlyphResolver;
+
+void FontParseGlyphResolver_free(FontParseGlyphResolver *resolver)
+{
+	for(size_t i = 0; i < resolver->numGlyphs && NULL != resolver->outlines; i++){
+		FontParseOutline_free(&resolver->outlines[i]);
+	}
+	free(resolver->outlines);
+	free(resolver->states);
+	free(resolver->errors);
+	FontParseGlyph_free(&resolver->glyph);
+	*resolver = (FontParseGlyphResolver){0};
+}
+
+//! @param indexToLocFormat HeadTable.indexToLocFormat
+FontParseError FontParseGlyphResolver_init(FontParseGlyphResolver *resolver, const FontParser *parser, int16_t indexToLocFormat, size_t numGlyphs)
+{
+	*resolver = (FontParseGlyphResolver){
+		.parser			= parser,
+		.indexToLocFormat	= indexToLocFormat,
+		.numGlyphs		= numGlyphs,
+	};
+	const FontParseError error = FontParser_table(parser, "glyf", &resolver->glyf);
+	if(FontParseError_None != error){
+		return error;
+	}
+	resolver->outlines	= (FontParseOutline *)ffmalloc(sizeof(FontParseOutline) * (numGlyphs + 1));
+	resolver->states	= (uint8_t *)ffmalloc(numGlyphs + 1);
+	resolver->errors	= (uint8_t *)ffmalloc(numGlyphs + 1);
+	return FontParseError_None;
+}
+
+int32_t FontParseGlyphResolver_round_inline_(double value)
+{
+	return (int32_t)floor(value + 0.5);
+}
+
+FontParseError FontParseGlyphResolver_resolve_inline_(FontParseGlyphResolver *resolver, size_t glyphId, int depth);
+
+FontParseError FontParseGlyphResolver_simple_inline_(FontParseGlyphResolver *resolver, uint32_t offset, uint32_t nextOffset, FontParseOutline *outline)
+{
+	FontParseGlyph *glyph = &resolver->glyph;
+	const FontParseError error = FontParser_glyph(resolver->glyf, offset, nextOffset, glyph);
+	if(FontParseError_None != error){
+		return error;
+	}
+	outline->contourNum = (0 < glyph->pointNum)? (size_t)glyph->header.numberOfContours : 0;
+	outline->pointNum = glyph->pointNum;
+	outline->endPts = (uint32_t *)ffmalloc(sizeof(uint32_t) * (outline->contourNum + 1));
+	outline->points = (FontParseOutlinePoint *)ffmalloc(sizeof(FontParseOutlinePoint) * (outline->pointNum + 1));
+	for(size_t co = 0; co < outline->contourNum; co++){
+		outline->endPts[co] = glyph->endPtsOfContours[co];
+	}
+	for(size_t i = 0; i < outline->pointNum; i++){
+		outline->points[i] = (FontParseOutlinePoint){
+			.x		= glyph->points[i].abs.x,
+			.y		= glyph->points[i].abs.y,
+			.isOnCurve	= (0 != (glyph->points[i].flag & 0x01)),
+		};
+	}
+	return FontParseError_None;
+}
+
+FontParseError FontParseGlyphResolver_composite_inline_(FontParseGlyphResolver *resolver, uint32_t offset, uint32_t nextOffset, int depth, FontParseOutline *outline)
+{
+	FontParseComposite composite = {0};
+	FontParseError error = FontParser_compositeGlyph(resolver->glyf, offset, nextOffset, &composite);
+	for(size_t c = 0; c < composite.componentNum && FontParseError_None == error; c++){
+		const FontParseComponent *component = &composite.components[c];
+		if(resolver->numGlyphs <= component->glyphIndex){
+			error = FontParseError_InvalidValue;
+			break;
+		}
+		error = FontParseGlyphResolver_resolve_inline_(resolver, component->glyphIndex, depth + 1);
+		if(FontParseError_None != error){
+			break;
+		}
+		// outlinesは確保し直さないので、部品の解決後も指す先は変わらない
+		const FontParseOutline *child = &resolver->outlines[component->glyphIndex];
+		const double *m = component->scale;
+
+		// 部品の位置: offset(必要なら変形する)、または親と部品の点を一致させる
+		int32_t dx = 0;
+		int32_t dy = 0;
+		if(0 != (component->flags & ComponentFlag_ARGS_ARE_XY_VALUES)){
+			if(0 != (component->flags & ComponentFlag_SCALED_COMPONENT_OFFSET)
+					&& 0 == (component->flags & ComponentFlag_UNSCALED_COMPONENT_OFFSET)){
+				dx = FontParseGlyphResolver_round_inline_((m[0] * component->arg1) + (m[2] * component->arg2));
+				dy = FontParseGlyphResolver_round_inline_((m[1] * component->arg1) + (m[3] * component->arg2));
+			}else{
+				dx = component->arg1;
+				dy = component->arg2;
+			}
+		}else{
+			if(outline->pointNum <= (size_t)component->arg1 || child->pointNum <= (size_t)component->arg2){
+				error = FontParseError_InvalidValue;
+				break;
+			}
+			const FontParseOutlinePoint *parentPoint = &outline->points[component->arg1];
+			const FontParseOutlinePoint *childPoint = &child->points[component->arg2];
+			dx = parentPoint->x - FontParseGlyphResolver_round_inline_((m[0] * childPoint->x) + (m[2] * childPoint->y));
+			dy = parentPoint->y - FontParseGlyphResolver_round_inline_((m[1] * childPoint->x) + (m[3] * childPoint->y));
+		}
+
+		outline->points = (FontParseOutlinePoint *)ffrealloc(outline->points, sizeof(FontParseOutlinePoint) * (outline->pointNum + child->pointNum + 1));
+		outline->endPts = (uint32_t *)ffrealloc(outline->endPts, sizeof(uint32_t) * (outline->contourNum + child->contourNum + 1));
+		for(size_t co = 0; co < child->contourNum; co++){
+			outline->endPts[outline->contourNum + co] = (uint32_t)outline->pointNum + child->endPts[co];
+		}
+		for(size_t i = 0; i < child->pointNum; i++){
+			const FontParseOutlinePoint *point = &child->points[i];
+			outline->points[outline->pointNum + i] = (FontParseOutlinePoint){
+				.x		= FontParseGlyphResolver_round_inline_((m[0] * point->x) + (m[2] * point->y)) + dx,
+				.y		= FontParseGlyphResolver_round_inline_((m[1] * point->x) + (m[3] * point->y)) + dy,
+				.isOnCurve	= point->isOnCurve,
+			};
+		}
+		outline->contourNum += child->contourNum;
+		outline->pointNum += child->pointNum;
+	}
+	FontParseComposite_free(&composite);
+	return error;
+}
+
+FontParseError FontParseGlyphResolver_resolve_inline_(FontParseGlyphResolver *resolver, size_t glyphId, int depth)
+{
+	switch(resolver->states[glyphId]){
+	case FontParseGlyphResolverState_Resolved:
+		return FontParseError_None;
+	case FontParseGlyphResolverState_Error:
+		return resolver->errors[glyphId];
+	case FontParseGlyphResolverState_Resolving:
+		return FontParseError_Recursion;
+	default:
+		break;
+	}
+	if(FontParseGlyphResolver_DEPTH_MAX < depth){
+		return FontParseError_Recursion;
+	}
+
+	resolver->states[glyphId] = FontParseGlyphResolverState_Resolving;
+	resolver->decodeNum++;
+	FontParseOutline outline = {0};
+	uint32_t offset;
+	uint32_t nextOffset;
+	FontParseError error = FontParser_locaEntry(resolver->parser, resolver->indexToLocFormat, resolver->numGlyphs, glyphId, &offset, &nextOffset);
+	if(FontParseError_None == error){
+		FontSpan data;
+		error = (nextOffset < offset)? FontParseError_InvalidValue : FontSpan_sub(resolver->glyf, offset, nextOffset - offset, &data);
+		if(FontParseError_None == error){
+			const bool isComposite = (2 <= data.size && 0 != (data.data[0] & 0x80));
+			error = isComposite ?
+				FontParseGlyphResolver_composite_inline_(resolver, offset, nextOffset, depth, &outline)
+				: FontParseGlyphResolver_simple_inline_(resolver, offset, nextOffset, &outline);
+		}
+	}
+	if(FontParseError_None != error){
+		FontParseOutline_free(&outline);
+		resolver->states[glyphId] = FontParseGlyphResolverState_Error;
+		resolver->errors[glyphId] = (uint8_t)error;
+		return error;
+	}
+	resolver->outlines[glyphId] = outline;
+	resolver->states[glyphId] = FontParseGlyphResolverState_Resolved;
+	return FontParseError_None;
+}
+
+/** @brief glyphのoutline(composite glyphは部品を変形・配置して1つにした絶対座標)を返す。
+  outlineはresolverが保持する(FontParseGlyphResolver_free()まで有効)。
+  */
+FontParseError FontParseGlyphResolver_outline(FontParseGlyphResolver *resolver, size_t glyphId, const FontParseOutline **outline)
+{
+	*outline = NULL;
+	if(resolver->numGlyphs <= glyphId){
+		return FontParseError_OutOfRange;
+	}
+	const FontParseError error = FontParseGlyphResolver_resolve_inline_(resolver, glyphId, 0);
+	if(FontParseError_None == error){
+		*outline = &resolver->outlines[glyphId];
+	}
+	return error;
+}
+
+/** @brief glyphの点数(phantom pointを除く)だけを読む。空glyphは0
+  composite glyphは部品の数('gvar'では部品毎のoffsetを1点として変化させる)。
+  */
+FontParseError FontParser_glyphPointNum(FontSpan glyf, uint32_t offset, uint32_t nextOffset, size_t *pointNum)
+{
+	*pointNum = 0;
+	if(nextOffset < offset){
+		return FontParseError_InvalidValue;
+	}
+	FontSpan data;
+	const FontParseError error = FontSpan_sub(glyf, offset, nextOffset - offset, &data);
+	if(FontParseError_None != error || 0 == data.size){
+		return error;
+	}
+	FontSpanReader reader = FontSpanReader_init(data, 0);
+	const int16_t numberOfContours = (int16_t)FontSpanReader_uint16(&reader);
+	if(numberOfContours < 0){
+		FontParseComposite composite = {0};
+		const FontParseError compositeError = FontParser_compositeGlyph(glyf, offset, nextOffset, &composite);
+		*pointNum = composite.componentNum;
+		FontParseComposite_free(&composite);
+		return compositeError;
+	}
+	if(0 == numberOfContours){
+		return reader.isOverrun ? FontParseError_OutOfRange : FontParseError_None;
+	}
+	reader.offset = sizeof(GlyphDescriptionHeader) + (sizeof(uint16_t) * (numberOfContours - 1));
+	const uint16_t lastEndPoint = FontSpanReader_uint16(&reader);
+	if(reader.isOverrun){
+		return FontParseError_OutOfRange;
+	}
+	*pointNum = (size_t)lastEndPoint + 1;
+	return FontParseError_None;
+}
+
+#endif // #ifndef DAISYFF_FONT_PARSER_HPP_
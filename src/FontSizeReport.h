@@ -0,0 +1,607 @@
+/**
+  @file
+  @brief フォントファイルの大きさの内訳と、符号化を変えた場合に減らせるbyte数の見積もり(daisydump --size-report)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  1. Table毎のbyte数(TableDirectory, Tableの間の隙間を含む)。
+  2. 'glyf'はglyph毎にheader, endPts, 命令, flag, x, y, 部品, paddingのbyte数と、
+     座標の形式(same, short, long)・flagのREPEATの集計。
+  3. 減らせるbyte数の見積もり
+     - flag repeat: 同じflagの並びを全てREPEATでまとめる
+     - short vector: 座標を最も短い形式(0はsame, 255以下はshort)で書く
+     - cmap range: format 4は文字の連続する範囲毎にdelta・glyphIdArrayの安い方、format 12は文字とglyphIdの連続する範囲で書く
+     - hmtx trailing: 末尾の同じadvanceWidthの並びをleftSideBearingだけの配列にする
+  'glyf'の見積もりはglyph毎の4byte境界のpaddingの変化を含まない。
+ */
+#ifndef DAISYFF_FONT_SIZE_REPORT_HPP_
+#define DAISYFF_FONT_SIZE_REPORT_HPP_
+
+#include "src/FontParser.h"
+#include "src/CmapPageTable.h"
+#include <inttypes.h>
+#include <stdarg.h>
+
+enum{
+	FontSizeCoord_SAME = 0,		//!< 0byte(前の点と同じ)
+	FontSizeCoord_SHORT,		//!< 1byte
+	FontSizeCoord_LONG,		//!< 2byte
+	FontSizeCoord_NUM,
+};
+typedef int FontSizeCoord;
+
+//! x, yそれぞれの座標の形式の集計
+typedef struct{
+	size_t			counts[FontSizeCoord_NUM];
+	size_t			bytes;
+	size_t			longFitsShortNum;	//!< longで書かれているがshortで書ける(1以上255以下)
+	size_t			zeroNotSameNum;		//!< 差分0だがsameで書かれていない
+}FontSizeCoordHistogram;
+
+//! glyph 1つのbyte数の内訳('loca'の範囲)
+typedef struct{
+	size_t			bytes;
+	size_t			headerBytes;
+	size_t			endPtsBytes;
+	size_t			instructionBytes;	//!< 長さの2byteを含む
+	size_t			flagBytes;
+	size_t			xBytes;
+	size_t			yBytes;
+	size_t			componentBytes;
+	size_t			paddingBytes;		//!< データの後ろの未使用のbyte
+	size_t			pointNum;
+}FontSizeGlyph;
+
+typedef struct{
+	FILE			*out;			//!< NULL: 出力せず数えるだけ
+	size_t			glyphFirst;		//!< glyph毎の行を出力する範囲
+	size_t			glyphLast;
+	// ** Table
+	size_t			fileSize;
+	size_t			directoryBytes;		//!< OffsetTable, TableDirectory
+	size_t			tableBytes;
+	// ** 'glyf'
+	size_t			glyphNum;
+	size_t			simpleNum;
+	size_t			compositeNum;
+	size_t			emptyNum;
+	size_t			errorNum;		//!< 解析できなかったglyph(内訳に含めない)
+	FontSizeGlyph		glyf;			//!< 全glyphの合計
+	size_t			flagRepeatedNum;	//!< REPEATでまとめられた(flagのbyteを持たない)点
+	size_t			flagRunNum;		//!< REPEATを使った並び
+	FontSizeCoordHistogram	coords[2];		//!< x, y
+	// ** 減らせるbyte数の見積もり
+	int64_t			savingFlagRepeat;
+	int64_t			savingShortVector;
+	int64_t			savingCmapRange;
+	int64_t			savingHmtxTrailing;
+	// glyph毎の作業領域(使い回す)
+	uint8_t			*flags;
+	int32_t			*deltas;		//!< [pointCapacity * 2] x, y
+	size_t			pointCapacity;
+}FontSizeReport;
+
+void FontSizeReport_free(FontSizeReport *report)
+{
+	free(report->flags);
+	free(report->deltas);
+	report->flags = NULL;
+	report->deltas = NULL;
+	report->pointCapacity = 0;
+}
+
+int64_t FontSizeReport_saving(const FontSizeReport *report)
+{
+	return report->savingFlagRepeat + report->savingShortVector + report->savingCmapRange + report->savingHmtxTrailing;
+}
+
+void FontSizeReport_print(FontSizeReport *report, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+void FontSizeReport_print(FontSizeReport *report, const char *fmt, ...)
+{
+	if(NULL == report->out){
+		return;
+	}
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(report->out, fmt, ap);
+	va_end(ap);
+	fputc('\n', report->out);
+}
+
+double FontSizeReport_percent_inline_(size_t bytes, size_t total)
+{
+	return (0 == total)? 0.0 : (100.0 * (double)bytes / (double)total);
+}
+
+// ** Table
+
+int FontSizeReport_compareLength_inline_(const void *a, const void *b)
+{
+	const TableDirectory_Member *ma = *(const TableDirectory_Member * const *)a;
+	const TableDirectory_Member *mb = *(const TableDirectory_Member * const *)b;
+	if(ma->length != mb->length){
+		return (ma->length < mb->length)? 1 : -1;
+	}
+	return (ma->tag < mb->tag)? -1 : ((mb->tag < ma->tag)? 1 : 0);
+}
+
+//! @brief Table毎のbyte数を大きい順に出力する
+void FontSizeReport_tables_inline_(FontSizeReport *report, const FontParser *parser)
+{
+	const size_t numTables = parser->offsetTable.numTables;
+	report->fileSize = parser->file.size;
+	report->directoryBytes = 12 + (16 * numTables);
+	const TableDirectory_Member **members = (const TableDirectory_Member **)ffmalloc(sizeof(TableDirectory_Member *) * (numTables + 1));
+	for(size_t i = 0; i < numTables; i++){
+		members[i] = &parser->tableDirectory[i];
+		report->tableBytes += members[i]->length;
+	}
+	qsort(members, numTables, sizeof(TableDirectory_Member *), FontSizeReport_compareLength_inline_);
+	FontSizeReport_print(report, "file: %zu bytes tables %zu", report->fileSize, numTables);
+	FontSizeReport_print(report, "directory: %zu bytes %.1f%%",
+			report->directoryBytes, FontSizeReport_percent_inline_(report->directoryBytes, report->fileSize));
+	for(size_t i = 0; i < numTables; i++){
+		char tag[5];
+		for(int c = 0; c < 4; c++){
+			const char ch = (char)(members[i]->tag >> (8 * (3 - c)));
+			tag[c] = (0x20 <= ch && ch < 0x7F)? ch : '?';
+		}
+		tag[4] = '\0';
+		FontSizeReport_print(report, "table '%s': %"PRIu32" bytes %.1f%%",
+				tag, members[i]->length, FontSizeReport_percent_inline_(members[i]->length, report->fileSize));
+	}
+	free(members);
+	// Table同士が重なる場合は負になる
+	const int64_t paddingBytes = (int64_t)report->fileSize - (int64_t)(report->directoryBytes + report->tableBytes);
+	FontSizeReport_print(report, "padding: %"PRId64" bytes", paddingBytes);
+}
+
+// ** 'glyf'
+
+//! @return 同じflagの並びを全てREPEATでまとめた場合のflagのbyte数
+size_t FontSizeReport_flagRunBytes_inline_(const uint8_t *flags, size_t pointNum)
+{
+	size_t bytes = 0;
+	for(size_t i = 0; i < pointNum; ){
+		size_t run = 1;
+		while(i + run < pointNum && run < 256 && flags[i + run] == flags[i]){
+			run++;
+		}
+		bytes += (1 == run)? 1 : 2;
+		i += run;
+	}
+	return bytes;
+}
+
+//! @brief 座標(axis 0: x, 1: y)を読んで集計し、deltasへ書く @return false: 範囲外
+bool FontSizeReport_coordinates_inline_(FontSizeReport *report, FontSpanReader *reader, size_t pointNum, int axis)
+{
+	const uint8_t shortBit = (0 == axis)? 0x02 : 0x04;
+	const uint8_t sameBit = (0 == axis)? 0x10 : 0x20;
+	FontSizeCoordHistogram *histogram = &report->coords[axis];
+	for(size_t i = 0; i < pointNum; i++){
+		const uint8_t flag = report->flags[i];
+		int32_t delta;
+		if(0 != (flag & shortBit)){
+			const uint8_t value = FontSpanReader_uint8(reader);
+			delta = (0 != (flag & sameBit))? value : -(int32_t)value;
+			histogram->counts[FontSizeCoord_SHORT]++;
+			histogram->bytes += 1;
+			histogram->zeroNotSameNum += (0 == delta)? 1 : 0;
+		}else if(0 != (flag & sameBit)){
+			delta = 0;
+			histogram->counts[FontSizeCoord_SAME]++;
+		}else{
+			delta = (int16_t)FontSpanReader_uint16(reader);
+			histogram->counts[FontSizeCoord_LONG]++;
+			histogram->bytes += 2;
+			histogram->zeroNotSameNum += (0 == delta)? 1 : 0;
+			histogram->longFitsShortNum += (0 != delta && -256 < delta && delta < 256)? 1 : 0;
+		}
+		report->deltas[(2 * i) + axis] = delta;
+	}
+	return ! reader->isOverrun;
+}
+
+//! @return 最も短い形式で書いた場合の座標のbyte数(flagsは書き換えたflag)
+size_t FontSizeReport_optimalCoordinates_inline_(FontSizeReport *report, size_t pointNum, uint8_t *flags)
+{
+	size_t bytes = 0;
+	for(size_t i = 0; i < pointNum; i++){
+		// ON_CURVE, OVERLAP_SIMPLE, reservedは元のまま
+		uint8_t flag = report->flags[i] & 0xC1;
+		for(int axis = 0; axis < 2; axis++){
+			const int32_t delta = report->deltas[(2 * i) + axis];
+			const uint8_t shortBit = (0 == axis)? 0x02 : 0x04;
+			const uint8_t sameBit = (0 == axis)? 0x10 : 0x20;
+			if(0 == delta){
+				flag |= sameBit;
+			}else if(-256 < delta && delta < 256){
+				flag |= shortBit | ((0 < delta)? sameBit : 0);
+				bytes += 1;
+			}else{
+				bytes += 2;
+			}
+		}
+		flags[i] = flag;
+	}
+	return bytes;
+}
+
+bool FontSizeReport_simpleGlyph_inline_(FontSizeReport *report, FontSpanReader *reader, size_t numberOfContours, FontSizeGlyph *glyph)
+{
+	glyph->endPtsBytes = 2 * numberOfContours;
+	uint16_t lastEndPt = 0;
+	for(size_t c = 0; c < numberOfContours; c++){
+		lastEndPt = FontSpanReader_uint16(reader);
+	}
+	const uint16_t instructionLength = FontSpanReader_uint16(reader);
+	reader->offset += instructionLength;
+	glyph->instructionBytes = 2 + (size_t)instructionLength;
+	if(reader->isOverrun || reader->size < reader->offset){
+		return false;
+	}
+	// numberOfContoursが0のglyphは点を持たない(headerと命令だけ)
+	const size_t pointNum = (0 == numberOfContours)? 0 : (size_t)lastEndPt + 1;
+	glyph->pointNum = pointNum;
+	if(report->pointCapacity < pointNum){
+		// 最適なflagの作業領域を後半に持つ
+		report->pointCapacity = pointNum;
+		report->flags = (uint8_t *)ffrealloc(report->flags, 2 * pointNum);
+		report->deltas = (int32_t *)ffrealloc(report->deltas, sizeof(int32_t) * 2 * pointNum);
+	}
+
+	// flag: REPEATを展開する
+	const size_t flagBegin = reader->offset;
+	size_t repeatedNum = 0;
+	size_t runNum = 0;
+	for(size_t i = 0; i < pointNum && ! reader->isOverrun; ){
+		const uint8_t flag = FontSpanReader_uint8(reader);
+		size_t count = 1;
+		if(0 != (flag & 0x08)){
+			count += FontSpanReader_uint8(reader);
+			repeatedNum += count - 1;
+			runNum++;
+		}
+		for(size_t r = 0; r < count && i < pointNum; r++){
+			report->flags[i++] = flag & (uint8_t)~0x08;
+		}
+	}
+	if(reader->isOverrun){
+		return false;
+	}
+	glyph->flagBytes = reader->offset - flagBegin;
+
+	// 座標を読む前の集計に戻せるように写しておく
+	const FontSizeCoordHistogram coords[2] = {report->coords[0], report->coords[1]};
+	if(! FontSizeReport_coordinates_inline_(report, reader, pointNum, 0)
+			|| ! FontSizeReport_coordinates_inline_(report, reader, pointNum, 1)){
+		report->coords[0] = coords[0];
+		report->coords[1] = coords[1];
+		return false;
+	}
+	glyph->xBytes = report->coords[0].bytes - coords[0].bytes;
+	glyph->yBytes = report->coords[1].bytes - coords[1].bytes;
+	report->flagRepeatedNum += repeatedNum;
+	report->flagRunNum += runNum;
+
+	uint8_t *optimalFlags = &report->flags[pointNum];
+	const size_t optimalCoordBytes = FontSizeReport_optimalCoordinates_inline_(report, pointNum, optimalFlags);
+	const size_t runBytes = FontSizeReport_flagRunBytes_inline_(report->flags, pointNum);
+	const size_t optimalRunBytes = FontSizeReport_flagRunBytes_inline_(optimalFlags, pointNum);
+	report->savingFlagRepeat += (int64_t)glyph->flagBytes - (int64_t)runBytes;
+	report->savingShortVector += (int64_t)(runBytes + glyph->xBytes + glyph->yBytes) - (int64_t)(optimalRunBytes + optimalCoordBytes);
+	return true;
+}
+
+bool FontSizeReport_compositeGlyph_inline_(FontSpanReader *reader, FontSizeGlyph *glyph)
+{
+	const size_t begin = reader->offset;
+	bool hasInstructions = false;
+	uint16_t flags;
+	do{
+		flags = FontSpanReader_uint16(reader);
+		reader->offset += 2; // glyphIndex
+		reader->offset += (0 != (flags & ComponentFlag_ARG_1_AND_2_ARE_WORDS))? 4 : 2;
+		if(0 != (flags & ComponentFlag_WE_HAVE_A_SCALE)){
+			reader->offset += 2;
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE)){
+			reader->offset += 4;
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_A_TWO_BY_TWO)){
+			reader->offset += 8;
+		}
+		hasInstructions = hasInstructions || (0 != (flags & ComponentFlag_WE_HAVE_INSTRUCTIONS));
+	}while(! reader->isOverrun && 0 != (flags & ComponentFlag_MORE_COMPONENTS) && reader->offset < reader->size);
+	glyph->componentBytes = reader->offset - begin;
+	if(hasInstructions){
+		const uint16_t instructionLength = FontSpanReader_uint16(reader);
+		reader->offset += instructionLength;
+		glyph->instructionBytes = 2 + (size_t)instructionLength;
+	}
+	return ! reader->isOverrun && reader->offset <= reader->size;
+}
+
+/** @brief glyph 1つ('loca'の範囲のbyte列)を集計する。
+  @return false: 解析できない(errorNumに数え、内訳には含めない)
+  */
+bool FontSizeReport_glyph(FontSizeReport *report, size_t glyphId, FontSpan data, FontSizeGlyph *glyph)
+{
+	*glyph = (FontSizeGlyph){.bytes = data.size};
+	report->glyphNum++;
+	if(0 == data.size){
+		report->emptyNum++;
+		return true;
+	}
+	FontSpanReader reader = FontSpanReader_init(data, 0);
+	const int16_t numberOfContours = (int16_t)FontSpanReader_uint16(&reader);
+	reader.offset += 8;
+	glyph->headerBytes = 10;
+	bool isOk;
+	if(numberOfContours < 0){
+		isOk = FontSizeReport_compositeGlyph_inline_(&reader, glyph);
+		report->compositeNum += isOk ? 1 : 0;
+	}else{
+		isOk = ! reader.isOverrun && FontSizeReport_simpleGlyph_inline_(report, &reader, (size_t)numberOfContours, glyph);
+		report->simpleNum += isOk ? 1 : 0;
+	}
+	if(! isOk){
+		report->errorNum++;
+		*glyph = (FontSizeGlyph){.bytes = data.size};
+		return false;
+	}
+	glyph->paddingBytes = data.size - reader.offset;
+
+	FontSizeGlyph *total = &report->glyf;
+	total->bytes			+= glyph->bytes;
+	total->headerBytes		+= glyph->headerBytes;
+	total->endPtsBytes		+= glyph->endPtsBytes;
+	total->instructionBytes		+= glyph->instructionBytes;
+	total->flagBytes		+= glyph->flagBytes;
+	total->xBytes			+= glyph->xBytes;
+	total->yBytes			+= glyph->yBytes;
+	total->componentBytes		+= glyph->componentBytes;
+	total->paddingBytes		+= glyph->paddingBytes;
+	total->pointNum			+= glyph->pointNum;
+	return true;
+}
+
+void FontSizeReport_printGlyph_inline_(FontSizeReport *report, const char *label, const FontSizeGlyph *glyph)
+{
+	FontSizeReport_print(report, "%s: bytes %zu header %zu endPts %zu instructions %zu flags %zu x %zu y %zu"
+			" components %zu padding %zu points %zu",
+			label, glyph->bytes, glyph->headerBytes, glyph->endPtsBytes, glyph->instructionBytes,
+			glyph->flagBytes, glyph->xBytes, glyph->yBytes, glyph->componentBytes, glyph->paddingBytes, glyph->pointNum);
+}
+
+void FontSizeReport_glyf_inline_(FontSizeReport *report, const FontParser *parser)
+{
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	FontSpan glyf;
+	FontParseLocaView loca;
+	FontParseError error = FontParser_head(parser, &head);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxp);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_table(parser, "glyf", &glyf);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_locaView(parser, head.indexToLocFormat, maxp.numGlyphs, &loca);
+	}
+	if(FontParseError_None != error){
+		FontSizeReport_print(report, "glyf: %s", FontParseError_toString(error));
+		return;
+	}
+
+	for(size_t glyphId = 0; glyphId < maxp.numGlyphs; glyphId++){
+		uint32_t offset;
+		uint32_t nextOffset;
+		FontSpan data = {NULL, 0};
+		FontSizeGlyph glyph;
+		const bool isInRange = (FontParseError_None == FontParseLocaView_entry(&loca, glyphId, glyf.size, &offset, &nextOffset)
+				&& FontParseError_None == FontSpan_sub(glyf, offset, nextOffset - offset, &data));
+		if(! isInRange){
+			report->glyphNum++;
+			report->errorNum++;
+			FontSizeReport_print(report, "glyph %zu: %s", glyphId, FontParseError_toString(FontParseError_OutOfRange));
+			continue;
+		}
+		if(! FontSizeReport_glyph(report, glyphId, data, &glyph)){
+			FontSizeReport_print(report, "glyph %zu: %s", glyphId, FontParseError_toString(FontParseError_InvalidValue));
+			continue;
+		}
+		if(report->glyphFirst <= glyphId && glyphId <= report->glyphLast){
+			char label[32];
+			snprintf(label, sizeof(label), "glyph %zu", glyphId);
+			FontSizeReport_printGlyph_inline_(report, label, &glyph);
+		}
+	}
+
+	const FontSizeGlyph *total = &report->glyf;
+	FontSizeReport_print(report, "glyf: glyphs %zu simple %zu composite %zu empty %zu error %zu points %zu",
+			report->glyphNum, report->simpleNum, report->compositeNum, report->emptyNum, report->errorNum, total->pointNum);
+	FontSizeReport_printGlyph_inline_(report, "glyf bytes", total);
+	FontSizeReport_print(report, "glyf flags: bytes %zu points %zu repeated %zu runs %zu",
+			total->flagBytes, total->pointNum, report->flagRepeatedNum, report->flagRunNum);
+	for(int axis = 0; axis < 2; axis++){
+		const FontSizeCoordHistogram *histogram = &report->coords[axis];
+		FontSizeReport_print(report, "glyf %c: same %zu short %zu long %zu bytes %zu long-fits-short %zu zero-not-same %zu",
+				(0 == axis)? 'x' : 'y',
+				histogram->counts[FontSizeCoord_SAME], histogram->counts[FontSizeCoord_SHORT], histogram->counts[FontSizeCoord_LONG],
+				histogram->bytes, histogram->longFitsShortNum, histogram->zeroNotSameNum);
+	}
+}
+
+// ** 'cmap'
+
+//! @brief format 4, 12のsubtableを割り当てから書き直した場合のbyte数を見積もる
+size_t FontSizeReport_cmapEstimate_inline_(const CmapPageTable *table, uint16_t format, size_t *rangeNum)
+{
+	// format 4: 文字の連続する範囲毎に、deltaの範囲で分けるかglyphIdArrayで1つにするかの安い方
+	// format 12: 文字とglyphIdが共に連続する範囲毎に1 group
+	const uint32_t limit = (4 == format)? 0xFFFF : CmapPageTable_CODEPOINT_NUM;
+	size_t bytes = 0;
+	size_t ranges = 0;
+	uint32_t prevCodepoint = UINT32_MAX;
+	uint16_t prevGlyphId = 0;
+	size_t blockLength = 0;
+	size_t blockDeltaRuns = 0;
+	for(uint32_t page = 0; page < CmapPageTable_CODEPOINT_NUM / CmapPageTable_PAGE_SIZE; page++){
+		if(0 == table->pageIndexes[page]){
+			continue;
+		}
+		const uint16_t *glyphIds = &table->pages[(size_t)table->pageIndexes[page] * CmapPageTable_PAGE_SIZE];
+		for(uint32_t i = 0; i < CmapPageTable_PAGE_SIZE; i++){
+			const uint32_t codepoint = (page * CmapPageTable_PAGE_SIZE) + i;
+			if(0 == glyphIds[i] || limit <= codepoint){
+				continue;
+			}
+			const bool isNextCodepoint = (prevCodepoint + 1 == codepoint);
+			const bool isNextGlyph = isNextCodepoint && (uint16_t)(prevGlyphId + 1) == glyphIds[i];
+			if(12 == format){
+				ranges += isNextGlyph ? 0 : 1;
+			}else if(isNextCodepoint){
+				blockLength++;
+				blockDeltaRuns += isNextGlyph ? 0 : 1;
+			}else{
+				if(0 < blockLength){
+					const size_t deltaBytes = 8 * blockDeltaRuns;
+					const size_t arrayBytes = 8 + (2 * blockLength);
+					bytes += (deltaBytes < arrayBytes)? deltaBytes : arrayBytes;
+					ranges += (deltaBytes < arrayBytes)? blockDeltaRuns : 1;
+				}
+				blockLength = 1;
+				blockDeltaRuns = 1;
+			}
+			prevCodepoint = codepoint;
+			prevGlyphId = glyphIds[i];
+		}
+	}
+	if(12 == format){
+		*rangeNum = ranges;
+		return 16 + (12 * ranges);
+	}
+	if(0 < blockLength){
+		const size_t deltaBytes = 8 * blockDeltaRuns;
+		const size_t arrayBytes = 8 + (2 * blockLength);
+		bytes += (deltaBytes < arrayBytes)? deltaBytes : arrayBytes;
+		ranges += (deltaBytes < arrayBytes)? blockDeltaRuns : 1;
+	}
+	// 終端の0xFFFFの範囲とheader
+	*rangeNum = ranges + 1;
+	return 16 + bytes + 8;
+}
+
+void FontSizeReport_cmap_inline_(FontSizeReport *report, const FontParser *parser)
+{
+	FontParseCmap cmap;
+	const FontParseError error = FontParser_cmap(parser, &cmap);
+	if(FontParseError_None != error){
+		FontParseCmap_free(&cmap);
+		FontSizeReport_print(report, "cmap: %s", FontParseError_toString(error));
+		return;
+	}
+	for(size_t i = 0; i < cmap.header.numTables; i++){
+		// 同じsubtableを指すEncodingRecordは最初の1つだけ数える
+		bool isShared = false;
+		for(size_t k = 0; k < i; k++){
+			isShared = isShared || (cmap.encodingRecords[k].offset == cmap.encodingRecords[i].offset);
+		}
+		// format 8以降は32bitの長さ
+		const size_t offset = cmap.encodingRecords[i].offset;
+		FontSpanReader reader = FontSpanReader_init(cmap.table, offset);
+		const uint16_t format = FontSpanReader_uint16(&reader);
+		size_t length;
+		if(8 <= format){
+			reader.offset += 2; // reserved
+			length = FontSpanReader_uint32(&reader);
+		}else{
+			length = FontSpanReader_uint16(&reader);
+		}
+		if(isShared || reader.isOverrun){
+			continue;
+		}
+		if(4 != format && 12 != format){
+			FontSizeReport_print(report, "cmap %u/%u format %u: %zu bytes",
+					cmap.encodingRecords[i].platformID, cmap.encodingRecords[i].encodingID, format, length);
+			continue;
+		}
+		FontSpan subtable;
+		CmapPageTable table;
+		FontSpan_sub(cmap.table, offset, cmap.table.size - offset, &subtable);
+		CmapPageTable_build(&table, subtable, UINT16_MAX);
+		size_t rangeNum;
+		const size_t estimate = FontSizeReport_cmapEstimate_inline_(&table, format, &rangeNum);
+		CmapPageTable_free(&table);
+		const int64_t saving = (estimate < length)? (int64_t)(length - estimate) : 0;
+		report->savingCmapRange += saving;
+		FontSizeReport_print(report, "cmap %u/%u format %u: %zu bytes ranges %zu estimate %zu bytes",
+				cmap.encodingRecords[i].platformID, cmap.encodingRecords[i].encodingID, format, length, rangeNum, estimate);
+	}
+	FontParseCmap_free(&cmap);
+}
+
+// ** 'hmtx'
+
+void FontSizeReport_hmtx_inline_(FontSizeReport *report, const FontParser *parser)
+{
+	HheaTable hhea;
+	MaxpTable_Version05 maxp;
+	if(FontParseError_None != FontParser_hhea(parser, &hhea)
+			|| FontParseError_None != FontParser_maxp(parser, &maxp)){
+		return;
+	}
+	FontParseHmtx hmtx;
+	const FontParseError error = FontParser_hmtx(parser, hhea.numberOfHMetrics, maxp.numGlyphs, &hmtx);
+	if(FontParseError_None != error){
+		FontSizeReport_print(report, "hmtx: %s", FontParseError_toString(error));
+		return;
+	}
+	// 最後のadvanceWidthと同じ値が末尾で続く分はlongHorMetricでなくてよい
+	const size_t numberOfHMetrics = hmtx.numberOfHMetrics;
+	uint16_t lastAdvance;
+	uint16_t advance;
+	int16_t lsb;
+	FontParseHmtx_metric(&hmtx, numberOfHMetrics - 1, &lastAdvance, &lsb);
+	size_t minimum = numberOfHMetrics;
+	while(1 < minimum){
+		FontParseHmtx_metric(&hmtx, minimum - 2, &advance, &lsb);
+		if(lastAdvance != advance){
+			break;
+		}
+		minimum--;
+	}
+	report->savingHmtxTrailing = 2 * (int64_t)(numberOfHMetrics - minimum);
+	FontSizeReport_print(report, "hmtx: %zu bytes numberOfHMetrics %zu minimum %zu numGlyphs %u",
+			hmtx.table.size, numberOfHMetrics, minimum, maxp.numGlyphs);
+}
+
+// ** 入口
+
+//! @brief 内訳と見積もりを出力する(reportは{0}にout, glyphFirst, glyphLastを入れて渡す)
+void FontSizeReport_analyze(FontSizeReport *report, const FontParser *parser)
+{
+	FontSizeReport_tables_inline_(report, parser);
+	if(NULL != FontParser_queryTag(parser, "glyf")){
+		FontSizeReport_glyf_inline_(report, parser);
+	}
+	if(NULL != FontParser_queryTag(parser, "cmap")){
+		FontSizeReport_cmap_inline_(report, parser);
+	}
+	if(NULL != FontParser_queryTag(parser, "hmtx")){
+		FontSizeReport_hmtx_inline_(report, parser);
+	}
+	FontSizeReport_free(report);
+
+	const int64_t savings[] = {
+		report->savingFlagRepeat, report->savingShortVector, report->savingCmapRange, report->savingHmtxTrailing,
+	};
+	const char *names[] = {"flag-repeat", "short-vector", "cmap-range", "hmtx-trailing",};
+	for(size_t i = 0; i < sizeof(savings) / sizeof(savings[0]); i++){
+		FontSizeReport_print(report, "saving %s: %"PRId64" bytes", names[i], savings[i]);
+	}
+}
+
+#endif // #ifndef DAISYFF_FONT_SIZE_REPORT_HPP_
@@ -0,0 +1,282 @@
+/**
+  @file
+  @brief フォントファイルの構造を検査し、見つけたエラーを全て集める(最初のエラーで終了しない)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  FontParserの上に作り、結果はフォント毎のFontValidationへ集める。
+  daisydump --batch で大量のフォントを並列に検査するのに使う。
+ */
+#ifndef DAISYFF_FONT_VALIDATOR_HPP_
+#define DAISYFF_FONT_VALIDATOR_HPP_
+
+#include "src/FontWoff.h"
+#include "src/CmapPageTable.h"
+#include "src/FontChecksum.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define FontValidation_ERROR_MAX	(64)	//!< これ以上のエラーは数だけ数える
+#define FontValidation_MESSAGE_SIZE	(256)
+
+typedef struct{
+	char			**errors;	//!< [min(errorNum, ERROR_MAX)]
+	size_t			errorNum;
+	double			elapsedMs;	//!< FontValidator_validateFile()の処理時間
+}FontValidation;
+
+void FontValidation_free(FontValidation *validation)
+{
+	const size_t num = (FontValidation_ERROR_MAX < validation->errorNum)? FontValidation_ERROR_MAX : validation->errorNum;
+	for(size_t i = 0; i < num; i++){
+		free(validation->errors[i]);
+	}
+	free(validation->errors);
+	*validation = (FontValidation){0};
+}
+
+void FontValidation_addError(FontValidation *validation, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+void FontValidation_addError(FontValidation *validation, const char *fmt, ...)
+{
+	if(FontValidation_ERROR_MAX <= validation->errorNum){
+		validation->errorNum++;
+		return;
+	}
+	char *message = (char *)ffmalloc(FontValidation_MESSAGE_SIZE);
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(message, FontValidation_MESSAGE_SIZE, fmt, ap);
+	va_end(ap);
+	validation->errors = (char **)ffrealloc(validation->errors, sizeof(char *) * (validation->errorNum + 1));
+	validation->errors[validation->errorNum++] = message;
+}
+
+void FontValidator_tableDirectory_inline_(const FontParser *parser, FontValidation *validation)
+{
+	for(size_t i = 0; i < parser->offsetTable.numTables; i++){
+		const TableDirectory_Member *member = &parser->tableDirectory[i];
+		FontSpan table;
+		if(FontParseError_None != FontSpan_sub(parser->file, member->offset, member->length, &table)){
+			const uint32_t tag = member->tag;
+			FontValidation_addError(validation, "table '%c%c%c%c' out of file: offset %"PRIu32" length %"PRIu32" (file %zu)",
+					(char)(tag >> 24), (char)(tag >> 16), (char)(tag >> 8), (char)tag,
+					member->offset, member->length, parser->file.size);
+		}
+	}
+}
+
+void FontValidator_checksum_inline_(const FontParser *parser, FontValidation *validation)
+{
+	// 検査自体をフォント毎に並列に行うので、checksumは1threadで計算する
+	FontChecksumReport report;
+	FontChecksum_verify(parser, 1, &report);
+	for(size_t i = 0; i < report.tableNum; i++){
+		const FontChecksumTable *table = &report.tables[i];
+		if(! table->isOutOfRange && table->stored != table->actual){
+			const uint32_t tag = table->tag;
+			FontValidation_addError(validation, "table '%c%c%c%c' checksum: stored 0x%08"PRIX32" actual 0x%08"PRIX32,
+					(char)(tag >> 24), (char)(tag >> 16), (char)(tag >> 8), (char)tag, table->stored, table->actual);
+		}
+	}
+	if(report.isHeadFound && report.storedAdjustment != report.actualAdjustment){
+		FontValidation_addError(validation, "head: checkSumAdjustment stored 0x%08"PRIX32" actual 0x%08"PRIX32,
+				report.storedAdjustment, report.actualAdjustment);
+	}
+	FontChecksumReport_free(&report);
+}
+
+void FontValidator_cmapFormat4_inline_(const FontParseCmap *cmap, size_t index, FontValidation *validation)
+{
+	FontParseCmapFormat4 format4;
+	const FontParseError error = FontParseCmap_format4(cmap, index, &format4);
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "cmap subtable %zu format 4: %s", index, FontParseError_toString(error));
+		FontParseCmapFormat4_free(&format4);
+		return;
+	}
+	const size_t segCount = format4.segCountX2 / 2;
+	if(0 == segCount){
+		FontValidation_addError(validation, "cmap subtable %zu format 4: no segment", index);
+	}
+	for(size_t seg = 0; seg < segCount; seg++){
+		if(format4.endCode[seg] < format4.startCode[seg]){
+			FontValidation_addError(validation, "cmap subtable %zu format 4: segment %zu startCode 0x%04X > endCode 0x%04X",
+					index, seg, format4.startCode[seg], format4.endCode[seg]);
+		}
+		if(0 < seg && format4.startCode[seg] <= format4.endCode[seg - 1]){
+			FontValidation_addError(validation, "cmap subtable %zu format 4: segment %zu not ascending (0x%04X <= 0x%04X)",
+					index, seg, format4.startCode[seg], format4.endCode[seg - 1]);
+		}
+	}
+	// 最後のsegmentは0xFFFFだけの終端
+	if(0 < segCount && ! (0xFFFF == format4.startCode[segCount - 1] && 0xFFFF == format4.endCode[segCount - 1])){
+		FontValidation_addError(validation, "cmap subtable %zu format 4: last segment is not 0xFFFF terminator", index);
+	}
+	FontParseCmapFormat4_free(&format4);
+}
+
+void FontValidator_cmap_inline_(const FontParser *parser, uint16_t numGlyphs, FontValidation *validation)
+{
+	FontParseCmap cmap;
+	FontParseError error = FontParser_cmap(parser, &cmap);
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "cmap: %s", FontParseError_toString(error));
+		FontParseCmap_free(&cmap);
+		return;
+	}
+	if(0 != cmap.header.version){
+		FontValidation_addError(validation, "cmap: version %u", cmap.header.version);
+	}
+	for(size_t i = 0; i < cmap.header.numTables; i++){
+		uint16_t format;
+		error = FontParseCmap_subtableFormat(&cmap, i, &format);
+		if(FontParseError_None != error){
+			FontValidation_addError(validation, "cmap subtable %zu: offset %"PRIu32" %s",
+					i, cmap.encodingRecords[i].offset, FontParseError_toString(error));
+			continue;
+		}
+		if(4 == format){
+			FontValidator_cmapFormat4_inline_(&cmap, i, validation);
+			continue;
+		}
+		// その他の形式は引く表を実際に作って読めることを確かめる
+		FontSpan subtable;
+		FontSpan_sub(cmap.table, cmap.encodingRecords[i].offset, cmap.table.size - cmap.encodingRecords[i].offset, &subtable);
+		CmapPageTable table;
+		error = CmapPageTable_build(&table, subtable, numGlyphs);
+		if(FontParseError_None != error && FontParseError_Unsupported != error){
+			FontValidation_addError(validation, "cmap subtable %zu format %u: %s", i, format, FontParseError_toString(error));
+		}
+		CmapPageTable_free(&table);
+	}
+	FontParseCmap_free(&cmap);
+}
+
+void FontValidator_glyf_inline_(const FontParser *parser, const HeadTable *head, uint16_t numGlyphs, FontValidation *validation)
+{
+	FontSpan glyf;
+	FontParseError error = FontParser_table(parser, "glyf", &glyf);
+	if(FontParseError_NotFound == error){
+		return; // CFF outline
+	}
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "glyf: %s", FontParseError_toString(error));
+		return;
+	}
+	FontParseLoca loca;
+	error = FontParser_loca(parser, head->indexToLocFormat, numGlyphs, &loca);
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "loca: %s", FontParseError_toString(error));
+		FontParseLoca_free(&loca);
+		return;
+	}
+	FontParseGlyph glyph = {0};
+	FontParseGlyphResolver resolver = {0}; // composite glyphの部品の展開(循環・深すぎる参照を検出する)
+	for(size_t glyphId = 0; glyphId < numGlyphs; glyphId++){
+		const uint32_t offset = loca.offsets[glyphId];
+		const uint32_t nextOffset = loca.offsets[glyphId + 1];
+		if(nextOffset < offset){
+			FontValidation_addError(validation, "loca: glyph %zu offset %"PRIu32" > next %"PRIu32, glyphId, offset, nextOffset);
+			continue;
+		}
+		if(glyf.size < nextOffset){
+			FontValidation_addError(validation, "loca: glyph %zu end %"PRIu32" beyond glyf (%zu)", glyphId, nextOffset, glyf.size);
+			continue;
+		}
+		error = FontParser_glyph(glyf, offset, nextOffset, &glyph);
+		if(FontParseError_Unsupported == error){
+			if(NULL == resolver.outlines){
+				FontParseGlyphResolver_init(&resolver, parser, head->indexToLocFormat, numGlyphs);
+			}
+			const FontParseOutline *outline;
+			error = FontParseGlyphResolver_outline(&resolver, glyphId, &outline);
+			if(FontParseError_None != error){
+				FontValidation_addError(validation, "glyf: composite glyph %zu: %s", glyphId, FontParseError_toString(error));
+			}
+		}else if(FontParseError_None != error){
+			FontValidation_addError(validation, "glyf: glyph %zu: %s", glyphId, FontParseError_toString(error));
+		}
+	}
+	FontParseGlyphResolver_free(&resolver);
+	FontParseGlyph_free(&glyph);
+	FontParseLoca_free(&loca);
+}
+
+/** @brief メモリ上のフォントを検査し、エラーをvalidationへ追加する。
+  data[size]は呼び出し側で保持する。validationは初期化済み({0})のものを渡す。
+  */
+void FontValidator_validateData(const uint8_t *data, size_t size, FontValidation *validation)
+{
+	FontParser parser;
+	FontParseError error = FontParser_init(&parser, data, size);
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "offset table: %s (file %zu)", FontParseError_toString(error), size);
+		FontParser_free(&parser);
+		return;
+	}
+	const uint32_t sfntVersion = parser.offsetTable.sfntVersion;
+	if(! (0x00010000 == sfntVersion || 0x4F54544F == sfntVersion || 0x74727565 == sfntVersion)){
+		FontValidation_addError(validation, "offset table: unknown sfntVersion 0x%08"PRIX32, sfntVersion);
+	}
+	FontValidator_tableDirectory_inline_(&parser, validation);
+	FontValidator_checksum_inline_(&parser, validation);
+
+	// ** head, maxp
+	HeadTable head;
+	error = FontParser_head(&parser, &head);
+	if(FontParseError_None != error){
+		FontValidation_addError(validation, "head: %s", FontParseError_toString(error));
+	}else{
+		if(0x5F0F3CF5 != head.magicNumber){
+			FontValidation_addError(validation, "head: magicNumber 0x%08"PRIX32, head.magicNumber);
+		}
+		if(! (16 <= head.unitsPerEm && head.unitsPerEm <= 16384)){
+			FontValidation_addError(validation, "head: unitsPerEm %u", head.unitsPerEm);
+		}
+		if(! (0 == head.indexToLocFormat || 1 == head.indexToLocFormat)){
+			FontValidation_addError(validation, "head: indexToLocFormat %d", head.indexToLocFormat);
+		}
+	}
+	MaxpTable_Version05 maxp;
+	const FontParseError maxpError = FontParser_maxp(&parser, &maxp);
+	if(FontParseError_None != maxpError){
+		FontValidation_addError(validation, "maxp: %s", FontParseError_toString(maxpError));
+	}
+
+	// ** cmap, loca/glyf
+	FontValidator_cmap_inline_(&parser, maxp.numGlyphs, validation);
+	if(FontParseError_None == error && FontParseError_None == maxpError){
+		FontValidator_glyf_inline_(&parser, &head, maxp.numGlyphs, validation);
+	}
+
+	FontParser_free(&parser);
+}
+
+//! @return false: ファイルを開けない(errorとして追加済み)
+bool FontValidator_validateFile(const char *filepath, FontValidation *validation)
+{
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	FontFile file;
+	const bool isOpened = FontFile_open(&file, filepath);
+	if(! isOpened){
+		FontValidation_addError(validation, "open: %d %s", errno, strerror(errno));
+	}else{
+		// WOFF, WOFF2は展開したsfntを検査する(並列はファイル単位なので展開は1thread)
+		const FontParseError error = FontWoff_decodeFile(&file, 1);
+		if(FontParseError_None != error){
+			FontValidation_addError(validation, "woff: %s", FontParseError_toString(error));
+		}else{
+			FontValidator_validateData(file.data, file.size, validation);
+		}
+		FontFile_close(&file);
+	}
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	validation->elapsedMs = ((double)(end.tv_sec - begin.tv_sec) * 1e3) + ((double)(end.tv_nsec - begin.tv_nsec) / 1e6);
+	return isOpened;
+}
+
+#endif // #ifndef DAISYFF_FONT_VALIDATOR_HPP_
@@ -0,0 +1,812 @@
+/**
+  @file
+  @brief WOFF, WOFF2のフォントをメモリ上のsfntへ展開する(daisydumpの入力)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  展開したsfntのTableは4byte境界で並べ、TableDirectoryはTag順に書く。
+  WOFFはTable毎にzlibで圧縮されているので、Table毎にWorkStealingPoolで並列に展開する。
+  Tableのbyte列とchecksumは元のまま(元のsfntを復元できたかをchecksumで確かめられる)。
+  WOFF2は全Tableが1つのbrotli streamなので展開は1thread。
+  変換された'glyf', 'loca', 'hmtx'は元の形式へ組み立て直し、checksumとcheckSumAdjustmentを計算し直す。
+  フォントコレクション('ttcf')は未対応。
+ */
+#ifndef DAISYFF_FONT_WOFF_HPP_
+#define DAISYFF_FONT_WOFF_HPP_
+
+#include "src/FontFile.h"
+#include "src/FontParser.h"
+#include "src/FontChecksum.h"
+#include "src/WorkStealingPool.h"
+#include <zlib.h>
+#include <brotli/decode.h>
+
+#define FontWoff_SFNT_SIZE_MAX		(1024 * 1024 * 1024)	//!< 展開後のsfntの大きさの上限(壊れた・悪意のあるファイル対策)
+#define FontWoff_PARALLEL_MIN_SIZE	(256 * 1024)		//!< 展開後の合計がこれより小さいWOFFはthreadを起こさない
+
+enum{
+	FontWoffFormat_NONE = 0,	//!< sfnt(またはその他)
+	FontWoffFormat_WOFF,
+	FontWoffFormat_WOFF2,
+};
+typedef int FontWoffFormat;
+
+FontWoffFormat FontWoff_format(const uint8_t *data, size_t size)
+{
+	if(size < 4){
+		return FontWoffFormat_NONE;
+	}
+	const uint32_t signature = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+	switch(signature){
+	case 0x774F4646: return FontWoffFormat_WOFF;	// 'wOFF'
+	case 0x774F4632: return FontWoffFormat_WOFF2;	// 'wOF2'
+	default: return FontWoffFormat_NONE;
+	}
+}
+
+// ** sfntの組み立て
+
+enum{
+	FontWoffTag_GLYF	= 0x676C7966,
+	FontWoffTag_LOCA	= 0x6C6F6361,
+	FontWoffTag_HMTX	= 0x686D7478,
+	FontWoffTag_HHEA	= 0x68686561,
+	FontWoffTag_HEAD	= 0x68656164,
+};
+
+size_t FontWoff_pad4_inline_(size_t size)
+{
+	return (size + 3) & ~(size_t)3;
+}
+
+void FontWoff_put16_inline_(uint8_t *p, uint16_t value)
+{
+	p[0] = (uint8_t)(value >> 8);
+	p[1] = (uint8_t)value;
+}
+
+void FontWoff_put32_inline_(uint8_t *p, uint32_t value)
+{
+	FontWoff_put16_inline_(&p[0], (uint16_t)(value >> 16));
+	FontWoff_put16_inline_(&p[2], (uint16_t)value);
+}
+
+int FontWoff_compareMember_inline_(const void *a, const void *b)
+{
+	const uint32_t ta = ((const TableDirectory_Member *)a)->tag;
+	const uint32_t tb = ((const TableDirectory_Member *)b)->tag;
+	return (ta < tb)? -1 : ((tb < ta)? 1 : 0);
+}
+
+//! @brief OffsetTableとTag順のTableDirectoryをsfnt先頭へ書く(tablesは並べ替える)
+void FontWoff_writeDirectory_inline_(uint8_t *sfnt, uint32_t flavor, TableDirectory_Member *tables, size_t numTables)
+{
+	uint16_t entrySelector = 0;
+	while((2u << entrySelector) <= numTables){
+		entrySelector++;
+	}
+	const uint16_t searchRange = (uint16_t)(16u << entrySelector);
+	FontWoff_put32_inline_(&sfnt[0], flavor);
+	FontWoff_put16_inline_(&sfnt[4], (uint16_t)numTables);
+	FontWoff_put16_inline_(&sfnt[6], searchRange);
+	FontWoff_put16_inline_(&sfnt[8], entrySelector);
+	FontWoff_put16_inline_(&sfnt[10], (uint16_t)((numTables * 16) - searchRange));
+	qsort(tables, numTables, sizeof(TableDirectory_Member), FontWoff_compareMember_inline_);
+	for(size_t i = 0; i < numTables; i++){
+		uint8_t *p = &sfnt[12 + (16 * i)];
+		FontWoff_put32_inline_(&p[0], tables[i].tag);
+		FontWoff_put32_inline_(&p[4], tables[i].checkSum);
+		FontWoff_put32_inline_(&p[8], tables[i].offset);
+		FontWoff_put32_inline_(&p[12], tables[i].length);
+	}
+}
+
+/** @brief 組み立てたsfntの'head'.checkSumAdjustmentを計算し直す。
+  Tableの並びは元のsfntと同じとは限らない(WOFFは元の配置を持たない)ので、元の値は使えない。
+  */
+void FontWoff_adjust_inline_(uint8_t *sfnt, size_t sfntSize, const TableDirectory_Member *head)
+{
+	if(NULL == head || head->length < FontChecksum_ADJUSTMENT_OFFSET + 4){
+		return;
+	}
+	uint8_t *adjustment = &sfnt[head->offset + FontChecksum_ADJUSTMENT_OFFSET];
+	FontWoff_put32_inline_(adjustment, 0);
+	FontWoff_put32_inline_(adjustment, FontChecksum_MAGIC - FontChecksum_sum(sfnt, sfntSize, 0));
+}
+
+// ** WOFF
+
+#define FontWoff_HEADER_SIZE		(44)
+
+typedef struct{
+	uint32_t		tag;
+	FontSpan		compressed;
+	uint32_t		origLength;
+	uint32_t		origChecksum;
+	uint32_t		sfntOffset;
+}FontWoffEntry;
+
+typedef struct{
+	const FontWoffEntry	*entries;
+	uint8_t			*sfnt;
+	uint8_t			*errors;	//!< [numTables] FontParseError
+}FontWoffContext;
+
+void FontWoff_task_inline_(void *context_, size_t index, size_t workerIndex)
+{
+	FontWoffContext *context = (FontWoffContext *)context_;
+	const FontWoffEntry *entry = &context->entries[index];
+	uint8_t *dst = &context->sfnt[entry->sfntOffset];
+	if(entry->compressed.size == entry->origLength){
+		memcpy(dst, entry->compressed.data, entry->origLength);
+		return;
+	}
+	uLongf length = entry->origLength;
+	const int ret = uncompress(dst, &length, entry->compressed.data, entry->compressed.size);
+	if(Z_OK != ret || length != entry->origLength){
+		context->errors[index] = FontParseError_InvalidValue;
+	}
+}
+
+FontParseError FontWoff_decodeWoff_inline_(FontSpan woff, size_t threadNum, uint8_t **pSfnt, size_t *pSfntSize)
+{
+	FontSpanReader reader = FontSpanReader_init(woff, 4);
+	const uint32_t flavor		= FontSpanReader_uint32(&reader);
+	const uint32_t length		= FontSpanReader_uint32(&reader);
+	const uint16_t numTables	= FontSpanReader_uint16(&reader);
+	if(reader.isOverrun || woff.size < FontWoff_HEADER_SIZE || woff.size < length){
+		return FontParseError_OutOfRange;
+	}
+	if(0 == numTables){
+		return FontParseError_InvalidValue;
+	}
+
+	FontWoffEntry *entries = (FontWoffEntry *)ffmalloc(sizeof(FontWoffEntry) * numTables);
+	FontParseError error = FontParseError_None;
+	size_t sfntSize = 12 + (16 * (size_t)numTables);
+	size_t origSize = 0;
+	reader.offset = FontWoff_HEADER_SIZE;
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		FontWoffEntry *entry = &entries[i];
+		entry->tag			= FontSpanReader_uint32(&reader);
+		const uint32_t offset		= FontSpanReader_uint32(&reader);
+		const uint32_t compLength	= FontSpanReader_uint32(&reader);
+		entry->origLength		= FontSpanReader_uint32(&reader);
+		entry->origChecksum		= FontSpanReader_uint32(&reader);
+		entry->sfntOffset		= (uint32_t)sfntSize;
+		if(reader.isOverrun){
+			error = FontParseError_OutOfRange;
+		}else if(entry->origLength < compLength){
+			error = FontParseError_InvalidValue;
+		}else{
+			error = FontSpan_sub(woff, offset, compLength, &entry->compressed);
+		}
+		sfntSize += FontWoff_pad4_inline_(entry->origLength);
+		origSize += entry->origLength;
+		if(FontWoff_SFNT_SIZE_MAX < sfntSize){
+			error = FontParseError_InvalidValue;
+		}
+	}
+	if(FontParseError_None != error){
+		free(entries);
+		return error;
+	}
+	uint8_t *sfnt = (uint8_t *)ffmalloc(sfntSize);
+	TableDirectory_Member *tables = (TableDirectory_Member *)ffmalloc(sizeof(TableDirectory_Member) * numTables);
+	for(size_t i = 0; i < numTables; i++){
+		tables[i] = (TableDirectory_Member){entries[i].tag, entries[i].origChecksum, entries[i].sfntOffset, entries[i].origLength};
+	}
+	FontWoff_writeDirectory_inline_(sfnt, flavor, tables, numTables);
+
+	FontWoffContext context = {
+		.entries	= entries,
+		.sfnt		= sfnt,
+		.errors		= (uint8_t *)ffmalloc(numTables),
+	};
+	WorkStealingPool_run(numTables, (origSize < FontWoff_PARALLEL_MIN_SIZE)? 1 : threadNum, FontWoff_task_inline_, &context);
+	const TableDirectory_Member *head = NULL;
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		error = context.errors[i];
+		head = (FontWoffTag_HEAD == tables[i].tag)? &tables[i] : head;
+	}
+	if(FontParseError_None == error){
+		FontWoff_adjust_inline_(sfnt, sfntSize, head);
+	}
+	free(tables);
+	free(context.errors);
+	free(entries);
+	if(FontParseError_None != error){
+		free(sfnt);
+		return error;
+	}
+	*pSfnt = sfnt;
+	*pSfntSize = sfntSize;
+	return FontParseError_None;
+}
+
+// ** WOFF2
+
+#define FontWoff2_HEADER_SIZE		(48)
+#define FontWoff2_GLYF_HEADER_SIZE	(36)
+
+//! flagsの下位6bitで指すTag(63: Tagを直後に持つ)
+const char fontWoff2KnownTags[63][5] = {
+	"cmap", "head", "hhea", "hmtx", "maxp", "name", "OS/2", "post",
+	"cvt ", "fpgm", "glyf", "loca", "prep", "CFF ", "VORG", "EBDT",
+	"EBLC", "gasp", "hdmx", "kern", "LTSH", "PCLT", "VDMX", "vhea",
+	"vmtx", "BASE", "GDEF", "GPOS", "GSUB", "EBSC", "JSTF", "MATH",
+	"CBDT", "CBLC", "COLR", "CPAL", "SVG ", "sbix", "acnt", "avar",
+	"bdat", "bloc", "bsln", "cvar", "fdsc", "feat", "fmtx", "fvar",
+	"gvar", "hsty", "just", "lcar", "mort", "morx", "opbd", "prop",
+	"trak", "Zapf", "Silf", "Glat", "Gloc", "Feat", "Sill",
+};
+
+uint32_t FontWoff2_knownTag_inline_(uint8_t index)
+{
+	const char *tag = fontWoff2KnownTags[index];
+	return ((uint32_t)(uint8_t)tag[0] << 24) | ((uint32_t)(uint8_t)tag[1] << 16) | ((uint32_t)(uint8_t)tag[2] << 8) | (uint8_t)tag[3];
+}
+
+typedef struct{
+	uint32_t		tag;
+	bool			isTransformed;
+	uint32_t		origLength;
+	FontSpan		source;		//!< 展開したstream上(変換されたTableは変換後の形式)
+	FontSpan		table;		//!< 組み立て後のTable
+}FontWoff2Entry;
+
+//! @brief 可変長の整数(UIntBase128)を読む @return false: 不正・範囲外
+bool FontWoff2_base128_inline_(FontSpanReader *reader, uint32_t *value)
+{
+	uint32_t acc = 0;
+	for(int i = 0; i < 5; i++){
+		const uint8_t b = FontSpanReader_uint8(reader);
+		if(reader->isOverrun || (0 == i && 0x80 == b) || 0 != (acc & 0xFE000000)){
+			return false;
+		}
+		acc = (acc << 7) | (b & 0x7F);
+		if(0 == (b & 0x80)){
+			*value = acc;
+			return true;
+		}
+	}
+	return false;
+}
+
+//! @brief 可変長の整数(255UInt16)を読む
+uint16_t FontWoff2_uint255_inline_(FontSpanReader *reader)
+{
+	const uint8_t code = FontSpanReader_uint8(reader);
+	switch(code){
+	case 253:
+		return FontSpanReader_uint16(reader);
+	case 254:
+		return (uint16_t)((253 * 2) + FontSpanReader_uint8(reader));
+	case 255:
+		return (uint16_t)(253 + FontSpanReader_uint8(reader));
+	default:
+		return code;
+	}
+}
+
+//! @brief readerから[size]byteを取り出す
+bool FontWoff2_bytes_inline_(FontSpanReader *reader, size_t size, FontSpan *span)
+{
+	if(FontParseError_None != FontSpan_sub((FontSpan){reader->data, reader->size}, reader->offset, size, span)){
+		reader->isOverrun = true;
+		return false;
+	}
+	reader->offset += size;
+	return true;
+}
+
+// *** 変換された'glyf'
+
+typedef struct{
+	FontSpanReader		nContour;
+	FontSpanReader		nPoints;
+	FontSpanReader		flag;
+	FontSpanReader		glyph;
+	FontSpanReader		composite;
+	FontSpanReader		bbox;
+	FontSpanReader		instruction;
+	FontSpan		bboxBitmap;
+	FontSpan		overlapBitmap;	//!< {NULL, 0}: 無い
+	// 点の作業領域(glyph毎に使い回す)
+	int32_t			*xs;
+	int32_t			*ys;
+	uint8_t			*flags;
+	size_t			pointCapacity;
+}FontWoff2Glyf;
+
+bool FontWoff2_bit_inline_(FontSpan bitmap, size_t index)
+{
+	return (index >> 3) < bitmap.size && 0 != (bitmap.data[index >> 3] & (0x80 >> (index & 7)));
+}
+
+int32_t FontWoff2_withSign_inline_(uint8_t flag, int32_t value)
+{
+	return (0 != (flag & 1))? value : -value;
+}
+
+/** @brief 点のflagの下位7bitが示す形式(triplet encoding)で座標の差分を読む。
+  @return false: glyph streamが足りない
+  */
+bool FontWoff2_triplet_inline_(FontSpanReader *glyph, uint8_t flag, int32_t *dx, int32_t *dy)
+{
+	const size_t size = (flag < 84)? 1 : ((flag < 120)? 2 : ((flag < 124)? 3 : 4));
+	FontSpan span;
+	if(! FontWoff2_bytes_inline_(glyph, size, &span)){
+		return false;
+	}
+	const uint8_t *in = span.data;
+	if(flag < 10){
+		*dx = 0;
+		*dy = FontWoff2_withSign_inline_(flag, ((flag & 14) << 7) + in[0]);
+	}else if(flag < 20){
+		*dx = FontWoff2_withSign_inline_(flag, (((flag - 10) & 14) << 7) + in[0]);
+		*dy = 0;
+	}else if(flag < 84){
+		const int32_t b0 = flag - 20;
+		*dx = FontWoff2_withSign_inline_(flag, 1 + (b0 & 0x30) + (in[0] >> 4));
+		*dy = FontWoff2_withSign_inline_(flag >> 1, 1 + ((b0 & 0x0C) << 2) + (in[0] & 0x0F));
+	}else if(flag < 120){
+		const int32_t b0 = flag - 84;
+		*dx = FontWoff2_withSign_inline_(flag, 1 + ((b0 / 12) << 8) + in[0]);
+		*dy = FontWoff2_withSign_inline_(flag >> 1, 1 + (((b0 % 12) >> 2) << 8) + in[1]);
+	}else if(flag < 124){
+		*dx = FontWoff2_withSign_inline_(flag, (in[0] << 4) + (in[1] >> 4));
+		*dy = FontWoff2_withSign_inline_(flag >> 1, ((in[1] & 0x0F) << 8) + in[2]);
+	}else{
+		*dx = FontWoff2_withSign_inline_(flag, (in[0] << 8) + in[1]);
+		*dy = FontWoff2_withSign_inline_(flag >> 1, (in[2] << 8) + in[3]);
+	}
+	return true;
+}
+
+//! @brief 命令の長さをglyph streamから、命令をinstruction streamから読んで書く
+bool FontWoff2Glyf_instructions_inline_(FontWoff2Glyf *streams, FFByteWriter *glyf)
+{
+	const uint16_t instructionLength = FontWoff2_uint255_inline_(&streams->glyph);
+	FontSpan instructions;
+	if(streams->glyph.isOverrun || ! FontWoff2_bytes_inline_(&streams->instruction, instructionLength, &instructions)){
+		return false;
+	}
+	FFByteWriter_uint16(glyf, instructionLength);
+	FFByteWriter_bytes(glyf, instructions.data, instructionLength);
+	return true;
+}
+
+FontParseError FontWoff2Glyf_composite_inline_(FontWoff2Glyf *streams, size_t glyphId, FFByteWriter *glyf, int16_t *xMin)
+{
+	FontSpan bbox;
+	if(! FontWoff2_bit_inline_(streams->bboxBitmap, glyphId)){
+		return FontParseError_InvalidValue; // composite glyphはbounding boxを必ず持つ
+	}
+	if(! FontWoff2_bytes_inline_(&streams->bbox, 8, &bbox)){
+		return FontParseError_OutOfRange;
+	}
+	// 部品の並びの長さを調べる
+	FontSpanReader *composite = &streams->composite;
+	const size_t begin = composite->offset;
+	bool hasInstructions = false;
+	uint16_t flags;
+	do{
+		flags = FontSpanReader_uint16(composite);
+		composite->offset += 2; // glyphIndex
+		composite->offset += (0 != (flags & ComponentFlag_ARG_1_AND_2_ARE_WORDS))? 4 : 2;
+		if(0 != (flags & ComponentFlag_WE_HAVE_A_SCALE)){
+			composite->offset += 2;
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE)){
+			composite->offset += 4;
+		}else if(0 != (flags & ComponentFlag_WE_HAVE_A_TWO_BY_TWO)){
+			composite->offset += 8;
+		}
+		hasInstructions = hasInstructions || (0 != (flags & ComponentFlag_WE_HAVE_INSTRUCTIONS));
+	}while(! composite->isOverrun && 0 != (flags & ComponentFlag_MORE_COMPONENTS));
+	if(composite->isOverrun || composite->size < composite->offset){
+		return FontParseError_OutOfRange;
+	}
+
+	FFByteWriter_uint16(glyf, 0xFFFF);
+	FFByteWriter_bytes(glyf, bbox.data, 8);
+	FFByteWriter_bytes(glyf, &composite->data[begin], composite->offset - begin);
+	if(hasInstructions && ! FontWoff2Glyf_instructions_inline_(streams, glyf)){
+		return FontParseError_OutOfRange;
+	}
+	*xMin = (int16_t)((bbox.data[0] << 8) | bbox.data[1]);
+	return FontParseError_None;
+}
+
+FontParseError FontWoff2Glyf_simple_inline_(FontWoff2Glyf *streams, size_t glyphId, uint16_t numberOfContours, FFByteWriter *glyf, int16_t *xMin)
+{
+	// 輪郭毎の点数
+	const size_t headerOffset = glyf->length;
+	FFByteWriter_extend(glyf, 10);
+	size_t pointNum = 0;
+	for(size_t c = 0; c < numberOfContours; c++){
+		pointNum += FontWoff2_uint255_inline_(&streams->nPoints);
+		if(streams->nPoints.isOverrun || 0 == pointNum || 0x10000 < pointNum){
+			return streams->nPoints.isOverrun ? FontParseError_OutOfRange : FontParseError_InvalidValue;
+		}
+		FFByteWriter_uint16(glyf, (uint16_t)(pointNum - 1));
+	}
+	if(streams->pointCapacity < pointNum){
+		streams->pointCapacity = pointNum;
+		streams->xs = (int32_t *)ffrealloc(streams->xs, sizeof(int32_t) * pointNum);
+		streams->ys = (int32_t *)ffrealloc(streams->ys, sizeof(int32_t) * pointNum);
+		streams->flags = (uint8_t *)ffrealloc(streams->flags, pointNum);
+	}
+
+	// 点: flag streamの1byte(最上位bit: off curve)とglyph streamの差分
+	int32_t x = 0;
+	int32_t y = 0;
+	int32_t bounds[4] = {INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN};
+	for(size_t i = 0; i < pointNum; i++){
+		const uint8_t flag = FontSpanReader_uint8(&streams->flag);
+		int32_t dx;
+		int32_t dy;
+		if(streams->flag.isOverrun || ! FontWoff2_triplet_inline_(&streams->glyph, flag & 0x7F, &dx, &dy)){
+			return FontParseError_OutOfRange;
+		}
+		x += dx;
+		y += dy;
+		streams->xs[i] = dx;
+		streams->ys[i] = dy;
+		bounds[0] = (x < bounds[0])? x : bounds[0];
+		bounds[1] = (y < bounds[1])? y : bounds[1];
+		bounds[2] = (bounds[2] < x)? x : bounds[2];
+		bounds[3] = (bounds[3] < y)? y : bounds[3];
+		// glyfのflag: on curve, short vector(符号をsameビットで表す), 0はsame
+		uint8_t glyfFlag = (0 == (flag & 0x80))? 0x01 : 0x00;
+		glyfFlag |= (0 == dx)? 0x10 : ((-256 < dx && dx < 256)? (0x02 | ((0 < dx)? 0x10 : 0)) : 0);
+		glyfFlag |= (0 == dy)? 0x20 : ((-256 < dy && dy < 256)? (0x04 | ((0 < dy)? 0x20 : 0)) : 0);
+		if(0 == i && FontWoff2_bit_inline_(streams->overlapBitmap, glyphId)){
+			glyfFlag |= 0x40; // OVERLAP_SIMPLE
+		}
+		streams->flags[i] = glyfFlag;
+	}
+	if(! FontWoff2Glyf_instructions_inline_(streams, glyf)){
+		return FontParseError_OutOfRange;
+	}
+
+	// flag(同じflagの連続はREPEATでまとめる), x, y
+	for(size_t i = 0; i < pointNum; ){
+		size_t run = 1;
+		while(i + run < pointNum && run < 256 && streams->flags[i + run] == streams->flags[i]){
+			run++;
+		}
+		if(1 < run){
+			FFByteWriter_uint8(glyf, streams->flags[i] | 0x08);
+			FFByteWriter_uint8(glyf, (uint8_t)(run - 1));
+		}else{
+			FFByteWriter_uint8(glyf, streams->flags[i]);
+		}
+		i += run;
+	}
+	for(int axis = 0; axis < 2; axis++){
+		const int32_t *deltas = (0 == axis)? streams->xs : streams->ys;
+		const uint8_t shortBit = (0 == axis)? 0x02 : 0x04;
+		const uint8_t sameBit = (0 == axis)? 0x10 : 0x20;
+		for(size_t i = 0; i < pointNum; i++){
+			const uint8_t flag = streams->flags[i];
+			if(0 != (flag & shortBit)){
+				FFByteWriter_uint8(glyf, (uint8_t)((deltas[i] < 0)? -deltas[i] : deltas[i]));
+			}else if(0 == (flag & sameBit)){
+				FFByteWriter_uint16(glyf, (uint16_t)(int16_t)deltas[i]);
+			}
+		}
+	}
+
+	// bounding box: 明示されていなければ点から求める
+	int16_t bbox[4];
+	if(FontWoff2_bit_inline_(streams->bboxBitmap, glyphId)){
+		for(int i = 0; i < 4; i++){
+			bbox[i] = (int16_t)FontSpanReader_uint16(&streams->bbox);
+		}
+		if(streams->bbox.isOverrun){
+			return FontParseError_OutOfRange;
+		}
+	}else{
+		for(int i = 0; i < 4; i++){
+			bbox[i] = (int16_t)bounds[i];
+		}
+	}
+	uint8_t *header = &glyf->data[headerOffset];
+	FontWoff_put16_inline_(&header[0], numberOfContours);
+	for(int i = 0; i < 4; i++){
+		FontWoff_put16_inline_(&header[2 + (2 * i)], (uint16_t)bbox[i]);
+	}
+	*xMin = bbox[0];
+	return FontParseError_None;
+}
+
+/** @brief 変換された'glyf'から'glyf'と'loca'を組み立てる。
+  @param xMins [numGlyphs] glyph毎のxMin('hmtx'の組み立てに使う。ffmalloc)
+  */
+FontParseError FontWoff2_glyf_inline_(FontSpan transformed, FFByteWriter *glyf, FFByteWriter *loca, int16_t **xMins, size_t *pNumGlyphs)
+{
+	FontSpanReader reader = FontSpanReader_init(transformed, 2);
+	const uint16_t optionFlags	= FontSpanReader_uint16(&reader);
+	const uint16_t numGlyphs	= FontSpanReader_uint16(&reader);
+	const uint16_t indexFormat	= FontSpanReader_uint16(&reader);
+	FontWoff2Glyf streams = {0};
+	FontSpanReader *readers[] = {
+		&streams.nContour, &streams.nPoints, &streams.flag, &streams.glyph,
+		&streams.composite, &streams.bbox, &streams.instruction,
+	};
+	size_t offset = FontWoff2_GLYF_HEADER_SIZE;
+	for(size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); i++){
+		const uint32_t size = FontSpanReader_uint32(&reader);
+		FontSpan stream;
+		if(reader.isOverrun || FontParseError_None != FontSpan_sub(transformed, offset, size, &stream)){
+			return FontParseError_OutOfRange;
+		}
+		*readers[i] = FontSpanReader_init(stream, 0);
+		offset += size;
+	}
+	if(! FontWoff2_bytes_inline_(&streams.bbox, ((numGlyphs + 31) >> 5) << 2, &streams.bboxBitmap)){
+		return FontParseError_OutOfRange;
+	}
+	if(0 != (optionFlags & 0x0001)
+			&& FontParseError_None != FontSpan_sub(transformed, offset, (numGlyphs + 7) >> 3, &streams.overlapBitmap)){
+		return FontParseError_OutOfRange;
+	}
+
+	*xMins = (int16_t *)ffmalloc(sizeof(int16_t) * (numGlyphs + 1));
+	uint32_t *offsets = (uint32_t *)ffmalloc(sizeof(uint32_t) * (numGlyphs + 1));
+	FontParseError error = FontParseError_None;
+	for(size_t glyphId = 0; glyphId < numGlyphs && FontParseError_None == error; glyphId++){
+		offsets[glyphId] = (uint32_t)glyf->length;
+		const int16_t numberOfContours = (int16_t)FontSpanReader_uint16(&streams.nContour);
+		if(streams.nContour.isOverrun){
+			error = FontParseError_OutOfRange;
+		}else if(0 == numberOfContours){
+			// 空glyphはbounding boxを持たない
+			error = FontWoff2_bit_inline_(streams.bboxBitmap, glyphId)? FontParseError_InvalidValue : FontParseError_None;
+		}else if(numberOfContours < 0){
+			error = FontWoff2Glyf_composite_inline_(&streams, glyphId, glyf, &(*xMins)[glyphId]);
+		}else{
+			error = FontWoff2Glyf_simple_inline_(&streams, glyphId, (uint16_t)numberOfContours, glyf, &(*xMins)[glyphId]);
+		}
+		const size_t padding = FontWoff_pad4_inline_(glyf->length) - glyf->length;
+		memset(FFByteWriter_extend(glyf, padding), 0, padding);
+	}
+	offsets[numGlyphs] = (uint32_t)glyf->length;
+	free(streams.xs);
+	free(streams.ys);
+	free(streams.flags);
+
+	const bool isShort = (0 == indexFormat);
+	if(FontParseError_None == error && isShort && 0x20000 < glyf->length){
+		error = FontParseError_InvalidValue;
+	}
+	for(size_t i = 0; i <= numGlyphs && FontParseError_None == error; i++){
+		if(isShort){
+			FFByteWriter_uint16(loca, (uint16_t)(offsets[i] / 2));
+		}else{
+			FFByteWriter_uint32(loca, offsets[i]);
+		}
+	}
+	free(offsets);
+	*pNumGlyphs = numGlyphs;
+	return error;
+}
+
+// *** 変換された'hmtx'
+
+//! @brief 省略されたleftSideBearingを'glyf'のxMinで補って'hmtx'を組み立てる
+FontParseError FontWoff2_hmtx_inline_(FontSpan transformed, const FontWoff2Entry *hhea, const int16_t *xMins, size_t numGlyphs, FFByteWriter *hmtx)
+{
+	FontSpanReader hheaReader = FontSpanReader_init(hhea->table, 34);
+	const size_t numberOfHMetrics = FontSpanReader_uint16(&hheaReader);
+	if(hheaReader.isOverrun || NULL == xMins || numGlyphs < numberOfHMetrics){
+		return FontParseError_InvalidValue;
+	}
+	FontSpanReader reader = FontSpanReader_init(transformed, 0);
+	const uint8_t flags = FontSpanReader_uint8(&reader);
+	if(0 != (flags & 0xFC) || 0 == (flags & 0x03)){
+		return FontParseError_InvalidValue;
+	}
+	FontSpanReader advances = reader;
+	reader.offset += 2 * numberOfHMetrics;
+	uint8_t *p = FFByteWriter_extend(hmtx, (4 * numberOfHMetrics) + (2 * (numGlyphs - numberOfHMetrics)));
+	for(size_t i = 0; i < numGlyphs; i++){
+		if(i < numberOfHMetrics){
+			FontWoff_put16_inline_(p, FontSpanReader_uint16(&advances));
+			p += 2;
+		}
+		const bool isOmitted = (0 != (flags & ((i < numberOfHMetrics)? 0x01 : 0x02)));
+		FontWoff_put16_inline_(p, isOmitted ? (uint16_t)xMins[i] : FontSpanReader_uint16(&reader));
+		p += 2;
+	}
+	return (reader.isOverrun || advances.isOverrun)? FontParseError_OutOfRange : FontParseError_None;
+}
+
+FontParseError FontWoff_decodeWoff2_inline_(FontSpan woff2, uint8_t **pSfnt, size_t *pSfntSize)
+{
+	FontSpanReader reader = FontSpanReader_init(woff2, 4);
+	const uint32_t flavor			= FontSpanReader_uint32(&reader);
+	const uint32_t length			= FontSpanReader_uint32(&reader);
+	const uint16_t numTables		= FontSpanReader_uint16(&reader);
+	reader.offset += 2 + 4; // reserved, totalSfntSize
+	const uint32_t totalCompressedSize	= FontSpanReader_uint32(&reader);
+	if(reader.isOverrun || woff2.size < FontWoff2_HEADER_SIZE || woff2.size < length){
+		return FontParseError_OutOfRange;
+	}
+	if(0x74746366 == flavor){ // 'ttcf'
+		return FontParseError_Unsupported;
+	}
+	if(0 == numTables){
+		return FontParseError_InvalidValue;
+	}
+
+	// ** TableDirectory
+	FontWoff2Entry *entries = (FontWoff2Entry *)ffmalloc(sizeof(FontWoff2Entry) * numTables);
+	FontParseError error = FontParseError_None;
+	size_t streamSize = 0;
+	reader.offset = FontWoff2_HEADER_SIZE;
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		FontWoff2Entry *entry = &entries[i];
+		const uint8_t flags = FontSpanReader_uint8(&reader);
+		const uint8_t tagIndex = flags & 0x3F;
+		const uint8_t transformVersion = flags >> 6;
+		entry->tag = (63 == tagIndex)? FontSpanReader_uint32(&reader) : FontWoff2_knownTag_inline_(tagIndex);
+		// glyf, locaは0が変換あり(3が無し)、その他は0が変換無し
+		const bool isGlyfOrLoca = (FontWoffTag_GLYF == entry->tag || FontWoffTag_LOCA == entry->tag);
+		entry->isTransformed = isGlyfOrLoca ? (3 != transformVersion) : (0 != transformVersion);
+		uint32_t sourceLength = 0;
+		if(! FontWoff2_base128_inline_(&reader, &entry->origLength)
+				|| (entry->isTransformed && ! FontWoff2_base128_inline_(&reader, &sourceLength))){
+			error = FontParseError_OutOfRange;
+			break;
+		}
+		if(! entry->isTransformed){
+			sourceLength = entry->origLength;
+		}
+		entry->source = (FontSpan){NULL, streamSize};	// 展開後に指し直す
+		entry->table = (FontSpan){NULL, sourceLength};
+		streamSize += sourceLength;
+		if(FontWoff_SFNT_SIZE_MAX < streamSize || FontWoff_SFNT_SIZE_MAX < entry->origLength){
+			error = FontParseError_InvalidValue;
+		}
+	}
+
+	// ** 全Tableのbrotli stream
+	uint8_t *stream = NULL;
+	FontSpan compressed;
+	if(FontParseError_None == error){
+		error = FontSpan_sub(woff2, reader.offset, totalCompressedSize, &compressed);
+	}
+	if(FontParseError_None == error){
+		stream = (uint8_t *)ffmalloc(streamSize + 1);
+		size_t decodedSize = streamSize;
+		if(BROTLI_DECODER_RESULT_SUCCESS != BrotliDecoderDecompress(compressed.size, compressed.data, &decodedSize, stream)
+				|| decodedSize != streamSize){
+			error = FontParseError_InvalidValue;
+		}
+	}
+
+	// ** 変換されたTableを組み立てる('glyf'の後に'loca', 'hmtx')
+	FFByteWriter glyf = {0};
+	FFByteWriter loca = {0};
+	FFByteWriter hmtx = {0};
+	int16_t *xMins = NULL;
+	size_t numGlyphs = 0;
+	const FontWoff2Entry *hhea = NULL;
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		FontWoff2Entry *entry = &entries[i];
+		entry->source = (FontSpan){&stream[entry->source.size], entry->table.size};
+		entry->table = entry->source;
+		hhea = (FontWoffTag_HHEA == entry->tag)? entry : hhea;
+		if(FontWoffTag_GLYF == entry->tag && entry->isTransformed){
+			error = FontWoff2_glyf_inline_(entry->source, &glyf, &loca, &xMins, &numGlyphs);
+			entry->table = (FontSpan){glyf.data, glyf.length};
+		}else if(entry->isTransformed && FontWoffTag_LOCA != entry->tag && FontWoffTag_HMTX != entry->tag){
+			error = FontParseError_Unsupported;
+		}
+	}
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		FontWoff2Entry *entry = &entries[i];
+		if(FontWoffTag_LOCA == entry->tag && entry->isTransformed){
+			entry->table = (FontSpan){loca.data, loca.length};
+			error = (NULL != xMins && loca.length == entry->origLength)? FontParseError_None : FontParseError_InvalidValue;
+		}else if(FontWoffTag_HMTX == entry->tag && entry->isTransformed){
+			error = (NULL == hhea)? FontParseError_InvalidValue
+				: FontWoff2_hmtx_inline_(entry->source, hhea, xMins, numGlyphs, &hmtx);
+			entry->table = (FontSpan){hmtx.data, hmtx.length};
+		}
+	}
+
+	// ** sfnt: Tableを並べ、checksumとcheckSumAdjustmentを計算し直す
+	uint8_t *sfnt = NULL;
+	size_t sfntSize = 12 + (16 * (size_t)numTables);
+	for(size_t i = 0; i < numTables && FontParseError_None == error; i++){
+		sfntSize += FontWoff_pad4_inline_(entries[i].table.size);
+		error = (FontWoff_SFNT_SIZE_MAX < sfntSize)? FontParseError_InvalidValue : FontParseError_None;
+	}
+	if(FontParseError_None == error){
+		sfnt = (uint8_t *)ffmalloc(sfntSize);
+		TableDirectory_Member *tables = (TableDirectory_Member *)ffmalloc(sizeof(TableDirectory_Member) * numTables);
+		size_t offset = 12 + (16 * (size_t)numTables);
+		for(size_t i = 0; i < numTables; i++){
+			const FontSpan table = entries[i].table;
+			if(0 < table.size){
+				memcpy(&sfnt[offset], table.data, table.size);
+			}
+			if(FontWoffTag_HEAD == entries[i].tag && FontChecksum_ADJUSTMENT_OFFSET + 4 <= table.size){
+				FontWoff_put32_inline_(&sfnt[offset + FontChecksum_ADJUSTMENT_OFFSET], 0); // 'head'のchecksumは0として計算する
+			}
+			tables[i] = (TableDirectory_Member){
+				.tag		= entries[i].tag,
+				.checkSum	= FontChecksum_sum(&sfnt[offset], table.size, 0),
+				.offset		= (uint32_t)offset,
+				.length		= (uint32_t)table.size,
+			};
+			offset += FontWoff_pad4_inline_(table.size);
+		}
+		FontWoff_writeDirectory_inline_(sfnt, flavor, tables, numTables);
+		const TableDirectory_Member *head = NULL;
+		for(size_t i = 0; i < numTables; i++){
+			head = (FontWoffTag_HEAD == tables[i].tag)? &tables[i] : head;
+		}
+		FontWoff_adjust_inline_(sfnt, sfntSize, head);
+		free(tables);
+	}
+
+	free(glyf.data);
+	free(loca.data);
+	free(hmtx.data);
+	free(xMins);
+	free(stream);
+	free(entries);
+	if(FontParseError_None != error){
+		return error;
+	}
+	*pSfnt = sfnt;
+	*pSfntSize = sfntSize;
+	return FontParseError_None;
+}
+
+// ** 入口
+
+/** @brief WOFF, WOFF2をsfntへ展開する。
+  @param threadNum WOFFのTableを展開するthread数(0: CPU数)
+  @param sfnt 展開したsfnt(ffmallocした領域。呼び出し側でfree()する)
+  @return FontParseError_Unsupported: WOFF, WOFF2ではない・フォントコレクション
+  */
+FontParseError FontWoff_decode(const uint8_t *data, size_t size, size_t threadNum, uint8_t **sfnt, size_t *sfntSize)
+{
+	*sfnt = NULL;
+	*sfntSize = 0;
+	switch(FontWoff_format(data, size)){
+	case FontWoffFormat_WOFF:
+		return FontWoff_decodeWoff_inline_((FontSpan){data, size}, threadNum, sfnt, sfntSize);
+	case FontWoffFormat_WOFF2:
+		return FontWoff_decodeWoff2_inline_((FontSpan){data, size}, sfnt, sfntSize);
+	default:
+		return FontParseError_Unsupported;
+	}
+}
+
+/** @brief fileがWOFF, WOFF2なら、展開したsfntを指すFontFileに置き換える(元のfileは閉じる)。
+  sfnt等その他の形式はそのまま。
+  @return エラーの場合fileはそのまま
+  */
+FontParseError FontWoff_decodeFile(FontFile *file, size_t threadNum)
+{
+	if(FontWoffFormat_NONE == FontWoff_format(file->data, file->size)){
+		return FontParseError_None;
+	}
+	uint8_t *sfnt;
+	size_t sfntSize;
+	const FontParseError error = FontWoff_decode(file->data, file->size, threadNum, &sfnt, &sfntSize);
+	if(FontParseError_None != error){
+		return error;
+	}
+	FontFile_close(file);
+	FontFile_openBuffer(file, sfnt, sfntSize);
+	return FontParseError_None;
+}
+
+#endif // #ifndef DAISYFF_FONT_WOFF_HPP_
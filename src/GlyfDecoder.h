@@ -0,0 +1,242 @@
+/**
+  @file
+  @brief simple glyphの座標(XYCoordinates)をflagの配列からdecodeするkernel。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  軸毎に次の3段で処理し、点毎の分岐を無くす。
+  1. flagから点毎の幅(short: 1, same: 0, long: 2 byte)を求め、その排他的累積和を各点の読み出し位置とする(SIMD)。
+  2. 読み出し位置から差分を集める(幅に依らず2byte読んでflagで選ぶ)。
+  3. 差分の累積和を絶対座標とする(SIMD)。
+  比較・検証用に点を順に読むscalar実装を持つ(結果は同じ)。
+ */
+#ifndef DAISYFF_GLYF_DECODER_HPP_
+#define DAISYFF_GLYF_DECODER_HPP_
+
+#include "src/Util.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DAISYFF_GLYF_DECODER_X86_SIMD
+#endif
+
+enum{
+	GlyfDecoder_FLAG_X_SHORT	= 0x02,
+	GlyfDecoder_FLAG_Y_SHORT	= 0x04,
+	GlyfDecoder_FLAG_X_SAME		= 0x10,	//!< short: 正の値 / long: 前の点と同じ(dataを持たない)
+	GlyfDecoder_FLAG_Y_SAME		= 0x20,
+};
+
+// ** scalar
+
+//! @return 読んだbyte数, SIZE_MAX: dataが足りない
+size_t GlyfDecoder_axisScalar_inline_(const uint8_t *data, size_t size, const uint8_t *flags, size_t pointNum,
+		uint8_t shortBit, uint8_t sameBit, int32_t *values)
+{
+	size_t offset = 0;
+	int32_t value = 0;
+	for(size_t i = 0; i < pointNum; i++){
+		if(0 != (flags[i] & shortBit)){
+			if(size < offset + 1){
+				return SIZE_MAX;
+			}
+			const int32_t delta = data[offset++];
+			value += (0 != (flags[i] & sameBit))? delta : -delta;
+		}else if(0 == (flags[i] & sameBit)){
+			if(size < offset + 2){
+				return SIZE_MAX;
+			}
+			value += (int16_t)((data[offset] << 8) | data[offset + 1]);
+			offset += 2;
+		}
+		values[i] = value;
+	}
+	return offset;
+}
+
+/** @brief 比較用のscalar実装。引数・結果はGlyfDecoder_coordinates()と同じ。
+  */
+bool GlyfDecoder_coordinatesScalar(const uint8_t *data, size_t size, const uint8_t *flags, size_t pointNum,
+		int32_t *xs, int32_t *ys, size_t *pUsed)
+{
+	const size_t xUsed = GlyfDecoder_axisScalar_inline_(
+			data, size, flags, pointNum, GlyfDecoder_FLAG_X_SHORT, GlyfDecoder_FLAG_X_SAME, xs);
+	if(SIZE_MAX == xUsed){
+		return false;
+	}
+	const size_t yUsed = GlyfDecoder_axisScalar_inline_(
+			&data[xUsed], size - xUsed, flags, pointNum, GlyfDecoder_FLAG_Y_SHORT, GlyfDecoder_FLAG_Y_SAME, ys);
+	if(SIZE_MAX == yUsed){
+		return false;
+	}
+	*pUsed = xUsed + yUsed;
+	return true;
+}
+
+// ** 幅 -> 読み出し位置 -> 差分 -> 累積和
+
+//! @return 点の幅(byte)
+int32_t GlyfDecoder_width_inline_(uint8_t flag, uint8_t shortBit, uint8_t sameBit)
+{
+	return (0 != (flag & shortBit))? 1 : ((0 != (flag & sameBit))? 0 : 2);
+}
+
+/** @brief values[i]へ点iの読み出し位置(幅の排他的累積和)を置く。
+  @return 全点の幅の合計
+  */
+size_t GlyfDecoder_offsetsScalar_inline_(const uint8_t *flags, size_t begin, size_t pointNum,
+		uint8_t shortBit, uint8_t sameBit, int32_t *values, size_t total)
+{
+	for(size_t i = begin; i < pointNum; i++){
+		values[i] = (int32_t)total;
+		total += (size_t)GlyfDecoder_width_inline_(flags[i], shortBit, sameBit);
+	}
+	return total;
+}
+
+//! @brief values[i](読み出し位置)を差分へ置き換える
+void GlyfDecoder_gatherDeltas_inline_(const uint8_t *data, size_t size, const uint8_t *flags, size_t pointNum,
+		uint8_t shortBit, uint8_t sameBit, int32_t *values)
+{
+	// 幅0・1の点も2byte読むので、末尾を超える位置は最後のbyteに留める(読んだ値は使わない)
+	static const uint8_t ZERO = 0;
+	const uint8_t *src = (0 == size)? &ZERO : data;
+	const size_t last = (0 == size)? 0 : size - 1;
+	for(size_t i = 0; i < pointNum; i++){
+		const size_t offset = (size_t)values[i];
+		const int32_t b0 = src[(offset < last)? offset : last];
+		const int32_t b1 = src[(offset + 1 < last)? offset + 1 : last];
+		const bool isShort = (0 != (flags[i] & shortBit));
+		const bool isSame = (0 != (flags[i] & sameBit));
+		const int32_t shortDelta = isSame ? b0 : -b0;
+		const int32_t longDelta = isSame ? 0 : (int16_t)((b0 << 8) | b1);
+		values[i] = isShort ? shortDelta : longDelta;
+	}
+}
+
+void GlyfDecoder_prefixSumScalar_inline_(int32_t *values, size_t begin, size_t pointNum, int32_t acc)
+{
+	for(size_t i = begin; i < pointNum; i++){
+		acc += values[i];
+		values[i] = acc;
+	}
+}
+
+#ifdef DAISYFF_GLYF_DECODER_X86_SIMD
+/** @brief 16点毎に幅をbyteで求め、レジスタ内で排他的累積和を取る。
+  @return SIMDで処理済みの点数(残りはscalarで処理する)
+  */
+__attribute__((target("sse2")))
+size_t GlyfDecoder_offsets_sse2_inline_(const uint8_t *flags, size_t pointNum,
+		uint8_t shortBit, uint8_t sameBit, int32_t *values, size_t *pTotal)
+{
+	const __m128i shortMask = _mm_set1_epi8((char)shortBit);
+	const __m128i sameMask = _mm_set1_epi8((char)sameBit);
+	const __m128i two = _mm_set1_epi8(2);
+	const __m128i zero = _mm_setzero_si128();
+	size_t total = 0;
+	size_t i = 0;
+	for(; i + 16 <= pointNum; i += 16){
+		const __m128i f = _mm_loadu_si128((const __m128i *)&flags[i]);
+		const __m128i isShort = _mm_cmpeq_epi8(_mm_and_si128(f, shortMask), shortMask);
+		const __m128i isSame = _mm_cmpeq_epi8(_mm_and_si128(f, sameMask), sameMask);
+		// short: 2 + (-1), same(非short): 0, long: 2
+		__m128i width = _mm_add_epi8(two, isShort);
+		width = _mm_andnot_si128(_mm_andnot_si128(isShort, isSame), width);
+		// 16点の幅の合計は32以下なのでbyteのまま累積和を取る
+		__m128i sum = _mm_add_epi8(width, _mm_slli_si128(width, 1));
+		sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 2));
+		sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+		sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+		const __m128i exclusive = _mm_sub_epi8(sum, width);
+
+		const __m128i base = _mm_set1_epi32((int)total);
+		const __m128i lo16 = _mm_unpacklo_epi8(exclusive, zero);
+		const __m128i hi16 = _mm_unpackhi_epi8(exclusive, zero);
+		_mm_storeu_si128((__m128i *)&values[i + 0], _mm_add_epi32(base, _mm_unpacklo_epi16(lo16, zero)));
+		_mm_storeu_si128((__m128i *)&values[i + 4], _mm_add_epi32(base, _mm_unpackhi_epi16(lo16, zero)));
+		_mm_storeu_si128((__m128i *)&values[i + 8], _mm_add_epi32(base, _mm_unpacklo_epi16(hi16, zero)));
+		_mm_storeu_si128((__m128i *)&values[i + 12], _mm_add_epi32(base, _mm_unpackhi_epi16(hi16, zero)));
+		total += (size_t)(_mm_extract_epi16(sum, 7) >> 8);
+	}
+	*pTotal = total;
+	return i;
+}
+
+/** @brief 4要素毎にレジスタ内で累積和を取る。
+  @return SIMDで処理済みの要素数(残りはscalarで処理する)
+  */
+__attribute__((target("sse2")))
+size_t GlyfDecoder_prefixSum_sse2_inline_(int32_t *values, size_t pointNum, int32_t *pAcc)
+{
+	__m128i carry = _mm_setzero_si128();
+	size_t i = 0;
+	for(; i + 4 <= pointNum; i += 4){
+		__m128i v = _mm_loadu_si128((const __m128i *)&values[i]);
+		// (a, b, c, d) -> (a, a+b, a+b+c, a+b+c+d)
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi32(v, carry);
+		_mm_storeu_si128((__m128i *)&values[i], v);
+		carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+	*pAcc = _mm_cvtsi128_si32(carry);
+	return i;
+}
+#endif // DAISYFF_GLYF_DECODER_X86_SIMD
+
+//! @return 読んだbyte数, SIZE_MAX: dataが足りない
+size_t GlyfDecoder_axis_inline_(const uint8_t *data, size_t size, const uint8_t *flags, size_t pointNum,
+		uint8_t shortBit, uint8_t sameBit, int32_t *values)
+{
+	size_t done = 0;
+	size_t total = 0;
+#ifdef DAISYFF_GLYF_DECODER_X86_SIMD
+	const bool isSse2 = __builtin_cpu_supports("sse2");
+	if(isSse2){
+		done = GlyfDecoder_offsets_sse2_inline_(flags, pointNum, shortBit, sameBit, values, &total);
+	}
+#endif
+	total = GlyfDecoder_offsetsScalar_inline_(flags, done, pointNum, shortBit, sameBit, values, total);
+	if(size < total){
+		return SIZE_MAX;
+	}
+
+	GlyfDecoder_gatherDeltas_inline_(data, total, flags, pointNum, shortBit, sameBit, values);
+
+	done = 0;
+	int32_t acc = 0;
+#ifdef DAISYFF_GLYF_DECODER_X86_SIMD
+	if(isSse2){
+		done = GlyfDecoder_prefixSum_sse2_inline_(values, pointNum, &acc);
+	}
+#endif
+	GlyfDecoder_prefixSumScalar_inline_(values, done, pointNum, acc);
+	return total;
+}
+
+/** @brief 展開済みのflags[pointNum]に従ってXYCoordinatesを読み、絶対座標をxs, ys[pointNum]へ置く。
+  @param data XYCoordinatesの先頭
+  @param pUsed 読んだbyte数(x, yの合計)
+  @return false: dataが足りない
+  */
+bool GlyfDecoder_coordinates(const uint8_t *data, size_t size, const uint8_t *flags, size_t pointNum,
+		int32_t *xs, int32_t *ys, size_t *pUsed)
+{
+	const size_t xUsed = GlyfDecoder_axis_inline_(
+			data, size, flags, pointNum, GlyfDecoder_FLAG_X_SHORT, GlyfDecoder_FLAG_X_SAME, xs);
+	if(SIZE_MAX == xUsed){
+		return false;
+	}
+	const size_t yUsed = GlyfDecoder_axis_inline_(
+			&data[xUsed], size - xUsed, flags, pointNum, GlyfDecoder_FLAG_Y_SHORT, GlyfDecoder_FLAG_Y_SAME, ys);
+	if(SIZE_MAX == yUsed){
+		return false;
+	}
+	*pUsed = xUsed + yUsed;
+	return true;
+}
+
+#endif // #ifndef DAISYFF_GLYF_DECODER_HPP_
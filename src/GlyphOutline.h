@@ -44,6 +44,16 @@ void GlyphOutline_addClosePath(GlyphOutline *outline, const GlyphClosePath *cpat
 	(outline->closePathNum) += 1;
 }
 
+void GlyphOutline_free(GlyphOutline *outline)
+{
+	for(int l = 0; l < outline->closePathNum; l++){
+		free(outline->closePaths[l].anchorPoints);
+	}
+	free(outline->closePaths);
+	outline->closePaths = NULL;
+	outline->closePathNum = 0;
+}
+
 GlyphOutline GlyphOutline_Notdef()
 {
 	// ** //! @todo flags repeat, Coodinates SHORT_VECTOR
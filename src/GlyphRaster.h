@@ -0,0 +1,514 @@
+/**
+  @file
+  @brief 'glyf' Tableのglyphをグレースケールへ描画するscanline rasterizer。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  線分毎に各pixelへ覆う面積の符号付き差分を加算し(cells)、行毎の累積和の絶対値をcoverageとする。
+  同じ向きのcontourの重なりは累積和が2以上になり1へ丸めるので、塗りはnonzero windingになる。
+  二次ベジェ曲線(off curve点)は誤差が概ね1/3pixel以下になる数の線分へ分割する。
+  GlyphRaster_begin() -> drawLine/drawQuad -> accumulate(cells -> pixels)。
+ */
+#ifndef DAISYFF_GLYPH_RASTER_HPP_
+#define DAISYFF_GLYPH_RASTER_HPP_
+
+#include "src/FontParser.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DAISYFF_GLYPH_RASTER_X86_SIMD
+#endif
+
+//! 行の右端を超えた差分を受ける余白(cell)
+#define GlyphRaster_STRIDE_MARGIN (2)
+
+typedef struct{
+	float			x;
+	float			y;
+	bool			isOnCurve;
+}GlyphRasterPoint;
+
+//! contourの線分(isQuad: (x1, y1)を制御点とする二次ベジェ曲線)
+typedef struct{
+	float			x0;
+	float			y0;
+	float			x1;
+	float			y1;
+	float			x2;
+	float			y2;
+	bool			isQuad;
+}GlyphEdge;
+
+/** 作業領域はglyph間で使い回す。
+  pixels[y * width + x]: 0(背景) - 255(塗り)。yは下向き。
+  */
+typedef struct{
+	size_t			width;
+	size_t			height;
+	size_t			stride;		//!< cellsの1行の要素数(width + 余白)
+	float			*cells;
+	size_t			cellCapacity;
+	uint8_t			*pixels;
+	size_t			pixelCapacity;
+	// decodeGlyph()の結果
+	FontParseGlyph		glyph;		//!< 'glyf'の解析に使い回す
+	GlyphRasterPoint	*points;
+	size_t			pointNum;
+	size_t			pointCapacity;
+	uint32_t		*endPoints;	//!< composite glyphを展開したoutlineは65535点を超えうる
+	size_t			contourNum;
+	size_t			endPointCapacity;
+	int32_t			xMin;
+	int32_t			yMin;
+	int32_t			xMax;
+	int32_t			yMax;
+	// buildEdges()の結果
+	GlyphEdge		*edges;
+	size_t			edgeNum;
+	size_t			edgeCapacity;
+}GlyphRaster;
+
+void GlyphRaster_free(GlyphRaster *raster)
+{
+	free(raster->cells);
+	free(raster->pixels);
+	FontParseGlyph_free(&raster->glyph);
+	free(raster->points);
+	free(raster->endPoints);
+	free(raster->edges);
+	*raster = (GlyphRaster){0};
+}
+
+//! @brief width x heightの描画を始める(cellsを0にする)。
+void GlyphRaster_begin(GlyphRaster *raster, size_t width, size_t height)
+{
+	const size_t stride = width + GlyphRaster_STRIDE_MARGIN;
+	if(raster->cellCapacity < stride * height){
+		raster->cellCapacity = stride * height;
+		raster->cells = (float *)ffrealloc(raster->cells, sizeof(float) * raster->cellCapacity);
+	}
+	if(raster->pixelCapacity < width * height){
+		raster->pixelCapacity = width * height;
+		raster->pixels = (uint8_t *)ffrealloc(raster->pixels, raster->pixelCapacity);
+	}
+	raster->width	= width;
+	raster->height	= height;
+	raster->stride	= stride;
+	memset(raster->cells, 0, sizeof(float) * stride * height);
+}
+
+/** @brief 線分を描く(pixel座標。bitmap外の部分は左右は端へ寄せ、上下は捨てる)。
+  向き(y増加で+1)がwindingの符号になる。
+  */
+void GlyphRaster_drawLine(GlyphRaster *raster, float x0, float y0, float x1, float y1)
+{
+	if(y0 == y1){
+		return;
+	}
+	float dir = 1.0f;
+	if(y1 < y0){
+		float t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		dir = -1.0f;
+	}
+	if(y1 <= 0.0f || (float)raster->height <= y0){
+		return;
+	}
+	const float dxdy = (x1 - x0) / (y1 - y0);
+	const float right = (float)raster->width;
+	float x = x0;
+	if(y0 < 0.0f){
+		x -= y0 * dxdy;
+	}
+	const size_t yBegin = (y0 < 0.0f)? 0 : (size_t)y0;
+	const size_t yEnd = (y1 < (float)raster->height)? (size_t)ceilf(y1) : raster->height;
+	for(size_t y = yBegin; y < yEnd; y++){
+		float *line = &raster->cells[y * raster->stride];
+		const float dy = fminf((float)(y + 1), y1) - fmaxf((float)y, y0);
+		const float xNext = x + dxdy * dy;
+		const float d = dy * dir;
+		float xa = fminf(fmaxf(fminf(x, xNext), 0.0f), right);
+		float xb = fminf(fmaxf(fmaxf(x, xNext), 0.0f), right);
+		const float xaFloor = floorf(xa);
+		const int xai = (int)xaFloor;
+		const float xbCeil = ceilf(xb);
+		const int xbi = (int)xbCeil;
+		if(xbi <= xai + 1){
+			// 1pixel内: 中点の位置で左右へ分ける
+			const float xmf = 0.5f * (xa + xb) - xaFloor;
+			line[xai]	+= d - d * xmf;
+			line[xai + 1]	+= d * xmf;
+		}else{
+			const float s = 1.0f / (xb - xa);
+			const float xaf = xa - xaFloor;
+			const float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+			const float xbf = xb - xbCeil + 1.0f;
+			const float am = 0.5f * s * xbf * xbf;
+			line[xai] += d * a0;
+			if(xbi == xai + 2){
+				line[xai + 1] += d * (1.0f - a0 - am);
+			}else{
+				const float a1 = s * (1.5f - xaf);
+				line[xai + 1] += d * (a1 - a0);
+				for(int xi = xai + 2; xi < xbi - 1; xi++){
+					line[xi] += d * s;
+				}
+				const float a2 = a1 + (float)(xbi - xai - 3) * s;
+				line[xbi - 1] += d * (1.0f - a2 - am);
+			}
+			line[xbi] += d * am;
+		}
+		x = xNext;
+	}
+}
+
+//! @brief 二次ベジェ曲線を描く(p1は制御点)。
+void GlyphRaster_drawQuad(GlyphRaster *raster, float x0, float y0, float x1, float y1, float x2, float y2)
+{
+	const float devX = x0 - 2.0f * x1 + x2;
+	const float devY = y0 - 2.0f * y1 + y2;
+	const float devSq = devX * devX + devY * devY;
+	if(devSq < 0.333f){
+		GlyphRaster_drawLine(raster, x0, y0, x2, y2);
+		return;
+	}
+	// 分割数nで誤差 devSq^(1/2) / (4 n^2) 程度
+	const float tolerance = 3.0f;
+	const int n = 1 + (int)floorf(sqrtf(sqrtf(tolerance * devSq)));
+	float px = x0;
+	float py = y0;
+	for(int i = 1; i <= n; i++){
+		const float t = (float)i / (float)n;
+		const float u = 1.0f - t;
+		const float nx = u * u * x0 + 2.0f * u * t * x1 + t * t * x2;
+		const float ny = u * u * y0 + 2.0f * u * t * y1 + t * t * y2;
+		GlyphRaster_drawLine(raster, px, py, nx, ny);
+		px = nx;
+		py = ny;
+	}
+}
+
+// ********
+// accumulation (cells -> pixels)
+// ********
+
+uint8_t GlyphRaster_coverage_inline_(float acc)
+{
+	return (uint8_t)(fminf(fabsf(acc), 1.0f) * 255.0f + 0.5f);
+}
+
+//! @return 行の末尾までの累積和
+float GlyphRaster_accumulateRow_scalar_inline_(const float *cells, uint8_t *pixels, size_t begin, size_t end, float acc)
+{
+	for(size_t x = begin; x < end; x++){
+		acc += cells[x];
+		pixels[x] = GlyphRaster_coverage_inline_(acc);
+	}
+	return acc;
+}
+
+#ifdef DAISYFF_GLYPH_RASTER_X86_SIMD
+/** @brief 4要素毎にレジスタ内で累積和を取る。
+  @return SIMDで処理済みの要素数(残りはscalarで処理する)
+  */
+__attribute__((target("sse2")))
+size_t GlyphRaster_accumulateRow_sse2_inline_(const float *cells, uint8_t *pixels, size_t width, float *pAcc)
+{
+	__m128 carry = _mm_set1_ps(*pAcc);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	size_t x = 0;
+	for(; x + 4 <= width; x += 4){
+		__m128 v = _mm_loadu_ps(&cells[x]);
+		// (a, b, c, d) -> (a, a+b, a+b+c, a+b+c+d)
+		v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+		v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+		v = _mm_add_ps(v, carry);
+		carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 coverage = _mm_min_ps(_mm_andnot_ps(signMask, v), one);
+		__m128i value = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, scale), half));
+		value = _mm_packs_epi32(value, value);
+		value = _mm_packus_epi16(value, value);
+		const uint32_t packed = (uint32_t)_mm_cvtsi128_si32(value);
+		memcpy(&pixels[x], &packed, sizeof(packed));
+	}
+	*pAcc = _mm_cvtss_f32(carry);
+	return x;
+}
+#endif // DAISYFF_GLYPH_RASTER_X86_SIMD
+
+//! @brief 比較用のscalar実装
+void GlyphRaster_accumulateScalar(GlyphRaster *raster)
+{
+	for(size_t y = 0; y < raster->height; y++){
+		GlyphRaster_accumulateRow_scalar_inline_(
+				&raster->cells[y * raster->stride], &raster->pixels[y * raster->width], 0, raster->width, 0.0f);
+	}
+}
+
+/** @brief cellsの行毎の累積和からpixelsを作る(cellsは変更しない)。
+  閉パスの差分は行毎に合計0になるので、行頭で累積和を0から始める。
+  */
+void GlyphRaster_accumulate(GlyphRaster *raster)
+{
+#ifdef DAISYFF_GLYPH_RASTER_X86_SIMD
+	if(__builtin_cpu_supports("sse2")){
+		for(size_t y = 0; y < raster->height; y++){
+			const float *cells = &raster->cells[y * raster->stride];
+			uint8_t *pixels = &raster->pixels[y * raster->width];
+			float acc = 0.0f;
+			const size_t done = GlyphRaster_accumulateRow_sse2_inline_(cells, pixels, raster->width, &acc);
+			GlyphRaster_accumulateRow_scalar_inline_(cells, pixels, done, raster->width, acc);
+		}
+		return;
+	}
+#endif
+	GlyphRaster_accumulateScalar(raster);
+}
+
+// ********
+// 'glyf' glyph description
+// ********
+
+/** @brief simple glyphの点(font unit)をdecodeしてraster->points, endPoints, bounding boxへ置く。
+  @param size 0: 空glyph
+  @return false: 範囲外参照など不正なglyph・composite glyph
+  */
+bool GlyphRaster_decodeGlyph(GlyphRaster *raster, const uint8_t *data, size_t size)
+{
+	raster->pointNum = 0;
+	raster->contourNum = 0;
+	raster->xMin = raster->yMin = raster->xMax = raster->yMax = 0;
+	if(0 == size){
+		return true;
+	}
+	FontParseGlyph *glyph = &raster->glyph;
+	if(FontParseError_None != FontParser_glyph((FontSpan){data, size}, 0, (uint32_t)size, glyph)){
+		return false;
+	}
+	const GlyphDescriptionHeader *header = &glyph->header;
+	if(header->xMax < header->xMin || header->yMax < header->yMin){
+		return false;
+	}
+	const size_t pointNum = glyph->pointNum;
+	const size_t contourNum = (0 < pointNum)? (size_t)header->numberOfContours : 0;
+	if(raster->endPointCapacity < contourNum){
+		raster->endPointCapacity = contourNum;
+		raster->endPoints = (uint32_t *)ffrealloc(raster->endPoints, sizeof(uint32_t) * raster->endPointCapacity);
+	}
+	if(raster->pointCapacity < pointNum){
+		raster->pointCapacity = pointNum;
+		raster->points = (GlyphRasterPoint *)ffrealloc(raster->points, sizeof(GlyphRasterPoint) * raster->pointCapacity);
+	}
+	for(size_t c = 0; c < contourNum; c++){
+		raster->endPoints[c] = glyph->endPtsOfContours[c];
+	}
+	for(size_t p = 0; p < pointNum; p++){
+		raster->points[p] = (GlyphRasterPoint){
+			.x		= (float)glyph->points[p].abs.x,
+			.y		= (float)glyph->points[p].abs.y,
+			.isOnCurve	= (0 != (glyph->points[p].flag & 0x01)),
+		};
+	}
+	raster->xMin = header->xMin;
+	raster->yMin = header->yMin;
+	raster->xMax = header->xMax;
+	raster->yMax = header->yMax;
+	raster->pointNum = pointNum;
+	raster->contourNum = contourNum;
+	return true;
+}
+
+/** @brief composite glyphを展開したoutline(font unit)をraster->points, endPoints, bounding boxへ置く。
+  bounding boxは点(off curve点を含む)から求める(曲線は点の凸包の内側にあるので欠けない)。
+  */
+void GlyphRaster_setOutline(GlyphRaster *raster, const FontParseOutline *outline)
+{
+	const size_t pointNum = outline->pointNum;
+	const size_t contourNum = (0 < pointNum)? outline->contourNum : 0;
+	if(raster->endPointCapacity < contourNum){
+		raster->endPointCapacity = contourNum;
+		raster->endPoints = (uint32_t *)ffrealloc(raster->endPoints, sizeof(uint32_t) * raster->endPointCapacity);
+	}
+	if(raster->pointCapacity < pointNum){
+		raster->pointCapacity = pointNum;
+		raster->points = (GlyphRasterPoint *)ffrealloc(raster->points, sizeof(GlyphRasterPoint) * raster->pointCapacity);
+	}
+	memcpy(raster->endPoints, outline->endPts, sizeof(uint32_t) * contourNum);
+	raster->xMin = raster->yMin = raster->xMax = raster->yMax = 0;
+	for(size_t p = 0; p < pointNum; p++){
+		const FontParseOutlinePoint *point = &outline->points[p];
+		raster->points[p] = (GlyphRasterPoint){(float)point->x, (float)point->y, point->isOnCurve};
+		if(0 == p || point->x < raster->xMin){
+			raster->xMin = point->x;
+		}
+		if(0 == p || raster->xMax < point->x){
+			raster->xMax = point->x;
+		}
+		if(0 == p || point->y < raster->yMin){
+			raster->yMin = point->y;
+		}
+		if(0 == p || raster->yMax < point->y){
+			raster->yMax = point->y;
+		}
+	}
+	raster->pointNum = pointNum;
+	raster->contourNum = contourNum;
+}
+
+//! @brief decodeした点を (x * scale + offsetX, offsetY - y * scale) へ移す(yは下向きになる)
+void GlyphRaster_transformPoints(GlyphRaster *raster, float scale, float offsetX, float offsetY)
+{
+	for(size_t p = 0; p < raster->pointNum; p++){
+		raster->points[p].x = raster->points[p].x * scale + offsetX;
+		raster->points[p].y = offsetY - raster->points[p].y * scale;
+	}
+}
+
+//! @brief 1 contourを線分へ分ける(連続するoff curve点の間は中点をon curve点とする)
+size_t GlyphRaster_contourToEdges_inline_(const GlyphRasterPoint *points, size_t pointNum, GlyphEdge *edges)
+{
+	if(pointNum < 2){
+		return 0;
+	}
+	size_t edgeNum = 0;
+	// 始点: on curve点。無ければ先頭2点の中点
+	size_t first = 0;
+	while(first < pointNum && (! points[first].isOnCurve)){
+		first++;
+	}
+	float startX, startY;
+	if(first == pointNum){
+		first = 0;
+		startX = 0.5f * (points[0].x + points[1].x);
+		startY = 0.5f * (points[0].y + points[1].y);
+	}else{
+		startX = points[first].x;
+		startY = points[first].y;
+	}
+	float x = startX;
+	float y = startY;
+	bool hasControl = false;
+	float cx = 0.0f, cy = 0.0f;
+	for(size_t i = 1; i <= pointNum; i++){
+		const GlyphRasterPoint *point = &points[(first + i) % pointNum];
+		const float px = (i == pointNum)? startX : point->x;
+		const float py = (i == pointNum)? startY : point->y;
+		const bool isOnCurve = (i == pointNum) || point->isOnCurve;
+		if(isOnCurve){
+			if(hasControl){
+				edges[edgeNum++] = (GlyphEdge){x, y, cx, cy, px, py, true};
+			}else{
+				edges[edgeNum++] = (GlyphEdge){x, y, px, py, px, py, false};
+			}
+			hasControl = false;
+			x = px;
+			y = py;
+		}else if(hasControl){
+			const float mx = 0.5f * (cx + px);
+			const float my = 0.5f * (cy + py);
+			edges[edgeNum++] = (GlyphEdge){x, y, cx, cy, mx, my, true};
+			x = mx;
+			y = my;
+			cx = px;
+			cy = py;
+		}else{
+			hasControl = true;
+			cx = px;
+			cy = py;
+		}
+	}
+	return edgeNum;
+}
+
+//! @brief decodeした全contourの線分をraster->edgesへ置く(点1つにつき線分は高々1つ)
+void GlyphRaster_buildEdges(GlyphRaster *raster)
+{
+	if(raster->edgeCapacity < raster->pointNum){
+		raster->edgeCapacity = raster->pointNum;
+		raster->edges = (GlyphEdge *)ffrealloc(raster->edges, sizeof(GlyphEdge) * raster->edgeCapacity);
+	}
+	raster->edgeNum = 0;
+	size_t begin = 0;
+	for(size_t c = 0; c < raster->contourNum; c++){
+		const size_t end = (size_t)raster->endPoints[c] + 1;
+		raster->edgeNum += GlyphRaster_contourToEdges_inline_(
+				&raster->points[begin], end - begin, &raster->edges[raster->edgeNum]);
+		begin = end;
+	}
+}
+
+//! @brief decode済みの点をppemで描画する(isEmpty: 0x0のbitmap)
+void GlyphRaster_renderDecoded_inline_(GlyphRaster *raster, bool isEmpty, double ppem, uint16_t unitsPerEm)
+{
+	if(isEmpty){
+		GlyphRaster_begin(raster, 0, 0);
+		return;
+	}
+	const float scale = (float)(ppem / unitsPerEm);
+	GlyphRaster_begin(raster,
+			(size_t)ceilf((float)(raster->xMax - raster->xMin) * scale) + 2,
+			(size_t)ceilf((float)(raster->yMax - raster->yMin) * scale) + 2);
+	GlyphRaster_transformPoints(raster, scale, 1.0f - (float)raster->xMin * scale, 1.0f + (float)raster->yMax * scale);
+	GlyphRaster_buildEdges(raster);
+	for(size_t e = 0; e < raster->edgeNum; e++){
+		const GlyphEdge *edge = &raster->edges[e];
+		if(edge->isQuad){
+			GlyphRaster_drawQuad(raster, edge->x0, edge->y0, edge->x1, edge->y1, edge->x2, edge->y2);
+		}else{
+			GlyphRaster_drawLine(raster, edge->x0, edge->y0, edge->x2, edge->y2);
+		}
+	}
+	GlyphRaster_accumulate(raster);
+}
+
+/** @brief 'glyf'のglyph 1つ(locaの範囲)をppemで描画し、raster->pixelsへ置く。
+  bitmapはglyphのbounding boxに1pixelの余白を付けた大きさ(左上がxMin, yMax)。
+  @param size 0: 空glyph(0x0のbitmap)
+  @return false: 不正・未対応(composite)のglyph
+  */
+bool GlyphRaster_renderGlyph(GlyphRaster *raster, const uint8_t *data, size_t size, double ppem, uint16_t unitsPerEm)
+{
+	if(0 == unitsPerEm || ! (0.0 < ppem) || ! GlyphRaster_decodeGlyph(raster, data, size)){
+		return false;
+	}
+	GlyphRaster_renderDecoded_inline_(raster, (0 == size), ppem, unitsPerEm);
+	return true;
+}
+
+/** @brief FontParseGlyphResolver_outline()のoutline(composite glyphを含む)を描画する。
+  点の無いoutlineは0x0のbitmap。
+  @return false: ppem, unitsPerEmが不正
+  */
+bool GlyphRaster_renderOutline(GlyphRaster *raster, const FontParseOutline *outline, double ppem, uint16_t unitsPerEm)
+{
+	if(0 == unitsPerEm || ! (0.0 < ppem)){
+		return false;
+	}
+	GlyphRaster_setOutline(raster, outline);
+	GlyphRaster_renderDecoded_inline_(raster, (0 == raster->pointNum), ppem, unitsPerEm);
+	return true;
+}
+
+//! @brief pixelsをPGM(P5)で書き出す
+bool GlyphRaster_writePgm(const GlyphRaster *raster, const char *filepath)
+{
+	FILE *fp = fopen(filepath, "wb");
+	if(NULL == fp){
+		return false;
+	}
+	fprintf(fp, "P5\n%zu %zu\n255\n", raster->width, raster->height);
+	const size_t size = raster->width * raster->height;
+	// 空のglyphはpixelsがNULLのことがある(fwrite()にNULLを渡さない)
+	const bool isSuccess = (0 == size) || (size == fwrite(raster->pixels, 1, size, fp));
+	return (0 == fclose(fp)) && isSuccess;
+}
+
+#endif // #ifndef DAISYFF_GLYPH_RASTER_HPP_
@@ -0,0 +1,657 @@
+/**
+  @file
+  @brief glyphのsigned distance field(SDF)とatlas生成。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  距離はpixel中心からcontourの線分・二次ベジェ曲線までの厳密な最短距離(曲線は3次方程式を解く)。
+  内外はpixel中心の行でのnonzero windingで決める。
+  値は 0.5 + distance / (2 * spread) を0-255にしたもの(内側が128以上)。
+  atlasはglyph毎のSDFを複数threadで計算し、skyline法で詰める。
+ */
+#ifndef DAISYFF_GLYPH_SDF_HPP_
+#define DAISYFF_GLYPH_SDF_HPP_
+
+#include "src/GlyphRaster.h"
+#include <pthread.h>
+
+//! atlas内のglyph間の余白(pixel)
+#define GlyphSdfAtlas_PADDING (1)
+#define GlyphSdfAtlas_THREAD_MAX (64)
+
+// ********
+// distance
+// ********
+
+double GlyphSdf_distanceSqToLine_inline_(double px, double py, double x0, double y0, double x1, double y1)
+{
+	const double dx = x1 - x0;
+	const double dy = y1 - y0;
+	const double lengthSq = dx * dx + dy * dy;
+	double t = (0.0 == lengthSq)? 0.0 : ((px - x0) * dx + (py - y0) * dy) / lengthSq;
+	t = fmin(fmax(t, 0.0), 1.0);
+	const double ex = x0 + t * dx - px;
+	const double ey = y0 + t * dy - py;
+	return ex * ex + ey * ey;
+}
+
+/** @brief a t^3 + b t^2 + c t + d = 0 の実数解
+  @return 解の数(0-3)
+  */
+int GlyphSdf_solveCubic_inline_(double a, double b, double c, double d, double *roots)
+{
+	if(fabs(a) < 1e-12){
+		if(fabs(b) < 1e-12){
+			if(fabs(c) < 1e-12){
+				return 0;
+			}
+			roots[0] = -d / c;
+			return 1;
+		}
+		const double discriminant = c * c - 4.0 * b * d;
+		if(discriminant < 0.0){
+			return 0;
+		}
+		const double s = sqrt(discriminant);
+		roots[0] = (-c + s) / (2.0 * b);
+		roots[1] = (-c - s) / (2.0 * b);
+		return 2;
+	}
+	// t = u - b/(3a) で u^3 + p u + q = 0 へ
+	const double bn = b / a;
+	const double cn = c / a;
+	const double dn = d / a;
+	const double p = cn - bn * bn / 3.0;
+	const double q = (2.0 * bn * bn * bn) / 27.0 - (bn * cn) / 3.0 + dn;
+	const double shift = -bn / 3.0;
+	const double discriminant = (q * q) / 4.0 + (p * p * p) / 27.0;
+	if(0.0 < discriminant){
+		const double s = sqrt(discriminant);
+		roots[0] = cbrt(-q / 2.0 + s) + cbrt(-q / 2.0 - s) + shift;
+		return 1;
+	}
+	if(0.0 == p){
+		roots[0] = shift;
+		return 1;
+	}
+	// 3実数解(三角関数解)
+	const double r = 2.0 * sqrt(-p / 3.0);
+	const double phi = acos(fmin(fmax((3.0 * q) / (p * r), -1.0), 1.0)) / 3.0;
+	for(int k = 0; k < 3; k++){
+		roots[k] = r * cos(phi - (2.0 * M_PI * k) / 3.0) + shift;
+	}
+	return 3;
+}
+
+//! @brief 点から二次ベジェ曲線 B(t) = p0 + 2t(p1 - p0) + t^2(p0 - 2p1 + p2) までの距離の2乗
+double GlyphSdf_distanceSqToQuad_inline_(double px, double py, const GlyphEdge *edge)
+{
+	const double ax = (double)edge->x1 - (double)edge->x0;
+	const double ay = (double)edge->y1 - (double)edge->y0;
+	const double bx = (double)edge->x0 - 2.0 * (double)edge->x1 + (double)edge->x2;
+	const double by = (double)edge->y0 - 2.0 * (double)edge->y1 + (double)edge->y2;
+	const double mx = (double)edge->x0 - px;
+	const double my = (double)edge->y0 - py;
+	// d/dt |B(t) - p|^2 = 0
+	double roots[3];
+	const int rootNum = GlyphSdf_solveCubic_inline_(
+			bx * bx + by * by,
+			3.0 * (ax * bx + ay * by),
+			2.0 * (ax * ax + ay * ay) + (mx * bx + my * by),
+			mx * ax + my * ay,
+			roots);
+	double best = fmin(
+			(mx * mx) + (my * my),
+			(((double)edge->x2 - px) * ((double)edge->x2 - px)) + (((double)edge->y2 - py) * ((double)edge->y2 - py)));
+	for(int i = 0; i < rootNum; i++){
+		const double t = roots[i];
+		if(! (0.0 < t && t < 1.0)){
+			continue;
+		}
+		const double ex = mx + 2.0 * t * ax + t * t * bx;
+		const double ey = my + 2.0 * t * ay + t * t * by;
+		best = fmin(best, ex * ex + ey * ey);
+	}
+	return best;
+}
+
+// ********
+// winding
+// ********
+
+typedef struct{
+	float			x;
+	int			dir;	//!< 下向き(y増加)に横切る場合+1
+}GlyphSdfCrossing;
+
+int GlyphSdfCrossing_compare_inline_(const void *a_, const void *b_)
+{
+	const GlyphSdfCrossing *a = (const GlyphSdfCrossing *)a_;
+	const GlyphSdfCrossing *b = (const GlyphSdfCrossing *)b_;
+	return (a->x < b->x)? -1 : ((b->x < a->x)? 1 : 0);
+}
+
+//! @brief yについて単調な区間[t0, t1]がy = ycを横切る点を追加する(y方向は半開区間)
+size_t GlyphSdf_addMonotonicCrossing_inline_(
+		const GlyphEdge *edge, double t0, double t1, double yc, GlyphSdfCrossing *crossings, size_t num)
+{
+	const double y0 = (double)edge->y0, y1 = (double)edge->y1, y2 = (double)edge->y2;
+	#define GlyphSdf_QUAD_AT(v0, v1, v2, t) (((1.0 - (t)) * (1.0 - (t)) * (v0)) + (2.0 * (1.0 - (t)) * (t) * (v1)) + ((t) * (t) * (v2)))
+	const double ya = edge->isQuad? GlyphSdf_QUAD_AT(y0, y1, y2, t0) : y0 + ((double)edge->y2 - y0) * t0;
+	const double yb = edge->isQuad? GlyphSdf_QUAD_AT(y0, y1, y2, t1) : y0 + ((double)edge->y2 - y0) * t1;
+	if(! (fmin(ya, yb) <= yc && yc < fmax(ya, yb))){
+		return num;
+	}
+	double t;
+	if(! edge->isQuad){
+		t = (yc - y0) / ((double)edge->y2 - y0);
+	}else{
+		// 単調区間内を二分法で解く(区間が狭いので十分に収束する)
+		double lo = t0, hi = t1;
+		const bool isIncreasing = (ya < yb);
+		for(int i = 0; i < 40; i++){
+			const double mid = 0.5 * (lo + hi);
+			if((GlyphSdf_QUAD_AT(y0, y1, y2, mid) < yc) == isIncreasing){
+				lo = mid;
+			}else{
+				hi = mid;
+			}
+		}
+		t = 0.5 * (lo + hi);
+	}
+	const double x = edge->isQuad? GlyphSdf_QUAD_AT((double)edge->x0, (double)edge->x1, (double)edge->x2, t) : (double)edge->x0 + ((double)edge->x2 - (double)edge->x0) * t;
+	#undef GlyphSdf_QUAD_AT
+	crossings[num] = (GlyphSdfCrossing){(float)x, (ya < yb)? 1 : -1};
+	return num + 1;
+}
+
+// ********
+// glyph SDF
+// ********
+
+/** 1 glyphのSDF。thread毎に1つ持ち、作業領域を使い回す。
+  sdf[y * width + x]。左上がglyphの(xMin, yMax)からspread pixel外側。
+  */
+typedef struct{
+	GlyphRaster		raster;		//!< decodeとcontourの分割に使う
+	uint8_t			*sdf;
+	size_t			sdfCapacity;
+	size_t			width;
+	size_t			height;
+	GlyphSdfCrossing	*crossings;
+	size_t			crossingCapacity;
+}GlyphSdf;
+
+void GlyphSdf_free(GlyphSdf *glyphSdf)
+{
+	GlyphRaster_free(&glyphSdf->raster);
+	free(glyphSdf->sdf);
+	free(glyphSdf->crossings);
+	*glyphSdf = (GlyphSdf){0};
+}
+
+/** @brief decode済み・pixel座標へ変換済みのraster->edgesからSDFを計算する
+  @param spread 距離の表現範囲(pixel)
+  */
+void GlyphSdf_computeEdges(GlyphSdf *glyphSdf, size_t width, size_t height, double spread)
+{
+	const GlyphRaster *raster = &glyphSdf->raster;
+	if(glyphSdf->sdfCapacity < width * height){
+		glyphSdf->sdfCapacity = width * height;
+		glyphSdf->sdf = (uint8_t *)ffrealloc(glyphSdf->sdf, glyphSdf->sdfCapacity);
+	}
+	// 二次曲線は単調区間2つに分けるので、1行あたり線分数 * 2まで
+	if(glyphSdf->crossingCapacity < raster->edgeNum * 2){
+		glyphSdf->crossingCapacity = raster->edgeNum * 2;
+		glyphSdf->crossings = (GlyphSdfCrossing *)ffrealloc(
+				glyphSdf->crossings, sizeof(GlyphSdfCrossing) * glyphSdf->crossingCapacity);
+	}
+	glyphSdf->width = width;
+	glyphSdf->height = height;
+
+	for(size_t y = 0; y < height; y++){
+		const double yc = (double)y + 0.5;
+		size_t crossingNum = 0;
+		for(size_t e = 0; e < raster->edgeNum; e++){
+			const GlyphEdge *edge = &raster->edges[e];
+			double tSplit = -1.0;
+			if(edge->isQuad){
+				const double denominator = (double)edge->y0 - 2.0 * (double)edge->y1 + (double)edge->y2;
+				if(0.0 != denominator){
+					tSplit = ((double)edge->y0 - (double)edge->y1) / denominator;
+				}
+			}
+			if(0.0 < tSplit && tSplit < 1.0){
+				crossingNum = GlyphSdf_addMonotonicCrossing_inline_(edge, 0.0, tSplit, yc, glyphSdf->crossings, crossingNum);
+				crossingNum = GlyphSdf_addMonotonicCrossing_inline_(edge, tSplit, 1.0, yc, glyphSdf->crossings, crossingNum);
+			}else{
+				crossingNum = GlyphSdf_addMonotonicCrossing_inline_(edge, 0.0, 1.0, yc, glyphSdf->crossings, crossingNum);
+			}
+		}
+		qsort(glyphSdf->crossings, crossingNum, sizeof(GlyphSdfCrossing), GlyphSdfCrossing_compare_inline_);
+
+		size_t c = 0;
+		int winding = 0;
+		for(size_t x = 0; x < width; x++){
+			const double xc = (double)x + 0.5;
+			while(c < crossingNum && (double)glyphSdf->crossings[c].x < xc){
+				winding += glyphSdf->crossings[c].dir;
+				c++;
+			}
+			double best = spread * spread;
+			for(size_t e = 0; e < raster->edgeNum; e++){
+				const GlyphEdge *edge = &raster->edges[e];
+				const double d = edge->isQuad
+					? GlyphSdf_distanceSqToQuad_inline_(xc, yc, edge)
+					: GlyphSdf_distanceSqToLine_inline_(xc, yc, (double)edge->x0, (double)edge->y0, (double)edge->x2, (double)edge->y2);
+				best = fmin(best, d);
+			}
+			const double distance = (0 != winding)? sqrt(best) : -sqrt(best);
+			const double value = fmin(fmax(0.5 + distance / (2.0 * spread), 0.0), 1.0);
+			glyphSdf->sdf[(y * width) + x] = (uint8_t)lround(value * 255.0);
+		}
+	}
+}
+
+//! @brief decode済みの点のSDFを計算する(isEmpty: 0x0)
+void GlyphSdf_computeDecoded_inline_(GlyphSdf *glyphSdf, bool isEmpty, double ppem, uint16_t unitsPerEm, double spread)
+{
+	GlyphRaster *raster = &glyphSdf->raster;
+	if(isEmpty){
+		glyphSdf->width = 0;
+		glyphSdf->height = 0;
+		return;
+	}
+	const float scale = (float)(ppem / unitsPerEm);
+	const float margin = (float)ceil(spread);
+	GlyphRaster_transformPoints(raster, scale, margin - (float)raster->xMin * scale, margin + (float)raster->yMax * scale);
+	GlyphRaster_buildEdges(raster);
+	GlyphSdf_computeEdges(glyphSdf,
+			(size_t)ceilf((float)(raster->xMax - raster->xMin) * scale + 2.0f * margin),
+			(size_t)ceilf((float)(raster->yMax - raster->yMin) * scale + 2.0f * margin),
+			spread);
+}
+
+/** @brief 'glyf'のglyph 1つのSDFを計算する
+  @param size 0: 空glyph(0x0)
+  @return false: 不正・未対応(composite)のglyph
+  */
+bool GlyphSdf_computeGlyph(GlyphSdf *glyphSdf, const uint8_t *data, size_t size, double ppem, uint16_t unitsPerEm, double spread)
+{
+	if(0 == unitsPerEm || ! (0.0 < ppem) || ! GlyphRaster_decodeGlyph(&glyphSdf->raster, data, size)){
+		return false;
+	}
+	GlyphSdf_computeDecoded_inline_(glyphSdf, (0 == size), ppem, unitsPerEm, spread);
+	return true;
+}
+
+/** @brief FontParseGlyphResolver_outline()のoutline(composite glyphを含む)のSDFを計算する。点の無いoutlineは0x0
+  @return false: ppem, unitsPerEmが不正
+  */
+bool GlyphSdf_computeOutline(GlyphSdf *glyphSdf, const FontParseOutline *outline, double ppem, uint16_t unitsPerEm, double spread)
+{
+	if(0 == unitsPerEm || ! (0.0 < ppem)){
+		return false;
+	}
+	GlyphRaster_setOutline(&glyphSdf->raster, outline);
+	GlyphSdf_computeDecoded_inline_(glyphSdf, (0 == glyphSdf->raster.pointNum), ppem, unitsPerEm, spread);
+	return true;
+}
+
+// ********
+// skyline packer
+// ********
+
+typedef struct{
+	size_t			x;
+	size_t			y;
+	size_t			width;
+}SkylineSegment;
+
+typedef struct{
+	size_t			width;		//!< atlasの幅(固定)
+	size_t			height;		//!< 配置済みの最大の高さ
+	SkylineSegment		*segments;	//!< x昇順。幅の合計はwidth
+	size_t			segmentNum;
+	size_t			segmentCapacity;
+}SkylinePacker;
+
+void SkylinePacker_init(SkylinePacker *packer, size_t width)
+{
+	*packer = (SkylinePacker){0};
+	packer->width = width;
+	packer->segmentCapacity = 16;
+	packer->segments = (SkylineSegment *)ffmalloc(sizeof(SkylineSegment) * packer->segmentCapacity);
+	packer->segments[0] = (SkylineSegment){0, 0, width};
+	packer->segmentNum = 1;
+}
+
+void SkylinePacker_free(SkylinePacker *packer)
+{
+	free(packer->segments);
+	*packer = (SkylinePacker){0};
+}
+
+/** @brief segment indexから幅widthの矩形を置ける最小のyを返す
+  @return false: 右端を超える
+  */
+bool SkylinePacker_fit_inline_(const SkylinePacker *packer, size_t index, size_t width, size_t *pY)
+{
+	const size_t x = packer->segments[index].x;
+	if(packer->width < x + width){
+		return false;
+	}
+	size_t y = 0;
+	size_t rest = width;
+	for(size_t i = index; 0 < rest; i++){
+		if(y < packer->segments[i].y){
+			y = packer->segments[i].y;
+		}
+		rest -= (rest < packer->segments[i].width)? rest : packer->segments[i].width;
+	}
+	*pY = y;
+	return true;
+}
+
+/** @brief width x heightの矩形を置く(上端が最も低く、同じなら左の位置: bottom-left)
+  @return false: 幅がatlasより大きい
+  */
+bool SkylinePacker_insert(SkylinePacker *packer, size_t width, size_t height, size_t *pX, size_t *pY)
+{
+	size_t bestIndex = SIZE_MAX;
+	size_t bestY = SIZE_MAX;
+	for(size_t i = 0; i < packer->segmentNum; i++){
+		size_t y;
+		if(SkylinePacker_fit_inline_(packer, i, width, &y) && y < bestY){
+			bestY = y;
+			bestIndex = i;
+		}
+	}
+	if(SIZE_MAX == bestIndex){
+		return false;
+	}
+	const size_t x = packer->segments[bestIndex].x;
+	*pX = x;
+	*pY = bestY;
+	if(0 == width){
+		return true;
+	}
+
+	// [x, x + width)を新しいsegmentで置き換える
+	if(packer->segmentCapacity < packer->segmentNum + 2){
+		packer->segmentCapacity *= 2;
+		packer->segments = (SkylineSegment *)ffrealloc(packer->segments, sizeof(SkylineSegment) * packer->segmentCapacity);
+	}
+	size_t end = bestIndex;
+	while(end < packer->segmentNum && packer->segments[end].x + packer->segments[end].width <= x + width){
+		end++;
+	}
+	// 最後のsegmentは右側が残る場合がある
+	SkylineSegment tail = {0};
+	bool hasTail = false;
+	if(end < packer->segmentNum && packer->segments[end].x < x + width){
+		tail = packer->segments[end];
+		tail.width = (tail.x + tail.width) - (x + width);
+		tail.x = x + width;
+		hasTail = true;
+		end++;
+	}
+	const SkylineSegment segment = {x, bestY + height, width};
+	const size_t insertNum = hasTail? 2 : 1;
+	memmove(&packer->segments[bestIndex + insertNum], &packer->segments[end],
+			sizeof(SkylineSegment) * (packer->segmentNum - end));
+	packer->segmentNum = bestIndex + insertNum + (packer->segmentNum - end);
+	packer->segments[bestIndex] = segment;
+	if(hasTail){
+		packer->segments[bestIndex + 1] = tail;
+	}
+	// 同じ高さの隣接segmentをまとめる
+	size_t n = 0;
+	for(size_t i = 0; i < packer->segmentNum; i++){
+		if(0 < n && packer->segments[n - 1].y == packer->segments[i].y){
+			packer->segments[n - 1].width += packer->segments[i].width;
+		}else{
+			packer->segments[n++] = packer->segments[i];
+		}
+	}
+	packer->segmentNum = n;
+
+	if(packer->height < bestY + height){
+		packer->height = bestY + height;
+	}
+	return true;
+}
+
+// ********
+// atlas
+// ********
+
+typedef struct{
+	uint16_t		glyphId;
+	uint16_t		advanceWidth;	//!< font unit
+	int16_t			lsb;
+	size_t			width;		//!< SDFの大きさ(0: 空glyph)
+	size_t			height;
+	double			bearingX;	//!< 原点からSDF左端へのpixel距離
+	double			bearingY;	//!< baselineからSDF上端へのpixel距離(上向き正)
+	size_t			atlasX;
+	size_t			atlasY;
+	uint8_t			*sdf;		//!< 計算後、atlasへ置くまで保持する
+	bool			isValid;
+}GlyphSdfAtlasGlyph;
+
+typedef struct{
+	double			ppem;
+	double			spread;
+	size_t			width;
+	size_t			height;
+	uint8_t			*pixels;	//!< [width * height]
+	GlyphSdfAtlasGlyph	*glyphs;
+	size_t			glyphNum;
+}GlyphSdfAtlas;
+
+//! atlasの作成に使うTable(作成の前に1度だけ解析する)
+typedef struct{
+	const FontParser	*parser;
+	uint16_t		unitsPerEm;
+	int16_t			indexToLocFormat;
+	uint16_t		numGlyphs;
+	FontParseHmtx		hmtx;
+}GlyphSdfAtlasFont;
+
+typedef struct{
+	const GlyphSdfAtlasFont	*font;
+	GlyphSdfAtlas		*atlas;
+	pthread_mutex_t		*mutex;
+	size_t			*nextIndex;	//!< mutexで保護
+}GlyphSdfAtlasWorkerArg;
+
+void *GlyphSdfAtlas_workerMain_inline_(void *arg_)
+{
+	GlyphSdfAtlasWorkerArg *arg = (GlyphSdfAtlasWorkerArg *)arg_;
+	GlyphSdfAtlas *atlas = arg->atlas;
+	const GlyphSdfAtlasFont *font = arg->font;
+	GlyphSdf glyphSdf = {0};
+	// composite glyphの部品はthread毎に覚える(resolverは複数threadで共有しない)
+	FontParseGlyphResolver resolver;
+	const FontParseError resolverError = FontParseGlyphResolver_init(&resolver, font->parser, font->indexToLocFormat, font->numGlyphs);
+	while(FontParseError_None == resolverError){
+		pthread_mutex_lock(arg->mutex);
+		const size_t index = (*arg->nextIndex)++;
+		pthread_mutex_unlock(arg->mutex);
+		if(atlas->glyphNum <= index){
+			break;
+		}
+
+		GlyphSdfAtlasGlyph *glyph = &atlas->glyphs[index];
+		const FontParseOutline *outline;
+		if(FontParseError_None != FontParseGlyphResolver_outline(&resolver, glyph->glyphId, &outline)
+				|| ! GlyphSdf_computeOutline(&glyphSdf, outline, atlas->ppem, font->unitsPerEm, atlas->spread)){
+			continue;
+		}
+		const double scale = atlas->ppem / font->unitsPerEm;
+		const double margin = ceil(atlas->spread);
+		glyph->width = glyphSdf.width;
+		glyph->height = glyphSdf.height;
+		glyph->bearingX = (glyphSdf.raster.xMin * scale) - margin;
+		glyph->bearingY = (glyphSdf.raster.yMax * scale) + margin;
+		glyph->sdf = (uint8_t *)ffmalloc(glyph->width * glyph->height + 1);
+		memcpy(glyph->sdf, glyphSdf.sdf, glyph->width * glyph->height);
+		FontParseHmtx_metric(&font->hmtx, glyph->glyphId, &glyph->advanceWidth, &glyph->lsb);
+		glyph->isValid = true;
+	}
+	FontParseGlyphResolver_free(&resolver);
+	GlyphSdf_free(&glyphSdf);
+	return NULL;
+}
+
+int GlyphSdfAtlasGlyph_compareHeight_inline_(const void *a_, const void *b_)
+{
+	const GlyphSdfAtlasGlyph *a = *(const GlyphSdfAtlasGlyph *const *)a_;
+	const GlyphSdfAtlasGlyph *b = *(const GlyphSdfAtlasGlyph *const *)b_;
+	if(a->height != b->height){
+		return (a->height < b->height)? 1 : -1;
+	}
+	return (a->glyphId < b->glyphId)? -1 : ((a->glyphId > b->glyphId)? 1 : 0);
+}
+
+void GlyphSdfAtlas_free(GlyphSdfAtlas *atlas)
+{
+	for(size_t i = 0; i < atlas->glyphNum; i++){
+		free(atlas->glyphs[i].sdf);
+	}
+	free(atlas->glyphs);
+	free(atlas->pixels);
+	*atlas = (GlyphSdfAtlas){0};
+}
+
+/** @brief glyph毎のSDFをthreadNum個のthreadで計算し、atlasへ詰める
+  @param glyphIds 重複の無いGlyphId列
+  composite glyphは部品を展開して計算する。
+  @return false: 不正なglyphがある(atlas->glyphs[].isValidで判別できる)、
+  	または'head', 'maxp', 'hhea', 'hmtx', 'loca', 'glyf'が無い・不正(全てのglyphが不正。atlasは空)
+  */
+bool GlyphSdfAtlas_build(
+		GlyphSdfAtlas *atlas,
+		const FontParser *parser,
+		const uint16_t *glyphIds,
+		size_t glyphNum,
+		double ppem,
+		double spread,
+		size_t threadNum)
+{
+	*atlas = (GlyphSdfAtlas){.ppem = ppem, .spread = spread, .glyphNum = glyphNum};
+	atlas->glyphs = (GlyphSdfAtlasGlyph *)ffmalloc(sizeof(GlyphSdfAtlasGlyph) * (glyphNum + 1));
+	for(size_t i = 0; i < glyphNum; i++){
+		atlas->glyphs[i].glyphId = glyphIds[i];
+	}
+
+	// ** Table
+	GlyphSdfAtlasFont font = {0};
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	HheaTable hhea;
+	FontParseError error = FontParser_head(parser, &head);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxp);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_hhea(parser, &hhea);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_hmtx(parser, hhea.numberOfHMetrics, maxp.numGlyphs, &font.hmtx);
+	}
+	FontSpan glyf;
+	FontParseLocaView loca;
+	if(FontParseError_None == error){
+		error = FontParser_table(parser, "glyf", &glyf);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_locaView(parser, head.indexToLocFormat, maxp.numGlyphs, &loca);
+	}
+	font.parser = parser;
+	font.unitsPerEm = head.unitsPerEm;
+	font.indexToLocFormat = head.indexToLocFormat;
+	font.numGlyphs = maxp.numGlyphs;
+	if(FontParseError_None != error){
+		return false; // 全て不正(isValid = false)、pixelsは無い
+	}
+
+	// ** SDF(並列)
+	if(0 == threadNum){
+		threadNum = 1;
+	}
+	if(GlyphSdfAtlas_THREAD_MAX < threadNum){
+		threadNum = GlyphSdfAtlas_THREAD_MAX;
+	}
+	if(glyphNum < threadNum){
+		threadNum = (0 == glyphNum)? 1 : glyphNum;
+	}
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	size_t nextIndex = 0;
+	GlyphSdfAtlasWorkerArg arg = {&font, atlas, &mutex, &nextIndex};
+	pthread_t threads[GlyphSdfAtlas_THREAD_MAX];
+	size_t startedNum = 0;
+	for(; startedNum < threadNum; startedNum++){
+		if(0 != pthread_create(&threads[startedNum], NULL, GlyphSdfAtlas_workerMain_inline_, &arg)){
+			break; // 起動できた分だけで続ける
+		}
+	}
+	if(0 == startedNum){
+		GlyphSdfAtlas_workerMain_inline_(&arg);
+	}
+	for(size_t i = 0; i < startedNum; i++){
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&mutex);
+
+	// ** packing(高い順に置く)
+	bool isAllValid = true;
+	size_t area = 0;
+	size_t maxWidth = 0;
+	GlyphSdfAtlasGlyph **order = (GlyphSdfAtlasGlyph **)ffmalloc(sizeof(GlyphSdfAtlasGlyph *) * (glyphNum + 1));
+	for(size_t i = 0; i < glyphNum; i++){
+		GlyphSdfAtlasGlyph *glyph = &atlas->glyphs[i];
+		isAllValid = isAllValid && glyph->isValid;
+		order[i] = glyph;
+		area += (glyph->width + GlyphSdfAtlas_PADDING) * (glyph->height + GlyphSdfAtlas_PADDING);
+		if(maxWidth < glyph->width + GlyphSdfAtlas_PADDING){
+			maxWidth = glyph->width + GlyphSdfAtlas_PADDING;
+		}
+	}
+	qsort(order, glyphNum, sizeof(GlyphSdfAtlasGlyph *), GlyphSdfAtlasGlyph_compareHeight_inline_);
+	// 幅: 面積の平方根以上の2の冪
+	size_t width = 16;
+	while(width * width < area + (area / 8) || width < maxWidth){
+		width *= 2;
+	}
+	SkylinePacker packer;
+	SkylinePacker_init(&packer, width);
+	for(size_t i = 0; i < glyphNum; i++){
+		GlyphSdfAtlasGlyph *glyph = order[i];
+		if(0 == glyph->width * glyph->height){
+			continue;
+		}
+		ASSERT(SkylinePacker_insert(&packer,
+					glyph->width + GlyphSdfAtlas_PADDING, glyph->height + GlyphSdfAtlas_PADDING,
+					&glyph->atlasX, &glyph->atlasY));
+	}
+	atlas->width = width;
+	atlas->height = (0 == packer.height)? 1 : packer.height;
+	SkylinePacker_free(&packer);
+	free(order);
+
+	atlas->pixels = (uint8_t *)ffmalloc(atlas->width * atlas->height);
+	for(size_t i = 0; i < glyphNum; i++){
+		GlyphSdfAtlasGlyph *glyph = &atlas->glyphs[i];
+		for(size_t y = 0; y < glyph->height; y++){
+			memcpy(&atlas->pixels[((glyph->atlasY + y) * atlas->width) + glyph->atlasX],
+					&glyph->sdf[y * glyph->width], glyph->width);
+		}
+		free(glyph->sdf);
+		glyph->sdf = NULL;
+	}
+	return isAllValid;
+}
+
+#endif // #ifndef DAISYFF_GLYPH_SDF_HPP_
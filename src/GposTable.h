@@ -0,0 +1,962 @@
+/**
+  @file
+  @brief 'GPOS' Table: pair kerning('kern' feature)の生成。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  pair一覧からglyphを左右のclassへまとめてPairPos format 2で出力し、
+  classの値と合わない例外のpairはformat 1のsubtableへ出す(lookup内でformat 2より先に置く)。
+  全pairをformat 1で出した場合(naive)の方が小さければそちらを使う。
+
+  右側: 全ての左glyphに対する値の列が同じglyphを同じclassにする(損失なし)。
+  左側: 行が同じglyphをまとめた後、例外として出すbyte数 < classを1つ増やすbyte数 なら既存classへ併合する。
+ */
+#ifndef DAISYFF_GPOS_TABLE_HPP_
+#define DAISYFF_GPOS_TABLE_HPP_
+
+#include "src/Util.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GposTable_OFFSET16_MAX			(UINT16_MAX)
+#define GposTable_LookupType_PairAdjustment	(2)
+#define GposTable_LookupType_Extension		(9)
+#define GposTable_ValueFormat_X_ADVANCE		(0x0004)
+
+typedef struct{
+	uint16_t		left;		//!< first glyph id
+	uint16_t		right;		//!< second glyph id
+	int16_t			xAdvance;
+	uint32_t		order;		//!< 追加順(同じpairは後に追加した値を使う)
+}GposKernPair;
+
+typedef struct{
+	size_t			pairNum;	//!< 重複と値0を除いたpair数
+	size_t			leftClassNum;	//!< Class1Count(format 2を使わない場合は0)
+	size_t			rightClassNum;	//!< Class2Count
+	size_t			exceptionNum;	//!< format 1へ出したpair数
+	size_t			naiveSize;	//!< 全pairをformat 1で出した場合のTableサイズ(圧縮前)
+	size_t			tableSize;	//!< 出力したTableサイズ(圧縮後)
+}GposKernReport;
+
+typedef struct{
+	GposKernPair		*pairs;
+	size_t			pairNum;
+	size_t			pairCapacity;
+	FFByteArray		byteArray;
+	GposKernReport		report;
+}GposTableBuf;
+
+// ********
+// Coverage, ClassDef
+// ********
+
+//! @param glyphs 昇順・重複なし
+size_t GposTable_coverageRangeNum_inline_(const uint16_t *glyphs, size_t num)
+{
+	size_t rangeNum = 0;
+	for(size_t i = 0; i < num; i++){
+		if(0 == i || glyphs[i - 1] + 1 != glyphs[i]){
+			rangeNum++;
+		}
+	}
+	return rangeNum;
+}
+
+size_t GposTable_coverageSize_inline_(const uint16_t *glyphs, size_t num)
+{
+	const size_t format1Size = 4 + (2 * num);
+	const size_t format2Size = 4 + (6 * GposTable_coverageRangeNum_inline_(glyphs, num));
+	return (format1Size <= format2Size)? format1Size : format2Size;
+}
+
+void GposTable_writeCoverage_inline_(FFByteWriter *writer, const uint16_t *glyphs, size_t num)
+{
+	const size_t rangeNum = GposTable_coverageRangeNum_inline_(glyphs, num);
+	if((2 * num) <= (6 * rangeNum)){
+		FFByteWriter_uint16(writer, 1);
+		FFByteWriter_uint16(writer, num);
+		for(size_t i = 0; i < num; i++){
+			FFByteWriter_uint16(writer, glyphs[i]);
+		}
+		return;
+	}
+
+	FFByteWriter_uint16(writer, 2);
+	FFByteWriter_uint16(writer, rangeNum);
+	size_t coverageIndex = 0;
+	for(size_t i = 0; i < num; ){
+		size_t end = i + 1;
+		while(end < num && glyphs[end - 1] + 1 == glyphs[end]){
+			end++;
+		}
+		FFByteWriter_uint16(writer, glyphs[i]);		// startGlyphID
+		FFByteWriter_uint16(writer, glyphs[end - 1]);	// endGlyphID
+		FFByteWriter_uint16(writer, coverageIndex);	// startCoverageIndex
+		coverageIndex += end - i;
+		i = end;
+	}
+}
+
+typedef struct{
+	uint16_t		glyph;
+	uint16_t		classValue;
+}GposGlyphClass;
+
+size_t GposTable_classDefRangeNum_inline_(const GposGlyphClass *entries, size_t num)
+{
+	size_t rangeNum = 0;
+	for(size_t i = 0; i < num; i++){
+		if(0 == i || entries[i - 1].glyph + 1 != entries[i].glyph
+				|| entries[i - 1].classValue != entries[i].classValue){
+			rangeNum++;
+		}
+	}
+	return rangeNum;
+}
+
+size_t GposTable_classDefSize_inline_(const GposGlyphClass *entries, size_t num)
+{
+	if(0 == num){
+		return 4;
+	}
+	const size_t format1Size = 6 + (2 * (entries[num - 1].glyph - entries[0].glyph + 1));
+	const size_t format2Size = 4 + (6 * GposTable_classDefRangeNum_inline_(entries, num));
+	return (format1Size <= format2Size)? format1Size : format2Size;
+}
+
+//! @param entries glyph昇順・class 0は含めない
+void GposTable_writeClassDef_inline_(FFByteWriter *writer, const GposGlyphClass *entries, size_t num)
+{
+	const size_t rangeNum = GposTable_classDefRangeNum_inline_(entries, num);
+	if(0 < num && (6 + (2 * (entries[num - 1].glyph - entries[0].glyph + 1))) <= (4 + (6 * rangeNum))){
+		const uint16_t startGlyph = entries[0].glyph;
+		const size_t glyphCount = entries[num - 1].glyph - startGlyph + 1;
+		FFByteWriter_uint16(writer, 1);
+		FFByteWriter_uint16(writer, startGlyph);
+		FFByteWriter_uint16(writer, glyphCount);
+		size_t e = 0;
+		for(size_t g = 0; g < glyphCount; g++){
+			if(e < num && entries[e].glyph == startGlyph + g){
+				FFByteWriter_uint16(writer, entries[e].classValue);
+				e++;
+			}else{
+				FFByteWriter_uint16(writer, 0);
+			}
+		}
+		return;
+	}
+
+	FFByteWriter_uint16(writer, 2);
+	FFByteWriter_uint16(writer, rangeNum);
+	for(size_t i = 0; i < num; ){
+		size_t end = i + 1;
+		while(end < num && entries[end - 1].glyph + 1 == entries[end].glyph
+				&& entries[end - 1].classValue == entries[end].classValue){
+			end++;
+		}
+		FFByteWriter_uint16(writer, entries[i].glyph);
+		FFByteWriter_uint16(writer, entries[end - 1].glyph);
+		FFByteWriter_uint16(writer, entries[i].classValue);
+		i = end;
+	}
+}
+
+// ********
+// PairPos subtable
+// ********
+
+typedef struct{
+	size_t			*offsets;	//!< subtable先頭のwriter内位置
+	size_t			num;
+}GposSubtableList;
+
+void GposSubtableList_append_inline_(GposSubtableList *list, size_t offset)
+{
+	list->offsets = (size_t *)ffrealloc(list->offsets, sizeof(size_t) * (list->num + 1));
+	list->offsets[list->num++] = offset;
+}
+
+/** @brief PairPos format 1を書き出す。PairSetのoffset(16bit)に収まるようsubtableを分割する。
+  @param pairs (left, right)昇順
+  */
+void GposTable_writePairPosFormat1_inline_(
+		FFByteWriter *writer,
+		GposSubtableList *subtables,
+		const GposKernPair *pairs,
+		size_t pairNum)
+{
+	uint16_t *lefts = (uint16_t *)ffmalloc(sizeof(uint16_t) * (pairNum + 1));
+	size_t begin = 0;
+	while(begin < pairNum){
+		// ** このsubtableに入れる左glyphを決める(PairSetの開始位置が16bit offsetに収まる範囲)
+		size_t leftNum = 0;
+		size_t end = begin;
+		size_t pairSetsSize = 0;
+		while(end < pairNum){
+			size_t groupEnd = end;
+			while(groupEnd < pairNum && pairs[groupEnd].left == pairs[end].left){
+				groupEnd++;
+			}
+			// 見積もり: header + PairSetOffsets[] + Coverage(format 1の上限)
+			const size_t headSize = 10 + (2 * (leftNum + 1)) + (4 + (2 * (leftNum + 1)));
+			if(0 < leftNum && GposTable_OFFSET16_MAX < headSize + pairSetsSize){
+				break;
+			}
+			lefts[leftNum++] = pairs[end].left;
+			pairSetsSize += 2 + (4 * (groupEnd - end));
+			end = groupEnd;
+		}
+
+		// ** subtable
+		const size_t subtableOffset = writer->length;
+		GposSubtableList_append_inline_(subtables, subtableOffset);
+		FFByteWriter_uint16(writer, 1);					// posFormat
+		const size_t coverageOffsetPosition = writer->length;
+		FFByteWriter_uint16(writer, 0);					// coverageOffset
+		FFByteWriter_uint16(writer, GposTable_ValueFormat_X_ADVANCE);	// valueFormat1
+		FFByteWriter_uint16(writer, 0);					// valueFormat2
+		FFByteWriter_uint16(writer, leftNum);				// pairSetCount
+		const size_t pairSetOffsetsPosition = writer->length;
+		for(size_t i = 0; i < leftNum; i++){
+			FFByteWriter_uint16(writer, 0);				// pairSetOffsets[]
+		}
+		FFByteWriter_setUint16(writer, coverageOffsetPosition, writer->length - subtableOffset);
+		GposTable_writeCoverage_inline_(writer, lefts, leftNum);
+
+		size_t p = begin;
+		for(size_t i = 0; i < leftNum; i++){
+			FFByteWriter_setUint16(writer, pairSetOffsetsPosition + (2 * i), writer->length - subtableOffset);
+			size_t groupEnd = p;
+			while(groupEnd < end && pairs[groupEnd].left == lefts[i]){
+				groupEnd++;
+			}
+			FFByteWriter_uint16(writer, groupEnd - p);			// pairValueCount
+			for(; p < groupEnd; p++){
+				FFByteWriter_uint16(writer, pairs[p].right);		// secondGlyph
+				FFByteWriter_uint16(writer, (uint16_t)pairs[p].xAdvance);	// valueRecord1.xAdvance
+			}
+		}
+		begin = end;
+	}
+	free(lefts);
+}
+
+typedef struct{
+	const GposKernPair	*pairs;		//!< (left, right)昇順・重複なし
+	size_t			pairNum;
+	size_t			rightClassNum;	//!< Class2Count(class 0含む)
+	const uint16_t		*rightClassOfGlyph;	//!< [65536]
+	const int16_t		*classValues;	//!< [leftClassNum][rightClassNum]
+	const uint16_t		*leftClassOfGlyph;	//!< [65536]
+	const uint16_t		*leftGlyphs;	//!< 昇順
+	size_t			leftGlyphNum;
+	size_t			leftClassNum;
+}GposClassKerning;
+
+/** @brief PairPos format 2を書き出す。
+  Class1Record[]の後ろに置くCoverage, ClassDefが16bit offsetに収まるよう、左classでsubtableを分割する。
+  @return false: 右classが多すぎて1行も収まらない
+  */
+bool GposTable_writePairPosFormat2_inline_(
+		FFByteWriter *writer,
+		GposSubtableList *subtables,
+		const GposClassKerning *kerning)
+{
+	const size_t rowSize = 2 * kerning->rightClassNum;
+
+	// ClassDef2(subtable毎に同じものを置く)
+	GposGlyphClass *classDef2 = (GposGlyphClass *)ffmalloc(sizeof(GposGlyphClass) * (UINT16_MAX + 1));
+	size_t classDef2Num = 0;
+	for(size_t g = 0; g <= UINT16_MAX; g++){
+		if(0 != kerning->rightClassOfGlyph[g]){
+			classDef2[classDef2Num++] = (GposGlyphClass){(uint16_t)g, kerning->rightClassOfGlyph[g]};
+		}
+	}
+
+	// 左classの行番号 -> subtable内の行番号
+	uint16_t *localClass = (uint16_t *)ffmalloc(sizeof(uint16_t) * kerning->leftClassNum);
+	GposGlyphClass *classDef1 = (GposGlyphClass *)ffmalloc(sizeof(GposGlyphClass) * (kerning->leftGlyphNum + 1));
+	uint16_t *coverage = (uint16_t *)ffmalloc(sizeof(uint16_t) * (kerning->leftGlyphNum + 1));
+	uint16_t *chunkClasses = (uint16_t *)ffmalloc(sizeof(uint16_t) * kerning->leftClassNum);
+	bool isSuccess = true;
+
+	size_t classBegin = 0;
+	while(classBegin < kerning->leftClassNum){
+		// ** このsubtableに入れる左classを決める
+		//    ClassDef2のoffsetが16bitに収まる範囲。Coverage, ClassDef1は全左glyph分の上限で見積もる。
+		const size_t coverageAndClassDef1Max = (4 + (2 * kerning->leftGlyphNum)) + (4 + (6 * kerning->leftGlyphNum));
+		size_t classEnd = classBegin;
+		while(classEnd < kerning->leftClassNum
+				&& (16 + ((classEnd - classBegin + 1) * rowSize) + coverageAndClassDef1Max) <= GposTable_OFFSET16_MAX){
+			classEnd++;
+		}
+		if(classBegin == classEnd){
+			isSuccess = false;
+			break;
+		}
+		const size_t chunkClassNum = classEnd - classBegin;
+		for(size_t c = 0; c < kerning->leftClassNum; c++){
+			localClass[c] = UINT16_MAX;
+		}
+		for(size_t c = 0; c < chunkClassNum; c++){
+			localClass[classBegin + c] = (uint16_t)c;
+			chunkClasses[c] = (uint16_t)(classBegin + c);
+		}
+		size_t coverageNum = 0;
+		size_t classDef1Num = 0;
+		for(size_t i = 0; i < kerning->leftGlyphNum; i++){
+			const uint16_t glyph = kerning->leftGlyphs[i];
+			const uint16_t local = localClass[kerning->leftClassOfGlyph[glyph]];
+			if(UINT16_MAX == local){
+				continue;
+			}
+			coverage[coverageNum++] = glyph;
+			if(0 != local){
+				classDef1[classDef1Num++] = (GposGlyphClass){glyph, local};
+			}
+		}
+
+		// ** subtable
+		const size_t subtableOffset = writer->length;
+		GposSubtableList_append_inline_(subtables, subtableOffset);
+		FFByteWriter_uint16(writer, 2);					// posFormat
+		const size_t coverageOffsetPosition = writer->length;
+		FFByteWriter_uint16(writer, 0);					// coverageOffset
+		FFByteWriter_uint16(writer, GposTable_ValueFormat_X_ADVANCE);	// valueFormat1
+		FFByteWriter_uint16(writer, 0);					// valueFormat2
+		const size_t classDef1OffsetPosition = writer->length;
+		FFByteWriter_uint16(writer, 0);					// classDef1Offset
+		const size_t classDef2OffsetPosition = writer->length;
+		FFByteWriter_uint16(writer, 0);					// classDef2Offset
+		FFByteWriter_uint16(writer, chunkClassNum);			// class1Count
+		FFByteWriter_uint16(writer, kerning->rightClassNum);		// class2Count
+		for(size_t c = 0; c < chunkClassNum; c++){
+			const int16_t *row = &kerning->classValues[chunkClasses[c] * kerning->rightClassNum];
+			for(size_t k = 0; k < kerning->rightClassNum; k++){
+				FFByteWriter_uint16(writer, (uint16_t)row[k]);	// class2Records[].valueRecord1.xAdvance
+			}
+		}
+		FFByteWriter_setUint16(writer, coverageOffsetPosition, writer->length - subtableOffset);
+		GposTable_writeCoverage_inline_(writer, coverage, coverageNum);
+		FFByteWriter_setUint16(writer, classDef1OffsetPosition, writer->length - subtableOffset);
+		GposTable_writeClassDef_inline_(writer, classDef1, classDef1Num);
+		FFByteWriter_setUint16(writer, classDef2OffsetPosition, writer->length - subtableOffset);
+		GposTable_writeClassDef_inline_(writer, classDef2, classDef2Num);
+
+		classBegin = classEnd;
+	}
+
+	free(chunkClasses);
+	free(coverage);
+	free(classDef1);
+	free(localClass);
+	free(classDef2);
+	return isSuccess;
+}
+
+// ********
+// GPOS Table
+// ********
+
+/** @brief ScriptList(DFLT), FeatureList(kern), LookupListを書き出し、subtableを続ける。
+  subtableへのoffset(16bit)に収まらない場合はExtension lookup(type 9)で包む。
+  @param subtableData subtable群(subtableOffsetsはこの先頭からの位置)
+  */
+void GposTable_writeTable_inline_(
+		FFByteWriter *writer,
+		const FFByteWriter *subtableData,
+		const GposSubtableList *subtables)
+{
+	// ** Header
+	FFByteWriter_uint16(writer, 1);		// majorVersion
+	FFByteWriter_uint16(writer, 0);		// minorVersion
+	FFByteWriter_uint16(writer, 10);		// scriptListOffset
+	FFByteWriter_uint16(writer, 10 + 20);	// featureListOffset
+	FFByteWriter_uint16(writer, 10 + 20 + 14);	// lookupListOffset
+
+	// ** ScriptList
+	FFByteWriter_uint16(writer, 1);		// scriptCount
+	FFByteWriter_bytes(writer, (const uint8_t *)"DFLT", 4);		// scriptRecords[0].scriptTag
+	FFByteWriter_uint16(writer, 8);		// scriptRecords[0].scriptOffset
+	// Script
+	FFByteWriter_uint16(writer, 4);		// defaultLangSysOffset
+	FFByteWriter_uint16(writer, 0);		// langSysCount
+	// LangSys
+	FFByteWriter_uint16(writer, 0);		// lookupOrderOffset
+	FFByteWriter_uint16(writer, 0xFFFF);	// requiredFeatureIndex
+	FFByteWriter_uint16(writer, 1);		// featureIndexCount
+	FFByteWriter_uint16(writer, 0);		// featureIndices[0]
+
+	// ** FeatureList
+	FFByteWriter_uint16(writer, 1);		// featureCount
+	FFByteWriter_bytes(writer, (const uint8_t *)"kern", 4);		// featureRecords[0].featureTag
+	FFByteWriter_uint16(writer, 8);		// featureRecords[0].featureOffset
+	// Feature
+	FFByteWriter_uint16(writer, 0);		// featureParamsOffset
+	FFByteWriter_uint16(writer, 1);		// lookupIndexCount
+	FFByteWriter_uint16(writer, 0);		// lookupListIndices[0]
+
+	// ** LookupList
+	FFByteWriter_uint16(writer, 1);		// lookupCount
+	FFByteWriter_uint16(writer, 4);		// lookupOffsets[0]
+	// Lookup
+	const size_t lookupHeadSize = 6 + (2 * subtables->num);
+	const bool isExtension = (GposTable_OFFSET16_MAX < lookupHeadSize + subtableData->length);
+	const size_t lookupOffset = writer->length;
+	FFByteWriter_uint16(writer, (isExtension)? GposTable_LookupType_Extension : GposTable_LookupType_PairAdjustment);
+	FFByteWriter_uint16(writer, 0);		// lookupFlag
+	FFByteWriter_uint16(writer, subtables->num);	// subTableCount
+	if(! isExtension){
+		for(size_t i = 0; i < subtables->num; i++){
+			FFByteWriter_uint16(writer, lookupHeadSize + subtables->offsets[i]);	// subtableOffsets[]
+		}
+	}else{
+		const size_t extensionSize = 8;
+		for(size_t i = 0; i < subtables->num; i++){
+			FFByteWriter_uint16(writer, lookupHeadSize + (extensionSize * i));	// subtableOffsets[]
+		}
+		for(size_t i = 0; i < subtables->num; i++){
+			const size_t extensionOffset = writer->length;
+			FFByteWriter_uint16(writer, 1);					// posFormat
+			FFByteWriter_uint16(writer, GposTable_LookupType_PairAdjustment);	// extensionLookupType
+			const size_t dataOffset = lookupOffset + lookupHeadSize + (extensionSize * subtables->num);
+			FFByteWriter_uint32(writer, dataOffset + subtables->offsets[i] - extensionOffset);	// extensionOffset
+		}
+	}
+	FFByteWriter_bytes(writer, subtableData->data, subtableData->length);
+}
+
+//! @brief format 1のみでGPOS Tableを生成する
+void GposTable_generateFormat1Only_inline_(FFByteWriter *writer, const GposKernPair *pairs, size_t pairNum)
+{
+	FFByteWriter subtableData = {0};
+	GposSubtableList subtables = {0};
+	GposTable_writePairPosFormat1_inline_(&subtableData, &subtables, pairs, pairNum);
+	GposTable_writeTable_inline_(writer, &subtableData, &subtables);
+	free(subtableData.data);
+	free(subtables.offsets);
+}
+
+// ********
+// class clustering
+// ********
+
+int GposKernPair_compareLeftRight_inline_(const void *a_, const void *b_)
+{
+	const GposKernPair *a = (const GposKernPair *)a_;
+	const GposKernPair *b = (const GposKernPair *)b_;
+	if(a->left != b->left){
+		return (a->left < b->left)? -1 : 1;
+	}
+	if(a->right != b->right){
+		return (a->right < b->right)? -1 : 1;
+	}
+	if(a->order != b->order){
+		return (a->order < b->order)? -1 : 1;
+	}
+	return 0;
+}
+
+int GposKernPair_compareRightLeft_inline_(const void *a_, const void *b_)
+{
+	const GposKernPair *a = (const GposKernPair *)a_;
+	const GposKernPair *b = (const GposKernPair *)b_;
+	if(a->right != b->right){
+		return (a->right < b->right)? -1 : 1;
+	}
+	if(a->left != b->left){
+		return (a->left < b->left)? -1 : 1;
+	}
+	return 0;
+}
+
+//! 右classの値の並び(行)・左glyphの値の並び(列)
+typedef struct{
+	size_t			begin;		//!< 要素配列内の位置
+	size_t			num;
+	uint32_t		hash;
+	uint16_t		glyph;
+	size_t			memberNum;	//!< 同じ並びのglyph数(左の行のみ使用)
+}GposKernVector;
+
+typedef struct{
+	uint16_t		key;		//!< 左glyph(列) or 右class(行)
+	int16_t			value;
+}GposKernCell;
+
+_Thread_local const GposKernCell *gposKernCellsForCompare_ = NULL; //!< qsort()の比較用(finally中のみ有効)
+
+uint32_t GposKernVector_hash_inline_(const GposKernCell *cells, size_t num)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < num; i++){
+		hash = (hash ^ cells[i].key) * 16777619u;
+		hash = (hash ^ (uint16_t)cells[i].value) * 16777619u;
+	}
+	return hash;
+}
+
+int GposKernVector_compare_inline_(const GposKernVector *a, const GposKernVector *b, const GposKernCell *cells)
+{
+	if(a->hash != b->hash){
+		return (a->hash < b->hash)? -1 : 1;
+	}
+	if(a->num != b->num){
+		return (a->num < b->num)? -1 : 1;
+	}
+	for(size_t i = 0; i < a->num; i++){
+		const GposKernCell *ca = &cells[a->begin + i];
+		const GposKernCell *cb = &cells[b->begin + i];
+		if(ca->key != cb->key){
+			return (ca->key < cb->key)? -1 : 1;
+		}
+		if(ca->value != cb->value){
+			return (ca->value < cb->value)? -1 : 1;
+		}
+	}
+	if(a->glyph != b->glyph){
+		return (a->glyph < b->glyph)? -1 : 1;
+	}
+	return 0;
+}
+
+int GposKernVector_qsortCompare_inline_(const void *a, const void *b)
+{
+	return GposKernVector_compare_inline_((const GposKernVector *)a, (const GposKernVector *)b, gposKernCellsForCompare_);
+}
+
+bool GposKernVector_isSameCells_inline_(const GposKernVector *a, const GposKernVector *b, const GposKernCell *cells)
+{
+	if(a->hash != b->hash || a->num != b->num){
+		return false;
+	}
+	for(size_t i = 0; i < a->num; i++){
+		if(cells[a->begin + i].key != cells[b->begin + i].key
+				|| cells[a->begin + i].value != cells[b->begin + i].value){
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief 行gを代表行cの左classへ併合した場合に例外として出すbyte数。
+  @param limit これ以上になったら打ち切る
+  */
+size_t GposKernVector_mergeCost_inline_(
+		const GposKernVector *g,
+		const GposKernVector *c,
+		const GposKernCell *cells,
+		const size_t *rightClassSizes,
+		size_t limit)
+{
+	size_t cost = 0;
+	size_t i = 0;
+	size_t j = 0;
+	while(i < g->num || j < c->num){
+		const GposKernCell *cg = (i < g->num)? &cells[g->begin + i] : NULL;
+		const GposKernCell *cc = (j < c->num)? &cells[c->begin + j] : NULL;
+		uint16_t key;
+		bool isDiffer;
+		if(NULL != cg && (NULL == cc || cg->key < cc->key)){
+			key = cg->key; isDiffer = true; i++;
+		}else if(NULL != cc && (NULL == cg || cc->key < cg->key)){
+			key = cc->key; isDiffer = true; j++;
+		}else{
+			key = cg->key; isDiffer = (cg->value != cc->value); i++; j++;
+		}
+		if(isDiffer){
+			// PairValueRecord(secondGlyph + xAdvance) * 右classのglyph数 * 左glyph数
+			cost += 4 * rightClassSizes[key] * g->memberNum;
+			if(limit <= cost){
+				return cost;
+			}
+		}
+	}
+	if(0 < cost){
+		// PairSet(pairValueCount + offset + coverage)
+		cost += 6 * g->memberNum;
+	}
+	return cost;
+}
+
+int GposKernVector_compareMemberNum_inline_(const void *a_, const void *b_)
+{
+	const GposKernVector *a = (const GposKernVector *)a_;
+	const GposKernVector *b = (const GposKernVector *)b_;
+	if(a->memberNum != b->memberNum){
+		return (a->memberNum > b->memberNum)? -1 : 1;
+	}
+	return (a->glyph < b->glyph)? -1 : ((a->glyph > b->glyph)? 1 : 0);
+}
+
+/** @brief class kerningを組み立ててformat 1(例外) + format 2で書き出す。
+  @param pairs (left, right)昇順・重複なし・値0なし
+  @return false: format 2に収まらない
+  */
+bool GposTable_generateClassKerning_inline_(
+		FFByteWriter *writer,
+		const GposKernPair *pairs,
+		size_t pairNum,
+		GposKernReport *report)
+{
+	bool isSuccess = true;
+	const size_t glyphIdNum = UINT16_MAX + 1;
+
+	// ** 右class: 列(左glyph -> 値)が同じ右glyphをまとめる
+	GposKernPair *byRight = (GposKernPair *)ffmalloc(sizeof(GposKernPair) * pairNum);
+	memcpy(byRight, pairs, sizeof(GposKernPair) * pairNum);
+	qsort(byRight, pairNum, sizeof(GposKernPair), GposKernPair_compareRightLeft_inline_);
+	GposKernCell *columnCells = (GposKernCell *)ffmalloc(sizeof(GposKernCell) * pairNum);
+	GposKernVector *columns = (GposKernVector *)ffmalloc(sizeof(GposKernVector) * pairNum);
+	size_t columnNum = 0;
+	for(size_t i = 0; i < pairNum; ){
+		size_t end = i;
+		while(end < pairNum && byRight[end].right == byRight[i].right){
+			columnCells[end] = (GposKernCell){byRight[end].left, byRight[end].xAdvance};
+			end++;
+		}
+		columns[columnNum++] = (GposKernVector){
+			.begin	= i,
+			.num	= end - i,
+			.hash	= GposKernVector_hash_inline_(&columnCells[i], end - i),
+			.glyph	= byRight[i].right,
+		};
+		i = end;
+	}
+	free(byRight);
+	gposKernCellsForCompare_ = columnCells;
+	qsort(columns, columnNum, sizeof(GposKernVector), GposKernVector_qsortCompare_inline_);
+
+	uint16_t *rightClassOfGlyph = (uint16_t *)ffmalloc(sizeof(uint16_t) * glyphIdNum);
+	size_t *rightClassSizes = (size_t *)ffmalloc(sizeof(size_t) * (columnNum + 1));
+	size_t rightClassNum = 1; // class 0: kerningの無い右glyph
+	rightClassSizes[0] = 0;
+	for(size_t i = 0; i < columnNum; i++){
+		if(0 == i || (! GposKernVector_isSameCells_inline_(&columns[i - 1], &columns[i], columnCells))){
+			rightClassSizes[rightClassNum++] = 0;
+		}
+		rightClassOfGlyph[columns[i].glyph] = rightClassNum - 1;
+		rightClassSizes[rightClassNum - 1]++;
+	}
+	free(columns);
+	free(columnCells);
+
+	// ** 左glyphの行(右class -> 値)。同じ右classの右glyphは列が同じなので値も同じ。
+	GposKernCell *rowCells = (GposKernCell *)ffmalloc(sizeof(GposKernCell) * pairNum);
+	GposKernVector *rows = (GposKernVector *)ffmalloc(sizeof(GposKernVector) * pairNum);
+	size_t rowNum = 0;
+	size_t rowCellNum = 0;
+	for(size_t i = 0; i < pairNum; ){
+		size_t end = i;
+		while(end < pairNum && pairs[end].left == pairs[i].left){
+			end++;
+		}
+		const size_t begin = rowCellNum;
+		for(size_t p = i; p < end; p++){
+			rowCells[rowCellNum++] = (GposKernCell){rightClassOfGlyph[pairs[p].right], pairs[p].xAdvance};
+		}
+		// 右class順に並べて重複を除く(挿入ソート: 行は短い)
+		for(size_t a = begin + 1; a < rowCellNum; a++){
+			const GposKernCell cell = rowCells[a];
+			size_t b = a;
+			while(begin < b && cell.key < rowCells[b - 1].key){
+				rowCells[b] = rowCells[b - 1];
+				b--;
+			}
+			rowCells[b] = cell;
+		}
+		size_t uniqueEnd = begin;
+		for(size_t a = begin; a < rowCellNum; a++){
+			if(begin == uniqueEnd || rowCells[uniqueEnd - 1].key != rowCells[a].key){
+				rowCells[uniqueEnd++] = rowCells[a];
+			}
+		}
+		rowCellNum = uniqueEnd;
+		rows[rowNum++] = (GposKernVector){
+			.begin		= begin,
+			.num		= rowCellNum - begin,
+			.hash		= GposKernVector_hash_inline_(&rowCells[begin], rowCellNum - begin),
+			.glyph		= pairs[i].left,
+			.memberNum	= 1,
+		};
+		i = end;
+	}
+
+	// ** 左: 行が同じglyphをまとめる
+	uint16_t *leftGlyphs = (uint16_t *)ffmalloc(sizeof(uint16_t) * (rowNum + 1));
+	for(size_t i = 0; i < rowNum; i++){
+		leftGlyphs[i] = rows[i].glyph; // pairsが左昇順なので昇順
+	}
+	const size_t leftGlyphNum = rowNum;
+	gposKernCellsForCompare_ = rowCells;
+	qsort(rows, rowNum, sizeof(GposKernVector), GposKernVector_qsortCompare_inline_);
+	gposKernCellsForCompare_ = NULL;
+
+	uint16_t *groupOfGlyph = (uint16_t *)ffmalloc(sizeof(uint16_t) * glyphIdNum);
+	GposKernVector *groups = (GposKernVector *)ffmalloc(sizeof(GposKernVector) * (rowNum + 1));
+	size_t groupNum = 0;
+	for(size_t i = 0; i < rowNum; i++){
+		if(0 == i || (! GposKernVector_isSameCells_inline_(&rows[i - 1], &rows[i], rowCells))){
+			groups[groupNum] = rows[i];
+			groups[groupNum].memberNum = 0;
+			groupNum++;
+		}
+		groupOfGlyph[rows[i].glyph] = groupNum - 1;
+		groups[groupNum - 1].memberNum++;
+	}
+	free(rows);
+
+	// ** 左class: glyph数の多い並びから順に、例外のbyte数 < 行のbyte数なら既存classへ併合する
+	uint16_t *groupOrder = (uint16_t *)ffmalloc(sizeof(uint16_t) * (groupNum + 1));
+	{
+		GposKernVector *sorted = (GposKernVector *)ffmalloc(sizeof(GposKernVector) * (groupNum + 1));
+		for(size_t i = 0; i < groupNum; i++){
+			sorted[i] = groups[i];
+			sorted[i].begin = i; // 元の位置を覚えておく(cellは使わない)
+		}
+		qsort(sorted, groupNum, sizeof(GposKernVector), GposKernVector_compareMemberNum_inline_);
+		for(size_t i = 0; i < groupNum; i++){
+			groupOrder[i] = (uint16_t)sorted[i].begin;
+		}
+		free(sorted);
+	}
+	size_t *classOfGroup = (size_t *)ffmalloc(sizeof(size_t) * (groupNum + 1));
+	size_t *classRepresentative = (size_t *)ffmalloc(sizeof(size_t) * (groupNum + 1));
+	size_t *classMemberNum = (size_t *)ffmalloc(sizeof(size_t) * (groupNum + 1));
+	size_t leftClassNum = 0;
+	const size_t newClassCost = 2 * rightClassNum;
+	for(size_t o = 0; o < groupNum; o++){
+		const size_t g = groupOrder[o];
+		size_t bestClass = SIZE_MAX;
+		size_t bestCost = newClassCost;
+		for(size_t c = 0; c < leftClassNum && 0 < bestCost; c++){
+			const size_t cost = GposKernVector_mergeCost_inline_(
+					&groups[g], &groups[classRepresentative[c]], rowCells, rightClassSizes, bestCost);
+			if(cost < bestCost){
+				bestCost = cost;
+				bestClass = c;
+			}
+		}
+		if(SIZE_MAX == bestClass){
+			bestClass = leftClassNum;
+			classRepresentative[leftClassNum] = g;
+			classMemberNum[leftClassNum] = 0;
+			leftClassNum++;
+		}
+		classOfGroup[g] = bestClass;
+		classMemberNum[bestClass] += groups[g].memberNum;
+	}
+	free(groupOrder);
+
+	// ** class番号: glyph数の最も多いclassをclass 0にする(ClassDef1に載せずに済む)
+	size_t largestClass = 0;
+	for(size_t c = 1; c < leftClassNum; c++){
+		if(classMemberNum[largestClass] < classMemberNum[c]){
+			largestClass = c;
+		}
+	}
+	size_t *classNumber = (size_t *)ffmalloc(sizeof(size_t) * (leftClassNum + 1));
+	for(size_t c = 0, n = 1; c < leftClassNum; c++){
+		classNumber[c] = (c == largestClass)? 0 : n++;
+	}
+	int16_t *classValues = (int16_t *)ffmalloc(sizeof(int16_t) * leftClassNum * rightClassNum);
+	for(size_t c = 0; c < leftClassNum; c++){
+		const GposKernVector *rep = &groups[classRepresentative[c]];
+		int16_t *row = &classValues[classNumber[c] * rightClassNum];
+		for(size_t i = 0; i < rep->num; i++){
+			row[rowCells[rep->begin + i].key] = rowCells[rep->begin + i].value;
+		}
+	}
+	uint16_t *leftClassOfGlyph = (uint16_t *)ffmalloc(sizeof(uint16_t) * glyphIdNum);
+	for(size_t i = 0; i < leftGlyphNum; i++){
+		const uint16_t glyph = leftGlyphs[i];
+		leftClassOfGlyph[glyph] = classNumber[classOfGroup[groupOfGlyph[glyph]]];
+	}
+	free(classNumber);
+	free(classMemberNum);
+	free(classRepresentative);
+	free(classOfGroup);
+	free(groups);
+	free(groupOfGlyph);
+	free(rowCells);
+
+	// ** 例外: classの値と異なるpair(classの値が0でないのにpairが無い場合は値0のpair)
+	uint16_t **rightGlyphsOfClass = (uint16_t **)ffmalloc(sizeof(uint16_t *) * rightClassNum);
+	{
+		size_t *filled = (size_t *)ffmalloc(sizeof(size_t) * rightClassNum);
+		for(size_t k = 1; k < rightClassNum; k++){
+			rightGlyphsOfClass[k] = (uint16_t *)ffmalloc(sizeof(uint16_t) * rightClassSizes[k]);
+		}
+		for(size_t g = 0; g < glyphIdNum; g++){
+			const uint16_t k = rightClassOfGlyph[g];
+			if(0 != k){
+				rightGlyphsOfClass[k][filled[k]++] = (uint16_t)g;
+			}
+		}
+		free(filled);
+	}
+	GposKernPair *exceptions = NULL;
+	size_t exceptionNum = 0;
+	size_t exceptionCapacity = 0;
+	int16_t *actualRow = (int16_t *)ffmalloc(sizeof(int16_t) * rightClassNum);
+	bool *isPairRow = (bool *)ffmalloc(sizeof(bool) * rightClassNum);
+	for(size_t i = 0; i < pairNum; ){
+		size_t end = i;
+		while(end < pairNum && pairs[end].left == pairs[i].left){
+			end++;
+		}
+		const uint16_t left = pairs[i].left;
+		const int16_t *classRow = &classValues[leftClassOfGlyph[left] * rightClassNum];
+		memset(isPairRow, 0, sizeof(bool) * rightClassNum);
+		for(size_t p = i; p < end; p++){
+			const uint16_t k = rightClassOfGlyph[pairs[p].right];
+			actualRow[k] = pairs[p].xAdvance;
+			isPairRow[k] = true;
+		}
+		for(size_t k = 1; k < rightClassNum; k++){
+			const int16_t actual = (isPairRow[k])? actualRow[k] : 0;
+			if(actual == classRow[k]){
+				continue;
+			}
+			if(exceptionCapacity < exceptionNum + rightClassSizes[k]){
+				exceptionCapacity = (exceptionCapacity + rightClassSizes[k]) * 2;
+				exceptions = (GposKernPair *)ffrealloc(exceptions, sizeof(GposKernPair) * exceptionCapacity);
+			}
+			for(size_t r = 0; r < rightClassSizes[k]; r++){
+				exceptions[exceptionNum++] = (GposKernPair){left, rightGlyphsOfClass[k][r], actual, 0};
+			}
+		}
+		i = end;
+	}
+	free(isPairRow);
+	free(actualRow);
+	for(size_t k = 1; k < rightClassNum; k++){
+		free(rightGlyphsOfClass[k]);
+	}
+	free(rightGlyphsOfClass);
+	free(rightClassSizes);
+	qsort(exceptions, exceptionNum, sizeof(GposKernPair), GposKernPair_compareLeftRight_inline_);
+
+	// ** 書き出し: 例外(format 1)を先に置き、一致しなかったpairはformat 2で引く
+	FFByteWriter subtableData = {0};
+	GposSubtableList subtables = {0};
+	GposTable_writePairPosFormat1_inline_(&subtableData, &subtables, exceptions, exceptionNum);
+	const GposClassKerning kerning = {
+		.pairs			= pairs,
+		.pairNum		= pairNum,
+		.rightClassNum		= rightClassNum,
+		.rightClassOfGlyph	= rightClassOfGlyph,
+		.classValues		= classValues,
+		.leftClassOfGlyph	= leftClassOfGlyph,
+		.leftGlyphs		= leftGlyphs,
+		.leftGlyphNum		= leftGlyphNum,
+		.leftClassNum		= leftClassNum,
+	};
+	isSuccess = GposTable_writePairPosFormat2_inline_(&subtableData, &subtables, &kerning);
+	if(isSuccess){
+		GposTable_writeTable_inline_(writer, &subtableData, &subtables);
+		report->leftClassNum	= leftClassNum;
+		report->rightClassNum	= rightClassNum;
+		report->exceptionNum	= exceptionNum;
+	}
+	free(subtableData.data);
+	free(subtables.offsets);
+
+	free(exceptions);
+	free(leftClassOfGlyph);
+	free(classValues);
+	free(leftGlyphs);
+	free(rightClassOfGlyph);
+
+	return isSuccess;
+}
+
+// ********
+// GposTableBuf
+// ********
+
+void GposTableBuf_appendPair(GposTableBuf *gposTableBuf, uint16_t left, uint16_t right, int16_t xAdvance)
+{
+	ASSERT(gposTableBuf);
+	if(gposTableBuf->pairCapacity == gposTableBuf->pairNum){
+		gposTableBuf->pairCapacity = (0 == gposTableBuf->pairCapacity)? 256 : (gposTableBuf->pairCapacity * 2);
+		gposTableBuf->pairs = (GposKernPair *)ffrealloc(
+				gposTableBuf->pairs, sizeof(GposKernPair) * gposTableBuf->pairCapacity);
+	}
+	gposTableBuf->pairs[gposTableBuf->pairNum] = (GposKernPair){
+		.left		= left,
+		.right		= right,
+		.xAdvance	= xAdvance,
+		.order		= (uint32_t)gposTableBuf->pairNum,
+	};
+	gposTableBuf->pairNum++;
+}
+
+/** @brief 'GPOS' Tableのbyte列(byteArray)とreportを生成する。
+  同じpairは後に追加した値を使い、値0のpairは除く。
+  */
+void GposTableBuf_finally(GposTableBuf *gposTableBuf)
+{
+	ASSERT(gposTableBuf);
+	ASSERT(NULL == gposTableBuf->byteArray.data);
+	FFTRACE_BEGIN("GPOS", "table");
+
+	// ** 正規化
+	qsort(gposTableBuf->pairs, gposTableBuf->pairNum, sizeof(GposKernPair), GposKernPair_compareLeftRight_inline_);
+	size_t pairNum = 0;
+	for(size_t i = 0; i < gposTableBuf->pairNum; i++){
+		const GposKernPair *pair = &gposTableBuf->pairs[i];
+		const bool isLast = (i + 1 == gposTableBuf->pairNum)
+			|| pair->left != gposTableBuf->pairs[i + 1].left
+			|| pair->right != gposTableBuf->pairs[i + 1].right;
+		if(isLast && 0 != pair->xAdvance){
+			gposTableBuf->pairs[pairNum++] = *pair;
+		}
+	}
+	gposTableBuf->pairNum = pairNum;
+
+	GposKernReport report = {.pairNum = pairNum};
+
+	// ** 全pairをformat 1で出した場合
+	FFByteWriter naive = {0};
+	GposTable_generateFormat1Only_inline_(&naive, gposTableBuf->pairs, pairNum);
+	report.naiveSize = naive.length;
+
+	// ** class kerning
+	FFByteWriter compact = {0};
+	GposKernReport compactReport = report;
+	const bool isClassKerning = GposTable_generateClassKerning_inline_(
+			&compact, gposTableBuf->pairs, pairNum, &compactReport);
+
+	FFByteWriter *result = &naive;
+	if(isClassKerning && compact.length < naive.length){
+		result = &compact;
+		report = compactReport;
+	}else{
+		report.exceptionNum = pairNum;
+	}
+	report.tableSize = result->length;
+	gposTableBuf->byteArray = (FFByteArray){
+		.length	= result->length,
+		.data	= result->data,
+	};
+	free((result == &naive)? compact.data : naive.data);
+	gposTableBuf->report = report;
+
+	DEBUG_LOG("GPOS pairs:%zu class:%zu x %zu exceptions:%zu size:%zu -> %zu",
+			report.pairNum, report.leftClassNum, report.rightClassNum,
+			report.exceptionNum, report.naiveSize, report.tableSize);
+	FFTRACE_END("GPOS", "table");
+}
+
+void GposTableBuf_free(GposTableBuf *gposTableBuf)
+{
+	free(gposTableBuf->pairs);
+	FFByteArray_free(&gposTableBuf->byteArray);
+	*gposTableBuf = (GposTableBuf){0};
+}
+
+#endif // #ifndef DAISYFF_GPOS_TABLE_HPP_
+
@@ -0,0 +1,202 @@
+/**
+  @file
+  @brief JSON/NDJSONを固定長のbufferへ組み立て、一杯になった時だけFILEへ書く。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  値毎にfprintf()を呼ばず、整数は桁を直接bufferへ書く。
+  区切りの','は直前に書いたものから決める(key, 値, 開き括弧の後は付けない)ので、呼び出し側は順に書くだけでよい。
+ */
+#ifndef DAISYFF_JSON_WRITER_HPP_
+#define DAISYFF_JSON_WRITER_HPP_
+
+#include "src/Util.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JsonWriter_BUFFER_SIZE	(64 * 1024)
+
+typedef struct{
+	FILE			*fp;
+	char			buffer[JsonWriter_BUFFER_SIZE];
+	size_t			length;
+	bool			isNeedComma;
+	bool			isError;	//!< 書き込みに失敗した
+}JsonWriter;
+
+void JsonWriter_init(JsonWriter *writer, FILE *fp)
+{
+	writer->fp = fp;
+	writer->length = 0;
+	writer->isNeedComma = false;
+	writer->isError = false;
+}
+
+//! @return false: 書き込みに失敗した(以降の書き込みは捨てる)
+bool JsonWriter_flush(JsonWriter *writer)
+{
+	if(0 < writer->length && ! writer->isError){
+		writer->isError = (writer->length != fwrite(writer->buffer, 1, writer->length, writer->fp));
+	}
+	writer->length = 0;
+	return ! writer->isError;
+}
+
+void JsonWriter_raw(JsonWriter *writer, const char *data, size_t length)
+{
+	if(JsonWriter_BUFFER_SIZE - writer->length < length){
+		JsonWriter_flush(writer);
+		if(JsonWriter_BUFFER_SIZE < length){
+			writer->isError = writer->isError || (length != fwrite(data, 1, length, writer->fp));
+			return;
+		}
+	}
+	memcpy(&writer->buffer[writer->length], data, length);
+	writer->length += length;
+}
+
+void JsonWriter_char_inline_(JsonWriter *writer, char c)
+{
+	if(JsonWriter_BUFFER_SIZE == writer->length){
+		JsonWriter_flush(writer);
+	}
+	writer->buffer[writer->length++] = c;
+}
+
+void JsonWriter_separator_inline_(JsonWriter *writer)
+{
+	if(writer->isNeedComma){
+		JsonWriter_char_inline_(writer, ',');
+	}
+	writer->isNeedComma = true;
+}
+
+void JsonWriter_beginObject(JsonWriter *writer)
+{
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_char_inline_(writer, '{');
+	writer->isNeedComma = false;
+}
+
+void JsonWriter_endObject(JsonWriter *writer)
+{
+	JsonWriter_char_inline_(writer, '}');
+	writer->isNeedComma = true;
+}
+
+void JsonWriter_beginArray(JsonWriter *writer)
+{
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_char_inline_(writer, '[');
+	writer->isNeedComma = false;
+}
+
+void JsonWriter_endArray(JsonWriter *writer)
+{
+	JsonWriter_char_inline_(writer, ']');
+	writer->isNeedComma = true;
+}
+
+//! @brief NDJSONの1行を終える
+void JsonWriter_endLine(JsonWriter *writer)
+{
+	JsonWriter_char_inline_(writer, '\n');
+	writer->isNeedComma = false;
+}
+
+void JsonWriter_stringValue_inline_(JsonWriter *writer, const char *str, size_t length)
+{
+	static const char HEX[] = "0123456789abcdef";
+	JsonWriter_char_inline_(writer, '"');
+	for(size_t i = 0; i < length; i++){
+		const unsigned char c = (unsigned char)str[i];
+		if('"' == c || '\\' == c){
+			JsonWriter_char_inline_(writer, '\\');
+			JsonWriter_char_inline_(writer, (char)c);
+		}else if(c < 0x20 || 0x7F == c){
+			const char escaped[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+			JsonWriter_raw(writer, escaped, sizeof(escaped));
+		}else{
+			JsonWriter_char_inline_(writer, (char)c);
+		}
+	}
+	JsonWriter_char_inline_(writer, '"');
+}
+
+//! @brief 長さを指定した文字列(NUL終端でないtag等)
+void JsonWriter_stringN(JsonWriter *writer, const char *str, size_t length)
+{
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_stringValue_inline_(writer, str, length);
+}
+
+void JsonWriter_string(JsonWriter *writer, const char *str)
+{
+	JsonWriter_stringN(writer, str, strlen(str));
+}
+
+void JsonWriter_key(JsonWriter *writer, const char *key)
+{
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_stringValue_inline_(writer, key, strlen(key));
+	JsonWriter_char_inline_(writer, ':');
+	writer->isNeedComma = false;
+}
+
+void JsonWriter_uint(JsonWriter *writer, uint64_t value)
+{
+	JsonWriter_separator_inline_(writer);
+	char digits[20];
+	size_t pos = sizeof(digits);
+	do{
+		digits[--pos] = (char)('0' + (value % 10));
+		value /= 10;
+	}while(0 != value);
+	JsonWriter_raw(writer, &digits[pos], sizeof(digits) - pos);
+}
+
+void JsonWriter_int(JsonWriter *writer, int64_t value)
+{
+	if(0 <= value){
+		JsonWriter_uint(writer, (uint64_t)value);
+		return;
+	}
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_char_inline_(writer, '-');
+	writer->isNeedComma = false;
+	JsonWriter_uint(writer, (uint64_t)0 - (uint64_t)value);
+}
+
+void JsonWriter_bool(JsonWriter *writer, bool value)
+{
+	JsonWriter_separator_inline_(writer);
+	JsonWriter_raw(writer, value ? "true" : "false", value ? 4 : 5);
+}
+
+// ** key: value
+
+void JsonWriter_keyString(JsonWriter *writer, const char *key, const char *value)
+{
+	JsonWriter_key(writer, key);
+	JsonWriter_string(writer, value);
+}
+
+void JsonWriter_keyUint(JsonWriter *writer, const char *key, uint64_t value)
+{
+	JsonWriter_key(writer, key);
+	JsonWriter_uint(writer, value);
+}
+
+void JsonWriter_keyInt(JsonWriter *writer, const char *key, int64_t value)
+{
+	JsonWriter_key(writer, key);
+	JsonWriter_int(writer, value);
+}
+
+void JsonWriter_keyBool(JsonWriter *writer, const char *key, bool value)
+{
+	JsonWriter_key(writer, key);
+	JsonWriter_bool(writer, value);
+}
+
+#endif // #ifndef DAISYFF_JSON_WRITER_HPP_
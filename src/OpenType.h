@@ -6,8 +6,8 @@
 #ifndef DAISYFF_OPEN_TYPE_HPP_
 #define DAISYFF_OPEN_TYPE_HPP_
 
-// strptime()のために先頭に置く
-#define _XOPEN_SOURCE
+// strptime(), clock_gettime()等のために先頭に置く
+#define _XOPEN_SOURCE 700
 #include <time.h>
 
 #include <stdlib.h>
@@ -22,6 +22,8 @@
 #include <errno.h>
 
 #include "src/Util.h"
+#include "src/Trace.h"
+#include "src/Utf.h"
 #include "src/GlyphOutline.h"
 
 // * ********
@@ -329,23 +331,42 @@ typedef struct{
 	Offset16Type	offset;
 }NameRecord_Member;
 
+/** string strage内の文字列(重複排除用)。
+  同じbyte列は全Record(Unicode, Windows等の各platform・言語)で1つだけ格納する。
+  */
+typedef struct{
+	uint32_t		hash;		//!< 0: 空き
+	uint16_t		offset;
+	uint16_t		length;
+}NameTableStringPoolEntry;
+
 typedef struct{
 	Uint16Type		format;
 	Uint16Type		count;
 	Offset16Type		stringOffset;
 	NameRecord_Member	*nameRecord;
+	size_t			nameRecordCapacity;
 	uint8_t			*stringStrage;
 	size_t 			stringStrageSize;
+	size_t 			stringStrageCapacity;
+	NameTableStringPoolEntry	*poolEntries;	//!< open addressing (2の累乗)
+	size_t			poolCapacity;
+	size_t			poolNum;
 	uint8_t			*data;
 	size_t			dataSize;
 }NameTableBuf;
 
 enum PlatformID{
 	PlatformID_Unicode		= 0,
+	PlatformID_Macintosh		= 1,
+	PlatformID_Windows		= 3,
 };
 enum EncodingID{
 	EncodingID_Unicode_0		= 0,
+	EncodingID_Macintosh_Roman	= 0,
+	EncodingID_Windows_UnicodeBMP	= 1,
 };
+#define LanguageID_Windows_EnglishUS (0x0409)
 typedef Uint16Type PlatformID;
 typedef Uint16Type EncodingID;
 typedef Uint16Type LanguageID;
@@ -370,21 +391,116 @@ bool PostScriptName_valid(const char *str)
 	return true;
 }
 
-uint8_t *convertNewUtf16FromUtf8(const char *stringdata)
+/** @brief UTF-8をUTF-16BEへ変換した新しいバッファを返す。
+  @return NULL: 不正なUTF-8
+  */
+uint8_t *convertNewUtf16FromUtf8(const char *stringdata, size_t *utf16sSize)
 {
-	//! @todo ASCIIしか変換できない。(とりあえずcopyrightマークに非対応な状態)
-	uint8_t *utf16s = (uint8_t *)ffmalloc((strlen(stringdata) * 2) + 2);
-	for(int i = 0; i < strlen(stringdata); i++){
-		utf16s[(i * 2) + 0] = 0x00;
-		utf16s[(i * 2) + 1] = stringdata[i];
-		utf16s[(i * 2) + 2] = 0x00;
-		utf16s[(i * 2) + 3] = 0x00;
+	const size_t srcSize = strlen(stringdata);
+	uint8_t *utf16s = (uint8_t *)ffmalloc((srcSize * 2) + 2);
+	if(! Utf8_toUtf16BE(utf16s, utf16sSize, (const uint8_t *)stringdata, srcSize)){
+		free(utf16s);
+		return NULL;
 	}
 
 	return utf16s;
 }
 
-void NameTableBuf_append(
+uint32_t NameTableBuf_hash_inline_(const uint8_t *data, size_t size)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < size; i++){
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return (0 == hash)? 1 : hash;
+}
+
+void NameTableBuf_poolInsert_inline_(NameTableBuf *nameTableBuf, NameTableStringPoolEntry entry)
+{
+	size_t index = entry.hash & (nameTableBuf->poolCapacity - 1);
+	while(0 != nameTableBuf->poolEntries[index].hash){
+		index = (index + 1) & (nameTableBuf->poolCapacity - 1);
+	}
+	nameTableBuf->poolEntries[index] = entry;
+	nameTableBuf->poolNum++;
+}
+
+/** @brief 文字列をstring strageに追加する。同じbyte列が既にあればそのoffsetを返す。
+  @param strageLimit 新しい文字列を加えた後のstring strageの大きさの上限
+  @return false: offset/lengthがUint16に収まらない、またはstrageLimitを超える
+  */
+bool NameTableBuf_internString_inline_(
+		NameTableBuf *nameTableBuf,
+		const uint8_t *data,
+		size_t size,
+		size_t strageLimit,
+		uint16_t *offset)
+{
+	if(UINT16_MAX < size){
+		return false;
+	}
+	const uint32_t hash = NameTableBuf_hash_inline_(data, size);
+	if(0 < nameTableBuf->poolCapacity){
+		size_t index = hash & (nameTableBuf->poolCapacity - 1);
+		for(; 0 != nameTableBuf->poolEntries[index].hash;
+				index = (index + 1) & (nameTableBuf->poolCapacity - 1)){
+			const NameTableStringPoolEntry *entry = &nameTableBuf->poolEntries[index];
+			if(hash == entry->hash && size == entry->length
+					&& 0 == memcmp(&nameTableBuf->stringStrage[entry->offset], data, size)){
+				*offset = entry->offset;
+				return true;
+			}
+		}
+	}
+
+	// 新しい文字列(offsetはUint16)
+	if(strageLimit < nameTableBuf->stringStrageSize
+			|| strageLimit < (nameTableBuf->stringStrageSize + size)){
+		return false;
+	}
+	if(nameTableBuf->stringStrageCapacity < nameTableBuf->stringStrageSize + size){
+		size_t capacity = (0 == nameTableBuf->stringStrageCapacity)? 256 : nameTableBuf->stringStrageCapacity;
+		while(capacity < nameTableBuf->stringStrageSize + size){
+			capacity *= 2;
+		}
+		nameTableBuf->stringStrage = (uint8_t *)ffrealloc(nameTableBuf->stringStrage, capacity);
+		nameTableBuf->stringStrageCapacity = capacity;
+	}
+	memcpy(&nameTableBuf->stringStrage[nameTableBuf->stringStrageSize], data, size);
+	*offset = (uint16_t)nameTableBuf->stringStrageSize;
+	nameTableBuf->stringStrageSize += size;
+
+	// 負荷率1/2を超えたら作り直す
+	if(nameTableBuf->poolCapacity <= (nameTableBuf->poolNum + 1) * 2){
+		NameTableStringPoolEntry *oldEntries = nameTableBuf->poolEntries;
+		const size_t oldCapacity = nameTableBuf->poolCapacity;
+		nameTableBuf->poolCapacity = (0 == oldCapacity)? 64 : (oldCapacity * 2);
+		nameTableBuf->poolEntries = (NameTableStringPoolEntry *)ffmalloc(
+				sizeof(NameTableStringPoolEntry) * nameTableBuf->poolCapacity);
+		nameTableBuf->poolNum = 0;
+		for(size_t i = 0; i < oldCapacity; i++){
+			if(0 != oldEntries[i].hash){
+				NameTableBuf_poolInsert_inline_(nameTableBuf, oldEntries[i]);
+			}
+		}
+		free(oldEntries);
+	}
+	NameTableBuf_poolInsert_inline_(nameTableBuf, (NameTableStringPoolEntry){
+			.hash	= hash,
+			.offset	= *offset,
+			.length	= (uint16_t)size,
+			});
+
+	return true;
+}
+
+/** @brief NameRecordを追加する。
+  文字列はUTF-8で受け取り、Unicode/Windows platformはUTF-16BE、MacintoshはRoman(ASCIIのみ)で格納する。
+  header(NameRecord[count]まで)とstring strageの合計は、stringOffsetと各NameRecordのoffsetが共にUint16に収まるよう64KiB未満に制限する。
+  @return false: 不正な文字列、またはheaderとstring strageがUint16のoffsetに収まらない
+  */
+bool NameTableBuf_append(
 		NameTableBuf *nameTableBuf,
 		PlatformID platformID,
 		EncodingID encodingID,
@@ -396,30 +512,73 @@ void NameTableBuf_append(
 	ASSERT(stringdata);
 	DEBUG_LOG("nameTableBuf->count:%d nameID:%2d`%s`", nameTableBuf->count, nameID, stringdata);
 
-	size_t utf16sSize = strlen(stringdata) * 2;
+	// このNameRecordを加えた後のheader(stringOffset)
+	const size_t headerSize = sizeof(NameTableHeader_Format0) + (sizeof(NameRecord_Member) * ((size_t)nameTableBuf->count + 1));
+	if(UINT16_MAX < headerSize + nameTableBuf->stringStrageSize){
+		WARN_LOG("'name' Table header and string strage overflow count:%d", nameTableBuf->count);
+		return false;
+	}
+
+	uint8_t *encoded;
+	size_t encodedSize;
+	if(PlatformID_Macintosh == platformID){
+		encodedSize = strlen(stringdata);
+		for(size_t i = 0; i < encodedSize; i++){
+			if(0x80 <= (uint8_t)stringdata[i]){
+				WARN_LOG("Macintosh platform name supports only ASCII `%s`", stringdata);
+				return false;
+			}
+		}
+		encoded = (uint8_t *)ffsprintf_new("%s", stringdata);
+	}else{
+		encoded = convertNewUtf16FromUtf8(stringdata, &encodedSize);
+		if(NULL == encoded){
+			WARN_LOG("invalid UTF-8 nameID:%d", nameID);
+			return false;
+		}
+	}
+
+	// ** string strageに文字列データを追加(重複は共有)
+	uint16_t offset;
+	const bool isSuccess = NameTableBuf_internString_inline_(nameTableBuf, encoded, encodedSize, UINT16_MAX - headerSize, &offset);
+	free(encoded);
+	if(! isSuccess){
+		return false;
+	}
 
 	// ** NameTable.nameRecord[]に新しいNameRecordを追加。
-	nameTableBuf->nameRecord = (NameRecord_Member *)ffrealloc(
-			nameTableBuf->nameRecord,
-			sizeof(NameRecord_Member) * (nameTableBuf->count + 1));
+	if(nameTableBuf->nameRecordCapacity == nameTableBuf->count){
+		nameTableBuf->nameRecordCapacity = (0 == nameTableBuf->nameRecordCapacity)? 16 : (nameTableBuf->nameRecordCapacity * 2);
+		nameTableBuf->nameRecord = (NameRecord_Member *)ffrealloc(
+				nameTableBuf->nameRecord,
+				sizeof(NameRecord_Member) * nameTableBuf->nameRecordCapacity);
+	}
 	NameRecord_Member nameRecord_Member = {
 		.platformID	= htons(platformID),
 		.encodingID	= htons(encodingID),
 		.languageID	= htons(languageID),
 		.nameID		= htons(nameID),
-		.length		= htons(utf16sSize),
-		.offset		= htons(nameTableBuf->stringStrageSize),
+		.length		= htons(encodedSize),
+		.offset		= htons(offset),
 	};
 	nameTableBuf->nameRecord[nameTableBuf->count] = nameRecord_Member;
 	(nameTableBuf->count)++;
 
-	// ** string strageを拡張して後ろに文字列データを追加
-	//DEBUG_LOG("%zu %zu", nameTableBuf->stringStrageSize, strlen(stringdata));
-	uint8_t *utf16s = convertNewUtf16FromUtf8(stringdata);
-	size_t newsize = nameTableBuf->stringStrageSize + utf16sSize;
-	nameTableBuf->stringStrage = (uint8_t *)ffrealloc(nameTableBuf->stringStrage, newsize);
-	memcpy(&nameTableBuf->stringStrage[nameTableBuf->stringStrageSize], utf16s, utf16sSize);
-	nameTableBuf->stringStrageSize = newsize;
+	return true;
+}
+
+int NameRecord_Member_compare_inline_(const void *a_, const void *b_)
+{
+	const NameRecord_Member *a = (const NameRecord_Member *)a_;
+	const NameRecord_Member *b = (const NameRecord_Member *)b_;
+	const uint16_t keysA[] = {ntohs(a->platformID), ntohs(a->encodingID), ntohs(a->languageID), ntohs(a->nameID)};
+	const uint16_t keysB[] = {ntohs(b->platformID), ntohs(b->encodingID), ntohs(b->languageID), ntohs(b->nameID)};
+	for(int i = 0; i < 4; i++){
+		if(keysA[i] != keysB[i]){
+			return (keysA[i] < keysB[i])? -1 : 1;
+		}
+	}
+	return 0;
 }
 
 void NameTableBuf_generateByteData(NameTableBuf *nameTableBuf)
@@ -427,6 +586,9 @@ void NameTableBuf_generateByteData(NameTableBuf *nameTableBuf)
 	ASSERT(nameTableBuf);
 	ASSERT(NULL == nameTableBuf->data); // 再実行はしない
 
+	// NameRecordはplatformID, encodingID, languageID, nameIDの順にソートされている必要がある
+	qsort(nameTableBuf->nameRecord, nameTableBuf->count, sizeof(NameRecord_Member), NameRecord_Member_compare_inline_);
+
 	// byte dataメモリ確保
 	size_t nameTableSize = sizeof(NameTableHeader_Format0)
 		+ (sizeof(NameRecord_Member) * nameTableBuf->count)
@@ -453,7 +615,23 @@ void NameTableBuf_generateByteData(NameTableBuf *nameTableBuf)
 	memcpy(&nameTableBuf->data[stringOffset], nameTableBuf->stringStrage, nameTableBuf->stringStrageSize);
 }
 
-NameTableBuf NameTableBuf_init(
+void NameTableBuf_begin(NameTableBuf *nameTableBuf)
+{
+	*nameTableBuf = (NameTableBuf){
+		.format			= 0,
+		.count			= 0,
+		.stringOffset		= sizeof(NameTableHeader_Format0),
+	};
+}
+
+/** @brief フォント名など基本のNameRecord一式を、指定platform・言語で追加する。
+  @return false: NameTableBuf_append()の失敗
+  */
+bool NameTableBuf_appendFontNames(
+			NameTableBuf *nameTableBuf,
+			PlatformID platformID,
+			EncodingID encodingID,
+			LanguageID languageID,
 			const char *copyright,
 			const char *fontname,
 			MacStyle    macStyle,
@@ -464,19 +642,6 @@ NameTableBuf NameTableBuf_init(
 			const char *designerurl
 		)
 {
-	//! @todo argument validation
-
-	NameTableBuf nameTableBuf = {
-		.format			= 0,
-		.count			= 0,
-		.stringOffset		= sizeof(NameTableHeader_Format0),
-		.nameRecord		= NULL,
-		.stringStrage		= NULL,
-		.stringStrageSize	= 0,
-		.data			= NULL,
-		.dataSize		= 0,
-	};
-
 	// NameTable.NameRecord[](および.stringstrage)にNameRecord_Menberを追加。
 	const char *macStyleString = MacStyle_toStringForNameTable(macStyle);
 	ASSERT(macStyleString);
@@ -484,24 +649,76 @@ NameTableBuf NameTableBuf_init(
 	const char *humanfullfontname		= ffsprintf_new("%s %s", fontname, macStyleString);
 	const char *postscriptfontname		= ffsprintf_new("%s-%s", fontname, macStyleString);
 	ASSERTF(PostScriptName_valid(postscriptfontname), "`%s`", postscriptfontname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  0, copyright);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  1, fontname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  2, macStyleString);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  3, appfullfontname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  4, humanfullfontname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  5, versionString);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  6, postscriptfontname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  8, vendorname);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,  9, designername);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0, 11, vendorurl);
-	NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0, 12, designerurl);
+	const struct{
+		NameID		nameID;
+		const char	*string;
+	}records[] = {
+		{ 0, copyright},
+		{ 1, fontname},
+		{ 2, macStyleString},
+		{ 3, appfullfontname},
+		{ 4, humanfullfontname},
+		{ 5, versionString},
+		{ 6, postscriptfontname},
+		{ 8, vendorname},
+		{ 9, designername},
+		{11, vendorurl},
+		{12, designerurl},
+	};
+	bool isSuccess = true;
+	for(size_t i = 0; i < sizeof(records) / sizeof(records[0]); i++){
+		if(! NameTableBuf_append(nameTableBuf, platformID, encodingID, languageID, records[i].nameID, records[i].string)){
+			isSuccess = false;
+			break;
+		}
+	}
+	free((void *)appfullfontname);
+	free((void *)humanfullfontname);
+	free((void *)postscriptfontname);
+
+	return isSuccess;
+}
+
+NameTableBuf NameTableBuf_init(
+			const char *copyright,
+			const char *fontname,
+			MacStyle    macStyle,
+			const char *versionString,
+			const char *vendorname,
+			const char *designername,
+			const char *vendorurl,
+			const char *designerurl
+		)
+{
+	//! @todo argument validation
+
+	NameTableBuf nameTableBuf;
+	NameTableBuf_begin(&nameTableBuf);
+
+	FFTRACE_BEGIN("name", "table");
+
+	ASSERT(NameTableBuf_appendFontNames(
+			&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0,
+			copyright, fontname, macStyle, versionString,
+			vendorname, designername, vendorurl, designerurl));
 
 	// NameTableのbufferからbyteデータを作成
 	NameTableBuf_generateByteData(&nameTableBuf);
 
+	FFTRACE_END("name", "table");
+
 	return nameTableBuf;
 }
 
+void NameTableBuf_free(NameTableBuf *nameTableBuf)
+{
+	free(nameTableBuf->nameRecord);
+	free(nameTableBuf->stringStrage);
+	free(nameTableBuf->poolEntries);
+	free(nameTableBuf->data);
+	*nameTableBuf = (NameTableBuf){0};
+}
+
 typedef struct{
 	Int16Type numberOfContours;
 	Int16Type xMin;
@@ -624,6 +841,7 @@ void GlyphDescriptionBuf_setOutline(
 	// endPoints[numberOfContours]
 	htonArray16Move(&(glyphDescriptionBuf->data[offset]), endPoints, glyphDescriptionBuf->numberOfContours);
 	offset += sizeof(uint16_t) * glyphDescriptionBuf->numberOfContours;
+	free(endPoints);
 	// instructionLength
 	wsize = sizeof(uint16_t);
 	v16 = htons(glyphDescriptionBuf->instructionLength);
@@ -651,6 +869,20 @@ void GlyphDescriptionBuf_setOutline(
 	glyphDescriptionBuf->xCoodinates	= xCoodinates;
 	glyphDescriptionBuf->yCoodinates	= yCoodinates;
 	glyphDescriptionBuf->pointNum		= pointNum;
+	glyphDescriptionBuf->xMin		= bbox.xMin;
+	glyphDescriptionBuf->yMin		= bbox.yMin;
+	glyphDescriptionBuf->xMax		= bbox.xMax;
+	glyphDescriptionBuf->yMax		= bbox.yMax;
+}
+
+void GlyphDescriptionBuf_free(GlyphDescriptionBuf *glyphDescriptionBuf)
+{
+	free(glyphDescriptionBuf->instructions);
+	free(glyphDescriptionBuf->flags);
+	free(glyphDescriptionBuf->xCoodinates);
+	free(glyphDescriptionBuf->yCoodinates);
+	free(glyphDescriptionBuf->data);
+	*glyphDescriptionBuf = (GlyphDescriptionBuf){0};
 }
 
 typedef struct{
@@ -740,14 +972,16 @@ void CmapTable_CmapSubtable_Format0_finally(CmapTable_CmapSubtable_Format0 *form
 	//format0.glyphIdArray	= {0},
 }
 
-FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
-		uint16_t languageId,
-		uint16_t *glyphIdArray)
+//! @brief 末尾segmentまで含めてsegmentを収集する
+//! @param segmentBufs [CmapSubtableFormat4_ARRAY_SIZE]
+//! @return segCount
+size_t CmapTable_CmapSubtable_Format4_collectSegments(
+		const uint16_t *glyphIdArray,
+		CmapSubtable_Format4_SegmentBuf *segmentBufs)
 {
 	ASSERT(glyphIdArray);
+	ASSERT(segmentBufs);
 
-	// ** segmentsを収集
-	CmapSubtable_Format4_SegmentBuf segmentBufs[CmapSubtableFormat4_ARRAY_SIZE];
 	size_t segCount = 0;
 	for(int c = 0; c <= CmapSubtableFormat4_CODEPOINT_MAX; c++){
 		// 末尾セグメント用に予約されているはず
@@ -765,9 +999,14 @@ FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
 			continue;
 		}
 
-		//!< @todo 今回はsegment形式マッピングで圧縮するほど文字数もないため、
-		// 処理を略し文字毎にsegmentを切ってしまう
+		// 直前のsegmentに連続する文字かつGlyphIdも連続(idDeltaが等しい)ならsegmentを伸ばす
 		Int16Type idDelta = glyphIdArray[c] - c;
+		if(0 < segCount
+				&& (segmentBufs[segCount - 1].endCode + 1) == c
+				&& segmentBufs[segCount - 1].idDelta == idDelta){
+			segmentBufs[segCount - 1].endCode = c;
+			continue;
+		}
 		segmentBufs[segCount] = (CmapSubtable_Format4_SegmentBuf){
 			.startCode	= c,
 			.endCode	= c,
@@ -792,6 +1031,28 @@ FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
 	}
 	ASSERT(segCount <= (UINT16_MAX / 2));
 
+	return segCount;
+}
+
+//! @brief Format4 subtableのbyte長(Uint16Typeのlengthに収まらない場合がある)
+size_t CmapTable_CmapSubtable_Format4_lengthFromSegCount(size_t segCount)
+{
+	size_t fixedheadSize	= (sizeof(Uint16Type) * 7);
+	size_t segmentsSize	= sizeof(Uint16Type) + (sizeof(Uint16Type) * segCount * 4);
+	return fixedheadSize + segmentsSize;
+}
+
+FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
+		uint16_t languageId,
+		uint16_t *glyphIdArray)
+{
+	ASSERT(glyphIdArray);
+
+	// ** segmentsを収集
+	CmapSubtable_Format4_SegmentBuf *segmentBufs = (CmapSubtable_Format4_SegmentBuf *)ffmalloc(
+			sizeof(CmapSubtable_Format4_SegmentBuf) * CmapSubtableFormat4_ARRAY_SIZE);
+	size_t segCount = CmapTable_CmapSubtable_Format4_collectSegments(glyphIdArray, segmentBufs);
+
 	// ** byte array生成
 	FFByteArray array = {0};
 	size_t segArrayElementSize = sizeof(Uint16Type) * segCount;
@@ -799,6 +1060,8 @@ FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
 	size_t fixedheadSize	= (sizeof(Uint16Type) * 7);
 	size_t segmentsSize	= reserveSize + (segArrayElementSize * 4);
 	size_t glyphIdArraySize	= 0;
+	ASSERTF((fixedheadSize + segmentsSize + glyphIdArraySize) <= UINT16_MAX,
+			"segCount:%zu", segCount); // CmapTable.subtable.format4.lengthはUint16
 	Uint16Type length = fixedheadSize + segmentsSize + glyphIdArraySize;
 	DEBUG_LOG("segCount:%zu length:%u(0x%08x)", segCount, length, (uint32_t)length);
 
@@ -808,29 +1071,36 @@ FFByteArray CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
 	uint16_t searchRange	= (2 * 2 * (int)floor(log2(segCount)));
 	uint16_t entrySelector	= ((int)log2(searchRange/2.0));
 	uint16_t rangeShift	= 2 * segCount - searchRange;
+	// host byte orderで書き込み、最後に一括でbig endianへ変換する
 	uint16_t *data16 = (uint16_t *)array.data;
-	data16[0] = htons(4);			//Uint16Type	format
-	data16[1] = htons(length);			//Uint16Type	length
-	data16[2] = htons(languageId);		//Uint16Type	language
-	data16[3] = htons(segCountX2	);	//Uint16Type	segCountX2
-	data16[4] = htons(searchRange	);	//Uint16Type	searchRange
-	data16[5] = htons(entrySelector	);	//Uint16Type	entrySelector
-	data16[6] = htons(rangeShift	);	//Uint16Type	rangeShift
+	data16[0] = 4;			//Uint16Type	format
+	data16[1] = length;		//Uint16Type	length
+	data16[2] = languageId;		//Uint16Type	language
+	data16[3] = segCountX2;		//Uint16Type	segCountX2
+	data16[4] = searchRange;	//Uint16Type	searchRange
+	data16[5] = entrySelector;	//Uint16Type	entrySelector
+	data16[6] = rangeShift;		//Uint16Type	rangeShift
 
 	// *** segments
 	Uint16Type	*endCode	= (Uint16Type*)&(array.data[fixedheadSize + 0]);
+	Uint16Type	*reservedPad	= (Uint16Type*)&(array.data[fixedheadSize + (segArrayElementSize * 1)]);
 	Uint16Type	*startCode	= (Uint16Type*)&(array.data[fixedheadSize + reserveSize + (segArrayElementSize * 1)]);
 	Int16Type	*idDelta	= (Int16Type*) &(array.data[fixedheadSize + reserveSize + (segArrayElementSize * 2)]);
 	Uint16Type	*idRangeOffset	= (Uint16Type*)&(array.data[fixedheadSize + reserveSize + (segArrayElementSize * 3)]);
+	*reservedPad = 0;
 	for(int seg = 0; seg < segCount; seg++){
-		endCode[seg]		= htons(segmentBufs[seg].startCode		);
-		startCode[seg]		= htons(segmentBufs[seg].endCode		);
-		idDelta[seg]		= htons(segmentBufs[seg].idDelta		);
-		idRangeOffset[seg]	= htons(segmentBufs[seg].idRangeOffset	);
+		endCode[seg]		= segmentBufs[seg].endCode;
+		startCode[seg]		= segmentBufs[seg].startCode;
+		idDelta[seg]		= segmentBufs[seg].idDelta;
+		idRangeOffset[seg]	= segmentBufs[seg].idRangeOffset;
 	}
 
 	//Uint16Type	*glyphIdArray;			// glyphIdArray[ ]
 
+	htonArray16(data16, length / sizeof(uint16_t));
+
+	free(segmentBufs);
+
 	return array;
 }
 
@@ -840,6 +1110,8 @@ typedef struct{
 	uint8_t			*cmapSubtableBuf_GlyphIdArray8;		//!< `glyphId = array[codepoint=0-255]`
 	uint16_t		*cmapSubtableBuf_GlyphIdArray16;	//!< `glyphId = array[codepoint=0-65535]`
 	FFByteArray		cmapByteArray;
+	uint32_t		*locaOffsets_Host;	//!< `glyfOffset = array[glyphId]` [numGlyphs + 1]
+	int16_t			indexToLocFormat;	//!< finally後に確定する HeadTable.indexToLocFormat
 	FFByteArray		locaByteArray;
 	uint8_t			*glyfData;
 	size_t			glyfDataSize;
@@ -858,42 +1130,28 @@ void GlyphTablesBuf_appendSimpleGlyph(
 	//DUMPUint16((uint16_t *)glyphDescriptionBuf->data, glyphDescriptionBuf->dataSize);
 
 	// ** 'glyf' Table
+	// 'loca' Table short formatはoffset/2を格納するため、GlyphDescriptionは2byte境界に置く
+	const size_t paddedDataSize = glyphDescriptionBuf->dataSize + (glyphDescriptionBuf->dataSize % 2);
 	glyphTablesBuf->glyfData = (uint8_t *)ffrealloc(
 			glyphTablesBuf->glyfData,
-			glyphTablesBuf->glyfDataSize + glyphDescriptionBuf->dataSize);
+			glyphTablesBuf->glyfDataSize + paddedDataSize);
+	memset(&glyphTablesBuf->glyfData[glyphTablesBuf->glyfDataSize], 0x00, paddedDataSize);
 	memcpy(&glyphTablesBuf->glyfData[glyphTablesBuf->glyfDataSize],
 			glyphDescriptionBuf->data,
 			glyphDescriptionBuf->dataSize);
-	glyphTablesBuf->glyfDataSize += glyphDescriptionBuf->dataSize;
+	glyphTablesBuf->glyfDataSize += paddedDataSize;
 
 	// ** 'loca' Table
-	// 'loca' Tableのoffsetsの型はHeadTable.indexToLocFormatにより指定。
-#if 0
-	{
-		size_t newsize = sizeof(Offset32Type) * (glyphTablesBuf->numGlyphs + 2);
-		FFByteArray_realloc(&(glyphTablesBuf->locaByteArray), newsize);
-		// 先頭オフセット(初回先頭がゼロ。以降前回の末尾オフセットがあれば同じ値で上書きされる)
-		Offset32Type *loca = (Offset32Type *)(glyphTablesBuf->locaByteArray.data);
-		loca[glyphTablesBuf->numGlyphs + 0]
-			= htonl(glyphTablesBuf->glyfDataSize - glyphDescriptionBuf->dataSize);
-		// 末尾オフセット
-		loca[glyphTablesBuf->numGlyphs + 1]
-			= htonl(glyphTablesBuf->glyfDataSize);
-	}
-#endif
-#if 1
-	{
-		size_t newsize = sizeof(Offset16Type) * (glyphTablesBuf->numGlyphs + 2);
-		FFByteArray_realloc(&(glyphTablesBuf->locaByteArray), newsize);
-		// 先頭オフセット(初回先頭がゼロ。以降前回の末尾オフセットがあれば同じ値で上書きされる)
-		Offset16Type *loca = (Offset16Type *)(glyphTablesBuf->locaByteArray.data);
-		loca[glyphTablesBuf->numGlyphs + 0]
-			= htons((glyphTablesBuf->glyfDataSize - glyphDescriptionBuf->dataSize) / 2);
-		// 末尾オフセット
-		loca[glyphTablesBuf->numGlyphs + 1]
-			= htons(glyphTablesBuf->glyfDataSize / 2);
-	}
-#endif
+	// 'loca' Tableのoffsetsの型(HeadTable.indexToLocFormat)はglyf全体の大きさが判明するfinallyで決める。
+	glyphTablesBuf->locaOffsets_Host = (uint32_t *)ffrealloc(
+			glyphTablesBuf->locaOffsets_Host,
+			sizeof(uint32_t) * (glyphTablesBuf->numGlyphs + 2));
+	// 先頭オフセット(初回先頭がゼロ。以降前回の末尾オフセットがあれば同じ値で上書きされる)
+	glyphTablesBuf->locaOffsets_Host[glyphTablesBuf->numGlyphs + 0]
+		= glyphTablesBuf->glyfDataSize - paddedDataSize;
+	// 末尾オフセット
+	glyphTablesBuf->locaOffsets_Host[glyphTablesBuf->numGlyphs + 1]
+		= glyphTablesBuf->glyfDataSize;
 
 	// ** 'cmap' Table
 	ASSERT(glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8);
@@ -905,7 +1163,10 @@ void GlyphTablesBuf_appendSimpleGlyph(
 			DEBUG_LOG("%3zu: 0x%02x`<not printable>`", glyphTablesBuf->numGlyphs, codepoint);
 		}
 
-		glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8[codepoint] = glyphTablesBuf->numGlyphs;
+		// Format0のglyphIdArrayはUint8なので、収まらないGlyphIdはFormat4でのみ引ける
+		if(glyphTablesBuf->numGlyphs <= UINT8_MAX){
+			glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8[codepoint] = glyphTablesBuf->numGlyphs;
+		}
 	}
 	if(codepoint <= CmapSubtableFormat4_CODEPOINT_MAX){
 		glyphTablesBuf->cmapSubtableBuf_GlyphIdArray16[codepoint] = glyphTablesBuf->numGlyphs;
@@ -915,8 +1176,37 @@ void GlyphTablesBuf_appendSimpleGlyph(
 	(glyphTablesBuf->numGlyphs)++;
 }
 
+void GlyphTablesBuf_finallyLoca_inline_(GlyphTablesBuf *glyphTablesBuf)
+{
+	const size_t locaNum = glyphTablesBuf->numGlyphs + 1;
+	if(0 == glyphTablesBuf->numGlyphs){
+		return;
+	}
+
+	// short formatはoffset/2をUint16で持つので、glyfが大きい場合はlong formatにする
+	if((glyphTablesBuf->glyfDataSize / 2) <= UINT16_MAX){
+		glyphTablesBuf->indexToLocFormat = 0;
+		FFByteArray_realloc(&(glyphTablesBuf->locaByteArray), sizeof(Offset16Type) * locaNum);
+		Offset16Type *loca = (Offset16Type *)(glyphTablesBuf->locaByteArray.data);
+		for(int i = 0; i < locaNum; i++){
+			loca[i] = glyphTablesBuf->locaOffsets_Host[i] / 2;
+		}
+		htonArray16(loca, locaNum);
+	}else{
+		glyphTablesBuf->indexToLocFormat = 1;
+		FFByteArray_realloc(&(glyphTablesBuf->locaByteArray), sizeof(Offset32Type) * locaNum);
+		htonArray32Move(glyphTablesBuf->locaByteArray.data, glyphTablesBuf->locaOffsets_Host, locaNum);
+	}
+}
+
 void GlyphTablesBuf_finally(GlyphTablesBuf *glyphTablesBuf)
 {
+	// ** 'loca' Table
+	FFTRACE_BEGIN("loca", "table");
+	GlyphTablesBuf_finallyLoca_inline_(glyphTablesBuf);
+	FFTRACE_END("loca", "table");
+
+	FFTRACE_BEGIN("cmap", "table");
 	//! @note 2019/03/03現在CmapTable内部のSubtable順序等はFontForgeに生成させたフォントファイルを参考に合わせている
 
 	// ** CmapTable.Header
@@ -931,9 +1221,11 @@ void GlyphTablesBuf_finally(GlyphTablesBuf *glyphTablesBuf)
 	memcpy(format0.glyphIdArray,
 			glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8, CmapSubtableFormat0_ARRAY_SIZE);
 	CmapTable_CmapSubtable_Format0_finally(&format0, glyphTablesBuf->numGlyphs);
+	FFTRACE_BEGIN("cmap.format4", "table");
 	FFByteArray arrayFormat4 = CmapTable_CmapSubtable_Format4_generateByteDataWithGlyphIdArray16(
 			0,
 			glyphTablesBuf->cmapSubtableBuf_GlyphIdArray16);
+	FFTRACE_END("cmap.format4", "table");
 
 	// ** CmapTable.encodingRecordElementHeader
 	size_t subtableOffset0
@@ -960,12 +1252,26 @@ void GlyphTablesBuf_finally(GlyphTablesBuf *glyphTablesBuf)
 
 	// ** CmapTable.subtable[Format4]
 	FFByteArray_appendArray(&glyphTablesBuf->cmapByteArray, arrayFormat4);
+	FFByteArray_free(&arrayFormat4);
 	DEBUG_LOG("format4: %zu(0x%08x)", arrayFormat4.length, (uint32_t)arrayFormat4.length);
 	DUMP0(arrayFormat4.data, arrayFormat4.length);
 	// ** CmapTable.subtable[Format0]
 	FFByteArray_append(&glyphTablesBuf->cmapByteArray,
 			&format0,
 			sizeof(CmapTable_CmapSubtable_Format0));
+	FFTRACE_END("cmap", "table");
+}
+
+void GlyphTablesBuf_free(GlyphTablesBuf *glyphTablesBuf)
+{
+	free(glyphTablesBuf->glyphDescriptionBufs);
+	free(glyphTablesBuf->cmapSubtableBuf_GlyphIdArray8);
+	free(glyphTablesBuf->cmapSubtableBuf_GlyphIdArray16);
+	FFByteArray_free(&glyphTablesBuf->cmapByteArray);
+	free(glyphTablesBuf->locaOffsets_Host);
+	FFByteArray_free(&glyphTablesBuf->locaByteArray);
+	free(glyphTablesBuf->glyfData);
+	*glyphTablesBuf = (GlyphTablesBuf){0};
 }
 
 void GlyphTablesBuf_init(GlyphTablesBuf *glyphTablesBuf)
@@ -1058,7 +1364,7 @@ void HmtxTableBuf_appendLongHorMetric(HmtxTableBuf *hmtxTableBuf, size_t advance
 		hmtxTableBuf->advanceWidthMax = advanceWidth;
 	}
 
-	hmtxTableBuf->longHorMetrics_Host = (HmtxTable_LongHorMetric_Member *)realloc(
+	hmtxTableBuf->longHorMetrics_Host = (HmtxTable_LongHorMetric_Member *)ffrealloc(
 					hmtxTableBuf->longHorMetrics_Host,
 					sizeof(HmtxTable_LongHorMetric_Member) * (hmtxTableBuf->numberOfHMetrics + 1));
 	hmtxTableBuf->longHorMetrics_Host[hmtxTableBuf->numberOfHMetrics] = (HmtxTable_LongHorMetric_Member){
@@ -1068,16 +1374,29 @@ void HmtxTableBuf_appendLongHorMetric(HmtxTableBuf *hmtxTableBuf, size_t advance
 	(hmtxTableBuf->numberOfHMetrics)++;
 }
 
+void HmtxTableBuf_free(HmtxTableBuf *hmtxTableBuf)
+{
+	free(hmtxTableBuf->longHorMetrics_Host);
+	FFByteArray_free(&hmtxTableBuf->byteArray);
+	*hmtxTableBuf = (HmtxTableBuf){0};
+}
+
 void HmtxTableBuf_finally(HmtxTableBuf *hmtxTableBuf)
 {
-	for(int i = 0; i < hmtxTableBuf->numberOfHMetrics; i++){
-		HmtxTable_LongHorMetric_Member host = hmtxTableBuf->longHorMetrics_Host[i];
-		HmtxTable_LongHorMetric_Member longHorMetric = {
-			.advanceWidth	= htons(host.advanceWidth	),
-			.lsb		= htons(host.lsb		),
-		};
-		FFByteArray_append(&hmtxTableBuf->byteArray, &longHorMetric, sizeof(HmtxTable_LongHorMetric_Member));
+	if(0 == hmtxTableBuf->numberOfHMetrics){
+		return;
 	}
+
+	FFTRACE_BEGIN("hmtx", "table");
+
+	// LongHorMetric{uint16, int16}は16bit要素の並びなので一括で変換できる
+	size_t oldLength = hmtxTableBuf->byteArray.length;
+	FFByteArray_append(&hmtxTableBuf->byteArray,
+			hmtxTableBuf->longHorMetrics_Host,
+			sizeof(HmtxTable_LongHorMetric_Member) * hmtxTableBuf->numberOfHMetrics);
+	htonArray16((uint16_t *)&(hmtxTableBuf->byteArray.data[oldLength]),
+			(sizeof(HmtxTable_LongHorMetric_Member) / sizeof(uint16_t)) * hmtxTableBuf->numberOfHMetrics);
+	FFTRACE_END("hmtx", "table");
 }
 
 typedef struct{
@@ -1131,12 +1450,13 @@ size_t TableSizeAlign(size_t size)
 	return size;
 }
 
+//! @brief tableはbig endianのbyte列(4byte境界まで0で埋めてあること)
 Uint32Type CalcTableChecksum(Uint32Type *table, Uint32Type numberOfBytesInTable)
 {
 	Uint32Type sum = 0;
 	Uint32Type nLongs = (numberOfBytesInTable + 3) / 4;
 	while (nLongs-- > 0)
-		sum += *table++;
+		sum += ntohl(*table++);
 	return sum;
 }
 
@@ -1145,7 +1465,9 @@ uint32_t calcChecksumWrapper(const uint8_t *data, size_t size)
 {
 	uint8_t *d = ffmalloc(TableSizeAlign(size));
 	memcpy(d, data, size);
-	return CalcTableChecksum((uint32_t *)d, size);
+	uint32_t checksum = CalcTableChecksum((uint32_t *)d, size);
+	free(d);
+	return checksum;
 }
 
 typedef struct{
@@ -1202,6 +1524,8 @@ bool Tablebuf_appendTable(Tablebuf *tableBuf, const char *tagstring, const uint8
 	ASSERT(tableData);
 	ASSERT(0 < tableSize);
 
+	FFTRACE_BEGIN(tagstring, "appendTable");
+
 	// ** TableDirectory の作成
 	// TableDirectoryを1メンバ分伸ばす
 	tableBuf->tableDirectory = ffrealloc(tableBuf->tableDirectory, sizeof(TableDirectory_Member) * (tableBuf->appendTableNum + 1));
@@ -1223,10 +1547,19 @@ bool Tablebuf_appendTable(Tablebuf *tableBuf, const char *tagstring, const uint8
 	tableBuf->dataSize		+= alignedSize;
 	tableBuf->appendTableNum	+= 1;
 
+	FFTRACE_END(tagstring, "appendTable");
+
 	DEBUG_LOG("out table:`%s` %zu %zu %zu", tagstring, tableSize, alignedSize, offset);
 	return true;
 }
 
+void Tablebuf_free(Tablebuf *tableBuf)
+{
+	free(tableBuf->tableDirectory);
+	free(tableBuf->data);
+	Tablebuf_init(tableBuf);
+}
+
 void Tablebuf_finallyTableDirectoryOffset(Tablebuf *tableBuf, size_t offsetHeadSize)
 {
 	ASSERT(tableBuf);
@@ -0,0 +1,133 @@
+/**
+  @file
+  @brief 文字列の送り幅の計測(cmap -> glyph -> 'hmtx')。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  TextMeasure_init()でcmap(format 12, 無ければformat 4)を2段の表(CmapPageTable)へ、hmtxをhost byte orderの配列へ展開しておき、
+  計測時はフォントのbyte列を読まない(1文字を定数時間で引く)。
+ */
+#ifndef DAISYFF_TEXT_MEASURE_HPP_
+#define DAISYFF_TEXT_MEASURE_HPP_
+
+#include "src/CmapPageTable.h"
+#include "src/Utf.h"
+
+typedef struct{
+	uint16_t		numGlyphs;
+	uint16_t		unitsPerEm;
+	uint16_t		*advanceWidths;		//!< [numGlyphs] numberOfHMetrics以降も展開済み
+	CmapPageTable		cmap;
+	uint16_t		asciiGlyphIds[0x80];
+}TextMeasure;
+
+typedef struct{
+	uint64_t		advance;	//!< font unit
+	size_t			charNum;
+	size_t			unmappedNum;	//!< .notdefの送り幅で数えた文字の数
+}TextMeasureResult;
+
+void TextMeasure_free(TextMeasure *measure)
+{
+	free(measure->advanceWidths);
+	CmapPageTable_free(&measure->cmap);
+	*measure = (TextMeasure){0};
+}
+
+//! @return GlyphId(0: 割り当て無し)
+uint16_t TextMeasure_glyphIdOfCodepoint(const TextMeasure *measure, uint32_t codepoint)
+{
+	return CmapPageTable_glyphId(&measure->cmap, codepoint);
+}
+
+/** @brief parserのcmapとhmtxを展開する(以降parserは参照しない)。
+  cmapが無い・不正な場合は読めた所までの割り当て(全て.notdef)で計測する。
+  @return 'head', 'maxp', 'hhea', 'hmtx'が無い・不正、またはglyphが無い
+  */
+FontParseError TextMeasure_init(TextMeasure *measure, const FontParser *parser)
+{
+	*measure = (TextMeasure){0};
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	HheaTable hhea;
+	FontParseHmtx hmtx;
+	FontParseError error = FontParser_head(parser, &head);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxp);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_hhea(parser, &hhea);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_hmtx(parser, hhea.numberOfHMetrics, maxp.numGlyphs, &hmtx);
+	}
+	if(FontParseError_None != error){
+		return error;
+	}
+	if(0 == maxp.numGlyphs || 0 == head.unitsPerEm){
+		return FontParseError_InvalidValue;
+	}
+	measure->numGlyphs = maxp.numGlyphs;
+	measure->unitsPerEm = head.unitsPerEm;
+
+	measure->advanceWidths = (uint16_t *)ffmalloc(sizeof(uint16_t) * maxp.numGlyphs);
+	for(size_t i = 0; i < maxp.numGlyphs; i++){
+		int16_t lsb;
+		FontParseHmtx_metric(&hmtx, i, &measure->advanceWidths[i], &lsb);
+	}
+
+	// 不正なsubtableは読めた所までを使う
+	FontParseCmap cmap;
+	FontSpan subtable = {NULL, 0};
+	if(FontParseError_None == FontParser_cmap(parser, &cmap)){
+		FontParseCmap_unicodeSubtable(&cmap, &subtable);
+	}
+	if(NULL != subtable.data){
+		CmapPageTable_build(&measure->cmap, subtable, maxp.numGlyphs);
+	}else{
+		CmapPageTable_init(&measure->cmap, maxp.numGlyphs);
+	}
+	FontParseCmap_free(&cmap);
+
+	for(uint32_t c = 0; c < 0x80; c++){
+		measure->asciiGlyphIds[c] = TextMeasure_glyphIdOfCodepoint(measure, c);
+	}
+	return FontParseError_None;
+}
+
+uint16_t TextMeasure_advanceOfCodepoint(const TextMeasure *measure, uint32_t codepoint)
+{
+	const uint16_t glyphId = (codepoint < 0x80)? measure->asciiGlyphIds[codepoint] : TextMeasure_glyphIdOfCodepoint(measure, codepoint);
+	return measure->advanceWidths[glyphId];
+}
+
+/** @brief UTF-8文字列の送り幅の合計(kerningは含まない)。割り当ての無い文字は.notdefの送り幅で数える。
+  @return false: 不正なUTF-8(resultは不正な位置の手前までの値)
+  */
+bool TextMeasure_measureUtf8(const TextMeasure *measure, const char *text, size_t size, TextMeasureResult *result)
+{
+	const uint8_t *src = (const uint8_t *)text;
+	*result = (TextMeasureResult){0};
+	size_t i = 0;
+	while(i < size){
+		uint16_t glyphId;
+		size_t length = 1;
+		if(src[i] < 0x80){
+			glyphId = measure->asciiGlyphIds[src[i]];
+		}else{
+			uint32_t codepoint;
+			length = Utf8_decodeOne_inline_(&src[i], size - i, &codepoint);
+			if(0 == length){
+				return false;
+			}
+			glyphId = TextMeasure_glyphIdOfCodepoint(measure, codepoint);
+		}
+		result->unmappedNum += (0 == glyphId)? 1 : 0;
+		result->advance += measure->advanceWidths[glyphId];
+		result->charNum++;
+		i += length;
+	}
+	return true;
+}
+
+#endif // #ifndef DAISYFF_TEXT_MEASURE_HPP_
@@ -0,0 +1,153 @@
+/**
+  @file
+  @brief stage/table単位の処理時間を記録し、Chrome trace-event JSON形式で書き出す。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  chrome://tracing や https://ui.perfetto.dev で開ける。
+  FFTrace_enable()するまでは記録しない(FFTRACE_*は分岐1つのみ)。
+  `-DFF_TRACE=0`でコンパイル時に除去する。
+  記録はプロセス全体で1つ(mutexで保護)。tidはthread毎に記録順で採番する。
+ */
+#ifndef DAISYFF_TRACE_HPP_
+#define DAISYFF_TRACE_HPP_
+
+#include "src/Util.h"
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifndef FF_TRACE
+#define FF_TRACE 1
+#endif
+
+typedef struct{
+	char		name[64];
+	const char	*category;	//!< 文字列リテラルを想定(コピーしない)
+	char		phase;		//!< 'B'(begin) or 'E'(end)
+	double		timestampUs;
+	int		tid;
+}FFTraceEvent;
+
+typedef struct{
+	bool		isEnabled;
+	FFTraceEvent	*events;
+	size_t		eventNum;
+	size_t		eventCapacity;
+}FFTrace;
+
+FFTrace ffTrace_ = {0};
+pthread_mutex_t ffTraceMutex_ = PTHREAD_MUTEX_INITIALIZER;
+int ffTraceTidNum_ = 0;
+_Thread_local int ffTraceTid_ = 0;
+
+double FFTrace_nowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec * 1e6) + ((double)ts.tv_nsec / 1e3);
+}
+
+void FFTrace_enable()
+{
+	ffTrace_.isEnabled = true;
+}
+
+void FFTrace_append_inline_(char phase, const char *name, const char *category)
+{
+	const double timestampUs = FFTrace_nowUs();
+
+	pthread_mutex_lock(&ffTraceMutex_);
+	if(0 == ffTraceTid_){
+		ffTraceTid_ = ++ffTraceTidNum_;
+	}
+	if(ffTrace_.eventNum == ffTrace_.eventCapacity){
+		ffTrace_.eventCapacity = (0 == ffTrace_.eventCapacity)? 256 : (ffTrace_.eventCapacity * 2);
+		ffTrace_.events = (FFTraceEvent *)ffrealloc(ffTrace_.events, sizeof(FFTraceEvent) * ffTrace_.eventCapacity);
+	}
+
+	FFTraceEvent *event = &ffTrace_.events[ffTrace_.eventNum];
+	snprintf(event->name, sizeof(event->name), "%s", (NULL != name)? name : "");
+	event->category		= category;
+	event->phase		= phase;
+	event->timestampUs	= timestampUs;
+	event->tid		= ffTraceTid_;
+	ffTrace_.eventNum++;
+	pthread_mutex_unlock(&ffTraceMutex_);
+}
+
+#if FF_TRACE
+#define FFTRACE_BEGIN(name, category) \
+	do{ \
+		if(ffTrace_.isEnabled){ \
+			FFTrace_append_inline_('B', (name), (category)); \
+		} \
+	}while(0)
+#define FFTRACE_END(name, category) \
+	do{ \
+		if(ffTrace_.isEnabled){ \
+			FFTrace_append_inline_('E', (name), (category)); \
+		} \
+	}while(0)
+#else
+#define FFTRACE_BEGIN(name, category) do{ (void)(name); (void)(category); }while(0)
+#define FFTRACE_END(name, category) do{ (void)(name); (void)(category); }while(0)
+#endif
+
+void FFTrace_fprintJsonString_inline_(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for(const char *c = str; '\0' != *c; c++){
+		if('"' == *c || '\\' == *c){
+			fprintf(fp, "\\%c", *c);
+		}else if(0 == isprint((unsigned char)*c)){
+			fprintf(fp, "\\u%04x", (unsigned char)*c);
+		}else{
+			fputc(*c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+//! @brief 記録したイベントを書き出し、記録を破棄する。
+bool FFTrace_writeJson(const char *filepath)
+{
+	ASSERT(filepath);
+
+	FILE *fp = fopen(filepath, "w");
+	if(NULL == fp){
+		ERROR_LOG("`%s` %d %s", filepath, errno, strerror(errno));
+		return false;
+	}
+
+	pthread_mutex_lock(&ffTraceMutex_);
+	const int pid = (int)getpid();
+	fprintf(fp, "{\"traceEvents\":[\n");
+	for(size_t i = 0; i < ffTrace_.eventNum; i++){
+		const FFTraceEvent *event = &ffTrace_.events[i];
+		fprintf(fp, "{\"name\":");
+		FFTrace_fprintJsonString_inline_(fp, event->name);
+		fprintf(fp, ",\"cat\":");
+		FFTrace_fprintJsonString_inline_(fp, (NULL != event->category)? event->category : "");
+		fprintf(fp, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}%s\n",
+				event->phase, event->timestampUs, pid, event->tid,
+				((i + 1) < ffTrace_.eventNum)? ",":"");
+	}
+	fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+
+	bool isSuccess = (0 == ferror(fp));
+	isSuccess = (0 == fclose(fp)) && isSuccess;
+
+	free(ffTrace_.events);
+	ffTrace_.events		= NULL;
+	ffTrace_.eventNum	= 0;
+	ffTrace_.eventCapacity	= 0;
+	pthread_mutex_unlock(&ffTraceMutex_);
+
+	return isSuccess;
+}
+
+#endif // #ifndef DAISYFF_TRACE_HPP_
+
@@ -0,0 +1,140 @@
+/**
+  @file
+  @brief UTF-8 -> UTF-16BE 変換('name' Table等の文字列用)。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  ASCIIの連続部分はSSE2で16byteずつ変換する。
+  不正なUTF-8(overlong, サロゲート, U+10FFFF超, 途中で切れた列)はエラーとする。
+ */
+#ifndef DAISYFF_UTF_HPP_
+#define DAISYFF_UTF_HPP_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DAISYFF_UTF_SSE2
+#endif
+
+/** @brief UTF-8の1文字を読む。
+  @return 読んだbyte数。0: 不正な列
+  */
+size_t Utf8_decodeOne_inline_(const uint8_t *src, size_t srcSize, uint32_t *codepoint)
+{
+	const uint8_t c0 = src[0];
+	if(c0 < 0x80){
+		*codepoint = c0;
+		return 1;
+	}
+
+	size_t length;
+	uint32_t cp;
+	uint32_t min;
+	if(0xC0 == (c0 & 0xE0)){
+		length = 2; cp = c0 & 0x1F; min = 0x80;
+	}else if(0xE0 == (c0 & 0xF0)){
+		length = 3; cp = c0 & 0x0F; min = 0x800;
+	}else if(0xF0 == (c0 & 0xF8)){
+		length = 4; cp = c0 & 0x07; min = 0x10000;
+	}else{
+		return 0; // 継続byte, 0xF8以上
+	}
+	if(srcSize < length){
+		return 0;
+	}
+	for(size_t i = 1; i < length; i++){
+		if(0x80 != (src[i] & 0xC0)){
+			return 0;
+		}
+		cp = (cp << 6) | (src[i] & 0x3F);
+	}
+	if(cp < min || 0x10FFFF < cp || (0xD800 <= cp && cp <= 0xDFFF)){
+		return 0;
+	}
+
+	*codepoint = cp;
+	return length;
+}
+
+/** @brief ASCIIの連続部分を変換する。
+  @return 変換したbyte数(srcの先頭から)
+  */
+size_t Utf8_toUtf16BEAscii_inline_(uint8_t *dst, const uint8_t *src, size_t srcSize)
+{
+	size_t i = 0;
+#ifdef DAISYFF_UTF_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	while(i + 16 <= srcSize){
+		const __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+		const int mask = _mm_movemask_epi8(v);
+		if(0 != mask){
+			// 非ASCIIの手前まで
+			const size_t asciiNum = (size_t)__builtin_ctz((unsigned int)mask);
+			for(size_t n = 0; n < asciiNum; n++){
+				dst[(i + n) * 2 + 0] = 0x00;
+				dst[(i + n) * 2 + 1] = src[i + n];
+			}
+			return i + asciiNum;
+		}
+		// 上位byteに0を挟む = big endianのUTF-16
+		_mm_storeu_si128((__m128i *)&dst[i * 2 +  0], _mm_unpacklo_epi8(zero, v));
+		_mm_storeu_si128((__m128i *)&dst[i * 2 + 16], _mm_unpackhi_epi8(zero, v));
+		i += 16;
+	}
+#endif
+	for(; i < srcSize && src[i] < 0x80; i++){
+		dst[i * 2 + 0] = 0x00;
+		dst[i * 2 + 1] = src[i];
+	}
+	return i;
+}
+
+/** @brief UTF-8をUTF-16BEへ変換する。
+  @param dst (srcSize * 2)byte以上
+  @param dstSize 書き込んだbyte数を返す
+  @return false: 不正なUTF-8
+  */
+bool Utf8_toUtf16BE(uint8_t *dst, size_t *dstSize, const uint8_t *src, size_t srcSize)
+{
+	size_t si = 0;
+	size_t di = 0;
+	while(si < srcSize){
+		if(src[si] < 0x80){
+			const size_t asciiNum = Utf8_toUtf16BEAscii_inline_(&dst[di], &src[si], srcSize - si);
+			si += asciiNum;
+			di += asciiNum * 2;
+			continue;
+		}
+
+		uint32_t cp;
+		const size_t length = Utf8_decodeOne_inline_(&src[si], srcSize - si, &cp);
+		if(0 == length){
+			*dstSize = di;
+			return false;
+		}
+		si += length;
+		if(cp < 0x10000){
+			dst[di++] = (uint8_t)(cp >> 8);
+			dst[di++] = (uint8_t)(cp & 0xFF);
+		}else{
+			// サロゲートペア(4byteのUTF-8から4byteなので、dstの見積もりは超えない)
+			const uint32_t v = cp - 0x10000;
+			const uint16_t high = (uint16_t)(0xD800 | (v >> 10));
+			const uint16_t low = (uint16_t)(0xDC00 | (v & 0x3FF));
+			dst[di++] = (uint8_t)(high >> 8);
+			dst[di++] = (uint8_t)(high & 0xFF);
+			dst[di++] = (uint8_t)(low >> 8);
+			dst[di++] = (uint8_t)(low & 0xFF);
+		}
+	}
+
+	*dstSize = di;
+	return true;
+}
+
+#endif // #ifndef DAISYFF_UTF_HPP_
+
@@ -23,12 +23,30 @@
 // debug print
 // ********
 
+/** ログレベルはコンパイル時に決める(`make LOG_LEVEL=3`など)。
+  レベル外のログは定数条件で除去されるが、引数の型チェックは残る。
+  */
+#define FF_LOG_LEVEL_NONE	0
+#define FF_LOG_LEVEL_ERROR	1
+#define FF_LOG_LEVEL_WARN	2
+#define FF_LOG_LEVEL_DEBUG	3
+#ifndef FF_LOG_LEVEL
+#define FF_LOG_LEVEL FF_LOG_LEVEL_WARN
+#endif
+
+#define FF_LOG_inline_(level, stream, prefix, fmt, ...) \
+	do{ \
+		if((level) <= FF_LOG_LEVEL){ \
+			fprintf(stream, prefix": %s()[%d]: "fmt"\n", __func__, __LINE__, ## __VA_ARGS__); \
+		} \
+	}while(0)
+
 #define ERROR_LOG(fmt, ...) \
-	fprintf(stderr, "error: %s()[%d]: "fmt"\n", __func__, __LINE__, ## __VA_ARGS__)
+	FF_LOG_inline_(FF_LOG_LEVEL_ERROR, stderr, "error", fmt, ## __VA_ARGS__)
 #define WARN_LOG(fmt, ...) \
-	fprintf(stderr, "warning: %s()[%d]: "fmt"\n", __func__, __LINE__, ## __VA_ARGS__)
+	FF_LOG_inline_(FF_LOG_LEVEL_WARN, stderr, "warning", fmt, ## __VA_ARGS__)
 #define DEBUG_LOG(fmt, ...) \
-	fprintf(stdout, "debug: %s()[%d]: "fmt"\n", __func__, __LINE__, ## __VA_ARGS__)
+	FF_LOG_inline_(FF_LOG_LEVEL_DEBUG, stdout, "debug", fmt, ## __VA_ARGS__)
 #define ASSERT(hr) \
 	do{ \
 		if(!(hr)){ \
@@ -74,7 +92,11 @@ void DUMP0_inline_(uint8_t *buf, size_t size)
 	fprintf(stdout, "\n");
 }
 #define DUMP0(buf, size) \
-	DEBUG_LOG("DUMP0:`" #buf "`[`" #size "`]:"); DUMP0_inline_((buf), (size));
+	do{ \
+		if(FF_LOG_LEVEL_DEBUG <= FF_LOG_LEVEL){ \
+			DEBUG_LOG("DUMP0:`" #buf "`[`" #size "`]:"); DUMP0_inline_((buf), (size)); \
+		} \
+	}while(0)
 
 void DUMPUint16_inline_(uint16_t *array16, size_t array16Num)
 {
@@ -87,7 +109,11 @@ void DUMPUint16_inline_(uint16_t *array16, size_t array16Num)
 	fprintf(stdout, "\n");
 }
 #define DUMPUint16(buf, size) \
-	DEBUG_LOG("DUMPUint16:`" #buf "`[`" #size "`]:"); DUMPUint16_inline_((buf), (size));
+	do{ \
+		if(FF_LOG_LEVEL_DEBUG <= FF_LOG_LEVEL){ \
+			DEBUG_LOG("DUMPUint16:`" #buf "`[`" #size "`]:"); DUMPUint16_inline_((buf), (size)); \
+		} \
+	}while(0)
 
 void DUMPUint16Ntohs_inline_(uint16_t *array16, size_t array16Num)
 {
@@ -100,20 +126,294 @@ void DUMPUint16Ntohs_inline_(uint16_t *array16, size_t array16Num)
 	fprintf(stdout, "\n");
 }
 #define DUMPUint16Ntohs(buf, size) \
-	DEBUG_LOG("DUMPUint16:`" #buf "`[`" #size "`]:"); DUMPUint16Ntohs_inline_((buf), (size));
+	do{ \
+		if(FF_LOG_LEVEL_DEBUG <= FF_LOG_LEVEL){ \
+			DEBUG_LOG("DUMPUint16:`" #buf "`[`" #size "`]:"); DUMPUint16Ntohs_inline_((buf), (size)); \
+		} \
+	}while(0)
 
 // ********
 // memory allocate
 // ********
 
+/** 確保の記録(`make ALLOC_TRACE=1`)。
+  ffmalloc/ffreallocの呼び出し元(関数名と行)毎に回数・確保した合計・生存中の量とその最大を数え、終了時にstderrへ出力する。
+  free()はmacroで置き換えて記録から外す(ffmalloc/ffrealloc以外で確保した領域はそのまま解放する)。
+  記録は1つのmutexで守るので、複数threadから確保・解放してよい。
+  */
+#ifndef FF_ALLOC_TRACE
+#define FF_ALLOC_TRACE 0
+#endif
+
+#if FF_ALLOC_TRACE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct{
+	const char	*func;
+	int		line;
+	const char	*expression;	//!< ffmalloc, ffreallocの引数の大きさの式
+	size_t		callNum;
+	size_t		totalBytes;	//!< 確保した量の合計(reallocは新しい大きさ)
+	size_t		liveBytes;	//!< 解放されていない量
+	size_t		peakBytes;	//!< liveBytesの最大
+	size_t		liveNum;	//!< 解放されていない領域の数
+}FFAllocSite;
+
+typedef struct{
+	void		*pointer;	//!< NULL: 空き
+	size_t		size;
+	size_t		siteIndex;
+}FFAllocBlock;
+
+typedef struct{
+	pthread_mutex_t	mutex;
+	FFAllocSite	*sites;		//!< [siteNum] 追加のみ(indexは変わらない)
+	size_t		siteNum;
+	size_t		siteCapacity;
+	uint32_t	*siteSlots;	//!< [siteSlotNum] 呼び出し元のhash(siteIndex + 1, 0: 空き)
+	size_t		siteSlotNum;
+	FFAllocBlock	*blocks;	//!< [blockSlotNum] 生存中の領域のhash(線形探索)
+	size_t		blockSlotNum;
+	size_t		blockNum;
+	size_t		allocNum;
+	size_t		reallocNum;
+	size_t		freeNum;	//!< 記録から外した解放
+	size_t		liveBytes;
+	size_t		peakBytes;
+	bool		isRegistered;	//!< atexit()済み
+}FFAllocTrace;
+FFAllocTrace ffAllocTrace = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+size_t FFAllocTrace_hash_inline_(uintptr_t key, size_t slotNum)
+{
+	return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> 32) & (slotNum - 1);
+}
+
+//! @brief 呼び出し元の記録を引く(無ければ作る)
+size_t FFAllocTrace_site_inline_(FFAllocTrace *trace, const char *func, int line, const char *expression)
+{
+	if(trace->siteSlotNum <= trace->siteNum * 2){
+		// hashを作り直す(記録は動かさない)
+		trace->siteSlotNum = (0 == trace->siteSlotNum)? 256 : trace->siteSlotNum * 2;
+		(free)(trace->siteSlots);
+		trace->siteSlots = (uint32_t *)calloc(trace->siteSlotNum, sizeof(uint32_t));
+		ASSERT(NULL != trace->siteSlots);
+		for(size_t i = 0; i < trace->siteNum; i++){
+			size_t slot = FFAllocTrace_hash_inline_((uintptr_t)trace->sites[i].func ^ (uintptr_t)trace->sites[i].line, trace->siteSlotNum);
+			while(0 != trace->siteSlots[slot]){
+				slot = (slot + 1) & (trace->siteSlotNum - 1);
+			}
+			trace->siteSlots[slot] = (uint32_t)(i + 1);
+		}
+	}
+	size_t slot = FFAllocTrace_hash_inline_((uintptr_t)func ^ (uintptr_t)line, trace->siteSlotNum);
+	while(0 != trace->siteSlots[slot]){
+		const size_t index = trace->siteSlots[slot] - 1;
+		if(func == trace->sites[index].func && line == trace->sites[index].line){
+			return index;
+		}
+		slot = (slot + 1) & (trace->siteSlotNum - 1);
+	}
+	if(trace->siteCapacity <= trace->siteNum){
+		trace->siteCapacity = (0 == trace->siteCapacity)? 64 : trace->siteCapacity * 2;
+		trace->sites = (FFAllocSite *)realloc(trace->sites, sizeof(FFAllocSite) * trace->siteCapacity);
+		ASSERT(NULL != trace->sites);
+	}
+	trace->sites[trace->siteNum] = (FFAllocSite){.func = func, .line = line, .expression = expression};
+	trace->siteSlots[slot] = (uint32_t)(trace->siteNum + 1);
+	return trace->siteNum++;
+}
+
+void FFAllocTrace_insertBlock_inline_(FFAllocTrace *trace, FFAllocBlock block)
+{
+	size_t slot = FFAllocTrace_hash_inline_((uintptr_t)block.pointer >> 4, trace->blockSlotNum);
+	while(NULL != trace->blocks[slot].pointer){
+		slot = (slot + 1) & (trace->blockSlotNum - 1);
+	}
+	trace->blocks[slot] = block;
+}
+
+//! @brief 領域を記録に加える(呼び出し元と全体の生存中の量を増やす)
+void FFAllocTrace_add_inline_(FFAllocTrace *trace, void *p, size_t size, size_t siteIndex)
+{
+	if(trace->blockSlotNum <= trace->blockNum * 2){
+		FFAllocBlock *blocks = trace->blocks;
+		const size_t blockSlotNum = trace->blockSlotNum;
+		trace->blockSlotNum = (0 == blockSlotNum)? 1024 : blockSlotNum * 2;
+		trace->blocks = (FFAllocBlock *)calloc(trace->blockSlotNum, sizeof(FFAllocBlock));
+		ASSERT(NULL != trace->blocks);
+		for(size_t i = 0; i < blockSlotNum; i++){
+			if(NULL != blocks[i].pointer){
+				FFAllocTrace_insertBlock_inline_(trace, blocks[i]);
+			}
+		}
+		(free)(blocks);
+	}
+	FFAllocTrace_insertBlock_inline_(trace, (FFAllocBlock){p, size, siteIndex});
+	trace->blockNum++;
+	FFAllocSite *site = &trace->sites[siteIndex];
+	site->callNum++;
+	site->totalBytes += size;
+	site->liveBytes += size;
+	site->liveNum++;
+	site->peakBytes = (site->peakBytes < site->liveBytes)? site->liveBytes : site->peakBytes;
+	trace->liveBytes += size;
+	trace->peakBytes = (trace->peakBytes < trace->liveBytes)? trace->liveBytes : trace->peakBytes;
+}
+
+//! @brief 領域を記録から外す @return false: 記録に無い(ffmalloc以外で確保した)
+bool FFAllocTrace_remove_inline_(FFAllocTrace *trace, void *p)
+{
+	if(NULL == p || 0 == trace->blockSlotNum){
+		return false;
+	}
+	const size_t mask = trace->blockSlotNum - 1;
+	size_t slot = FFAllocTrace_hash_inline_((uintptr_t)p >> 4, trace->blockSlotNum);
+	while(p != trace->blocks[slot].pointer){
+		if(NULL == trace->blocks[slot].pointer){
+			return false;
+		}
+		slot = (slot + 1) & mask;
+	}
+	const FFAllocBlock block = trace->blocks[slot];
+	FFAllocSite *site = &trace->sites[block.siteIndex];
+	site->liveBytes -= block.size;
+	site->liveNum--;
+	trace->liveBytes -= block.size;
+	trace->blockNum--;
+	// 後ろの要素を詰める(線形探索の並びを保つ)
+	size_t hole = slot;
+	for(size_t next = (slot + 1) & mask; NULL != trace->blocks[next].pointer; next = (next + 1) & mask){
+		const size_t home = FFAllocTrace_hash_inline_((uintptr_t)trace->blocks[next].pointer >> 4, trace->blockSlotNum);
+		if(((next - home) & mask) >= ((next - hole) & mask)){
+			trace->blocks[hole] = trace->blocks[next];
+			hole = next;
+		}
+	}
+	trace->blocks[hole] = (FFAllocBlock){0};
+	return true;
+}
+
+int FFAllocTrace_compareSite_inline_(const void *a, const void *b)
+{
+	const FFAllocSite *sa = (const FFAllocSite *)a;
+	const FFAllocSite *sb = (const FFAllocSite *)b;
+	if(sa->liveBytes != sb->liveBytes){
+		return (sa->liveBytes < sb->liveBytes)? 1 : -1;
+	}
+	if(sa->peakBytes != sb->peakBytes){
+		return (sa->peakBytes < sb->peakBytes)? 1 : -1;
+	}
+	return (sa->totalBytes < sb->totalBytes)? 1 : ((sb->totalBytes < sa->totalBytes)? -1 : 0);
+}
+
+//! @brief 全体と呼び出し元毎(生存中の量の多い順)の記録を出力する
+void FFAllocTrace_report(FILE *stream)
+{
+	FFAllocTrace *trace = &ffAllocTrace;
+	pthread_mutex_lock(&trace->mutex);
+	FFAllocSite *sites = (FFAllocSite *)malloc(sizeof(FFAllocSite) * (trace->siteNum + 1));
+	ASSERT(NULL != sites);
+	memcpy(sites, trace->sites, sizeof(FFAllocSite) * trace->siteNum);
+	const size_t siteNum = trace->siteNum;
+	fprintf(stream, "alloc-trace: allocs %zu reallocs %zu frees %zu peak %zu bytes live %zu bytes in %zu blocks sites %zu\n",
+			trace->allocNum, trace->reallocNum, trace->freeNum, trace->peakBytes, trace->liveBytes, trace->blockNum, siteNum);
+	pthread_mutex_unlock(&trace->mutex);
+
+	qsort(sites, siteNum, sizeof(FFAllocSite), FFAllocTrace_compareSite_inline_);
+	for(size_t i = 0; i < siteNum; i++){
+		const FFAllocSite *site = &sites[i];
+		fprintf(stream, "alloc-trace: %s()[%d] calls %zu total %zu peak %zu live %zu in %zu blocks (%s)\n",
+				site->func, site->line, site->callNum, site->totalBytes, site->peakBytes,
+				site->liveBytes, site->liveNum, site->expression);
+	}
+	(free)(sites);
+}
+
+void FFAllocTrace_atexit_inline_(void)
+{
+	FFAllocTrace_report(stderr);
+}
+
+/** @brief 確保・再確保した領域を記録する(呼び出し側がtrace->mutexを取っておく)。
+  @param src 再確保の元の領域のaddress(0: 新たな確保。realloc()の前に値にしておく)
+  */
+void FFAllocTrace_record_inline_(FFAllocTrace *trace, uintptr_t src, void *dstp, size_t size, const char *expression, const char *func, int line)
+{
+	if(! trace->isRegistered){
+		trace->isRegistered = true;
+		atexit(FFAllocTrace_atexit_inline_);
+	}
+	if(0 == src){
+		trace->allocNum++;
+	}else{
+		trace->reallocNum++;
+		FFAllocTrace_remove_inline_(trace, (void *)src);
+	}
+	FFAllocTrace_add_inline_(trace, dstp, size, FFAllocTrace_site_inline_(trace, func, line, expression));
+}
+
+void fffree_inline_(void *p)
+{
+	FFAllocTrace *trace = &ffAllocTrace;
+	pthread_mutex_lock(&trace->mutex);
+	trace->freeNum += FFAllocTrace_remove_inline_(trace, p)? 1 : 0;
+	pthread_mutex_unlock(&trace->mutex);
+	(free)(p);
+}
+#define free(p) fffree_inline_(p)
+#endif // #if FF_ALLOC_TRACE
+
+/** 確保失敗の注入(テスト用)。
+  ffAllocFailCountdownを1以上にすると、そのthreadでその回数目のffmalloc/ffreallocを失敗させる。
+  */
+#ifndef FF_ALLOC_FAIL_INJECT
+#define FF_ALLOC_FAIL_INJECT 0
+#endif
+
+#if FF_ALLOC_FAIL_INJECT
+#include <stdbool.h>
+
+_Thread_local size_t ffAllocFailCountdown = 0;
+
+bool ffAllocFailInject_inline_(void)
+{
+	if(0 == ffAllocFailCountdown){
+		return false;
+	}
+	return (0 == --ffAllocFailCountdown);
+}
+#endif
+
+#include <setjmp.h>
+/** 確保失敗時の戻り先(threadごと)。
+  NULLの間はffmalloc/ffreallocの失敗でプロセスを終了する。
+  設定した呼び出し側はlongjmp()で戻り、その間に確保した作業領域は解放されない。
+  */
+_Thread_local jmp_buf *ffAllocFailureJump = NULL;
+
 void *ffmalloc_inline_(size_t size, const char *strsize, const char *func, int line)
 {
+#if FF_ALLOC_FAIL_INJECT
+	void *p = ffAllocFailInject_inline_()? NULL : malloc(size);
+#else
 	void *p = malloc(size);
+#endif
 	if(NULL == p){
+		if(NULL != ffAllocFailureJump){
+			longjmp(*ffAllocFailureJump, 1);
+		}
 		fprintf(stderr, "critical: %s()[%d]:ffmalloc(%s)\n", func, line, strsize);
 		exit(1);
 	}
 	memset(p, 0, size);
+#if FF_ALLOC_TRACE
+	pthread_mutex_lock(&ffAllocTrace.mutex);
+	FFAllocTrace_record_inline_(&ffAllocTrace, 0, p, size, strsize, func, line);
+	pthread_mutex_unlock(&ffAllocTrace.mutex);
+#endif
 
 	return p;
 }
@@ -124,11 +424,30 @@ void *ffrealloc_inline_(
 		const char *strsrcp, const char *strsize,
 		const char *func, int line)
 {
+#if FF_ALLOC_TRACE
+	// realloc()が解放したsrcのaddressを別threadが確保して記録する前に、記録を移し終える
+	const uintptr_t src = (uintptr_t)srcp;
+	pthread_mutex_lock(&ffAllocTrace.mutex);
+#endif
+#if FF_ALLOC_FAIL_INJECT
+	void *dstp = ffAllocFailInject_inline_()? NULL : realloc(srcp, size);
+#else
 	void *dstp = realloc(srcp, size);
+#endif
 	if(NULL == dstp){
+#if FF_ALLOC_TRACE
+		pthread_mutex_unlock(&ffAllocTrace.mutex); // atexit()の出力・戻り先の後の確保が取る
+#endif
+		if(NULL != ffAllocFailureJump){
+			longjmp(*ffAllocFailureJump, 1);
+		}
 		fprintf(stderr, "critical: %s()[%d]:ffrealloc(%s, %s)'\n", func, line, strsrcp, strsize);
 		exit(1);
 	}
+#if FF_ALLOC_TRACE
+	FFAllocTrace_record_inline_(&ffAllocTrace, src, dstp, size, strsize, func, line);
+	pthread_mutex_unlock(&ffAllocTrace.mutex);
+#endif
 
 	return dstp;
 }
@@ -190,35 +509,101 @@ void FFByteArray_appendArray(FFByteArray *array, FFByteArray array1)
 	FFByteArray_append(array, array1.data, array1.length);
 }
 
-// ********
-// data endian
-// ********
-
-// http://www.math.kobe-u.ac.jp/HOME/kodama/tips-C-endian.html
-bool IS_LITTLE_ENDIAN()
+void FFByteArray_free(FFByteArray *array)
 {
-        int i = 1;
-        return (bool)(*(char*)&i);
+	free(array->data);
+	array->data = NULL;
+	array->length = 0;
 }
 
-uint64_t htonll(uint64_t x)
+/** @brief big endianで末尾へ書き足していくbuffer(Tableの組み立て用)。
+  容量は倍々に伸ばす。{0}で初期化し、FFByteWriter_toByteArray()で中身を渡すかfree(data)する。
+  */
+typedef struct{
+	uint8_t		*data;
+	size_t		length;
+	size_t		capacity;
+}FFByteWriter;
+
+//! @brief 末尾にsize byteを書き足せる容量を確保する
+void FFByteWriter_reserve(FFByteWriter *writer, size_t size)
 {
-	if(IS_LITTLE_ENDIAN()){
-		return bswap_64(x);
-	}else{
-		return x;
+	if(writer->length + size <= writer->capacity){
+		return;
 	}
+	size_t capacity = (0 == writer->capacity)? 256 : writer->capacity;
+	while(capacity < writer->length + size){
+		capacity *= 2;
+	}
+	writer->data = (uint8_t *)ffrealloc(writer->data, capacity);
+	writer->capacity = capacity;
 }
 
-void htonArray16Move(uint8_t *buf8, const uint16_t *array16, size_t array16Num)
+//! @brief 末尾をsize byte伸ばし、その先頭を返す(中身は呼び出し側が埋める)
+uint8_t *FFByteWriter_extend(FFByteWriter *writer, size_t size)
 {
-	uint16_t *buf16 = (uint16_t *)ffmalloc(sizeof(uint16_t) * array16Num);
-	for(int i = 0; i < array16Num; i++){
-		buf16[i] = htons(array16[i]);
+	FFByteWriter_reserve(writer, size);
+	uint8_t *p = &writer->data[writer->length];
+	writer->length += size;
+	return p;
+}
+
+void FFByteWriter_uint8(FFByteWriter *writer, uint8_t value)
+{
+	*FFByteWriter_extend(writer, 1) = value;
+}
+
+void FFByteWriter_uint16(FFByteWriter *writer, uint16_t value)
+{
+	uint8_t *p = FFByteWriter_extend(writer, 2);
+	p[0] = (uint8_t)(value >> 8);
+	p[1] = (uint8_t)(value & 0xFF);
+}
+
+void FFByteWriter_uint32(FFByteWriter *writer, uint32_t value)
+{
+	FFByteWriter_uint16(writer, (uint16_t)(value >> 16));
+	FFByteWriter_uint16(writer, (uint16_t)(value & 0xFFFF));
+}
+
+void FFByteWriter_bytes(FFByteWriter *writer, const uint8_t *data, size_t size)
+{
+	if(0 < size){
+		memcpy(FFByteWriter_extend(writer, size), data, size);
 	}
-	memcpy(buf8, (uint8_t *)buf16, sizeof(uint16_t) * array16Num);
-	free(buf16);
 }
 
+//! @brief 書き出し済みの位置へ値を埋める(offsetの後埋め用)
+void FFByteWriter_setUint16(FFByteWriter *writer, size_t offset, size_t value)
+{
+	ASSERT(value <= UINT16_MAX);
+	ASSERT(offset + 2 <= writer->length);
+	writer->data[offset + 0] = (uint8_t)(value >> 8);
+	writer->data[offset + 1] = (uint8_t)(value & 0xFF);
+}
+
+void FFByteWriter_setUint32(FFByteWriter *writer, size_t offset, size_t value)
+{
+	ASSERT(value <= UINT32_MAX);
+	FFByteWriter_setUint16(writer, offset + 0, (value >> 16) & 0xFFFF);
+	FFByteWriter_setUint16(writer, offset + 2, value & 0xFFFF);
+}
+
+//! @brief 書き出した中身をFFByteArrayとして渡し、writerを空に戻す
+FFByteArray FFByteWriter_toByteArray(FFByteWriter *writer)
+{
+	FFByteArray byteArray = {
+		.length	= writer->length,
+		.data	= writer->data,
+	};
+	*writer = (FFByteWriter){0};
+	return byteArray;
+}
+
+// ********
+// data endian
+// ********
+#include "src/Endian.h"
+
 #endif // #ifndef DAISYFF_UTIL_HPP_
 
@@ -0,0 +1,1246 @@
+/**
+  @file
+  @brief 'fvar', 'avar', 'gvar' Table: 複数のmaster(互換のあるGlyphOutline)からvariable fontを生成する。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  default master('glyf' Table)との差分をglyph毎のtuple variationとして'gvar'へ出力する。
+  masterの位置からregion(start, peak, end)を決め、先のmasterの寄与を引いた差分を各tupleの値とする
+  (fontTools.varLib.models.VariationModelと同じ考え方)。
+
+  'gvar'の圧縮:
+    - IUP(Interpolation of Untouched Points)で再現できる点は出力しない
+    - point numbers, deltasはpacked形式(run length)
+    - 2つ以上のglyphで使うpeak tupleはshared tuplesへ置く
+    - 最も多く使うpoint numbersの組はglyph内で共有する(SHARED_POINT_NUMBERS)
+ */
+#ifndef DAISYFF_VARIATION_TABLES_HPP_
+#define DAISYFF_VARIATION_TABLES_HPP_
+
+#include "src/Util.h"
+#include "src/GlyphOutline.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define VariationTables_PHANTOM_POINT_NUM		(4)
+#define VariationTables_AXIS_MAX			(64)
+#define VariationTables_SHARED_TUPLE_MAX		(0x0FFF)
+#define GvarTupleIndex_EMBEDDED_PEAK_TUPLE		(0x8000)
+#define GvarTupleIndex_INTERMEDIATE_REGION		(0x4000)
+#define GvarTupleIndex_PRIVATE_POINT_NUMBERS		(0x2000)
+#define GvarTupleVariationCount_SHARED_POINT_NUMBERS	(0x8000)
+#define GvarPackedDeltas_ARE_ZERO			(0x80)
+#define GvarPackedDeltas_ARE_WORDS			(0x40)
+#define GvarPackedPointNumbers_ARE_WORDS		(0x80)
+
+typedef struct{
+	double			from;		//!< normalized
+	double			to;		//!< normalized
+}AvarAxisValueMap;
+
+typedef struct{
+	char			tag[4];
+	double			minValue;
+	double			defaultValue;
+	double			maxValue;
+	uint16_t		nameId;
+	AvarAxisValueMap	*maps;		//!< fromの昇順。-1, 0, 1の固定点を含む
+	size_t			mapNum;
+	bool			isMapped;	//!< 固定点以外のmapがある
+}FvarAxis;
+
+typedef struct{
+	uint16_t		subfamilyNameId;
+	double			*coordinates;	//!< user座標[axisNum]
+}FvarInstance;
+
+typedef struct{
+	uint16_t		glyphId;
+	int16_t			*location;	//!< normalized F2Dot14[axisNum] ('avar'適用後)
+	GlyphPoint		*points;	//!< default glyphと同じ点数
+	uint16_t		advanceWidth;
+}GvarMaster;
+
+//! default master(各glyphの'glyf'上の点)
+typedef struct{
+	GlyphPoint		*points;
+	size_t			pointNum;
+	size_t			pointCapacity;
+	uint16_t		*endPoints;	//!< glyph内のcontour終端index
+	size_t			endPointNum;
+	size_t			endPointCapacity;
+	size_t			*pointStarts;	//!< [glyph + 1]
+	size_t			*endPointStarts;	//!< [glyph + 1]
+	uint16_t		*advanceWidths;
+	size_t			glyphNum;
+	size_t			glyphCapacity;
+}VariationDefaultGlyphs;
+
+typedef struct{
+	size_t			tupleNum;	//!< 出力したtuple variation数
+	size_t			sharedTupleNum;
+	size_t			pointNum;	//!< 出力した点数(IUPで省略した後)
+	size_t			omittedPointNum;	//!< IUPで省略した点数
+	size_t			gvarSize;
+	size_t			gvarUnpackedSize;	//!< 全点をpackせずに出力した場合の'gvar'サイズ
+}GvarReport;
+
+typedef struct{
+	FvarAxis		*axes;
+	size_t			axisNum;
+	FvarInstance		*instances;
+	size_t			instanceNum;
+	GvarMaster		*masters;
+	size_t			masterNum;
+	VariationDefaultGlyphs	defaultGlyphs;
+
+	FFByteArray		fvarByteArray;
+	FFByteArray		avarByteArray;
+	FFByteArray		gvarByteArray;
+	GvarReport		report;
+}VariationTablesBuf;
+
+// ********
+// 座標
+// ********
+
+int16_t F2Dot14_fromDouble(double value)
+{
+	const double v = round(value * 16384.0);
+	return (int16_t)((v < -32768.0)? -32768.0 : ((32767.0 < v)? 32767.0 : v));
+}
+
+double F2Dot14_toDouble(int16_t value)
+{
+	return (double)value / 16384.0;
+}
+
+uint32_t FixedType_fromDouble(double value)
+{
+	return (uint32_t)(int32_t)lround(value * 65536.0);
+}
+
+//! @brief user座標 -> normalized('avar'適用前)
+double FvarAxis_normalize(const FvarAxis *axis, double value)
+{
+	if(value < axis->defaultValue){
+		if(axis->minValue == axis->defaultValue){
+			return 0.0;
+		}
+		const double v = (value - axis->defaultValue) / (axis->defaultValue - axis->minValue);
+		return (v < -1.0)? -1.0 : v;
+	}
+	if(axis->defaultValue < value){
+		if(axis->maxValue == axis->defaultValue){
+			return 0.0;
+		}
+		const double v = (value - axis->defaultValue) / (axis->maxValue - axis->defaultValue);
+		return (1.0 < v)? 1.0 : v;
+	}
+	return 0.0;
+}
+
+//! @brief 'avar'のsegment mapを適用する
+double FvarAxis_applyAvar(const FvarAxis *axis, double value)
+{
+	const AvarAxisValueMap *maps = axis->maps;
+	for(size_t i = 1; i < axis->mapNum; i++){
+		if(value <= maps[i].from){
+			const AvarAxisValueMap *a = &maps[i - 1];
+			const AvarAxisValueMap *b = &maps[i];
+			return a->to + ((b->to - a->to) * (value - a->from) / (b->from - a->from));
+		}
+	}
+	return value;
+}
+
+// ********
+// default master
+// ********
+
+void VariationDefaultGlyphs_append(VariationDefaultGlyphs *defaultGlyphs, const GlyphOutline *outline, uint16_t advanceWidth)
+{
+	if(defaultGlyphs->glyphCapacity <= defaultGlyphs->glyphNum + 1){
+		defaultGlyphs->glyphCapacity = (0 == defaultGlyphs->glyphCapacity)? 64 : (defaultGlyphs->glyphCapacity * 2);
+		defaultGlyphs->pointStarts = (size_t *)ffrealloc(
+				defaultGlyphs->pointStarts, sizeof(size_t) * (defaultGlyphs->glyphCapacity + 1));
+		defaultGlyphs->endPointStarts = (size_t *)ffrealloc(
+				defaultGlyphs->endPointStarts, sizeof(size_t) * (defaultGlyphs->glyphCapacity + 1));
+		defaultGlyphs->advanceWidths = (uint16_t *)ffrealloc(
+				defaultGlyphs->advanceWidths, sizeof(uint16_t) * defaultGlyphs->glyphCapacity);
+	}
+	const size_t glyph = defaultGlyphs->glyphNum;
+	defaultGlyphs->pointStarts[glyph] = defaultGlyphs->pointNum;
+	defaultGlyphs->endPointStarts[glyph] = defaultGlyphs->endPointNum;
+	defaultGlyphs->advanceWidths[glyph] = advanceWidth;
+
+	size_t glyphPointNum = 0;
+	for(size_t l = 0; l < outline->closePathNum; l++){
+		const GlyphClosePath *closePath = &outline->closePaths[l];
+		if(defaultGlyphs->pointCapacity < defaultGlyphs->pointNum + closePath->anchorPointNum){
+			while(defaultGlyphs->pointCapacity < defaultGlyphs->pointNum + closePath->anchorPointNum){
+				defaultGlyphs->pointCapacity = (0 == defaultGlyphs->pointCapacity)? 256 : (defaultGlyphs->pointCapacity * 2);
+			}
+			defaultGlyphs->points = (GlyphPoint *)ffrealloc(
+					defaultGlyphs->points, sizeof(GlyphPoint) * defaultGlyphs->pointCapacity);
+		}
+		for(size_t i = 0; i < closePath->anchorPointNum; i++){
+			defaultGlyphs->points[defaultGlyphs->pointNum++] = closePath->anchorPoints[i].point;
+		}
+		glyphPointNum += closePath->anchorPointNum;
+
+		if(defaultGlyphs->endPointCapacity <= defaultGlyphs->endPointNum){
+			defaultGlyphs->endPointCapacity = (0 == defaultGlyphs->endPointCapacity)? 64 : (defaultGlyphs->endPointCapacity * 2);
+			defaultGlyphs->endPoints = (uint16_t *)ffrealloc(
+					defaultGlyphs->endPoints, sizeof(uint16_t) * defaultGlyphs->endPointCapacity);
+		}
+		defaultGlyphs->endPoints[defaultGlyphs->endPointNum++] = (uint16_t)(glyphPointNum - 1);
+	}
+
+	defaultGlyphs->glyphNum++;
+	defaultGlyphs->pointStarts[defaultGlyphs->glyphNum] = defaultGlyphs->pointNum;
+	defaultGlyphs->endPointStarts[defaultGlyphs->glyphNum] = defaultGlyphs->endPointNum;
+}
+
+size_t VariationDefaultGlyphs_pointNum(const VariationDefaultGlyphs *defaultGlyphs, uint16_t glyphId)
+{
+	return defaultGlyphs->pointStarts[glyphId + 1] - defaultGlyphs->pointStarts[glyphId];
+}
+
+size_t VariationDefaultGlyphs_contourNum(const VariationDefaultGlyphs *defaultGlyphs, uint16_t glyphId)
+{
+	return defaultGlyphs->endPointStarts[glyphId + 1] - defaultGlyphs->endPointStarts[glyphId];
+}
+
+void VariationDefaultGlyphs_free(VariationDefaultGlyphs *defaultGlyphs)
+{
+	free(defaultGlyphs->points);
+	free(defaultGlyphs->endPoints);
+	free(defaultGlyphs->pointStarts);
+	free(defaultGlyphs->endPointStarts);
+	free(defaultGlyphs->advanceWidths);
+	*defaultGlyphs = (VariationDefaultGlyphs){0};
+}
+
+// ********
+// VariationTablesBuf 入力
+// ********
+
+//! @return 追加したaxisのindex
+size_t VariationTablesBuf_appendAxis(
+		VariationTablesBuf *buf,
+		const char *tag,
+		double minValue,
+		double defaultValue,
+		double maxValue,
+		uint16_t nameId)
+{
+	buf->axes = (FvarAxis *)ffrealloc(buf->axes, sizeof(FvarAxis) * (buf->axisNum + 1));
+	FvarAxis *axis = &buf->axes[buf->axisNum];
+	*axis = (FvarAxis){
+		.minValue	= minValue,
+		.defaultValue	= defaultValue,
+		.maxValue	= maxValue,
+		.nameId		= nameId,
+	};
+	memcpy(axis->tag, tag, 4);
+	axis->maps = (AvarAxisValueMap *)ffmalloc(sizeof(AvarAxisValueMap) * 3);
+	axis->maps[0] = (AvarAxisValueMap){-1.0, -1.0};
+	axis->maps[1] = (AvarAxisValueMap){ 0.0,  0.0};
+	axis->maps[2] = (AvarAxisValueMap){ 1.0,  1.0};
+	axis->mapNum = 3;
+	return buf->axisNum++;
+}
+
+/** @brief 'avar'のmapを追加する(fromの昇順に挿入。同じfromは置き換える)。
+  @param from, to user座標(fromはmin, default, max以外)
+  @return false: toがfromの順に単調増加にならない(追加しない)
+  */
+bool VariationTablesBuf_appendAxisMap(VariationTablesBuf *buf, size_t axisIndex, double from, double to)
+{
+	ASSERT(axisIndex < buf->axisNum);
+	FvarAxis *axis = &buf->axes[axisIndex];
+	const AvarAxisValueMap map = {
+		.from	= F2Dot14_toDouble(F2Dot14_fromDouble(FvarAxis_normalize(axis, from))),
+		.to	= F2Dot14_toDouble(F2Dot14_fromDouble(FvarAxis_normalize(axis, to))),
+	};
+	ASSERT(-1.0 < map.from && map.from < 1.0 && 0.0 != map.from);
+	size_t i = 0;
+	while(i < axis->mapNum && axis->maps[i].from < map.from){
+		i++;
+	}
+	const bool isReplace = (axis->maps[i].from == map.from);
+	if(map.to < axis->maps[i - 1].to || axis->maps[(isReplace)? (i + 1) : i].to < map.to){
+		return false;
+	}
+	if(! isReplace){
+		axis->maps = (AvarAxisValueMap *)ffrealloc(axis->maps, sizeof(AvarAxisValueMap) * (axis->mapNum + 1));
+		memmove(&axis->maps[i + 1], &axis->maps[i], sizeof(AvarAxisValueMap) * (axis->mapNum - i));
+		axis->mapNum++;
+	}
+	axis->maps[i] = map;
+	axis->isMapped = true;
+	return true;
+}
+
+void VariationTablesBuf_appendInstance(VariationTablesBuf *buf, uint16_t subfamilyNameId, const double *coordinates)
+{
+	// 確保を済ませてから数を増やす(途中の確保失敗でも解放できる状態を保つ)
+	double *instanceCoordinates = (double *)ffmalloc(sizeof(double) * buf->axisNum);
+	memcpy(instanceCoordinates, coordinates, sizeof(double) * buf->axisNum);
+	buf->instances = (FvarInstance *)ffrealloc(buf->instances, sizeof(FvarInstance) * (buf->instanceNum + 1));
+	buf->instances[buf->instanceNum++] = (FvarInstance){
+		.subfamilyNameId	= subfamilyNameId,
+		.coordinates		= instanceCoordinates,
+	};
+}
+
+//! @brief user座標 -> 'gvar'で使うnormalized F2Dot14('avar'適用後)
+void VariationTablesBuf_normalizeLocation(const VariationTablesBuf *buf, const double *coordinates, int16_t *location)
+{
+	for(size_t a = 0; a < buf->axisNum; a++){
+		const FvarAxis *axis = &buf->axes[a];
+		const double normalized = F2Dot14_toDouble(F2Dot14_fromDouble(FvarAxis_normalize(axis, coordinates[a])));
+		location[a] = F2Dot14_fromDouble(FvarAxis_applyAvar(axis, normalized));
+	}
+}
+
+//! @param location normalized F2Dot14[axisNum]
+void VariationTablesBuf_appendMaster(
+		VariationTablesBuf *buf,
+		uint16_t glyphId,
+		const int16_t *location,
+		const GlyphPoint *points,
+		size_t pointNum,
+		uint16_t advanceWidth)
+{
+	ASSERT(pointNum == VariationDefaultGlyphs_pointNum(&buf->defaultGlyphs, glyphId));
+	// 確保を済ませてから数を増やす(途中の確保失敗でも解放できる状態を保つ)
+	int16_t *masterLocation = (int16_t *)ffmalloc(sizeof(int16_t) * buf->axisNum);
+	memcpy(masterLocation, location, sizeof(int16_t) * buf->axisNum);
+	GlyphPoint *masterPoints = (GlyphPoint *)ffmalloc(sizeof(GlyphPoint) * (pointNum + 1));
+	memcpy(masterPoints, points, sizeof(GlyphPoint) * pointNum);
+	buf->masters = (GvarMaster *)ffrealloc(buf->masters, sizeof(GvarMaster) * (buf->masterNum + 1));
+	buf->masters[buf->masterNum++] = (GvarMaster){
+		.glyphId	= glyphId,
+		.location	= masterLocation,
+		.points		= masterPoints,
+		.advanceWidth	= advanceWidth,
+	};
+}
+
+// ********
+// 'fvar', 'avar'
+// ********
+
+void VariationTablesBuf_generateFvar_inline_(VariationTablesBuf *buf)
+{
+	FFByteWriter writer = {0};
+	const size_t axisSize = 20;
+	const size_t instanceSize = 4 + (4 * buf->axisNum);
+	FFByteWriter_uint16(&writer, 1);			// majorVersion
+	FFByteWriter_uint16(&writer, 0);			// minorVersion
+	FFByteWriter_uint16(&writer, 16);			// axesArrayOffset
+	FFByteWriter_uint16(&writer, 2);			// reserved
+	FFByteWriter_uint16(&writer, buf->axisNum);		// axisCount
+	FFByteWriter_uint16(&writer, axisSize);		// axisSize
+	FFByteWriter_uint16(&writer, buf->instanceNum);	// instanceCount
+	FFByteWriter_uint16(&writer, instanceSize);		// instanceSize
+	for(size_t a = 0; a < buf->axisNum; a++){
+		const FvarAxis *axis = &buf->axes[a];
+		FFByteWriter_bytes(&writer, (const uint8_t *)axis->tag, 4);	// axisTag
+		FFByteWriter_uint32(&writer, FixedType_fromDouble(axis->minValue));
+		FFByteWriter_uint32(&writer, FixedType_fromDouble(axis->defaultValue));
+		FFByteWriter_uint32(&writer, FixedType_fromDouble(axis->maxValue));
+		FFByteWriter_uint16(&writer, 0);				// flags
+		FFByteWriter_uint16(&writer, axis->nameId);			// axisNameID
+	}
+	for(size_t i = 0; i < buf->instanceNum; i++){
+		const FvarInstance *instance = &buf->instances[i];
+		FFByteWriter_uint16(&writer, instance->subfamilyNameId);	// subfamilyNameID
+		FFByteWriter_uint16(&writer, 0);				// flags
+		for(size_t a = 0; a < buf->axisNum; a++){
+			FFByteWriter_uint32(&writer, FixedType_fromDouble(instance->coordinates[a]));
+		}
+	}
+	buf->fvarByteArray = FFByteWriter_toByteArray(&writer);
+}
+
+void VariationTablesBuf_generateAvar_inline_(VariationTablesBuf *buf)
+{
+	FFByteWriter writer = {0};
+	FFByteWriter_uint16(&writer, 1);			// majorVersion
+	FFByteWriter_uint16(&writer, 0);			// minorVersion
+	FFByteWriter_uint16(&writer, 0);			// reserved
+	FFByteWriter_uint16(&writer, buf->axisNum);		// axisCount
+	for(size_t a = 0; a < buf->axisNum; a++){
+		const FvarAxis *axis = &buf->axes[a];
+		FFByteWriter_uint16(&writer, axis->mapNum);		// positionMapCount
+		for(size_t i = 0; i < axis->mapNum; i++){
+			FFByteWriter_uint16(&writer, (uint16_t)F2Dot14_fromDouble(axis->maps[i].from));	// fromCoordinate
+			FFByteWriter_uint16(&writer, (uint16_t)F2Dot14_fromDouble(axis->maps[i].to));	// toCoordinate
+		}
+	}
+	buf->avarByteArray = FFByteWriter_toByteArray(&writer);
+}
+
+// ********
+// 'gvar': variation model
+// ********
+
+//! 1 tuple variationのregion
+typedef struct{
+	double			start;
+	double			peak;
+	double			end;
+}GvarAxisRegion;
+
+//! @brief regionの位置locationでの係数(OpenType仕様 "Algorithm for interpolation of instance values")
+double GvarRegion_scalar(const GvarAxisRegion *regions, size_t axisNum, const double *location)
+{
+	double scalar = 1.0;
+	for(size_t a = 0; a < axisNum; a++){
+		const GvarAxisRegion *r = &regions[a];
+		const double v = location[a];
+		if(0.0 == r->peak){
+			continue;
+		}
+		if(v == r->peak){
+			continue;
+		}
+		if(v <= r->start || r->end <= v){
+			return 0.0;
+		}
+		if(v < r->peak){
+			scalar *= (v - r->start) / (r->peak - r->start);
+		}else{
+			scalar *= (r->end - v) / (r->end - r->peak);
+		}
+	}
+	return scalar;
+}
+
+//! @brief masterの並び順(非0の軸が少ない順 -> 軸順 -> 負が先 -> 0に近い順)
+int GvarMaster_compareLocation_inline_(const int16_t *a, const int16_t *b, size_t axisNum)
+{
+	size_t nonZeroA = 0;
+	size_t nonZeroB = 0;
+	for(size_t i = 0; i < axisNum; i++){
+		nonZeroA += (0 != a[i]);
+		nonZeroB += (0 != b[i]);
+	}
+	if(nonZeroA != nonZeroB){
+		return (nonZeroA < nonZeroB)? -1 : 1;
+	}
+	for(size_t i = 0; i < axisNum; i++){
+		if((0 != a[i]) != (0 != b[i])){
+			return (0 != a[i])? -1 : 1;
+		}
+	}
+	for(size_t i = 0; i < axisNum; i++){
+		if((a[i] < 0) != (b[i] < 0)){
+			return (a[i] < 0)? -1 : 1;
+		}
+	}
+	for(size_t i = 0; i < axisNum; i++){
+		const int absA = abs(a[i]);
+		const int absB = abs(b[i]);
+		if(absA != absB){
+			return (absA < absB)? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+/** @brief 並べたmasterのregionを決める(fontTools VariationModel._computeMasterSupportsと同じ規則)。
+  @param locations [masterNum][axisNum]
+  @param regions [masterNum][axisNum]
+  */
+void GvarModel_computeRegions_inline_(
+		const double *locations,
+		size_t masterNum,
+		size_t axisNum,
+		GvarAxisRegion *regions)
+{
+	double axisMins[VariationTables_AXIS_MAX] = {0};
+	double axisMaxs[VariationTables_AXIS_MAX] = {0};
+	for(size_t m = 0; m < masterNum; m++){
+		for(size_t a = 0; a < axisNum; a++){
+			const double v = locations[(m * axisNum) + a];
+			axisMins[a] = (v < axisMins[a])? v : axisMins[a];
+			axisMaxs[a] = (axisMaxs[a] < v)? v : axisMaxs[a];
+		}
+	}
+
+	for(size_t i = 0; i < masterNum; i++){
+		const double *loc = &locations[i * axisNum];
+		GvarAxisRegion *box = &regions[i * axisNum];
+		for(size_t a = 0; a < axisNum; a++){
+			if(0.0 < loc[a]){
+				box[a] = (GvarAxisRegion){0.0, loc[a], axisMaxs[a]};
+			}else if(loc[a] < 0.0){
+				box[a] = (GvarAxisRegion){axisMins[a], loc[a], 0.0};
+			}else{
+				box[a] = (GvarAxisRegion){0.0, 0.0, 0.0};
+			}
+		}
+		for(size_t j = 0; j < i; j++){
+			const double *m = &locations[j * axisNum];
+			// 軸の多いmasterは関与しない
+			bool isRelevant = true;
+			for(size_t a = 0; a < axisNum && isRelevant; a++){
+				if(0.0 != m[a] && 0.0 == loc[a]){
+					isRelevant = false;
+				}
+			}
+			// boxの外のmasterは関与しない
+			for(size_t a = 0; a < axisNum && isRelevant; a++){
+				if(0.0 == loc[a]){
+					continue;
+				}
+				if(! (m[a] == box[a].peak || (box[a].start < m[a] && m[a] < box[a].end))){
+					isRelevant = false;
+				}
+			}
+			if(! isRelevant){
+				continue;
+			}
+			// 比率の最も大きい方向でboxを切る
+			double bestRatio = -1.0;
+			GvarAxisRegion bestBoxes[VariationTables_AXIS_MAX];
+			bool isBestAxes[VariationTables_AXIS_MAX] = {0};
+			for(size_t a = 0; a < axisNum; a++){
+				if(0.0 == m[a]){
+					continue;
+				}
+				const GvarAxisRegion r = box[a];
+				GvarAxisRegion newRegion = r;
+				double ratio;
+				if(m[a] < r.peak){
+					newRegion.start = m[a];
+					ratio = (m[a] - r.peak) / (r.start - r.peak);
+				}else if(r.peak < m[a]){
+					newRegion.end = m[a];
+					ratio = (m[a] - r.peak) / (r.end - r.peak);
+				}else{
+					continue;
+				}
+				if(bestRatio < ratio){
+					bestRatio = ratio;
+					memset(isBestAxes, 0, sizeof(isBestAxes));
+				}
+				if(ratio == bestRatio){
+					isBestAxes[a] = true;
+					bestBoxes[a] = newRegion;
+				}
+			}
+			for(size_t a = 0; a < axisNum; a++){
+				if(isBestAxes[a]){
+					box[a] = bestBoxes[a];
+				}
+			}
+		}
+	}
+}
+
+// ********
+// 'gvar': IUP
+// ********
+
+/** @brief 参照点ref1, ref2の間にある点の差分を補間する(1軸)
+  @return 参照点の座標が同じで差分が異なる場合は実装により結果が異なるので、再現できない値(HUGE_VAL)を返す
+  */
+double GvarIup_interpolate_inline_(int coord, int ref1Coord, double ref1Delta, int ref2Coord, double ref2Delta)
+{
+	if(ref1Coord == ref2Coord){
+		return (ref1Delta == ref2Delta)? ref1Delta : HUGE_VAL;
+	}
+	const int lowCoord = (ref1Coord < ref2Coord)? ref1Coord : ref2Coord;
+	const int highCoord = (ref1Coord < ref2Coord)? ref2Coord : ref1Coord;
+	const double lowDelta = (ref1Coord < ref2Coord)? ref1Delta : ref2Delta;
+	const double highDelta = (ref1Coord < ref2Coord)? ref2Delta : ref1Delta;
+	if(coord <= lowCoord){
+		return lowDelta;
+	}
+	if(highCoord <= coord){
+		return highDelta;
+	}
+	return lowDelta + ((highDelta - lowDelta) * (double)(coord - lowCoord) / (double)(highCoord - lowCoord));
+}
+
+/** @brief contour内で参照点(isTouched)以外の差分をIUPで求めて、実際の差分と一致するか調べる。
+  @param isTouched 参照する点
+  @return true: 全点が許容誤差(0.5)以内で再現できる
+  */
+bool GvarIup_isReproducible_inline_(
+		const GlyphPoint *points,
+		const int *deltaX,
+		const int *deltaY,
+		const bool *isTouched,
+		size_t start,
+		size_t end)
+{
+	size_t touchedNum = 0;
+	size_t firstTouched = SIZE_MAX;
+	for(size_t i = start; i <= end; i++){
+		if(isTouched[i]){
+			touchedNum++;
+			if(SIZE_MAX == firstTouched){
+				firstTouched = i;
+			}
+		}
+	}
+	const double tolerance = 0.5;
+	if(0 == touchedNum){
+		// 参照点の無いcontourは差分0
+		for(size_t i = start; i <= end; i++){
+			if(tolerance < fabs((double)deltaX[i]) || tolerance < fabs((double)deltaY[i])){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const size_t pointNum = end - start + 1;
+	size_t prev = firstTouched;
+	for(size_t n = 1; n <= pointNum; n++){
+		const size_t i = start + (((firstTouched - start) + n) % pointNum);
+		if(! isTouched[i]){
+			continue;
+		}
+		// prevとiの間の参照されていない点
+		for(size_t k = 1; ; k++){
+			const size_t u = start + (((prev - start) + k) % pointNum);
+			if(u == i){
+				break;
+			}
+			const double x = GvarIup_interpolate_inline_(
+					points[u].x, points[prev].x, deltaX[prev], points[i].x, deltaX[i]);
+			const double y = GvarIup_interpolate_inline_(
+					points[u].y, points[prev].y, deltaY[prev], points[i].y, deltaY[i]);
+			if(! (fabs(x - deltaX[u]) <= tolerance && fabs(y - deltaY[u]) <= tolerance)){
+				return false;
+			}
+		}
+		prev = i;
+	}
+	return true;
+}
+
+/** @brief IUPで再現できる点を省き、出力する点を決める。
+  @param isTouched [pointNum + phantom] 結果
+  @return 出力する点数
+  */
+size_t GvarIup_optimize_inline_(
+		const GlyphPoint *points,
+		size_t pointNum,
+		const uint16_t *endPoints,
+		size_t contourNum,
+		const int *deltaX,
+		const int *deltaY,
+		bool *isTouched)
+{
+	size_t touchedNum = 0;
+	size_t start = 0;
+	for(size_t c = 0; c < contourNum; c++){
+		const size_t end = endPoints[c];
+		// 差分0のcontourは丸ごと省略できる
+		for(size_t i = start; i <= end; i++){
+			isTouched[i] = false;
+		}
+		if(! GvarIup_isReproducible_inline_(points, deltaX, deltaY, isTouched, start, end)){
+			for(size_t i = start; i <= end; i++){
+				isTouched[i] = true;
+			}
+			// 貪欲に1点ずつ外して、再現できる限り外したままにする
+			for(size_t i = start; i <= end; i++){
+				isTouched[i] = false;
+				if(! GvarIup_isReproducible_inline_(points, deltaX, deltaY, isTouched, start, end)){
+					isTouched[i] = true;
+				}
+			}
+		}
+		for(size_t i = start; i <= end; i++){
+			touchedNum += isTouched[i];
+		}
+		start = end + 1;
+	}
+	// phantom pointはIUPの対象外
+	for(size_t i = pointNum; i < pointNum + VariationTables_PHANTOM_POINT_NUM; i++){
+		isTouched[i] = (0 != deltaX[i] || 0 != deltaY[i]);
+		touchedNum += isTouched[i];
+	}
+	return touchedNum;
+}
+
+// ********
+// 'gvar': packed形式
+// ********
+
+//! @brief packed point numbers(isTouched == NULL: 全点)
+void GvarPacked_writePointNumbers_inline_(FFByteWriter *writer, const bool *isTouched, size_t allPointNum)
+{
+	if(NULL == isTouched){
+		FFByteWriter_uint8(writer, 0); // 全点
+		return;
+	}
+	uint16_t *pointNumbers = (uint16_t *)ffmalloc(sizeof(uint16_t) * (allPointNum + 1));
+	size_t count = 0;
+	for(size_t i = 0; i < allPointNum; i++){
+		if(isTouched[i]){
+			pointNumbers[count++] = (uint16_t)i;
+		}
+	}
+	if(count < 0x80){
+		FFByteWriter_uint8(writer, (uint8_t)count);
+	}else{
+		FFByteWriter_uint16(writer, (uint16_t)(0x8000 | count));
+	}
+	uint16_t prev = 0;
+	for(size_t i = 0; i < count; ){
+		const bool isWords = (0xFF < (uint16_t)(pointNumbers[i] - prev));
+		size_t runEnd = i;
+		uint16_t runPrev = prev;
+		while(runEnd < count && runEnd - i < 128){
+			const uint16_t diff = pointNumbers[runEnd] - runPrev;
+			if((0xFF < diff) != isWords){
+				break;
+			}
+			runPrev = pointNumbers[runEnd];
+			runEnd++;
+		}
+		FFByteWriter_uint8(writer, (uint8_t)(((isWords)? GvarPackedPointNumbers_ARE_WORDS : 0) | (runEnd - i - 1)));
+		for(size_t k = i; k < runEnd; k++){
+			const uint16_t diff = pointNumbers[k] - prev;
+			if(isWords){
+				FFByteWriter_uint16(writer, diff);
+			}else{
+				FFByteWriter_uint8(writer, (uint8_t)diff);
+			}
+			prev = pointNumbers[k];
+		}
+		i = runEnd;
+	}
+	free(pointNumbers);
+}
+
+bool GvarPacked_isByte_inline_(int value)
+{
+	return (-128 <= value && value <= 127);
+}
+
+//! @brief packed deltas
+void GvarPacked_writeDeltas_inline_(FFByteWriter *writer, const int *deltas, size_t num)
+{
+	for(size_t i = 0; i < num; ){
+		size_t end = i;
+		if(0 == deltas[i]){
+			while(end < num && end - i < 64 && 0 == deltas[end]){
+				end++;
+			}
+			FFByteWriter_uint8(writer, (uint8_t)(GvarPackedDeltas_ARE_ZERO | (end - i - 1)));
+		}else if(GvarPacked_isByte_inline_(deltas[i])){
+			// byteのrun: 0が2つ続く所・wordの所で切る
+			while(end < num && end - i < 64 && GvarPacked_isByte_inline_(deltas[end])){
+				if(0 == deltas[end] && end + 1 < num && 0 == deltas[end + 1]){
+					break;
+				}
+				end++;
+			}
+			FFByteWriter_uint8(writer, (uint8_t)(end - i - 1));
+			for(size_t k = i; k < end; k++){
+				FFByteWriter_uint8(writer, (uint8_t)(int8_t)deltas[k]);
+			}
+		}else{
+			// wordのrun: 0の所・byteが2つ続く所で切る
+			while(end < num && end - i < 64 && 0 != deltas[end]){
+				if(GvarPacked_isByte_inline_(deltas[end])
+						&& end + 1 < num && GvarPacked_isByte_inline_(deltas[end + 1])){
+					break;
+				}
+				end++;
+			}
+			FFByteWriter_uint8(writer, (uint8_t)(GvarPackedDeltas_ARE_WORDS | (end - i - 1)));
+			for(size_t k = i; k < end; k++){
+				FFByteWriter_uint16(writer, (uint16_t)(int16_t)deltas[k]);
+			}
+		}
+		i = end;
+	}
+}
+
+// ********
+// 'gvar': 生成
+// ********
+
+//! glyph内の1 tuple variation(出力前)
+typedef struct{
+	int16_t			*peak;		//!< [axisNum]
+	int16_t			*start;
+	int16_t			*end;
+	bool			isIntermediate;
+	int			*deltaX;	//!< [allPointNum]
+	int			*deltaY;
+	bool			*isTouched;	//!< NULL: 全点
+	size_t			touchedNum;
+}GvarTuple;
+
+typedef struct{
+	int16_t			*peak;		//!< [axisNum] (VariationTablesBuf.mastersのlocationを指す)
+	size_t			useNum;
+}GvarSharedTuple;
+
+//! @return shared tuplesのindex。-1: 無し
+int GvarSharedTuples_find_inline_(const GvarSharedTuple *sharedTuples, size_t num, const int16_t *peak, size_t axisNum)
+{
+	for(size_t i = 0; i < num; i++){
+		if(0 == memcmp(sharedTuples[i].peak, peak, sizeof(int16_t) * axisNum)){
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+int GvarSharedTuple_compareUseNum_inline_(const void *a_, const void *b_)
+{
+	const GvarSharedTuple *a = (const GvarSharedTuple *)a_;
+	const GvarSharedTuple *b = (const GvarSharedTuple *)b_;
+	if(a->useNum != b->useNum){
+		return (a->useNum > b->useNum)? -1 : 1;
+	}
+	return 0;
+}
+
+bool GvarTuple_isSamePoints_inline_(const GvarTuple *a, const GvarTuple *b, size_t allPointNum)
+{
+	if(NULL == a->isTouched || NULL == b->isTouched){
+		return (a->isTouched == b->isTouched);
+	}
+	return (0 == memcmp(a->isTouched, b->isTouched, sizeof(bool) * allPointNum));
+}
+
+/** @brief glyphのmasterからtuple variationを求める。
+  @param masterIndexes このglyphのmaster(VariationTablesBuf.masters内のindex)
+  @return tuple数(差分が全て0のtupleは除く)
+  */
+size_t VariationTablesBuf_computeTuples_inline_(
+		const VariationTablesBuf *buf,
+		uint16_t glyphId,
+		const size_t *masterIndexes,
+		size_t masterNum,
+		GvarTuple *tuples)
+{
+	const VariationDefaultGlyphs *defaultGlyphs = &buf->defaultGlyphs;
+	const size_t axisNum = buf->axisNum;
+	const size_t pointNum = VariationDefaultGlyphs_pointNum(defaultGlyphs, glyphId);
+	const size_t allPointNum = pointNum + VariationTables_PHANTOM_POINT_NUM;
+	const GlyphPoint *defaultPoints = &defaultGlyphs->points[defaultGlyphs->pointStarts[glyphId]];
+	const uint16_t *endPoints = &defaultGlyphs->endPoints[defaultGlyphs->endPointStarts[glyphId]];
+	const size_t contourNum = VariationDefaultGlyphs_contourNum(defaultGlyphs, glyphId);
+
+	// ** masterを並べてregionを決める
+	size_t *order = (size_t *)ffmalloc(sizeof(size_t) * masterNum);
+	for(size_t i = 0; i < masterNum; i++){
+		size_t j = i;
+		while(0 < j && 0 < GvarMaster_compareLocation_inline_(
+					buf->masters[order[j - 1]].location, buf->masters[masterIndexes[i]].location, axisNum)){
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = masterIndexes[i];
+	}
+	double *locations = (double *)ffmalloc(sizeof(double) * masterNum * axisNum);
+	for(size_t m = 0; m < masterNum; m++){
+		for(size_t a = 0; a < axisNum; a++){
+			locations[(m * axisNum) + a] = F2Dot14_toDouble(buf->masters[order[m]].location[a]);
+		}
+	}
+	GvarAxisRegion *regions = (GvarAxisRegion *)ffmalloc(sizeof(GvarAxisRegion) * masterNum * axisNum);
+	GvarModel_computeRegions_inline_(locations, masterNum, axisNum, regions);
+
+	// ** 差分: master - default - (先のtupleの寄与)
+	int **deltaXs = (int **)ffmalloc(sizeof(int *) * masterNum);
+	int **deltaYs = (int **)ffmalloc(sizeof(int *) * masterNum);
+	double *scalars = (double *)ffmalloc(sizeof(double) * masterNum);
+	const uint16_t defaultAdvance = defaultGlyphs->advanceWidths[glyphId];
+	for(size_t m = 0; m < masterNum; m++){
+		const GvarMaster *master = &buf->masters[order[m]];
+		deltaXs[m] = (int *)ffmalloc(sizeof(int) * allPointNum);
+		deltaYs[m] = (int *)ffmalloc(sizeof(int) * allPointNum);
+		for(size_t j = 0; j < m; j++){
+			scalars[j] = GvarRegion_scalar(&regions[j * axisNum], axisNum, &locations[m * axisNum]);
+		}
+		for(size_t p = 0; p < allPointNum; p++){
+			double x = 0.0;
+			double y = 0.0;
+			if(p < pointNum){
+				x = master->points[p].x - defaultPoints[p].x;
+				y = master->points[p].y - defaultPoints[p].y;
+			}else if(pointNum + 1 == p){
+				x = (double)master->advanceWidth - (double)defaultAdvance; // 送り幅(右側のphantom point)
+			}
+			for(size_t j = 0; j < m; j++){
+				x -= scalars[j] * deltaXs[j][p];
+				y -= scalars[j] * deltaYs[j][p];
+			}
+			deltaXs[m][p] = (int)lround(x);
+			deltaYs[m][p] = (int)lround(y);
+		}
+	}
+
+	// ** tuple
+	size_t tupleNum = 0;
+	for(size_t m = 0; m < masterNum; m++){
+		bool isZero = true;
+		for(size_t p = 0; p < allPointNum && isZero; p++){
+			isZero = (0 == deltaXs[m][p] && 0 == deltaYs[m][p]);
+		}
+		if(isZero){
+			free(deltaXs[m]);
+			free(deltaYs[m]);
+			continue;
+		}
+		GvarTuple *tuple = &tuples[tupleNum++];
+		*tuple = (GvarTuple){
+			.peak		= buf->masters[order[m]].location,
+			.start		= (int16_t *)ffmalloc(sizeof(int16_t) * axisNum),
+			.end		= (int16_t *)ffmalloc(sizeof(int16_t) * axisNum),
+			.deltaX		= deltaXs[m],
+			.deltaY		= deltaYs[m],
+		};
+		for(size_t a = 0; a < axisNum; a++){
+			const GvarAxisRegion *r = &regions[(m * axisNum) + a];
+			tuple->start[a] = F2Dot14_fromDouble(r->start);
+			tuple->end[a] = F2Dot14_fromDouble(r->end);
+			// 省略時のregionは(min(peak, 0), peak, max(peak, 0))
+			const int16_t peak = tuple->peak[a];
+			if(tuple->start[a] != ((peak < 0)? peak : 0) || tuple->end[a] != ((0 < peak)? peak : 0)){
+				tuple->isIntermediate = true;
+			}
+		}
+		tuple->isTouched = (bool *)ffmalloc(sizeof(bool) * allPointNum);
+		tuple->touchedNum = GvarIup_optimize_inline_(
+				defaultPoints, pointNum, endPoints, contourNum,
+				tuple->deltaX, tuple->deltaY, tuple->isTouched);
+		if(allPointNum == tuple->touchedNum){
+			free(tuple->isTouched);
+			tuple->isTouched = NULL;
+		}
+	}
+
+	free(scalars);
+	free(deltaYs);
+	free(deltaXs);
+	free(regions);
+	free(locations);
+	free(order);
+	return tupleNum;
+}
+
+void GvarTuple_free_inline_(GvarTuple *tuple)
+{
+	free(tuple->start);
+	free(tuple->end);
+	free(tuple->deltaX);
+	free(tuple->deltaY);
+	free(tuple->isTouched);
+	*tuple = (GvarTuple){0};
+}
+
+/** @brief 1 glyphのGlyphVariationDataを書き出す。
+  @return false: variationDataSize(Uint16)を超える
+  */
+bool VariationTablesBuf_writeGlyphVariationData_inline_(
+		FFByteWriter *writer,
+		GvarTuple *tuples,
+		size_t tupleNum,
+		size_t allPointNum,
+		size_t axisNum,
+		const GvarSharedTuple *sharedTuples,
+		size_t sharedTupleNum,
+		GvarReport *report)
+{
+	// ** 最も多く使うpoint numbersの組をglyph内で共有する
+	size_t sharedPointsTuple = SIZE_MAX;
+	size_t bestUseNum = 1;
+	for(size_t t = 0; t < tupleNum; t++){
+		size_t useNum = 0;
+		for(size_t u = 0; u < tupleNum; u++){
+			useNum += GvarTuple_isSamePoints_inline_(&tuples[t], &tuples[u], allPointNum);
+		}
+		if(bestUseNum < useNum){
+			bestUseNum = useNum;
+			sharedPointsTuple = t;
+		}
+	}
+
+	// ** serialized data
+	FFByteWriter data = {0};
+	if(SIZE_MAX != sharedPointsTuple){
+		GvarPacked_writePointNumbers_inline_(&data, tuples[sharedPointsTuple].isTouched, allPointNum);
+	}
+	size_t *dataSizes = (size_t *)ffmalloc(sizeof(size_t) * tupleNum);
+	bool *isPrivatePoints = (bool *)ffmalloc(sizeof(bool) * tupleNum);
+	int *packedDeltas = (int *)ffmalloc(sizeof(int) * allPointNum);
+	for(size_t t = 0; t < tupleNum; t++){
+		const GvarTuple *tuple = &tuples[t];
+		const size_t begin = data.length;
+		isPrivatePoints[t] = (SIZE_MAX == sharedPointsTuple
+				|| (! GvarTuple_isSamePoints_inline_(tuple, &tuples[sharedPointsTuple], allPointNum)));
+		if(isPrivatePoints[t]){
+			GvarPacked_writePointNumbers_inline_(&data, tuple->isTouched, allPointNum);
+		}
+		for(int axis = 0; axis < 2; axis++){
+			const int *deltas = (0 == axis)? tuple->deltaX : tuple->deltaY;
+			size_t num = 0;
+			for(size_t p = 0; p < allPointNum; p++){
+				if(NULL == tuple->isTouched || tuple->isTouched[p]){
+					packedDeltas[num++] = deltas[p];
+				}
+			}
+			GvarPacked_writeDeltas_inline_(&data, packedDeltas, num);
+		}
+		dataSizes[t] = data.length - begin;
+		report->pointNum += (NULL == tuple->isTouched)? allPointNum : tuple->touchedNum;
+		report->omittedPointNum += allPointNum - ((NULL == tuple->isTouched)? allPointNum : tuple->touchedNum);
+		// 全点の差分をword(2byte)で出した場合
+		report->gvarUnpackedSize += 4 + (axisNum * 2) + ((tuple->isIntermediate)? (axisNum * 4) : 0) + 1
+			+ (allPointNum * 4) + (2 * ((allPointNum + 63) / 64));
+	}
+	free(packedDeltas);
+
+	bool isSuccess = true;
+	// ** header
+	size_t headerSize = 4;
+	for(size_t t = 0; t < tupleNum; t++){
+		const bool isShared = (0 <= GvarSharedTuples_find_inline_(sharedTuples, sharedTupleNum, tuples[t].peak, axisNum));
+		headerSize += 4 + ((isShared)? 0 : (axisNum * 2)) + ((tuples[t].isIntermediate)? (axisNum * 4) : 0);
+		if(UINT16_MAX < dataSizes[t]){
+			isSuccess = false;
+		}
+	}
+	if(isSuccess && UINT16_MAX < headerSize){
+		isSuccess = false;
+	}
+	if(isSuccess){
+		FFByteWriter_uint16(writer, (uint16_t)(tupleNum
+					| ((SIZE_MAX != sharedPointsTuple)? GvarTupleVariationCount_SHARED_POINT_NUMBERS : 0)));
+		FFByteWriter_uint16(writer, (uint16_t)headerSize);	// dataOffset
+		for(size_t t = 0; t < tupleNum; t++){
+			const GvarTuple *tuple = &tuples[t];
+			const int sharedIndex = GvarSharedTuples_find_inline_(sharedTuples, sharedTupleNum, tuple->peak, axisNum);
+			uint16_t tupleIndex = (0 <= sharedIndex)? (uint16_t)sharedIndex : GvarTupleIndex_EMBEDDED_PEAK_TUPLE;
+			tupleIndex |= (tuple->isIntermediate)? GvarTupleIndex_INTERMEDIATE_REGION : 0;
+			tupleIndex |= (isPrivatePoints[t])? GvarTupleIndex_PRIVATE_POINT_NUMBERS : 0;
+			FFByteWriter_uint16(writer, (uint16_t)dataSizes[t]);	// variationDataSize
+			FFByteWriter_uint16(writer, tupleIndex);
+			if(sharedIndex < 0){
+				for(size_t a = 0; a < axisNum; a++){
+					FFByteWriter_uint16(writer, (uint16_t)tuple->peak[a]);
+				}
+			}
+			if(tuple->isIntermediate){
+				for(size_t a = 0; a < axisNum; a++){
+					FFByteWriter_uint16(writer, (uint16_t)tuple->start[a]);
+				}
+				for(size_t a = 0; a < axisNum; a++){
+					FFByteWriter_uint16(writer, (uint16_t)tuple->end[a]);
+				}
+			}
+		}
+		FFByteWriter_bytes(writer, data.data, data.length);
+	}
+
+	free(isPrivatePoints);
+	free(dataSizes);
+	free(data.data);
+	return isSuccess;
+}
+
+/** @brief 'gvar' Tableを生成する。
+  @return false: glyphのvariation dataが大きすぎる
+  */
+bool VariationTablesBuf_generateGvar_inline_(VariationTablesBuf *buf, size_t numGlyphs)
+{
+	const size_t axisNum = buf->axisNum;
+	GvarReport report = {0};
+
+	// ** glyph毎のmaster
+	size_t *masterStarts = (size_t *)ffmalloc(sizeof(size_t) * (numGlyphs + 1));
+	size_t *masterIndexes = (size_t *)ffmalloc(sizeof(size_t) * (buf->masterNum + 1));
+	for(size_t m = 0; m < buf->masterNum; m++){
+		masterStarts[buf->masters[m].glyphId + 1]++;
+	}
+	for(size_t g = 0; g < numGlyphs; g++){
+		masterStarts[g + 1] += masterStarts[g];
+	}
+	{
+		size_t *filled = (size_t *)ffmalloc(sizeof(size_t) * (numGlyphs + 1));
+		for(size_t m = 0; m < buf->masterNum; m++){
+			const uint16_t g = buf->masters[m].glyphId;
+			masterIndexes[masterStarts[g] + filled[g]++] = m;
+		}
+		free(filled);
+	}
+
+	// ** tuple
+	GvarTuple **glyphTuples = (GvarTuple **)ffmalloc(sizeof(GvarTuple *) * (numGlyphs + 1));
+	size_t *glyphTupleNums = (size_t *)ffmalloc(sizeof(size_t) * (numGlyphs + 1));
+	GvarSharedTuple *sharedTuples = NULL;
+	size_t sharedTupleNum = 0;
+	for(size_t g = 0; g < numGlyphs; g++){
+		const size_t masterNum = masterStarts[g + 1] - masterStarts[g];
+		if(0 == masterNum){
+			continue;
+		}
+		glyphTuples[g] = (GvarTuple *)ffmalloc(sizeof(GvarTuple) * masterNum);
+		glyphTupleNums[g] = VariationTablesBuf_computeTuples_inline_(
+				buf, (uint16_t)g, &masterIndexes[masterStarts[g]], masterNum, glyphTuples[g]);
+		for(size_t t = 0; t < glyphTupleNums[g]; t++){
+			int16_t *peak = glyphTuples[g][t].peak;
+			const int index = GvarSharedTuples_find_inline_(sharedTuples, sharedTupleNum, peak, axisNum);
+			if(0 <= index){
+				sharedTuples[index].useNum++;
+			}else{
+				sharedTuples = (GvarSharedTuple *)ffrealloc(sharedTuples, sizeof(GvarSharedTuple) * (sharedTupleNum + 1));
+				sharedTuples[sharedTupleNum++] = (GvarSharedTuple){peak, 1};
+			}
+		}
+	}
+	free(masterIndexes);
+	free(masterStarts);
+
+	// ** shared tuples: 2つ以上のglyphで使うpeak
+	if(0 < sharedTupleNum){
+		qsort(sharedTuples, sharedTupleNum, sizeof(GvarSharedTuple), GvarSharedTuple_compareUseNum_inline_);
+	}
+	size_t usedSharedTupleNum = 0;
+	while(usedSharedTupleNum < sharedTupleNum && usedSharedTupleNum < VariationTables_SHARED_TUPLE_MAX
+			&& 2 <= sharedTuples[usedSharedTupleNum].useNum){
+		usedSharedTupleNum++;
+	}
+
+	// ** GlyphVariationData
+	bool isSuccess = true;
+	FFByteWriter glyphData = {0};
+	size_t *glyphOffsets = (size_t *)ffmalloc(sizeof(size_t) * (numGlyphs + 1));
+	for(size_t g = 0; g < numGlyphs; g++){
+		glyphOffsets[g] = glyphData.length;
+		if(isSuccess && 0 < glyphTupleNums[g]){
+			const size_t allPointNum = VariationDefaultGlyphs_pointNum(&buf->defaultGlyphs, (uint16_t)g)
+				+ VariationTables_PHANTOM_POINT_NUM;
+			isSuccess = VariationTablesBuf_writeGlyphVariationData_inline_(
+					&glyphData, glyphTuples[g], glyphTupleNums[g], allPointNum, axisNum,
+					sharedTuples, usedSharedTupleNum, &report);
+			report.tupleNum += glyphTupleNums[g];
+			// short offsetに備えて偶数長にする
+			if(0 != glyphData.length % 2){
+				FFByteWriter_uint8(&glyphData, 0);
+			}
+		}
+		for(size_t t = 0; t < glyphTupleNums[g]; t++){
+			GvarTuple_free_inline_(&glyphTuples[g][t]);
+		}
+		free(glyphTuples[g]);
+	}
+	glyphOffsets[numGlyphs] = glyphData.length;
+	free(glyphTupleNums);
+	free(glyphTuples);
+
+	if(isSuccess){
+		const bool isLongOffsets = (UINT16_MAX < (glyphData.length / 2));
+		const size_t offsetSize = (isLongOffsets)? 4 : 2;
+		const size_t sharedTuplesOffset = 20 + (offsetSize * (numGlyphs + 1));
+		const size_t glyphDataOffset = sharedTuplesOffset + (usedSharedTupleNum * axisNum * 2);
+		FFByteWriter writer = {0};
+		FFByteWriter_uint16(&writer, 1);				// majorVersion
+		FFByteWriter_uint16(&writer, 0);				// minorVersion
+		FFByteWriter_uint16(&writer, axisNum);			// axisCount
+		FFByteWriter_uint16(&writer, usedSharedTupleNum);		// sharedTupleCount
+		FFByteWriter_uint32(&writer, sharedTuplesOffset);		// sharedTuplesOffset
+		FFByteWriter_uint16(&writer, numGlyphs);			// glyphCount
+		FFByteWriter_uint16(&writer, (isLongOffsets)? 1 : 0);	// flags
+		FFByteWriter_uint32(&writer, glyphDataOffset);		// glyphVariationDataArrayOffset
+		for(size_t g = 0; g <= numGlyphs; g++){
+			if(isLongOffsets){
+				FFByteWriter_uint32(&writer, glyphOffsets[g]);
+			}else{
+				FFByteWriter_uint16(&writer, glyphOffsets[g] / 2);
+			}
+		}
+		for(size_t i = 0; i < usedSharedTupleNum; i++){
+			for(size_t a = 0; a < axisNum; a++){
+				FFByteWriter_uint16(&writer, (uint16_t)sharedTuples[i].peak[a]);
+			}
+		}
+		FFByteWriter_bytes(&writer, glyphData.data, glyphData.length);
+
+		report.sharedTupleNum = usedSharedTupleNum;
+		report.gvarSize = writer.length;
+		report.gvarUnpackedSize += 20 + (4 * (numGlyphs + 1));
+		buf->gvarByteArray = FFByteWriter_toByteArray(&writer);
+	}
+
+	free(glyphOffsets);
+	free(glyphData.data);
+	free(sharedTuples);
+	buf->report = report;
+	return isSuccess;
+}
+
+/** @brief 'fvar', 'avar'(axis mapがある場合), 'gvar' Tableを生成する。
+  @return false: 'gvar'がフォーマットの上限を超える
+  */
+bool VariationTablesBuf_finally(VariationTablesBuf *buf, size_t numGlyphs)
+{
+	ASSERT(buf);
+	ASSERT(0 < buf->axisNum);
+	ASSERT(numGlyphs == buf->defaultGlyphs.glyphNum);
+	FFTRACE_BEGIN("fvar", "table");
+	VariationTablesBuf_generateFvar_inline_(buf);
+	FFTRACE_END("fvar", "table");
+
+	bool isAvar = false;
+	for(size_t a = 0; a < buf->axisNum; a++){
+		isAvar = isAvar || buf->axes[a].isMapped;
+	}
+	if(isAvar){
+		VariationTablesBuf_generateAvar_inline_(buf);
+	}
+
+	FFTRACE_BEGIN("gvar", "table");
+	const bool isSuccess = VariationTablesBuf_generateGvar_inline_(buf, numGlyphs);
+	FFTRACE_END("gvar", "table");
+	DEBUG_LOG("gvar tuples:%zu shared:%zu points:%zu(omitted:%zu) size:%zu(unpacked:%zu)",
+			buf->report.tupleNum, buf->report.sharedTupleNum,
+			buf->report.pointNum, buf->report.omittedPointNum,
+			buf->report.gvarSize, buf->report.gvarUnpackedSize);
+	return isSuccess;
+}
+
+void VariationTablesBuf_free(VariationTablesBuf *buf)
+{
+	for(size_t a = 0; a < buf->axisNum; a++){
+		free(buf->axes[a].maps);
+	}
+	free(buf->axes);
+	for(size_t i = 0; i < buf->instanceNum; i++){
+		free(buf->instances[i].coordinates);
+	}
+	free(buf->instances);
+	for(size_t m = 0; m < buf->masterNum; m++){
+		free(buf->masters[m].location);
+		free(buf->masters[m].points);
+	}
+	free(buf->masters);
+	VariationDefaultGlyphs_free(&buf->defaultGlyphs);
+	FFByteArray_free(&buf->fvarByteArray);
+	FFByteArray_free(&buf->avarByteArray);
+	FFByteArray_free(&buf->gvarByteArray);
+	*buf = (VariationTablesBuf){0};
+}
+
+#endif // #ifndef DAISYFF_VARIATION_TABLES_HPP_
+
@@ -0,0 +1,160 @@
+/**
+  @file
+  @brief 添字[0, taskNum)の処理を複数threadで分け合うwork-stealing pool。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  各workerは連続した添字の範囲を持ち、自分の範囲を先頭から処理する。
+  自分の範囲が尽きたworkerは、残りの最も多いworkerの範囲の後ろ半分を盗む。
+  処理時間が添字によって大きく違う(フォント毎の大きさが違う)場合も、全threadが最後まで働く。
+ */
+#ifndef DAISYFF_WORK_STEALING_POOL_HPP_
+#define DAISYFF_WORK_STEALING_POOL_HPP_
+
+#include "src/Util.h"
+#include <pthread.h>
+
+#define WorkStealingPool_THREAD_MAX (256)
+
+//! @param workerIndex [0, threadNum) 処理しているworker(worker毎の作業領域の選択に使う)
+typedef void (*WorkStealingPool_Func)(void *context, size_t index, size_t workerIndex);
+
+typedef struct{
+	pthread_mutex_t		mutex;
+	size_t			begin;		//!< 次に自分で処理する添字
+	size_t			end;		//!< 他のworkerはここから前へ盗む
+	size_t			stealNum;	//!< 盗んだ回数
+	size_t			taskNum;	//!< 処理した数
+}WorkStealingPoolWorker;
+
+typedef struct{
+	WorkStealingPoolWorker	*workers;
+	size_t			workerNum;
+	WorkStealingPool_Func	func;
+	void			*context;
+}WorkStealingPool;
+
+typedef struct{
+	WorkStealingPool	*pool;
+	size_t			workerIndex;
+}WorkStealingPoolThreadArg;
+
+//! @return true: 盗めた(自分の範囲へ入れた)
+bool WorkStealingPool_steal_inline_(WorkStealingPool *pool, size_t workerIndex)
+{
+	// 残りの最も多いworkerを選ぶ(選んだ後に減っていれば取れる分だけ取る)
+	size_t victim = workerIndex;
+	size_t victimRemain = 0;
+	for(size_t i = 1; i < pool->workerNum; i++){
+		const size_t w = (workerIndex + i) % pool->workerNum;
+		pthread_mutex_lock(&pool->workers[w].mutex);
+		const size_t remain = pool->workers[w].end - pool->workers[w].begin;
+		pthread_mutex_unlock(&pool->workers[w].mutex);
+		if(victimRemain < remain){
+			victim = w;
+			victimRemain = remain;
+		}
+	}
+	if(0 == victimRemain){
+		return false;
+	}
+
+	WorkStealingPoolWorker *from = &pool->workers[victim];
+	pthread_mutex_lock(&from->mutex);
+	const size_t remain = from->end - from->begin;
+	const size_t take = (remain + 1) / 2;
+	const size_t end = from->end;
+	from->end -= take;
+	pthread_mutex_unlock(&from->mutex);
+	if(0 == take){
+		return true; // 選ぶ間に尽きた(もう1度探す)
+	}
+
+	WorkStealingPoolWorker *self = &pool->workers[workerIndex];
+	pthread_mutex_lock(&self->mutex);
+	self->begin = end - take;
+	self->end = end;
+	self->stealNum++;
+	pthread_mutex_unlock(&self->mutex);
+	return true;
+}
+
+void *WorkStealingPool_workerMain_inline_(void *arg_)
+{
+	WorkStealingPoolThreadArg *arg = (WorkStealingPoolThreadArg *)arg_;
+	WorkStealingPool *pool = arg->pool;
+	WorkStealingPoolWorker *self = &pool->workers[arg->workerIndex];
+	while(true){
+		pthread_mutex_lock(&self->mutex);
+		const bool isExist = (self->begin < self->end);
+		const size_t index = self->begin;
+		if(isExist){
+			self->begin++;
+		}
+		pthread_mutex_unlock(&self->mutex);
+		if(isExist){
+			pool->func(pool->context, index, arg->workerIndex);
+			self->taskNum++;
+			continue;
+		}
+		if(! WorkStealingPool_steal_inline_(pool, arg->workerIndex)){
+			break;
+		}
+	}
+	return NULL;
+}
+
+/** @brief func(context, index, workerIndex)を全ての添字[0, taskNum)について1度ずつ呼ぶ(全て終わるまで戻らない)。
+  @param threadNum 0の場合はCPU数
+  @return 盗んだ回数の合計
+  */
+size_t WorkStealingPool_run(size_t taskNum, size_t threadNum, WorkStealingPool_Func func, void *context)
+{
+	if(0 == threadNum){
+		const long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+		threadNum = (cpuNum < 1)? 1 : (size_t)cpuNum;
+	}
+	threadNum = (WorkStealingPool_THREAD_MAX < threadNum)? WorkStealingPool_THREAD_MAX : threadNum;
+	threadNum = (taskNum < threadNum)? ((0 == taskNum)? 1 : taskNum) : threadNum;
+
+	WorkStealingPool pool = {
+		.workers	= (WorkStealingPoolWorker *)ffmalloc(sizeof(WorkStealingPoolWorker) * threadNum),
+		.workerNum	= threadNum,
+		.func		= func,
+		.context	= context,
+	};
+	// 初めは均等に分ける
+	for(size_t w = 0; w < threadNum; w++){
+		pthread_mutex_init(&pool.workers[w].mutex, NULL);
+		pool.workers[w].begin = (taskNum * w) / threadNum;
+		pool.workers[w].end = (taskNum * (w + 1)) / threadNum;
+	}
+
+	WorkStealingPoolThreadArg args[WorkStealingPool_THREAD_MAX];
+	pthread_t threads[WorkStealingPool_THREAD_MAX];
+	size_t startedNum = 0;
+	for(size_t w = 1; w < threadNum; w++){
+		args[w] = (WorkStealingPoolThreadArg){&pool, w};
+		if(0 != pthread_create(&threads[w], NULL, WorkStealingPool_workerMain_inline_, &args[w])){
+			WARN_LOG("pthread_create: %zu/%zu", w, threadNum);
+			break; // 起動できなかったworkerの範囲は他のworkerが盗む
+		}
+		startedNum = w;
+	}
+	// 呼び出し元のthreadもworker 0として働く
+	args[0] = (WorkStealingPoolThreadArg){&pool, 0};
+	WorkStealingPool_workerMain_inline_(&args[0]);
+	for(size_t w = 1; w <= startedNum; w++){
+		pthread_join(threads[w], NULL);
+	}
+
+	size_t stealNum = 0;
+	for(size_t w = 0; w < threadNum; w++){
+		stealNum += pool.workers[w].stealNum;
+		pthread_mutex_destroy(&pool.workers[w].mutex);
+	}
+	free(pool.workers);
+	return stealNum;
+}
+
+#endif // #ifndef DAISYFF_WORK_STEALING_POOL_HPP_
@@ -5,8 +5,21 @@
  */
 
 #include "src/OpenType.h"
+#include "src/FontFile.h"
+#include "src/FontParser.h"
+#include "src/GlyphRaster.h"
+#include "src/GlyphSdf.h"
+#include "src/TextMeasure.h"
+#include "src/FontValidator.h"
+#include "src/FontChecksum.h"
+#include "src/FontDiff.h"
+#include "src/FontWoff.h"
+#include "src/FontSizeReport.h"
+#include "src/WorkStealingPool.h"
+#include "src/JsonWriter.h"
 #include "include/version.h"
 #include <inttypes.h>
+#include <dirent.h>
 
 enum{
 	FFStrictMode_NONE = 0,
@@ -15,11 +28,52 @@ enum{
 };
 typedef int FFStrictMode;
 
+//! -t で出力を指定できるTable
+enum{
+	DumpTable_HEAD		= (1 << 0),
+	DumpTable_MAXP		= (1 << 1),
+	DumpTable_CMAP		= (1 << 2),
+	DumpTable_LOCA		= (1 << 3),
+	DumpTable_GLYF		= (1 << 4),
+	DumpTable_FVAR		= (1 << 5),
+	DumpTable_GVAR		= (1 << 6),
+	DumpTable_ALL		= (1 << 7) - 1,
+};
+typedef int DumpTable;
+
+typedef struct{
+	const char		*tag;
+	DumpTable		table;
+}DumpTableTag;
+const DumpTableTag dumpTableTags[] = {
+	{"head", DumpTable_HEAD},
+	{"maxp", DumpTable_MAXP},
+	{"cmap", DumpTable_CMAP},
+	{"loca", DumpTable_LOCA},
+	{"glyf", DumpTable_GLYF},
+	{"fvar", DumpTable_FVAR},
+	{"gvar", DumpTable_GVAR},
+};
+
 typedef struct{
 	FFStrictMode		strictMode;
-	char			tablename[5];
+	DumpTable		tables;		//!< 0: 全て
+	size_t			glyphFirst;	//!< --glyphs: glyf, gvarで出力するglyphIdの範囲
+	size_t			glyphLast;
+	long			renderGlyphId;	//!< -1: 描画しない
+	double			renderPpem;
+	const char		*renderPath;
+	const char		*sdfRanges;	//!< NULL: SDF atlasを出力しない
+	double			sdfPpem;
+	double			sdfSpread;
+	const char		*sdfOutBase;
+	const char		*measureText;	//!< NULL: 送り幅を計測しない
+	bool			isJson;		//!< --json: NDJSONで出力する
+	bool			isVerifyOnly;	//!< --verify-only: checksumだけを確かめる(Tableを解析しない)
+	bool			isSizeReport;	//!< --size-report: 大きさの内訳と見積もりだけを出力する
+	size_t			threadNum;	//!< --threads: checksumの計算・WOFFの展開に使うthread数(0: CPU数)
 }FfDumpArg;
-FfDumpArg arg = {0};
+FfDumpArg arg = {.renderGlyphId = -1, .glyphLast = SIZE_MAX};
 
 #define FONT_ERROR_LOG(fmt, ...) \
 	do{ \
@@ -33,10 +87,12 @@ FfDumpArg arg = {0};
 	do{ \
 		fprintf(stderr, "font warning: %s()[%d]: "fmt"\n", __func__, __LINE__, ## __VA_ARGS__); \
 	}while(0);
-#define FONT_ASSERT(arg) \
+//! @brief 解析のエラーを出力する。範囲外(途中で切れたファイル等)はフォントの不正として終了する。
+#define FONT_PARSE_ERROR_LOG(ARG_error, fmt, ...) \
 	do{ \
-		if(!(arg)){ \
-			fprintf(stderr, "font assert: %s()[%d]:'%s'\n", __func__, __LINE__, #arg); \
+		const FontParseError error_ = (ARG_error); \
+		FONT_ERROR_LOG("%s: "fmt, FontParseError_toString(error_), ## __VA_ARGS__); \
+		if(FontParseError_OutOfRange == error_){ \
 			exit(1); \
 		} \
 	}while(0);
@@ -52,42 +108,6 @@ int CONVERT_INT_FROM_UINT16T(int16_t sv)
 	return dv *= -1;
 }
 
-uint64_t ntohll(uint64_t x)
-{
-	if(IS_LITTLE_ENDIAN()){
-		return bswap_64(x);
-	}else{
-		return x;
-	}
-}
-
-void ntohArray16Move(uint8_t *buf8, const uint16_t *array16, size_t array16Num)
-{
-	// uint16_tの場合は逆変換するだけ
-	htonArray16Move(buf8, array16, array16Num);
-}
-
-void ntohArray16(uint16_t *array16, size_t array16Num)
-{
-	uint8_t *buf8 = (uint8_t *)array16; // 自身へmove
-	ntohArray16Move(buf8, array16, array16Num);
-}
-
-TagType TagType_Generate(const char *tagstring)
-{
-	ASSERT(tagstring);
-
-	if(4 != strlen(tagstring)){
-		ERROR_LOG("%zu `%s`", strlen(tagstring), tagstring);
-		return false;
-	}
-
-	TagType tagvalue;
-	memcpy((void *)&tagvalue, tagstring, 4);
-
-	return tagvalue;
-}
-
 //!< @return malloc tag like string or 32bit hex dump.
 const char *TagType_ToPrintString(uint32_t tagValue)
 {
@@ -144,58 +164,6 @@ const char *OffsetTable_SfntVersion_ToPrintString(uint32_t sfntVersion)
 	return TagType_ToPrintString(sfntVersion);
 }
 
-TableDirectory_Member *TableDirectory_QueryTag(TableDirectory_Member *tableDirectory, size_t numTables, TagType tagvalue)
-{
-	for(int i = 0; i < numTables; i++){
-		//DEBUG_LOG("%04x %04x", tableDirectory[i].tag, tagvalue);
-		if(tableDirectory[i].tag == tagvalue){
-			return &tableDirectory[i];
-		}
-	}
-
-	return NULL;
-}
-
-HeadTable HeadTable_ToHostByteOrder(HeadTable headTable)
-{
-	HeadTable headTable_Host = {
-		.majorVersion		= ntohs(headTable.majorVersion		),
-		.minorVersion		= ntohs(headTable.minorVersion		),
-		.fontRevision		= ntohl(headTable.fontRevision		),
-		.checkSumAdjustment	= ntohl(headTable.checkSumAdjustment	),
-		.magicNumber		= ntohl(headTable.magicNumber		),
-		.flags			= ntohs(headTable.flags			),
-		.unitsPerEm		= ntohs(headTable.unitsPerEm		),
-		.created		= ntohll(headTable.created		),
-		.modified		= ntohll(headTable.modified		),
-		.xMin			= ntohs(headTable.xMin			),
-		.yMin			= ntohs(headTable.yMin			),
-		.xMax			= ntohs(headTable.xMax			),
-		.yMax			= ntohs(headTable.yMax			),
-		.macStyle		= ntohs(headTable.macStyle		),
-		.lowestRecPPEM		= ntohs(headTable.lowestRecPPEM		),
-		.fontDirectionHint	= ntohs(headTable.fontDirectionHint	),
-		.indexToLocFormat	= ntohs(headTable.indexToLocFormat	),
-		.glyphDataFormat	= ntohs(headTable.glyphDataFormat	),
-	};
-
-	return headTable_Host;
-}
-
-typedef MaxpTable_Version05 MaxpTable;
-
-MaxpTable MaxpTable_ToHostByteOrder(MaxpTable maxpTable)
-{
-	MaxpTable maxpTable_Host = {
-		.version		= ntohl(maxpTable.version	),
-		.numGlyphs		= ntohs(maxpTable.numGlyphs	),
-	};
-	if(0x00005000 != maxpTable_Host.version){
-		WARN_LOG("not implement"); //!< @todo not implement
-	}
-
-	return maxpTable_Host;
-}
 
 typedef struct{
 	uint16_t	id;
@@ -318,17 +286,10 @@ const char *CmapSubtable_ToShowString(uint16_t format)
 	return cmapSubtableInfo->showString;
 }
 
-
-enum LocaTable_Kind{
-	LocaTable_Kind_Short	= 0,
-	LocaTable_Kind_Long	= 1,
-};
-typedef int LocaTable_Kind;
-
-char *GlyphDescriptionFlag_ToPrintString(uint8_t flag)
+//! @brief 点毎に呼ぶので呼び出し側のbufferへ書く(確保しない)
+const char *GlyphDescriptionFlag_ToPrintString(uint8_t flag, char *str, size_t size)
 {
-	char *str = ffmalloc(512);
-	snprintf(str, 512,
+	snprintf(str, size,
 		"%-7s %-7s %-7s %-7s %-7s %-7s %-9s",
 		(0 != (flag & (1 << 6))) ? "Overlap":"",
 		(0 != (flag & (1 << 5))) ? "YDual":"",
@@ -342,142 +303,107 @@ char *GlyphDescriptionFlag_ToPrintString(uint8_t flag)
 	return str;
 }
 
-typedef struct{
-	uint16_t x;
-	uint16_t y;
-}RawPoint;
-
-typedef struct{
-	int x;
-	int y;
-}Point;
-
-typedef struct{
-	int		isFlagRepeated;
-	uint8_t		flag;
-	int		isRelXSame;
-	int		isRelYSame;
-	RawPoint	raw;
-	Point		rel;
-	Point		abs;
-}GlyphDescriptionPoint;
-
-bool GlyphFlag_IsXShortVector(uint8_t flag)
-{
-	return (0 != (flag & (0x1 << 1)));
-}
-
-bool GlyphFlag_IsSameOrPisitiveXShortVector(uint8_t flag)
-{
-	return (0 != (flag & (0x1 << 4)));
-}
-
-bool GlyphFlag_IsYShortVector(uint8_t flag)
-{
-	return (0 != (flag & (0x1 << 2)));
-}
-
-bool GlyphFlag_IsSameOrPisitiveYShortVector(uint8_t flag)
+//! @brief composite glyphの部品のflagを表示用の文字列にする
+void ComponentFlag_ToPrintString(uint16_t flags, char *str, size_t size)
 {
-	return (0 != (flag & (0x1 << 5)));
+	const struct{
+		uint16_t	flag;
+		const char	*name;
+	}names[] = {
+		{ComponentFlag_ARG_1_AND_2_ARE_WORDS,		"Words"},
+		{ComponentFlag_ARGS_ARE_XY_VALUES,		"XY"},
+		{ComponentFlag_ROUND_XY_TO_GRID,		"Round"},
+		{ComponentFlag_WE_HAVE_A_SCALE,			"Scale"},
+		{ComponentFlag_MORE_COMPONENTS,			"More"},
+		{ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE,	"XYScale"},
+		{ComponentFlag_WE_HAVE_A_TWO_BY_TWO,		"2x2"},
+		{ComponentFlag_WE_HAVE_INSTRUCTIONS,		"Inst"},
+		{ComponentFlag_USE_MY_METRICS,			"MyMetrics"},
+		{ComponentFlag_OVERLAP_COMPOUND,		"Overlap"},
+		{ComponentFlag_SCALED_COMPONENT_OFFSET,		"ScaledOffset"},
+		{ComponentFlag_UNSCALED_COMPONENT_OFFSET,	"UnscaledOffset"},
+	};
+	str[0] = '\0';
+	size_t length = 0;
+	for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++){
+		if(0 != (flags & names[i].flag) && length < size){
+			length += snprintf(&str[length], size - length, "%s%s", ((0 == length)? "":"|"), names[i].name);
+		}
+	}
 }
 
-#define COPYRANGE_OR_DIE(ARG_fd, ARG_buf, ARG_offset, ARG_size) \
-	do{ \
-		int fd_ = (ARG_fd); void *buf_ = (ARG_buf); size_t offset_ = (ARG_offset); size_t size_ = (ARG_size); \
-		if(! copyrange(fd_, buf_, offset_, size_)){ \
-			FONT_ERROR_LOG("COPYRANGE_OR_DIE: %d %s %d %p %zu %zu", errno, strerror(errno), fd_, buf_, offset_, size_); \
-			exit(1); \
-		} \
-	}while(0);
-
-bool copyrange(int fd, uint8_t *buf, size_t offset, size_t size)
+void tableDirectory(const FontParser *parser)
 {
-	errno = 0;
-	off_t off = lseek(fd, offset, SEEK_SET);
-	if(-1 == off){
-		ERROR_LOG("lseek: %ld %d %s", off, errno, strerror(errno));
-		return false;
-	}
-
-	ssize_t ssize;
-	ssize = read(fd, buf, size);
-	if(ssize != size){
-		ERROR_LOG("read: %zd %d %s\n", ssize, errno, strerror(errno));
-		return false;
+	// ** TableDirectory
+	for(int i = 0; i < parser->offsetTable.numTables; i++){
+		const TableDirectory_Member *tableDirectory_Member_Host = &parser->tableDirectory[i];
+		const char *tagstring = TagType_ToPrintString(tableDirectory_Member_Host->tag);
+		fprintf(stdout,
+				"%2d. '%s' - checksum = 0x%08x, offset = 0x%08x(%6d), len =%8d\n",
+				i,
+				tagstring,
+				tableDirectory_Member_Host->checkSum,
+				tableDirectory_Member_Host->offset,
+				tableDirectory_Member_Host->offset,
+				tableDirectory_Member_Host->length);
 	}
-
-	return true;
 }
 
-/*
-#define DEBUG_RANGE(ARG_fd, ARG_offset, ARG_size) \
-	do{ \
-		int fd_ = (ARG_fd); size_t offset_ = (ARG_offset); size_t size_ = (ARG_size); \
-		void *buf_ = ffmalloc(size_); \
-		COPYRANGE_OR_DIE(fd_, buf_, offset_, size_); \
-	}while(0);
-*/
-void readTableDirectory(
-		TableDirectory_Member **pTableDirectory,
-		size_t numTables,
-		int fd)
+/** @brief Table毎のchecksumとcheckSumAdjustmentを計算し直して比べる。
+  @return true: 全て一致した
+  */
+bool checksumTable(const FontParser *parser)
 {
-	TableDirectory_Member *tableDirectory = NULL;
-	// ** TableDirectory
-	//TableDirectory_Member *tableDirectory = NULL;
-	for(int i = 0; i < numTables; i++){
-		TableDirectory_Member tableDirectory_Member;
-		ssize_t ssize;
-		ssize = read(fd, (void *)&tableDirectory_Member, sizeof(tableDirectory_Member));
-		if(ssize != sizeof(tableDirectory_Member)){
-			FONT_ERROR_LOG("read: %zd %d %s", ssize, errno, strerror(errno));
-			exit(1);
-		}
-
-		tableDirectory = ffrealloc(tableDirectory, sizeof(TableDirectory_Member) * (i + 1));
-		ASSERT(tableDirectory);
-		memcpy(&tableDirectory[i], &tableDirectory_Member, sizeof(TableDirectory_Member));
+	FontChecksumReport report;
+	FontChecksum_verify(parser, arg.threadNum, &report);
 
-		{
-			TableDirectory_Member tableDirectory_Member_Host;
-			tableDirectory_Member_Host.tag		= ntohl(tableDirectory_Member.tag);
-			tableDirectory_Member_Host.checkSum	= ntohl(tableDirectory_Member.checkSum);
-			tableDirectory_Member_Host.offset	= ntohl(tableDirectory_Member.offset);
-			tableDirectory_Member_Host.length	= ntohl(tableDirectory_Member.length);
-			const char *tagstring = TagType_ToPrintString(tableDirectory_Member_Host.tag);
-			fprintf(stdout,
-					"%2d. '%s' - checksum = 0x%08x, offset = 0x%08x(%6d), len =%8d\n",
-					i,
-					tagstring,
-					tableDirectory_Member_Host.checkSum,
-					tableDirectory_Member_Host.offset,
-					tableDirectory_Member_Host.offset,
-					tableDirectory_Member_Host.length);
+	fprintf(stdout,
+			"\n"
+			"Checksum\n"
+			"--------\n");
+	for(size_t i = 0; i < report.tableNum; i++){
+		const FontChecksumTable *table = &report.tables[i];
+		const char *tagstring = TagType_ToPrintString(table->tag);
+		if(table->isOutOfRange){
+			fprintf(stdout, "%2zu. '%s' - out of file\n", i, tagstring);
+			FONT_ERROR_LOG("'%s' checksum: table out of file", tagstring);
+			continue;
+		}
+		const bool isOk = (table->stored == table->actual);
+		fprintf(stdout, "%2zu. '%s' - stored = 0x%08x, actual = 0x%08x %s\n",
+				i, tagstring, table->stored, table->actual, isOk ? "ok" : "MISMATCH");
+		if(! isOk){
+			FONT_ERROR_LOG("'%s' checksum: stored 0x%08x actual 0x%08x", tagstring, table->stored, table->actual);
 		}
 	}
-
-	*pTableDirectory = tableDirectory;
+	if(report.isHeadFound){
+		const bool isOk = (report.storedAdjustment == report.actualAdjustment);
+		fprintf(stdout, "	 checkSumAdjustment: stored = 0x%08x, actual = 0x%08x %s\n",
+				report.storedAdjustment, report.actualAdjustment, isOk ? "ok" : "MISMATCH");
+		if(! isOk){
+			FONT_ERROR_LOG("'head' checkSumAdjustment: stored 0x%08x actual 0x%08x",
+					report.storedAdjustment, report.actualAdjustment);
+		}
+	}
+	const bool isOk = FontChecksumReport_isOk(&report);
+	FontChecksumReport_free(&report);
+	return isOk;
 }
 
-void headTable(
-		TableDirectory_Member *tableDirectory,
-		size_t numTables,
-		int fd,
-		uint16_t *headTable_Host_indexToLocFormat)
+void headTable(const FontParser *parser, uint16_t *headTable_Host_indexToLocFormat)
 {
 	// ** HeadTable
-	TableDirectory_Member *tableDirectory_HeadTable = TableDirectory_QueryTag(tableDirectory, numTables, TagType_Generate("head"));
-	if(NULL == tableDirectory_HeadTable){
+	HeadTable headTable_Host;
+	const FontParseError error = FontParser_head(parser, &headTable_Host);
+	if(FontParseError_NotFound == error){
 		FONT_WARN_LOG("HeadTable not detected.");
 		return;
 	}
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "'head'");
+		return;
+	}
 
-	HeadTable headTable;
-
-	COPYRANGE_OR_DIE(fd, (void *)&headTable, ntohl(tableDirectory_HeadTable->offset), sizeof(headTable));
-
-	HeadTable headTable_Host = HeadTable_ToHostByteOrder(headTable);
 	const char *macstyleprintstring = MacStyle_toStringForNameTable(headTable_Host.macStyle);
 	macstyleprintstring = ((NULL != macstyleprintstring) ?  macstyleprintstring : "unknown");
 	fprintf(stdout, "\n");
@@ -528,26 +454,21 @@ void headTable(
 	*headTable_Host_indexToLocFormat = headTable_Host.indexToLocFormat;
 }
 
-void maxpTable(
-		TableDirectory_Member *tableDirectory,
-		size_t numTables,
-		int fd,
-		size_t *maxpTable_Host_numGlyphs)
+void maxpTable(const FontParser *parser, size_t *maxpTable_Host_numGlyphs)
 {
-
 	// ** MaxpTable
-	TableDirectory_Member *tableDirectory_MaxpTable = TableDirectory_QueryTag(tableDirectory, numTables, TagType_Generate("maxp"));
-	if(NULL == tableDirectory_MaxpTable){
+	MaxpTable_Version05 maxpTable_Host;
+	const FontParseError error = FontParser_maxp(parser, &maxpTable_Host);
+	if(FontParseError_NotFound == error){
 		FONT_WARN_LOG("MaxpTable not detected.");
 		return;
 	}
-
-	MaxpTable_Version05 maxpTable;
-
-	COPYRANGE_OR_DIE(fd, (void *)&maxpTable, ntohl(tableDirectory_MaxpTable->offset), sizeof(maxpTable));
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "'maxp'");
+		return;
+	}
 
 	// MaxpTable Version 0.5
-	MaxpTable_Version05 maxpTable_Host = MaxpTable_ToHostByteOrder(maxpTable);
 	if(0x00005000 != maxpTable_Host.version){
 		FONT_WARN_LOG("not implement or invalid version 0x%08x", maxpTable_Host.version);
 	}
@@ -564,59 +485,88 @@ void maxpTable(
 	*maxpTable_Host_numGlyphs = maxpTable_Host.numGlyphs;
 }
 
-void cmapTable_Format0(TableDirectory_Member *tableDirectory_CmapTable, int fd, size_t subtableOffset)
+//! @brief 他のTableの出力に必要な値だけを読む(出力しない)
+void headTable_Read(const FontParser *parser, uint16_t *headTable_Host_indexToLocFormat)
+{
+	HeadTable headTable_Host;
+	const FontParseError error = FontParser_head(parser, &headTable_Host);
+	if(FontParseError_None == error){
+		*headTable_Host_indexToLocFormat = headTable_Host.indexToLocFormat;
+	}else if(FontParseError_NotFound != error){
+		FONT_PARSE_ERROR_LOG(error, "'head'");
+	}
+}
+
+//! @brief 他のTableの出力に必要な値だけを読む(出力しない)
+void maxpTable_Read(const FontParser *parser, size_t *maxpTable_Host_numGlyphs)
+{
+	MaxpTable_Version05 maxpTable_Host;
+	const FontParseError error = FontParser_maxp(parser, &maxpTable_Host);
+	if(FontParseError_None == error){
+		*maxpTable_Host_numGlyphs = maxpTable_Host.numGlyphs;
+	}else if(FontParseError_NotFound != error){
+		FONT_PARSE_ERROR_LOG(error, "'maxp'");
+	}
+}
+
+void cmapTable_Format0(const FontParseCmap *cmap, size_t index)
 {
-	size_t HEADER_SIZE = 6;
-	uint16_t header[3];
-	COPYRANGE_OR_DIE(fd, (void *)header, ntohl(tableDirectory_CmapTable->offset) + subtableOffset, sizeof(header));
-	uint16_t length = htons(header[1]);
-	uint16_t languageId = htons(header[2]);
+	FontParseCmapSubtableHeader header;
+	FontParseError error = FontParseCmap_subtableHeader(cmap, index, &header);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "Format0 header");
+		return;
+	}
 	fprintf(stdout,
 		"		 Length:     %3d(limited to header(6) + 256)\n"
 		"		 Language:   %3d\n",
-		length,
-		languageId);
+		header.length,
+		header.language);
 
-	FONT_ASSERT(6 + 256 >= length); // Format0 fullsize
-	FONT_ASSERT(6 <= length); // Format0 fixed length head size
+	FontParseCmapFormat0 format0;
+	error = FontParseCmap_format0(cmap, index, &format0);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "Format0 length %d", header.length);
+		return;
+	}
 
-	uint8_t glyphIdArray[256];
-	COPYRANGE_OR_DIE(fd, (void *)glyphIdArray, ntohl(tableDirectory_CmapTable->offset) + subtableOffset + HEADER_SIZE, length - HEADER_SIZE);
 	fprintf(stdout,
 		"		[%3d] = {\n"
 		"		",
-		(int)(length - HEADER_SIZE));
-	for(int g = 0; g < (length - HEADER_SIZE); g++){
+		(int)format0.glyphIdNum);
+	for(int g = 0; g < format0.glyphIdNum; g++){
 		if((0 != g) && (0 == g % 16)){
 			fprintf(stdout, "\n		");
 		}
-		fprintf(stdout, "%3d,", glyphIdArray[g]);
+		fprintf(stdout, "%3d,", format0.glyphIdArray[g]);
 	}
 	fprintf(stdout, "}\n");
 }
 
-void cmapTable_Format4(TableDirectory_Member *tableDirectory_CmapTable, int fd, size_t subtableOffset)
+void cmapTable_Format4(const FontParseCmap *cmap, size_t index)
 {
-	// ** CmapSubtableFormat4 FixedLengthHead
-	size_t FIXED_LENGTH_HEAD_SIZE = sizeof(Uint16Type) * 7;
-	uint16_t header[3];
-	COPYRANGE_OR_DIE(fd, (void *)header, ntohl(tableDirectory_CmapTable->offset) + subtableOffset, sizeof(header));
-	uint16_t length = htons(header[1]);
-	uint16_t languageId = htons(header[2]);
+	// ** CmapSubtableFormat4
+	FontParseCmapSubtableHeader header;
+	FontParseError error = FontParseCmap_subtableHeader(cmap, index, &header);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "Format4 header");
+		return;
+	}
 	fprintf(stdout,
 		"		 Length:     %3d(limited to header(6) + 256)\n"
 		"		 Language:   %3d\n",
-		length,
-		languageId);
-
-	FONT_ASSERT(FIXED_LENGTH_HEAD_SIZE <= length); // Format4 fixed length head size
-
-	// ** read fixed length elements of head
-	// segment listの最適化された検索パラメタ 先頭固定長領域を取ってくる
-	CmapTable_CmapSubtable_Format4Buf format4buf_Host = {0};
-	COPYRANGE_OR_DIE(fd, (void *)&format4buf_Host, ntohl(tableDirectory_CmapTable->offset) + subtableOffset, FIXED_LENGTH_HEAD_SIZE);
-	ntohArray16((void *)&format4buf_Host, FIXED_LENGTH_HEAD_SIZE);
+		header.length,
+		header.language);
+
+	FontParseCmapFormat4 format4buf_Host;
+	error = FontParseCmap_format4(cmap, index, &format4buf_Host);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "Format4 length %d", header.length);
+		FontParseCmapFormat4_free(&format4buf_Host);
+		return;
+	}
 
+	// segment listの最適化された検索パラメタ
 	uint16_t segCount	= format4buf_Host.segCountX2 / 2;
 	uint16_t searchRange	= (2 * 2 * (int)floor(log2(segCount)));
 	uint16_t entrySelector	= ((int)log2(searchRange/2.0));
@@ -642,44 +592,6 @@ void cmapTable_Format4(TableDirectory_Member *tableDirectory_CmapTable, int fd,
 		format4buf_Host.rangeShift,
 		rangeShift);
 
-	// ** read variable length elements (segCount)
-	size_t offsetInSubtable = subtableOffset;
-	offsetInSubtable += FIXED_LENGTH_HEAD_SIZE;
-
-	// *** メモリ確保
-	format4buf_Host.endCode		= ffmalloc(sizeof(Uint16Type) * segCount);
-	format4buf_Host.startCode	= ffmalloc(sizeof(Uint16Type) * segCount);
-	format4buf_Host.idDelta		= ffmalloc(sizeof(Uint16Type) * segCount);
-	format4buf_Host.idRangeOffset	= ffmalloc(sizeof(Uint16Type) * segCount);
-	//format4buf_Host.glyphIdArray	= ffmalloc(sizeof(Uint16Type) * segCount);
-
-	// *** endCode
-	COPYRANGE_OR_DIE(fd, (void *)format4buf_Host.endCode,
-			ntohl(tableDirectory_CmapTable->offset) + offsetInSubtable,
-			sizeof(Uint16Type) * segCount);
-	ntohArray16((void *)format4buf_Host.endCode, sizeof(Uint16Type) * segCount);
-	offsetInSubtable += sizeof(Uint16Type) * segCount;
-	// *** reservedPad
-	offsetInSubtable += sizeof(Uint16Type);
-	// *** startCode
-	COPYRANGE_OR_DIE(fd, (void *)format4buf_Host.startCode,
-			ntohl(tableDirectory_CmapTable->offset) + offsetInSubtable,
-			sizeof(Uint16Type) * segCount);
-	ntohArray16((void *)format4buf_Host.startCode, sizeof(Uint16Type) * segCount);
-	offsetInSubtable += sizeof(Uint16Type) * segCount;
-	// *** idDelta
-	COPYRANGE_OR_DIE(fd, (void *)format4buf_Host.idDelta,
-			ntohl(tableDirectory_CmapTable->offset) + offsetInSubtable,
-			sizeof(Uint16Type) * segCount);
-	ntohArray16((void *)format4buf_Host.idDelta, sizeof(Uint16Type) * segCount);
-	offsetInSubtable += sizeof(Uint16Type) * segCount;
-	// *** idRangeOffset
-	COPYRANGE_OR_DIE(fd, (void *)format4buf_Host.idRangeOffset,
-			ntohl(tableDirectory_CmapTable->offset) + offsetInSubtable,
-			sizeof(Uint16Type) * segCount);
-	ntohArray16((void *)format4buf_Host.idRangeOffset, sizeof(Uint16Type) * segCount);
-	offsetInSubtable += sizeof(Uint16Type) * segCount;
-
 	// ** segments summary
 	for(int seg = 0; seg < segCount; seg++){
 		fprintf(stdout,
@@ -734,13 +646,15 @@ void cmapTable_Format4(TableDirectory_Member *tableDirectory_CmapTable, int fd,
 				glyphId);
 		}
 	}
+	FontParseCmapFormat4_free(&format4buf_Host);
 }
 
-void cmapTable(TableDirectory_Member *tableDirectory, size_t numTables, int fd)
+void cmapTable(const FontParser *parser)
 {
 	// ** CmapTable
-	TableDirectory_Member *tableDirectory_CmapTable = TableDirectory_QueryTag(tableDirectory, numTables, TagType_Generate("cmap"));
-	if(NULL == tableDirectory_CmapTable){
+	FontParseCmap cmap;
+	const FontParseError error = FontParser_cmap(parser, &cmap);
+	if(FontParseError_NotFound == error){
 		FONT_WARN_LOG("CmapTable not detected.");
 		return;
 	}
@@ -750,57 +664,49 @@ void cmapTable(TableDirectory_Member *tableDirectory, size_t numTables, int fd)
 		"'cmap' Table - Character to Glyph Index Mapping Table\n"
 		"-----------------------------------------------------\n");
 
-	CmapTableHeader cmapTableHeader;
-	COPYRANGE_OR_DIE(fd, (void *)&cmapTableHeader, ntohl(tableDirectory_CmapTable->offset), sizeof(CmapTableHeader));
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "'cmap'");
+		FontParseCmap_free(&cmap);
+		return;
+	}
 
 	// *** CmapTableHeader
-	CmapTableHeader cmapTableHeader_Host = {
-		.version	= ntohs(cmapTableHeader.version		),
-		.numTables	= ntohs(cmapTableHeader.numTables	),
-	};
 	fprintf(stdout,
 		"	 'cmap' version: %d\n"
 		//"	 number of encodings: 1\n"
 		"	 number of subtables: %2d\n"
 		,
-		cmapTableHeader_Host.version,
-		cmapTableHeader_Host.numTables);
-
-	size_t offsetInTable = sizeof(CmapTableHeader);
+		cmap.header.version,
+		cmap.header.numTables);
 
 	fprintf(stdout, "\n");
 
 	// *** CmapTable EncogindRecords
-	uint32_t cmapSubtableOffsets[cmapTableHeader_Host.numTables]; // CmapSubtableを引くのに使う
-	for(int r = 0; r < cmapTableHeader_Host.numTables; r++){
-		CmapTable_EncodingRecordElementHeader encodingRecord;
-		COPYRANGE_OR_DIE(fd, (void *)&encodingRecord, ntohl(tableDirectory_CmapTable->offset) + offsetInTable, sizeof(CmapTable_EncodingRecordElementHeader));
-		CmapTable_EncodingRecordElementHeader encodingRecord_Host = {
-			.platformID	= ntohs(encodingRecord.platformID	),
-			.encodingID	= ntohs(encodingRecord.encodingID	),
-			.offset		= ntohl(encodingRecord.offset		),
-		};
+	for(int r = 0; r < cmap.header.numTables; r++){
+		const CmapTable_EncodingRecordElementHeader *encodingRecord_Host = &cmap.encodingRecords[r];
 		fprintf(stdout,
 			"Encoding   %d.	 PlatformID:  %d(%s)\n"
 			"		 EcodingID:   %d(%s)\n"
 			"		 SubTable: %d, Offset: 0x%08x(%4d)\n",
 			r,
-			encodingRecord_Host.platformID,
-			PlatformID_ToShowString(encodingRecord_Host.platformID),
-			encodingRecord_Host.encodingID,
-			EncodingID_ToShowString(encodingRecord_Host.platformID, encodingRecord_Host.encodingID),
+			encodingRecord_Host->platformID,
+			PlatformID_ToShowString(encodingRecord_Host->platformID),
+			encodingRecord_Host->encodingID,
+			EncodingID_ToShowString(encodingRecord_Host->platformID, encodingRecord_Host->encodingID),
 			r,
-			encodingRecord_Host.offset,
-			encodingRecord_Host.offset);
-		offsetInTable += sizeof(CmapTable_EncodingRecordElementHeader);
-		cmapSubtableOffsets[r] = encodingRecord_Host.offset;
+			encodingRecord_Host->offset,
+			encodingRecord_Host->offset);
 	}
 
 	// *** CmapTable Subtable
-	for(int t = 0; t < cmapTableHeader_Host.numTables; t++){
+	for(int t = 0; t < cmap.header.numTables; t++){
+		const uint32_t subtableOffset = cmap.encodingRecords[t].offset;
 		uint16_t format;
-		COPYRANGE_OR_DIE(fd, (void *)&format, ntohl(tableDirectory_CmapTable->offset) + cmapSubtableOffsets[t], sizeof(uint16_t));
-		format = ntohs(format);
+		const FontParseError formatError = FontParseCmap_subtableFormat(&cmap, t, &format);
+		if(FontParseError_None != formatError){
+			FONT_PARSE_ERROR_LOG(formatError, "SubTable %d offset 0x%08x", t, subtableOffset);
+			continue;
+		}
 
 		fprintf(stdout, "\n");
 		fprintf(stdout,
@@ -808,30 +714,30 @@ void cmapTable(TableDirectory_Member *tableDirectory, size_t numTables, int fd)
 			t,
 			format,
 			CmapSubtable_ToShowString(format),
-			(uint32_t)cmapSubtableOffsets[t]); // あまり大きいoffsetは想定していない
+			subtableOffset); // あまり大きいoffsetは想定していない
 
 		int alreadyIndex = -1;
 		for(int ii = 0; ii < t; ii++){
-			if(cmapSubtableOffsets[t] == cmapSubtableOffsets[ii]){
+			if(subtableOffset == cmap.encodingRecords[ii].offset){
 				alreadyIndex = ii;
 			}
 		}
 		if(-1 != alreadyIndex){
 			fprintf(stdout,
 				"	skip CmapSubtable already %2d,%2d/%2d(offset:0x%08x)\n",
-				alreadyIndex, t, cmapTableHeader_Host.numTables, cmapSubtableOffsets[t]);
+				alreadyIndex, t, cmap.header.numTables, subtableOffset);
 			continue;
 		}
 
 		switch(format){
 			case 0:
 			{
-				cmapTable_Format0(tableDirectory_CmapTable, fd, cmapSubtableOffsets[t]);
+				cmapTable_Format0(&cmap, t);
 			}
 				break;
 			case 4:
 			{
-				cmapTable_Format4(tableDirectory_CmapTable, fd, cmapSubtableOffsets[t]);
+				cmapTable_Format4(&cmap, t);
 			}
 				break;
 			default:
@@ -841,109 +747,173 @@ void cmapTable(TableDirectory_Member *tableDirectory, size_t numTables, int fd)
 					);
 		}
 	}
+	FontParseCmap_free(&cmap);
 }
 
 void locaTable(
-		TableDirectory_Member *tableDirectory,
-		size_t numTables,
-		int fd,
+		const FontParser *parser,
 		uint16_t headTable_Host_indexToLocFormat,
-		size_t maxpTable_Host_numGlyphs,
-		uint32_t **pLocaList)
+		size_t maxpTable_Host_numGlyphs)
 {
-	uint32_t *locaList = NULL;
-
 	// ** LocaTable
-	LocaTable_Kind locaTable_Kind = ((0 == headTable_Host_indexToLocFormat) ? LocaTable_Kind_Short : LocaTable_Kind_Long);
-	TableDirectory_Member *tableDirectory_LocaTable = TableDirectory_QueryTag(tableDirectory, numTables, TagType_Generate("loca"));
-	if(NULL == tableDirectory_LocaTable){
+	// 展開せずにmapping上から1 entryずつ読む(glyph数によらずメモリを確保しない)
+	FontParseLocaView loca;
+	const FontParseError error = FontParser_locaView(parser, (int16_t)headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs, &loca);
+	if(FontParseError_NotFound == error){
 		FONT_WARN_LOG("LocaTable not detected.");
 		return;
 	}
-
-	size_t locaOffsetSize = (locaTable_Kind == LocaTable_Kind_Short) ? sizeof(uint16_t):sizeof(uint32_t);
-	size_t tableSize = locaOffsetSize * (maxpTable_Host_numGlyphs + 1);
-	uint8_t locaTable[tableSize];
-
-	COPYRANGE_OR_DIE(fd, (void *)&locaTable, ntohl(tableDirectory_LocaTable->offset), sizeof(locaTable));
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "'loca' numGlyphs %zu", maxpTable_Host_numGlyphs);
+		return;
+	}
+	FontSpan glyf;
+	const bool isGlyfFound = (FontParseError_None == FontParser_table(parser, "glyf", &glyf));
 
 	// LocaTable short,long
 	fprintf(stdout, "\n");
 	fprintf(stdout,
 		"'loca' Table - Index to Location\n"
 		"--------------------------------\n");
-	for(int i = 0; i < (maxpTable_Host_numGlyphs + 1); i++){
-		uint32_t sv = 0;
-		uint32_t dv = 0;
-		if(locaTable_Kind == LocaTable_Kind_Short){
-			uint16_t shortv;
-			memcpy(&shortv, &locaTable[i * sizeof(uint16_t)], sizeof(uint16_t));
-			shortv = ntohs(shortv);
-			sv = shortv;
-			dv = shortv * 2;
+	uint32_t prev = 0;
+	for(size_t i = 0; i < loca.num; i++){
+		uint32_t sv = FontParseLocaView_raw(&loca, i);
+		uint32_t dv = FontParseLocaView_offset(&loca, i);
+		if(i != maxpTable_Host_numGlyphs){
+			fprintf(stdout, "	 Idx %6zu -> GlyphOffset 0x%08x(0x%08x %6u)\n", i, dv, sv, dv);
 		}else{
-			uint32_t longv;
-			memcpy(&longv, &locaTable[i * sizeof(uint32_t)], sizeof(uint32_t));
-			longv = ntohl(longv);
-			sv = longv;
-			dv = longv;
+			fprintf(stdout, "	                  Ended at 0x%08x(0x%08x %6u)\n", dv, sv, dv);
 		}
+		if(dv < prev){
+			FONT_ERROR_LOG("'loca' Idx %zu: offset 0x%08x < previous 0x%08x", i, dv, prev);
+		}
+		prev = dv;
+	}
+	if(isGlyfFound && glyf.size < prev){
+		FONT_ERROR_LOG("'loca' ended at 0x%08x beyond 'glyf' size 0x%08zx", prev, glyf.size);
+	}
+}
 
-		locaList = (uint32_t *)ffrealloc(locaList, sizeof(uint32_t) * (i + 1));
-		ASSERT(locaList);
-		locaList[i] = dv;
+/** @brief composite glyphの部品と、部品を展開したoutline(絶対座標)を表示する
+  */
+void glyfTable_Composite(
+		FontSpan glyf,
+		uint32_t offset,
+		uint32_t nextOffset,
+		size_t glyphId,
+		FontParseComposite *composite,
+		FontParseGlyphResolver *resolver)
+{
+	const FontParseError error = FontParser_compositeGlyph(glyf, offset, nextOffset, composite);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "glyph %zu: composite 0x%08x - 0x%08x", glyphId, offset, nextOffset);
+		return;
+	}
 
-		if(i != maxpTable_Host_numGlyphs){
-			fprintf(stdout, "	 Idx %6d -> GlyphOffset 0x%08x(0x%08x %6u)\n", i, dv, sv, dv);
+	// *** CompositeGlyphDescription.Components
+	fprintf(stdout, "\n");
+	fprintf(stdout,
+		"	 Components (%zu)\n"
+		"	 ----------\n",
+		composite->componentNum);
+	for(size_t c = 0; c < composite->componentNum; c++){
+		const FontParseComponent *component = &composite->components[c];
+		char flagstring[128];
+		ComponentFlag_ToPrintString(component->flags, flagstring, sizeof(flagstring));
+		fprintf(stdout, "	 %2zu: glyph %6u flags 0x%04x(%s)\n", c, component->glyphIndex, component->flags, flagstring);
+		if(0 != (component->flags & ComponentFlag_ARGS_ARE_XY_VALUES)){
+			fprintf(stdout, "	     offset ( %6d, %6d)", component->arg1, component->arg2);
 		}else{
-			fprintf(stdout, "	                  Ended at 0x%08x(0x%08x %6u)\n", dv, sv, dv);
+			fprintf(stdout, "	     match point ( parent %4d, component %4d)", component->arg1, component->arg2);
 		}
+		fprintf(stdout, " transform ( %7.4f, %7.4f, %7.4f, %7.4f)\n",
+				component->scale[0], component->scale[1], component->scale[2], component->scale[3]);
+	}
+
+	// *** CompositeGlyphDescription.Instructions
+	fprintf(stdout, "\n");
+	fprintf(stdout, "	 Length of Instructions: %2d\n", (int)composite->instructions.size);
+	for(int inst = 0; inst < composite->instructions.size; inst++){
+		fprintf(stdout, "	 Instruction[%02d]: 0x%02x\n", inst, composite->instructions.data[inst]);
 	}
 
-	*pLocaList = locaList;
+	// *** Outline(部品を展開した絶対座標)
+	const FontParseOutline *outline;
+	const FontParseError outlineError = FontParseGlyphResolver_outline(resolver, glyphId, &outline);
+	if(FontParseError_None != outlineError){
+		FONT_PARSE_ERROR_LOG(outlineError, "glyph %zu: resolve components", glyphId);
+		return;
+	}
+	fprintf(stdout, "\n");
+	fprintf(stdout,
+		"	 Outline (contours: %zu, pointNum: %zu)\n"
+		"	 -------\n",
+		outline->contourNum, outline->pointNum);
+	for(size_t co = 0; co < outline->contourNum; co++){
+		fprintf(stdout, "	 EndPoint %2zu: %2u\n", co, outline->endPts[co]);
+	}
+	for(size_t i = 0; i < outline->pointNum; i++){
+		fprintf(stdout, "	 %2zu Abs ( %6d, %6d) %s\n",
+				i, outline->points[i].x, outline->points[i].y, (outline->points[i].isOnCurve ? "OnCurve":"OffCurve"));
+	}
 }
 
+/** @brief glyph毎の範囲は'loca'から必要な分だけ読む(loca全体を展開しない)
+  @param glyphFirst, glyphLast 出力するglyphIdの範囲(numGlyphs以上は無視する)
+  */
 void glyfTable(
-		TableDirectory_Member *tableDirectory,
-		size_t numTables,
-		int fd,
+		const FontParser *parser,
+		uint16_t headTable_Host_indexToLocFormat,
 		size_t maxpTable_Host_numGlyphs,
-		uint32_t *locaList)
+		size_t glyphFirst,
+		size_t glyphLast)
 {
 	// ** GlyfTable
-	TableDirectory_Member *tableDirectory_GlyfTable = TableDirectory_QueryTag(tableDirectory, numTables, TagType_Generate("glyf"));
-	if(NULL == tableDirectory_GlyfTable){
+	FontSpan glyf;
+	const FontParseError tableError = FontParser_table(parser, "glyf", &glyf);
+	if(FontParseError_NotFound == tableError){
 		FONT_WARN_LOG("GlyfTable not detected.");
 		return;
 	}
+	if(FontParseError_None != tableError){
+		FONT_PARSE_ERROR_LOG(tableError, "'glyf'");
+		return;
+	}
 
 	fprintf(stdout, "\n");
 	fprintf(stdout,
 		"'glyf' Table - Glyph Data\n"
 		"-------------------------\n");
 
-	FONT_ASSERT(NULL != locaList);
+	FontParseLocaView loca;
+	const FontParseError locaViewError = FontParser_locaView(parser, (int16_t)headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs, &loca);
+	if(FontParseError_NotFound == locaViewError){
+		FONT_ERROR_LOG("'glyf' requires 'loca'");
+		return;
+	}
+	if(FontParseError_None != locaViewError){
+		FONT_PARSE_ERROR_LOG(locaViewError, "'loca' numGlyphs %zu", maxpTable_Host_numGlyphs);
+		return;
+	}
 
-	for(int glyphId = 0; glyphId< maxpTable_Host_numGlyphs; glyphId++){
-		size_t offsetOnTable = locaList[glyphId];
-		size_t datasize = locaList[glyphId + 1] - locaList[glyphId];
+	FontParseGlyph glyph = {0}; // glyph間で配列を使い回す
+	FontParseComposite composite = {0};
+	FontParseGlyphResolver resolver = {0}; // 初めのcomposite glyphで作り、部品の展開結果をglyph間で共有する
+	for(size_t glyphId = glyphFirst; glyphId <= glyphLast && glyphId < maxpTable_Host_numGlyphs; glyphId++){
+		uint32_t offset;
+		uint32_t nextOffset;
+		const FontParseError locaError = FontParseLocaView_entry(&loca, glyphId, glyf.size, &offset, &nextOffset);
+		if(FontParseError_None != locaError){
+			FONT_ERROR_LOG("'loca' glyph %zu: 0x%08x - 0x%08x is not ascending or beyond 'glyf' size 0x%08zx",
+					glyphId, offset, nextOffset, glyf.size);
+			continue;
+		}
+		const FontParseError error = FontParser_glyph(glyf, offset, nextOffset, &glyph);
 
 		// *** GlyphDescription.Header
-		GlyphDescriptionHeader glyphDescriptionHeader;
-		COPYRANGE_OR_DIE(fd, (void *)&glyphDescriptionHeader, ntohl(tableDirectory_GlyfTable->offset) + offsetOnTable, sizeof(GlyphDescriptionHeader));
-
-		//DUMPUint16((uint16_t *)&glyphDescriptionHeader, sizeof(GlyphDescriptionHeader));
-
-		GlyphDescriptionHeader glyphDescriptionHeader_Host = {
-			.numberOfContours	= ntohs(glyphDescriptionHeader.numberOfContours		),
-			.xMin			= ntohs(glyphDescriptionHeader.xMin			),
-			.yMin			= ntohs(glyphDescriptionHeader.yMin			),
-			.xMax			= ntohs(glyphDescriptionHeader.xMax			),
-			.yMax			= ntohs(glyphDescriptionHeader.yMax			),
-		};
 		fprintf(stdout, "\n");
 		fprintf(stdout,
-			"Glyph %6d.\n"
+			"Glyph %6zu.\n"
 			"	 numberOfContours:	 %4d\n"
 			"	 xMin:			 %4d\n"
 			"	 yMin:			 %4d\n"
@@ -951,191 +921,69 @@ void glyfTable(
 			"	 yMax:			 %4d\n"
 			,
 			glyphId,
-			glyphDescriptionHeader_Host.numberOfContours	,
-			glyphDescriptionHeader_Host.xMin		,
-			glyphDescriptionHeader_Host.yMin		,
-			glyphDescriptionHeader_Host.xMax		,
-			glyphDescriptionHeader_Host.yMax		);
+			glyph.header.numberOfContours	,
+			glyph.header.xMin		,
+			glyph.header.yMin		,
+			glyph.header.xMax		,
+			glyph.header.yMax		);
 
-		if(0 == datasize){
+		if(FontParseError_None == error && 0 == glyph.dataSize){
 			fprintf(stdout, "	 skip datasize is zero.\n");
 			continue;
 		}
 
-		if(0 > glyphDescriptionHeader_Host.numberOfContours){
-			fprintf(stdout, "	 skip CompositeGlyphDescription not implement.\n"); //!< @todo not implement.
+		if(FontParseError_Unsupported == error){
+			if(NULL == resolver.outlines){
+				FontParseGlyphResolver_init(&resolver, parser, (int16_t)headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs);
+			}
+			glyfTable_Composite(glyf, offset, nextOffset, glyphId, &composite, &resolver);
 			continue;
 		}
 
-		//! @todo check GlyphDescription elemetns on memory data range.
-
-		uint8_t *gdata = ffmalloc(datasize);
-		COPYRANGE_OR_DIE(fd, gdata, ntohl(tableDirectory_GlyfTable->offset) + offsetOnTable, datasize);
-
-		//DUMPUint16((uint16_t *)gdata, sizeof(GlyphDescriptionHeader));
-		//DUMPUint16Ntohs((uint16_t *)gdata, datasize / 2);
-		//DUMP0(gdata, sizeof(GlyphDescriptionHeader));
-		//DUMP0(&gdata[sizeof(GlyphDescriptionHeader)], 16);
-
-		size_t pointNum = 0; //! @todo use flags from EndPoints?
-
-		size_t offsetInTable = 0;
+		if(FontParseError_None != error){
+			FONT_PARSE_ERROR_LOG(error, "glyph %zu: 0x%08x - 0x%08x", glyphId, offset, nextOffset);
+			continue;
+		}
 
 		// *** GlyphDescription.EndPoints
-		offsetInTable += sizeof(GlyphDescriptionHeader);
 		fprintf(stdout, "\n");
 		fprintf(stdout,
 			"	 EndPoints (%d)\n"
 			"	 ---------\n",
-			glyphDescriptionHeader_Host.numberOfContours
+			glyph.header.numberOfContours
 			);
-		for(int co = 0; co < glyphDescriptionHeader_Host.numberOfContours; co++){
-			ASSERTF(offsetInTable < ntohl(tableDirectory_GlyfTable->length),
-					"%d", ntohl(tableDirectory_GlyfTable->length));
-
-			uint16_t *p = (uint16_t *)&gdata[offsetInTable];
-			uint16_t endPtsOfContour = ntohs(*p);
-			fprintf(stdout, "	 %2d: %2d\n", co, endPtsOfContour);
-
-			pointNum = endPtsOfContour + 1;
-			offsetInTable += sizeof(uint16_t);
+		for(int co = 0; co < glyph.header.numberOfContours; co++){
+			fprintf(stdout, "	 %2d: %2d\n", co, glyph.endPtsOfContours[co]);
 		}
 
 		// *** GlyphDescription.LengthOfInstructions
-		uint16_t *p = (uint16_t *)&gdata[offsetInTable];
-		uint16_t v0 = *p;
-		uint16_t instructionLength = ntohs(v0);
 		fprintf(stdout, "\n");
-		fprintf(stdout, "	 Length of Instructions: %2d\n", instructionLength);
-
-		offsetInTable += sizeof(uint16_t);
-		for(int inst = 0; inst < instructionLength; inst++){
-			ASSERTF(offsetInTable < ntohl(tableDirectory_GlyfTable->length),
-					"%d", ntohl(tableDirectory_GlyfTable->length));
-
-			uint8_t instruction = gdata[offsetInTable];
-			fprintf(stdout, "	 Instruction[%02d]: 0x%02x\n", inst, instruction);
-			offsetInTable += sizeof(uint8_t);
+		fprintf(stdout, "	 Length of Instructions: %2d\n", (int)glyph.instructions.size);
+		for(int inst = 0; inst < glyph.instructions.size; inst++){
+			fprintf(stdout, "	 Instruction[%02d]: 0x%02x\n", inst, glyph.instructions.data[inst]);
 		}
 
-		GlyphDescriptionPoint *gpoints = ffmalloc(pointNum * sizeof(GlyphDescriptionPoint));
-
 		// *** GlyphDescription.Flags
+		const size_t pointNum = glyph.pointNum;
+		const FontParseGlyphPoint *gpoints = glyph.points;
 		fprintf(stdout, "\n");
 		fprintf(stdout,
 			"	 Flags (pointNum:%2zd)\n"
 			"	 -----\n",
 			pointNum);
-
-		for(int iflag = 0; iflag < pointNum; iflag++){
-			ASSERTF(offsetInTable < ntohl(tableDirectory_GlyfTable->length),
-					"%d", ntohl(tableDirectory_GlyfTable->length));
-
-			uint8_t flag = gdata[offsetInTable];
-			gpoints[iflag].flag = flag;
-			//fprintf(stdout, "	 flag %2d: %s 0x%02x\n", iflag, GlyphDescriptionFlag_ToPrintString(flag), flag);
-			if(0 != (flag & (1 << 3))){
-				offsetInTable += sizeof(uint8_t);
-				uint8_t repeatNum = gdata[offsetInTable];
-				for(int rep = 0; rep < repeatNum; rep++){
-					iflag++;
-					//offsetInTable += sizeof(uint8_t);
-					gpoints[iflag].isFlagRepeated = 1;
-					gpoints[iflag].flag = flag;
-					//fprintf(stdout, ">	 flag %2d: <repeated(%02d/%02d 0x%02x)>\n", iflag, rep, repeatNum, repeatNum);
-				}
-			}
-			offsetInTable += sizeof(uint8_t);
-		}
-
 		for(int iflag = 0; iflag < pointNum; iflag++){
 			bool isRepeated = (0 != gpoints[iflag].isFlagRepeated);
 			uint8_t flag = gpoints[iflag].flag;
+			char flagstring[128];
 			fprintf(stdout, "	 flag %2d: %s 0x%02x %s\n",
-					iflag, GlyphDescriptionFlag_ToPrintString(flag), flag, (isRepeated?"<repeated>":""));
+					iflag, GlyphDescriptionFlag_ToPrintString(flag, flagstring, sizeof(flagstring)), flag, (isRepeated?"<repeated>":""));
 		}
 
-		//DUMP0(&gdata[offsetInTable], 8);
-
 		// *** GlyphDescription.XYCoordinates
 		fprintf(stdout, "\n");
 		fprintf(stdout,
 			"	 Coordinates\n"
 			"	 -----------\n");
-		// xCoordinates
-		for(int xcor = 0; xcor < pointNum; xcor++){
-			uint8_t flag = gpoints[xcor].flag;
-			if((! GlyphFlag_IsXShortVector(flag)) && GlyphFlag_IsSameOrPisitiveXShortVector(flag)){
-				gpoints[xcor].isRelXSame = 1;
-				if(0 == xcor){
-					//! @note 先頭の場合はゼロ(FontForgeの生成したフォントファイルによるとありうるらしい。)
-					continue;
-				}
-				gpoints[xcor].raw.x = 0; //gpoints[xcor - 1].raw.x;
-				gpoints[xcor].rel.x = 0; //gpoints[xcor - 1].rel.x;
-				gpoints[xcor].abs.x = gpoints[xcor - 1].abs.x;
-			}else{
-				uint16_t raw;
-				int16_t rel;
-				if(GlyphFlag_IsXShortVector(flag)){
-					raw = *(uint8_t *)(&gdata[offsetInTable]);
-					rel = raw;
-					offsetInTable += sizeof(uint8_t);
-				}else{
-					raw = ntohs(*(uint16_t *)(&gdata[offsetInTable]));
-					rel = CONVERT_INT_FROM_UINT16T(raw);
-					rel *= -1; //!< @todo 正直ttfdump合わせでよくわかってない
-					offsetInTable += sizeof(uint16_t);
-				}
-				if(GlyphFlag_IsXShortVector(flag) && GlyphFlag_IsSameOrPisitiveXShortVector(flag)){
-					rel *= +1;
-				}else{
-					rel *= -1;
-				}
-				int prev = (0 == xcor)? 0:gpoints[xcor - 1].abs.x;
-				gpoints[xcor].raw.x = raw;
-				gpoints[xcor].rel.x = rel;
-				gpoints[xcor].abs.x = prev + rel;
-			}
-		}
-
-		// yCoordinates
-		for(int ycor = 0; ycor < pointNum; ycor++){
-			uint8_t flag = gpoints[ycor].flag;
-			if((! GlyphFlag_IsYShortVector(flag)) && GlyphFlag_IsSameOrPisitiveYShortVector(flag)){
-				gpoints[ycor].isRelYSame = 1;
-				if(0 == ycor){
-					continue;
-				}
-				gpoints[ycor].raw.y = 0; //gpoints[ycor - 1].raw.y;
-				gpoints[ycor].rel.y = 0; //gpoints[ycor - 1].rel.y;
-				gpoints[ycor].abs.y = gpoints[ycor - 1].abs.y;
-			}else{
-				uint16_t raw;
-				int16_t rel;
-				if(GlyphFlag_IsYShortVector(flag)){
-					raw = *(uint8_t *)(&gdata[offsetInTable]);
-					rel = raw;
-					offsetInTable += sizeof(uint8_t);
-				}else{
-					raw = ntohs(*(uint16_t *)(&gdata[offsetInTable]));
-					rel = CONVERT_INT_FROM_UINT16T(raw);
-					rel *= -1; //!< @todo 正直ttfdump合わせでよくわかってない
-					offsetInTable += sizeof(uint16_t);
-				}
-				if(GlyphFlag_IsYShortVector(flag) && GlyphFlag_IsSameOrPisitiveYShortVector(flag)){
-					rel *= +1;
-				}else{
-					rel *= -1;
-				}
-				int prev = (0 == ycor)? 0:gpoints[ycor - 1].abs.y;
-				gpoints[ycor].raw.y = raw;
-				gpoints[ycor].rel.y = rel;
-				gpoints[ycor].abs.y = prev + rel;
-			}
-		}
-
-		// print
 		for(int cor = 0; cor < pointNum; cor++){
 			uint8_t flag = gpoints[cor].flag;
 			fprintf(stdout,
@@ -1157,117 +1005,1488 @@ void glyfTable(
 				);
 		}
 	}
+	FontParseGlyphResolver_free(&resolver);
+	FontParseComposite_free(&composite);
+	FontParseGlyph_free(&glyph);
 }
+// ** 'fvar', 'gvar' Table (variable font)
 
+double F2Dot14Type_ToDouble(uint16_t value)
+{
+	return (double)CONVERT_INT_FROM_UINT16T((int16_t)value) / 16384.0;
+}
 
-int main(int argc, char **argv)
+double FixedType_ToDouble(uint32_t value)
 {
-	/**
-	第1引数でフォントファイル名を指定する
-	*/
-	if(argc < 2){
-		exit(1);
-	}
-	const char *fontfilepath = argv[1];
+	return (double)(int32_t)value / 65536.0;
+}
 
-	// ** 引数：Table指定
-	if(argc >= 3){
-		if(0 == strcmp("-t", argv[2])){
-			if(! (argc >= 4)){
-				ERROR_LOG("invalid table name");
-				exit(1);
-			}
-			if(4 != strlen(argv[3])){
-				ERROR_LOG("invalid table name");
-				exit(1);
-			}
-			strcpy(arg.tablename, argv[3]);
-		}else if(0 == strcmp("--strict", argv[2])){
-			arg.strictMode = FFStrictMode_ALL;
-		}else{
-			ERROR_LOG("invalid args");
-			exit(1);
-		}
+//! @return Tableの範囲を指すポインタ(コピーしない)。NULL: Tableが無い
+const uint8_t *readTableOrNull(const FontParser *parser, const char *tagstring, size_t *pSize)
+{
+	FontSpan table;
+	const FontParseError error = FontParser_table(parser, tagstring, &table);
+	if(FontParseError_NotFound == error){
+		return NULL;
 	}
-
-	int fd = open(fontfilepath, O_RDONLY, 0777);
-	if(-1 == fd){
-		fprintf(stderr, "open: %d %s\n", errno, strerror(errno));
-		exit(1);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "'%s'", tagstring);
+		return NULL;
 	}
+	*pSize = table.size;
+	return table.data;
+}
 
-	// ** OffsetTable
-	OffsetTable offsetTable;
-	ssize_t ssize;
-	ssize = read(fd, (void *)&offsetTable, sizeof(offsetTable));
-	if(ssize != sizeof(offsetTable)){
-		fprintf(stderr, "read: %zd %d %s\n", ssize, errno, strerror(errno));
-		exit(1);
+void fvarTable(const FontParser *parser, size_t *pAxisCount)
+{
+	size_t size;
+	const uint8_t *data = readTableOrNull(parser, "fvar", &size);
+	if(NULL == data){
+		return;
 	}
-	offsetTable.sfntVersion		= ntohl(offsetTable.sfntVersion);
-	offsetTable.numTables		= ntohs(offsetTable.numTables);
-
-	const char *sfntversionstr = OffsetTable_SfntVersion_ToPrintString(offsetTable.sfntVersion);
+	FontSpanReader reader = {data, size, 0, false};
 
+	fprintf(stdout, "\n");
 	fprintf(stdout,
-			"Font File Dumper: v %s\n"
-			"project daisy bell 2019\n"
-			"Dumping File:%s\n"
-			"\n"
-			"\n"
-			"Offset Table\n"
-			"------------\n"
-			"	 sfnt version: 		%s\n"
-			"	 number of tables:%3d\n",
-			//FULL_VERSION,
-			SHOW_VERSION,
-			fontfilepath,
-			sfntversionstr,
-			offsetTable.numTables);
-
-	size_t numTables = offsetTable.numTables; // use TableDirectory
+		"'fvar' Table - Font Variations\n"
+		"------------------------------\n");
+	const uint16_t majorVersion		= FontSpanReader_uint16(&reader);
+	const uint16_t minorVersion		= FontSpanReader_uint16(&reader);
+	const uint16_t axesArrayOffset		= FontSpanReader_uint16(&reader);
+	FontSpanReader_uint16(&reader); // reserved
+	const uint16_t axisCount		= FontSpanReader_uint16(&reader);
+	const uint16_t axisSize			= FontSpanReader_uint16(&reader);
+	const uint16_t instanceCount		= FontSpanReader_uint16(&reader);
+	const uint16_t instanceSize		= FontSpanReader_uint16(&reader);
+	fprintf(stdout,
+		"	 version:		 %d.%d\n"
+		"	 axisCount:		 %d\n"
+		"	 instanceCount:		 %d\n",
+		majorVersion, minorVersion, axisCount, instanceCount);
+	if(20 != axisSize || (4 + 4 * axisCount) > instanceSize){
+		FONT_ERROR_LOG("invalid axisSize:%d instanceSize:%d", axisSize, instanceSize);
+	}
 
-	// ** TableDirectory
-	TableDirectory_Member *tableDirectory = NULL;
-	readTableDirectory(&tableDirectory, numTables, fd);
-
-	// ** table指定jump
-	if(0 == strlen(arg.tablename)){
-		// NOP // table not selected
-	}else if(0 == strcmp("cmap", arg.tablename)){
-		goto CmapTable;
-	}else{
-		ERROR_LOG("invalid table name");
-		exit(1);
+	reader.offset = axesArrayOffset;
+	for(int a = 0; a < axisCount; a++){
+		const uint32_t tag		= FontSpanReader_uint32(&reader);
+		const uint32_t minValue		= FontSpanReader_uint32(&reader);
+		const uint32_t defaultValue	= FontSpanReader_uint32(&reader);
+		const uint32_t maxValue		= FontSpanReader_uint32(&reader);
+		FontSpanReader_uint16(&reader); // flags
+		const uint16_t axisNameID	= FontSpanReader_uint16(&reader);
+		fprintf(stdout, "	 Axis %2d. '%s' min %9.3f default %9.3f max %9.3f nameID %d\n",
+				a, TagType_ToPrintString(tag),
+				FixedType_ToDouble(minValue), FixedType_ToDouble(defaultValue), FixedType_ToDouble(maxValue),
+				axisNameID);
+		if(FixedType_ToDouble(maxValue) < FixedType_ToDouble(defaultValue)
+				|| FixedType_ToDouble(defaultValue) < FixedType_ToDouble(minValue)){
+			FONT_ERROR_LOG("axis %d: invalid range", a);
+		}
+	}
+	for(int i = 0; i < instanceCount; i++){
+		reader.offset = axesArrayOffset + (axisSize * axisCount) + (instanceSize * i);
+		const uint16_t subfamilyNameID	= FontSpanReader_uint16(&reader);
+		FontSpanReader_uint16(&reader); // flags
+		fprintf(stdout, "	 Instance %2d. nameID %d (", i, subfamilyNameID);
+		for(int a = 0; a < axisCount; a++){
+			fprintf(stdout, "%s%.3f", ((0 == a)? "":", "), FixedType_ToDouble(FontSpanReader_uint32(&reader)));
+		}
+		fprintf(stdout, ")\n");
+	}
+	if(reader.isOverrun){
+		FONT_ERROR_LOG("'fvar' Table overrun");
 	}
 
-	// ** Tables
-	uint16_t headTable_Host_indexToLocFormat = 0; // use LocaTable from HeadTable member
+	*pAxisCount = axisCount;
+}
 
-	headTable(tableDirectory, numTables, fd, &headTable_Host_indexToLocFormat);
+//! @brief 'gvar'の出力に必要なaxisCountだけを読む(出力しない)
+size_t fvarTable_AxisCount(const FontParser *parser)
+{
+	size_t size;
+	const uint8_t *data = readTableOrNull(parser, "fvar", &size);
+	if(NULL == data){
+		return 0;
+	}
+	FontSpanReader reader = {data, size, 8, false};
+	const uint16_t axisCount = FontSpanReader_uint16(&reader);
+	return reader.isOverrun ? 0 : axisCount;
+}
 
-	size_t maxpTable_Host_numGlyphs = 0; // use LocaTable from MaxpTable member
+//! @return glyphの点数(phantom pointを除く)。空・composite glyphは0
+size_t glyfTable_PointNum(const FontParser *parser, uint16_t headTable_Host_indexToLocFormat, size_t maxpTable_Host_numGlyphs, int glyphId)
+{
+	FontSpan glyf;
+	uint32_t offset;
+	uint32_t nextOffset;
+	if(FontParseError_None != FontParser_table(parser, "glyf", &glyf)
+			|| FontParseError_None != FontParser_locaEntry(parser, (int16_t)headTable_Host_indexToLocFormat,
+				maxpTable_Host_numGlyphs, glyphId, &offset, &nextOffset)){
+		return 0;
+	}
+	size_t pointNum;
+	const FontParseError error = FontParser_glyphPointNum(glyf, offset, nextOffset, &pointNum);
+	if(FontParseError_None != error){
+		FONT_PARSE_ERROR_LOG(error, "glyph %d", glyphId);
+	}
+	return pointNum;
+}
+
+//! @brief numより小さい場合だけ広げる(glyph・tuple間で使い回す)
+void *gvarTable_Reserve(void *buffer, size_t *capacity, size_t num, size_t elementSize)
+{
+	if(*capacity < num){
+		buffer = ffrealloc(buffer, elementSize * num);
+		*capacity = num;
+	}
+	return buffer;
+}
+
+/** @brief packed point numbersを*pBufferへ読む
+  @param pPointNumbers NULL(全点)または*pBuffer
+  @return 点数。全点の場合はallPointNum
+  */
+size_t gvarTable_ReadPointNumbers(FontSpanReader *reader, size_t allPointNum,
+		uint16_t **pBuffer, size_t *pCapacity, const uint16_t **pPointNumbers)
+{
+	size_t count = FontSpanReader_uint8(reader);
+	if(0 != (count & 0x80)){
+		count = ((count & 0x7f) << 8) | FontSpanReader_uint8(reader);
+	}
+	if(0 == count){
+		*pPointNumbers = NULL;
+		return allPointNum;
+	}
+	uint16_t *pointNumbers = *pBuffer = (uint16_t *)gvarTable_Reserve(*pBuffer, pCapacity, count, sizeof(uint16_t));
+	uint16_t pointNumber = 0;
+	for(size_t i = 0; i < count && (! reader->isOverrun); ){
+		const uint8_t control = FontSpanReader_uint8(reader);
+		const size_t runCount = (control & 0x7f) + 1;
+		for(size_t r = 0; r < runCount && i < count; r++, i++){
+			pointNumber += (0 != (control & 0x80))? FontSpanReader_uint16(reader) : FontSpanReader_uint8(reader);
+			pointNumbers[i] = pointNumber;
+		}
+	}
+	*pPointNumbers = pointNumbers;
+	return count;
+}
+
+void gvarTable_ReadDeltas(FontSpanReader *reader, int16_t *deltas, size_t count)
+{
+	for(size_t i = 0; i < count && (! reader->isOverrun); ){
+		const uint8_t control = FontSpanReader_uint8(reader);
+		const size_t runCount = (control & 0x3f) + 1;
+		for(size_t r = 0; r < runCount && i < count; r++, i++){
+			if(0 != (control & 0x80)){
+				deltas[i] = 0;
+			}else if(0 != (control & 0x40)){
+				deltas[i] = (int16_t)FontSpanReader_uint16(reader);
+			}else{
+				deltas[i] = (int8_t)FontSpanReader_uint8(reader);
+			}
+		}
+	}
+}
+
+//! @param glyphFirst, glyphLast 出力するglyphIdの範囲
+void gvarTable(
+		const FontParser *parser,
+		size_t fvarTable_Host_axisCount,
+		uint16_t headTable_Host_indexToLocFormat,
+		size_t maxpTable_Host_numGlyphs,
+		size_t glyphFirst,
+		size_t glyphLast)
+{
+	size_t size;
+	const uint8_t *data = readTableOrNull(parser, "gvar", &size);
+	if(NULL == data){
+		return;
+	}
+	FontSpanReader reader = {data, size, 0, false};
+
+	fprintf(stdout, "\n");
+	fprintf(stdout,
+		"'gvar' Table - Glyph Variations\n"
+		"-------------------------------\n");
+	const uint16_t majorVersion			= FontSpanReader_uint16(&reader);
+	const uint16_t minorVersion			= FontSpanReader_uint16(&reader);
+	const uint16_t axisCount			= FontSpanReader_uint16(&reader);
+	const uint16_t sharedTupleCount			= FontSpanReader_uint16(&reader);
+	const uint32_t sharedTuplesOffset		= FontSpanReader_uint32(&reader);
+	const uint16_t glyphCount			= FontSpanReader_uint16(&reader);
+	const uint16_t flags				= FontSpanReader_uint16(&reader);
+	const uint32_t glyphVariationDataArrayOffset	= FontSpanReader_uint32(&reader);
+	fprintf(stdout,
+		"	 version:		 %d.%d\n"
+		"	 axisCount:		 %d\n"
+		"	 sharedTupleCount:	 %d\n"
+		"	 glyphCount:		 %d\n"
+		"	 flags:			 0x%04x\n",
+		majorVersion, minorVersion, axisCount, sharedTupleCount, glyphCount, flags);
+	if(axisCount != fvarTable_Host_axisCount){
+		FONT_ERROR_LOG("axisCount:%d != 'fvar' axisCount:%zu", axisCount, fvarTable_Host_axisCount);
+	}
+	if(glyphCount != maxpTable_Host_numGlyphs){
+		FONT_ERROR_LOG("glyphCount:%d != numGlyphs:%zu", glyphCount, maxpTable_Host_numGlyphs);
+	}
+
+	const bool isLongOffset = (0 != (flags & 0x1));
+	uint32_t *glyphOffsets = ffmalloc(sizeof(uint32_t) * (glyphCount + 1));
+	for(int g = 0; g < glyphCount + 1; g++){
+		glyphOffsets[g] = isLongOffset? FontSpanReader_uint32(&reader) : (uint32_t)FontSpanReader_uint16(&reader) * 2;
+	}
+
+	uint16_t *sharedTuples = ffmalloc(sizeof(uint16_t) * (sharedTupleCount * axisCount + 1));
+	reader.offset = sharedTuplesOffset;
+	for(int t = 0; t < sharedTupleCount; t++){
+		fprintf(stdout, "	 SharedTuple %3d. (", t);
+		for(int a = 0; a < axisCount; a++){
+			sharedTuples[t * axisCount + a] = FontSpanReader_uint16(&reader);
+			fprintf(stdout, "%s%.4f", ((0 == a)? "":", "), F2Dot14Type_ToDouble(sharedTuples[t * axisCount + a]));
+		}
+		fprintf(stdout, ")\n");
+	}
+
+	// glyph・tuple間で使い回す作業領域(glyph数によらず最大のglyphの大きさで止まる)
+	uint16_t *sharedPointBuffer = NULL;
+	size_t sharedPointCapacity = 0;
+	uint16_t *pointBuffer = NULL;
+	size_t pointCapacity = 0;
+	int16_t *deltas = NULL;
+	size_t deltaCapacity = 0;
+	uint16_t *tupleCoords = (uint16_t *)ffmalloc(sizeof(uint16_t) * (axisCount * 3 + 1)); // peak, start, end
+	uint16_t *peak = &tupleCoords[0];
+	uint16_t *intermediate[2] = {&tupleCoords[axisCount], &tupleCoords[axisCount * 2]};
+
+	for(int glyphId = 0; glyphId < glyphCount && (! reader.isOverrun); glyphId++){
+		if((size_t)glyphId < glyphFirst || glyphLast < (size_t)glyphId){
+			continue;
+		}
+		if(glyphOffsets[glyphId + 1] < glyphOffsets[glyphId]){
+			FONT_ERROR_LOG("glyph %d: offsets are not ascending", glyphId);
+			break;
+		}
+		if(glyphOffsets[glyphId + 1] == glyphOffsets[glyphId]){
+			continue;
+		}
+		const size_t dataBegin = glyphVariationDataArrayOffset + glyphOffsets[glyphId];
+		const size_t allPointNum = ((glyphId < maxpTable_Host_numGlyphs)?
+				glyfTable_PointNum(parser, headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs, glyphId) : 0) + 4; // + phantom points
+		reader.offset = dataBegin;
+		const uint16_t tupleVariationCount	= FontSpanReader_uint16(&reader);
+		const uint16_t dataOffset		= FontSpanReader_uint16(&reader);
+		const size_t tupleCount = tupleVariationCount & 0x0fff;
+		fprintf(stdout, "\n");
+		fprintf(stdout, "Glyph %6d. tupleVariationCount: 0x%04x, points: %zu\n", glyphId, tupleVariationCount, allPointNum);
+
+		// serialized dataの先頭(shared point numbers)
+		FontSpanReader dataReader = {data, dataBegin + (glyphOffsets[glyphId + 1] - glyphOffsets[glyphId]), dataBegin + dataOffset, false};
+		if(size < dataReader.size){
+			FONT_ERROR_LOG("glyph %d: data overrun", glyphId);
+			break;
+		}
+		const uint16_t *sharedPointNumbers = NULL;
+		size_t sharedPointCount = allPointNum;
+		if(0 != (tupleVariationCount & 0x8000)){
+			sharedPointCount = gvarTable_ReadPointNumbers(&dataReader, allPointNum,
+					&sharedPointBuffer, &sharedPointCapacity, &sharedPointNumbers);
+		}
+
+		for(size_t t = 0; t < tupleCount; t++){
+			const uint16_t variationDataSize	= FontSpanReader_uint16(&reader);
+			const uint16_t tupleIndex		= FontSpanReader_uint16(&reader);
+			for(int a = 0; a < axisCount; a++){
+				peak[a] = (0 != (tupleIndex & 0x8000))?
+					FontSpanReader_uint16(&reader) : sharedTuples[(tupleIndex & 0x0fff) * axisCount + a];
+			}
+			if(0 == (tupleIndex & 0x8000) && sharedTupleCount <= (tupleIndex & 0x0fff)){
+				FONT_ERROR_LOG("glyph %d: invalid shared tuple index %d", glyphId, tupleIndex & 0x0fff);
+				break;
+			}
+			for(int i = 0; i < 2; i++){
+				for(int a = 0; a < axisCount; a++){
+					intermediate[i][a] = (0 != (tupleIndex & 0x4000))? FontSpanReader_uint16(&reader) : 0;
+				}
+			}
+
+			fprintf(stdout, "	 Tuple %2zu. size %4d peak (", t, variationDataSize);
+			for(int a = 0; a < axisCount; a++){
+				fprintf(stdout, "%s%.4f", ((0 == a)? "":", "), F2Dot14Type_ToDouble(peak[a]));
+			}
+			fprintf(stdout, ")");
+			if(0 != (tupleIndex & 0x4000)){
+				for(int i = 0; i < 2; i++){
+					fprintf(stdout, " %s (", ((0 == i)? "start":"end"));
+					for(int a = 0; a < axisCount; a++){
+						fprintf(stdout, "%s%.4f", ((0 == a)? "":", "), F2Dot14Type_ToDouble(intermediate[i][a]));
+					}
+					fprintf(stdout, ")");
+				}
+			}
+			fprintf(stdout, "\n");
+
+			const size_t tupleDataBegin = dataReader.offset;
+			const uint16_t *pointNumbers = sharedPointNumbers;
+			size_t pointCount = sharedPointCount;
+			if(0 != (tupleIndex & 0x2000)){
+				pointCount = gvarTable_ReadPointNumbers(&dataReader, allPointNum, &pointBuffer, &pointCapacity, &pointNumbers);
+			}
+			deltas = (int16_t *)gvarTable_Reserve(deltas, &deltaCapacity, pointCount * 2 + 1, sizeof(int16_t));
+			gvarTable_ReadDeltas(&dataReader, &deltas[0], pointCount);
+			gvarTable_ReadDeltas(&dataReader, &deltas[pointCount], pointCount);
+			for(size_t i = 0; i < pointCount; i++){
+				const size_t pointNumber = (NULL == pointNumbers)? i : pointNumbers[i];
+				fprintf(stdout, "	 	 %3zu%s delta ( %6d, %6d)\n",
+						pointNumber, ((allPointNum - 4 <= pointNumber)? "p":" "),
+						deltas[i], deltas[pointCount + i]);
+			}
+			if(dataReader.offset - tupleDataBegin != variationDataSize){
+				FONT_ERROR_LOG("glyph %d tuple %zu: variationDataSize %d != %zu",
+						glyphId, t, variationDataSize, dataReader.offset - tupleDataBegin);
+			}
+		}
+		if(dataReader.isOverrun){
+			FONT_ERROR_LOG("glyph %d: data overrun", glyphId);
+		}
+	}
+	if(reader.isOverrun){
+		FONT_ERROR_LOG("'gvar' Table overrun");
+	}
+
+	free(tupleCoords);
+	free(deltas);
+	free(pointBuffer);
+	free(sharedPointBuffer);
+	free(sharedTuples);
+	free(glyphOffsets);
+}
+
+/** @brief glyphをppemで描画してPGMへ書き出す(Tableの出力はしない)
+  */
+void renderGlyph(
+		const FontParser *parser,
+		long glyphId,
+		double ppem,
+		const char *filepath)
+{
+	HeadTable headTable;
+	MaxpTable_Version05 maxpTable;
+	FontParseError error = FontParser_head(parser, &headTable);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxpTable);
+	}
+	if(FontParseError_None != error){
+		FONT_ERROR_LOG("render: 'head', 'maxp', 'loca', 'glyf' Table required. %s", FontParseError_toString(error));
+		exit(1);
+	}
+	if(! (0 <= glyphId && glyphId < maxpTable.numGlyphs)){
+		ERROR_LOG("render: glyphId %ld out of range (numGlyphs %d)", glyphId, maxpTable.numGlyphs);
+		exit(1);
+	}
+
+	// composite glyphは部品を展開したoutlineを描画する
+	FontParseGlyphResolver resolver;
+	error = FontParseGlyphResolver_init(&resolver, parser, headTable.indexToLocFormat, maxpTable.numGlyphs);
+	if(FontParseError_None != error){
+		FONT_ERROR_LOG("render: 'head', 'maxp', 'loca', 'glyf' Table required. %s", FontParseError_toString(error));
+		exit(1);
+	}
+	const FontParseOutline *outline;
+	error = FontParseGlyphResolver_outline(&resolver, (size_t)glyphId, &outline);
+	if(FontParseError_None != error){
+		FONT_ERROR_LOG("render: glyph %ld: %s", glyphId, FontParseError_toString(error));
+		exit(1);
+	}
+
+	GlyphRaster raster = {0};
+	if(! GlyphRaster_renderOutline(&raster, outline, ppem, headTable.unitsPerEm)){
+		FONT_ERROR_LOG("render: glyph %ld: invalid unitsPerEm %u", glyphId, headTable.unitsPerEm);
+		exit(1);
+	}
+	if(! GlyphRaster_writePgm(&raster, filepath)){
+		ERROR_LOG("render: `%s` %d %s", filepath, errno, strerror(errno));
+		exit(1);
+	}
+	fprintf(stdout, "\nrender glyph %ld at %.1f ppem: %zux%zu -> %s\n", glyphId, ppem, raster.width, raster.height, filepath);
+
+	GlyphRaster_free(&raster);
+	FontParseGlyphResolver_free(&resolver);
+}
+
+/** @brief "U+0020-U+007E,U+3042"形式のcodepoint範囲を展開する(重複は除かない)
+  @return false: 書式不正
+  */
+bool parseCodepointRanges(const char *text, uint32_t **codepoints, size_t *codepointNum)
+{
+	*codepoints = NULL;
+	*codepointNum = 0;
+	const char *p = text;
+	while(true){
+		uint32_t range[2];
+		for(int i = 0; i < 2; i++){
+			if(0 == strncmp("U+", p, 2) || 0 == strncmp("u+", p, 2) || 0 == strncmp("0x", p, 2)){
+				p += 2;
+			}
+			char *end;
+			const unsigned long value = strtoul(p, &end, 16);
+			if(end == p || 0x10FFFF < value){
+				free(*codepoints);
+				return false;
+			}
+			range[i] = (uint32_t)value;
+			p = end;
+			if(0 == i){
+				if('-' != *p){
+					range[1] = range[0];
+					break;
+				}
+				p++;
+			}
+		}
+		if(range[1] < range[0]){
+			free(*codepoints);
+			return false;
+		}
+		const size_t num = (size_t)(range[1] - range[0]) + 1;
+		*codepoints = (uint32_t *)ffrealloc(*codepoints, sizeof(uint32_t) * (*codepointNum + num));
+		for(size_t i = 0; i < num; i++){
+			(*codepoints)[(*codepointNum)++] = range[0] + (uint32_t)i;
+		}
+		if('\0' == *p){
+			return true;
+		}
+		if(',' != *p){
+			free(*codepoints);
+			return false;
+		}
+		p++;
+	}
+}
+
+/** @brief codepoint範囲のglyphのSDFを並列に計算し、atlas(OUTBASE.pgm)とmetrics(OUTBASE.json)を書き出す
+  */
+void sdfAtlas(const FontParser *parser, const char *ranges, double ppem, double spread, const char *outBase)
+{
+	uint32_t *codepoints;
+	size_t codepointNum;
+	if(! parseCodepointRanges(ranges, &codepoints, &codepointNum)){
+		ERROR_LOG("sdf-atlas: invalid codepoint ranges `%s`", ranges);
+		exit(1);
+	}
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	HheaTable hhea;
+	FontParseError error = FontParser_head(parser, &head);
+	if(FontParseError_None == error){
+		error = FontParser_maxp(parser, &maxp);
+	}
+	if(FontParseError_None == error){
+		error = FontParser_hhea(parser, &hhea);
+	}
+	if(FontParseError_None != error){
+		FONT_ERROR_LOG("sdf-atlas: 'head', 'maxp', 'hhea' Table required. %s", FontParseError_toString(error));
+		exit(1);
+	}
+	// 割り当てはUnicodeのsubtable(無い場合は全て割り当て無し)
+	CmapPageTable cmapPageTable;
+	FontParseCmap cmap;
+	FontSpan subtable = {NULL, 0};
+	if(FontParseError_None == FontParser_cmap(parser, &cmap)){
+		FontParseCmap_unicodeSubtable(&cmap, &subtable);
+	}
+	if(NULL != subtable.data){
+		CmapPageTable_build(&cmapPageTable, subtable, maxp.numGlyphs);
+	}else{
+		CmapPageTable_init(&cmapPageTable, maxp.numGlyphs);
+	}
+	FontParseCmap_free(&cmap);
+
+	// ** codepoint -> glyph(同じglyphは1度だけ計算する)
+	uint16_t *glyphIdOfCodepoint = (uint16_t *)ffmalloc(sizeof(uint16_t) * (codepointNum + 1));
+	uint16_t *glyphIds = (uint16_t *)ffmalloc(sizeof(uint16_t) * (codepointNum + 1));
+	size_t glyphNum = 0;
+	size_t unmappedNum = 0;
+	uint8_t *isUsed = (uint8_t *)ffmalloc((size_t)maxp.numGlyphs + 1);
+	for(size_t i = 0; i < codepointNum; i++){
+		// 表はnumGlyphs以上のglyphIdを割り当て無しとする
+		const uint16_t glyphId = CmapPageTable_glyphId(&cmapPageTable, codepoints[i]);
+		glyphIdOfCodepoint[i] = glyphId;
+		if(0 == glyphId){
+			unmappedNum++;
+			continue;
+		}
+		if(! isUsed[glyphId]){
+			isUsed[glyphId] = 1;
+			glyphIds[glyphNum++] = glyphId;
+		}
+	}
+	free(isUsed);
+	if(0 < unmappedNum){
+		WARN_LOG("sdf-atlas: %zu codepoints not mapped (skipped)", unmappedNum);
+	}
+
+	long threadNum = sysconf(_SC_NPROCESSORS_ONLN);
+	GlyphSdfAtlas atlas;
+	if(! GlyphSdfAtlas_build(&atlas, parser, glyphIds, glyphNum, ppem, spread, (threadNum < 1)? 1 : (size_t)threadNum)){
+		for(size_t i = 0; i < atlas.glyphNum; i++){
+			if(! atlas.glyphs[i].isValid){
+				FONT_ERROR_LOG("sdf-atlas: glyph %u: invalid glyph", atlas.glyphs[i].glyphId);
+			}
+		}
+	}
 
-	maxpTable(tableDirectory, numTables, fd, &maxpTable_Host_numGlyphs);
+	// ** 出力
+	const size_t pathSize = strlen(outBase) + 8;
+	char *path = (char *)ffmalloc(pathSize);
+	snprintf(path, pathSize, "%s.pgm", outBase);
+	GlyphRaster image = {.width = atlas.width, .height = atlas.height, .pixels = atlas.pixels};
+	if(! GlyphRaster_writePgm(&image, path)){
+		ERROR_LOG("sdf-atlas: `%s` %d %s", path, errno, strerror(errno));
+		exit(1);
+	}
+	snprintf(path, pathSize, "%s.json", outBase);
+	FILE *file = fopen(path, "w");
+	if(NULL == file){
+		ERROR_LOG("sdf-atlas: `%s` %d %s", path, errno, strerror(errno));
+		exit(1);
+	}
+	fprintf(file, "{\"ppem\":%g,\"spread\":%g,\"unitsPerEm\":%u,\"ascender\":%d,\"descender\":%d,"
+			"\"width\":%zu,\"height\":%zu,\"glyphs\":[",
+			ppem, spread, head.unitsPerEm, hhea.ascender, hhea.descender, atlas.width, atlas.height);
+	bool isFirst = true;
+	for(size_t i = 0; i < codepointNum; i++){
+		const GlyphSdfAtlasGlyph *glyph = NULL;
+		for(size_t g = 0; g < atlas.glyphNum; g++){
+			if(atlas.glyphs[g].glyphId == glyphIdOfCodepoint[i] && atlas.glyphs[g].isValid){
+				glyph = &atlas.glyphs[g];
+				break;
+			}
+		}
+		if(NULL == glyph){
+			continue;
+		}
+		fprintf(file, "%s\n{\"codepoint\":%u,\"glyphId\":%u,\"advance\":%u,\"lsb\":%d,"
+				"\"x\":%zu,\"y\":%zu,\"w\":%zu,\"h\":%zu,\"bearingX\":%.3f,\"bearingY\":%.3f}",
+				isFirst? "" : ",",
+				codepoints[i], glyph->glyphId, glyph->advanceWidth, glyph->lsb,
+				glyph->atlasX, glyph->atlasY, glyph->width, glyph->height, glyph->bearingX, glyph->bearingY);
+		isFirst = false;
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	fprintf(stdout, "sdf-atlas %zu codepoints, %zu glyphs at %.1f ppem spread %.1f: %zux%zu -> %s.pgm, %s.json\n",
+			codepointNum, glyphNum, ppem, spread, atlas.width, atlas.height, outBase, outBase);
+
+	free(path);
+	GlyphSdfAtlas_free(&atlas);
+	free(glyphIds);
+	free(glyphIdOfCodepoint);
+	free(codepoints);
+	CmapPageTable_free(&cmapPageTable);
+}
 
-CmapTable:
-	cmapTable(tableDirectory, numTables, fd);
-	if(0 == strcmp("cmap", arg.tablename)){
+/** @brief UTF-8文字列の送り幅を計測して表示する
+  */
+void measureText(const FontParser *parser, const char *text)
+{
+	TextMeasure measure;
+	const FontParseError error = TextMeasure_init(&measure, parser);
+	if(FontParseError_None != error){
+		FONT_ERROR_LOG("measure: 'head', 'maxp', 'hhea', 'hmtx' Table required. %s", FontParseError_toString(error));
+		exit(1);
+	}
+
+	TextMeasureResult result;
+	if(! TextMeasure_measureUtf8(&measure, text, strlen(text), &result)){
+		ERROR_LOG("measure: invalid UTF-8 after %zu chars", result.charNum);
+		exit(1);
+	}
+	fprintf(stdout, "measure advance=%"PRIu64" chars=%zu unmapped=%zu units_per_em=%u\n",
+			result.advance, result.charNum, result.unmappedNum, measure.unitsPerEm);
+	TextMeasure_free(&measure);
+}
+
+// ** --json
+
+void dumpJson_tag_inline_(JsonWriter *writer, uint32_t tag)
+{
+	const char str[4] = {(char)(tag >> 24), (char)(tag >> 16), (char)(tag >> 8), (char)tag};
+	JsonWriter_stringN(writer, str, sizeof(str));
+}
+
+void dumpJson_error_inline_(JsonWriter *writer, const char *table, FontParseError error)
+{
+	JsonWriter_beginObject(writer);
+	JsonWriter_keyString(writer, "type", "error");
+	JsonWriter_keyString(writer, "table", table);
+	JsonWriter_keyString(writer, "error", FontParseError_toString(error));
+	JsonWriter_endObject(writer);
+	JsonWriter_endLine(writer);
+}
+
+//! @return 解析のエラーの数
+size_t dumpJson_cmap_inline_(JsonWriter *writer, const FontParser *parser)
+{
+	FontParseCmap cmap;
+	FontParseError error = FontParser_cmap(parser, &cmap);
+	if(FontParseError_None != error){
+		dumpJson_error_inline_(writer, "cmap", error);
+		FontParseCmap_free(&cmap);
+		return 1;
+	}
+	JsonWriter_beginObject(writer);
+	JsonWriter_keyString(writer, "type", "cmap");
+	JsonWriter_keyUint(writer, "version", cmap.header.version);
+	JsonWriter_keyUint(writer, "numTables", cmap.header.numTables);
+	JsonWriter_endObject(writer);
+	JsonWriter_endLine(writer);
+
+	size_t errorNum = 0;
+	for(size_t i = 0; i < cmap.header.numTables; i++){
+		const CmapTable_EncodingRecordElementHeader *record = &cmap.encodingRecords[i];
+		uint16_t format;
+		error = FontParseCmap_subtableFormat(&cmap, i, &format);
+		if(FontParseError_None != error){
+			dumpJson_error_inline_(writer, "cmap", error);
+			errorNum++;
+			continue;
+		}
+		FontSpan subtable;
+		FontSpan_sub(cmap.table, record->offset, cmap.table.size - record->offset, &subtable);
+		CmapPageTable table;
+		error = CmapPageTable_build(&table, subtable, UINT16_MAX);
+
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyString(writer, "type", "cmapSubtable");
+		JsonWriter_keyUint(writer, "index", i);
+		JsonWriter_keyUint(writer, "platformID", record->platformID);
+		JsonWriter_keyUint(writer, "encodingID", record->encodingID);
+		JsonWriter_keyUint(writer, "offset", record->offset);
+		JsonWriter_keyUint(writer, "format", format);
+		if(FontParseError_None == error){
+			// [[codepoint, glyphId], ...] 割り当てのあるpageだけを辿る
+			JsonWriter_key(writer, "mappings");
+			JsonWriter_beginArray(writer);
+			for(uint32_t page = 0; page < CmapPageTable_CODEPOINT_NUM / CmapPageTable_PAGE_SIZE; page++){
+				if(0 == table.pageIndexes[page]){
+					continue;
+				}
+				for(uint32_t c = page * CmapPageTable_PAGE_SIZE; c < (page + 1) * CmapPageTable_PAGE_SIZE; c++){
+					const uint16_t glyphId = CmapPageTable_glyphId(&table, c);
+					if(0 == glyphId){
+						continue;
+					}
+					JsonWriter_beginArray(writer);
+					JsonWriter_uint(writer, c);
+					JsonWriter_uint(writer, glyphId);
+					JsonWriter_endArray(writer);
+				}
+			}
+			JsonWriter_endArray(writer);
+		}else if(FontParseError_Unsupported != error){
+			JsonWriter_keyString(writer, "error", FontParseError_toString(error));
+			errorNum++;
+		}
+		JsonWriter_endObject(writer);
+		JsonWriter_endLine(writer);
+		CmapPageTable_free(&table);
+	}
+	FontParseCmap_free(&cmap);
+	return errorNum;
+}
+
+//! @return 解析のエラーの数
+size_t dumpJson_loca_inline_(JsonWriter *writer, const FontParser *parser, int16_t indexToLocFormat, uint16_t numGlyphs)
+{
+	FontParseLocaView loca;
+	const FontParseError error = FontParser_locaView(parser, indexToLocFormat, numGlyphs, &loca);
+	if(FontParseError_NotFound == error){
+		return 0;
+	}
+	if(FontParseError_None != error){
+		dumpJson_error_inline_(writer, "loca", error);
+		return 1;
+	}
+	JsonWriter_beginObject(writer);
+	JsonWriter_keyString(writer, "type", "loca");
+	JsonWriter_keyInt(writer, "indexToLocFormat", indexToLocFormat);
+	JsonWriter_key(writer, "offsets");
+	JsonWriter_beginArray(writer);
+	bool isAscending = true;
+	for(size_t i = 0; i < loca.num; i++){
+		const uint32_t offset = FontParseLocaView_offset(&loca, i);
+		isAscending = isAscending && (0 == i || FontParseLocaView_offset(&loca, i - 1) <= offset);
+		JsonWriter_uint(writer, offset);
+	}
+	JsonWriter_endArray(writer);
+	JsonWriter_keyBool(writer, "isAscending", isAscending);
+	JsonWriter_endObject(writer);
+	JsonWriter_endLine(writer);
+	if(! isAscending){
+		dumpJson_error_inline_(writer, "loca", FontParseError_InvalidValue);
+		return 1;
+	}
+	return 0;
+}
+
+/** @brief composite glyphの"components"と、部品を展開した"endPtsOfContours", "points"を書く
+  @return 解析のエラーの数
+  */
+size_t dumpJson_composite_inline_(JsonWriter *writer, FontSpan glyf, uint32_t offset, uint32_t nextOffset, size_t glyphId,
+		FontParseComposite *composite, FontParseGlyphResolver *resolver)
+{
+	FontParseError error = FontParser_compositeGlyph(glyf, offset, nextOffset, composite);
+	if(FontParseError_None != error){
+		JsonWriter_keyString(writer, "error", FontParseError_toString(error));
+		return 1;
+	}
+	JsonWriter_key(writer, "components");
+	JsonWriter_beginArray(writer);
+	for(size_t c = 0; c < composite->componentNum; c++){
+		const FontParseComponent *component = &composite->components[c];
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyUint(writer, "glyphId", component->glyphIndex);
+		JsonWriter_keyUint(writer, "flags", component->flags);
+		JsonWriter_keyInt(writer, "arg1", component->arg1);
+		JsonWriter_keyInt(writer, "arg2", component->arg2);
+		// F2Dot14は16384倍した整数で書く(浮動小数点の書式に依らない)
+		JsonWriter_key(writer, "transform");
+		JsonWriter_beginArray(writer);
+		for(int i = 0; i < 4; i++){
+			JsonWriter_int(writer, (int64_t)floor((component->scale[i] * 16384.0) + 0.5));
+		}
+		JsonWriter_endArray(writer);
+		JsonWriter_endObject(writer);
+	}
+	JsonWriter_endArray(writer);
+	JsonWriter_keyUint(writer, "instructionLength", composite->instructions.size);
+
+	const FontParseOutline *outline;
+	error = FontParseGlyphResolver_outline(resolver, glyphId, &outline);
+	if(FontParseError_None != error){
+		JsonWriter_keyString(writer, "error", FontParseError_toString(error));
+		return 1;
+	}
+	JsonWriter_key(writer, "endPtsOfContours");
+	JsonWriter_beginArray(writer);
+	for(size_t co = 0; co < outline->contourNum; co++){
+		JsonWriter_uint(writer, outline->endPts[co]);
+	}
+	JsonWriter_endArray(writer);
+	JsonWriter_key(writer, "points");
+	JsonWriter_beginArray(writer);
+	for(size_t i = 0; i < outline->pointNum; i++){
+		JsonWriter_beginArray(writer);
+		JsonWriter_int(writer, outline->points[i].x);
+		JsonWriter_int(writer, outline->points[i].y);
+		JsonWriter_uint(writer, outline->points[i].isOnCurve ? 1 : 0);
+		JsonWriter_endArray(writer);
+	}
+	JsonWriter_endArray(writer);
+	return 0;
+}
+
+//! @return 解析のエラーの数
+size_t dumpJson_glyf_inline_(JsonWriter *writer, const FontParser *parser, int16_t indexToLocFormat, uint16_t numGlyphs,
+		size_t glyphFirst, size_t glyphLast)
+{
+	FontSpan glyf;
+	FontParseError error = FontParser_table(parser, "glyf", &glyf);
+	if(FontParseError_NotFound == error){
+		return 0;
+	}
+	if(FontParseError_None != error){
+		dumpJson_error_inline_(writer, "glyf", error);
+		return 1;
+	}
+
+	FontParseLocaView loca;
+	error = FontParser_locaView(parser, indexToLocFormat, numGlyphs, &loca);
+	if(FontParseError_None != error){
+		dumpJson_error_inline_(writer, "loca", error);
+		return 1;
+	}
+	size_t errorNum = 0;
+	FontParseGlyph glyph = {0}; // glyph間で配列を使い回す
+	FontParseComposite composite = {0};
+	FontParseGlyphResolver resolver = {0};
+	for(size_t glyphId = glyphFirst; glyphId <= glyphLast && glyphId < numGlyphs; glyphId++){
+		uint32_t offset;
+		uint32_t nextOffset;
+		// 昇順でない・'glyf'の外の範囲はFontParser_glyph()がエラーにする
+		FontParseLocaView_entry(&loca, glyphId, glyf.size, &offset, &nextOffset);
+		error = FontParser_glyph(glyf, offset, nextOffset, &glyph);
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyString(writer, "type", "glyph");
+		JsonWriter_keyUint(writer, "glyphId", glyphId);
+		JsonWriter_keyUint(writer, "offset", offset);
+		JsonWriter_keyUint(writer, "length", glyph.dataSize);
+		if(FontParseError_None != error && FontParseError_Unsupported != error){
+			JsonWriter_keyString(writer, "error", FontParseError_toString(error));
+			errorNum++;
+		}else{
+			JsonWriter_keyInt(writer, "numberOfContours", glyph.header.numberOfContours);
+			JsonWriter_keyInt(writer, "xMin", glyph.header.xMin);
+			JsonWriter_keyInt(writer, "yMin", glyph.header.yMin);
+			JsonWriter_keyInt(writer, "xMax", glyph.header.xMax);
+			JsonWriter_keyInt(writer, "yMax", glyph.header.yMax);
+		}
+		if(FontParseError_Unsupported == error){
+			JsonWriter_keyBool(writer, "composite", true);
+			if(NULL == resolver.outlines){
+				FontParseGlyphResolver_init(&resolver, parser, indexToLocFormat, numGlyphs);
+			}
+			errorNum += dumpJson_composite_inline_(writer, glyf, offset, nextOffset, glyphId, &composite, &resolver);
+		}else if(FontParseError_None == error){
+			JsonWriter_key(writer, "endPtsOfContours");
+			JsonWriter_beginArray(writer);
+			for(int co = 0; co < glyph.header.numberOfContours; co++){
+				JsonWriter_uint(writer, glyph.endPtsOfContours[co]);
+			}
+			JsonWriter_endArray(writer);
+			JsonWriter_keyUint(writer, "instructionLength", glyph.instructions.size);
+			// [[x, y, onCurve], ...] 絶対座標
+			JsonWriter_key(writer, "points");
+			JsonWriter_beginArray(writer);
+			for(size_t i = 0; i < glyph.pointNum; i++){
+				JsonWriter_beginArray(writer);
+				JsonWriter_int(writer, glyph.points[i].abs.x);
+				JsonWriter_int(writer, glyph.points[i].abs.y);
+				JsonWriter_uint(writer, glyph.points[i].flag & 0x01);
+				JsonWriter_endArray(writer);
+			}
+			JsonWriter_endArray(writer);
+		}
+		JsonWriter_endObject(writer);
+		JsonWriter_endLine(writer);
+	}
+	FontParseGlyphResolver_free(&resolver);
+	FontParseComposite_free(&composite);
+	FontParseGlyph_free(&glyph);
+	return errorNum;
+}
+
+/** @brief Table毎・glyph毎に1行のJSON(NDJSON)を出力する。
+  解析のエラーは{"type":"error"}の行(またはrecordの"error")として出力し、続きを出力する。
+  @param tables 出力するTable(依存するTableは出力せずに読む)
+  @return 終了コード(解析のエラーがあれば1)
+  */
+int dumpJson(const FontParser *parser, const char *fontfilepath, DumpTable tables, size_t glyphFirst, size_t glyphLast)
+{
+	static JsonWriter writer_;
+	JsonWriter *writer = &writer_;
+	JsonWriter_init(writer, stdout);
+	size_t errorNum = 0;
+
+	// ** OffsetTable, TableDirectory
+	JsonWriter_beginObject(writer);
+	JsonWriter_keyString(writer, "type", "file");
+	JsonWriter_keyString(writer, "path", fontfilepath);
+	JsonWriter_keyUint(writer, "size", parser->file.size);
+	JsonWriter_keyUint(writer, "sfntVersion", parser->offsetTable.sfntVersion);
+	JsonWriter_keyUint(writer, "numTables", parser->offsetTable.numTables);
+	JsonWriter_endObject(writer);
+	JsonWriter_endLine(writer);
+	FontChecksumReport checksum;
+	FontChecksum_verify(parser, arg.threadNum, &checksum);
+	for(size_t i = 0; i < parser->offsetTable.numTables; i++){
+		const TableDirectory_Member *member = &parser->tableDirectory[i];
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyString(writer, "type", "table");
+		JsonWriter_key(writer, "tag");
+		dumpJson_tag_inline_(writer, member->tag);
+		JsonWriter_keyUint(writer, "checkSum", member->checkSum);
+		JsonWriter_keyUint(writer, "checkSumActual", checksum.tables[i].actual);
+		JsonWriter_keyBool(writer, "isCheckSumOk", (! checksum.tables[i].isOutOfRange) && member->checkSum == checksum.tables[i].actual);
+		JsonWriter_keyUint(writer, "offset", member->offset);
+		JsonWriter_keyUint(writer, "length", member->length);
+		JsonWriter_endObject(writer);
+		JsonWriter_endLine(writer);
+	}
+	JsonWriter_beginObject(writer);
+	JsonWriter_keyString(writer, "type", "checksum");
+	JsonWriter_keyBool(writer, "ok", FontChecksumReport_isOk(&checksum));
+	JsonWriter_keyUint(writer, "mismatchTables", checksum.mismatchNum);
+	if(checksum.isHeadFound){
+		JsonWriter_keyUint(writer, "checkSumAdjustment", checksum.storedAdjustment);
+		JsonWriter_keyUint(writer, "checkSumAdjustmentActual", checksum.actualAdjustment);
+	}
+	JsonWriter_endObject(writer);
+	JsonWriter_endLine(writer);
+	FontChecksumReport_free(&checksum);
+
+	// ** head, maxp
+	const bool isHeadNeeded = (0 != (tables & (DumpTable_HEAD | DumpTable_LOCA | DumpTable_GLYF)));
+	const bool isMaxpNeeded = (0 != (tables & (DumpTable_MAXP | DumpTable_LOCA | DumpTable_GLYF)));
+	HeadTable head = {0};
+	const FontParseError headError = isHeadNeeded ? FontParser_head(parser, &head) : FontParseError_None;
+	if(FontParseError_None != headError){
+		dumpJson_error_inline_(writer, "head", headError);
+		errorNum++;
+	}else if(0 != (tables & DumpTable_HEAD)){
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyString(writer, "type", "head");
+		JsonWriter_keyUint(writer, "majorVersion", head.majorVersion);
+		JsonWriter_keyUint(writer, "minorVersion", head.minorVersion);
+		JsonWriter_keyUint(writer, "fontRevision", head.fontRevision);
+		JsonWriter_keyUint(writer, "checkSumAdjustment", head.checkSumAdjustment);
+		JsonWriter_keyUint(writer, "magicNumber", head.magicNumber);
+		JsonWriter_keyUint(writer, "flags", head.flags);
+		JsonWriter_keyUint(writer, "unitsPerEm", head.unitsPerEm);
+		JsonWriter_keyInt(writer, "created", (int64_t)head.created);
+		JsonWriter_keyInt(writer, "modified", (int64_t)head.modified);
+		JsonWriter_keyInt(writer, "xMin", head.xMin);
+		JsonWriter_keyInt(writer, "yMin", head.yMin);
+		JsonWriter_keyInt(writer, "xMax", head.xMax);
+		JsonWriter_keyInt(writer, "yMax", head.yMax);
+		JsonWriter_keyUint(writer, "macStyle", head.macStyle);
+		JsonWriter_keyUint(writer, "lowestRecPPEM", head.lowestRecPPEM);
+		JsonWriter_keyInt(writer, "fontDirectionHint", head.fontDirectionHint);
+		JsonWriter_keyInt(writer, "indexToLocFormat", head.indexToLocFormat);
+		JsonWriter_keyInt(writer, "glyphDataFormat", head.glyphDataFormat);
+		JsonWriter_endObject(writer);
+		JsonWriter_endLine(writer);
+	}
+	MaxpTable_Version05 maxp = {0};
+	const FontParseError maxpError = isMaxpNeeded ? FontParser_maxp(parser, &maxp) : FontParseError_None;
+	if(FontParseError_None != maxpError){
+		dumpJson_error_inline_(writer, "maxp", maxpError);
+		errorNum++;
+	}else if(0 != (tables & DumpTable_MAXP)){
+		JsonWriter_beginObject(writer);
+		JsonWriter_keyString(writer, "type", "maxp");
+		JsonWriter_keyUint(writer, "version", maxp.version);
+		JsonWriter_keyUint(writer, "numGlyphs", maxp.numGlyphs);
+		JsonWriter_endObject(writer);
+		JsonWriter_endLine(writer);
+	}
+
+	// ** cmap, loca, glyf
+	if(0 != (tables & DumpTable_CMAP)){
+		errorNum += dumpJson_cmap_inline_(writer, parser);
+	}
+	if(FontParseError_None == headError && FontParseError_None == maxpError){
+		if(0 != (tables & DumpTable_LOCA)){
+			errorNum += dumpJson_loca_inline_(writer, parser, head.indexToLocFormat, maxp.numGlyphs);
+		}
+		if(0 != (tables & DumpTable_GLYF)){
+			errorNum += dumpJson_glyf_inline_(writer, parser, head.indexToLocFormat, maxp.numGlyphs, glyphFirst, glyphLast);
+		}
+	}
+
+	if(! JsonWriter_flush(writer)){
+		ERROR_LOG("write: %d %s", errno, strerror(errno));
+		return 1;
+	}
+	fflush(stdout);
+	return (0 == errorNum)? 0 : 1;
+}
+
+// ** --batch
+
+typedef struct{
+	char			**paths;
+	size_t			pathNum;
+	FontValidation		*validations;	//!< [pathNum]
+}BatchValidateContext;
+
+void batchValidate_addPath(BatchValidateContext *context, const char *path)
+{
+	char *dst = (char *)ffmalloc(strlen(path) + 1);
+	strcpy(dst, path);
+	context->paths = (char **)ffrealloc(context->paths, sizeof(char *) * (context->pathNum + 1));
+	context->paths[context->pathNum++] = dst;
+}
+
+bool batchValidate_isFontPath(const char *path)
+{
+	const char *ext = strrchr(path, '.');
+	if(NULL == ext){
+		return false;
+	}
+	const char *exts[] = {".otf", ".ttf", ".woff", ".woff2"};
+	for(size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++){
+		bool isMatch = (strlen(ext) == strlen(exts[i]));
+		for(size_t c = 0; isMatch && '\0' != exts[i][c]; c++){
+			isMatch = (tolower((unsigned char)ext[c]) == exts[i][c]);
+		}
+		if(isMatch){
+			return true;
+		}
+	}
+	return false;
+}
+
+//! @brief ディレクトリを再帰的に辿り、.otf/.ttf/.woff/.woff2を集める
+void batchValidate_scanDir(BatchValidateContext *context, const char *dirpath)
+{
+	DIR *dir = opendir(dirpath);
+	if(NULL == dir){
+		ERROR_LOG("opendir: `%s` %d %s", dirpath, errno, strerror(errno));
+		exit(1);
+	}
+	struct dirent *entry;
+	while(NULL != (entry = readdir(dir))){
+		if(0 == strcmp(".", entry->d_name) || 0 == strcmp("..", entry->d_name)){
+			continue;
+		}
+		const size_t pathSize = strlen(dirpath) + 1 + strlen(entry->d_name) + 1;
+		char *path = (char *)ffmalloc(pathSize);
+		snprintf(path, pathSize, "%s/%s", dirpath, entry->d_name);
+		struct stat st;
+		if(0 == stat(path, &st)){
+			if(S_ISDIR(st.st_mode)){
+				batchValidate_scanDir(context, path);
+			}else if(S_ISREG(st.st_mode) && batchValidate_isFontPath(path)){
+				batchValidate_addPath(context, path);
+			}
+		}
+		free(path);
+	}
+	closedir(dir);
+}
+
+//! @brief 1行1ファイルのリストを読む(空行と'#'で始まる行は飛ばす)
+void batchValidate_readList(BatchValidateContext *context, const char *listpath)
+{
+	FILE *fp = fopen(listpath, "r");
+	if(NULL == fp){
+		ERROR_LOG("fopen: `%s` %d %s", listpath, errno, strerror(errno));
+		exit(1);
+	}
+	char line[4096];
+	while(NULL != fgets(line, sizeof(line), fp)){
+		line[strcspn(line, "\r\n")] = '\0';
+		if('\0' == line[0] || '#' == line[0]){
+			continue;
+		}
+		batchValidate_addPath(context, line);
+	}
+	fclose(fp);
+}
+
+int batchValidate_comparePath(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+void batchValidate_task(void *context_, size_t index, size_t workerIndex)
+{
+	BatchValidateContext *context = (BatchValidateContext *)context_;
+	FontValidator_validateFile(context->paths[index], &context->validations[index]);
+}
+
+/** @brief 複数のフォントを並列に検査し、フォント毎の結果と集計を入力順に出力する。
+  フォントのエラーでは終了せず、全て検査し終えてから1つでも不正なら1を返す。
+  @param path ディレクトリ(再帰的に.otf/.ttf/.woff/.woff2を探す)またはファイルのリスト
+  @param threadNum 0: CPU数
+  */
+int batchValidate(const char *path, size_t threadNum)
+{
+	BatchValidateContext context = {0};
+	struct stat st;
+	if(0 != stat(path, &st)){
+		ERROR_LOG("stat: `%s` %d %s", path, errno, strerror(errno));
+		exit(1);
+	}
+	if(S_ISDIR(st.st_mode)){
+		batchValidate_scanDir(&context, path);
+		if(0 < context.pathNum){
+			qsort(context.paths, context.pathNum, sizeof(char *), batchValidate_comparePath);
+		}
+	}else{
+		batchValidate_readList(&context, path);
+	}
+
+	context.validations = (FontValidation *)ffmalloc(sizeof(FontValidation) * (context.pathNum + 1));
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	const size_t stealNum = WorkStealingPool_run(context.pathNum, threadNum, batchValidate_task, &context);
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	const double wallMs = ((double)(end.tv_sec - begin.tv_sec) * 1e3) + ((double)(end.tv_nsec - begin.tv_nsec) / 1e6);
+
+	// 結果は1度にまとめて書く(threadの完了順ではなく入力順)
+	FFByteArray out = {0};
+	char line[FontValidation_MESSAGE_SIZE + 4096 + 64];
+	size_t failedNum = 0;
+	double cpuMs = 0;
+	for(size_t i = 0; i < context.pathNum; i++){
+		const FontValidation *validation = &context.validations[i];
+		cpuMs += validation->elapsedMs;
+		int n;
+		if(0 == validation->errorNum){
+			n = snprintf(line, sizeof(line), "ok %.3f %s\n", validation->elapsedMs, context.paths[i]);
+		}else{
+			failedNum++;
+			n = snprintf(line, sizeof(line), "fail %.3f %s errors=%zu\n", validation->elapsedMs, context.paths[i], validation->errorNum);
+		}
+		FFByteArray_append(&out, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+		const size_t storedNum = (FontValidation_ERROR_MAX < validation->errorNum)? FontValidation_ERROR_MAX : validation->errorNum;
+		for(size_t e = 0; e < storedNum; e++){
+			n = snprintf(line, sizeof(line), "\terror: %s\n", validation->errors[e]);
+			FFByteArray_append(&out, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+		}
+	}
+	if(0 < out.length){
+		fwrite(out.data, 1, out.length, stdout);
+	}
+	fprintf(stdout, "batch fonts=%zu ok=%zu failed=%zu steals=%zu wall_ms=%.3f cpu_ms=%.3f\n",
+			context.pathNum, context.pathNum - failedNum, failedNum, stealNum, wallMs, cpuMs);
+	fflush(stdout);
+
+	FFByteArray_free(&out);
+	for(size_t i = 0; i < context.pathNum; i++){
+		FontValidation_free(&context.validations[i]);
+		free(context.paths[i]);
+	}
+	free(context.validations);
+	free(context.paths);
+	return (0 == failedNum)? 0 : 1;
+}
+
+/** @brief 2つのフォントを比べ、違いと集計を出力する。
+  @return 0: 同じ 1: 違いがある 2: 開けない・読めない(diff(1)に合わせる)
+  */
+int diffFonts(const char *pathA, const char *pathB)
+{
+	const char *paths[] = {pathA, pathB};
+	FontFile files[2];
+	FontParser parsers[2];
+	for(int i = 0; i < 2; i++){
+		if(! FontFile_open(&files[i], paths[i])){
+			fprintf(stderr, "open: `%s` %d %s\n", paths[i], errno, strerror(errno));
+			exit(2);
+		}
+		FontParseError error = FontWoff_decodeFile(&files[i], 0);
+		if(FontParseError_None != error){
+			fprintf(stderr, "woff: `%s` %zu %s\n", paths[i], files[i].size, FontParseError_toString(error));
+			exit(2);
+		}
+		error = FontParser_init(&parsers[i], files[i].data, files[i].size);
+		if(FontParseError_None != error){
+			fprintf(stderr, "read: `%s` %zu %s\n", paths[i], files[i].size, FontParseError_toString(error));
+			exit(2);
+		}
+	}
+
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	fprintf(stdout, "--- %s\n+++ %s\n", pathA, pathB);
+	FontDiff diff = {.out = stdout};
+	FontDiff_compare(&diff, &parsers[0], &parsers[1]);
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	const double wallMs = ((double)(end.tv_sec - begin.tv_sec) * 1e3) + ((double)(end.tv_nsec - begin.tv_nsec) / 1e6);
+	fprintf(stdout, "diff %s tables same=%zu changed=%zu added=%zu removed=%zu fields=%zu mappings=%zu glyphs=%zu wall_ms=%.3f\n",
+			FontDiff_isSame(&diff) ? "same" : "differ",
+			diff.tableSameNum, diff.tableChangedNum, diff.tableAddedNum, diff.tableRemovedNum,
+			diff.fieldNum, diff.mappingNum, diff.glyphNum, wallMs);
+	fflush(stdout);
+
+	for(int i = 0; i < 2; i++){
+		FontParser_free(&parsers[i]);
+		FontFile_close(&files[i]);
+	}
+	return FontDiff_isSame(&diff) ? 0 : 1;
+}
+
+/** @brief --size-report: Table, glyph毎の大きさと、符号化を変えた場合に減らせるbyte数の見積もりを出力する。
+  glyph毎の行は--glyphsの範囲。
+  */
+void sizeReport(const FontParser *parser)
+{
+	struct timespec begin;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	FontSizeReport report = {.out = stdout, .glyphFirst = arg.glyphFirst, .glyphLast = arg.glyphLast};
+	FontSizeReport_analyze(&report, parser);
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	const double wallMs = ((double)(end.tv_sec - begin.tv_sec) * 1e3) + ((double)(end.tv_nsec - begin.tv_nsec) / 1e6);
+	const int64_t saving = FontSizeReport_saving(&report);
+	fprintf(stdout, "size-report file %zu bytes saving %"PRId64" bytes %.1f%% wall_ms=%.3f\n",
+			report.fileSize, saving, (0 == report.fileSize)? 0.0 : (100.0 * (double)saving / (double)report.fileSize), wallMs);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	/**
+	第1引数でフォントファイル名を指定する
+	*/
+	if(argc < 2){
+		exit(1);
+	}
+
+	// ** 引数：--batch PATH [--threads N]
+	if(0 == strcmp("--batch", argv[1])){
+		long threadNum = 0;
+		char *end = NULL;
+		if(argc == 5 && 0 == strcmp("--threads", argv[3])){
+			threadNum = strtol(argv[4], &end, 10);
+		}
+		if(! (argc == 3 || (argc == 5 && '\0' == *end && 0 < threadNum))){
+			ERROR_LOG("invalid args: --batch PATH [--threads N]");
+			exit(1);
+		}
+		return batchValidate(argv[2], (size_t)threadNum);
+	}
+	// ** 引数：--diff A B
+	if(0 == strcmp("--diff", argv[1])){
+		if(argc != 4){
+			ERROR_LOG("invalid args: --diff A B");
+			exit(2);
+		}
+		return diffFonts(argv[2], argv[3]);
+	}
+	const char *fontfilepath = argv[1];
+
+	// ** 引数
+	for(int i = 2; i < argc; i++){
+		if(0 == strcmp("-t", argv[i])){
+			// -t TAG[,TAG...] (繰り返し指定できる)
+			if(! (i + 1 < argc)){
+				ERROR_LOG("invalid table name");
+				exit(1);
+			}
+			const char *tags = argv[++i];
+			while(true){
+				const size_t length = strcspn(tags, ",");
+				DumpTable table = 0;
+				for(size_t t = 0; t < sizeof(dumpTableTags) / sizeof(dumpTableTags[0]); t++){
+					if(4 == length && 0 == strncmp(dumpTableTags[t].tag, tags, length)){
+						table = dumpTableTags[t].table;
+					}
+				}
+				if(0 == table){
+					ERROR_LOG("invalid table name: `%.*s` (head, maxp, cmap, loca, glyf, fvar, gvar)", (int)length, tags);
+					exit(1);
+				}
+				arg.tables |= table;
+				if('\0' == tags[length]){
+					break;
+				}
+				tags += length + 1;
+			}
+		}else if(0 == strcmp("--glyphs", argv[i])){
+			// --glyphs FIRST[-LAST]
+			char *end0 = NULL;
+			char *end1 = NULL;
+			if(i + 1 < argc){
+				const char *range = argv[++i];
+				arg.glyphFirst = strtoul(range, &end0, 10);
+				arg.glyphLast = arg.glyphFirst;
+				end1 = end0;
+				if(end0 != range && '-' == *end0){
+					arg.glyphLast = strtoul(end0 + 1, &end1, 10);
+					end1 = (end1 == end0 + 1)? end0 : end1;
+				}
+				end0 = (end0 == range)? NULL : end0;
+			}
+			if(NULL == end0 || '\0' != *end1 || arg.glyphLast < arg.glyphFirst){
+				ERROR_LOG("invalid args: --glyphs FIRST[-LAST]");
+				exit(1);
+			}
+		}else if(0 == strcmp("--strict", argv[i])){
+			arg.strictMode = FFStrictMode_ALL;
+		}else if(0 == strcmp("--json", argv[i])){
+			arg.isJson = true;
+		}else if(0 == strcmp("--verify-only", argv[i])){
+			arg.isVerifyOnly = true;
+		}else if(0 == strcmp("--size-report", argv[i])){
+			arg.isSizeReport = true;
+		}else if(0 == strcmp("--threads", argv[i])){
+			char *end = NULL;
+			const long threadNum = (i + 1 < argc)? strtol(argv[++i], &end, 10) : 0;
+			if(NULL == end || '\0' != *end || threadNum < 1){
+				ERROR_LOG("invalid args: --threads N");
+				exit(1);
+			}
+			arg.threadNum = (size_t)threadNum;
+		}else if(0 == strcmp("--render", argv[i])){
+			// --render GLYPHID PPEM FILE.pgm
+			char *end0 = NULL;
+			char *end1 = NULL;
+			if(i + 3 < argc){
+				arg.renderGlyphId = strtol(argv[i + 1], &end0, 10);
+				arg.renderPpem = strtod(argv[i + 2], &end1);
+				arg.renderPath = argv[i + 3];
+				i += 3;
+			}
+			if(NULL == arg.renderPath || '\0' != *end0 || '\0' != *end1
+					|| arg.renderGlyphId < 0 || ! (0.0 < arg.renderPpem && arg.renderPpem <= 4096.0)){
+				ERROR_LOG("invalid args: --render GLYPHID PPEM FILE.pgm");
+				exit(1);
+			}
+		}else if(0 == strcmp("--sdf-atlas", argv[i])){
+			// --sdf-atlas RANGES PPEM SPREAD OUTBASE
+			char *end0 = NULL;
+			char *end1 = NULL;
+			if(i + 4 < argc){
+				arg.sdfRanges = argv[i + 1];
+				arg.sdfPpem = strtod(argv[i + 2], &end0);
+				arg.sdfSpread = strtod(argv[i + 3], &end1);
+				arg.sdfOutBase = argv[i + 4];
+			}
+			if(NULL == arg.sdfRanges || '\0' != *end0 || '\0' != *end1
+					|| ! (0.0 < arg.sdfPpem && arg.sdfPpem <= 4096.0) || ! (0.0 < arg.sdfSpread && arg.sdfSpread <= 256.0)){
+				ERROR_LOG("invalid args: --sdf-atlas RANGES PPEM SPREAD OUTBASE");
+				exit(1);
+			}
+			i += 4;
+		}else if(0 == strcmp("--measure", argv[i])){
+			// --measure TEXT(UTF-8)
+			if(! (i + 1 < argc)){
+				ERROR_LOG("invalid args: --measure TEXT");
+				exit(1);
+			}
+			arg.measureText = argv[++i];
+		}else{
+			ERROR_LOG("invalid args");
+			exit(1);
+		}
+	}
+	const DumpTable tables = (0 == arg.tables)? DumpTable_ALL : arg.tables;
+
+	// ファイルは1度だけmmap(できない場合は読み切る)し、以降はメモリ上の範囲を参照する
+	FontFile fontFile;
+	const FontFile *file = &fontFile;
+	if(! FontFile_open(&fontFile, fontfilepath)){
+		fprintf(stderr, "open: %d %s\n", errno, strerror(errno));
+		exit(1);
+	}
+	// WOFF, WOFF2はメモリ上のsfntへ展開してから読む
+	const FontWoffFormat woffFormat = FontWoff_format(fontFile.data, fontFile.size);
+	FontParseError error = FontWoff_decodeFile(&fontFile, arg.threadNum);
+	if(FontParseError_None != error){
+		fprintf(stderr, "woff: %zu %s\n", fontFile.size, FontParseError_toString(error));
+		exit(1);
+	}
+	if(FontWoffFormat_NONE != woffFormat){
+		DEBUG_LOG("%s decoded: sfnt %zu byte", (FontWoffFormat_WOFF == woffFormat)? "WOFF" : "WOFF2", fontFile.size);
+	}
+
+	// ** OffsetTable, TableDirectory
+	FontParser fontParser;
+	const FontParser *parser = &fontParser;
+	error = FontParser_init(&fontParser, file->data, file->size);
+	if(FontParseError_None != error){
+		fprintf(stderr, "read: %zu %s\n", file->size, FontParseError_toString(error));
+		exit(1);
+	}
+	const OffsetTable offsetTable = fontParser.offsetTable;
+
+	if(NULL != arg.sdfRanges || NULL != arg.measureText){
+		// Tableを出力せず、atlasの書き出しか計測だけをする
+		if(NULL != arg.sdfRanges){
+			sdfAtlas(parser, arg.sdfRanges, arg.sdfPpem, arg.sdfSpread, arg.sdfOutBase);
+		}else{
+			measureText(parser, arg.measureText);
+		}
+		FontParser_free(&fontParser);
+		FontFile_close(&fontFile);
+		return 0;
+	}
+
+	if(arg.isVerifyOnly){
+		// Tableを解析せず、checksumだけを確かめる
+		const bool isOk = checksumTable(parser);
+		fprintf(stdout, "verify: %s %s\n", isOk ? "ok" : "MISMATCH", fontfilepath);
+		FontParser_free(&fontParser);
+		FontFile_close(&fontFile);
+		return isOk ? 0 : 1;
+	}
+	if(arg.isSizeReport){
+		sizeReport(parser);
+		FontParser_free(&fontParser);
+		FontFile_close(&fontFile);
+		return 0;
+	}
+
+	if(arg.isJson){
+		const int ret = dumpJson(parser, fontfilepath, tables, arg.glyphFirst, arg.glyphLast);
+		FontParser_free(&fontParser);
+		FontFile_close(&fontFile);
+		return ret;
+	}
+
+	const char *sfntversionstr = OffsetTable_SfntVersion_ToPrintString(offsetTable.sfntVersion);
+
+	fprintf(stdout,
+			"Font File Dumper: v %s\n"
+			"project daisy bell 2019\n"
+			"Dumping File:%s\n"
+			"\n"
+			"\n"
+			"Offset Table\n"
+			"------------\n"
+			"	 sfnt version: 		%s\n"
+			"	 number of tables:%3d\n",
+			//FULL_VERSION,
+			SHOW_VERSION,
+			fontfilepath,
+			sfntversionstr,
+			offsetTable.numTables);
+
+	tableDirectory(parser);
+
+	if(0 <= arg.renderGlyphId){
+		renderGlyph(parser, arg.renderGlyphId, arg.renderPpem, arg.renderPath);
 		goto finally;
 	}
 
-	uint32_t *locaList = NULL; // use GlyfTable from LocaTable
+	checksumTable(parser);
 
-	locaTable(tableDirectory, numTables, fd,
-			headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs,
-			&locaList);
+	// ** Tables
+	// 指定されたTableと、その出力に必要なTable(loca, glyf, gvarにはhead, maxp等)だけを読む
+	uint16_t headTable_Host_indexToLocFormat = 0; // use LocaTable from HeadTable member
+	if(0 != (tables & DumpTable_HEAD)){
+		headTable(parser, &headTable_Host_indexToLocFormat);
+	}else if(0 != (tables & (DumpTable_LOCA | DumpTable_GLYF | DumpTable_GVAR))){
+		headTable_Read(parser, &headTable_Host_indexToLocFormat);
+	}
 
-	glyfTable(tableDirectory, numTables, fd,
-			maxpTable_Host_numGlyphs, locaList);
+	size_t maxpTable_Host_numGlyphs = 0; // use LocaTable from MaxpTable member
+	if(0 != (tables & DumpTable_MAXP)){
+		maxpTable(parser, &maxpTable_Host_numGlyphs);
+	}else if(0 != (tables & (DumpTable_LOCA | DumpTable_GLYF | DumpTable_GVAR))){
+		maxpTable_Read(parser, &maxpTable_Host_numGlyphs);
+	}
+
+	if(0 != (tables & DumpTable_CMAP)){
+		cmapTable(parser);
+	}
+
+	if(0 != (tables & DumpTable_LOCA)){
+		locaTable(parser,
+				headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs);
+	}
+
+	if(0 != (tables & DumpTable_GLYF)){
+		glyfTable(parser,
+				headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs,
+				arg.glyphFirst, arg.glyphLast);
+	}
+
+	size_t fvarTable_Host_axisCount = 0; // use GvarTable from FvarTable member
+	if(0 != (tables & DumpTable_FVAR)){
+		fvarTable(parser, &fvarTable_Host_axisCount);
+	}else if(0 != (tables & DumpTable_GVAR)){
+		fvarTable_Host_axisCount = fvarTable_AxisCount(parser);
+	}
+
+	if(0 != (tables & DumpTable_GVAR)){
+		gvarTable(parser,
+				fvarTable_Host_axisCount,
+				headTable_Host_indexToLocFormat, maxpTable_Host_numGlyphs,
+				arg.glyphFirst, arg.glyphLast);
+	}
 
 finally:
 
-	close(fd);
+	FontParser_free(&fontParser);
+	FontFile_close(&fontFile);
 
 	return 0;
 }
@@ -0,0 +1,10 @@
+/**
+  @file
+  @brief libdaisyff(libdaisyff.a, libdaisyff.so)の翻訳単位。
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+
+  内部ヘッダはこの翻訳単位に閉じ込め、include/daisyff.hのAPIのみを公開する(-fvisibility=hidden)。
+ */
+
+#include "src/DaisyffBuilder.h"
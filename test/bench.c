@@ -0,0 +1,589 @@
+/**
+  @file
+  @brief 合成N glyphフォントによるdaisyff生成処理のベンチマーク
+  @author michianri.nukazawa@gmail.com / project daisy bell
+  @details license: MIT
+ */
+#include "src/OpenType.h"
+#include "src/GlyphRaster.h"
+#include "src/TextMeasure.h"
+#include "include/version.h"
+#include <inttypes.h>
+
+enum{
+	BenchDistribution_Sequential = 0,	//!< U+0021から連続
+	BenchDistribution_Cjk,			//!< U+4E00(CJK統合漢字)から連続
+	BenchDistribution_Random,		//!< BMP内にdensityの密度でランダム
+};
+typedef int BenchDistribution;
+
+typedef struct{
+	const char		*name;
+	BenchDistribution	distribution;
+}BenchDistributionInfo;
+const BenchDistributionInfo benchDistributionInfos[] = {
+	{"seq",		BenchDistribution_Sequential,},
+	{"cjk",		BenchDistribution_Cjk,},
+	{"random",	BenchDistribution_Random,},
+};
+
+typedef struct{
+	size_t			glyphNum;
+	size_t			pointNum;	//!< glyphあたりのpoint数
+	size_t			contourNum;	//!< glyphあたりのcontour数
+	BenchDistribution	distribution;
+	double			density;	//!< BenchDistribution_Randomで使う(0.0, 1.0]
+	unsigned int		seed;
+	const char		*outputPath;	//!< 結果(JSON Lines)の追記先
+	const char		*fontPath;	//!< 書き出し先(計測後に削除する)
+	double			rasterPpem;	//!< 0より大きい場合は全glyphをこのppemで描画して計測する
+	size_t			measureCharNum;	//!< 0より大きい場合は生成したフォントの文字からこの文字数のcorpusを作り、送り幅を計測する
+	const char		*corpusPath;	//!< 送り幅を計測するUTF-8 text(measureCharNumより優先)
+}BenchArg;
+
+//! 計測するstage(出力のkey名)
+enum{
+	BenchStage_OutlineBuild = 0,
+	BenchStage_SetOutline,
+	BenchStage_AppendGlyph,
+	BenchStage_GlyphTablesFinally,
+	BenchStage_AppendTable,
+	BenchStage_Checksum,
+	BenchStage_Write,
+	BenchStage_NUM,
+};
+const char *benchStageNames[BenchStage_NUM] = {
+	"outline_build",
+	"glyph_description_set_outline",
+	"glyph_tables_append_simple_glyph",
+	"glyph_tables_finally",
+	"tablebuf_append_table",
+	"checksum",
+	"write",
+};
+
+uint64_t Bench_nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+//! @brief 再現性のために固定seedのxorshift32を使う
+uint32_t Bench_random(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+//! @return 昇順のcodepoint列(glyphNum個)
+uint16_t *Bench_generateCodepoints(const BenchArg *benchArg)
+{
+	// .notdef(0), NUL(1), TAB(2)の後ろに並べるので、GlyphIdは最大でUINT16_MAX
+	ASSERTF(benchArg->glyphNum <= (UINT16_MAX - 3), "%zu", benchArg->glyphNum);
+
+	uint16_t *codepoints = (uint16_t *)ffmalloc(sizeof(uint16_t) * benchArg->glyphNum);
+	const uint32_t first = 0x21; // 制御文字とspaceは避ける
+	const uint32_t last = CmapSubtableFormat4_CODEPOINT_MAX;
+
+	switch(benchArg->distribution){
+	case BenchDistribution_Sequential:
+	case BenchDistribution_Cjk:
+	{
+		uint32_t start = (BenchDistribution_Cjk == benchArg->distribution) ? 0x4E00 : first;
+		if((last - first + 1) < benchArg->glyphNum){
+			ERROR_LOG("glyphNum:%zu too many.", benchArg->glyphNum);
+			exit(1);
+		}
+		// 足りなければ先頭側へ寄せる
+		if((last - start + 1) < benchArg->glyphNum){
+			start = last + 1 - benchArg->glyphNum;
+		}
+		for(size_t i = 0; i < benchArg->glyphNum; i++){
+			codepoints[i] = start + i;
+		}
+	}
+		break;
+	case BenchDistribution_Random:
+	{
+		// windowの中から密度densityになるよう選ぶ(選択サンプリングで昇順に得る)
+		size_t window = (size_t)((double)benchArg->glyphNum / benchArg->density);
+		if((last - first + 1) < window){
+			window = last - first + 1;
+		}
+		ASSERTF(benchArg->glyphNum <= window, "%zu %zu", benchArg->glyphNum, window);
+		uint32_t state = benchArg->seed;
+		size_t n = 0;
+		for(size_t c = 0; c < window && n < benchArg->glyphNum; c++){
+			uint64_t r = Bench_random(&state) % (window - c);
+			if(r < (benchArg->glyphNum - n)){
+				codepoints[n++] = first + c;
+			}
+		}
+		ASSERT_EQ_INT(n, benchArg->glyphNum);
+	}
+		break;
+	default:
+		ASSERT(false);
+	}
+
+	return codepoints;
+}
+
+//! @brief pointNum点をcontourNum個の閉パスに分けて、ランダムなアウトラインを生成する
+GlyphOutline Bench_generateOutline(const BenchArg *benchArg, uint32_t *state)
+{
+	GlyphOutline outline = {0};
+	size_t restPointNum = benchArg->pointNum;
+	for(size_t c = 0; c < benchArg->contourNum; c++){
+		size_t anchorPointNum = restPointNum / (benchArg->contourNum - c);
+		restPointNum -= anchorPointNum;
+
+		GlyphClosePath cpath = {0};
+		GlyphAnchorPoint *apoints = (GlyphAnchorPoint *)ffmalloc(sizeof(GlyphAnchorPoint) * anchorPointNum);
+		for(size_t i = 0; i < anchorPointNum; i++){
+			apoints[i].point.x = (int16_t)(Bench_random(state) % 1000);
+			apoints[i].point.y = (int16_t)(Bench_random(state) % 1000) - 300;
+		}
+		GlyphClosePath_addAnchorPoints(&cpath, apoints, anchorPointNum);
+		GlyphOutline_addClosePath(&outline, &cpath);
+		free(apoints);
+	}
+
+	return outline;
+}
+
+typedef struct{
+	uint64_t		renderNs;	//!< decode + 描画 + 累積和(SIMD)
+	uint64_t		accumulateNs;	//!< 累積和(SIMD)のみ
+	uint64_t		accumulateScalarNs;	//!< 累積和(scalar)のみ
+	uint64_t		pixelNum;
+}BenchRasterResult;
+
+//! @brief 生成した'glyf'の全glyphを描画する
+BenchRasterResult Bench_raster(const BenchArg *benchArg, const GlyphTablesBuf *glyphTablesBuf)
+{
+	BenchRasterResult result = {0};
+	GlyphRaster raster = {0};
+	for(size_t glyphId = 0; glyphId < glyphTablesBuf->numGlyphs; glyphId++){
+		const uint32_t offset = glyphTablesBuf->locaOffsets_Host[glyphId];
+		const size_t size = glyphTablesBuf->locaOffsets_Host[glyphId + 1] - offset;
+		uint64_t t = Bench_nowNs();
+		ASSERT(GlyphRaster_renderGlyph(&raster, &glyphTablesBuf->glyfData[offset], size, benchArg->rasterPpem, 1024));
+		result.renderNs += Bench_nowNs() - t;
+
+		t = Bench_nowNs();
+		GlyphRaster_accumulate(&raster);
+		result.accumulateNs += Bench_nowNs() - t;
+		t = Bench_nowNs();
+		GlyphRaster_accumulateScalar(&raster);
+		result.accumulateScalarNs += Bench_nowNs() - t;
+		result.pixelNum += raster.width * raster.height;
+	}
+	GlyphRaster_free(&raster);
+	return result;
+}
+
+typedef struct{
+	uint64_t		cacheBuildNs;	//!< TextMeasure_init()
+	uint64_t		measureNs;	//!< TextMeasure_measureUtf8()
+	uint64_t		uncachedNs;	//!< 同じ計測で送り幅を1文字毎に'hmtx'から引いた場合
+	uint64_t		lookupNs;	//!< CmapPageTable_glyphId()のみ
+	uint64_t		lookupNum;
+	size_t			cmapBytes;	//!< CmapPageTable_memorySize()
+	uint64_t		charNum;	//!< 計測した文字数(corpusを繰り返した合計)
+	size_t			corpusBytes;
+	size_t			unmappedNum;
+}BenchMeasureResult;
+
+size_t Bench_encodeUtf8_inline_(uint8_t *dst, uint16_t codepoint)
+{
+	if(codepoint < 0x80){
+		dst[0] = (uint8_t)codepoint;
+		return 1;
+	}else if(codepoint < 0x800){
+		dst[0] = (uint8_t)(0xC0 | (codepoint >> 6));
+		dst[1] = (uint8_t)(0x80 | (codepoint & 0x3F));
+		return 2;
+	}
+	dst[0] = (uint8_t)(0xE0 | (codepoint >> 12));
+	dst[1] = (uint8_t)(0x80 | ((codepoint >> 6) & 0x3F));
+	dst[2] = (uint8_t)(0x80 | (codepoint & 0x3F));
+	return 3;
+}
+
+//! @brief 生成したフォントで文字列の送り幅を計測する(corpusが短い場合は繰り返す)
+BenchMeasureResult Bench_measure(const BenchArg *benchArg, const uint8_t *fontData, size_t fontDataSize, const uint16_t *codepoints)
+{
+	BenchMeasureResult result = {0};
+
+	// ** corpus
+	uint8_t *corpus;
+	size_t corpusSize = 0;
+	if(NULL != benchArg->corpusPath){
+		int fd = open(benchArg->corpusPath, O_RDONLY);
+		ASSERTF(-1 != fd, "`%s` %d %s", benchArg->corpusPath, errno, strerror(errno));
+		struct stat st;
+		ASSERT(0 == fstat(fd, &st));
+		corpus = (uint8_t *)ffmalloc(st.st_size + 1);
+		ssize_t ssize;
+		while(0 < (ssize = read(fd, &corpus[corpusSize], st.st_size - corpusSize))){
+			corpusSize += ssize;
+		}
+		close(fd);
+	}else{
+		// 8文字に1つspace(割り当て無し)を混ぜる
+		uint32_t state = benchArg->seed;
+		corpus = (uint8_t *)ffmalloc((benchArg->measureCharNum * 3) + 1);
+		for(size_t i = 0; i < benchArg->measureCharNum; i++){
+			const uint32_t r = Bench_random(&state);
+			const uint16_t codepoint = (0 == (r & 7))? ' ' : codepoints[(r >> 3) % benchArg->glyphNum];
+			corpusSize += Bench_encodeUtf8_inline_(&corpus[corpusSize], codepoint);
+		}
+	}
+	result.corpusBytes = corpusSize;
+
+	FontParser parser;
+	ASSERT(FontParseError_None == FontParser_init(&parser, fontData, fontDataSize));
+
+	uint64_t t = Bench_nowNs();
+	TextMeasure measure;
+	ASSERT(FontParseError_None == TextMeasure_init(&measure, &parser));
+	result.cacheBuildNs = Bench_nowNs() - t;
+
+	// ** 計測(短いcorpusは合計100万文字以上になるまで繰り返す)
+	uint64_t advance = 0;
+	t = Bench_nowNs();
+	do{
+		TextMeasureResult measureResult;
+		ASSERTF(TextMeasure_measureUtf8(&measure, (const char *)corpus, corpusSize, &measureResult), "invalid UTF-8 corpus");
+		advance += measureResult.advance;
+		result.charNum += measureResult.charNum;
+		result.unmappedNum = measureResult.unmappedNum;
+	}while(0 < corpusSize && result.charNum < 1000000);
+	result.measureNs = Bench_nowNs() - t;
+
+	// ** codepoint -> glyphIdのみ(生成した文字を合計1000万回以上引く)
+	uint64_t glyphIdSum = 0;
+	t = Bench_nowNs();
+	while(result.lookupNum < 10000000){
+		for(size_t i = 0; i < benchArg->glyphNum; i++){
+			glyphIdSum += CmapPageTable_glyphId(&measure.cmap, codepoints[i]);
+		}
+		result.lookupNum += benchArg->glyphNum;
+	}
+	result.lookupNs = Bench_nowNs() - t;
+	ASSERT(0 < glyphIdSum);
+	result.cmapBytes = CmapPageTable_memorySize(&measure.cmap);
+
+	// ** 比較: 1文字毎に'hmtx'を引く
+	HheaTable hhea;
+	FontParseHmtx hmtx;
+	ASSERT(FontParseError_None == FontParser_hhea(&parser, &hhea));
+	ASSERT(FontParseError_None == FontParser_hmtx(&parser, hhea.numberOfHMetrics, measure.numGlyphs, &hmtx));
+	uint64_t uncachedAdvance = 0;
+	uint64_t uncachedCharNum = 0;
+	t = Bench_nowNs();
+	while(uncachedCharNum < result.charNum){
+		for(size_t i = 0; i < corpusSize; ){
+			uint32_t codepoint;
+			const size_t length = Utf8_decodeOne_inline_(&corpus[i], corpusSize - i, &codepoint);
+			uint16_t advanceWidth;
+			int16_t lsb;
+			ASSERT(FontParseError_None == FontParseHmtx_metric(&hmtx, CmapPageTable_glyphId(&measure.cmap, codepoint), &advanceWidth, &lsb));
+			uncachedAdvance += advanceWidth;
+			uncachedCharNum++;
+			i += length;
+		}
+	}
+	result.uncachedNs = Bench_nowNs() - t;
+	ASSERT(advance == uncachedAdvance);
+
+	TextMeasure_free(&measure);
+	FontParser_free(&parser);
+	free(corpus);
+	return result;
+}
+
+void Bench_run(const BenchArg *benchArg)
+{
+	uint64_t stageNs[BenchStage_NUM] = {0};
+	uint64_t t;
+	uint32_t state = benchArg->seed;
+
+	uint16_t *codepoints = Bench_generateCodepoints(benchArg);
+
+	// ** outline build
+	t = Bench_nowNs();
+	GlyphOutline *outlines = (GlyphOutline *)ffmalloc(sizeof(GlyphOutline) * benchArg->glyphNum);
+	for(size_t i = 0; i < benchArg->glyphNum; i++){
+		outlines[i] = Bench_generateOutline(benchArg, &state);
+	}
+	stageNs[BenchStage_OutlineBuild] += Bench_nowNs() - t;
+
+	// ** GlyphDescriptionBuf_setOutline
+	t = Bench_nowNs();
+	GlyphDescriptionBuf *glyphDescriptionBufs = (GlyphDescriptionBuf *)ffmalloc(sizeof(GlyphDescriptionBuf) * benchArg->glyphNum);
+	for(size_t i = 0; i < benchArg->glyphNum; i++){
+		GlyphDescriptionBuf_setOutline(&glyphDescriptionBufs[i], &outlines[i]);
+	}
+	GlyphDescriptionBuf glyphDescriptionBuf_notdef = {0};
+	GlyphOutline outline_notdef = GlyphOutline_Notdef();
+	GlyphDescriptionBuf_setOutline(&glyphDescriptionBuf_notdef, &outline_notdef);
+	GlyphDescriptionBuf glyphDescriptionBuf_empty = {0};
+	GlyphOutline outline_empty = {0};
+	GlyphDescriptionBuf_setOutline(&glyphDescriptionBuf_empty, &outline_empty);
+	stageNs[BenchStage_SetOutline] += Bench_nowNs() - t;
+
+	// ** GlyphTablesBuf_appendSimpleGlyph (daisyff.cと同じ先頭3glyph + 合成glyph)
+	t = Bench_nowNs();
+	GlyphTablesBuf glyphTablesBuf;
+	GlyphTablesBuf_init(&glyphTablesBuf);
+	HmtxTableBuf hmtxTableBuf = {0};
+	GlyphTablesBuf_appendSimpleGlyph(&glyphTablesBuf, 0x0, &glyphDescriptionBuf_notdef);
+	HmtxTableBuf_appendLongHorMetric(&hmtxTableBuf, 500, 50);
+	GlyphTablesBuf_appendSimpleGlyph(&glyphTablesBuf, 0, &glyphDescriptionBuf_empty);
+	HmtxTableBuf_appendLongHorMetric(&hmtxTableBuf, 0, 0);
+	GlyphTablesBuf_appendSimpleGlyph(&glyphTablesBuf, '\t', &glyphDescriptionBuf_empty);
+	HmtxTableBuf_appendLongHorMetric(&hmtxTableBuf, 1000, 0);
+	for(size_t i = 0; i < benchArg->glyphNum; i++){
+		GlyphTablesBuf_appendSimpleGlyph(&glyphTablesBuf, codepoints[i], &glyphDescriptionBufs[i]);
+		HmtxTableBuf_appendLongHorMetric(&hmtxTableBuf, 1000, 0);
+	}
+	stageNs[BenchStage_AppendGlyph] += Bench_nowNs() - t;
+
+	// ** GlyphTablesBuf_finally
+	t = Bench_nowNs();
+	GlyphTablesBuf_finally(&glyphTablesBuf);
+	HmtxTableBuf_finally(&hmtxTableBuf);
+	stageNs[BenchStage_GlyphTablesFinally] += Bench_nowNs() - t;
+
+	// ** rasterize(フォント生成の計測には含めない)
+	BenchRasterResult rasterResult = {0};
+	if(0.0 < benchArg->rasterPpem){
+		rasterResult = Bench_raster(benchArg, &glyphTablesBuf);
+	}
+
+	// ** Tablebuf_appendTable
+	BBox bBox = BBox_generate(0, 1000, -300, 700);
+	HeadTable headTable;
+	ASSERT(HeadTable_init(&headTable, 0x00010000, 0, 0, 0, (MacStyle)MacStyle_Bit6_Regular, bBox, 8));
+	headTable.indexToLocFormat = htons(glyphTablesBuf.indexToLocFormat);
+	NameTableBuf nameTableBuf = NameTableBuf_init(
+			"(c)bench", "DaisyBench", (MacStyle)MacStyle_Bit6_Regular,
+			"Version 1.0", "bench", "bench", "https://example.com/", "https://example.com/");
+	HheaTable hheaTable = {0};
+	HheaTable_init(&hheaTable, 700, 300, 24, hmtxTableBuf.advanceWidthMax, 0, 0, 1000, hmtxTableBuf.numberOfHMetrics);
+	MaxpTable_Version05 maxpTable;
+	ASSERT(MaxpTable_Version05_init(&maxpTable, glyphTablesBuf.numGlyphs));
+	PostTable_Header postTable = {
+		.version		= htonl(0x00030000),
+	};
+
+	t = Bench_nowNs();
+	Tablebuf tableBuf;
+	Tablebuf_init(&tableBuf);
+	Tablebuf_appendTable(&tableBuf, "head", (void *)(&headTable), sizeof(HeadTable));
+	Tablebuf_appendTable(&tableBuf, "name", (void *)(nameTableBuf.data), nameTableBuf.dataSize);
+	Tablebuf_appendTable(&tableBuf, "maxp", (void *)(&maxpTable), sizeof(MaxpTable_Version05));
+	Tablebuf_appendTable(&tableBuf, "cmap", (void *)(glyphTablesBuf.cmapByteArray.data), glyphTablesBuf.cmapByteArray.length);
+	Tablebuf_appendTable(&tableBuf, "loca", (void *)(glyphTablesBuf.locaByteArray.data), glyphTablesBuf.locaByteArray.length);
+	Tablebuf_appendTable(&tableBuf, "glyf", (void *)(glyphTablesBuf.glyfData), glyphTablesBuf.glyfDataSize);
+	Tablebuf_appendTable(&tableBuf, "hhea", (void *)(&hheaTable), sizeof(HheaTable));
+	Tablebuf_appendTable(&tableBuf, "hmtx", (void *)(hmtxTableBuf.byteArray.data), hmtxTableBuf.byteArray.length);
+	Tablebuf_appendTable(&tableBuf, "post", (void *)(&postTable), sizeof(PostTable_Header));
+	const size_t offsetHeadSize = sizeof(OffsetTable) + (sizeof(TableDirectory_Member) * tableBuf.appendTableNum);
+	Tablebuf_finallyTableDirectoryOffset(&tableBuf, offsetHeadSize);
+	stageNs[BenchStage_AppendTable] += Bench_nowNs() - t;
+
+	OffsetTable offsetTable;
+	ASSERT(OffsetTable_init(&offsetTable, 0x00010000, tableBuf.appendTableNum));
+	const size_t fontDataSize = offsetHeadSize + tableBuf.dataSize;
+	uint8_t *fontData = (uint8_t *)ffmalloc(fontDataSize);
+	memcpy(&fontData[0], &offsetTable, sizeof(OffsetTable));
+	memcpy(&fontData[sizeof(OffsetTable)], tableBuf.tableDirectory, sizeof(TableDirectory_Member) * tableBuf.appendTableNum);
+	memcpy(&fontData[offsetHeadSize], tableBuf.data, tableBuf.dataSize);
+
+	// ** checksum (checkSumAdjustment)
+	t = Bench_nowNs();
+	Uint32Type checkSumAdjustment = 0xB1B0AFBA - CalcTableChecksum((uint32_t *)fontData, fontDataSize);
+	uint32_t checkSumAdjustment_Net = htonl(checkSumAdjustment);
+	memcpy(&fontData[offsetHeadSize + offsetof(HeadTable, checkSumAdjustment)], &checkSumAdjustment_Net, sizeof(uint32_t));
+	stageNs[BenchStage_Checksum] += Bench_nowNs() - t;
+
+	// ** 送り幅の計測(フォント生成の計測には含めない)
+	BenchMeasureResult measureResult = {0};
+	const bool isMeasure = (0 < benchArg->measureCharNum || NULL != benchArg->corpusPath);
+	if(isMeasure){
+		measureResult = Bench_measure(benchArg, fontData, fontDataSize, codepoints);
+	}
+
+	// ** write
+	t = Bench_nowNs();
+	int fd = open(benchArg->fontPath, O_CREAT|O_TRUNC|O_WRONLY, 0644);
+	ASSERTF(-1 != fd, "%d %s", errno, strerror(errno));
+	ssize_t s = write(fd, fontData, fontDataSize);
+	ASSERTF(s == fontDataSize, "%zd %d %s", s, errno, strerror(errno));
+	close(fd);
+	stageNs[BenchStage_Write] += Bench_nowNs() - t;
+	unlink(benchArg->fontPath);
+
+	// ** 結果の追記
+	uint64_t totalNs = 0;
+	for(int i = 0; i < BenchStage_NUM; i++){
+		totalNs += stageNs[i];
+	}
+	FILE *fp = fopen(benchArg->outputPath, "a");
+	ASSERTF(NULL != fp, "`%s` %d %s", benchArg->outputPath, errno, strerror(errno));
+	fprintf(fp,
+			"{\"version\":\"%s\",\"git_hash\":\"%s\",\"git_status\":\"%s\""
+			",\"glyphs\":%zu,\"points\":%zu,\"contours\":%zu"
+			",\"distribution\":\"%s\",\"density\":%.3f,\"seed\":%u"
+			",\"font_bytes\":%zu,\"glyf_bytes\":%zu,\"index_to_loc_format\":%d"
+			",\"total_ns\":%"PRIu64",\"stage_ns\":{",
+			FULL_VERSION, GIT_HASH, GIT_STATUS_SHORT,
+			benchArg->glyphNum, benchArg->pointNum, benchArg->contourNum,
+			benchDistributionInfos[benchArg->distribution].name, benchArg->density, benchArg->seed,
+			fontDataSize, glyphTablesBuf.glyfDataSize, glyphTablesBuf.indexToLocFormat,
+			totalNs);
+	for(int i = 0; i < BenchStage_NUM; i++){
+		fprintf(fp, "%s\"%s\":%"PRIu64, ((0 == i)? "":","), benchStageNames[i], stageNs[i]);
+	}
+	fprintf(fp, "}");
+	const double rasterGlyphsPerSec = (0 == rasterResult.renderNs)? 0.0
+		: (double)glyphTablesBuf.numGlyphs * 1e9 / (double)rasterResult.renderNs;
+	if(0.0 < benchArg->rasterPpem){
+		fprintf(fp,
+				",\"raster\":{\"ppem\":%.1f,\"pixels\":%"PRIu64",\"render_ns\":%"PRIu64",\"glyphs_per_sec\":%.1f"
+				",\"accumulate_ns\":%"PRIu64",\"accumulate_scalar_ns\":%"PRIu64"}",
+				benchArg->rasterPpem, rasterResult.pixelNum, rasterResult.renderNs, rasterGlyphsPerSec,
+				rasterResult.accumulateNs, rasterResult.accumulateScalarNs);
+	}
+	const double measureCharsPerSec = (0 == measureResult.measureNs)? 0.0
+		: (double)measureResult.charNum * 1e9 / (double)measureResult.measureNs;
+	const double uncachedCharsPerSec = (0 == measureResult.uncachedNs)? 0.0
+		: (double)measureResult.charNum * 1e9 / (double)measureResult.uncachedNs;
+	const double lookupsPerSec = (0 == measureResult.lookupNs)? 0.0
+		: (double)measureResult.lookupNum * 1e9 / (double)measureResult.lookupNs;
+	if(isMeasure){
+		fprintf(fp,
+				",\"measure\":{\"corpus\":\"%s\",\"corpus_bytes\":%zu,\"chars\":%"PRIu64",\"unmapped\":%zu"
+				",\"cache_build_ns\":%"PRIu64",\"measure_ns\":%"PRIu64",\"chars_per_sec\":%.1f"
+				",\"uncached_ns\":%"PRIu64",\"uncached_chars_per_sec\":%.1f"
+				",\"cmap_bytes\":%zu,\"lookup_ns\":%"PRIu64",\"lookups_per_sec\":%.1f}",
+				(NULL != benchArg->corpusPath)? benchArg->corpusPath : "synthetic",
+				measureResult.corpusBytes, measureResult.charNum, measureResult.unmappedNum,
+				measureResult.cacheBuildNs, measureResult.measureNs, measureCharsPerSec,
+				measureResult.uncachedNs, uncachedCharsPerSec,
+				measureResult.cmapBytes, measureResult.lookupNs, lookupsPerSec);
+	}
+	fprintf(fp, "}\n");
+	fclose(fp);
+
+	fprintf(stderr, "bench: glyphs:%6zu points:%3zu %-6s total:%10.3f ms (",
+			benchArg->glyphNum, benchArg->pointNum,
+			benchDistributionInfos[benchArg->distribution].name, (double)totalNs / 1e6);
+	for(int i = 0; i < BenchStage_NUM; i++){
+		fprintf(stderr, "%s%s:%.3f", ((0 == i)? "":" "), benchStageNames[i], (double)stageNs[i] / 1e6);
+	}
+	fprintf(stderr, ")\n");
+	if(0.0 < benchArg->rasterPpem){
+		fprintf(stderr, "bench: raster ppem:%.1f %.0f glyphs/sec (accumulate simd:%.3f scalar:%.3f ms)\n",
+				benchArg->rasterPpem, rasterGlyphsPerSec,
+				(double)rasterResult.accumulateNs / 1e6, (double)rasterResult.accumulateScalarNs / 1e6);
+	}
+	if(isMeasure){
+		fprintf(stderr, "bench: measure %"PRIu64" chars %.0f chars/sec (uncached %.0f chars/sec, cache build %.3f ms)\n",
+				measureResult.charNum, measureCharsPerSec, uncachedCharsPerSec, (double)measureResult.cacheBuildNs / 1e6);
+		fprintf(stderr, "bench: cmap lookup %.0f lookups/sec (%zu bytes)\n", lookupsPerSec, measureResult.cmapBytes);
+	}
+
+	// 計測対象外の後始末は省略(プロセス終了に任せる)
+}
+
+void Bench_usage()
+{
+	fprintf(stderr,
+			"usage: bench.exe [--glyphs N] [--points N] [--contours N]\n"
+			"                 [--distribution seq|cjk|random] [--density D] [--seed N]\n"
+			"                 [--output FILE.jsonl] [--font FILE] [--raster-ppem PPEM]\n"
+			"                 [--measure-chars N] [--corpus FILE.txt]\n");
+}
+
+int main(int argc, char **argv)
+{
+	BenchArg benchArg = {
+		.glyphNum	= 1000,
+		.pointNum	= 16,
+		.contourNum	= 2,
+		.distribution	= BenchDistribution_Sequential,
+		.density	= 0.5,
+		.seed		= 2463534242,
+		.outputPath	= "bench_result.jsonl",
+		.fontPath	= "bench_tmp.otf",
+	};
+
+	for(int i = 1; i < argc; i++){
+		if(! (i + 1 < argc)){
+			Bench_usage();
+			return 1;
+		}
+		const char *value = argv[i + 1];
+		if(0 == strcmp("--glyphs", argv[i])){
+			benchArg.glyphNum = strtoul(value, NULL, 10);
+		}else if(0 == strcmp("--points", argv[i])){
+			benchArg.pointNum = strtoul(value, NULL, 10);
+		}else if(0 == strcmp("--contours", argv[i])){
+			benchArg.contourNum = strtoul(value, NULL, 10);
+		}else if(0 == strcmp("--distribution", argv[i])){
+			bool isFound = false;
+			for(int d = 0; d < sizeof(benchDistributionInfos) / sizeof(benchDistributionInfos[0]); d++){
+				if(0 == strcmp(benchDistributionInfos[d].name, value)){
+					benchArg.distribution = benchDistributionInfos[d].distribution;
+					isFound = true;
+				}
+			}
+			if(! isFound){
+				Bench_usage();
+				return 1;
+			}
+		}else if(0 == strcmp("--density", argv[i])){
+			benchArg.density = strtod(value, NULL);
+		}else if(0 == strcmp("--seed", argv[i])){
+			benchArg.seed = strtoul(value, NULL, 10);
+		}else if(0 == strcmp("--output", argv[i])){
+			benchArg.outputPath = value;
+		}else if(0 == strcmp("--font", argv[i])){
+			benchArg.fontPath = value;
+		}else if(0 == strcmp("--raster-ppem", argv[i])){
+			benchArg.rasterPpem = strtod(value, NULL);
+		}else if(0 == strcmp("--measure-chars", argv[i])){
+			benchArg.measureCharNum = strtoul(value, NULL, 10);
+		}else if(0 == strcmp("--corpus", argv[i])){
+			benchArg.corpusPath = value;
+		}else{
+			Bench_usage();
+			return 1;
+		}
+		i++;
+	}
+
+	if(0 == benchArg.glyphNum
+			|| 0 == benchArg.contourNum
+			|| benchArg.pointNum < benchArg.contourNum
+			|| ! (0.0 < benchArg.density && benchArg.density <= 1.0)
+			|| ! (0.0 <= benchArg.rasterPpem && benchArg.rasterPpem <= 4096.0)
+			|| 0 == benchArg.seed){
+		Bench_usage();
+		return 1;
+	}
+
+	Bench_run(&benchArg);
+
+	return 0;
+}
+
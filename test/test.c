@@ -3,8 +3,23 @@
   @author michianri.nukazawa@gmail.com / project daisy bell
   @details license: MIT
  */
+#define FF_ALLOC_FAIL_INJECT 1
 #include "src/OpenType.h"
 #include "src/GlyphOutline.h"
+#include "src/DaisyffBuilder.h"
+#include "src/GlyphRaster.h"
+#include "src/GlyphSdf.h"
+#include "src/TextMeasure.h"
+#include "src/FontParser.h"
+#include "src/FontValidator.h"
+#include "src/WorkStealingPool.h"
+#include "src/JsonWriter.h"
+#include "src/GlyfDecoder.h"
+#include "src/FontChecksum.h"
+#include "src/FontDiff.h"
+#include "src/FontWoff.h"
+#include "src/FontSizeReport.h"
+#include <brotli/encode.h>
 #include <stdio.h>
 #include <inttypes.h>
 
@@ -78,6 +93,25 @@
 		}\
 	}while(0);
 
+// ** big-endian bytes(テスト用のTableを組み立て・読むための共通の補助)
+
+uint16_t testBytes_u16(const uint8_t *p)
+{
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+void testBytes_appendU16(FFByteArray *array, uint16_t value)
+{
+	const uint8_t bytes[] = {(uint8_t)(value >> 8), (uint8_t)value};
+	FFByteArray_append(array, bytes, sizeof(bytes));
+}
+
+void testBytes_appendU32(FFByteArray *array, uint32_t value)
+{
+	testBytes_appendU16(array, (uint16_t)(value >> 16));
+	testBytes_appendU16(array, (uint16_t)value);
+}
+
 
 void longdatetime_test()
 {
@@ -225,6 +259,2707 @@ void glyphDescriptionBufNotdefNoCompression_test()
 	DEBUG_LOG("out");
 }
 
+void endianArray_test()
+{
+	DEBUG_LOG("in");
+
+	// SIMD(32byte,16byte単位)と端数のscalar処理の境界を跨ぐ長さを試す
+	const size_t nums[] = {0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 100};
+	for(int t = 0; t < sizeof(nums) / sizeof(nums[0]); t++){
+		const size_t num = nums[t];
+		uint16_t src16[128];
+		uint32_t src32[128];
+		for(int i = 0; i < num; i++){
+			src16[i] = (uint16_t)(0x0102 + (i * 0x0101));
+			src32[i] = (uint32_t)(0x01020304 + (i * 0x01010101));
+		}
+
+		// copy (非アライメント先)
+		uint8_t buf8[(128 * 4) + 1];
+		htonArray16Move(&buf8[1], src16, num);
+		for(int i = 0; i < num; i++){
+			EXPECT_EQ_UINT(buf8[1 + (i * 2) + 0], (uint8_t)(src16[i] >> 8));
+			EXPECT_EQ_UINT(buf8[1 + (i * 2) + 1], (uint8_t)(src16[i] >> 0));
+		}
+		uint16_t dst16[128];
+		ntohArray16Move(dst16, &buf8[1], num);
+		EXPECT_EQ_ARRAY((uint8_t *)dst16, (uint8_t *)src16, sizeof(uint16_t) * num);
+
+		htonArray32Move(&buf8[1], src32, num);
+		for(int i = 0; i < num; i++){
+			EXPECT_EQ_UINT(buf8[1 + (i * 4) + 0], (uint8_t)(src32[i] >> 24));
+			EXPECT_EQ_UINT(buf8[1 + (i * 4) + 3], (uint8_t)(src32[i] >>  0));
+		}
+		uint32_t dst32[128];
+		ntohArray32Move(dst32, &buf8[1], num);
+		EXPECT_EQ_ARRAY((uint8_t *)dst32, (uint8_t *)src32, sizeof(uint32_t) * num);
+
+		// in-place
+		memcpy(dst16, src16, sizeof(uint16_t) * num);
+		htonArray16(dst16, num);
+		for(int i = 0; i < num; i++){
+			EXPECT_EQ_UINT(dst16[i], htons(src16[i]));
+		}
+		ntohArray16(dst16, num);
+		EXPECT_EQ_ARRAY((uint8_t *)dst16, (uint8_t *)src16, sizeof(uint16_t) * num);
+
+		memcpy(dst32, src32, sizeof(uint32_t) * num);
+		htonArray32(dst32, num);
+		for(int i = 0; i < num; i++){
+			EXPECT_EQ_UINT(dst32[i], htonl(src32[i]));
+		}
+	}
+
+	DEBUG_LOG("out");
+}
+
+void utf8ToUtf16BE_test()
+{
+	DEBUG_LOG("in");
+
+	{
+		// ASCII(SIMDの16byte単位 + 端数)
+		const char *src = "(c)Copyright the project daisy bell 2019";
+		uint8_t dst[128];
+		size_t dstSize = 0;
+		EXPECT_EQ_INT(1, Utf8_toUtf16BE(dst, &dstSize, (const uint8_t *)src, strlen(src)));
+		EXPECT_EQ_UINT(strlen(src) * 2, dstSize);
+		for(size_t i = 0; i < strlen(src); i++){
+			EXPECT_EQ_UINT(0x00, dst[i * 2 + 0]);
+			EXPECT_EQ_UINT(src[i], dst[i * 2 + 1]);
+		}
+	}
+	{
+		// 2,3,4byte(サロゲートペア)とASCIIの混在
+		const char *src = "\xC2\xA9" "Copyright 0123456789abcdef \xE3\x81\x82\xF0\xA0\xAE\xB7!";
+		const uint8_t expect[] = {
+			0x00, 0xA9,
+			0x00, 'C', 0x00, 'o', 0x00, 'p', 0x00, 'y', 0x00, 'r', 0x00, 'i', 0x00, 'g', 0x00, 'h', 0x00, 't', 0x00, ' ',
+			0x00, '0', 0x00, '1', 0x00, '2', 0x00, '3', 0x00, '4', 0x00, '5', 0x00, '6', 0x00, '7',
+			0x00, '8', 0x00, '9', 0x00, 'a', 0x00, 'b', 0x00, 'c', 0x00, 'd', 0x00, 'e', 0x00, 'f', 0x00, ' ',
+			0x30, 0x42,
+			0xD8, 0x42, 0xDF, 0xB7,
+			0x00, '!',
+		};
+		uint8_t dst[128];
+		size_t dstSize = 0;
+		EXPECT_EQ_INT(1, Utf8_toUtf16BE(dst, &dstSize, (const uint8_t *)src, strlen(src)));
+		EXPECT_EQ_UINT(sizeof(expect), dstSize);
+		EXPECT_EQ_ARRAY(dst, expect, sizeof(expect));
+	}
+	{
+		// 不正なUTF-8
+		const char *invalids[] = {
+			"\xC0\x80",		// overlong
+			"\xE0\x80\xAF",	// overlong
+			"\xED\xA0\x80",	// サロゲート
+			"\xF4\x90\x80\x80",	// U+10FFFF超
+			"\xE3\x81",		// 途中で切れている
+			"0123456789abcdef\x80",	// 単独の継続byte
+			"\xFF",
+		};
+		for(size_t i = 0; i < sizeof(invalids) / sizeof(invalids[0]); i++){
+			uint8_t dst[64];
+			size_t dstSize;
+			EXPECT_EQ_INT(0, Utf8_toUtf16BE(dst, &dstSize, (const uint8_t *)invalids[i], strlen(invalids[i])));
+		}
+		size_t utf16sSize;
+		EXPECT_EQ_UINT(0, (uintptr_t)convertNewUtf16FromUtf8("\xC0\x80", &utf16sSize));
+	}
+
+	DEBUG_LOG("out");
+}
+
+void nameTableStringPool_test()
+{
+	DEBUG_LOG("in");
+
+	NameTableBuf nameTableBuf;
+	NameTableBuf_begin(&nameTableBuf);
+	EXPECT_EQ_INT(1, NameTableBuf_append(&nameTableBuf, PlatformID_Windows, EncodingID_Windows_UnicodeBMP, 0x0411, 1, "\xE3\x81\x82"));
+	EXPECT_EQ_INT(1, NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0, 1, "Daisy"));
+	EXPECT_EQ_INT(1, NameTableBuf_append(&nameTableBuf, PlatformID_Windows, EncodingID_Windows_UnicodeBMP, 0x0409, 1, "Daisy"));
+	EXPECT_EQ_INT(1, NameTableBuf_append(&nameTableBuf, PlatformID_Macintosh, EncodingID_Macintosh_Roman, 0x0, 1, "Daisy"));
+	EXPECT_EQ_INT(0, NameTableBuf_append(&nameTableBuf, PlatformID_Macintosh, EncodingID_Macintosh_Roman, 0x0, 2, "\xE3\x81\x82"));
+	EXPECT_EQ_INT(0, NameTableBuf_append(&nameTableBuf, PlatformID_Unicode, EncodingID_Unicode_0, 0x0, 2, "\xC0\x80"));
+	EXPECT_EQ_UINT(4, nameTableBuf.count);
+	// "あ"(2) + "Daisy"(UTF-16BE 10, 共有) + "Daisy"(Roman 5)
+	EXPECT_EQ_UINT(2 + 10 + 5, nameTableBuf.stringStrageSize);
+	// 多数の同じ文字列
+	for(int i = 0; i < 1000; i++){
+		EXPECT_EQ_INT(1, NameTableBuf_append(&nameTableBuf, PlatformID_Windows, EncodingID_Windows_UnicodeBMP, 0x0400 + i, 4, "Daisy"));
+	}
+	EXPECT_EQ_UINT(2 + 10 + 5, nameTableBuf.stringStrageSize);
+
+	NameTableBuf_generateByteData(&nameTableBuf);
+	// NameRecordはplatformID, encodingID, languageID, nameIDの順
+	const NameRecord_Member *records = (const NameRecord_Member *)&nameTableBuf.data[sizeof(NameTableHeader_Format0)];
+	EXPECT_EQ_UINT(PlatformID_Unicode, ntohs(records[0].platformID));
+	EXPECT_EQ_UINT(PlatformID_Macintosh, ntohs(records[1].platformID));
+	for(int i = 3; i < nameTableBuf.count; i++){
+		EXPECT_EQ_INT(-1, NameRecord_Member_compare_inline_(&records[i - 1], &records[i]));
+	}
+	NameTableBuf_free(&nameTableBuf);
+
+	// stringOffset(6 + 12 * count)とstring strageの合計はUint16に収まる数まで
+	NameTableBuf_begin(&nameTableBuf);
+	size_t count = 0;
+	while(NameTableBuf_append(&nameTableBuf, PlatformID_Windows, EncodingID_Windows_UnicodeBMP, count / 0x100, count % 0x100, "Daisy")){
+		count++;
+	}
+	EXPECT_EQ_UINT((UINT16_MAX - 6 - 10) / 12, count);
+	EXPECT_EQ_UINT(count, nameTableBuf.count);
+	NameTableBuf_generateByteData(&nameTableBuf);
+	const NameTableHeader_Format0 *header = (const NameTableHeader_Format0 *)nameTableBuf.data;
+	EXPECT_EQ_UINT(6 + (12 * count), ntohs(header->stringOffset));
+	EXPECT_EQ_UINT(6 + (12 * count) + 10, nameTableBuf.dataSize);
+	NameTableBuf_free(&nameTableBuf);
+
+	DEBUG_LOG("out");
+}
+
+void daisyffBuilder_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "BuilderTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = -200, .xMax = 400, .yMax = 800,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+		.created = 0, .modified = 0,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+
+	{
+		// 必須の設定が無い
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		uint8_t *data;
+		size_t size;
+		EXPECT_EQ_INT(DaisyffError_InvalidState, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+		EXPECT_EQ_INT(DaisyffError_InvalidState, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		DaisyffBuilder_free(builder);
+	}
+	{
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		EXPECT_EQ_UINT(3, DaisyffBuilder_getNumGlyphs(builder));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+
+		uint16_t glyphId = 0;
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, &glyphId));
+		EXPECT_EQ_UINT(3, glyphId);
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 0x3042, contours, 1, 500, 0, &glyphId));
+		EXPECT_EQ_UINT(4, glyphId);
+		// 重複・範囲外・不正な輪郭
+		EXPECT_EQ_INT(DaisyffError_DuplicateCodepoint, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, NULL));
+		EXPECT_EQ_INT(DaisyffError_DuplicateCodepoint, DaisyffBuilder_addGlyph(builder, '\t', NULL, 0, 500, 0, NULL));
+		EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addGlyph(builder, 0x10000, contours, 1, 500, 0, NULL));
+		const DaisyffContour emptyContours[] = {{points, 0},};
+		EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addGlyph(builder, 'B', emptyContours, 1, 500, 0, NULL));
+		EXPECT_EQ_UINT(5, DaisyffBuilder_getNumGlyphs(builder));
+
+		uint8_t *data = NULL;
+		size_t size = 0;
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		EXPECT_EQ_UINT(0, size % 4);
+		const OffsetTable *offsetTable = (const OffsetTable *)data;
+		EXPECT_EQ_UINT(0x00010000, ntohl(offsetTable->sfntVersion));
+		EXPECT_EQ_UINT(9, ntohs(offsetTable->numTables));
+		// finally後は変更できない
+		EXPECT_EQ_INT(DaisyffError_InvalidState, DaisyffBuilder_addGlyph(builder, 'C', contours, 1, 500, 0, NULL));
+		free(data);
+		DaisyffBuilder_free(builder);
+	}
+	{
+		// 言語別の名前
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addLocalizedName(builder, 0x0411, 1, "\xE3\x81\x82"));
+		EXPECT_EQ_INT(DaisyffError_DuplicateName, DaisyffBuilder_addLocalizedName(builder, 0x0411, 1, "x"));
+		EXPECT_EQ_INT(DaisyffError_DuplicateName, DaisyffBuilder_addLocalizedName(builder, 0x0409, 1, "x"));
+		EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addLocalizedName(builder, 0x0412, 1, "\xE3\x81"));
+		uint8_t *data = NULL;
+		size_t size = 0;
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		free(data);
+		DaisyffBuilder_free(builder);
+	}
+	{
+		// 'name' Tableのheader(stringOffset)がUint16を超える数の名前
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+		for(uint16_t i = 0; i < 6000; i++){
+			EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addLocalizedName(builder, 0x0400 + (i / 0x100), 0x100 + (i % 0x100), "x"));
+		}
+		uint8_t *data = NULL;
+		size_t size = 0;
+		EXPECT_EQ_INT(DaisyffError_TableOverflow, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		DaisyffBuilder_free(builder);
+	}
+	{
+		// PostScript名に使えない文字
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		DaisyffNames invalidNames = names;
+		invalidNames.familyName = "Builder(Test)";
+		EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_setNames(builder, &invalidNames));
+		DaisyffBuilder_free(builder);
+	}
+
+	DEBUG_LOG("out");
+}
+
+// ** 'GPOS' kerningの参照実装(pairの値をlookupから引く)
+
+//! @return glyphのCoverage Index。-1: 含まれない
+int gposTest_coverageIndex(const uint8_t *coverage, uint16_t glyph)
+{
+	const uint16_t count = testBytes_u16(&coverage[2]);
+	if(1 == testBytes_u16(&coverage[0])){
+		for(int i = 0; i < count; i++){
+			if(glyph == testBytes_u16(&coverage[4 + (2 * i)])){
+				return i;
+			}
+		}
+		return -1;
+	}
+	for(int i = 0; i < count; i++){
+		const uint8_t *range = &coverage[4 + (6 * i)];
+		if(testBytes_u16(&range[0]) <= glyph && glyph <= testBytes_u16(&range[2])){
+			return testBytes_u16(&range[4]) + (glyph - testBytes_u16(&range[0]));
+		}
+	}
+	return -1;
+}
+
+uint16_t gposTest_class(const uint8_t *classDef, uint16_t glyph)
+{
+	if(1 == testBytes_u16(&classDef[0])){
+		const uint16_t start = testBytes_u16(&classDef[2]);
+		const uint16_t count = testBytes_u16(&classDef[4]);
+		if(start <= glyph && glyph < start + count){
+			return testBytes_u16(&classDef[6 + (2 * (glyph - start))]);
+		}
+		return 0;
+	}
+	const uint16_t count = testBytes_u16(&classDef[2]);
+	for(int i = 0; i < count; i++){
+		const uint8_t *range = &classDef[4 + (6 * i)];
+		if(testBytes_u16(&range[0]) <= glyph && glyph <= testBytes_u16(&range[2])){
+			return testBytes_u16(&range[4]);
+		}
+	}
+	return 0;
+}
+
+int16_t gposTest_lookupPair(const uint8_t *gpos, uint16_t left, uint16_t right)
+{
+	const uint8_t *lookupList = &gpos[testBytes_u16(&gpos[8])];
+	const uint8_t *lookup = &lookupList[testBytes_u16(&lookupList[2])];
+	const uint16_t lookupType = testBytes_u16(&lookup[0]);
+	const uint16_t subtableCount = testBytes_u16(&lookup[4]);
+	for(int s = 0; s < subtableCount; s++){
+		const uint8_t *subtable = &lookup[testBytes_u16(&lookup[6 + (2 * s)])];
+		if(9 == lookupType){
+			const uint8_t *offset = &subtable[4];
+			subtable = &subtable[((uint32_t)testBytes_u16(&offset[0]) << 16) | testBytes_u16(&offset[2])];
+		}
+		if(-1 == gposTest_coverageIndex(&subtable[testBytes_u16(&subtable[2])], left)){
+			continue;
+		}
+		if(1 == testBytes_u16(&subtable[0])){
+			const int coverageIndex = gposTest_coverageIndex(&subtable[testBytes_u16(&subtable[2])], left);
+			const uint8_t *pairSet = &subtable[testBytes_u16(&subtable[10 + (2 * coverageIndex)])];
+			for(int i = 0; i < testBytes_u16(&pairSet[0]); i++){
+				if(right == testBytes_u16(&pairSet[2 + (4 * i)])){
+					return (int16_t)testBytes_u16(&pairSet[2 + (4 * i) + 2]);
+				}
+			}
+			continue; // 次のsubtableへ
+		}
+		const uint16_t class1 = gposTest_class(&subtable[testBytes_u16(&subtable[8])], left);
+		const uint16_t class2 = gposTest_class(&subtable[testBytes_u16(&subtable[10])], right);
+		const uint16_t class2Count = testBytes_u16(&subtable[14]);
+		return (int16_t)testBytes_u16(&subtable[16 + (2 * ((class1 * class2Count) + class2))]);
+	}
+	return 0;
+}
+
+const uint8_t *gposTest_findTable(const uint8_t *data, const char *tag)
+{
+	const OffsetTable *offsetTable = (const OffsetTable *)data;
+	const TableDirectory_Member *members = (const TableDirectory_Member *)&data[sizeof(OffsetTable)];
+	for(int i = 0; i < ntohs(offsetTable->numTables); i++){
+		if(0 == memcmp(&members[i].tag, tag, 4)){
+			return &data[ntohl(members[i].offset)];
+		}
+	}
+	return NULL;
+}
+
+void gposKerning_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "KerningTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = -200, .xMax = 400, .yMax = 800,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	enum{ GLYPH_NUM = 300, };
+	static int16_t expected[GLYPH_NUM][GLYPH_NUM];
+
+	struct{
+		size_t		leftNum;
+		size_t		rightNum;
+		bool		isRandom;	//!< 全pairが別の値(classにまとまらない)
+	}const cases[] = {
+		{ 40,  60, false},
+		{GLYPH_NUM, GLYPH_NUM, true},
+	};
+	for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+		const uint16_t firstGlyph = (uint16_t)DaisyffBuilder_getNumGlyphs(builder);
+		for(size_t i = 0; i < GLYPH_NUM; i++){
+			EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 0x4E00 + i, NULL, 0, 500, 0, NULL));
+		}
+		EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addKerningPair(builder, 0, firstGlyph + GLYPH_NUM, -10));
+
+		memset(expected, 0, sizeof(expected));
+		uint32_t seed = 1;
+		for(size_t l = 0; l < cases[c].leftNum; l++){
+			for(size_t r = 0; r < cases[c].rightNum; r++){
+				int16_t value;
+				if(cases[c].isRandom){
+					seed = seed * 1103515245u + 12345u;
+					value = (int16_t)((seed >> 16) % 2000) - 1000;
+				}else{
+					// 左5class x 右7class + 例外
+					value = (int16_t)(((l % 5) * 10) - ((r % 7) * 3));
+					if(3 == l && 0 == r % 11){
+						value = 123;
+					}
+					if(0 == (l + r) % 17){
+						continue; // pair無し
+					}
+				}
+				expected[l][r] = value;
+				EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addKerningPair(
+							builder, firstGlyph + l, firstGlyph + r, (0 == r)? 999 : value));
+			}
+		}
+		// 同じpairは後勝ち
+		for(size_t l = 0; l < cases[c].leftNum; l++){
+			EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addKerningPair(
+						builder, firstGlyph + l, firstGlyph, expected[l][0]));
+		}
+
+		DaisyffKerningReport report;
+		EXPECT_EQ_INT(DaisyffError_InvalidState, DaisyffBuilder_getKerningReport(builder, &report));
+		uint8_t *data = NULL;
+		size_t size = 0;
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_getKerningReport(builder, &report));
+		EXPECT_TRUE(report.tableSize <= report.naiveSize);
+		if(! cases[c].isRandom){
+			EXPECT_TRUE(0 < report.leftClassNum);
+			EXPECT_TRUE(report.tableSize < report.naiveSize);
+		}
+
+		const uint8_t *gpos = gposTest_findTable(data, "GPOS");
+		EXPECT_TRUE(NULL != gpos);
+		for(size_t l = 0; l < GLYPH_NUM; l++){
+			for(size_t r = 0; r < GLYPH_NUM; r++){
+				const int16_t value = gposTest_lookupPair(gpos, firstGlyph + l, firstGlyph + r);
+				if(expected[l][r] != value){
+					fprintf(stderr, "case:%zu pair:%zu,%zu expected:%d actual:%d\n", c, l, r, expected[l][r], value);
+				}
+				EXPECT_EQ_INT(expected[l][r], value);
+			}
+		}
+		free(data);
+		DaisyffBuilder_free(builder);
+	}
+
+	DEBUG_LOG("out");
+}
+
+//! 'gvar' Tableの1 glyph分を適用した点(phantom point含む)を返す
+typedef struct{
+	const uint8_t	*p;
+}GvarTestReader;
+
+uint16_t gvarTest_readU16(GvarTestReader *reader)
+{
+	const uint16_t v = testBytes_u16(reader->p);
+	reader->p += 2;
+	return v;
+}
+
+//! @return 点数。points == NULL: 全点
+size_t gvarTest_readPoints(GvarTestReader *reader, uint16_t *points)
+{
+	size_t count = *reader->p++;
+	if(0 != (count & 0x80)){
+		count = ((count & 0x7f) << 8) | *reader->p++;
+	}
+	uint16_t point = 0;
+	for(size_t i = 0; i < count; ){
+		const uint8_t control = *reader->p++;
+		for(size_t r = 0; r < (size_t)(control & 0x7f) + 1; r++, i++){
+			point += (0 != (control & 0x80))? gvarTest_readU16(reader) : *reader->p++;
+			points[i] = point;
+		}
+	}
+	return count;
+}
+
+void gvarTest_readDeltas(GvarTestReader *reader, double *deltas, size_t count)
+{
+	for(size_t i = 0; i < count; ){
+		const uint8_t control = *reader->p++;
+		for(size_t r = 0; r < (size_t)(control & 0x3f) + 1; r++, i++){
+			if(0 != (control & 0x80)){
+				deltas[i] = 0;
+			}else if(0 != (control & 0x40)){
+				deltas[i] = (int16_t)gvarTest_readU16(reader);
+			}else{
+				deltas[i] = (int8_t)*reader->p++;
+			}
+		}
+	}
+}
+
+//! 仕様の"Inferred deltas for un-referenced point numbers"
+void gvarTest_iup(const double *coords, double *deltas, const bool *isReferenced, size_t begin, size_t end)
+{
+	size_t refNum = 0;
+	for(size_t i = begin; i < end; i++){
+		refNum += isReferenced[i]? 1 : 0;
+	}
+	for(size_t i = begin; i < end; i++){
+		if(isReferenced[i]){
+			continue;
+		}
+		if(0 == refNum){
+			deltas[i] = 0;
+			continue;
+		}
+		const size_t n = end - begin;
+		size_t prev = i;
+		size_t next = i;
+		do{ prev = begin + (prev - begin + n - 1) % n; }while(! isReferenced[prev]);
+		do{ next = begin + (next - begin + 1) % n; }while(! isReferenced[next]);
+		const double x1 = coords[prev], x2 = coords[next], d1 = deltas[prev], d2 = deltas[next];
+		const double x = coords[i];
+		if(x1 == x2){
+			deltas[i] = (d1 == d2)? d1 : 0;
+		}else if(x <= fmin(x1, x2)){
+			deltas[i] = (x1 < x2)? d1 : d2;
+		}else if(fmax(x1, x2) <= x){
+			deltas[i] = (x1 < x2)? d2 : d1;
+		}else{
+			deltas[i] = d1 + (x - x1) * (d2 - d1) / (x2 - x1);
+		}
+	}
+}
+
+double gvarTest_scalar(const double *location, const double *peak, const double *start, const double *end, size_t axisNum)
+{
+	double scalar = 1.0;
+	for(size_t a = 0; a < axisNum; a++){
+		const double v = location[a];
+		if(0 == peak[a] || v == peak[a]){
+			continue;
+		}
+		if(v < start[a] || end[a] < v){
+			return 0;
+		}
+		scalar *= (v < peak[a])? ((v - start[a]) / (peak[a] - start[a])) : ((end[a] - v) / (end[a] - peak[a]));
+	}
+	return scalar;
+}
+
+/** @brief 'gvar'をlocationで適用した座標を返す
+  @param outX, outY [pointNum + 4] 入力はdefaultの座標(phantom pointは advance を outX[pointNum + 1])
+  */
+void gvarTest_apply(
+		const uint8_t *gvar,
+		uint16_t glyphId,
+		const double *location,
+		const uint16_t *endPoints,
+		size_t contourNum,
+		size_t pointNum,
+		double *outX,
+		double *outY)
+{
+	GvarTestReader header = {gvar + 4};
+	const size_t axisNum = gvarTest_readU16(&header);
+	gvarTest_readU16(&header);
+	const uint8_t *sharedTuples = gvar + ((testBytes_u16(&gvar[8]) << 16) | testBytes_u16(&gvar[10]));
+	const uint16_t flags = testBytes_u16(&gvar[14]);
+	const uint32_t arrayOffset = (testBytes_u16(&gvar[16]) << 16) | testBytes_u16(&gvar[18]);
+	uint32_t begin, next;
+	if(0 != (flags & 0x1)){
+		begin = (testBytes_u16(&gvar[20 + glyphId * 4]) << 16) | testBytes_u16(&gvar[22 + glyphId * 4]);
+		next = (testBytes_u16(&gvar[24 + glyphId * 4]) << 16) | testBytes_u16(&gvar[26 + glyphId * 4]);
+	}else{
+		begin = testBytes_u16(&gvar[20 + glyphId * 2]) * 2;
+		next = testBytes_u16(&gvar[22 + glyphId * 2]) * 2;
+	}
+	if(begin == next){
+		return;
+	}
+	const size_t allNum = pointNum + 4;
+	double defaultX[allNum], defaultY[allNum];
+	memcpy(defaultX, outX, sizeof(double) * allNum);
+	memcpy(defaultY, outY, sizeof(double) * allNum);
+
+	GvarTestReader reader = {gvar + arrayOffset + begin};
+	const uint16_t tupleVariationCount = gvarTest_readU16(&reader);
+	GvarTestReader data = {gvar + arrayOffset + begin + gvarTest_readU16(&reader)};
+	uint16_t sharedPoints[allNum];
+	size_t sharedPointNum = 0;
+	if(0 != (tupleVariationCount & 0x8000)){
+		sharedPointNum = gvarTest_readPoints(&data, sharedPoints);
+	}
+	for(size_t t = 0; t < (tupleVariationCount & 0x0fff); t++){
+		const uint16_t size = gvarTest_readU16(&reader);
+		const uint16_t tupleIndex = gvarTest_readU16(&reader);
+		double peak[axisNum], start[axisNum], end[axisNum];
+		for(size_t a = 0; a < axisNum; a++){
+			const int16_t v = (0 != (tupleIndex & 0x8000))?
+				(int16_t)gvarTest_readU16(&reader) : (int16_t)testBytes_u16(&sharedTuples[((tupleIndex & 0x0fff) * axisNum + a) * 2]);
+			peak[a] = v / 16384.0;
+			start[a] = fmin(peak[a], 0);
+			end[a] = fmax(peak[a], 0);
+		}
+		if(0 != (tupleIndex & 0x4000)){
+			for(size_t a = 0; a < axisNum; a++){
+				start[a] = (int16_t)gvarTest_readU16(&reader) / 16384.0;
+			}
+			for(size_t a = 0; a < axisNum; a++){
+				end[a] = (int16_t)gvarTest_readU16(&reader) / 16384.0;
+			}
+		}
+		const uint8_t *dataEnd = data.p + size;
+		uint16_t privatePoints[allNum];
+		const uint16_t *points = sharedPoints;
+		size_t num = sharedPointNum;
+		if(0 != (tupleIndex & 0x2000)){
+			num = gvarTest_readPoints(&data, privatePoints);
+			points = privatePoints;
+		}
+		const bool isAll = (0 == num);
+		if(isAll){
+			num = allNum;
+		}
+		double dx[num], dy[num];
+		gvarTest_readDeltas(&data, dx, num);
+		gvarTest_readDeltas(&data, dy, num);
+		EXPECT_TRUE(dataEnd == data.p);
+
+		double deltaX[allNum], deltaY[allNum];
+		bool isReferenced[allNum];
+		memset(deltaX, 0, sizeof(deltaX));
+		memset(deltaY, 0, sizeof(deltaY));
+		memset(isReferenced, 0, sizeof(isReferenced));
+		for(size_t i = 0; i < num; i++){
+			const size_t p = isAll? i : points[i];
+			EXPECT_TRUE(p < allNum);
+			deltaX[p] = dx[i];
+			deltaY[p] = dy[i];
+			isReferenced[p] = true;
+		}
+		for(size_t c = 0, b = 0; c < contourNum; b = endPoints[c] + 1, c++){
+			gvarTest_iup(defaultX, deltaX, isReferenced, b, endPoints[c] + 1);
+			gvarTest_iup(defaultY, deltaY, isReferenced, b, endPoints[c] + 1);
+		}
+		const double scalar = gvarTest_scalar(location, peak, start, end, axisNum);
+		for(size_t p = 0; p < allNum; p++){
+			outX[p] += scalar * deltaX[p];
+			outY[p] += scalar * deltaY[p];
+		}
+	}
+}
+
+void variableFont_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "VariableTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = -200, .xMax = 1000, .yMax = 800,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+
+	uint16_t axisIndex;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addAxis(builder, "wght", 100, 400, 900, "Weight", &axisIndex));
+	EXPECT_EQ_INT(0, axisIndex);
+	EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addAxis(builder, "wght", 100, 400, 900, "Weight", NULL));
+	EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addAxis(builder, "wdth", 125, 100, 75, "Width", NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addAxis(builder, "wdth", 75, 100, 125, "Width", &axisIndex));
+	EXPECT_EQ_INT(1, axisIndex);
+	// wght 700 -> 650 (normalized 0.6 -> 0.5)
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addAxisMapping(builder, 0, 700, 650));
+	EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addAxisMapping(builder, 2, 700, 650));
+
+	const double bold[] = {700, 100};
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addNamedInstance(builder, "Bold", bold));
+	EXPECT_EQ_INT(DaisyffError_InvalidState, DaisyffBuilder_addAxis(builder, "opsz", 8, 12, 72, "Optical size", NULL));
+
+	// default: 正方形(8点) + 三角形
+	enum{ CONTOUR_NUM = 2, POINT_NUM = 11, };
+	const DaisyffPoint defaultPoints[POINT_NUM] = {
+		{100, 0}, {100, 350}, {100, 700}, {300, 700}, {500, 700}, {500, 350}, {500, 0}, {300, 0},
+		{200, 200}, {300, 500}, {400, 200},
+	};
+	const uint16_t endPoints[CONTOUR_NUM] = {7, 10};
+	const DaisyffContour defaultContours[CONTOUR_NUM] = {
+		{&defaultPoints[0], 8},
+		{&defaultPoints[8], 3},
+	};
+	uint16_t glyphId;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', defaultContours, CONTOUR_NUM, 600, 100, &glyphId));
+
+	// master: user座標, 横方向の拡大率, 縦方向のずれ, 送り幅
+	struct{
+		double		coordinates[2];
+		double		normalized[2];
+		double		scaleX;
+		int		shiftY;
+		uint16_t	advanceWidth;
+	}const masters[] = {
+		{{900, 100}, { 1.0,  0.0}, 1.5,   0, 800},
+		{{700, 100}, { 0.5,  0.0}, 1.3,   0, 720},
+		{{100, 100}, {-1.0,  0.0}, 0.8,   0, 520},
+		{{400,  75}, { 0.0, -1.0}, 0.6,   0, 420},
+		{{900, 125}, { 1.0,  1.0}, 2.0,  30, 999},
+		{{400, 125}, { 0.0,  1.0}, 1.2,  10, 680},
+	};
+	const size_t masterNum = sizeof(masters) / sizeof(masters[0]);
+	DaisyffPoint masterPoints[sizeof(masters) / sizeof(masters[0])][POINT_NUM];
+	for(size_t m = 0; m < masterNum; m++){
+		for(size_t p = 0; p < POINT_NUM; p++){
+			masterPoints[m][p] = (DaisyffPoint){
+				(int16_t)lround(100 + (defaultPoints[p].x - 100) * masters[m].scaleX),
+				(int16_t)(defaultPoints[p].y + ((8 <= p)? masters[m].shiftY : 0)),
+			};
+		}
+		const DaisyffContour contours[CONTOUR_NUM] = {
+			{&masterPoints[m][0], 8},
+			{&masterPoints[m][8], 3},
+		};
+		EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyphMaster(
+					builder, glyphId, masters[m].coordinates, contours, CONTOUR_NUM, masters[m].advanceWidth));
+	}
+	const double defaultLocation[] = {400, 100};
+	const double unusedLocation[] = {500, 100};
+	const DaisyffContour triangle[] = {{&defaultPoints[8], 3}};
+	EXPECT_EQ_INT(DaisyffError_IncompatibleMaster, DaisyffBuilder_addGlyphMaster(builder, glyphId, unusedLocation, triangle, 1, 600));
+	EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addGlyphMaster(builder, glyphId, defaultLocation, defaultContours, CONTOUR_NUM, 600));
+	EXPECT_EQ_INT(DaisyffError_InvalidArgument, DaisyffBuilder_addGlyphMaster(builder, glyphId, masters[0].coordinates, defaultContours, CONTOUR_NUM, 600));
+
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffVariationReport report;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_getVariationReport(builder, &report));
+	EXPECT_EQ_INT(masterNum, report.tupleNum);
+	EXPECT_TRUE(0 < report.omittedPointNum);
+	EXPECT_TRUE(report.gvarSize < report.gvarUnpackedSize);
+	EXPECT_TRUE(NULL != gposTest_findTable(data, "fvar"));
+	EXPECT_TRUE(NULL != gposTest_findTable(data, "avar"));
+	const uint8_t *gvar = gposTest_findTable(data, "gvar");
+	EXPECT_TRUE(NULL != gvar);
+
+	// 各masterの位置でmasterの字形を再現する(IUP 0.5 + 丸め)
+	for(size_t m = 0; m < masterNum; m++){
+		double x[POINT_NUM + 4] = {0};
+		double y[POINT_NUM + 4] = {0};
+		for(size_t p = 0; p < POINT_NUM; p++){
+			x[p] = defaultPoints[p].x;
+			y[p] = defaultPoints[p].y;
+		}
+		x[POINT_NUM + 1] = 600;
+		gvarTest_apply(gvar, glyphId, masters[m].normalized, endPoints, CONTOUR_NUM, POINT_NUM, x, y);
+		for(size_t p = 0; p < POINT_NUM; p++){
+			if(1.0 < fabs(x[p] - masterPoints[m][p].x) || 1.0 < fabs(y[p] - masterPoints[m][p].y)){
+				fprintf(stderr, "master:%zu point:%zu expected:%d,%d actual:%.2f,%.2f\n",
+						m, p, masterPoints[m][p].x, masterPoints[m][p].y, x[p], y[p]);
+			}
+			EXPECT_TRUE(fabs(x[p] - masterPoints[m][p].x) <= 1.0);
+			EXPECT_TRUE(fabs(y[p] - masterPoints[m][p].y) <= 1.0);
+		}
+		EXPECT_TRUE(fabs(x[POINT_NUM + 1] - masters[m].advanceWidth) <= 1.0);
+	}
+	free(data);
+	DaisyffBuilder_free(builder);
+
+	DEBUG_LOG("out");
+}
+
+//! NoMemoryの後は同じbuilderの呼び出しが全てNoMemoryになる
+DaisyffError daisyffBuilderNoMemoryTest_expect(DaisyffError error, bool *isNoMemory)
+{
+	if(*isNoMemory){
+		EXPECT_EQ_INT(DaisyffError_NoMemory, error);
+	}else{
+		EXPECT_TRUE(DaisyffError_None == error || DaisyffError_NoMemory == error);
+	}
+	*isNoMemory = (DaisyffError_NoMemory == error);
+	return error;
+}
+
+void daisyffBuilderNoMemory_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "NoMemoryTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = -200, .xMax = 400, .yMax = 800,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	const DaisyffPoint boldPoints[] = {{0, 0}, {0, 400}, {500, 400}, {500, 0},};
+	const DaisyffContour boldContours[] = {{boldPoints, 4},};
+	const double bold[] = {700};
+
+	// n回目の確保を失敗させ、どのAPIで失敗してもexitせずNoMemoryで返ることを、失敗が起きなくなるまで確かめる
+	size_t injectedNum = 0;
+	for(size_t n = 1; ; n++){
+		ffAllocFailCountdown = n;
+		DaisyffBuilder *builder = DaisyffBuilder_new();
+		if(NULL == builder){
+			EXPECT_EQ_UINT(0, ffAllocFailCountdown);
+			injectedNum++;
+			continue;
+		}
+		bool isNoMemory = false;
+		uint16_t glyphIdA = 0;
+		uint16_t glyphIdB = 0;
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_setNames(builder, &names), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_setMetrics(builder, &metrics), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addLocalizedName(builder, 0x0411, 1, "ノーメモリー"), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addAxis(builder, "wght", 100, 400, 900, "Weight", NULL), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addAxisMapping(builder, 0, 700, 650), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addNamedInstance(builder, "Bold", bold), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, &glyphIdA), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addGlyph(builder, 'B', contours, 1, 500, 0, &glyphIdB), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addGlyphMaster(builder, glyphIdA, bold, boldContours, 1, 600), &isNoMemory);
+		daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_addKerningPair(builder, glyphIdA, glyphIdB, -50), &isNoMemory);
+		uint8_t *data = NULL;
+		size_t size = 0;
+		if(DaisyffError_None == daisyffBuilderNoMemoryTest_expect(DaisyffBuilder_finallyToMemory(builder, &data, &size), &isNoMemory)){
+			EXPECT_TRUE(0 < size);
+			free(data);
+		}
+		DaisyffBuilder_free(builder);
+
+		const bool isInjected = (0 == ffAllocFailCountdown);
+		ffAllocFailCountdown = 0;
+		EXPECT_EQ_INT(isInjected, isNoMemory);
+		if(! isInjected){
+			break;
+		}
+		injectedNum++;
+	}
+	EXPECT_TRUE(10 < injectedNum);
+
+	DEBUG_LOG("out");
+}
+
+double glyphRasterTest_sum(const GlyphRaster *raster)
+{
+	double sum = 0;
+	for(size_t i = 0; i < raster->width * raster->height; i++){
+		sum += raster->pixels[i];
+	}
+	return sum / 255.0;
+}
+
+void glyphRasterTest_drawRect(GlyphRaster *raster, float x0, float y0, float x1, float y1, bool isReverse)
+{
+	const float xs[] = {x0, x1, x1, x0};
+	const float ys[] = {y0, y0, y1, y1};
+	for(int i = 0; i < 4; i++){
+		const int a = isReverse? (4 - i) % 4 : i;
+		const int b = isReverse? (3 - i) : (i + 1) % 4;
+		GlyphRaster_drawLine(raster, xs[a], ys[a], xs[b], ys[b]);
+	}
+}
+
+void glyphRaster_test()
+{
+	DEBUG_LOG("in");
+
+	GlyphRaster raster = {0};
+
+	// 面積と内外
+	GlyphRaster_begin(&raster, 16, 16);
+	glyphRasterTest_drawRect(&raster, 2.5f, 2.5f, 12.5f, 12.5f, false);
+	GlyphRaster_accumulate(&raster);
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - 100.0) < 0.5);
+	EXPECT_EQ_UINT(255, raster.pixels[(7 * 16) + 7]);
+	EXPECT_EQ_UINT(128, raster.pixels[(7 * 16) + 2]);
+	EXPECT_EQ_UINT(0, raster.pixels[(7 * 16) + 14]);
+
+	// nonzero winding: 同じ向きの重なりは塗り、逆向きは穴
+	GlyphRaster_begin(&raster, 16, 16);
+	glyphRasterTest_drawRect(&raster, 0, 0, 10, 10, false);
+	glyphRasterTest_drawRect(&raster, 5, 5, 15, 15, false);
+	GlyphRaster_accumulate(&raster);
+	EXPECT_EQ_UINT(255, raster.pixels[(7 * 16) + 7]);
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - 175.0) < 0.5);
+	GlyphRaster_begin(&raster, 16, 16);
+	glyphRasterTest_drawRect(&raster, 0, 0, 10, 10, false);
+	glyphRasterTest_drawRect(&raster, 5, 5, 15, 15, true);
+	GlyphRaster_accumulate(&raster);
+	EXPECT_EQ_UINT(0, raster.pixels[(7 * 16) + 7]);
+	EXPECT_EQ_UINT(255, raster.pixels[(2 * 16) + 2]);
+
+	// 二次ベジェ: 弦と放物線の間の面積 = 2/3 * 20 * 10
+	GlyphRaster_begin(&raster, 24, 24);
+	GlyphRaster_drawQuad(&raster, 2, 20, 12, 0, 22, 20);
+	GlyphRaster_drawLine(&raster, 22, 20, 2, 20);
+	GlyphRaster_accumulate(&raster);
+	// (n分割の折れ線の面積は(1 - 1/n^2)倍。この曲線はn = 9)
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - (2.0 / 3.0 * 20 * 10) * (1.0 - 1.0 / 81)) < 0.5);
+
+	// bitmap外へはみ出す線分
+	GlyphRaster_begin(&raster, 8, 8);
+	glyphRasterTest_drawRect(&raster, -100, -100, 100, 100, false);
+	GlyphRaster_accumulate(&raster);
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - 64.0) < 0.5);
+
+	// SIMDとscalarの累積和が一致する(4の倍数でない幅)
+	const size_t widths[] = {1, 3, 4, 5, 37};
+	for(size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++){
+		const size_t width = widths[w];
+		GlyphRaster_begin(&raster, width, 29);
+		uint32_t seed = 7;
+		for(int i = 0; i < 40; i++){
+			float v[6];
+			for(int k = 0; k < 6; k++){
+				seed = seed * 1103515245u + 12345u;
+				v[k] = (float)((seed >> 16) % 4000) / 100.0f - 5.0f;
+			}
+			GlyphRaster_drawQuad(&raster, v[0], v[1], v[2], v[3], v[4], v[5]);
+			GlyphRaster_drawLine(&raster, v[4], v[5], v[0], v[1]);
+		}
+		GlyphRaster_accumulate(&raster);
+		uint8_t simd[width * 29];
+		memcpy(simd, raster.pixels, sizeof(simd));
+		GlyphRaster_accumulateScalar(&raster);
+		for(size_t i = 0; i < width * 29; i++){
+			EXPECT_TRUE(abs((int)simd[i] - (int)raster.pixels[i]) <= 1);
+		}
+	}
+
+	// 'glyf'のglyph(.notdef: 外枠400x500 - 穴300x400)
+	GlyphDescriptionBuf glyphDescriptionBuf = {0};
+	GlyphOutline outline = GlyphOutline_Notdef();
+	GlyphDescriptionBuf_setOutline(&glyphDescriptionBuf, &outline);
+	EXPECT_TRUE(GlyphRaster_renderGlyph(&raster, glyphDescriptionBuf.data, glyphDescriptionBuf.dataSize, 102.4, 1024));
+	EXPECT_EQ_UINT(42, raster.width);
+	EXPECT_EQ_UINT(52, raster.height);
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - 800.0) < 2.0);
+	EXPECT_EQ_UINT(0, raster.pixels[(26 * 42) + 21]);
+	EXPECT_EQ_UINT(255, raster.pixels[(26 * 42) + 3]);
+	EXPECT_TRUE(! GlyphRaster_renderGlyph(&raster, glyphDescriptionBuf.data, 12, 102.4, 1024));
+	EXPECT_TRUE(GlyphRaster_renderGlyph(&raster, NULL, 0, 102.4, 1024));
+	EXPECT_EQ_UINT(0, raster.width);
+
+	GlyphRaster_free(&raster);
+
+	// 空のraster(pixelsがNULL)はheaderだけを書き出す
+	{
+		char path[] = "/tmp/daisyff_test_XXXXXX";
+		const int fd = mkstemp(path);
+		EXPECT_TRUE(-1 != fd);
+		close(fd);
+		const GlyphRaster empty = {0};
+		EXPECT_TRUE(GlyphRaster_writePgm(&empty, path));
+		FILE *fp = fopen(path, "rb");
+		EXPECT_TRUE(NULL != fp);
+		char text[32] = {0};
+		const size_t length = fread(text, 1, sizeof(text) - 1, fp);
+		fclose(fp);
+		unlink(path);
+		EXPECT_EQ_UINT(strlen("P5\n0 0\n255\n"), length);
+		EXPECT_TRUE(0 == strcmp("P5\n0 0\n255\n", text));
+	}
+
+	DEBUG_LOG("out");
+}
+
+void glyphSdf_test()
+{
+	DEBUG_LOG("in");
+
+	// 点と二次ベジェ曲線の距離: 細かく標本化した最短距離と一致する
+	uint32_t seed = 11;
+	for(int i = 0; i < 200; i++){
+		double v[8];
+		for(int k = 0; k < 8; k++){
+			seed = seed * 1103515245u + 12345u;
+			v[k] = (double)(float)((double)((seed >> 16) % 4000) / 100.0 - 20.0);
+		}
+		const GlyphEdge edge = {(float)v[0], (float)v[1], (float)v[2], (float)v[3], (float)v[4], (float)v[5], true};
+		double sampled = INFINITY;
+		for(int s = 0; s <= 20000; s++){
+			const double t = s / 20000.0;
+			const double x = ((1 - t) * (1 - t) * v[0]) + (2 * (1 - t) * t * v[2]) + (t * t * v[4]);
+			const double y = ((1 - t) * (1 - t) * v[1]) + (2 * (1 - t) * t * v[3]) + (t * t * v[5]);
+			sampled = fmin(sampled, sqrt(((x - v[6]) * (x - v[6])) + ((y - v[7]) * (y - v[7]))));
+		}
+		const double exact = sqrt(GlyphSdf_distanceSqToQuad_inline_(v[6], v[7], &edge));
+		EXPECT_TRUE(exact <= sampled + 1e-6);
+		EXPECT_TRUE(sampled - exact < 0.01);
+	}
+
+	// .notdef(外枠400x500 - 穴300x400)を0.1倍: 枠の太さ5pixel, spread 4
+	GlyphSdf glyphSdf = {0};
+	GlyphDescriptionBuf glyphDescriptionBuf = {0};
+	GlyphOutline outline = GlyphOutline_Notdef();
+	GlyphDescriptionBuf_setOutline(&glyphDescriptionBuf, &outline);
+	EXPECT_TRUE(GlyphSdf_computeGlyph(&glyphSdf, glyphDescriptionBuf.data, glyphDescriptionBuf.dataSize, 102.4, 1024, 4.0));
+	EXPECT_EQ_UINT(48, glyphSdf.width);
+	EXPECT_EQ_UINT(58, glyphSdf.height);
+	EXPECT_EQ_UINT(207, glyphSdf.sdf[(29 * 48) + 6]);	// 枠の中央(内側2.5pixel)
+	EXPECT_EQ_UINT(48, glyphSdf.sdf[(29 * 48) + 1]);	// 外側2.5pixel
+	EXPECT_EQ_UINT(0, glyphSdf.sdf[(29 * 48) + 24]);	// 穴の中央
+	EXPECT_EQ_UINT(0, glyphSdf.sdf[0]);
+	EXPECT_TRUE(! GlyphSdf_computeGlyph(&glyphSdf, glyphDescriptionBuf.data, 12, 102.4, 1024, 4.0));
+	EXPECT_TRUE(GlyphSdf_computeGlyph(&glyphSdf, NULL, 0, 102.4, 1024, 4.0));
+	EXPECT_EQ_UINT(0, glyphSdf.width);
+	GlyphSdf_free(&glyphSdf);
+
+	// skyline: 重ならず、幅と高さに収まる
+	{
+		SkylinePacker packer;
+		SkylinePacker_init(&packer, 64);
+		size_t rects[100][4];
+		for(size_t i = 0; i < 100; i++){
+			seed = seed * 1103515245u + 12345u;
+			rects[i][2] = 1 + ((seed >> 16) % 20);
+			seed = seed * 1103515245u + 12345u;
+			rects[i][3] = 1 + ((seed >> 16) % 20);
+			EXPECT_TRUE(SkylinePacker_insert(&packer, rects[i][2], rects[i][3], &rects[i][0], &rects[i][1]));
+			EXPECT_TRUE(rects[i][0] + rects[i][2] <= 64);
+			EXPECT_TRUE(rects[i][1] + rects[i][3] <= packer.height);
+		}
+		for(size_t i = 0; i < 100; i++){
+			for(size_t k = i + 1; k < 100; k++){
+				const bool isSeparated = (rects[i][0] + rects[i][2] <= rects[k][0]) || (rects[k][0] + rects[k][2] <= rects[i][0])
+					|| (rects[i][1] + rects[i][3] <= rects[k][1]) || (rects[k][1] + rects[k][3] <= rects[i][1]);
+				EXPECT_TRUE(isSeparated);
+			}
+		}
+		size_t x, y;
+		EXPECT_TRUE(! SkylinePacker_insert(&packer, 65, 1, &x, &y));
+		SkylinePacker_free(&packer);
+	}
+
+	DEBUG_LOG("out");
+}
+
+void glyphSdfAtlas_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "AtlasTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 0x3042, contours, 1, 600, 0, NULL));
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffBuilder_free(builder);
+
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	MaxpTable_Version05 maxp;
+	HheaTable hhea;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_maxp(&parser, &maxp));
+	EXPECT_EQ_UINT(5, maxp.numGlyphs);
+	EXPECT_EQ_INT(FontParseError_None, FontParser_hhea(&parser, &hhea));
+	EXPECT_EQ_INT(800, hhea.ascender);
+
+	// 'hmtx'
+	FontParseHmtx hmtx;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_hmtx(&parser, hhea.numberOfHMetrics, maxp.numGlyphs, &hmtx));
+	uint16_t advanceWidth;
+	int16_t lsb;
+	EXPECT_EQ_INT(FontParseError_None, FontParseHmtx_metric(&hmtx, 4, &advanceWidth, &lsb));
+	EXPECT_EQ_UINT(600, advanceWidth);
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParseHmtx_metric(&hmtx, 5, &advanceWidth, &lsb));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParser_hmtx(&parser, 0, maxp.numGlyphs, &hmtx));
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_hmtx(&parser, hhea.numberOfHMetrics, 0xFFFF, &hmtx));
+
+	// 'cmap'のUnicode subtable
+	FontParseCmap cmap;
+	FontSpan subtable;
+	CmapPageTable cmapPageTable;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_cmap(&parser, &cmap));
+	EXPECT_EQ_INT(FontParseError_None, FontParseCmap_unicodeSubtable(&cmap, &subtable));
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&cmapPageTable, subtable, maxp.numGlyphs));
+	EXPECT_EQ_UINT(3, CmapPageTable_glyphId(&cmapPageTable, 'A'));
+	EXPECT_EQ_UINT(4, CmapPageTable_glyphId(&cmapPageTable, 0x3042));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&cmapPageTable, 'B'));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&cmapPageTable, 0x1F600));
+	CmapPageTable_free(&cmapPageTable);
+	FontParseCmap_free(&cmap);
+
+	// atlas: 2 glyph(400x400 -> 40x40 + spread)を2 threadで
+	const uint16_t glyphIds[] = {3, 4,};
+	GlyphSdfAtlas atlas;
+	EXPECT_TRUE(GlyphSdfAtlas_build(&atlas, &parser, glyphIds, 2, 102.4, 3.0, 2));
+	EXPECT_EQ_UINT(46, atlas.glyphs[0].width);
+	EXPECT_EQ_UINT(46, atlas.glyphs[1].height);
+	EXPECT_EQ_UINT(500, atlas.glyphs[0].advanceWidth);
+	EXPECT_EQ_UINT(600, atlas.glyphs[1].advanceWidth);
+	EXPECT_TRUE(atlas.glyphs[0].atlasX != atlas.glyphs[1].atlasX || atlas.glyphs[0].atlasY != atlas.glyphs[1].atlasY);
+	EXPECT_TRUE(46 * 2 <= atlas.width * atlas.height / 46);
+	const GlyphSdfAtlasGlyph *glyph = &atlas.glyphs[1];
+	EXPECT_TRUE(128 < atlas.pixels[((glyph->atlasY + 23) * atlas.width) + glyph->atlasX + 23]);
+	EXPECT_EQ_UINT(0, atlas.pixels[(glyph->atlasY * atlas.width) + glyph->atlasX]);
+	GlyphSdfAtlas_free(&atlas);
+	FontParser_free(&parser);
+
+	// Tableの無いデータ: 全glyphが不正
+	const uint8_t empty[12] = {0, 1, 0, 0,};
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, empty, sizeof(empty)));
+	EXPECT_TRUE(! GlyphSdfAtlas_build(&atlas, &parser, glyphIds, 2, 102.4, 3.0, 2));
+	EXPECT_TRUE(! atlas.glyphs[0].isValid);
+	EXPECT_EQ_UINT(0, atlas.width);
+	GlyphSdfAtlas_free(&atlas);
+	FontParser_free(&parser);
+	free(data);
+
+	DEBUG_LOG("out");
+}
+
+void textMeasure_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "MeasureTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 510, 0, NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, ' ', NULL, 0, 250, 0, NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 0x3042, contours, 1, 1000, 0, NULL));
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffBuilder_free(builder);
+
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	TextMeasure measure;
+	EXPECT_EQ_INT(FontParseError_None, TextMeasure_init(&measure, &parser));
+	const uint16_t notdefAdvance = measure.advanceWidths[0];
+	EXPECT_EQ_UINT(6, measure.numGlyphs);
+	EXPECT_EQ_UINT(0, TextMeasure_glyphIdOfCodepoint(&measure, 'B'));
+	EXPECT_EQ_UINT(0, TextMeasure_glyphIdOfCodepoint(&measure, 0x1F600));
+	FontParser_free(&parser);
+	free(data);
+
+	EXPECT_EQ_UINT(510, TextMeasure_advanceOfCodepoint(&measure, 'A'));
+	EXPECT_EQ_UINT(1000, TextMeasure_advanceOfCodepoint(&measure, 0x3042));
+	EXPECT_EQ_UINT(notdefAdvance, TextMeasure_advanceOfCodepoint(&measure, 'B'));
+	TextMeasureResult result;
+	const char *text = "A A\xE3\x81\x82" "B";
+	EXPECT_TRUE(TextMeasure_measureUtf8(&measure, text, strlen(text), &result));
+	EXPECT_EQ_UINT(510 + 250 + 510 + 1000 + notdefAdvance, result.advance);
+	EXPECT_EQ_UINT(5, result.charNum);
+	EXPECT_EQ_UINT(1, result.unmappedNum);
+	// 不正なUTF-8: 手前までの値を返す
+	EXPECT_TRUE(! TextMeasure_measureUtf8(&measure, "AA\xE3\x81", 4, &result));
+	EXPECT_EQ_UINT(2, result.charNum);
+	EXPECT_EQ_UINT(1020, result.advance);
+	TextMeasure_free(&measure);
+
+	// cmap format 12(BMP外を含む): group 2つ + 順序違反のgroup(捨てる)
+	const uint32_t groups[][3] = {{0x41, 0x43, 1}, {0x1F600, 0x1F601, 10}, {0x50, 0x51, 20},};
+	uint8_t subtableData[16 + (12 * 3)] = {0, 12,};
+	subtableData[7] = sizeof(subtableData);
+	subtableData[15] = 3;
+	for(size_t i = 0; i < 3; i++){
+		for(size_t k = 0; k < 3; k++){
+			const uint32_t v = htonl(groups[i][k]);
+			memcpy(&subtableData[16 + (12 * i) + (4 * k)], &v, 4);
+		}
+	}
+	measure = (TextMeasure){.numGlyphs = 100};
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&measure.cmap, (FontSpan){subtableData, sizeof(subtableData)}, 100));
+	EXPECT_EQ_UINT(3 + 2, measure.cmap.mappedNum);
+	EXPECT_EQ_UINT(2, TextMeasure_glyphIdOfCodepoint(&measure, 0x42));
+	EXPECT_EQ_UINT(11, TextMeasure_glyphIdOfCodepoint(&measure, 0x1F601));
+	EXPECT_EQ_UINT(0, TextMeasure_glyphIdOfCodepoint(&measure, 0x1F602));
+	EXPECT_EQ_UINT(0, TextMeasure_glyphIdOfCodepoint(&measure, 0x44));
+	EXPECT_EQ_UINT(0, TextMeasure_glyphIdOfCodepoint(&measure, 0x40));
+	TextMeasure_free(&measure);
+
+	DEBUG_LOG("out");
+}
+
+void fontFile_test()
+{
+	DEBUG_LOG("in");
+
+	char path[] = "/tmp/daisyff_test_XXXXXX";
+	const int fd = mkstemp(path);
+	EXPECT_TRUE(-1 != fd);
+	const uint8_t bytes[] = {0x00, 0x01, 0x00, 0x00, 0x12, 0x34,};
+	EXPECT_TRUE(sizeof(bytes) == write(fd, bytes, sizeof(bytes)));
+	close(fd);
+
+	FontFile file;
+	EXPECT_TRUE(FontFile_open(&file, path));
+	EXPECT_TRUE(NULL != file.mapped);
+	EXPECT_EQ_UINT(sizeof(bytes), file.size);
+	EXPECT_TRUE(NULL != FontFile_view(&file, 0, sizeof(bytes)));
+	EXPECT_TRUE(NULL != FontFile_view(&file, sizeof(bytes), 0));
+	EXPECT_TRUE(NULL == FontFile_view(&file, 4, 3));
+	EXPECT_TRUE(NULL == FontFile_view(&file, 7, 0));
+	EXPECT_TRUE(NULL == FontFile_view(&file, 1, SIZE_MAX));
+	uint16_t value;
+	EXPECT_TRUE(FontFile_copyRange(&file, &value, 4, sizeof(value)));
+	EXPECT_EQ_UINT(0x1234, ntohs(value));
+	EXPECT_TRUE(! FontFile_copyRange(&file, &value, 5, sizeof(value)));
+	FontFile_close(&file);
+	unlink(path);
+
+	EXPECT_TRUE(! FontFile_open(&file, path));
+
+	DEBUG_LOG("out");
+}
+
+/** @brief 'head'から'glyf'の全glyphまでを解析する(threadと壊れたデータの試験用)
+  @return 最初のエラー。*pSumには全点の絶対座標の和を返す
+  */
+FontParseError fontParser_parseAll(const uint8_t *data, size_t size, int64_t *pSum)
+{
+	*pSum = 0;
+	FontParser parser;
+	FontParseError error = FontParser_init(&parser, data, size);
+	if(FontParseError_None != error){
+		FontParser_free(&parser);
+		return error;
+	}
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	FontParseCmap cmap;
+	FontParseLoca loca = {0};
+	FontParseGlyph glyph = {0};
+	FontSpan glyf;
+	if(FontParseError_None == error){ error = FontParser_head(&parser, &head); }
+	if(FontParseError_None == error){ error = FontParser_maxp(&parser, &maxp); }
+	if(FontParseError_None == error){
+		error = FontParser_cmap(&parser, &cmap);
+		for(size_t i = 0; FontParseError_None == error && i < cmap.header.numTables; i++){
+			uint16_t format;
+			error = FontParseCmap_subtableFormat(&cmap, i, &format);
+			if(FontParseError_None == error && 0 == format){
+				FontParseCmapFormat0 format0;
+				error = FontParseCmap_format0(&cmap, i, &format0);
+			}
+			if(FontParseError_None == error && 4 == format){
+				FontParseCmapFormat4 format4;
+				error = FontParseCmap_format4(&cmap, i, &format4);
+				FontParseCmapFormat4_free(&format4);
+			}
+		}
+		FontParseCmap_free(&cmap);
+	}
+	if(FontParseError_None == error){ error = FontParser_loca(&parser, head.indexToLocFormat, maxp.numGlyphs, &loca); }
+	if(FontParseError_None == error){ error = FontParser_table(&parser, "glyf", &glyf); }
+	for(size_t g = 0; FontParseError_None == error && g < maxp.numGlyphs; g++){
+		error = FontParser_glyph(glyf, loca.offsets[g], loca.offsets[g + 1], &glyph);
+		for(size_t i = 0; i < glyph.pointNum; i++){
+			*pSum += glyph.points[i].abs.x + glyph.points[i].abs.y;
+		}
+	}
+	FontParseGlyph_free(&glyph);
+	FontParseLoca_free(&loca);
+	FontParser_free(&parser);
+	return error;
+}
+
+typedef struct{
+	const uint8_t	*data;
+	size_t		size;
+	int64_t		sum;
+	int		errorNum;
+}FontParserTestThread;
+
+void *fontParser_thread(void *arg)
+{
+	FontParserTestThread *thread = (FontParserTestThread *)arg;
+	for(int i = 0; i < 200; i++){
+		int64_t sum;
+		thread->errorNum += (FontParseError_None != fontParser_parseAll(thread->data, thread->size, &sum))? 1 : 0;
+		thread->sum = sum;
+	}
+	return NULL;
+}
+
+void fontParser_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "ParserTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 0x3042, contours, 1, 600, 0, NULL));
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffBuilder_free(builder);
+
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	EXPECT_EQ_UINT(0x00010000, parser.offsetTable.sfntVersion);
+	FontSpan table;
+	EXPECT_EQ_INT(FontParseError_NotFound, FontParser_table(&parser, "CFF ", &table));
+	HeadTable head;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_head(&parser, &head));
+	EXPECT_EQ_UINT(0x5F0F3CF5, head.magicNumber);
+	MaxpTable_Version05 maxp;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_maxp(&parser, &maxp));
+	EXPECT_EQ_UINT(5, maxp.numGlyphs);
+
+	// cmap format 4: 'A' -> 3
+	FontParseCmap cmap;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_cmap(&parser, &cmap));
+	bool isFormat4Found = false;
+	for(size_t i = 0; i < cmap.header.numTables; i++){
+		uint16_t format;
+		EXPECT_EQ_INT(FontParseError_None, FontParseCmap_subtableFormat(&cmap, i, &format));
+		if(4 != format){
+			continue;
+		}
+		FontParseCmapFormat4 format4;
+		EXPECT_EQ_INT(FontParseError_None, FontParseCmap_format4(&cmap, i, &format4));
+		EXPECT_EQ_UINT('A', format4.startCode[0]);
+		EXPECT_EQ_UINT(3, (uint16_t)('A' + format4.idDelta[0]));
+		EXPECT_EQ_UINT(0xFFFF, format4.endCode[format4.segCountX2 / 2 - 1]);
+		FontParseCmapFormat4_free(&format4);
+		isFormat4Found = true;
+	}
+	EXPECT_TRUE(isFormat4Found);
+	FontParseCmap_free(&cmap);
+
+	// glyph 3: 入力した点(絶対座標)に戻る
+	FontParseLoca loca;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_loca(&parser, head.indexToLocFormat, maxp.numGlyphs, &loca));
+	EXPECT_EQ_UINT(6, loca.num);
+	FontSpan glyf;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "glyf", &glyf));
+	FontParseGlyph glyph = {0};
+	EXPECT_EQ_INT(FontParseError_None, FontParser_glyph(glyf, loca.offsets[3], loca.offsets[4], &glyph));
+	EXPECT_EQ_INT(1, glyph.header.numberOfContours);
+	EXPECT_EQ_UINT(4, glyph.pointNum);
+	size_t pointNum;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_glyphPointNum(glyf, loca.offsets[3], loca.offsets[4], &pointNum));
+	EXPECT_EQ_UINT(4, pointNum);
+	for(size_t i = 0; i < 4; i++){
+		bool isFound = false;
+		for(size_t k = 0; k < 4; k++){
+			isFound = isFound || (points[k].x == glyph.points[i].abs.x && points[k].y == glyph.points[i].abs.y);
+		}
+		EXPECT_TRUE(isFound);
+	}
+	// 範囲外・逆順のloca
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_glyph(glyf, loca.offsets[3], (uint32_t)glyf.size + 1, &glyph));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParser_glyph(glyf, loca.offsets[4], loca.offsets[3], &glyph));
+	EXPECT_EQ_UINT(0, glyph.pointNum);
+	FontParseGlyph_free(&glyph);
+	// 1 glyph分だけ読むlocaは展開したlocaと一致する
+	for(size_t glyphId = 0; glyphId < maxp.numGlyphs; glyphId++){
+		uint32_t offset;
+		uint32_t nextOffset;
+		EXPECT_EQ_INT(FontParseError_None, FontParser_locaEntry(&parser, head.indexToLocFormat, maxp.numGlyphs, glyphId, &offset, &nextOffset));
+		EXPECT_EQ_UINT(loca.offsets[glyphId], offset);
+		EXPECT_EQ_UINT(loca.offsets[glyphId + 1], nextOffset);
+	}
+	uint32_t locaEntry[2];
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_locaEntry(&parser, head.indexToLocFormat, maxp.numGlyphs, maxp.numGlyphs, &locaEntry[0], &locaEntry[1]));
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_locaEntry(&parser, head.indexToLocFormat, 10000, 0, &locaEntry[0], &locaEntry[1]));
+	// mapping上から直接引くlocaも展開したlocaと一致し、昇順・'glyf'の範囲を確かめる
+	FontParseLocaView locaView;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_locaView(&parser, head.indexToLocFormat, maxp.numGlyphs, &locaView));
+	EXPECT_EQ_UINT(loca.num, locaView.num);
+	for(size_t i = 0; i < loca.num; i++){
+		EXPECT_EQ_UINT(loca.rawOffsets[i], FontParseLocaView_raw(&locaView, i));
+		EXPECT_EQ_UINT(loca.offsets[i], FontParseLocaView_offset(&locaView, i));
+	}
+	const size_t lastGlyphId = maxp.numGlyphs - 1;
+	EXPECT_EQ_INT(FontParseError_None, FontParseLocaView_entry(&locaView, lastGlyphId, glyf.size, &locaEntry[0], &locaEntry[1]));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParseLocaView_entry(&locaView, lastGlyphId, locaEntry[1] - 1, &locaEntry[0], &locaEntry[1]));
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParseLocaView_entry(&locaView, maxp.numGlyphs, glyf.size, &locaEntry[0], &locaEntry[1]));
+	uint8_t *locaData = (uint8_t *)&locaView.table.data[0];
+	const size_t entrySize = (0 == head.indexToLocFormat)? 2 : 4;
+	uint8_t saved[4];
+	memcpy(saved, &locaData[lastGlyphId * entrySize], entrySize);
+	memset(&locaData[lastGlyphId * entrySize], 0xFF, entrySize); // 次のentryより大きい
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParseLocaView_entry(&locaView, lastGlyphId, glyf.size, &locaEntry[0], &locaEntry[1]));
+	EXPECT_TRUE(locaEntry[1] < locaEntry[0]);
+	memcpy(&locaData[lastGlyphId * entrySize], saved, entrySize);
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_locaView(&parser, head.indexToLocFormat, 10000, &locaView));
+	FontParseLoca_free(&loca);
+	// 解析するTableの終端(これより短いデータはエラーになる)
+	size_t parsedEnd = 0;
+	const char *tags[] = {"head", "maxp", "cmap", "loca", "glyf",};
+	for(size_t i = 0; i < sizeof(tags) / sizeof(tags[0]); i++){
+		const TableDirectory_Member *member = FontParser_queryTag(&parser, tags[i]);
+		EXPECT_TRUE(NULL != member);
+		parsedEnd = (parsedEnd < member->offset + member->length)? (member->offset + member->length) : parsedEnd;
+	}
+	FontParser_free(&parser);
+
+	int64_t expectSum;
+	EXPECT_EQ_INT(FontParseError_None, fontParser_parseAll(data, size, &expectSum));
+
+	// 途中で切れたデータ・壊れたデータ: エラーを返して落ちない
+	for(size_t cut = 0; cut < size; cut++){
+		uint8_t *partial = (uint8_t *)ffmalloc(cut + 1);
+		memcpy(partial, data, cut);
+		int64_t sum;
+		const FontParseError error = fontParser_parseAll(partial, cut, &sum);
+		EXPECT_TRUE((FontParseError_None != error) == (cut < parsedEnd));
+		free(partial);
+	}
+	uint8_t *broken = (uint8_t *)ffmalloc(size);
+	uint32_t random = 2463534242;
+	for(int trial = 0; trial < 2000; trial++){
+		memcpy(broken, data, size);
+		for(int i = 0; i < 4; i++){
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			broken[random % size] = (uint8_t)(random >> 24);
+		}
+		int64_t sum;
+		fontParser_parseAll(broken, size, &sum);
+	}
+	free(broken);
+
+	// 大域状態を持たないので複数threadで同時に解析できる
+	FontParserTestThread threads[4];
+	pthread_t threadIds[4];
+	for(int i = 0; i < 4; i++){
+		threads[i] = (FontParserTestThread){data, size, 0, 0};
+		EXPECT_EQ_INT(0, pthread_create(&threadIds[i], NULL, fontParser_thread, &threads[i]));
+	}
+	for(int i = 0; i < 4; i++){
+		EXPECT_EQ_INT(0, pthread_join(threadIds[i], NULL));
+		EXPECT_EQ_INT(0, threads[i].errorNum);
+		EXPECT_EQ_INT(expectSum, threads[i].sum);
+	}
+	free(data);
+
+	DEBUG_LOG("out");
+}
+
+void cmapPageTable_test()
+{
+	DEBUG_LOG("in");
+
+	CmapPageTable table;
+	// format 0
+	uint8_t format0[6 + 256] = {0, 0, 0x01, 0x06,};
+	format0[6 + 'A'] = 3;
+	format0[6 + 0xE9] = 7;
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&table, (FontSpan){format0, sizeof(format0)}, 5));
+	EXPECT_EQ_UINT(3, CmapPageTable_glyphId(&table, 'A'));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0xE9)); // numGlyphs以上は割り当て無し
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0x141));
+	EXPECT_EQ_UINT(1, table.mappedNum);
+	EXPECT_EQ_UINT(2, table.pageNum);
+	CmapPageTable_free(&table);
+	EXPECT_EQ_INT(FontParseError_OutOfRange, CmapPageTable_build(&table, (FontSpan){format0, 100}, 5));
+	CmapPageTable_free(&table);
+
+	// format 4: delta segment, idRangeOffset segment, 終端segment
+	const uint16_t format4[] = {
+		4, 0, 0, 6, 0, 0, 0,		// format, length, language, segCountX2, ...
+		0x0042, 0x3043, 0xFFFF,		// endCode
+		0,				// reservedPad
+		0x0041, 0x3042, 0xFFFF,		// startCode
+		(uint16_t)-60, 10, 1,		// idDelta
+		0, 4, 0,			// idRangeOffset(自身の位置からglyphIdArrayまで)
+		5, 0,				// glyphIdArray
+	};
+	uint16_t format4Be[sizeof(format4) / sizeof(format4[0])];
+	for(size_t i = 0; i < sizeof(format4) / sizeof(format4[0]); i++){
+		format4Be[i] = htons(format4[i]);
+	}
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&table, (FontSpan){(const uint8_t *)format4Be, sizeof(format4Be)}, 100));
+	EXPECT_EQ_UINT(5, CmapPageTable_glyphId(&table, 'A'));
+	EXPECT_EQ_UINT(6, CmapPageTable_glyphId(&table, 'B'));
+	EXPECT_EQ_UINT(15, CmapPageTable_glyphId(&table, 0x3042));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0x3043));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0xFFFF));
+	EXPECT_EQ_UINT(3, table.mappedNum);
+	EXPECT_EQ_UINT(3, table.pageNum);
+	EXPECT_EQ_UINT(sizeof(table.pageIndexes) + (3 * 256 * 2), CmapPageTable_memorySize(&table));
+	CmapPageTable_free(&table);
+
+	// format 6, 13
+	const uint16_t format6[] = {htons(6), 0, 0, htons(0xF600), htons(2), htons(8), htons(9),};
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&table, (FontSpan){(const uint8_t *)format6, sizeof(format6)}, 100));
+	EXPECT_EQ_UINT(8, CmapPageTable_glyphId(&table, 0xF600));
+	EXPECT_EQ_UINT(9, CmapPageTable_glyphId(&table, 0xF601));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0xF602));
+	CmapPageTable_free(&table);
+	uint8_t format13[16 + 12] = {0, 13,};
+	format13[15] = 1;
+	const uint32_t group[] = {htonl(0x20000), htonl(0x2FFFF), htonl(4),};
+	memcpy(&format13[16], group, sizeof(group));
+	EXPECT_EQ_INT(FontParseError_None, CmapPageTable_build(&table, (FontSpan){format13, sizeof(format13)}, 100));
+	EXPECT_EQ_UINT(4, CmapPageTable_glyphId(&table, 0x2ABCD));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0x30000));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 0x110000));
+	EXPECT_EQ_UINT(0x10000, table.mappedNum);
+	CmapPageTable_free(&table);
+
+	// 未対応のformat
+	const uint16_t format2[] = {htons(2), 0, 0,};
+	EXPECT_EQ_INT(FontParseError_Unsupported, CmapPageTable_build(&table, (FontSpan){(const uint8_t *)format2, sizeof(format2)}, 100));
+	EXPECT_EQ_UINT(0, CmapPageTable_glyphId(&table, 'A'));
+	CmapPageTable_free(&table);
+
+	DEBUG_LOG("out");
+}
+
+typedef struct{
+	pthread_mutex_t		mutex;
+	int			*visitNums;
+	size_t			workerMax;
+}WorkStealingPoolTestContext;
+
+void workStealingPool_task(void *context_, size_t index, size_t workerIndex)
+{
+	WorkStealingPoolTestContext *context = (WorkStealingPoolTestContext *)context_;
+	// 先頭の添字ほど重くし、偏った分担を盗んで均す
+	volatile uint64_t sum = 0;
+	for(size_t i = 0; i < (index < 16 ? 200000 : 100); i++){
+		sum += i;
+	}
+	pthread_mutex_lock(&context->mutex);
+	context->visitNums[index]++;
+	context->workerMax = (context->workerMax < workerIndex)? workerIndex : context->workerMax;
+	pthread_mutex_unlock(&context->mutex);
+}
+
+void workStealingPool_test()
+{
+	DEBUG_LOG("in");
+
+	const size_t threadNums[] = {1, 8, 0};
+	const size_t taskNums[] = {0, 1, 3, 1000};
+	for(size_t t = 0; t < sizeof(threadNums) / sizeof(threadNums[0]); t++){
+		for(size_t n = 0; n < sizeof(taskNums) / sizeof(taskNums[0]); n++){
+			WorkStealingPoolTestContext context = {
+				.visitNums = (int *)ffmalloc(sizeof(int) * (taskNums[n] + 1)),
+			};
+			pthread_mutex_init(&context.mutex, NULL);
+			const size_t stealNum = WorkStealingPool_run(taskNums[n], threadNums[t], workStealingPool_task, &context);
+			for(size_t i = 0; i < taskNums[n]; i++){
+				EXPECT_EQ_INT(1, context.visitNums[i]);
+			}
+			if(1 == threadNums[t]){
+				EXPECT_EQ_UINT(0, stealNum);
+				EXPECT_EQ_UINT(0, context.workerMax);
+			}
+			if(0 != threadNums[t]){
+				EXPECT_TRUE(context.workerMax < threadNums[t]);
+			}
+			pthread_mutex_destroy(&context.mutex);
+			free(context.visitNums);
+		}
+	}
+
+	DEBUG_LOG("out");
+}
+
+void fontValidator_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "ValidatorTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, NULL));
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffBuilder_free(builder);
+
+	FontValidation validation = {0};
+	FontValidator_validateData(data, size, &validation);
+	EXPECT_EQ_UINT(0, validation.errorNum);
+	FontValidation_free(&validation);
+
+	// 不正な値は終了せずにエラーとして集める
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	const uint32_t headOffset = FontParser_queryTag(&parser, "head")->offset;
+	FontParser_free(&parser);
+	uint8_t *broken = (uint8_t *)ffmalloc(size);
+	memcpy(broken, data, size);
+	broken[headOffset + 12] ^= 0xFF;	// magicNumber
+	broken[headOffset + 18] = 0;		// unitsPerEm
+	broken[headOffset + 19] = 1;
+	FontValidator_validateData(broken, size, &validation);
+	EXPECT_EQ_UINT(4, validation.errorNum);
+	EXPECT_TRUE(NULL != strstr(validation.errors[0], "table 'head' checksum"));
+	EXPECT_TRUE(NULL != strstr(validation.errors[1], "checkSumAdjustment"));
+	EXPECT_TRUE(NULL != strstr(validation.errors[2], "magicNumber"));
+	EXPECT_TRUE(NULL != strstr(validation.errors[3], "unitsPerEm 1"));
+	FontValidation_free(&validation);
+
+	// 途中で切れたファイル
+	for(size_t cut = 0; cut < size; cut += 7){
+		FontValidator_validateData(data, cut, &validation);
+		EXPECT_TRUE(0 < validation.errorNum);
+		FontValidation_free(&validation);
+	}
+
+	// 開けないファイル
+	EXPECT_TRUE(! FontValidator_validateFile("/nonexistent/font.otf", &validation));
+	EXPECT_EQ_UINT(1, validation.errorNum);
+	FontValidation_free(&validation);
+
+	free(broken);
+	free(data);
+
+	DEBUG_LOG("out");
+}
+
+void jsonWriter_test()
+{
+	DEBUG_LOG("in");
+
+	static JsonWriter writer;
+	FILE *fp = tmpfile();
+	ASSERT(fp);
+	JsonWriter_init(&writer, fp);
+	JsonWriter_beginObject(&writer);
+	JsonWriter_keyString(&writer, "s", "a\"b\\c\n\x01");
+	JsonWriter_keyInt(&writer, "min", INT64_MIN);
+	JsonWriter_keyInt(&writer, "neg", -120);
+	JsonWriter_keyUint(&writer, "max", UINT64_MAX);
+	JsonWriter_keyUint(&writer, "zero", 0);
+	JsonWriter_keyBool(&writer, "b", false);
+	JsonWriter_key(&writer, "a");
+	JsonWriter_beginArray(&writer);
+	JsonWriter_beginArray(&writer);
+	JsonWriter_int(&writer, -1);
+	JsonWriter_uint(&writer, 2);
+	JsonWriter_endArray(&writer);
+	JsonWriter_beginArray(&writer);
+	JsonWriter_endArray(&writer);
+	JsonWriter_beginObject(&writer);
+	JsonWriter_endObject(&writer);
+	JsonWriter_endArray(&writer);
+	JsonWriter_endObject(&writer);
+	JsonWriter_endLine(&writer);
+	JsonWriter_beginObject(&writer);
+	JsonWriter_endObject(&writer);
+	JsonWriter_endLine(&writer);
+	const char *expected =
+		"{\"s\":\"a\\\"b\\\\c\\u000a\\u0001\",\"min\":-9223372036854775808,\"neg\":-120,"
+		"\"max\":18446744073709551615,\"zero\":0,\"b\":false,\"a\":[[-1,2],[],{}]}\n{}\n";
+	EXPECT_TRUE(JsonWriter_flush(&writer));
+	EXPECT_EQ_UINT(strlen(expected), (size_t)ftell(fp));
+	char actual[256] = {0};
+	rewind(fp);
+	EXPECT_EQ_UINT(strlen(expected), fread(actual, 1, sizeof(actual), fp));
+	EXPECT_EQ_INT(0, strcmp(expected, actual));
+	fclose(fp);
+
+	// bufferより大きい出力は途中で書き出す
+	fp = tmpfile();
+	ASSERT(fp);
+	JsonWriter_init(&writer, fp);
+	JsonWriter_beginArray(&writer);
+	for(uint64_t i = 0; i < 100000; i++){
+		JsonWriter_uint(&writer, i);
+	}
+	JsonWriter_endArray(&writer);
+	EXPECT_TRUE(JsonWriter_flush(&writer));
+	size_t expectedSize = 2 + (100000 - 1);
+	for(uint64_t i = 0; i < 100000; i++){
+		expectedSize += (i < 10)? 1 : (i < 100)? 2 : (i < 1000)? 3 : (i < 10000)? 4 : 5;
+	}
+	EXPECT_EQ_UINT(expectedSize, (size_t)ftell(fp));
+	fclose(fp);
+
+	DEBUG_LOG("out");
+}
+
+//! @brief composite glyphのheader(numberOfContours = -1, bboxは0)
+void compositeGlyphTest_header(FFByteArray *glyph)
+{
+	testBytes_appendU16(glyph, 0xFFFF);
+	for(int i = 0; i < 4; i++){
+		testBytes_appendU16(glyph, 0);
+	}
+}
+
+//! @brief 部品1つ(引数はbyte, XY)だけのcomposite glyph
+void compositeGlyphTest_reference(FFByteArray *glyph, uint16_t glyphIndex)
+{
+	compositeGlyphTest_header(glyph);
+	testBytes_appendU16(glyph, ComponentFlag_ARGS_ARE_XY_VALUES);
+	testBytes_appendU16(glyph, glyphIndex);
+	testBytes_appendU16(glyph, 0);
+}
+
+//! @brief 'loca'(long), 'glyf'だけのsfntを作る
+uint8_t *compositeGlyphTest_font(const FFByteArray *glyphs, size_t numGlyphs, size_t *size)
+{
+	FFByteArray glyf = {0};
+	FFByteArray loca = {0};
+	for(size_t i = 0; i < numGlyphs; i++){
+		testBytes_appendU32(&loca, (uint32_t)glyf.length);
+		if(0 < glyphs[i].length){
+			FFByteArray_appendArray(&glyf, glyphs[i]);
+		}
+	}
+	testBytes_appendU32(&loca, (uint32_t)glyf.length);
+
+	FFByteArray font = {0};
+	const uint32_t headerSize = 12 + (16 * 2);
+	testBytes_appendU32(&font, 0x00010000);
+	testBytes_appendU16(&font, 2);
+	testBytes_appendU16(&font, 32);
+	testBytes_appendU16(&font, 1);
+	testBytes_appendU16(&font, 0);
+	testBytes_appendU32(&font, 0x676C7966); // 'glyf'
+	testBytes_appendU32(&font, 0);
+	testBytes_appendU32(&font, headerSize);
+	testBytes_appendU32(&font, (uint32_t)glyf.length);
+	testBytes_appendU32(&font, 0x6C6F6361); // 'loca'
+	testBytes_appendU32(&font, 0);
+	testBytes_appendU32(&font, headerSize + (uint32_t)glyf.length);
+	testBytes_appendU32(&font, (uint32_t)loca.length);
+	FFByteArray_appendArray(&font, glyf);
+	FFByteArray_appendArray(&font, loca);
+	FFByteArray_free(&glyf);
+	FFByteArray_free(&loca);
+	*size = font.length;
+	return font.data;
+}
+
+void compositeGlyph_test()
+{
+	DEBUG_LOG("in");
+
+	enum{ GLYPH_NUM = 28, CHAIN_BEGIN = 8, };
+	FFByteArray glyphs[GLYPH_NUM] = {{0}};
+	// 0: 正方形(0,0)-(100,100)
+	testBytes_appendU16(&glyphs[0], 1);
+	const uint16_t squareHeader[] = {0, 0, 100, 100, 3, 0,}; // bbox, endPts, instructionLength
+	const int16_t squareXY[] = {0, 0, 100, 0, 0, 100, 0, -100,};
+	for(size_t i = 0; i < sizeof(squareHeader) / sizeof(squareHeader[0]); i++){
+		testBytes_appendU16(&glyphs[0], squareHeader[i]);
+	}
+	for(int i = 0; i < 4; i++){
+		FFByteArray_append(&glyphs[0], "\x01", 1); // OnCurve, long vector
+	}
+	for(size_t i = 0; i < sizeof(squareXY) / sizeof(squareXY[0]); i++){
+		testBytes_appendU16(&glyphs[0], (uint16_t)squareXY[i]);
+	}
+	// 1: glyph 0 を0.5倍して(10, 20)へ(引数はword)
+	compositeGlyphTest_header(&glyphs[1]);
+	testBytes_appendU16(&glyphs[1], ComponentFlag_ARG_1_AND_2_ARE_WORDS | ComponentFlag_ARGS_ARE_XY_VALUES | ComponentFlag_WE_HAVE_A_SCALE);
+	testBytes_appendU16(&glyphs[1], 0);
+	testBytes_appendU16(&glyphs[1], 10);
+	testBytes_appendU16(&glyphs[1], 20);
+	testBytes_appendU16(&glyphs[1], 0x2000);
+	// 2: glyph 1 を(-5, 0)へ、glyph 0 を2x2で90度回転
+	compositeGlyphTest_header(&glyphs[2]);
+	testBytes_appendU16(&glyphs[2], ComponentFlag_ARGS_ARE_XY_VALUES | ComponentFlag_MORE_COMPONENTS);
+	testBytes_appendU16(&glyphs[2], 1);
+	testBytes_appendU16(&glyphs[2], 0xFB00); // (int8)-5, 0
+	testBytes_appendU16(&glyphs[2], ComponentFlag_ARGS_ARE_XY_VALUES | ComponentFlag_WE_HAVE_A_TWO_BY_TWO);
+	testBytes_appendU16(&glyphs[2], 0);
+	testBytes_appendU16(&glyphs[2], 0);
+	const uint16_t rotate[] = {0x0000, 0x4000, 0xC000, 0x0000,};
+	for(int i = 0; i < 4; i++){
+		testBytes_appendU16(&glyphs[2], rotate[i]);
+	}
+	// 3: glyph 0 と、その点2に点0を合わせたglyph 0 (X, Y scale, instructions付き)
+	compositeGlyphTest_header(&glyphs[3]);
+	testBytes_appendU16(&glyphs[3], ComponentFlag_ARGS_ARE_XY_VALUES | ComponentFlag_MORE_COMPONENTS);
+	testBytes_appendU16(&glyphs[3], 0);
+	testBytes_appendU16(&glyphs[3], 0);
+	testBytes_appendU16(&glyphs[3], ComponentFlag_WE_HAVE_AN_X_AND_Y_SCALE | ComponentFlag_WE_HAVE_INSTRUCTIONS);
+	testBytes_appendU16(&glyphs[3], 0);
+	testBytes_appendU16(&glyphs[3], 0x0200); // parent point 2, child point 0
+	testBytes_appendU16(&glyphs[3], 0x4000);
+	testBytes_appendU16(&glyphs[3], 0x8000); // -2.0
+	testBytes_appendU16(&glyphs[3], 2);
+	FFByteArray_append(&glyphs[3], "\xB0\x01", 2);
+	// 4: 自身を参照 5, 6: 互いに参照 7: 存在しないglyph
+	compositeGlyphTest_reference(&glyphs[4], 4);
+	compositeGlyphTest_reference(&glyphs[5], 6);
+	compositeGlyphTest_reference(&glyphs[6], 5);
+	compositeGlyphTest_reference(&glyphs[7], GLYPH_NUM);
+	// 8..26: 次のglyphを参照する深い連鎖、27: glyph 0と同じ
+	for(size_t i = CHAIN_BEGIN; i < GLYPH_NUM - 1; i++){
+		compositeGlyphTest_reference(&glyphs[i], (uint16_t)(i + 1));
+	}
+	FFByteArray_appendArray(&glyphs[GLYPH_NUM - 1], glyphs[0]);
+
+	size_t size;
+	uint8_t *data = compositeGlyphTest_font(glyphs, GLYPH_NUM, &size);
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	FontSpan glyf;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "glyf", &glyf));
+	uint32_t offset;
+	uint32_t nextOffset;
+
+	// 部品の記録
+	FontParseComposite composite = {0};
+	EXPECT_EQ_INT(FontParseError_None, FontParser_locaEntry(&parser, 1, GLYPH_NUM, 3, &offset, &nextOffset));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_compositeGlyph(glyf, offset, nextOffset, &composite));
+	EXPECT_EQ_UINT(2, composite.componentNum);
+	EXPECT_EQ_INT(2, composite.components[1].arg1);
+	EXPECT_EQ_INT(0, composite.components[1].arg2);
+	EXPECT_TRUE(1.0 == composite.components[1].scale[0] && -2.0 == composite.components[1].scale[3]);
+	EXPECT_EQ_UINT(2, composite.instructions.size);
+	EXPECT_EQ_UINT(0xB0, composite.instructions.data[0]);
+	size_t pointNum;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_glyphPointNum(glyf, offset, nextOffset, &pointNum));
+	EXPECT_EQ_UINT(2, pointNum);
+	// 途中で切れた部品
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParser_compositeGlyph(glyf, offset, nextOffset - 4, &composite));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_locaEntry(&parser, 1, GLYPH_NUM, 0, &offset, &nextOffset));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParser_compositeGlyph(glyf, offset, nextOffset, &composite));
+	FontParseComposite_free(&composite);
+
+	// 展開
+	FontParseGlyphResolver resolver;
+	EXPECT_EQ_INT(FontParseError_None, FontParseGlyphResolver_init(&resolver, &parser, 1, GLYPH_NUM));
+	const FontParseOutline *outline;
+	EXPECT_EQ_INT(FontParseError_None, FontParseGlyphResolver_outline(&resolver, 1, &outline));
+	const int32_t expected1[][2] = {{10, 20}, {10, 70}, {60, 70}, {60, 20},};
+	EXPECT_EQ_UINT(4, outline->pointNum);
+	for(size_t i = 0; i < 4; i++){
+		EXPECT_EQ_INT(expected1[i][0], outline->points[i].x);
+		EXPECT_EQ_INT(expected1[i][1], outline->points[i].y);
+	}
+	EXPECT_EQ_UINT(2, resolver.decodeNum);
+	EXPECT_EQ_INT(FontParseError_None, FontParseGlyphResolver_outline(&resolver, 2, &outline));
+	EXPECT_EQ_UINT(3, resolver.decodeNum); // glyph 0, 1は解決済み
+	const int32_t expected2[][2] = {{5, 20}, {5, 70}, {55, 70}, {55, 20}, {0, 0}, {-100, 0}, {-100, 100}, {0, 100},};
+	EXPECT_EQ_UINT(8, outline->pointNum);
+	EXPECT_EQ_UINT(2, outline->contourNum);
+	EXPECT_EQ_UINT(3, outline->endPts[0]);
+	EXPECT_EQ_UINT(7, outline->endPts[1]);
+	for(size_t i = 0; i < 8; i++){
+		EXPECT_EQ_INT(expected2[i][0], outline->points[i].x);
+		EXPECT_EQ_INT(expected2[i][1], outline->points[i].y);
+		EXPECT_TRUE(outline->points[i].isOnCurve);
+	}
+	// 展開したoutlineの描画(0.1倍: (5,20)-(55,70)と(-100,0)-(0,100)の正方形)
+	GlyphRaster raster = {0};
+	EXPECT_TRUE(GlyphRaster_renderOutline(&raster, outline, 102.4, 1024));
+	EXPECT_EQ_UINT(18, raster.width);
+	EXPECT_EQ_UINT(12, raster.height);
+	EXPECT_TRUE(fabs(glyphRasterTest_sum(&raster) - 125.0) < 1.0);
+	EXPECT_EQ_UINT(255, raster.pixels[(6 * 18) + 6]);
+	EXPECT_EQ_UINT(255, raster.pixels[(6 * 18) + 14]);
+	EXPECT_EQ_UINT(0, raster.pixels[(10 * 18) + 14]);
+	EXPECT_TRUE(! GlyphRaster_renderOutline(&raster, outline, 102.4, 0));
+	GlyphRaster_free(&raster);
+	GlyphSdf glyphSdf = {0};
+	EXPECT_TRUE(GlyphSdf_computeOutline(&glyphSdf, outline, 102.4, 1024, 4.0));
+	EXPECT_EQ_UINT(24, glyphSdf.width);
+	EXPECT_EQ_UINT(18, glyphSdf.height);
+	EXPECT_EQ_UINT(255, glyphSdf.sdf[(9 * 24) + 9]);	// 回転した正方形の中
+	EXPECT_TRUE(128 < glyphSdf.sdf[(9 * 24) + 4]);		// 左端(x = 4pixel)の内外
+	EXPECT_TRUE(glyphSdf.sdf[(9 * 24) + 3] < 128);
+	GlyphSdf_free(&glyphSdf);
+	EXPECT_EQ_INT(FontParseError_None, FontParseGlyphResolver_outline(&resolver, 3, &outline));
+	const int32_t expected3[][2] = {{0, 0}, {0, 100}, {100, 100}, {100, 0}, {100, 100}, {100, -100}, {200, -100}, {200, 100},};
+	EXPECT_EQ_UINT(8, outline->pointNum);
+	for(size_t i = 0; i < 8; i++){
+		EXPECT_EQ_INT(expected3[i][0], outline->points[i].x);
+		EXPECT_EQ_INT(expected3[i][1], outline->points[i].y);
+	}
+	EXPECT_EQ_UINT(4, resolver.decodeNum);
+
+	// 循環・存在しない部品・深すぎる参照はエラー(覚えて2度目は解析しない)
+	EXPECT_EQ_INT(FontParseError_Recursion, FontParseGlyphResolver_outline(&resolver, 4, &outline));
+	EXPECT_TRUE(NULL == outline);
+	EXPECT_EQ_INT(FontParseError_Recursion, FontParseGlyphResolver_outline(&resolver, 5, &outline));
+	EXPECT_EQ_INT(FontParseError_Recursion, FontParseGlyphResolver_outline(&resolver, 6, &outline));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParseGlyphResolver_outline(&resolver, 7, &outline));
+	const size_t decodeNum = resolver.decodeNum;
+	EXPECT_EQ_INT(FontParseError_Recursion, FontParseGlyphResolver_outline(&resolver, 4, &outline));
+	EXPECT_EQ_INT(FontParseError_InvalidValue, FontParseGlyphResolver_outline(&resolver, 7, &outline));
+	EXPECT_EQ_UINT(decodeNum, resolver.decodeNum);
+	EXPECT_EQ_INT(FontParseError_Recursion, FontParseGlyphResolver_outline(&resolver, CHAIN_BEGIN, &outline));
+	EXPECT_EQ_INT(FontParseError_None, FontParseGlyphResolver_outline(&resolver, GLYPH_NUM - 3, &outline));
+	EXPECT_EQ_UINT(4, outline->pointNum);
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontParseGlyphResolver_outline(&resolver, GLYPH_NUM, &outline));
+	FontParseGlyphResolver_free(&resolver);
+
+	FontParser_free(&parser);
+	free(data);
+	for(size_t i = 0; i < GLYPH_NUM; i++){
+		FFByteArray_free(&glyphs[i]);
+	}
+
+	DEBUG_LOG("out");
+}
+
+uint32_t glyfDecoderTest_random(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+void glyfDecoder_test()
+{
+	DEBUG_LOG("in");
+
+	{
+		// x: +10(short), -3(short), same, -300(long), 0(long) / y: 500(long), same, +1(short), -2(short), -1(long)
+		const uint8_t flags[] = {0x12, 0x22, 0x34, 0x04, 0x00};
+		const uint8_t data[] = {
+			10, 3, 0xFE, 0xD4, 0x00, 0x00,
+			0x01, 0xF4, 1, 2, 0xFF, 0xFF,
+		};
+		int32_t xs[5];
+		int32_t ys[5];
+		size_t used;
+		EXPECT_TRUE(GlyfDecoder_coordinates(data, sizeof(data), flags, 5, xs, ys, &used));
+		const int32_t expectedX[] = {10, 7, 7, -293, -293,};
+		const int32_t expectedY[] = {500, 500, 501, 499, 498,};
+		EXPECT_EQ_UINT(sizeof(data), used);
+		for(size_t i = 0; i < 5; i++){
+			EXPECT_EQ_INT(expectedX[i], xs[i]);
+			EXPECT_EQ_INT(expectedY[i], ys[i]);
+		}
+		// 最後のyが途中で切れている
+		EXPECT_TRUE(! GlyfDecoder_coordinates(data, sizeof(data) - 1, flags, 5, xs, ys, &used));
+		EXPECT_TRUE(! GlyfDecoder_coordinatesScalar(data, sizeof(data) - 1, flags, 5, xs, ys, &used));
+	}
+
+	// SIMD版とscalar版が同じ結果になることを乱数のflag・dataで確かめる
+	uint32_t random = 88172645;
+	enum{ POINT_MAX = 300, };
+	uint8_t flags[POINT_MAX];
+	uint8_t data[POINT_MAX * 4];
+	int32_t xs[POINT_MAX];
+	int32_t ys[POINT_MAX];
+	int32_t scalarXs[POINT_MAX];
+	int32_t scalarYs[POINT_MAX];
+	size_t mismatchNum = 0;
+	size_t successNum = 0;
+	for(int iter = 0; iter < 3000; iter++){
+		const size_t pointNum = glyfDecoderTest_random(&random) % POINT_MAX;
+		// 偏ったflag(全てshort等)も混ぜる
+		const uint8_t mask = (0 == iter % 4)? 0x12 : 0xFF;
+		for(size_t i = 0; i < pointNum; i++){
+			flags[i] = (uint8_t)glyfDecoderTest_random(&random) & mask;
+		}
+		for(size_t i = 0; i < sizeof(data); i++){
+			data[i] = (uint8_t)glyfDecoderTest_random(&random);
+		}
+		// 大抵は足りる長さ、時々は途中で切れる長さ
+		const size_t size = (0 == iter % 3)? glyfDecoderTest_random(&random) % (pointNum * 4 + 1) : sizeof(data);
+		size_t used = 0;
+		size_t scalarUsed = 0;
+		const bool isOk = GlyfDecoder_coordinates(data, size, flags, pointNum, xs, ys, &used);
+		const bool isScalarOk = GlyfDecoder_coordinatesScalar(data, size, flags, pointNum, scalarXs, scalarYs, &scalarUsed);
+		if(isOk != isScalarOk){
+			mismatchNum++;
+			continue;
+		}
+		if(! isOk){
+			continue;
+		}
+		successNum++;
+		if(used != scalarUsed
+				|| (0 < pointNum && (0 != memcmp(xs, scalarXs, sizeof(int32_t) * pointNum)
+				|| 0 != memcmp(ys, scalarYs, sizeof(int32_t) * pointNum)))){
+			mismatchNum++;
+		}
+	}
+	EXPECT_EQ_UINT(0, mismatchNum);
+	EXPECT_TRUE(2000 < successNum);
+
+	DEBUG_LOG("out");
+}
+
+void fontChecksum_test()
+{
+	DEBUG_LOG("in");
+
+	// big endianのuint32の合計(途中から始まる範囲も桁を合わせる)
+	const uint8_t bytes[] = {0x00, 0x00, 0x00, 0x01, 0x80, 0x00, 0x00, 0x00, 0x12, 0x34, 0x56,};
+	EXPECT_EQ_UINT(0x92345601, FontChecksum_sum(bytes, sizeof(bytes), 0));
+	EXPECT_EQ_UINT(0x92345601, FontChecksum_sum(bytes, 3, 0) + FontChecksum_sum(&bytes[3], sizeof(bytes) - 3, 3));
+	EXPECT_EQ_UINT(0, FontChecksum_sum(bytes, 0, 0));
+
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "ChecksumTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	const DaisyffPoint points[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour contours[] = {{points, 4},};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contours, 1, 500, 0, NULL));
+	uint8_t *data = NULL;
+	size_t size = 0;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, &size));
+	DaisyffBuilder_free(builder);
+
+	// 生成したフォントは全て一致する
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	FontChecksumReport report;
+	FontChecksum_verify(&parser, 0, &report);
+	EXPECT_EQ_UINT(parser.offsetTable.numTables, report.tableNum);
+	EXPECT_EQ_UINT(0, report.mismatchNum);
+	EXPECT_TRUE(report.isHeadFound);
+	EXPECT_EQ_UINT(report.storedAdjustment, report.actualAdjustment);
+	EXPECT_TRUE(FontChecksumReport_isOk(&report));
+	FontChecksumReport_free(&report);
+	const uint32_t glyfOffset = FontParser_queryTag(&parser, "glyf")->offset;
+	FontParser_free(&parser);
+
+	// 壊れたTableとadjustmentを見つける
+	// 大きなファイル(並列に計算する)の後ろの0はchecksumを変えない
+	const size_t largeSize = FontChecksum_PARALLEL_MIN_SIZE + (FontChecksum_CHUNK_SIZE / 2) + 3;
+	uint8_t *large = (uint8_t *)ffmalloc(largeSize);
+	memcpy(large, data, size);
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, large, largeSize));
+	FontChecksum_verify(&parser, 4, &report);
+	EXPECT_TRUE(FontChecksumReport_isOk(&report));
+	FontChecksumReport_free(&report);
+	large[glyfOffset + 1] ^= 0x10;
+	large[largeSize - 1] = 1;
+	FontChecksum_verify(&parser, 4, &report);
+	EXPECT_EQ_UINT(1, report.mismatchNum);
+	for(size_t i = 0; i < report.tableNum; i++){
+		const bool isGlyf = (0x676C7966 == report.tables[i].tag);
+		EXPECT_TRUE(isGlyf == (report.tables[i].stored != report.tables[i].actual));
+	}
+	EXPECT_TRUE(report.storedAdjustment != report.actualAdjustment);
+	EXPECT_TRUE(! FontChecksumReport_isOk(&report));
+	FontChecksumReport_free(&report);
+	FontParser_free(&parser);
+
+	free(large);
+	free(data);
+
+	DEBUG_LOG("out");
+}
+
+//! @brief 'A', 2文字目(codepoint)の2 glyphを持つフォントを作る
+uint8_t *fontDiffTest_font(const DaisyffContour *contourA, uint32_t codepoint, const DaisyffContour *contour, size_t *size)
+{
+	const DaisyffNames names = {
+		.copyright	= "(c)Copyright",
+		.familyName	= "DiffTest",
+		.macStyle	= DaisyffMacStyle_Regular,
+		.versionString	= "Version 1.0",
+		.vendorName	= "vendor",
+		.designerName	= "designer",
+		.vendorUrl	= "https://example.com/",
+		.designerUrl	= "https://example.com/",
+	};
+	const DaisyffMetrics metrics = {
+		.xMin = 0, .yMin = 0, .xMax = 400, .yMax = 400,
+		.ascender = 800, .descender = 200, .lineGap = 0, .lowestRecPPEM = 8,
+	};
+	DaisyffBuilder *builder = DaisyffBuilder_new();
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setNames(builder, &names));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_setMetrics(builder, &metrics));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, 'A', contourA, 1, 500, 0, NULL));
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_addGlyph(builder, codepoint, contour, 1, 500, 0, NULL));
+	uint8_t *data = NULL;
+	EXPECT_EQ_INT(DaisyffError_None, DaisyffBuilder_finallyToMemory(builder, &data, size));
+	DaisyffBuilder_free(builder);
+	return data;
+}
+
+void fontDiff_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffPoint square[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffPoint moved[] = {{0, 0}, {0, 400}, {380, 410}, {400, 0},};
+	const DaisyffPoint triangle[] = {{0, 0}, {200, 400}, {400, 0},};
+	const DaisyffContour squareContour = {square, 4};
+	const DaisyffContour movedContour = {moved, 4};
+	const DaisyffContour triangleContour = {triangle, 3};
+	size_t sizeA;
+	size_t sizeB;
+	uint8_t *dataA = fontDiffTest_font(&squareContour, 'B', &squareContour, &sizeA);
+	// 'A'の1点を動かし、'B'を'C'(三角形)に置き換える
+	uint8_t *dataB = fontDiffTest_font(&movedContour, 'C', &triangleContour, &sizeB);
+
+	FontParser parserA;
+	FontParser parserB;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parserA, dataA, sizeA));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parserB, dataB, sizeB));
+
+	// 同じフォントは全てのTableを読み飛ばす
+	FontDiff diff = {0};
+	FontDiff_compare(&diff, &parserA, &parserA);
+	EXPECT_TRUE(FontDiff_isSame(&diff));
+	EXPECT_EQ_UINT(parserA.offsetTable.numTables, diff.tableSameNum);
+
+	diff = (FontDiff){0};
+	FontDiff_compare(&diff, &parserA, &parserB);
+	EXPECT_TRUE(! FontDiff_isSame(&diff));
+	EXPECT_EQ_UINT(0, diff.tableAddedNum);
+	EXPECT_EQ_UINT(0, diff.tableRemovedNum);
+	EXPECT_EQ_UINT(2, diff.mappingNum);	// U+0042 削除, U+0043 追加
+	EXPECT_EQ_UINT(2, diff.glyphNum);	// 'A'の1点, 点数の変わったglyph
+	EXPECT_EQ_UINT(0, diff.fieldNum);
+	FILE *out = tmpfile();
+	EXPECT_TRUE(NULL != out);
+	diff = (FontDiff){.out = out};
+	FontDiff_compare(&diff, &parserA, &parserB);
+	char text[4096] = {0};
+	rewind(out);
+	EXPECT_TRUE(0 < fread(text, 1, sizeof(text) - 1, out));
+	fclose(out);
+	EXPECT_TRUE(NULL != strstr(text, "cmap U+0042: removed glyph 4\n"));
+	EXPECT_TRUE(NULL != strstr(text, "cmap U+0043: added glyph 4\n"));
+	EXPECT_TRUE(NULL != strstr(text, "glyph 3: moved 1 / 4 points\n"));
+	EXPECT_TRUE(NULL != strstr(text, "glyph 3 point 2: (400, 400) -> (380, 410) delta (-20, +10)\n"));
+	EXPECT_TRUE(NULL != strstr(text, "glyph 4: points 4 -> 3 contours 1 -> 1\n"));
+	FontParser_free(&parserB);
+
+	// checksumだけが違うTable, 'head'のcheckSumAdjustment(比べない)とunitsPerEm
+	const TableDirectory_Member *glyf = FontParser_queryTag(&parserA, "glyf");
+	const size_t glyfIndex = (size_t)(glyf - parserA.tableDirectory);
+	const uint32_t headOffset = FontParser_queryTag(&parserA, "head")->offset;
+	memcpy(dataB, dataA, sizeA);
+	dataB[12 + (16 * glyfIndex) + 4] ^= 0x01;	// TableDirectory checkSum
+	dataB[headOffset + FontChecksum_ADJUSTMENT_OFFSET] ^= 0x01;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parserB, dataB, sizeA));
+	diff = (FontDiff){0};
+	FontDiff_compare(&diff, &parserA, &parserB);
+	EXPECT_EQ_UINT(1, diff.tableChangedNum);
+	EXPECT_EQ_UINT(parserA.offsetTable.numTables - 1, diff.tableSameNum);
+	EXPECT_EQ_UINT(0, diff.glyphNum);
+	EXPECT_EQ_UINT(0, diff.fieldNum);
+	FontParser_free(&parserB);
+	dataB[headOffset + 19] ^= 0x01;	// unitsPerEm
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parserB, dataB, sizeA));
+	diff = (FontDiff){0};
+	FontDiff_compare(&diff, &parserA, &parserB);
+	EXPECT_EQ_UINT(2, diff.tableChangedNum);
+	EXPECT_EQ_UINT(1, diff.fieldNum);
+	FontParser_free(&parserB);
+
+	FontParser_free(&parserA);
+	free(dataA);
+	free(dataB);
+
+	DEBUG_LOG("out");
+}
+
+//! @brief FFByteArray_append()は0byteを追加できないので飛ばす
+void fontWoffTest_append(FFByteArray *array, const uint8_t *data, size_t size)
+{
+	if(0 < size){
+		FFByteArray_append(array, data, size);
+	}
+}
+
+void fontWoffTest_base128(FFByteArray *array, uint32_t value)
+{
+	uint8_t bytes[5];
+	size_t size = 0;
+	do{
+		bytes[4 - size] = (uint8_t)((value & 0x7F) | ((0 == size)? 0x00 : 0x80));
+		value >>= 7;
+		size++;
+	}while(0 != value);
+	fontWoffTest_append(array, &bytes[5 - size], size);
+}
+
+//! @brief sfntをWOFFにする(Tableはzlibで圧縮し、小さくならなければそのまま)
+FFByteArray fontWoffTest_woff(const uint8_t *sfnt, size_t size)
+{
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, sfnt, size));
+	const size_t numTables = parser.offsetTable.numTables;
+	FFByteArray woff = {0};
+	FFByteArray data = {0};
+	size_t offset = FontWoff_HEADER_SIZE + (20 * numTables);
+	for(size_t i = 0; i < numTables; i++){
+		const TableDirectory_Member *member = &parser.tableDirectory[i];
+		uLongf compLength = compressBound(member->length);
+		uint8_t *compressed = (uint8_t *)ffmalloc(compLength);
+		EXPECT_EQ_INT(Z_OK, compress(compressed, &compLength, &sfnt[member->offset], member->length));
+		const bool isStored = (member->length <= compLength);
+		if(isStored){
+			compLength = member->length;
+			memcpy(compressed, &sfnt[member->offset], compLength);
+		}
+		fontWoffTest_append(&data, compressed, compLength);
+		free(compressed);
+		const uint8_t padding[3] = {0};
+		fontWoffTest_append(&data, padding, FontWoff_pad4_inline_(compLength) - compLength);
+		const uint32_t entry[] = {member->tag, (uint32_t)(offset + data.length - FontWoff_pad4_inline_(compLength)),
+			(uint32_t)compLength, member->length, member->checkSum};
+		for(size_t e = 0; e < 5; e++){
+			testBytes_appendU32(&woff, entry[e]);
+		}
+	}
+	FFByteArray header = {0};
+	testBytes_appendU32(&header, 0x774F4646);
+	testBytes_appendU32(&header, parser.offsetTable.sfntVersion);
+	testBytes_appendU32(&header, (uint32_t)(FontWoff_HEADER_SIZE + woff.length + data.length));
+	testBytes_appendU16(&header, (uint16_t)numTables);
+	testBytes_appendU16(&header, 0);
+	testBytes_appendU32(&header, (uint32_t)size);
+	const uint8_t zeros[FontWoff_HEADER_SIZE] = {0};
+	fontWoffTest_append(&header, zeros, FontWoff_HEADER_SIZE - header.length);
+	fontWoffTest_append(&header, woff.data, woff.length);
+	fontWoffTest_append(&header, data.data, data.length);
+	FFByteArray_free(&woff);
+	FFByteArray_free(&data);
+	FontParser_free(&parser);
+	return header;
+}
+
+//! @brief simple glyphだけのsfntをWOFF2にする('glyf', 'loca', 'hmtx'は変換する。座標は全て4byteの形式)
+FFByteArray fontWoffTest_woff2(const uint8_t *sfnt, size_t size)
+{
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, sfnt, size));
+	HeadTable head;
+	MaxpTable_Version05 maxp;
+	FontSpan glyfTable;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_head(&parser, &head));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_maxp(&parser, &maxp));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "glyf", &glyfTable));
+	const size_t numGlyphs = maxp.numGlyphs;
+
+	// 変換した'glyf'の各stream(bboxは偶数のglyphだけ明示し、奇数は点から求めさせる)
+	FFByteArray streams[7] = {{0}};
+	enum{ NCONTOUR, NPOINTS, FLAG, GLYPH, COMPOSITE, BBOX, INSTRUCTION, };
+	const size_t bitmapSize = ((numGlyphs + 31) >> 5) << 2;
+	uint8_t *bboxBitmap = (uint8_t *)ffmalloc(bitmapSize);
+	FFByteArray bboxes = {0};
+	int16_t *xMins = (int16_t *)ffmalloc(sizeof(int16_t) * numGlyphs);
+	FontParseGlyph glyph = {0};
+	for(size_t glyphId = 0; glyphId < numGlyphs; glyphId++){
+		uint32_t offset;
+		uint32_t nextOffset;
+		EXPECT_EQ_INT(FontParseError_None, FontParser_locaEntry(&parser, head.indexToLocFormat, numGlyphs, glyphId, &offset, &nextOffset));
+		EXPECT_EQ_INT(FontParseError_None, FontParser_glyph(glyfTable, offset, nextOffset, &glyph));
+		testBytes_appendU16(&streams[NCONTOUR], (uint16_t)glyph.header.numberOfContours);
+		xMins[glyphId] = glyph.header.xMin;
+		if(0 == glyph.header.numberOfContours){
+			continue;
+		}
+		for(size_t c = 0; c < (size_t)glyph.header.numberOfContours; c++){
+			const size_t pointNum = glyph.endPtsOfContours[c] + 1 - ((0 == c)? 0 : glyph.endPtsOfContours[c - 1] + 1);
+			EXPECT_TRUE(pointNum < 253);
+			const uint8_t byte = (uint8_t)pointNum;
+			fontWoffTest_append(&streams[NPOINTS], &byte, 1);
+		}
+		for(size_t i = 0; i < glyph.pointNum; i++){
+			const int dx = glyph.points[i].rel.x;
+			const int dy = glyph.points[i].rel.y;
+			const uint8_t flag = (uint8_t)(((0 != (glyph.points[i].flag & 0x01))? 0x00 : 0x80)
+					| 124 | ((0 <= dx)? 1 : 0) | ((0 <= dy)? 2 : 0));
+			fontWoffTest_append(&streams[FLAG], &flag, 1);
+			testBytes_appendU16(&streams[GLYPH], (uint16_t)abs(dx));
+			testBytes_appendU16(&streams[GLYPH], (uint16_t)abs(dy));
+		}
+		EXPECT_TRUE(glyph.instructions.size < 253);
+		const uint8_t instructionLength = (uint8_t)glyph.instructions.size;
+		fontWoffTest_append(&streams[GLYPH], &instructionLength, 1);
+		fontWoffTest_append(&streams[INSTRUCTION], glyph.instructions.data, glyph.instructions.size);
+		if(0 == (glyphId % 2)){
+			bboxBitmap[glyphId >> 3] |= (uint8_t)(0x80 >> (glyphId & 7));
+			const int16_t bbox[] = {glyph.header.xMin, glyph.header.yMin, glyph.header.xMax, glyph.header.yMax};
+			for(size_t b = 0; b < 4; b++){
+				testBytes_appendU16(&bboxes, (uint16_t)bbox[b]);
+			}
+		}
+	}
+	FontParseGlyph_free(&glyph);
+	fontWoffTest_append(&streams[BBOX], bboxBitmap, bitmapSize);
+	fontWoffTest_append(&streams[BBOX], bboxes.data, bboxes.length);
+	FFByteArray_free(&bboxes);
+	free(bboxBitmap);
+	FFByteArray glyf = {0};
+	testBytes_appendU16(&glyf, 0);
+	testBytes_appendU16(&glyf, 0);
+	testBytes_appendU16(&glyf, (uint16_t)numGlyphs);
+	testBytes_appendU16(&glyf, (uint16_t)head.indexToLocFormat);
+	for(size_t i = 0; i < 7; i++){
+		testBytes_appendU32(&glyf, (uint32_t)streams[i].length);
+	}
+	for(size_t i = 0; i < 7; i++){
+		fontWoffTest_append(&glyf, streams[i].data, streams[i].length);
+		FFByteArray_free(&streams[i]);
+	}
+
+	// 'hmtx': leftSideBearingが全てxMinと同じならどちらも省略する
+	FontSpan hhea;
+	FontSpan hmtxTable;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "hhea", &hhea));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "hmtx", &hmtxTable));
+	const size_t numberOfHMetrics = (hhea.data[34] << 8) | hhea.data[35];
+	FFByteArray hmtx = {0};
+	const uint8_t hmtxFlags = 0x03;
+	fontWoffTest_append(&hmtx, &hmtxFlags, 1);
+	for(size_t i = 0; i < numGlyphs; i++){
+		const size_t lsbOffset = (i < numberOfHMetrics)? ((4 * i) + 2) : ((4 * numberOfHMetrics) + (2 * (i - numberOfHMetrics)));
+		EXPECT_EQ_INT(xMins[i], (int16_t)((hmtxTable.data[lsbOffset] << 8) | hmtxTable.data[lsbOffset + 1]));
+		if(i < numberOfHMetrics){
+			fontWoffTest_append(&hmtx, &hmtxTable.data[4 * i], 2);
+		}
+	}
+	free(xMins);
+
+	// TableDirectoryとbrotliで圧縮した全Table
+	FFByteArray directory = {0};
+	FFByteArray stream = {0};
+	for(size_t i = 0; i < parser.offsetTable.numTables; i++){
+		const TableDirectory_Member *member = &parser.tableDirectory[i];
+		uint8_t tagIndex = 63;
+		for(uint8_t k = 0; k < 63; k++){
+			tagIndex = (member->tag == FontWoff2_knownTag_inline_(k))? k : tagIndex;
+		}
+		const bool isGlyfOrLoca = (FontWoffTag_GLYF == member->tag || FontWoffTag_LOCA == member->tag);
+		const uint8_t flags = (uint8_t)(tagIndex | ((FontWoffTag_HMTX == member->tag)? 0x40 : 0x00));
+		fontWoffTest_append(&directory, &flags, 1);
+		if(63 == tagIndex){
+			testBytes_appendU32(&directory, member->tag);
+		}
+		fontWoffTest_base128(&directory, member->length);
+		if(FontWoffTag_GLYF == member->tag){
+			fontWoffTest_base128(&directory, (uint32_t)glyf.length);
+			fontWoffTest_append(&stream, glyf.data, glyf.length);
+		}else if(FontWoffTag_LOCA == member->tag){
+			fontWoffTest_base128(&directory, 0);
+		}else if(FontWoffTag_HMTX == member->tag){
+			fontWoffTest_base128(&directory, (uint32_t)hmtx.length);
+			fontWoffTest_append(&stream, hmtx.data, hmtx.length);
+		}else{
+			EXPECT_TRUE(! isGlyfOrLoca);
+			fontWoffTest_append(&stream, &sfnt[member->offset], member->length);
+		}
+	}
+	FFByteArray_free(&glyf);
+	FFByteArray_free(&hmtx);
+	size_t compressedSize = BrotliEncoderMaxCompressedSize(stream.length);
+	uint8_t *compressed = (uint8_t *)ffmalloc(compressedSize);
+	EXPECT_TRUE(BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_FONT,
+			stream.length, stream.data, &compressedSize, compressed));
+	FFByteArray_free(&stream);
+
+	FFByteArray woff2 = {0};
+	testBytes_appendU32(&woff2, 0x774F4632);
+	testBytes_appendU32(&woff2, parser.offsetTable.sfntVersion);
+	testBytes_appendU32(&woff2, (uint32_t)(FontWoff2_HEADER_SIZE + directory.length + compressedSize));
+	testBytes_appendU16(&woff2, parser.offsetTable.numTables);
+	testBytes_appendU16(&woff2, 0);
+	testBytes_appendU32(&woff2, (uint32_t)size);
+	testBytes_appendU32(&woff2, (uint32_t)compressedSize);
+	const uint8_t zeros[FontWoff2_HEADER_SIZE] = {0};
+	fontWoffTest_append(&woff2, zeros, FontWoff2_HEADER_SIZE - woff2.length);
+	fontWoffTest_append(&woff2, directory.data, directory.length);
+	fontWoffTest_append(&woff2, compressed, compressedSize);
+	FFByteArray_free(&directory);
+	free(compressed);
+	FontParser_free(&parser);
+	return woff2;
+}
+
+void fontWoff_test()
+{
+	DEBUG_LOG("in");
+
+	const DaisyffPoint square[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffPoint far[] = {{10, -300}, {0, 900}, {1200, 880}, {300, 0}, {20, 10},};
+	const DaisyffContour squareContour = {square, 4};
+	const DaisyffContour farContour = {far, 5};
+	size_t size;
+	uint8_t *sfnt = fontDiffTest_font(&squareContour, 'B', &farContour, &size);
+	EXPECT_EQ_INT(FontWoffFormat_NONE, FontWoff_format(sfnt, size));
+	uint8_t *decoded;
+	size_t decodedSize;
+	EXPECT_EQ_INT(FontParseError_Unsupported, FontWoff_decode(sfnt, size, 1, &decoded, &decodedSize));
+	FontParser original;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&original, sfnt, size));
+
+	// WOFF: Tableは元のまま(checksumも一致する)
+	FFByteArray woff = fontWoffTest_woff(sfnt, size);
+	EXPECT_EQ_INT(FontWoffFormat_WOFF, FontWoff_format(woff.data, woff.length));
+	for(size_t threadNum = 1; threadNum <= 4; threadNum += 3){
+		EXPECT_EQ_INT(FontParseError_None, FontWoff_decode(woff.data, woff.length, threadNum, &decoded, &decodedSize));
+		EXPECT_EQ_UINT(size, decodedSize);
+		FontParser parser;
+		EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, decoded, decodedSize));
+		FontDiff diff = {0};
+		FontDiff_compare(&diff, &original, &parser);
+		EXPECT_TRUE(FontDiff_isSame(&diff));
+		FontChecksumReport report;
+		FontChecksum_verify(&parser, 1, &report);
+		EXPECT_TRUE(FontChecksumReport_isOk(&report));
+		FontChecksumReport_free(&report);
+		FontParser_free(&parser);
+		free(decoded);
+	}
+	// 途中で切れたWOFF, 壊れた圧縮データ
+	EXPECT_EQ_INT(FontParseError_OutOfRange, FontWoff_decode(woff.data, woff.length - 1, 1, &decoded, &decodedSize));
+	woff.data[woff.length - 8] ^= 0xFF;
+	EXPECT_TRUE(FontParseError_None != FontWoff_decode(woff.data, woff.length, 1, &decoded, &decodedSize));
+	FFByteArray_free(&woff);
+
+	// WOFF2: 変換した'glyf', 'loca', 'hmtx'を組み立て直す
+	FFByteArray woff2 = fontWoffTest_woff2(sfnt, size);
+	EXPECT_EQ_INT(FontWoffFormat_WOFF2, FontWoff_format(woff2.data, woff2.length));
+	EXPECT_EQ_INT(FontParseError_None, FontWoff_decode(woff2.data, woff2.length, 1, &decoded, &decodedSize));
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, decoded, decodedSize));
+	FILE *out = tmpfile();
+	EXPECT_TRUE(NULL != out);
+	FontDiff diff = {.out = out};
+	FontDiff_compare(&diff, &original, &parser);
+	char text[4096] = {0};
+	rewind(out);
+	EXPECT_TRUE(fread(text, 1, sizeof(text) - 1, out) < sizeof(text) - 1);
+	fclose(out);
+	EXPECT_EQ_UINT(0, diff.tableAddedNum + diff.tableRemovedNum);
+	EXPECT_EQ_UINT(0, diff.fieldNum);
+	EXPECT_EQ_UINT(0, diff.mappingNum);
+	EXPECT_TRUE(NULL == strstr(text, "points"));	// 全glyphの輪郭が元と同じ
+	FontSpan hmtxA;
+	FontSpan hmtxB;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&original, "hmtx", &hmtxA));
+	EXPECT_EQ_INT(FontParseError_None, FontParser_table(&parser, "hmtx", &hmtxB));
+	EXPECT_EQ_UINT(hmtxA.size, hmtxB.size);
+	EXPECT_TRUE(0 == memcmp(hmtxA.data, hmtxB.data, hmtxA.size));
+	FontChecksumReport report;
+	FontChecksum_verify(&parser, 1, &report);
+	EXPECT_TRUE(FontChecksumReport_isOk(&report));
+	FontChecksumReport_free(&report);
+	FontParser_free(&parser);
+	free(decoded);
+	// フォントコレクションは未対応
+	woff2.data[4] = 't'; woff2.data[5] = 't'; woff2.data[6] = 'c'; woff2.data[7] = 'f';
+	EXPECT_EQ_INT(FontParseError_Unsupported, FontWoff_decode(woff2.data, woff2.length, 1, &decoded, &decodedSize));
+	FFByteArray_free(&woff2);
+
+	FontParser_free(&original);
+	free(sfnt);
+
+	DEBUG_LOG("out");
+}
+
+void fontSizeReport_test()
+{
+	DEBUG_LOG("in");
+
+	// 全てlongで書いた3点: x 0, +100, +300 / y 0, 0, -5 (paddingの3byteを含む)
+	const uint8_t simple[] = {
+		0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x90, 0x00, 0x00,	// header
+		0x00, 0x02,							// endPtsOfContours
+		0x00, 0x00,							// instructionLength
+		0x01, 0x01, 0x01,						// flags
+		0x00, 0x00, 0x00, 0x64, 0x01, 0x2C,				// x
+		0x00, 0x00, 0x00, 0x00, 0xFF, 0xFB,				// y
+		0x00, 0x00, 0x00,
+	};
+	FontSizeReport report = {0};
+	FontSizeGlyph glyph;
+	EXPECT_TRUE(FontSizeReport_glyph(&report, 0, (FontSpan){simple, sizeof(simple)}, &glyph));
+	EXPECT_EQ_UINT(32, glyph.bytes);
+	EXPECT_EQ_UINT(2, glyph.endPtsBytes);
+	EXPECT_EQ_UINT(2, glyph.instructionBytes);
+	EXPECT_EQ_UINT(3, glyph.flagBytes);
+	EXPECT_EQ_UINT(6, glyph.xBytes);
+	EXPECT_EQ_UINT(6, glyph.yBytes);
+	EXPECT_EQ_UINT(3, glyph.paddingBytes);
+	EXPECT_EQ_UINT(3, glyph.pointNum);
+	EXPECT_EQ_UINT(3, report.coords[0].counts[FontSizeCoord_LONG]);
+	EXPECT_EQ_UINT(1, report.coords[0].longFitsShortNum);
+	EXPECT_EQ_UINT(1, report.coords[0].zeroNotSameNum);
+	EXPECT_EQ_UINT(1, report.coords[1].longFitsShortNum);
+	EXPECT_EQ_UINT(2, report.coords[1].zeroNotSameNum);
+	// flag: 同じ3つはREPEATで2byte / 座標: same, short, long, short の4byte・flagは3種類で3byte
+	EXPECT_EQ_INT(1, (int)report.savingFlagRepeat);
+	EXPECT_EQ_INT((2 + 12) - (3 + 4), (int)report.savingShortVector);
+
+	// REPEATで書いたflagはそのまま
+	uint8_t repeated[sizeof(simple) - 1];
+	memcpy(repeated, simple, 14);
+	repeated[14] = 0x09;
+	repeated[15] = 0x02;
+	memcpy(&repeated[16], &simple[17], sizeof(simple) - 17);
+	EXPECT_TRUE(FontSizeReport_glyph(&report, 1, (FontSpan){repeated, sizeof(repeated)}, &glyph));
+	EXPECT_EQ_UINT(2, glyph.flagBytes);
+	EXPECT_EQ_UINT(2, report.flagRepeatedNum);
+	EXPECT_EQ_UINT(1, report.flagRunNum);
+	EXPECT_EQ_INT(1, (int)report.savingFlagRepeat);
+
+	// composite glyph(部品1つ, byteの引数), 途中で切れたglyph, 空glyph
+	const uint8_t composite[] = {
+		0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x01, 0x90, 0x01, 0x90,
+		0x00, 0x02, 0x00, 0x01, 0x0A, 0x0B,
+	};
+	EXPECT_TRUE(FontSizeReport_glyph(&report, 2, (FontSpan){composite, sizeof(composite)}, &glyph));
+	EXPECT_EQ_UINT(6, glyph.componentBytes);
+	EXPECT_EQ_UINT(0, glyph.paddingBytes);
+	EXPECT_TRUE(! FontSizeReport_glyph(&report, 3, (FontSpan){simple, 20}, &glyph));
+	EXPECT_TRUE(FontSizeReport_glyph(&report, 4, (FontSpan){simple, 0}, &glyph));
+	EXPECT_EQ_UINT(5, report.glyphNum);
+	EXPECT_EQ_UINT(2, report.simpleNum);
+	EXPECT_EQ_UINT(1, report.compositeNum);
+	EXPECT_EQ_UINT(1, report.emptyNum);
+	EXPECT_EQ_UINT(1, report.errorNum);
+	EXPECT_EQ_UINT(6, report.glyf.pointNum);	// 途中で切れたglyphは数えない
+	FontSizeReport_free(&report);
+
+	// フォント全体
+	const DaisyffPoint square[] = {{0, 0}, {0, 400}, {400, 400}, {400, 0},};
+	const DaisyffContour squareContour = {square, 4};
+	size_t size;
+	uint8_t *data = fontDiffTest_font(&squareContour, 'B', &squareContour, &size);
+	FontParser parser;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_init(&parser, data, size));
+	MaxpTable_Version05 maxp;
+	EXPECT_EQ_INT(FontParseError_None, FontParser_maxp(&parser, &maxp));
+	FILE *out = tmpfile();
+	EXPECT_TRUE(NULL != out);
+	report = (FontSizeReport){.out = out, .glyphFirst = 3, .glyphLast = 3};
+	FontSizeReport_analyze(&report, &parser);
+	char text[4096] = {0};
+	rewind(out);
+	EXPECT_TRUE(0 < fread(text, 1, sizeof(text) - 1, out));
+	fclose(out);
+	EXPECT_EQ_UINT(size, report.fileSize);
+	EXPECT_EQ_UINT(maxp.numGlyphs, report.glyphNum);
+	EXPECT_EQ_UINT(0, report.errorNum);
+	EXPECT_TRUE(report.directoryBytes + report.tableBytes <= size);
+	EXPECT_TRUE(0 <= report.savingCmapRange && 0 <= report.savingHmtxTrailing);
+	EXPECT_EQ_INT((int)FontSizeReport_saving(&report),
+			(int)(report.savingFlagRepeat + report.savingShortVector + report.savingCmapRange + report.savingHmtxTrailing));
+	EXPECT_TRUE(NULL != strstr(text, "\nglyph 3: bytes "));
+	EXPECT_TRUE(NULL == strstr(text, "\nglyph 2: "));
+	EXPECT_TRUE(NULL != strstr(text, "\ntable 'glyf': "));
+	EXPECT_TRUE(NULL != strstr(text, "\nsaving hmtx-trailing: "));
+	EXPECT_TRUE(NULL == report.flags);
+	FontParser_free(&parser);
+	free(data);
+
+	DEBUG_LOG("out");
+}
+
+#if FF_ALLOC_TRACE
+void allocTrace_task(void *context, size_t index, size_t workerIndex)
+{
+	void *p = ffmalloc(16 + index);
+	p = ffrealloc(p, 64 + index);
+	free(p);
+}
+
+void allocTrace_test()
+{
+	DEBUG_LOG("in");
+
+	FFAllocTrace *trace = &ffAllocTrace;
+	const size_t liveBytes = trace->liveBytes;
+	const size_t blockNum = trace->blockNum;
+	const size_t freeNum = trace->freeNum;
+
+	uint8_t *p = (uint8_t *)ffmalloc(100);
+	EXPECT_EQ_UINT(liveBytes + 100, trace->liveBytes);
+	EXPECT_EQ_UINT(blockNum + 1, trace->blockNum);
+	p = (uint8_t *)ffrealloc(p, 300);
+	EXPECT_EQ_UINT(liveBytes + 300, trace->liveBytes);
+	EXPECT_EQ_UINT(blockNum + 1, trace->blockNum);
+	EXPECT_TRUE(liveBytes + 300 <= trace->peakBytes);
+	free(p);
+	EXPECT_EQ_UINT(liveBytes, trace->liveBytes);
+	EXPECT_EQ_UINT(freeNum + 1, trace->freeNum);
+	// ffmalloc以外で確保した領域は記録に無い
+	void *raw = (malloc)(8);
+	free(raw);
+	EXPECT_EQ_UINT(freeNum + 1, trace->freeNum);
+
+	// hashの作り直しと、途中の要素を外した後の探索
+	enum{ BLOCK_NUM = 5000, };
+	void **blocks = (void **)ffmalloc(sizeof(void *) * BLOCK_NUM);
+	for(size_t i = 0; i < BLOCK_NUM; i++){
+		blocks[i] = ffmalloc(1 + (i % 7));
+	}
+	for(size_t i = 0; i < BLOCK_NUM; i++){
+		free(blocks[(i * 7919) % BLOCK_NUM]);
+	}
+	free(blocks);
+	EXPECT_EQ_UINT(liveBytes, trace->liveBytes);
+	EXPECT_EQ_UINT(blockNum, trace->blockNum);
+
+	// 複数threadからの確保・解放
+	WorkStealingPool_run(1000, 4, allocTrace_task, NULL);
+	EXPECT_EQ_UINT(liveBytes, trace->liveBytes);
+	EXPECT_EQ_UINT(blockNum, trace->blockNum);
+
+	// 呼び出し元毎の出力
+	FILE *out = tmpfile();
+	EXPECT_TRUE(NULL != out);
+	FFAllocTrace_report(out);
+	char text[256] = {0};
+	rewind(out);
+	EXPECT_TRUE(0 < fread(text, 1, sizeof(text) - 1, out));
+	fclose(out);
+	EXPECT_TRUE(0 == strncmp(text, "alloc-trace: allocs ", strlen("alloc-trace: allocs ")));
+
+	DEBUG_LOG("out");
+}
+#endif // #if FF_ALLOC_TRACE
+
 int main()
 {
 
@@ -232,6 +2967,32 @@ int main()
 	glyphOutline0_test();
 	glyphDescriptionBufEmpty_test();
 	glyphDescriptionBufNotdefNoCompression_test();
+	endianArray_test();
+	utf8ToUtf16BE_test();
+	nameTableStringPool_test();
+	daisyffBuilder_test();
+	gposKerning_test();
+	variableFont_test();
+	daisyffBuilderNoMemory_test();
+	glyphRaster_test();
+	fontFile_test();
+	glyphSdf_test();
+	glyphSdfAtlas_test();
+	textMeasure_test();
+	fontParser_test();
+	cmapPageTable_test();
+	workStealingPool_test();
+	fontValidator_test();
+	jsonWriter_test();
+	compositeGlyph_test();
+	glyfDecoder_test();
+	fontChecksum_test();
+	fontDiff_test();
+	fontWoff_test();
+	fontSizeReport_test();
+#if FF_ALLOC_TRACE
+	allocTrace_test();
+#endif
 
 	fprintf(stdout, "success.\n");
 
@@ -7,8 +7,225 @@ set -o pipefail
 
 trap 'echo "$0(${LINENO}) ${BASH_COMMAND}"' ERR
 
-# -t(table)
+# daisyff --trace
+TRACE_FILE=$(mktemp)
+./daisyff.exe DaisyMini --trace "${TRACE_FILE}" > /dev/null
+grep -q '"traceEvents"' "${TRACE_FILE}"
+grep -q '"name":"glyf","cat":"appendTable","ph":"E"' "${TRACE_FILE}"
+rm -f "${TRACE_FILE}"
+
+# daisyff --serve (stdin)
+SERVE_DIR=$(mktemp -d)
+cat > "${SERVE_DIR}/glyphs.txt" << EOF
+U+0041 500 50 50,100 250,600 450,100 250,180
+U+3042 1000 0 0,0 0,800 800,800 800,0 / 100,100 700,100 700,700 100,700
+U+0056 500 50 50,600 250,100 450,600
+KERN U+0041 U+0056 -80
+KERN U+0056 U+0041 -80
+EOF
+RESPONSE=$(printf 'name=Serve1 output=%s/s1.otf\nname=Serve2 output=%s/s2.otf glyphs=%s/glyphs.txt\nname=Serve3 glyphs=%s/none.txt\nstats\n' \
+	"${SERVE_DIR}" "${SERVE_DIR}" "${SERVE_DIR}" "${SERVE_DIR}" \
+	| ./daisyff.exe --serve --workers 2 --queue 1 2> /dev/null)
+[ 2 -eq "$(echo "${RESPONSE}" | grep -c '^ok id=')" ]
+echo "${RESPONSE}" | grep -q '^ok id=[0-9]* output=.*/s2.otf bytes=[0-9]* glyphs=6 queue_us=.* kern_pairs=2 gpos_bytes=[0-9]* gpos_naive_bytes='
+echo "${RESPONSE}" | grep -q '^error id=3 '
+echo "${RESPONSE}" | grep -q '^stats jobs='
+./daisydump.exe "${SERVE_DIR}/s2.otf" --strict > /dev/null 2>&1
+rm -rf "${SERVE_DIR}"
+
+# daisyff --serve variable font
+VAR_DIR=$(mktemp -d)
+cat > "${VAR_DIR}/glyphs.txt" << EOF
+AXIS wght 100 400 900 Weight
+AXISMAP wght 700 650
+INSTANCE Bold wght=700
+U+0041 500 50 50,100 250,600 450,100 250,180
+MASTER U+0041 wght=900 560 40,100 280,600 520,100 280,180
+MASTER U+0041 wght=700 540 45,100 265,600 485,100 265,180
+EOF
+RESPONSE=$(printf 'name=Var1 output=%s/v1.otf glyphs=%s/glyphs.txt\nname=Var2 glyphs=%s/glyphs.txt output=%s/v2.otf\n' \
+	"${VAR_DIR}" "${VAR_DIR}" "${VAR_DIR}" "${VAR_DIR}" \
+	| ./daisyff.exe --serve --workers 1 2> /dev/null)
+echo "${RESPONSE}" | grep -q '^ok id=1 .* gvar_tuples=2 gvar_bytes=[0-9]* gvar_unpacked_bytes='
+./daisydump.exe "${VAR_DIR}/v1.otf" --strict 2> /dev/null | grep "Axis  0. 'wght' min   100.000 default   400.000 max   900.000" > /dev/null
+echo "MASTER U+0041 wght=800 560 40,100 280,600 520,100" >> "${VAR_DIR}/glyphs.txt"
+printf 'name=Var3 glyphs=%s/glyphs.txt output=%s/v3.otf\n' "${VAR_DIR}" "${VAR_DIR}" \
+	| ./daisyff.exe --serve --workers 1 2> /dev/null | grep -q '^error id=1 .*incompatible master'
+rm -rf "${VAR_DIR}"
+
+# mmapできない入力(pipe)は読み切って同じ結果になる
+diff <(./daisydump.exe DaisyMini.otf 2> /dev/null | grep -v '^Dumping File:') \
+	<(cat DaisyMini.otf | ./daisydump.exe /dev/stdin 2> /dev/null | grep -v '^Dumping File:') > /dev/null
+# 途中で切れたファイルは範囲外として終了する
+TRUNC_FILE=$(mktemp)
+head -c 1000 DaisyMini.otf > "${TRUNC_FILE}"
+set +e
+./daisydump.exe "${TRUNC_FILE}" > /dev/null 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+rm -f "${TRUNC_FILE}"
+
+# -t(table), --glyphs
 ./daisydump.exe DaisyMini.otf -t cmap > /dev/null
+TABLE_OUT=$(./daisydump.exe DaisyMini.otf -t head,loca 2> /dev/null)
+echo "${TABLE_OUT}" | grep "^'head' Table" > /dev/null
+echo "${TABLE_OUT}" | grep "^'loca' Table" > /dev/null
+[ 0 -eq "$(echo "${TABLE_OUT}" | grep -c "^'maxp' Table\|^'cmap' Table\|^'glyf' Table")" ]
+TABLE_OUT=$(./daisydump.exe DaisyMini.otf -t glyf --glyphs 2-3 2> /dev/null)
+[ "Glyph      2.,Glyph      3." = "$(echo "${TABLE_OUT}" | grep '^Glyph ' | paste -sd,)" ]
+[ 0 -eq "$(echo "${TABLE_OUT}" | grep -c "^'head' Table\|^'loca' Table")" ]
+[ 1 -eq "$(./daisydump.exe DaisyMini.otf --json -t glyf --glyphs 3 | grep -c '^{"type":"glyph",')" ]
+set +e
+./daisydump.exe DaisyMini.otf -t name > /dev/null 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+set +e
+./daisydump.exe DaisyMini.otf --glyphs 3-1 > /dev/null 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+
+# --json(NDJSON)
+JSON_FILE=$(mktemp)
+./daisydump.exe DaisyMini.otf --json > "${JSON_FILE}"
+[ 9 -eq "$(grep -c '^{"type":"table","tag":"[^"]*","checkSum":[0-9]*,"checkSumActual":[0-9]*,"isCheckSumOk":true,"offset":[0-9]*,"length":[0-9]*}$' "${JSON_FILE}")" ]
+grep -q '^{"type":"checksum","ok":true,"mismatchTables":0,' "${JSON_FILE}"
+grep -q '^{"type":"head",.*"unitsPerEm":1024,' "${JSON_FILE}"
+grep -q '^{"type":"cmapSubtable","index":0,.*"format":4,"mappings":\[\[65,3\]\]}$' "${JSON_FILE}"
+grep -q '^{"type":"glyph","glyphId":3,.*"points":\[\[50,100,1\],\[250,600,1\],\[450,100,1\],\[250,180,1\]\]}$' "${JSON_FILE}"
+[ 4 -eq "$(grep -c '^{"type":"glyph",' "${JSON_FILE}")" ]
+head -c 1000 DaisyMini.otf > "${JSON_FILE}"
+set +e
+./daisydump.exe "${JSON_FILE}" --json > "${JSON_FILE}.out" 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+grep -q '^{"type":"error","table":"cmap","error":"out of range"}$' "${JSON_FILE}.out"
+rm -f "${JSON_FILE}" "${JSON_FILE}.out"
+
+# --render
+RENDER_FILE=$(mktemp)
+./daisydump.exe DaisyMini.otf --render 3 64 "${RENDER_FILE}" > /dev/null
+[ "P5" = "$(head -n 1 "${RENDER_FILE}")" ]
+set +e
+./daisydump.exe DaisyMini.otf --render 9999 64 "${RENDER_FILE}" > /dev/null 2>&1
+RET=$?
+set -e
+[ 0 -ne $RET ]
+rm -f "${RENDER_FILE}"
+
+# --sdf-atlas
+SDF_DIR=$(mktemp -d)
+./daisydump.exe DaisyMini.otf --sdf-atlas U+0020-U+007E,U+3042 32 4 "${SDF_DIR}/atlas" > /dev/null 2>&1
+[ "P5" = "$(head -n 1 "${SDF_DIR}/atlas.pgm")" ]
+grep -q '"codepoint":65,"glyphId":3,"advance":500' "${SDF_DIR}/atlas.json"
+set +e
+./daisydump.exe DaisyMini.otf --sdf-atlas U+0041-U+0020 32 4 "${SDF_DIR}/atlas" > /dev/null 2>&1
+RET=$?
+set -e
+[ 0 -ne $RET ]
+rm -rf "${SDF_DIR}"
+
+# --measure
+./daisydump.exe DaisyMini.otf --measure "AAB" | grep -q '^measure advance=1500 chars=3 unmapped=1 '
+
+# 昇順でないloca
+LOCA_FILE=$(mktemp)
+cp DaisyMini.otf "${LOCA_FILE}"
+LOCA_OFFSET=$(./daisydump.exe DaisyMini.otf -t loca 2> /dev/null | sed -n "s/^ *[0-9]*\. 'loca' - checksum = 0x[0-9a-f]*, offset = 0x[0-9a-f]*( *\([0-9]*\)).*/\1/p")
+printf '\xff\xff' | dd of="${LOCA_FILE}" bs=1 seek=$((LOCA_OFFSET + 2)) conv=notrunc 2> /dev/null
+./daisydump.exe "${LOCA_FILE}" -t loca,glyf 2>&1 | grep "'loca' Idx 2: offset 0x00000044 < previous 0x0001fffe" > /dev/null
+./daisydump.exe "${LOCA_FILE}" -t glyf 2>&1 | grep "'loca' glyph 1: 0x0001fffe - 0x00000044 is not ascending" > /dev/null
+LOCA_JSON=$(./daisydump.exe "${LOCA_FILE}" --json -t loca || true)
+echo "${LOCA_JSON}" | grep '"isAscending":false' > /dev/null
+set +e
+./daisydump.exe "${LOCA_FILE}" -t loca --strict > /dev/null 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+rm -f "${LOCA_FILE}"
+
+# checksum, --verify-only
+./daisydump.exe DaisyMini.otf --verify-only --threads 2 | grep '^verify: ok DaisyMini.otf$' > /dev/null
+./daisydump.exe DaisyMini.otf 2> /dev/null | grep "checkSumAdjustment: stored = 0x[0-9a-f]*, actual = 0x[0-9a-f]* ok" > /dev/null
+CORRUPT_FILE=$(mktemp)
+cp DaisyMini.otf "${CORRUPT_FILE}"
+printf '\x7f' | dd of="${CORRUPT_FILE}" bs=1 seek=1300 conv=notrunc 2> /dev/null
+set +e
+./daisydump.exe "${CORRUPT_FILE}" --verify-only > /dev/null 2>&1
+RET_VERIFY=$?
+./daisydump.exe "${CORRUPT_FILE}" --strict > /dev/null 2>&1
+RET_STRICT=$?
+set -e
+[ 1 -eq $RET_VERIFY ]
+[ 0 -ne $RET_STRICT ]
+./daisydump.exe "${CORRUPT_FILE}" 2>&1 | grep "checkSumAdjustment: stored 0x[0-9a-f]* actual" > /dev/null
+rm -f "${CORRUPT_FILE}"
+
+# --diff
+./daisydump.exe --diff DaisyMini.otf DaisyMini.otf | grep '^diff same tables same=[0-9]* changed=0 added=0 removed=0 ' > /dev/null
+DIFF_OUT=$(./daisydump.exe --diff DaisyMini.otf example/DaisyMiniFF_A.ttf || true)
+echo "${DIFF_OUT}" | grep "^table 'OS/2': added length 96$" > /dev/null
+echo "${DIFF_OUT}" | grep '^head.xMax: 450 -> 453$' > /dev/null
+echo "${DIFF_OUT}" | grep '^glyph 3 point 0: (50, 100) -> (59, 0) delta (+9, -100)$' > /dev/null
+echo "${DIFF_OUT}" | grep '^diff differ ' > /dev/null
+set +e
+./daisydump.exe --diff DaisyMini.otf example/DaisyMiniFF_A.ttf > /dev/null
+RET_DIFF=$?
+./daisydump.exe --diff DaisyMini.otf /nonexistent.otf > /dev/null 2>&1
+RET_OPEN=$?
+set -e
+[ 1 -eq $RET_DIFF ]
+[ 2 -eq $RET_OPEN ]
+
+# WOFF: 展開したsfntは元のフォントと同じ
+./daisydump.exe --diff example/DaisyMiniFF_A.ttf example/DaisyMiniFF_A.woff | grep '^diff same tables same=13 changed=0 ' > /dev/null
+./daisydump.exe example/DaisyMiniFF_A.woff --verify-only | grep '^verify: ok ' > /dev/null
+./daisydump.exe example/DaisyMiniFF_A.woff --threads 2 > /dev/null
+./daisydump.exe example/DaisyMiniFF_A.woff --measure "AAA" | grep -q '^measure advance=1497 chars=3 unmapped=0 '
+SDF_DIR=$(mktemp -d)
+./daisydump.exe example/DaisyMiniFF_A.woff --sdf-atlas U+0041 32 4 "${SDF_DIR}/atlas" > /dev/null 2>&1
+grep -q '"codepoint":65,"glyphId":3,"advance":499' "${SDF_DIR}/atlas.json"
+rm -rf "${SDF_DIR}"
+WOFF_FILE=$(mktemp)
+head -c 100 example/DaisyMiniFF_A.woff > "${WOFF_FILE}"
+set +e
+./daisydump.exe "${WOFF_FILE}" > /dev/null 2>&1
+RET_WOFF=$?
+set -e
+rm -f "${WOFF_FILE}"
+[ 1 -eq $RET_WOFF ]
+
+# --size-report
+SIZE_OUT=$(./daisydump.exe DaisyMini.otf --size-report)
+echo "${SIZE_OUT}" | grep "^table 'name': 592 bytes " > /dev/null
+echo "${SIZE_OUT}" | grep '^glyf: glyphs 4 simple 4 composite 0 empty 0 error 0 points 12$' > /dev/null
+echo "${SIZE_OUT}" | grep '^glyf x: same 0 short 0 long 12 bytes 24 long-fits-short 5 zero-not-same 3$' > /dev/null
+echo "${SIZE_OUT}" | grep '^saving short-vector: 13 bytes$' > /dev/null
+echo "${SIZE_OUT}" | grep '^size-report file 1372 bytes saving ' > /dev/null
+[ 1 -eq $(./daisydump.exe DaisyMini.otf --size-report --glyphs 3 | grep -c '^glyph ') ]
+
+# --batch
+BATCH_DIR=$(mktemp -d)
+mkdir "${BATCH_DIR}/sub"
+cp DaisyMini.otf "${BATCH_DIR}/"
+cp example/*.ttf example/DaisyMiniFF_A.woff "${BATCH_DIR}/sub/"
+head -c 1000 DaisyMini.otf > "${BATCH_DIR}/trunc.OTF"
+set +e
+./daisydump.exe --batch "${BATCH_DIR}" --threads 2 > "${BATCH_DIR}/out.txt" 2>&1
+RET=$?
+set -e
+[ 1 -eq $RET ]
+grep -q "^ok [0-9.]* ${BATCH_DIR}/DaisyMini.otf$" "${BATCH_DIR}/out.txt"
+grep -q "^fail [0-9.]* ${BATCH_DIR}/trunc.OTF errors=[0-9]*$" "${BATCH_DIR}/out.txt"
+grep -q "^	error: table 'glyf' out of file" "${BATCH_DIR}/out.txt"
+grep -q "^ok [0-9.]* ${BATCH_DIR}/sub/DaisyMiniFF_A.woff$" "${BATCH_DIR}/out.txt"
+grep -q '^batch fonts=5 ok=4 failed=1 ' "${BATCH_DIR}/out.txt"
+ls "${BATCH_DIR}"/sub/*.ttf DaisyMini.otf > "${BATCH_DIR}/list.txt"
+./daisydump.exe --batch "${BATCH_DIR}/list.txt" | grep '^batch fonts=3 ok=3 failed=0 ' > /dev/null
+rm -rf "${BATCH_DIR}"
 
 # --strict mode
 ./daisydump.exe "example/DaisyMiniFF_A.ttf" --strict > /dev/null